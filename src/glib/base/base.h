@@ -82,6 +82,7 @@
   #include <dirent.h>
   #include <unistd.h>
   #include <signal.h>
+  #include <pthread.h>
   #include <sys/poll.h>
   #include <sys/socket.h>
   #include <sys/stat.h>
@@ -221,7 +221,7 @@ void TBlobBs::AssertBlobState(const PFRnd& FBlobBs, const TBlobState& State){
   EAssert(TBlobState(FBlobBs->GetCh())==State);
 }
 
-void TBlobBs::AssertBfCsEqFlCs(const TCs& BfCs, const TCs& FCs){
+void TBlobBs::AssertBfCsEqFlCs(const TCs& BfCs, const TCs& FCs) const {
   if (BfCs!=FCs){
     printf("[%d:%d]\n", BfCs.Get(), FCs.Get());}
   //EAssert(BfCs==FCs);
@@ -239,11 +239,14 @@ TStr TGBlobBs::GetNrBlobBsFNm(const TStr& BlobBsFNm){
 TGBlobBs::TGBlobBs(
  const TStr& BlobBsFNm, const TFAccess& _Access, const int& _MxSegLen):
   TBlobBs(), FBlobBs(), Access(_Access), MxSegLen(_MxSegLen),
-  BlockLenV(), FFreeBlobPtV(TB4Def::B4Bits), FirstBlobPt(){
+  BlockLenV(), FFreeBlobPtV(TB4Def::B4Bits), FirstBlobPt(),
+  ShadowP(false), EndAddr(0){
   if (MxSegLen==-1){MxSegLen=MxBlobFLen;}
   TStr NrBlobBsFNm=GetNrBlobBsFNm(BlobBsFNm);
+  FreeFNm=NrBlobBsFNm+".Free";
   switch (Access){
     case faCreate:
+      TFile::Del(FreeFNm, false);
       FBlobBs=TFRnd::New(NrBlobBsFNm, faCreate, true); break;
     case faUpdate:
     case faRdOnly:
@@ -261,25 +264,61 @@ TGBlobBs::TGBlobBs(
     GenFFreeBlobPtV(BlockLenV, FFreeBlobPtV);
     PutFFreeBlobPtV(FBlobBs, FFreeBlobPtV);
   } else {
+    // checkpointed blob-bases keep free lists in the side-file and
+    // do not maintain header state
+    ShadowP=TFile::Exists(FreeFNm);
     FBlobBs->SetFPos(0);
     AssertVersionStr(FBlobBs);
     int FPos=FBlobBs->GetFPos();
-    if (Access!=faRestore){
+    if ((Access!=faRestore)&&(!ShadowP)){
       AssertBlobBsStateStr(FBlobBs, bbsClosed);}
     if (Access!=faRdOnly){
       FBlobBs->SetFPos(FPos);
       PutBlobBsStateStr(FBlobBs, bbsOpened);
     }
+    FBlobBs->SetFPos(FPos+GetStateStrLen()+1);
     MxSegLen=GetMxSegLen(FBlobBs);
     GetBlockLenV(FBlobBs, BlockLenV);
     GetFFreeBlobPtV(FBlobBs, FFreeBlobPtV);
   }
   FirstBlobPt=TBlobPt(FBlobBs->GetFPos());
+  if (ShadowP){LoadShadow();}
   FBlobBs->Flush();
 }
 
+void TGBlobBs::InitShadow(){
+  // collect free blobs from on-disk free lists
+  FreeAddrVV.Gen(FFreeBlobPtV.Len()); DelAddrVV.Gen(FFreeBlobPtV.Len());
+  for (int FFreeBlobPtN=0; FFreeBlobPtN<FFreeBlobPtV.Len(); FFreeBlobPtN++){
+    TBlobPt FreeBlobPt=FFreeBlobPtV[FFreeBlobPtN];
+    while (!FreeBlobPt.Empty()){
+      FreeAddrVV[FFreeBlobPtN].Add(FreeBlobPt.GetAddr());
+      FBlobBs->SetFPos(FreeBlobPt.GetAddr());
+      AssertBlobTag(FBlobBs, btBegin);
+      FBlobBs->GetInt();
+      AssertBlobState(FBlobBs, bsFree);
+      FreeBlobPt=TBlobPt::LoadAddr(FBlobBs);
+    }
+  }
+  EndAddr=uint(FBlobBs->GetFLen());
+  NewAddrSet.Clr();
+  ShadowP=true;
+}
+
+void TGBlobBs::LoadShadow(){
+  TFIn FIn(FreeFNm);
+  TUInt _EndAddr(FIn); EndAddr=_EndAddr;
+  FreeAddrVV.Load(FIn); DelAddrVV.Load(FIn);
+  // deletes pending at checkpoint are free after it
+  for (int FFreeBlobPtN=0; FFreeBlobPtN<DelAddrVV.Len(); FFreeBlobPtN++){
+    FreeAddrVV[FFreeBlobPtN].AddV(DelAddrVV[FFreeBlobPtN]);
+    DelAddrVV[FFreeBlobPtN].Clr();
+  }
+}
+
 TGBlobBs::~TGBlobBs(){
-  if (Access!=faRdOnly){
+  // copy-on-write state is persisted only by checkpoints
+  if ((Access!=faRdOnly)&&(!ShadowP)){
     FBlobBs->SetFPos(0);
     PutVersionStr(FBlobBs);
     PutBlobBsStateStr(FBlobBs, bbsClosed);
@@ -297,6 +336,32 @@ TBlobPt TGBlobBs::PutBlob(const PSIn& SIn){
   int MxBfL; int FFreeBlobPtN;
   GetAllocInfo(BfL, BlockLenV, MxBfL, FFreeBlobPtN);
   TBlobPt BlobPt; TCs Cs;
+  if (ShadowP){
+    TUIntV& FreeAddrV=FreeAddrVV[FFreeBlobPtN];
+    if (FreeAddrV.Empty()){
+      if (EndAddr>uint(MxSegLen)){return BlobPt;}
+      EAssert(EndAddr<=uint(MxBlobFLen));
+      BlobPt=TBlobPt(EndAddr);
+      FBlobBs->SetFPos(BlobPt.GetAddr());
+      PutBlobTag(FBlobBs, btBegin);
+      FBlobBs->PutInt(MxBfL);
+    } else {
+      BlobPt=TBlobPt(FreeAddrV.Last()); FreeAddrV.DelLast();
+      FBlobBs->SetFPos(BlobPt.GetAddr());
+      AssertBlobTag(FBlobBs, btBegin);
+      EAssert(FBlobBs->GetInt()==MxBfL);
+    }
+    PutBlobState(FBlobBs, bsActive);
+    FBlobBs->PutInt(BfL);
+    FBlobBs->PutSIn(SIn, Cs);
+    FBlobBs->PutCh(TCh::NullCh, MxBfL-BfL);
+    FBlobBs->PutCs(Cs);
+    PutBlobTag(FBlobBs, btEnd);
+    if (BlobPt.GetAddr()==EndAddr){EndAddr=uint(FBlobBs->GetFPos());}
+    NewAddrSet.AddKey(BlobPt.GetAddr());
+    FBlobBs->Flush();
+    return BlobPt;
+  }
   if (FFreeBlobPtV[FFreeBlobPtN].Empty()){
     int FLen=FBlobBs->GetFLen();
     if (FLen<=MxSegLen){
@@ -340,7 +405,8 @@ TBlobPt TGBlobBs::PutBlob(const TBlobPt& BlobPt, const PSIn& SIn){
   AssertBlobTag(FBlobBs, btBegin);
   int MxBfL=FBlobBs->GetInt();
   AssertBlobState(FBlobBs, bsActive);
-  if (BfL>MxBfL){
+  // checkpointed blobs are never overwritten
+  if ((BfL>MxBfL)||(ShadowP&&!NewAddrSet.IsKey(BlobPt.GetAddr()))){
     DelBlob(BlobPt);
     return PutBlob(SIn);
   } else {
@@ -369,6 +435,30 @@ PSIn TGBlobBs::GetBlob(const TBlobPt& BlobPt){
   return SIn;
 }
 
+PSIn TGBlobBs::GetBlobAt(const TBlobPt& BlobPt) const {
+  // header: begin-tag, reserved length, state, length
+  const int HdL=sizeof(uint)+sizeof(int)+sizeof(char)+sizeof(int);
+  char Hd[HdL]; const int Addr=int(BlobPt.GetAddr());
+  FBlobBs->GetBfAt(Addr, Hd, HdL);
+  uint BeginTag; memcpy(&BeginTag, Hd, sizeof(uint));
+  EAssert(BeginTag==GetBeginBlobTag());
+  int MxBfL; memcpy(&MxBfL, Hd+sizeof(uint), sizeof(int));
+  EAssert(TBlobState(Hd[sizeof(uint)+sizeof(int)])==bsActive);
+  int BfL; memcpy(&BfL, Hd+sizeof(uint)+sizeof(int)+sizeof(char), sizeof(int));
+  // data; the stream owns the buffer
+  char* Bf=new char[BfL]; PSIn SIn=PSIn(new TMIn(Bf, BfL, true));
+  FBlobBs->GetBfAt(Addr+HdL, Bf, BfL);
+  TCs BfCs=TCs::GetCsFromBf(Bf, BfL);
+  // tail after the reserved space: checksum, end-tag
+  char Tl[sizeof(int)+sizeof(uint)];
+  FBlobBs->GetBfAt(Addr+HdL+MxBfL, Tl, sizeof(Tl));
+  int CsVal; memcpy(&CsVal, Tl, sizeof(int)); TCs FCs(CsVal);
+  uint EndTag; memcpy(&EndTag, Tl+sizeof(int), sizeof(uint));
+  EAssert(EndTag==GetEndBlobTag());
+  AssertBfCsEqFlCs(BfCs, FCs);
+  return SIn;
+}
+
 void TGBlobBs::DelBlob(const TBlobPt& BlobPt){
   EAssert((Access==faCreate)||(Access==faUpdate)||(Access==faRestore));
   FBlobBs->SetFPos(BlobPt.GetAddr());
@@ -377,11 +467,24 @@ void TGBlobBs::DelBlob(const TBlobPt& BlobPt){
   int FPos=FBlobBs->GetFPos();
   AssertBlobState(FBlobBs, bsActive);
   /*int BfL=*/FBlobBs->GetInt();
-  FBlobBs->SetFPos(FPos);
-  PutBlobState(FBlobBs, bsFree);
   int _MxBfL; int FFreeBlobPtN;
   GetAllocInfo(MxBfL, BlockLenV, _MxBfL, FFreeBlobPtN);
   EAssert(MxBfL==_MxBfL);
+  if (ShadowP){
+    const uint BlobAddr=BlobPt.GetAddr();
+    if (NewAddrSet.IsKey(BlobAddr)){
+      NewAddrSet.DelKey(BlobAddr);
+      FBlobBs->SetFPos(FPos);
+      PutBlobState(FBlobBs, bsFree);
+      FreeAddrVV[FFreeBlobPtN].Add(BlobAddr);
+      FBlobBs->Flush();
+    } else {
+      DelAddrVV[FFreeBlobPtN].Add(BlobAddr);
+    }
+    return;
+  }
+  FBlobBs->SetFPos(FPos);
+  PutBlobState(FBlobBs, bsFree);
   FFreeBlobPtV[FFreeBlobPtN].SaveAddr(FBlobBs);
   FFreeBlobPtV[FFreeBlobPtN]=BlobPt;
   FBlobBs->PutCh(TCh::NullCh, MxBfL+sizeof(TCs));
@@ -396,7 +499,8 @@ TBlobPt TGBlobBs::FFirstBlobPt(){
 bool TGBlobBs::FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn){
   forever {
     uint TrvBlobAddr=TrvBlobPt.GetAddr();
-    if (TrvBlobAddr>=uint(FBlobBs->GetFLen())){
+    const uint FLen=ShadowP ? EndAddr : uint(FBlobBs->GetFLen());
+    if (TrvBlobAddr>=FLen){
       TrvBlobPt.Clr(); BlobPt.Clr(); BlobSIn=NULL;
       return false;
     } else {
@@ -426,6 +530,30 @@ bool TGBlobBs::FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn){
   }
 }
 
+void TGBlobBs::Checkpoint(TFCommit& Commit){
+  EAssert((Access==faCreate)||(Access==faUpdate)||(Access==faRestore));
+  if (!ShadowP){InitShadow();}
+  // blobs must be on disk before the checkpoint referencing them
+  FBlobBs->Sync();
+  TFOut FOut(Commit.AddFNm(FreeFNm));
+  TUInt(EndAddr).Save(FOut);
+  FreeAddrVV.Save(FOut); DelAddrVV.Save(FOut);
+}
+
+void TGBlobBs::OnCommit(){
+  if (!ShadowP){return;}
+  for (int FFreeBlobPtN=0; FFreeBlobPtN<DelAddrVV.Len(); FFreeBlobPtN++){
+    TUIntV& DelAddrV=DelAddrVV[FFreeBlobPtN];
+    for (int DelAddrN=0; DelAddrN<DelAddrV.Len(); DelAddrN++){
+      FBlobBs->SetFPos(DelAddrV[DelAddrN]+sizeof(uint)+sizeof(int));
+      PutBlobState(FBlobBs, bsFree);
+    }
+    FreeAddrVV[FFreeBlobPtN].AddV(DelAddrV); DelAddrV.Clr();
+  }
+  NewAddrSet.Clr();
+  FBlobBs->Flush();
+}
+
 bool TGBlobBs::Exists(const TStr& BlobBsFNm){
   TStr NrBlobBsFNm=GetNrBlobBsFNm(BlobBsFNm);
   return TFile::Exists(NrBlobBsFNm);
@@ -457,8 +585,8 @@ void TMBlobBs::LoadMain(int& Segs){
   Segs=Lx.GetVarInt("Segments");
 }
 
-void TMBlobBs::SaveMain() const {
-  PSOut SOut=TFOut::New(GetMainFNm(NrFPath, NrFMid));
+void TMBlobBs::SaveMain(const TStr& MainFNm) const {
+  PSOut SOut=TFOut::New(MainFNm);
   TOLx Lx(SOut, TFSet()|oloFrcEoln|oloSigNum|oloCsSens);
   Lx.PutVarStr("Version", GetVersionStr());
   Lx.PutVarInt("MxSegLen", MxSegLen);
@@ -468,7 +596,7 @@ void TMBlobBs::SaveMain() const {
 TMBlobBs::TMBlobBs(
  const TStr& BlobBsFNm, const TFAccess& _Access, const int& _MxSegLen):
   TBlobBs(), Access(_Access), MxSegLen(_MxSegLen),
-  NrFPath(), NrFMid(), SegV(), CurSegN(0){
+  NrFPath(), NrFMid(), SegV(), CurSegN(0), CheckpointP(false){
   if (MxSegLen==-1){MxSegLen=MxBlobFLen;}
   GetNrFPathFMid(BlobBsFNm, NrFPath, NrFMid);
   switch (Access){
@@ -477,7 +605,7 @@ TMBlobBs::TMBlobBs(
       TStr SegFNm=GetSegFNm(NrFPath, NrFMid, 0);
       PBlobBs Seg=TGBlobBs::New(SegFNm, faCreate, MxSegLen);
       SegV.Add(Seg);
-      SaveMain(); break;}
+      SaveMain(GetMainFNm(NrFPath, NrFMid)); break;}
     case faUpdate:
     case faRdOnly:{
       int Segs; LoadMain(Segs);
@@ -512,7 +640,7 @@ TMBlobBs::TMBlobBs(
         TStr SegFNm=GetSegFNm(NrFPath, NrFMid, 0);
         PBlobBs Seg=TGBlobBs::New(SegFNm, faCreate, MxSegLen);
         SegV.Add(Seg);
-        SaveMain();
+        SaveMain(GetMainFNm(NrFPath, NrFMid));
       }
       break;}
     default: Fail;
@@ -520,8 +648,8 @@ TMBlobBs::TMBlobBs(
 }
 
 TMBlobBs::~TMBlobBs(){
-  if (Access!=faRdOnly){
-    SaveMain();
+  if ((Access!=faRdOnly)&&(!CheckpointP)){
+    SaveMain(GetMainFNm(NrFPath, NrFMid));
   }
 }
 
@@ -562,6 +690,11 @@ PSIn TMBlobBs::GetBlob(const TBlobPt& BlobPt){
   return SegV[SegN]->GetBlob(BlobPt);
 }
 
+PSIn TMBlobBs::GetBlobAt(const TBlobPt& BlobPt) const {
+  int SegN=BlobPt.GetSeg();
+  return SegV[SegN]->GetBlobAt(BlobPt);
+}
+
 void TMBlobBs::DelBlob(const TBlobPt& BlobPt){
   int SegN=BlobPt.GetSeg();
   SegV[SegN]->DelBlob(BlobPt);
@@ -592,6 +725,19 @@ bool TMBlobBs::FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn){
   }
 }
 
+void TMBlobBs::Checkpoint(TFCommit& Commit){
+  EAssert((Access==faCreate)||(Access==faUpdate)||(Access==faRestore));
+  SaveMain(Commit.AddFNm(GetMainFNm(NrFPath, NrFMid)));
+  for (int SegN=0; SegN<SegV.Len(); SegN++){
+    SegV[SegN]->Checkpoint(Commit);}
+  CheckpointP=true;
+}
+
+void TMBlobBs::OnCommit(){
+  for (int SegN=0; SegN<SegV.Len(); SegN++){
+    SegV[SegN]->OnCommit();}
+}
+
 bool TMBlobBs::Exists(const TStr& BlobBsFNm){
   TStr NrFPath; TStr NrFMid; GetNrFPathFMid(BlobBsFNm, NrFPath, NrFMid);
   TStr MainFNm=GetMainFNm(NrFPath, NrFMid);
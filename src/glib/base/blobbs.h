@@ -143,8 +143,8 @@ public:
   void GetAllocInfo(
    const int& BfL, const TIntV& BlockLenV, int& MxBfL, int& FFreeBlobPtN);
 
-  uint GetBeginBlobTag(){return 0xABCDEFFF;}
-  uint GetEndBlobTag(){return 0xFFFEDCBA;}
+  uint GetBeginBlobTag() const {return 0xABCDEFFF;}
+  uint GetEndBlobTag() const {return 0xFFFEDCBA;}
   void PutBlobTag(const PFRnd& FBlobBs, const TBlobTag& BlobTag);
   void AssertBlobTag(const PFRnd& FBlobBs, const TBlobTag& BlobTag);
 
@@ -152,13 +152,16 @@ public:
   TBlobState GetBlobState(const PFRnd& FBlobBs);
   void AssertBlobState(const PFRnd& FBlobBs, const TBlobState& State);
 
-  void AssertBfCsEqFlCs(const TCs& BfCs, const TCs& FCs);
+  void AssertBfCsEqFlCs(const TCs& BfCs, const TCs& FCs) const;
 
   virtual TBlobPt PutBlob(const PSIn& SIn)=0;
   TBlobPt PutBlob(const TStr& Str){
     PSIn SIn=TStrIn::New(Str); return PutBlob(SIn);}
   virtual TBlobPt PutBlob(const TBlobPt& BlobPt, const PSIn& SIn)=0;
   virtual PSIn GetBlob(const TBlobPt& BlobPt)=0;
+  // reads the blob without using the file position; safe to call from
+  // several threads, as long as no blob is written at the same time
+  virtual PSIn GetBlobAt(const TBlobPt& BlobPt) const=0;
   virtual void DelBlob(const TBlobPt& BlobPt)=0;
 
   virtual TBlobPt GetFirstBlobPt()=0;
@@ -166,6 +169,14 @@ public:
   virtual bool FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn)=0;
   bool FNextBlobPt(TBlobPt& TrvBlobPt, PSIn& BlobSIn){
     TBlobPt BlobPt; return FNextBlobPt(TrvBlobPt, BlobPt, BlobSIn);}
+
+  // adds blob-base state to the commit; after the first checkpoint the
+  // blob-base switches to copy-on-write: blobs belonging to the last
+  // committed checkpoint are not overwritten or reused until the next
+  // checkpoint is committed, so reopening always sees a consistent state
+  virtual void Checkpoint(TFCommit& Commit)=0;
+  // called after the commit with the checkpoint was applied
+  virtual void OnCommit()=0;
 };
 
 /////////////////////////////////////////////////
@@ -178,7 +189,18 @@ private:
   TIntV BlockLenV;
   TBlobPtV FFreeBlobPtV;
   TBlobPt FirstBlobPt;
+  // copy-on-write mode; free lists are kept in memory and in a side-file
+  TStr FreeFNm;
+  bool ShadowP;
+  uint EndAddr;
+  TVec<TUIntV> FreeAddrVV;
+  // blobs deleted since last checkpoint, freed when the next one commits
+  TVec<TUIntV> DelAddrVV;
+  // blobs written since last checkpoint, can be changed in place
+  THashSet<TUInt> NewAddrSet;
   static TStr GetNrBlobBsFNm(const TStr& BlobBsFNm);
+  void InitShadow();
+  void LoadShadow();
 public:
   TGBlobBs(const TStr& BlobBsFNm, const TFAccess& _Access=faRdOnly,
    const int& _MxSegLen=-1);
@@ -193,12 +215,16 @@ public:
   TBlobPt PutBlob(const PSIn& SIn);
   TBlobPt PutBlob(const TBlobPt& BlobPt, const PSIn& SIn);
   PSIn GetBlob(const TBlobPt& BlobPt);
+  PSIn GetBlobAt(const TBlobPt& BlobPt) const;
   void DelBlob(const TBlobPt& BlobPt);
 
   TBlobPt GetFirstBlobPt(){return FirstBlobPt;}
   TBlobPt FFirstBlobPt();
   bool FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn);
 
+  void Checkpoint(TFCommit& Commit);
+  void OnCommit();
+
   static bool Exists(const TStr& BlobBsFNm);
 };
 
@@ -211,11 +237,12 @@ private:
   TStr NrFPath, NrFMid;
   TBlobBsV SegV;
   int CurSegN;
+  bool CheckpointP;
   static void GetNrFPathFMid(const TStr& BlobBsFNm, TStr& NrFPath, TStr& NrFMid);
   static TStr GetMainFNm(const TStr& NrFPath, const TStr& NrFMid);
   static TStr GetSegFNm(const TStr& NrFPath, const TStr& NrFMid, const int& SegN);
   void LoadMain(int& Segs);
-  void SaveMain() const;
+  void SaveMain(const TStr& MainFNm) const;
 public:
   TMBlobBs(const TStr& BlobBsFNm, const TFAccess& _Access=faRdOnly,
    const int& _MxSegLen=-1);
@@ -231,12 +258,16 @@ public:
   TBlobPt PutBlob(const PSIn& SIn);
   TBlobPt PutBlob(const TBlobPt& BlobPt, const PSIn& SIn);
   PSIn GetBlob(const TBlobPt& BlobPt);
+  PSIn GetBlobAt(const TBlobPt& BlobPt) const;
   void DelBlob(const TBlobPt& BlobPt);
 
   TBlobPt GetFirstBlobPt();
   TBlobPt FFirstBlobPt();
   bool FNextBlobPt(TBlobPt& TrvBlobPt, TBlobPt& BlobPt, PSIn& BlobSIn);
 
+  void Checkpoint(TFCommit& Commit);
+  void OnCommit();
+
   static bool Exists(const TStr& BlobBsFNm);
 };
 
@@ -165,6 +165,27 @@ void TValCache<TVal>::GetVal(const int& _ValId, TVal& Val) const {
 	ValCache.Put(ValId, ValDat);
 }
 
+///////////////////////////////
+// Block-Cache-Shard
+//   Part of a block cache with its own lock. Blocks are assigned to
+//   shards by their id, so readers of different blocks rarely wait
+//   for each other.
+template <class TDat>
+class TBlockCacheShard {
+private:
+	TCRef CRef;
+	typedef TPt<TBlockCacheShard<TDat> > PBlockCacheShard;
+public:
+	TQCache<TInt, TDat> Cache;
+	TSysCs Cs;
+
+	TBlockCacheShard(const int64& MxCacheMem, void* RefToBs): Cache(MxCacheMem, RefToBs) { }
+	static PBlockCacheShard New(const int64& MxCacheMem, void* RefToBs) { 
+		return new TBlockCacheShard(MxCacheMem, RefToBs); }
+
+	friend class TPt<TBlockCacheShard<TDat> >;
+};
+
 ///////////////////////////////
 // Block-Cache
 // 
@@ -175,6 +196,10 @@ void TValCache<TVal>::GetVal(const int& _ValId, TVal& Val) const {
 //    - void Load(TSIn& SIn)
 //    - void Save(TSOut& SOut) const
 //
+//   Blocks are kept in a scan-resistant cache (TQCache), split into
+//   CacheShards shards. Values can be read by many threads at once, 
+//   exclusion between the writer and readers is left to the caller.
+//
 template <class TVal>
 class TBlockCache {
 private:
@@ -184,12 +209,18 @@ private:
 	private:
 		TBool ChangedP;
 		TVec<TVal> ValV;
+		// memory used by the block, updated with each change
+		int64 MemUsed;
 
 	public:
-		TBlockDat(): ChangedP(true) { }
+		TBlockDat(): ChangedP(true), MemUsed((int64)sizeof(TVec<TVal>)) { }
 		static PBlockDat New() { return new TBlockDat; }
 		// serialization
-		TBlockDat(TSIn& SIn): ChangedP(false) { ValV.Load(SIn); }
+		TBlockDat(TSIn& SIn): ChangedP(false), MemUsed((int64)sizeof(TVec<TVal>)) { 
+			ValV.Load(SIn); 
+			for (int ValN = 0; ValN < ValV.Len(); ValN++) {
+				MemUsed += (int64)ValV[ValN].GetMemUsed(); }
+		}
 		static PBlockDat Load(TSIn& SIn) { return new TBlockDat(SIn); }
 		void Save(TSOut& SOut) const { ValV.Save(SOut); }
 
@@ -197,44 +228,43 @@ private:
 		int GetVals() const { return ValV.Len(); }
 		bool IsFull(const int& BlockSize) const { return !(ValV.Len() < BlockSize); }
 		// add new value
-		int AddVal(const TVal& Val) { ChangedP = true; return ValV.Add(Val); }
+		int AddVal(const TVal& Val) { 
+			ChangedP = true; MemUsed += (int64)Val.GetMemUsed(); return ValV.Add(Val); }
 		// updated existing value
-		void SetVal(const int& ValId, const TVal& Val) { ChangedP = true; ValV[ValId] = Val; }
+		void SetVal(const int& ValId, const TVal& Val) { 
+			ChangedP = true; MemUsed += (int64)Val.GetMemUsed() - (int64)ValV[ValId].GetMemUsed();
+			ValV[ValId] = Val; }
 		// retrieve value
 		bool IsValId(const int& ValId) const { return (ValId >= 0) && (ValId < ValV.Len()); }
 		const TVal& GetVal(const int& ValId) const { return ValV[ValId]; }
 
 		// need to report size, for keeping up used-up space in cache
-        int64 GetMemUsed() const {
-			int64 MemUsed = (int64)sizeof(TVec<TVal>);
-			for (int ValN = 0; ValN < ValV.Len(); ValN++) {
-				MemUsed += (int64)ValV[ValN].GetMemUsed(); }
-			return MemUsed;
-		}
+		int64 GetMemUsed() const { return MemUsed; }
         // store only on delete-from cache (in case new values added)
         void OnDelFromCache(const TInt& BlockId, void* BlockCache) {
 			if (ChangedP && !((TBlockCache*)BlockCache)->IsReadOnly()) {
-				((TBlockCache*)BlockCache)->StoreBlock(BlockId); }
+				((TBlockCache*)BlockCache)->StoreBlock(BlockId, *this); ChangedP = false; }
 		}
 	};
+	typedef TBlockCacheShard<PBlockDat> TCacheShard;
+	typedef TPt<TCacheShard> PCacheShard;
 
 private:
     // remember access mode
     TStr FNmPrefix;
     TFAccess Access;
-	// max memory to be used by cache
-    int64 CacheResetThreshold;
-    int64 NewCacheSizeInc;
 	// number of items
 	TInt Vals;
 	// block-size
 	TInt BlockSize;
 
-	// value cache
-	mutable TCache<TInt, PBlockDat> BlockCache;
+	// block cache, split into shards
+	TVec<PCacheShard> CacheShardV;
 	// value disk store
     TBlobPtV BlockBlobPtV;
 	PBlobBs BlockBlobBs;
+	// disk store keeps a file position, so it is used by one thread at a time
+	mutable TSysCs BlobCs;
 
 private:
     // asserts if we are allowed to change stuff
@@ -244,14 +274,19 @@ private:
 
 	// for callbacks from cache, to store blocks before drop from cache
     void* GetVoidThis() const { return (void*)this; }
-	void StoreBlock(const int& BlockId);
+	void StoreBlock(const int& BlockId, const TBlockDat& BlockDat);
 
+	// create cache shards
+	void InitCacheShards(const int64& MxCacheMem, const int& CacheShards);
+	// shard holding the given block
+	TCacheShard& GetCacheShard(const int& BlockId) const {
+		return *CacheShardV[BlockId % CacheShardV.Len()]; }
 	// add new block to the end
 	int AddBlock();
-	// get block from cache or load from disc
+	// get block from cache or load from disc, caller holds the lock of its shard
 	void GetBlock(const int& BlockId, PBlockDat& BlockDat) const;
-	// returns last block in vector, creates a new one if full
-	int GetLastBlock(PBlockDat& BlockDat);
+	// returns id of last block, creates a new one if full
+	int GetLastBlockId();
 
 	// value id transformations
 	uint64 GetValId(const int& BlockId, const int& BlockValId) const {
@@ -264,8 +299,10 @@ private:
 	// undef default, copy and assign
 	UndefDefaultCopyAssign(TBlockCache);
 public:
-    TBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem, const int& _BlockSize);
-    TBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access, const int64& MxCacheMem);
+	TBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem, 
+		const int& _BlockSize, const int& CacheShards = 1);
+	TBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access, 
+		const int64& MxCacheMem, const int& CacheShards = 1);
 	~TBlockCache();
 
 	// properties
@@ -279,14 +316,17 @@ public:
 	int Len() const { return Vals; }
 	bool IsValId(const uint64& ValId) const;
 	void GetVal(const uint64& ValId, TVal& Val) const;
+
+	// cache statistics, summed over shards
+	void GetCacheStat(int64& MemUsed, int64& Hits, int64& Misses, int64& Evictions) const;
 };
 
 template <class TVal>
-void TBlockCache<TVal>::StoreBlock(const int& BlockId) {
+void TBlockCache<TVal>::StoreBlock(const int& BlockId, const TBlockDat& BlockDat) {
 	AssertReadOnly();
-    PBlockDat BlockDat; EAssert(BlockCache.Get(BlockId, BlockDat));
 	// store value to the disk
-	TMOut MOut; BlockDat->Save(MOut);
+	TMOut MOut; BlockDat.Save(MOut);
+	TSysCsLock Lock(BlobCs);
 	const TBlobPt& BlockBlobPt = BlockBlobPtV[BlockId];
 	if (BlockBlobPt.Empty()) {
 		// first time
@@ -297,62 +337,61 @@ void TBlockCache<TVal>::StoreBlock(const int& BlockId) {
 	}
 }
 
+template <class TVal>
+void TBlockCache<TVal>::InitCacheShards(const int64& MxCacheMem, const int& CacheShards) {
+	EAssertR(CacheShards > 0, "Block cache needs at least one shard");
+	for (int ShardN = 0; ShardN < CacheShards; ShardN++) {
+		CacheShardV.Add(TCacheShard::New(MxCacheMem / CacheShards, GetVoidThis()));
+	}
+}
+
 template <class TVal>
 void TBlockCache<TVal>::GetBlock(const int& BlockId, PBlockDat& BlockDat) const {
+	TQCache<TInt, PBlockDat>& BlockCache = GetCacheShard(BlockId).Cache;
 	// load from the cache
 	if (!BlockCache.Get(BlockId, BlockDat)) {
 		// if not in there, load from disk
-		const TBlobPt& BlockBlobPt = BlockBlobPtV[(int)BlockId];
-		PSIn SIn = BlockBlobBs->GetBlob(BlockBlobPt); 
-		BlockDat = TBlockDat::Load(*SIn);
+		{ TSysCsLock Lock(BlobCs);
+		  PSIn SIn = BlockBlobBs->GetBlob(BlockBlobPtV[BlockId]);
+		  BlockDat = TBlockDat::Load(*SIn); }
+		// add to the cache
+		BlockCache.Put(BlockId, BlockDat);
 	}
-	// bring to the top of cache
-	BlockCache.Put(BlockId, BlockDat);
 }
 
 template <class TVal>
 int TBlockCache<TVal>::AddBlock() {
-	// creat new block
-	PBlockDat BlockDat = TBlockDat::New();
 	// mark existance of the block with empty disk-blob pointer
 	const int BlockId = BlockBlobPtV.Add(TBlobPt());
-	// add it to cache
-	BlockCache.Put(BlockId, BlockDat);
-	// update cache size increase with the size of cache key and empty block
-	NewCacheSizeInc += sizeof(TInt) + BlockDat->GetMemUsed(); 
+	// add new block to cache
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
+	CacheShard.Cache.Put(BlockId, TBlockDat::New());
 	// return id of the new block
 	return BlockId;
 }
 
 template <class TVal>
-int TBlockCache<TVal>::GetLastBlock(PBlockDat& BlockDat) {
+int TBlockCache<TVal>::GetLastBlockId() {
 	// ID of the last block in the queue
 	const int LastBlockId = BlockBlobPtV.Len()-1;
-	// retrieve block
-	GetBlock(LastBlockId, BlockDat);
-	// if full, make a new one
-	if (BlockDat->IsFull(BlockSize)) {
-		//creat new block
-		const int NewBlockId = AddBlock();
-		// return its reference
-		GetBlock(NewBlockId, BlockDat);
-		// and new block id
-		return NewBlockId;
-	}
-	// just return existing last block id
-	return LastBlockId;
+	{ TSysCsLock Lock(GetCacheShard(LastBlockId).Cs);
+	  PBlockDat BlockDat; GetBlock(LastBlockId, BlockDat);
+	  // just return existing last block id, when not full
+	  if (!BlockDat->IsFull(BlockSize)) { return LastBlockId; } }
+	// otherwise make a new one
+	return AddBlock();
 }
 
 template <class TVal>
 TBlockCache<TVal>::TBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem,
-		const int& _BlockSize): BlockSize(_BlockSize), BlockCache(MxCacheMem, 1000000, GetVoidThis()) {
+		const int& _BlockSize, const int& CacheShards): BlockSize(_BlockSize) {
 
 	// initialize storage parameters
     FNmPrefix = _FNmPrefix;
     Access = faCreate;
-	// initialize cache parameters
-	CacheResetThreshold = MAX(int64(0.1 * double(MxCacheMem)), int64(10*1024*1024));
-	NewCacheSizeInc = 0;
+	// initialize cache
+	InitCacheShards(MxCacheMem, CacheShards);
 	// initialize value disk store
 	try {
 		BlockBlobBs = TMBlobBs::New(FNmPrefix + "BlobBs", Access);
@@ -370,14 +409,13 @@ TBlockCache<TVal>::TBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem,
 
 template <class TVal>
 TBlockCache<TVal>::TBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access,
-		const int64& MxCacheMem): BlockCache(MxCacheMem, 1000000, GetVoidThis()) {
+		const int64& MxCacheMem, const int& CacheShards) {
 
 	// initialize storage parameters
     FNmPrefix = _FNmPrefix;
     Access = _Access;
-	// initialize cache parameters
-	CacheResetThreshold = MAX(int64(0.1 * double(MxCacheMem)), int64(10*1024*1024));
-	NewCacheSizeInc = 0;
+	// initialize cache
+	InitCacheShards(MxCacheMem, CacheShards);
 	// initialize value disk store
     BlockBlobBs = TMBlobBs::New(FNmPrefix + "BlobBs", Access);
 	// make sure we are not trying to create
@@ -393,7 +431,10 @@ template <class TVal>
 TBlockCache<TVal>::~TBlockCache() {
     if ((Access == faCreate) || (Access == faUpdate)) {
         // flush all the latest changes in cache to the disk
-        BlockCache.Flush();
+		for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+			TSysCsLock Lock(CacheShardV[ShardN]->Cs);
+			CacheShardV[ShardN]->Cache.Flush();
+		}
         // save the rest to FNmPrefix + ".Dat"
         TFOut FOut(FNmPrefix + ".Dat");
 		Vals.Save(FOut);
@@ -405,28 +446,14 @@ TBlockCache<TVal>::~TBlockCache() {
 template <class TVal>
 uint64 TBlockCache<TVal>::AddVal(const TVal& Val) {
 	// get last block, with some space left
-	PBlockDat BlockDat; 
-	const int BlockId = GetLastBlock(BlockDat);
+	const int BlockId = GetLastBlockId();
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
+	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	// add the value to the block
 	const int BlockValId = BlockDat->AddVal(Val);
-	// update cache increase count
-    NewCacheSizeInc += BlockDat->GetVal(BlockValId).GetMemUsed();
-    // check if we have to drop anything from the cache
-    if (NewCacheSizeInc > CacheResetThreshold) {
-		// report on the size increase
-        printf("Cache clean-up [%s] ... ", TUInt64::GetMegaStr(NewCacheSizeInc).CStr());
-		//// report on the current size
-		//const uint64 OldSize = BlockCache.GetMemUsed();
-		//printf("[%s] ... ", TUInt64::GetMegaStr(OldSize).CStr());
-		// refresh memory count
-		BlockCache.RefreshMemUsed();
-		//// report on the current size
-		//const uint64 NewSize = BlockCache.GetMemUsed();
-		//printf("[%s] ", TUInt64::GetMegaStr(NewSize).CStr());
-		printf("Done\n");
-		// reset increase counter
-        NewCacheSizeInc = 0; 
-	}
+	// update memory used by the block, this can drop other blocks from cache
+	CacheShard.Cache.UpdateMemUsed(BlockId);
 	// increase count of all values
 	Vals++;
 	// compute the value ID as a combination of BlockId and BlockValId
@@ -439,9 +466,12 @@ void TBlockCache<TVal>::SetVal(const uint64& ValId, const TVal& Val) {
 	int BlockId = -1, BlockValId = -1;
 	GetBlockId(ValId, BlockId, BlockValId);
 	// get the block
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
 	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	// set the val
 	BlockDat->SetVal(BlockValId, Val);
+	CacheShard.Cache.UpdateMemUsed(BlockId);
 }
 
 template <class TVal>
@@ -451,6 +481,7 @@ bool TBlockCache<TVal>::IsValId(const uint64& ValId) const {
 	GetBlockId(ValId, BlockId, BlockValId);
 	// check all is fine
 	if (BlockId < 0 || BlockId >= BlockBlobPtV.Len()) { return false; }
+	TSysCsLock Lock(GetCacheShard(BlockId).Cs);
 	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	return BlockDat->IsValId(BlockValId);	
 }
@@ -461,11 +492,25 @@ void TBlockCache<TVal>::GetVal(const uint64& ValId, TVal& Val) const {
 	int BlockId = -1, BlockValId = -1;
 	GetBlockId(ValId, BlockId, BlockValId);
 	// get the block
+	TSysCsLock Lock(GetCacheShard(BlockId).Cs);
 	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	// get the val
 	Val = BlockDat->GetVal(BlockValId);
 }
 
+template <class TVal>
+void TBlockCache<TVal>::GetCacheStat(int64& MemUsed, int64& Hits, 
+		int64& Misses, int64& Evictions) const {
+
+	MemUsed = 0; Hits = 0; Misses = 0; Evictions = 0;
+	for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+		TSysCsLock Lock(CacheShardV[ShardN]->Cs);
+		const TQCache<TInt, PBlockDat>& BlockCache = CacheShardV[ShardN]->Cache;
+		MemUsed += BlockCache.GetMemUsed(); Hits += BlockCache.GetHits();
+		Misses += BlockCache.GetMisses(); Evictions += BlockCache.GetEvictions();
+	}
+}
+
 ///////////////////////////////
 // Windowed-Block-Cache
 // 
@@ -476,6 +521,10 @@ void TBlockCache<TVal>::GetVal(const uint64& ValId, TVal& Val) const {
 //    - void Load(TSIn& SIn)
 //    - void Save(TSOut& SOut) const
 //
+//   Blocks are kept in a scan-resistant cache (TQCache), split into
+//   CacheShards shards. Values can be read by many threads at once, 
+//   exclusion between the writer and readers is left to the caller.
+//
 template <class TVal>
 class TWndBlockCache {
 private:
@@ -485,13 +534,19 @@ private:
 	private:
 		TBool ChangedP;
 		TVec<TVal> ValV;
+		// memory used by the block, updated with each change
+		int64 MemUsed;
 
 	public:
 
-		TBlockDat(): ChangedP(true) { }
+		TBlockDat(): ChangedP(true), MemUsed((int64)sizeof(TVec<TVal>)) { }
 		static PBlockDat New() { return new TBlockDat; }
 		// serialization
-		TBlockDat(TSIn& SIn): ChangedP(false) { ValV.Load(SIn); }
+		TBlockDat(TSIn& SIn): ChangedP(false), MemUsed((int64)sizeof(TVec<TVal>)) { 
+			ValV.Load(SIn); 
+			for (int ValN = 0; ValN < ValV.Len(); ValN++) {
+				MemUsed += (int64)ValV[ValN].GetMemUsed(); }
+		}
 		static PBlockDat Load(TSIn& SIn) { return new TBlockDat(SIn); }
 		void Save(TSOut& SOut) const { ValV.Save(SOut); }
 
@@ -499,49 +554,50 @@ private:
 		int GetVals() const { return ValV.Len(); }
 		bool IsFull(const int& BlockSize) const { return !(ValV.Len() < BlockSize); }
 		// add new value
-		int AddVal(const TVal& Val) { ChangedP = true; return ValV.Add(Val); }
+		int AddVal(const TVal& Val) { 
+			ChangedP = true; MemUsed += (int64)Val.GetMemUsed(); return ValV.Add(Val); }
 		// updated existing value
-		void SetVal(const int& ValId, const TVal& Val) { ChangedP = true; ValV[ValId] = Val; }
+		void SetVal(const int& ValId, const TVal& Val) { 
+			ChangedP = true; MemUsed += (int64)Val.GetMemUsed() - (int64)ValV[ValId].GetMemUsed();
+			ValV[ValId] = Val; }
 		// retrieve value
 		bool IsValId(const int& ValId) const { return (ValId >= 0) && (ValId < ValV.Len()); }
 		const TVal& GetVal(const int& ValId) const { return ValV[ValId]; }
 
 		// need to report size, for keeping up used-up space in cache
-		int64 GetMemUsed() const {
-			int64 MemUsed = (int64)sizeof(TVec<TVal>);
-			for (int ValN = 0; ValN < ValV.Len(); ValN++) {
-				MemUsed += (int64)ValV[ValN].GetMemUsed(); }
-			return MemUsed;
-		}
+		int64 GetMemUsed() const { return MemUsed; }
 		// store only on delete-from cache (in case new values added)
 		void OnDelFromCache(const TInt& BlockId, void* WndBlockCache) {
 			if (ChangedP && !((TWndBlockCache*)WndBlockCache)->IsReadOnly()) {
-				((TWndBlockCache*)WndBlockCache)->StoreBlock(BlockId); }
+				((TWndBlockCache*)WndBlockCache)->StoreBlock(BlockId, *this); ChangedP = false; }
 		}
 	};
+	typedef TBlockCacheShard<PBlockDat> TCacheShard;
+	typedef TPt<TCacheShard> PCacheShard;
 
 private:
 	// remember access mode
 	TStr FNmPrefix;
 	TFAccess Access;
-	// max memory to be used by cache
-	int64 CacheResetThreshold;
-	int64 NewCacheSizeInc;
 	// number of items
 	TInt Vals;
 	// block-size
 	TInt BlockSize;
 
-	// value cache
-	mutable TCache<TInt, PBlockDat> BlockCache;
+	// block cache, split into shards
+	TVec<PCacheShard> CacheShardV;
 	// value disk store
 	TBlobPtV BlockBlobPtV;
 	PBlobBs BlockBlobBs;
+	// disk store keeps a file position, so it is used by one thread at a time
+	mutable TSysCs BlobCs;
 
 	// offset of the oldest block
 	TInt FirstBlockOffset;
 	// offset of the oldest record within the oldest block
 	TInt FirstValOffset;
+	// once checkpointed, state is persisted only by checkpoints
+	TBool CheckpointP;
 
 private:
 	// asserts if we are allowed to change stuff
@@ -551,16 +607,25 @@ private:
 
 	// for callbacks from cache, to store blocks before drop from cache
 	void* GetVoidThis() const { return (void*)this; }
-	void StoreBlock(const int& BlockId);
+	void StoreBlock(const int& BlockId, const TBlockDat& BlockDat);
 
+	// create cache shards
+	void InitCacheShards(const int64& MxCacheMem, const int& CacheShards);
+	// shard holding the given block
+	TCacheShard& GetCacheShard(const int& BlockId) const {
+		return *CacheShardV[BlockId % CacheShardV.Len()]; }
 	// add new block to the end
 	int AddBlock();
-	// get block from cache or load from disc
+	// get block from cache or load from disc, caller holds the lock of its shard
 	void GetBlock(const int& BlockId, PBlockDat& BlockDat) const;
-	// returns last block in vector, creates a new one if full
-	int GetLastBlock(PBlockDat& BlockDat);
+	// returns id of last block, creates a new one if full
+	int GetLastBlockId();
 	// delete oldest block
 	void DelBlock();
+	// write changed blocks from cache to disk
+	void FlushCache();
+	// save block map and counters
+	void SaveDat(const TStr& DatFNm) const;
 
 	// value id transformations
 	uint64 GetValId(const int& BlockId, const int& BlockValId) const {
@@ -572,8 +637,10 @@ private:
 	}
 	
 public:
-	TWndBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem, const int& _BlockSize);
-	TWndBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access, const int64& MxCacheMem);
+	TWndBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem, 
+		const int& _BlockSize, const int& CacheShards = 1);
+	TWndBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access, 
+		const int64& MxCacheMem, const int& CacheShards = 1);
 	~TWndBlockCache();
 
 	// properties
@@ -596,16 +663,23 @@ public:
 	bool DelVal();
 	// delete first N values
 	int DelVals(const int& _Vals);
+
+	// cache statistics, summed over shards
+	void GetCacheStat(int64& MemUsed, int64& Hits, int64& Misses, int64& Evictions) const;
+
+	// write changed blocks and add state to the commit
+	void Checkpoint(TFCommit& Commit);
+	// called after the commit was applied
+	void OnCommit() { BlockBlobBs->OnCommit(); }
 };
 
 template <class TVal>
-void TWndBlockCache<TVal>::StoreBlock(const int& BlockId) {
+void TWndBlockCache<TVal>::StoreBlock(const int& BlockId, const TBlockDat& BlockDat) {
 	AssertReadOnly();
-	PBlockDat BlockDat; 
-	EAssert(BlockCache.Get(BlockId, BlockDat));
 	// store value to the disk
 	TMOut MOut; 
-	BlockDat->Save(MOut);
+	BlockDat.Save(MOut);
+	TSysCsLock Lock(BlobCs);
 	int _BlockId = BlockId - FirstBlockOffset;
 	const TBlobPt& BlockBlobPt = BlockBlobPtV[_BlockId];
 	if (BlockBlobPt.Empty()) {
@@ -617,51 +691,51 @@ void TWndBlockCache<TVal>::StoreBlock(const int& BlockId) {
 	}
 }
 
+template <class TVal>
+void TWndBlockCache<TVal>::InitCacheShards(const int64& MxCacheMem, const int& CacheShards) {
+	EAssertR(CacheShards > 0, "Block cache needs at least one shard");
+	for (int ShardN = 0; ShardN < CacheShards; ShardN++) {
+		CacheShardV.Add(TCacheShard::New(MxCacheMem / CacheShards, GetVoidThis()));
+	}
+}
+
 template <class TVal>
 void TWndBlockCache<TVal>::GetBlock(const int& BlockId, PBlockDat& BlockDat) const {
+	TQCache<TInt, PBlockDat>& BlockCache = GetCacheShard(BlockId).Cache;
 	// load from the cache
 	if (!BlockCache.Get(BlockId, BlockDat)) {
 		// if not in there, load from disk
+		{ TSysCsLock Lock(BlobCs);
 		int _BlockId = BlockId - FirstBlockOffset;
-		const TBlobPt& BlockBlobPt = BlockBlobPtV[_BlockId];
-		PSIn SIn = BlockBlobBs->GetBlob(BlockBlobPt); 
-		BlockDat = TBlockDat::Load(*SIn);
+		  PSIn SIn = BlockBlobBs->GetBlob(BlockBlobPtV[_BlockId]); 
+		  BlockDat = TBlockDat::Load(*SIn); }
+		// add to the cache
+		BlockCache.Put(BlockId, BlockDat);
 	}
-	// bring to the top of cache
-	BlockCache.Put(BlockId, BlockDat);
 }
 
 template <class TVal>
 int TWndBlockCache<TVal>::AddBlock() {
-	// create new block
-	PBlockDat BlockDat = TBlockDat::New();
 	// mark existance of the block with empty disk-blob pointer
 	const int BlockId = BlockBlobPtV.Add(TBlobPt()) + FirstBlockOffset;
-	// add it to cache
-	BlockCache.Put(BlockId, BlockDat);
-	// update cache size increase with the size of cache key and empty block
-	NewCacheSizeInc += sizeof(TInt) + BlockDat->GetMemUsed(); 
+	// add new block to cache
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
+	CacheShard.Cache.Put(BlockId, TBlockDat::New());
 	// return id of the new block
 	return BlockId;
 }
 
 template <class TVal>
-int TWndBlockCache<TVal>::GetLastBlock(PBlockDat& BlockDat) {
+int TWndBlockCache<TVal>::GetLastBlockId() {
 	// ID of the last block in the queue
 	const int LastBlockId = BlockBlobPtV.Len() - 1 + FirstBlockOffset;
-	// retrieve block
-	GetBlock(LastBlockId, BlockDat);
-	// if full, make a new one
-	if (BlockDat->IsFull(BlockSize)) {
-		//creat new block
-		const int NewBlockId = AddBlock();
-		// return its reference
-		GetBlock(NewBlockId, BlockDat);
-		// and new block id
-		return NewBlockId;
-	}
-	// just return existing last block id
-	return LastBlockId;
+	{ TSysCsLock Lock(GetCacheShard(LastBlockId).Cs);
+	  PBlockDat BlockDat; GetBlock(LastBlockId, BlockDat);
+	  // just return existing last block id, when not full
+	  if (!BlockDat->IsFull(BlockSize)) { return LastBlockId; } }
+	// otherwise make a new one
+	return AddBlock();
 }
 
 template <class TVal>
@@ -669,8 +743,11 @@ void TWndBlockCache<TVal>::DelBlock() {
 	// get first block id
 	const int FirstBlockId = FirstBlockOffset;
 	// delete from cache
-	BlockCache.Del(FirstBlockId, false);
+	{ TCacheShard& CacheShard = GetCacheShard(FirstBlockId);
+	  TSysCsLock Lock(CacheShard.Cs);
+	  CacheShard.Cache.Del(FirstBlockId, false); }
 	// delete from blob
+	TSysCsLock Lock(BlobCs);
 	if (!BlockBlobPtV[0].Empty()) { 
 		BlockBlobBs->DelBlob(BlockBlobPtV[0]);
 	}
@@ -678,16 +755,33 @@ void TWndBlockCache<TVal>::DelBlock() {
 	BlockBlobPtV.Del(0);
 }
 
+template <class TVal>
+void TWndBlockCache<TVal>::FlushCache() {
+	for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+		TSysCsLock Lock(CacheShardV[ShardN]->Cs);
+		CacheShardV[ShardN]->Cache.Flush();
+	}
+}
+
+template <class TVal>
+void TWndBlockCache<TVal>::SaveDat(const TStr& DatFNm) const {
+	TFOut FOut(DatFNm);
+	Vals.Save(FOut);
+	BlockSize.Save(FOut);
+	BlockBlobPtV.Save(FOut);
+	FirstBlockOffset.Save(FOut);
+	FirstValOffset.Save(FOut);
+}
+
 template <class TVal>
 TWndBlockCache<TVal>::TWndBlockCache(const TStr& _FNmPrefix, const int64& MxCacheMem, 
-		const int& _BlockSize): BlockSize(_BlockSize), BlockCache(MxCacheMem, 1000000, GetVoidThis()) {
+		const int& _BlockSize, const int& CacheShards): BlockSize(_BlockSize) {
 
 	// initialize storage parameters
 	FNmPrefix = _FNmPrefix;
 	Access = faCreate;
-	// initialize cache parameters
-	CacheResetThreshold = MAX(int64(0.1 * double(MxCacheMem)), int64(10*1024*1024));
-	NewCacheSizeInc = 0;
+	// initialize cache
+	InitCacheShards(MxCacheMem, CacheShards);
 	// initialize value disk store
 	try {
 		BlockBlobBs = TMBlobBs::New(FNmPrefix + "BlobBs", Access);
@@ -703,14 +797,13 @@ TWndBlockCache<TVal>::TWndBlockCache(const TStr& _FNmPrefix, const int64& MxCach
 
 template <class TVal>
 TWndBlockCache<TVal>::TWndBlockCache(const TStr& _FNmPrefix, const TFAccess& _Access,
-		const int64& MxCacheMem): BlockCache(MxCacheMem, 1000000, GetVoidThis()) {
+		const int64& MxCacheMem, const int& CacheShards) {
 
 	// initialize storage parameters
 	FNmPrefix = _FNmPrefix;
 	Access = _Access;
-	// initialize cache parameters
-	CacheResetThreshold = MAX(int64(0.1 * double(MxCacheMem)), int64(10*1024*1024));
-	NewCacheSizeInc = 0;
+	// initialize cache
+	InitCacheShards(MxCacheMem, CacheShards);
 	// initialize value disk store
 	BlockBlobBs = TMBlobBs::New(FNmPrefix + "BlobBs", Access);
 	// make sure we are not trying to create
@@ -726,37 +819,25 @@ TWndBlockCache<TVal>::TWndBlockCache(const TStr& _FNmPrefix, const TFAccess& _Ac
 
 template <class TVal>
 TWndBlockCache<TVal>::~TWndBlockCache() {
-	if ((Access == faCreate) || (Access == faUpdate)) {
+	if (((Access == faCreate) || (Access == faUpdate)) && !CheckpointP) {
 		// flush all the latest changes in cache to the disk		
-		BlockCache.Flush();
+		FlushCache();
 		// save the rest to FNmPrefix + ".Dat"
-		TFOut FOut(FNmPrefix + ".Dat");
-		Vals.Save(FOut);
-		BlockSize.Save(FOut);
-		BlockBlobPtV.Save(FOut);
-		FirstBlockOffset.Save(FOut);
-		FirstValOffset.Save(FOut);
+		SaveDat(FNmPrefix + ".Dat");
 	}
 }
 
 template <class TVal>
 uint64 TWndBlockCache<TVal>::AddVal(const TVal& Val) {
 	// get last block, with some space left
-	PBlockDat BlockDat; 
-	const int BlockId = GetLastBlock(BlockDat);
+	const int BlockId = GetLastBlockId();
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
+	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	// add the value to the block
 	const int BlockValId = BlockDat->AddVal(Val);
-	// update cache increase count
-	NewCacheSizeInc += BlockDat->GetVal(BlockValId).GetMemUsed();
-	// check if we have to drop anything from the cache
-	if (NewCacheSizeInc > CacheResetThreshold) {
-		// report on the size increase
-		printf("Cache clean-up [%s] ... ", TUInt64::GetMegaStr(NewCacheSizeInc).CStr());
-		BlockCache.RefreshMemUsed();
-		printf("Done\n");
-		// reset increase counter
-		NewCacheSizeInc = 0; 
-	}
+	// update memory used by the block, this can drop other blocks from cache
+	CacheShard.Cache.UpdateMemUsed(BlockId);
 	// increase count of all values
 	Vals++;
 	// return value id
@@ -769,9 +850,11 @@ void TWndBlockCache<TVal>::SetVal(const uint64& ValId, const TVal& Val) {
 	int BlockId = -1, BlockValId = -1;
 	GetBlockId(ValId, BlockId, BlockValId);
 	// get the block
-	PBlockDat BlockDat;
-	GetBlock(BlockId, BlockDat);
+	TCacheShard& CacheShard = GetCacheShard(BlockId);
+	TSysCsLock Lock(CacheShard.Cs);
+	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	BlockDat->SetVal(BlockValId, Val);
+	CacheShard.Cache.UpdateMemUsed(BlockId);
 }
 
 template <class TVal>
@@ -796,6 +879,7 @@ bool TWndBlockCache<TVal>::IsValId(const uint64& ValId) const {
 	if (BlockId == FirstBlockOffset && BlockValId < FirstValOffset) { return false; }
 	// check if value exists
 	//TODO: no need to pull the block out, unless it's the last last block
+	TSysCsLock Lock(GetCacheShard(BlockId).Cs);
 	PBlockDat BlockDat; GetBlock(BlockId, BlockDat);
 	return BlockDat->IsValId(BlockValId);
 }
@@ -804,6 +888,7 @@ template <class TVal>
 uint64 TWndBlockCache<TVal>::GetFirstVal(TVal& Val) const {
 	int BlockId = FirstBlockOffset, BlockValId = FirstValOffset;
 	// get the block
+	TSysCsLock Lock(GetCacheShard(BlockId).Cs);
 	PBlockDat BlockDat;
 	GetBlock(BlockId, BlockDat);
 	// get the val
@@ -817,6 +902,7 @@ void TWndBlockCache<TVal>::GetVal(const uint64& ValId, TVal& Val) const {
 	int BlockId = -1, BlockValId = -1;
 	GetBlockId(ValId, BlockId, BlockValId);
 	// get the block
+	TSysCsLock Lock(GetCacheShard(BlockId).Cs);
 	PBlockDat BlockDat;
 	GetBlock(BlockId, BlockDat);
 	// get the val
@@ -852,4 +938,27 @@ int TWndBlockCache<TVal>::DelVals(const int& _Vals) {
 	return DeletedVals;
 }
 
+template <class TVal>
+void TWndBlockCache<TVal>::Checkpoint(TFCommit& Commit) {
+	AssertReadOnly();
+	// only blocks changed since last checkpoint are written, they stay in cache
+	FlushCache();
+	SaveDat(Commit.AddFNm(FNmPrefix + ".Dat"));
+	BlockBlobBs->Checkpoint(Commit);
+	CheckpointP = true;
+}
+
+template <class TVal>
+void TWndBlockCache<TVal>::GetCacheStat(int64& MemUsed, int64& Hits, 
+		int64& Misses, int64& Evictions) const {
+
+	MemUsed = 0; Hits = 0; Misses = 0; Evictions = 0;
+	for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+		TSysCsLock Lock(CacheShardV[ShardN]->Cs);
+		const TQCache<TInt, PBlockDat>& BlockCache = CacheShardV[ShardN]->Cache;
+		MemUsed += BlockCache.GetMemUsed(); Hits += BlockCache.GetHits();
+		Misses += BlockCache.GetMisses(); Evictions += BlockCache.GetEvictions();
+	}
+}
+
 #endif
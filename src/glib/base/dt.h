@@ -311,7 +311,7 @@ public:
     if ((MxLen==-1)||(BfL<MxLen)){operator+=(Ch);}}
   void AddChTo(const char& Ch, const int& ToChN){
     while (Len()<ToChN){AddCh(Ch);}}
-  void AddBf(char *NewBf, const int& BfS){
+  void AddBf(const char *NewBf, const int& BfS){
     if ((BfL+BfS+1)>MxBfL){Resize(BfL+BfS+1);}
     strncpy(Bf+BfL,NewBf,BfS); BfL+=BfS; Bf[BfL]=0;}
   void PutCh(const int& ChN, const char& Ch){
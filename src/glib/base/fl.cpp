@@ -17,11 +17,14 @@
  * 
  */
 
-#ifdef GLib_LINUX
+#ifdef GLib_UNIX
 extern "C" {
 	#include <sys/mman.h>
 }
 
+#endif
+#ifdef GLib_WIN
+#include <io.h>
 #endif
 
 /////////////////////////////////////////////////
@@ -860,6 +863,25 @@ void TFRnd::GetBf(void* Bf, const TSize& BfL){
    "Error reading file '"+TStr(FNm)+"'.");
 }
 
+void TFRnd::GetBfAt(const int& FPos, void* Bf, const TSize& BfL) const {
+#if defined(GLib_WIN)
+  HANDLE FileHnd=(HANDLE)_get_osfhandle(_fileno(FileId));
+  OVERLAPPED Overlapped; memset(&Overlapped, 0, sizeof(Overlapped));
+  Overlapped.Offset=DWORD(FPos);
+  DWORD ReadL=0;
+  EAssertR(
+   ReadFile(FileHnd, Bf, DWORD(BfL), &ReadL, &Overlapped)&&(ReadL==BfL),
+   "Error reading file '"+TStr(FNm)+"'.");
+#else
+  TSize ReadL=0;
+  while (ReadL<BfL){
+    const ssize_t BlockL=pread(fileno(FileId), (char*)Bf+ReadL, BfL-ReadL, FPos+ReadL);
+    EAssertR(BlockL>0, "Error reading file '"+TStr(FNm)+"'.");
+    ReadL+=TSize(BlockL);
+  }
+#endif
+}
+
 void TFRnd::PutBf(const void* Bf, const TSize& BfL){
   RefreshFPos();
   EAssertR(
@@ -871,6 +893,15 @@ void TFRnd::Flush(){
   EAssertR(fflush(FileId)==0, "Can not flush file '"+TStr(FNm)+"'.");
 }
 
+void TFRnd::Sync(){
+  Flush();
+#if defined(GLib_WIN)
+  EAssertR(_commit(_fileno(FileId))==0, "Can not sync file '"+TStr(FNm)+"'.");
+#else
+  EAssertR(fsync(fileno(FileId))==0, "Can not sync file '"+TStr(FNm)+"'.");
+#endif
+}
+
 void TFRnd::PutCh(const char& Ch, const int& Chs){
   if (Chs>0){
     char* CStr=new char[Chs];
@@ -949,6 +980,61 @@ TFAccess TFRnd::GetFAccessFromStr(const TStr& Str){
   return faUndef;
 }
 
+/////////////////////////////////////////////////
+// Memory-Mapped-File
+#if defined(GLib_WIN)
+
+TFMMap::TFMMap(const TStr& _FNm): FNm(_FNm.CStr()), Bf(NULL), BfL(0), 
+  FileHnd(INVALID_HANDLE_VALUE), MapHnd(NULL){
+  FileHnd=CreateFile(_FNm.CStr(), GENERIC_READ, FILE_SHARE_READ, NULL, 
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  EAssertR(FileHnd!=INVALID_HANDLE_VALUE, "Can not open file '"+_FNm+"'.");
+  LARGE_INTEGER FSize; EAssertR(GetFileSizeEx(FileHnd, &FSize), 
+    "Can not get size of file '"+_FNm+"'.");
+  BfL=uint64(FSize.QuadPart);
+  if (BfL>0){
+    MapHnd=CreateFileMapping(FileHnd, NULL, PAGE_READONLY, 0, 0, NULL);
+    EAssertR(MapHnd!=NULL, "Can not map file '"+_FNm+"'.");
+    Bf=(char*)MapViewOfFile(MapHnd, FILE_MAP_READ, 0, 0, 0);
+    EAssertR(Bf!=NULL, "Can not map file '"+_FNm+"'.");
+  }
+}
+
+TFMMap::~TFMMap(){
+  if (Bf!=NULL){UnmapViewOfFile(Bf);}
+  if (MapHnd!=NULL){CloseHandle(MapHnd);}
+  if (FileHnd!=INVALID_HANDLE_VALUE){CloseHandle(FileHnd);}
+}
+
+#else
+
+TFMMap::TFMMap(const TStr& _FNm): FNm(_FNm.CStr()), Bf(NULL), BfL(0){
+  int FileDesc=open(_FNm.CStr(), O_RDONLY);
+  EAssertR(FileDesc!=-1, "Can not open file '"+_FNm+"'.");
+  struct stat FStat;
+  if (fstat(FileDesc, &FStat)!=0){
+    close(FileDesc); TExcept::Throw("Can not get size of file '"+_FNm+"'.");}
+  BfL=uint64(FStat.st_size);
+  if (BfL>0){
+    void* MapBf=mmap(NULL, size_t(BfL), PROT_READ, MAP_SHARED, FileDesc, 0);
+    if (MapBf==MAP_FAILED){
+      close(FileDesc); TExcept::Throw("Can not map file '"+_FNm+"'.");}
+    Bf=(char*)MapBf;
+  }
+  // mapping stays valid after the descriptor is closed
+  close(FileDesc);
+}
+
+TFMMap::~TFMMap(){
+  if (Bf!=NULL){munmap(Bf, size_t(BfL));}
+}
+
+#endif
+
+TStr TFMMap::GetFNm() const {
+  return FNm.CStr();
+}
+
 /////////////////////////////////////////////////
 // Files
 const TStr TFile::TxtFExt=".Txt";
@@ -1086,6 +1172,38 @@ void TFile::Rename(const TStr& SrcFNm, const TStr& DstFNm){
    "Error renaming file '"+SrcFNm+"' to "+DstFNm+"'.");
 }
 
+void TFile::Replace(const TStr& SrcFNm, const TStr& DstFNm){
+#if defined(GLib_WIN)
+  EAssertR(MoveFileEx(SrcFNm.CStr(), DstFNm.CStr(),
+   MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)!=0,
+   "Error replacing file '"+DstFNm+"' with '"+SrcFNm+"'.");
+#else
+  // rename is atomic on posix and replaces existing destination
+  EAssertR(rename(SrcFNm.CStr(), DstFNm.CStr())==0,
+   "Error replacing file '"+DstFNm+"' with '"+SrcFNm+"'.");
+#endif
+}
+
+void TFile::Sync(const TStr& FNm){
+#if defined(GLib_WIN)
+  // directory entries are written through by MoveFileEx
+  if (TDir::Exists(FNm)){return;}
+  HANDLE hFile=CreateFile(FNm.CStr(), GENERIC_WRITE,
+   FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  EAssertR(hFile!=INVALID_HANDLE_VALUE, "Can not open file '"+FNm+"' for sync.");
+  const bool OkP=(FlushFileBuffers(hFile)!=0);
+  CloseHandle(hFile);
+  EAssertR(OkP, "Can not sync file '"+FNm+"'.");
+#else
+  // works also for directories, making renames in them durable
+  const int FileDesc=open(FNm.CStr(), O_RDONLY);
+  EAssertR(FileDesc!=-1, "Can not open file '"+FNm+"' for sync.");
+  const bool OkP=(fsync(FileDesc)==0);
+  close(FileDesc);
+  EAssertR(OkP, "Can not sync file '"+FNm+"'.");
+#endif
+}
+
 TStr TFile::GetUniqueFNm(const TStr& FNm){
   // <name>.#.txt --> <name>.<num>.txt
   int Cnt=1; int ch;
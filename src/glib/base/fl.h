@@ -543,8 +543,13 @@ public:
   int GetRecs();
 
   void GetBf(void* Bf, const TSize& BfL);
+  // reads at FPos without using the file position, so several threads can
+  // read at once; on Windows it can move the OS file position, which is
+  // fine as long as stream reads and writes start with SetFPos
+  void GetBfAt(const int& FPos, void* Bf, const TSize& BfL) const;
   void PutBf(const void* Bf, const TSize& BfL);
   void Flush();
+  void Sync();
 
   void GetHd(void* Hd){IAssert(RecAct);
     int FPos=GetFPos(); SetFPos(0); GetBf(Hd, HdLen); SetFPos(FPos);}
@@ -576,6 +581,29 @@ public:
   static TFAccess GetFAccessFromStr(const TStr& Str);
 };
 
+/////////////////////////////////////////////////
+// Memory-Mapped-File
+//   Read-only view of the whole file; pages come from the page cache and
+//   are shared between all processes mapping the same file
+ClassTP(TFMMap, PFMMap)//{
+private:
+  TSStr FNm;
+  char* Bf;
+  uint64 BfL;
+#if defined(GLib_WIN)
+  HANDLE FileHnd, MapHnd;
+#endif
+  UndefDefaultCopyAssign(TFMMap);
+public:
+  TFMMap(const TStr& _FNm);
+  static PFMMap New(const TStr& FNm){return new TFMMap(FNm);}
+  ~TFMMap();
+
+  TStr GetFNm() const;
+  const char* GetBf() const {return Bf;}
+  uint64 Len() const {return BfL;}
+};
+
 /////////////////////////////////////////////////
 // Files
 class TFile{
@@ -592,6 +620,10 @@ public:
   static bool Del(const TStr& FNm, const bool& ThrowExceptP=true);
   static void DelWc(const TStr& WcStr, const bool& RecurseDirP=false);
   static void Rename(const TStr& SrcFNm, const TStr& DstFNm);
+  // atomically replaces destination file
+  static void Replace(const TStr& SrcFNm, const TStr& DstFNm);
+  // forces file (or directory) to disk
+  static void Sync(const TStr& FNm);
   static TStr GetUniqueFNm(const TStr& FNm);
   static uint64 GetSize(const TStr& FNm);
   static uint64 GetCreateTm(const TStr& FNm);
@@ -42,11 +42,42 @@ public:
     virtual void Minus(const TVec<TItem>& MainV, 
 		const TVec<TItem>& JoinV, TVec<TItem>& ResV) const = 0;
 	virtual void Merge(TVec<TItem>& ItemV) const = 0;
+    // called on items of a key, when intersecting possibly only on the part
+    // of them which can match the other side
     virtual void Def(const TKey& Key, TVec<TItem>& MainV) const = 0;
 
     friend class TPt<TGixMerger<TKey, TItem> >;
 };
 
+/////////////////////////////////////////////////
+// General-Inverted-Index Galloping-Search
+//   Used when intersecting item vectors of very different lengths: instead
+//   of walking the longer vector, we jump through it with exponentially 
+//   growing steps and finish with a binary search.
+class TGixGallop {
+public:
+    // position of the first item at or after StartN which is not smaller 
+    // than Item, or length of the vector when there is no such item
+    template <class TItem>
+    static int GetNextItemN(const TVec<TItem>& ItemV, const TItem& Item, const int& StartN);
+};
+
+template <class TItem>
+int TGixGallop::GetNextItemN(const TVec<TItem>& ItemV, const TItem& Item, const int& StartN) {
+    const int Items = ItemV.Len();
+    if (StartN >= Items || !(ItemV[StartN] < Item)) { return StartN; }
+    // gallop until we overshoot, ItemV[PrevN] < Item holds all the time
+    int PrevN = StartN, Step = 1;
+    while (PrevN + Step < Items && ItemV[PrevN + Step] < Item) { PrevN += Step; Step *= 2; }
+    // binary search in (PrevN, PrevN + Step]
+    int LItemN = PrevN + 1, RItemN = TInt::GetMn(PrevN + Step, Items);
+    while (LItemN < RItemN) {
+        const int ItemN = (LItemN + RItemN) / 2;
+        if (ItemV[ItemN] < Item) { LItemN = ItemN + 1; } else { RItemN = ItemN; }
+    }
+    return LItemN;
+}
+
 /////////////////////////////////////////////////
 // General-Inverted-Index-Default-Merger
 template <class TKey, class TItem>
@@ -83,6 +114,175 @@ public:
     friend class TPt<TGixKeyStr<TKey> >;
 };
 
+/////////////////////////////////////////////////
+// General-Inverted-Index Item-Codec
+//   By default item sets are stored as plain vectors. Specializations 
+//   can provide a compact encoding, in which case item sets are kept 
+//   encoded on disk and in cache, and decoded only when needed.
+template <class TItem>
+class TGixItemCodec {
+public:
+    // are item sets kept encoded
+    static bool IsPacked() { return false; }
+    // encode merged (sorted and unique) items
+    static void Pack(const TVec<TItem>& ItemV, TMem& PackedMem) { Fail; }
+    // decode all items
+    static void Unpack(const TMem& PackedMem, TVec<TItem>& ItemV) { Fail; }
+    // decode at least all items equal to some item from sorted FilterItemV
+    static void UnpackFilter(const TMem& PackedMem, const TVec<TItem>& FilterItemV, 
+        TVec<TItem>& ItemV) { Fail; }
+    // number of encoded items
+    static int GetItems(const TMem& PackedMem) { Fail; return 0; }
+};
+
+/////////////////////////////////////////////////
+// General-Inverted-Index Item-Codec for (RecId, Fq) items
+//   Items are split into blocks. Each block has an entry in the skip 
+//   table with its first record id and offset, which allows decoding
+//   (or skipping) blocks independently. Inside a block record ids are 
+//   delta encoded and frequencies stored separately, all as varints.
+//   Layout: [Items][Blocks][Blocks x (FirstRecId, Offset)][block data]
+template <>
+class TGixItemCodec<TKeyDat<TUInt64, TInt> > {
+private:
+    typedef TKeyDat<TUInt64, TInt> TItem;
+    enum { 
+        // number of items in one block
+        BlockLen = 128,
+        // size of the header and of one skip table entry
+        HdSize = 2 * sizeof(int),
+        SkipSize = sizeof(uint64) + sizeof(int)
+    };
+
+    static void AddVarUInt64(TMem& Mem, uint64 Val) {
+        while (Val >= 0x80) { Mem += char((Val & 0x7F) | 0x80); Val >>= 7; }
+        Mem += char(Val); }
+    static uint64 GetVarUInt64(const uchar*& Bf) {
+        uint64 Val = 0; int Shift = 0;
+        while ((*Bf) & 0x80) { Val |= uint64((*Bf) & 0x7F) << Shift; Shift += 7; Bf++; }
+        Val |= uint64(*Bf) << Shift; Bf++; return Val; }
+    // zig-zag encoding, frequencies can be negative before merging
+    static uint64 GetZigZag(const int& Val) { 
+        return uint64((uint(Val) << 1) ^ uint(Val >> 31)); }
+    static int GetUnZigZag(const uint64& Val) { 
+        return int(uint(Val >> 1) ^ (0 - uint(Val & 1))); }
+    // last block at or after StartBlockN which starts at or before RecId,
+    // assumes block StartBlockN starts at or before RecId
+    static int GetBlockN(const TMem& PackedMem, const uint64& RecId, const int& StartBlockN);
+
+public:
+    static bool IsPacked() { return true; }
+    static void Pack(const TVec<TItem>& ItemV, TMem& PackedMem);
+    static void Unpack(const TMem& PackedMem, TVec<TItem>& ItemV);
+    // uses the skip table to decode only blocks holding items from FilterItemV
+    static void UnpackFilter(const TMem& PackedMem, const TVec<TItem>& FilterItemV, TVec<TItem>& ItemV);
+    static int GetItems(const TMem& PackedMem) { 
+        return PackedMem.Empty() ? 0 : *((const int*)PackedMem.GetBf()); }
+    static int GetBlocks(const TMem& PackedMem) { 
+        return PackedMem.Empty() ? 0 : *((const int*)(PackedMem.GetBf() + sizeof(int))); }
+    // first record id in the block
+    static uint64 GetBlockRecId(const TMem& PackedMem, const int& BlockN) {
+        return *((const uint64*)(PackedMem.GetBf() + HdSize + BlockN * SkipSize)); }
+    // decode one block and append its items to ItemV
+    static void UnpackBlock(const TMem& PackedMem, const int& BlockN, TVec<TItem>& ItemV);
+};
+
+inline void TGixItemCodec<TKeyDat<TUInt64, TInt> >::Pack(const TVec<TItem>& ItemV, TMem& PackedMem) {
+    const int Items = ItemV.Len();
+    const int Blocks = (Items + BlockLen - 1) / BlockLen;
+    const int DataOffset = HdSize + Blocks * SkipSize;
+    // worst case is ten bytes per record id and five per frequency
+    TMem Mem(DataOffset + Items * 15); Mem.GenZeros(DataOffset);
+    memcpy(Mem.GetBf(), &Items, sizeof(int)); 
+    memcpy(Mem.GetBf() + sizeof(int), &Blocks, sizeof(int));
+    for (int BlockN = 0; BlockN < Blocks; BlockN++) {
+        const int StartItemN = BlockN * BlockLen;
+        const int EndItemN = TInt::GetMn(StartItemN + int(BlockLen), Items);
+        // skip table entry
+        const uint64 FirstRecId = ItemV[StartItemN].Key;
+        const int Offset = Mem.Len() - DataOffset;
+        char* SkipBf = Mem.GetBf() + HdSize + BlockN * SkipSize;
+        memcpy(SkipBf, &FirstRecId, sizeof(uint64));
+        memcpy(SkipBf + sizeof(uint64), &Offset, sizeof(int));
+        // record id deltas
+        for (int ItemN = StartItemN + 1; ItemN < EndItemN; ItemN++) {
+            AddVarUInt64(Mem, ItemV[ItemN].Key - ItemV[ItemN - 1].Key);
+        }
+        // frequencies
+        for (int ItemN = StartItemN; ItemN < EndItemN; ItemN++) {
+            AddVarUInt64(Mem, GetZigZag(ItemV[ItemN].Dat));
+        }
+    }
+    // keep only the used part of the buffer
+    PackedMem = TMem(Mem.GetBf(), Mem.Len());
+}
+
+inline void TGixItemCodec<TKeyDat<TUInt64, TInt> >::UnpackBlock(
+        const TMem& PackedMem, const int& BlockN, TVec<TItem>& ItemV) {
+
+    const int Items = GetItems(PackedMem), Blocks = GetBlocks(PackedMem);
+    const int BlockItems = TInt::GetMn(int(BlockLen), Items - BlockN * BlockLen);
+    const char* SkipBf = PackedMem.GetBf() + HdSize + BlockN * SkipSize;
+    const int Offset = *((const int*)(SkipBf + sizeof(uint64)));
+    const uchar* Bf = (const uchar*)(PackedMem.GetBf() + HdSize + Blocks * SkipSize + Offset);
+    // record ids
+    const int StartItemN = ItemV.Len();
+    uint64 RecId = *((const uint64*)SkipBf);
+    ItemV.Add(TItem(RecId, 0));
+    for (int ItemN = 1; ItemN < BlockItems; ItemN++) {
+        RecId += GetVarUInt64(Bf); ItemV.Add(TItem(RecId, 0));
+    }
+    // frequencies
+    for (int ItemN = 0; ItemN < BlockItems; ItemN++) {
+        ItemV[StartItemN + ItemN].Dat = GetUnZigZag(GetVarUInt64(Bf));
+    }
+}
+
+inline void TGixItemCodec<TKeyDat<TUInt64, TInt> >::Unpack(const TMem& PackedMem, TVec<TItem>& ItemV) {
+    ItemV.Gen(GetItems(PackedMem), 0);
+    const int Blocks = GetBlocks(PackedMem);
+    for (int BlockN = 0; BlockN < Blocks; BlockN++) {
+        UnpackBlock(PackedMem, BlockN, ItemV);
+    }
+}
+
+inline int TGixItemCodec<TKeyDat<TUInt64, TInt> >::GetBlockN(
+        const TMem& PackedMem, const uint64& RecId, const int& StartBlockN) {
+
+    const int Blocks = GetBlocks(PackedMem);
+    // gallop through the skip table, block PrevN starts at or before RecId
+    int PrevN = StartBlockN, Step = 1;
+    while (PrevN + Step < Blocks && GetBlockRecId(PackedMem, PrevN + Step) <= RecId) { 
+        PrevN += Step; Step *= 2; }
+    // binary search for the last such block in [PrevN, PrevN + Step)
+    int LBlockN = PrevN, RBlockN = TInt::GetMn(PrevN + Step, Blocks) - 1;
+    while (LBlockN < RBlockN) {
+        const int BlockN = (LBlockN + RBlockN + 1) / 2;
+        if (GetBlockRecId(PackedMem, BlockN) <= RecId) { LBlockN = BlockN; } else { RBlockN = BlockN - 1; }
+    }
+    return LBlockN;
+}
+
+inline void TGixItemCodec<TKeyDat<TUInt64, TInt> >::UnpackFilter(const TMem& PackedMem, 
+        const TVec<TItem>& FilterItemV, TVec<TItem>& ItemV) {
+
+    ItemV.Clr();
+    const int Blocks = GetBlocks(PackedMem), FilterItems = FilterItemV.Len();
+    if (Blocks == 0) { return; }
+    // skip filter items before the first block
+    int FilterItemN = TGixGallop::GetNextItemN(FilterItemV, TItem(GetBlockRecId(PackedMem, 0), 0), 0);
+    int BlockN = 0;
+    while (FilterItemN < FilterItems) {
+        // block which can hold the next filter item
+        BlockN = GetBlockN(PackedMem, FilterItemV[FilterItemN].Key, BlockN);
+        UnpackBlock(PackedMem, BlockN, ItemV);
+        if (BlockN + 1 == Blocks) { break; }
+        // skip filter items covered by this block
+        BlockN++; FilterItemN = TGixGallop::GetNextItemN(FilterItemV, 
+            TItem(GetBlockRecId(PackedMem, BlockN), 0), FilterItemN);
+    }
+}
+
 /////////////////////////////////////////////////
 // General-Inverted-Index Item-Set
 template <class TKey, class TItem>
@@ -91,38 +291,59 @@ private:
     TCRef CRef;
     typedef TPt<TGixItemSet<TKey, TItem> > PGixItemSet;
     typedef TPt<TGixMerger<TKey, TItem> > PGixMerger;
+    typedef TGixItemCodec<TItem> TCodec;
+    // marks encoded item set on disk (plain vectors start with non-negative length)
+    enum { PackedTag = -2 };
 private:
     TKey ItemSetKey;
-    TVec<TItem> ItemV;
+    // items are decoded lazily from PackedMem on first access
+    mutable TVec<TItem> ItemV;
+    mutable TMem PackedMem;
+    mutable TBool PackedP;
     // for keeping the ItemV unique and sorted
     TBool MergedP;
-    PGixMerger Merger;
+    // changed since last saved
+    TBool ChangedP;
+    // merger is owned by the index, weak pointer keeps item sets from touching
+    // its reference count, so they can be created and dropped in parallel
+    TWPt<TGixMerger<TKey, TItem> > Merger;
+
+    // decode items, after this the item set can be edited
+    void Unpack() const;
+    // load items saved either encoded or as plain vector
+    void LoadItems(TSIn& SIn);
 
 public:
+    // merger must outlive the item set
     TGixItemSet(const TKey& _ItemSetKey, const PGixMerger& _Merger): 
-      ItemSetKey(_ItemSetKey), MergedP(true), Merger(_Merger) { }
+      ItemSetKey(_ItemSetKey), PackedP(false), MergedP(true), ChangedP(true), Merger(_Merger) { }
     static PGixItemSet New(const TKey& ItemSetKey, const PGixMerger& Merger) { 
         return new TGixItemSet(ItemSetKey, Merger); }
 
     TGixItemSet(TSIn& SIn, const PGixMerger& _Merger):
-		ItemSetKey(SIn), ItemV(SIn), MergedP(true), Merger(_Merger) { }
+		ItemSetKey(SIn), PackedP(false), MergedP(true), ChangedP(false), Merger(_Merger) { LoadItems(SIn); }
     static PGixItemSet Load(TSIn& SIn, const PGixMerger& Merger) { 
         return new TGixItemSet(SIn, Merger); }
     void Save(TSOut& SOut);
 
     // functions used by TCache
     int GetMemUsed() const {
-        return ItemSetKey.GetMemUsed() + ItemV.GetMemUsed() + sizeof(TBool) + sizeof(PGixMerger); }
+        return ItemSetKey.GetMemUsed() + ItemV.GetMemUsed() + PackedMem.GetMemUsed() + 
+            3 * sizeof(TBool) + sizeof(TWPt<TGixMerger<TKey, TItem> >); }
     void OnDelFromCache(const TBlobPt& BlobPt, void* Gix);
 
     // key & items
     const TKey& GetKey() const { return ItemSetKey; }
+    bool IsChanged() const { return ChangedP; }
 	int AddItem(const TItem& NewItem);
 	int AddItemV(const TVec<TItem>& NewItemV);
-    int GetItems() const { return ItemV.Len(); }
-    const TItem& GetItem(const int& ItemN) const { return ItemV[ItemN]; }
-    const TVec<TItem>& GetItemV() const { return ItemV; }
+    int GetItems() const { return PackedP ? TCodec::GetItems(PackedMem) : ItemV.Len(); }
+    const TItem& GetItem(const int& ItemN) const { Unpack(); return ItemV[ItemN]; }
+    const TVec<TItem>& GetItemV() const { Unpack(); return ItemV; }
     void GetItemV(TVec<TItem>& _ItemV);
+    // copy at least the items equal to some item from sorted FilterItemV,
+    // encoded item set decodes only the blocks which can hold them
+    void GetItemV(const TVec<TItem>& FilterItemV, TVec<TItem>& _ItemV);
 	int DelItem(const TItem& Item);
     int Clr();
     void Def();
@@ -130,56 +351,89 @@ public:
     friend class TPt<TGixItemSet>;
 };
 
+template <class TKey, class TItem>
+void TGixItemSet<TKey, TItem>::Unpack() const {
+    if (PackedP) {
+        TCodec::Unpack(PackedMem, ItemV);
+        PackedMem.Clr(); PackedP = false;
+    }
+}
+
+template <class TKey, class TItem>
+void TGixItemSet<TKey, TItem>::LoadItems(TSIn& SIn) {
+    if (!TCodec::IsPacked()) { ItemV.Load(SIn); return; }
+    TInt Tag(SIn);
+    if (Tag.Val == PackedTag) {
+        // encoded items, keep them as they are
+        PackedMem = TMem(SIn); PackedP = true;
+    } else {
+        // plain vector, tag was its capacity
+        TInt Items(SIn); ItemV.Gen(Items, 0);
+        for (int ItemN = 0; ItemN < Items; ItemN++) { ItemV.Add(TItem(SIn)); }
+    }
+}
+
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::Save(TSOut& SOut) { 
 	// make sure all is merged before saving
-	Def();
+	Def(); ChangedP = false;
 	// save item key and set
 	ItemSetKey.Save(SOut);
-	ItemV.Save(SOut);
+    if (!TCodec::IsPacked()) { ItemV.Save(SOut); return; }
+    TInt(PackedTag).Save(SOut);
+    if (PackedP) { 
+        PackedMem.Save(SOut);
+    } else {
+        TMem Mem; TCodec::Pack(ItemV, Mem); Mem.Save(SOut);
+    }
 }
 
-
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::OnDelFromCache(const TBlobPt& BlobPt, void* Gix) {
-    if (!((TGix<TKey, TItem>*)Gix)->IsReadOnly()) {
+    if (ChangedP && !((TGix<TKey, TItem>*)Gix)->IsReadOnly()) {
         ((TGix<TKey, TItem>*)Gix)->StoreItemSet(BlobPt);
     } 
 }
 
 template <class TKey, class TItem>
 int TGixItemSet<TKey, TItem>::AddItem(const TItem& NewItem) { 
-    const int OldSize = ItemV.GetMemUsed();
+    const int OldSize = GetMemUsed(); Unpack();
     ItemV.Add(NewItem);
-    MergedP = false;
-    return ItemV.GetMemUsed() - OldSize;
+    MergedP = false; ChangedP = true;
+    return GetMemUsed() - OldSize;
 }
 
 template <class TKey, class TItem>
 int TGixItemSet<TKey, TItem>::AddItemV(const TVec<TItem>& NewItemV) { 
-    const int OldSize = ItemV.GetMemUsed();
+    const int OldSize = GetMemUsed(); Unpack();
     ItemV.AddV(NewItemV);
-    MergedP = false;
-    return ItemV.GetMemUsed() - OldSize;
+    MergedP = false; ChangedP = true;
+    return GetMemUsed() - OldSize;
 }
 
 template <class TKey, class TItem>
 void TGixItemSet<TKey, TItem>::GetItemV(TVec<TItem>& _ItemV) { 
-    _ItemV = ItemV; 
+    // decode directly into the output, item set stays encoded
+    if (PackedP) { TCodec::Unpack(PackedMem, _ItemV); } else { _ItemV = ItemV; }
+}
+
+template <class TKey, class TItem>
+void TGixItemSet<TKey, TItem>::GetItemV(const TVec<TItem>& FilterItemV, TVec<TItem>& _ItemV) { 
+    if (PackedP) { TCodec::UnpackFilter(PackedMem, FilterItemV, _ItemV); } else { _ItemV = ItemV; }
 }
 
 template <class TKey, class TItem>
 int TGixItemSet<TKey, TItem>::DelItem(const TItem& Item) {
-    const int OldSize = ItemV.GetMemUsed();
-    ItemV.DelIfIn(Item);
-    return ItemV.GetMemUsed() - OldSize;
+    const int OldSize = GetMemUsed(); Unpack();
+    ItemV.DelIfIn(Item); ChangedP = true;
+    return GetMemUsed() - OldSize;
 }
 
 template <class TKey, class TItem>
 int TGixItemSet<TKey, TItem>::Clr() { 
-    const int OldSize = ItemV.GetMemUsed();
-    ItemV.Clr();
-    return ItemV.GetMemUsed() - OldSize;
+    const int OldSize = GetMemUsed(); 
+    ItemV.Clr(); PackedMem.Clr(); PackedP = false; ChangedP = true;
+    return GetMemUsed() - OldSize;
 }
 
 template <class TKey, class TItem>
@@ -190,8 +444,110 @@ void TGixItemSet<TKey, TItem>::Def() {
 	}
 }
 
+/////////////////////////////////////////////////
+// General-Inverted-Index Cache-Shard
+//   Part of the item-set cache with its own lock
+template <class TKey, class TItem>
+class TGixCacheShard {
+private:
+    TCRef CRef;
+    typedef TPt<TGixCacheShard<TKey, TItem> > PGixCacheShard;
+    typedef TPt<TGixItemSet<TKey, TItem> > PGixItemSet;
+public:
+    TCache<TBlobPt, PGixItemSet> ItemSetCache;
+    TSysCs Cs;
+
+    TGixCacheShard(const int64& CacheSize, void* Gix): ItemSetCache(CacheSize, 1000000, Gix) { }
+    static PGixCacheShard New(const int64& CacheSize, void* Gix) { 
+        return new TGixCacheShard(CacheSize, Gix); }
+
+    friend class TPt<TGixCacheShard<TKey, TItem> >;
+};
+
+/////////////////////////////////////////////////
+// General-Inverted-Index Key-Data
+//   Pointer to the item set and number of its items when it was last
+//   stored, so the size of a key is known without loading the item set.
+//   Number of items is -1 in key tables saved before it was kept.
+typedef TPair<TBlobPt, TInt> TGixKeyDat;
+
+/////////////////////////////////////////////////
+// General-Inverted-Index Flat-Key-Table
+//   Keys with pointers to their item sets, sorted by key and saved as one
+//   flat array, so a read-only index can map it instead of loading a hash
+//   table. Only for keys without pointers (e.g. pairs of numbers).
+template <class TKey>
+class TGixFlatKeys {
+private:
+    typedef TPair<TKey, TGixKeyDat> TKeyBlobPt;
+    // header: [FlatTag][sizeof(TKeyBlobPt)][number of keys]
+    enum { FlatTag = -3, HdLen = 3 * sizeof(int64) };
+
+    PFMMap KeyMMap;
+    const TKeyBlobPt* KeyBlobPtV;
+    int Keys;
+
+public:
+    TGixFlatKeys(): KeyBlobPtV(NULL), Keys(0) { }
+
+    // save keys from the hash table
+    static void Save(const TStr& FNm, const THash<TKey, TGixKeyDat>& KeyIdH);
+    // map keys from the file, returns false if file is missing or not compatible
+    bool Load(const TStr& FNm);
+    // are keys mapped
+    bool Empty() const { return KeyMMap.Empty(); }
+
+    int Len() const { return Keys; }
+    // position of key or -1 when not found
+    int GetKeyN(const TKey& Key) const;
+    const TKey& GetKey(const int& KeyN) const { return KeyBlobPtV[KeyN].Val1; }
+    const TGixKeyDat& GetKeyDat(const int& KeyN) const { return KeyBlobPtV[KeyN].Val2; }
+};
+
+template <class TKey>
+void TGixFlatKeys<TKey>::Save(const TStr& FNm, const THash<TKey, TGixKeyDat>& KeyIdH) {
+    TVec<TKeyBlobPt> KeyBlobPtV(KeyIdH.Len(), 0);
+    int KeyId = KeyIdH.FFirstKeyId();
+    while (KeyIdH.FNextKeyId(KeyId)) {
+        KeyBlobPtV.Add(TKeyBlobPt(KeyIdH.GetKey(KeyId), KeyIdH[KeyId])); }
+    KeyBlobPtV.Sort();
+    TFOut FOut(FNm);
+    FOut.Save(int64(FlatTag)); FOut.Save(int64(sizeof(TKeyBlobPt)));
+    FOut.Save(int64(KeyBlobPtV.Len()));
+    if (!KeyBlobPtV.Empty()) {
+        FOut.SaveBf(KeyBlobPtV.BegI(), KeyBlobPtV.Len() * sizeof(TKeyBlobPt)); }
+}
+
+template <class TKey>
+bool TGixFlatKeys<TKey>::Load(const TStr& FNm) {
+    if (!TFile::Exists(FNm)) { return false; }
+    PFMMap MMap = TFMMap::New(FNm);
+    if (MMap->Len() < uint64(HdLen)) { return false; }
+    const int64* HdV = (const int64*)MMap->GetBf();
+    if (HdV[0] != int64(FlatTag) || HdV[1] != int64(sizeof(TKeyBlobPt))) { return false; }
+    if (MMap->Len() != uint64(HdLen) + uint64(HdV[2]) * sizeof(TKeyBlobPt)) { return false; }
+    KeyMMap = MMap; Keys = int(HdV[2]);
+    KeyBlobPtV = (const TKeyBlobPt*)(KeyMMap->GetBf() + HdLen);
+    return true;
+}
+
+template <class TKey>
+int TGixFlatKeys<TKey>::GetKeyN(const TKey& Key) const {
+    int LKeyN = 0, RKeyN = Keys;
+    while (LKeyN < RKeyN) {
+        const int MidKeyN = LKeyN + (RKeyN - LKeyN) / 2;
+        if (KeyBlobPtV[MidKeyN].Val1 < Key) { LKeyN = MidKeyN + 1; } else { RKeyN = MidKeyN; }
+    }
+    return ((LKeyN < Keys) && (KeyBlobPtV[LKeyN].Val1 == Key)) ? LKeyN : -1;
+}
+
 /////////////////////////////////////////////////
 // General-Inverted-Index
+//   Can be used by many concurrent readers (GetItemV, GetItems, GetItemsEst
+//   and expression evaluation) or by a single writer. Exclusion between the
+//   writer and readers is left to the caller. Item-set cache is split into
+//   shards, each guarded by its own lock, and readers only copy the items
+//   out while holding the lock of the shard.
 template <class TKey, class TItem>
 class TGix {
 private:
@@ -201,18 +557,34 @@ private:
     typedef TPt<TGixMerger<TKey, TItem> > PGixMerger;
     typedef TGixDefMerger<TKey, TItem> _TGixDefMerger;
 	typedef TPt<TGixKeyStr<TKey> > PGixKeyStr;
+    typedef TGixCacheShard<TKey, TItem> _TGixCacheShard;
+    typedef TPt<_TGixCacheShard> PGixCacheShard;
+    // number of item-set cache shards
+    enum { CacheShards = 16 };
+    // marks key tables saved with item counts
+    enum { KeyTblTag = -4 };
 private:
     TFAccess Access;
     TStr GixFNm;
     TStr GixBlobFNm;
-    THash<TKey, TBlobPt> KeyIdH; 
-    mutable TCache<TBlobPt, PGixItemSet> ItemSetCache;
+    TStr GixKeyFNm;
+    THash<TKey, TGixKeyDat> KeyIdH; 
+    // read-only index maps keys from GixKeyFNm instead of loading KeyIdH
+    bool FlatKeysP;
+    TGixFlatKeys<TKey> FlatKeys;
+    TVec<PGixCacheShard> CacheShardV;
     PBlobBs ItemSetBlobBs;
 	PGixMerger Merger;
 
     int64 CacheResetThreshold;
     int64 NewCacheSizeInc;
     bool CacheFullP;
+    // once checkpointed, state is persisted only by checkpoints
+    bool CheckpointP;
+    // key table changes after GixFNm snapshot
+    TFDelta KeyDelta;
+    // keys with changed item set pointers since last checkpoint
+    THashSet<TKey> ChangedKeySet;
 
     // returns pointer to this object (used in cache call-backs)
     void* GetVoidThis() const { return (void*)this; }
@@ -222,32 +594,56 @@ private:
             "Index opened in Read-Only mode!"); }
     // get keyid of a given key and create it if does not exist
     TBlobPt AddKeyId(const TKey& Key);
-    TBlobPt GetKeyId(const TKey& Key) const;
+    TBlobPt GetKeyId(const TKey& Key) const { return GetKeyDat(Key).Val1; }
+    // item set pointer and number of items, empty pointer if key does not exist
+    TGixKeyDat GetKeyDat(const TKey& Key) const;
+    // save and load key tables, tables saved without item counts can be loaded too
+    static void SaveKeyIdH(const TStr& FNm, const THash<TKey, TGixKeyDat>& KeyIdH);
+    static void LoadKeyIdH(const TStr& FNm, THash<TKey, TGixKeyDat>& KeyIdH);
+    // cache shard responsible for the given item set
+    _TGixCacheShard& GetCacheShard(const TBlobPt& KeyId) const { 
+        return *CacheShardV[KeyId.GetPrimHashCd() % CacheShardV.Len()]; }
+    // load item set from the blob storage, safe to call from several readers
+    PGixItemSet LoadItemSet(const TBlobPt& KeyId) const;
+    // calls Read(ItemSet) with the item set's shard locked; item sets missing
+    // from the cache are loaded without the lock, so disk reads do not block the shard
+    template <class TRead> void ReadItemSet(const TBlobPt& KeyId, const TRead& Read) const;
 
 public:
     TGix(const TStr& Nm, const TStr& FPath = TStr(), 
 		const TFAccess& _Access = faRdOnly, const int64& CacheSize = 100000000, 
-		const PGixMerger& _Merger = _TGixDefMerger::New() );
+		const PGixMerger& _Merger = _TGixDefMerger::New(), const bool& _FlatKeysP = false);
     static PGix New(const TStr& Nm, const TStr& FPath = TStr(), 
 		const TFAccess& Access = faRdOnly, const int64& CacheSize = 100000000, 
-		const PGixMerger& Merger = _TGixDefMerger::New()) {
-            return new TGix(Nm, FPath, Access, CacheSize, Merger); }
+		const PGixMerger& Merger = _TGixDefMerger::New(), const bool& FlatKeysP = false) {
+            return new TGix(Nm, FPath, Access, CacheSize, Merger, FlatKeysP); }
 	
 	~TGix();
 
     // Gix properties
     bool IsReadOnly() const { return Access == faRdOnly; }
     TStr GetFPath() const { return GixFNm.GetFPath(); }
-	int64 GetMxCacheSize() const { return ItemSetCache.GetMxMemUsed(); }
+	int64 GetMxCacheSize() const;
 
     // do we have Key in the index?
-    bool IsKey(const TKey& Key) const { return KeyIdH.IsKey(Key); }
+    bool IsKey(const TKey& Key) const { 
+        return FlatKeys.Empty() ? KeyIdH.IsKey(Key) : (FlatKeys.GetKeyN(Key) != -1); }
     // number of keys in the index
-    int GetKeys() const { return KeyIdH.Len(); }
-    // sort keys
-    void SortKeys() { KeyIdH.SortByKey(true); }
-    // get item set for given key
+    int GetKeys() const { return FlatKeys.Empty() ? KeyIdH.Len() : FlatKeys.Len(); }
+    // sort keys (mapped keys are already sorted)
+    void SortKeys() { if (FlatKeys.Empty()) { KeyIdH.SortByKey(true); } }
+    // get item set for given key (not safe for concurrent use)
     PGixItemSet GetItemSet(const TKey& Key) const; 
+    // copy items for given key, returns false if key does not exist (thread safe)
+    bool GetItemV(const TKey& Key, TVec<TItem>& ItemV) const;
+    // copy at least the items for given key which are also in sorted FilterItemV,
+    // used for intersections (thread safe)
+    bool GetItemV(const TKey& Key, const TVec<TItem>& FilterItemV, TVec<TItem>& ItemV) const;
+    // number of items for given key (thread safe)
+    int GetItems(const TKey& Key) const;
+    // number of items for given key, from the cached item set or from the key
+    // table, item set is loaded only if the key table has no count (thread safe)
+    int GetItemsEst(const TKey& Key) const;
     // adding new item to the inverted index
     void AddItem(const TKey& Key, const TItem& Item);
     // adding new items to the inverted index
@@ -258,24 +654,32 @@ public:
     void Clr(const TKey& Key);
 
     // traversing keys
-    int FFirstKeyId() const { return KeyIdH.FFirstKeyId(); }
-    bool FNextKeyId(int& KeyId) const { return KeyIdH.FNextKeyId(KeyId); }
-    const TKey& GetKey(const int& KeyId) const { return KeyIdH.GetKey(KeyId); }
+    int FFirstKeyId() const { return FlatKeys.Empty() ? KeyIdH.FFirstKeyId() : -1; }
+    bool FNextKeyId(int& KeyId) const { 
+        return FlatKeys.Empty() ? KeyIdH.FNextKeyId(KeyId) : (++KeyId < FlatKeys.Len()); }
+    const TKey& GetKey(const int& KeyId) const { 
+        return FlatKeys.Empty() ? KeyIdH.GetKey(KeyId) : FlatKeys.GetKey(KeyId); }
 
     // merges another index with same key and item vocabulary
     void MergeIndex(const PGix& TmpGix);
 
     // get amount of memory currently used
     int64 GetMemUsed() const { 
-        return int64(sizeof(TFAccess) + GixFNm.GetMemUsed() + GixBlobFNm.GetMemUsed()) + 
-            int64(KeyIdH.GetMemUsed()) + int64(ItemSetCache.GetMemUsed()); }
+        return int64(sizeof(TFAccess) + GixFNm.GetMemUsed() + GixBlobFNm.GetMemUsed() + 
+            GixKeyFNm.GetMemUsed()) + 
+            int64(KeyIdH.GetMemUsed()) + GetCacheSize(); }
     int GetNewCacheSizeInc() const { return NewCacheSizeInc; }
-    int GetCacheSize() const { return ItemSetCache.GetMemUsed(); }
+    int64 GetCacheSize() const;
     bool IsCacheFull() const { return CacheFullP; }
     void RefreshMemUsed();
 
-    // for storing item sets from cache to blob
-    void StoreItemSet(const TBlobPt& KeyId);
+    // for storing item sets from cache to blob, returns new key id
+    TBlobPt StoreItemSet(const TBlobPt& KeyId);
+
+    // store cached item sets and add index state to the commit
+    void Checkpoint(TFCommit& Commit);
+    // called after the commit was applied
+    void OnCommit() { ItemSetBlobBs->OnCommit(); KeyDelta.OnCommit(); ChangedKeySet.Clr(); }
 
 	// print statistics for index keys
 	void SaveTxt(const TStr& FNm, const PGixKeyStr& KeyStr) const;
@@ -286,31 +690,65 @@ public:
 
 template <class TKey, class TItem>
 TBlobPt TGix<TKey, TItem>::AddKeyId(const TKey& Key) { 
-    if (IsKey(Key)) { return KeyIdH.GetDat(Key); }
+    TBlobPt KeyId = GetKeyId(Key);
+    if (!KeyId.Empty()) { return KeyId; }
     // we don't have this key, create an empty item set and return pointer to it
     AssertReadOnly(); // check if we are allowed to write
     PGixItemSet ItemSet = TGixItemSet<TKey, TItem>::New(Key, Merger);
     TMOut MOut; ItemSet->Save(MOut);
-    TBlobPt KeyId = ItemSetBlobBs->PutBlob(MOut.GetSIn());
-    KeyIdH.AddDat(Key, KeyId); // remember the new key and its Id
+    KeyId = ItemSetBlobBs->PutBlob(MOut.GetSIn());
+    KeyIdH.AddDat(Key, TGixKeyDat(KeyId, 0)); // remember the new key and its Id
+    if (CheckpointP) { ChangedKeySet.AddKey(Key); }
     return KeyId;
 }
 
 template <class TKey, class TItem>
-TBlobPt TGix<TKey, TItem>::GetKeyId(const TKey& Key) const { 
-    if (IsKey(Key)) { return KeyIdH.GetDat(Key); }
+TGixKeyDat TGix<TKey, TItem>::GetKeyDat(const TKey& Key) const { 
+    if (!FlatKeys.Empty()) {
+        const int KeyN = FlatKeys.GetKeyN(Key);
+        return (KeyN == -1) ? TGixKeyDat() : FlatKeys.GetKeyDat(KeyN);
+    }
+    const int KeyId = KeyIdH.GetKeyId(Key);
+    if (KeyId != -1) { return KeyIdH[KeyId]; }
     // we don't have this key, return empty pointer
-    return TBlobPt();
+    return TGixKeyDat();
+}
+
+template <class TKey, class TItem>
+void TGix<TKey, TItem>::SaveKeyIdH(const TStr& FNm, const THash<TKey, TGixKeyDat>& KeyIdH) {
+    TFOut FOut(FNm); TInt(KeyTblTag).Save(FOut); KeyIdH.Save(FOut);
+}
+
+template <class TKey, class TItem>
+void TGix<TKey, TItem>::LoadKeyIdH(const TStr& FNm, THash<TKey, TGixKeyDat>& KeyIdH) {
+    {
+        TFIn FIn(FNm);
+        if (TInt(FIn) == KeyTblTag) { KeyIdH.Load(FIn); return; }
+    }
+    // hash tables start with non-negative length, this one has no item counts
+    TFIn FIn(FNm); THash<TKey, TBlobPt> OldKeyIdH(FIn);
+    KeyIdH.Gen(OldKeyIdH.Len());
+    int KeyId = OldKeyIdH.FFirstKeyId();
+    while (OldKeyIdH.FNextKeyId(KeyId)) {
+        KeyIdH.AddDat(OldKeyIdH.GetKey(KeyId), TGixKeyDat(OldKeyIdH[KeyId], -1)); }
 }
 
 template <class TKey, class TItem>
 TGix<TKey, TItem>::TGix(const TStr& Nm, const TStr& FPath, const TFAccess& _Access, 
-  const int64& CacheSize, const TPt<TGixMerger<TKey, TItem> >& _Merger): Access(_Access),
-  ItemSetCache(CacheSize, 1000000, GetVoidThis()), Merger(_Merger) {
+  const int64& CacheSize, const TPt<TGixMerger<TKey, TItem> >& _Merger, 
+  const bool& _FlatKeysP): Access(_Access), FlatKeysP(_FlatKeysP), Merger(_Merger),
+  CheckpointP(false) {
+
+    // split cache into shards
+    for (int ShardN = 0; ShardN < CacheShards; ShardN++) {
+        CacheShardV.Add(_TGixCacheShard::New(CacheSize / CacheShards, GetVoidThis()));
+    }
 
     // filenames of the GIX datastore
     GixFNm = TStr::GetNrFPath(FPath) + Nm.GetFBase() + ".Gix";
     GixBlobFNm = TStr::GetNrFPath(FPath) + Nm.GetFBase() + ".GixDat";
+    GixKeyFNm = TStr::GetNrFPath(FPath) + Nm.GetFBase() + ".GixKey";
+    KeyDelta = TFDelta(GixFNm);
 
     if (Access == faCreate) {
         // creating a new Gix
@@ -318,8 +756,21 @@ TGix<TKey, TItem>::TGix(const TStr& Nm, const TStr& FPath, const TFAccess& _Acce
     } else {
         // loading an old Gix and getting it ready for search and update
         EAssert((Access == faUpdate) || (Access == faRdOnly) || (Access == faRestore));
-        // load Gix from GixFNm
-        TFIn FIn(GixFNm); KeyIdH.Load(FIn);
+        // map keys when read-only and key table is not older than GixFNm
+        // and its deltas, otherwise load Gix from GixFNm and apply deltas
+        const bool MapKeysP = FlatKeysP && (Access == faRdOnly) && TFile::Exists(GixKeyFNm) &&
+            (TFile::GetLastWriteTm(GixKeyFNm) >= TFile::GetLastWriteTm(GixFNm)) &&
+            (KeyDelta.GetDeltas() == 0);
+        if (!MapKeysP || !FlatKeys.Load(GixKeyFNm)) {
+            LoadKeyIdH(GixFNm, KeyIdH);
+            for (int DeltaN = 0; DeltaN < KeyDelta.GetDeltas(); DeltaN++) {
+                THash<TKey, TGixKeyDat> DeltaKeyIdH; LoadKeyIdH(KeyDelta.GetDeltaFNm(DeltaN), DeltaKeyIdH);
+                int KeyId = DeltaKeyIdH.FFirstKeyId();
+                while (DeltaKeyIdH.FNextKeyId(KeyId)) {
+                    KeyIdH.AddDat(DeltaKeyIdH.GetKey(KeyId), DeltaKeyIdH[KeyId]); }
+                KeyDelta.AddDeltaItems(DeltaKeyIdH.Len());
+            }
+        }
         // load ItemSets from GixBlobFNm
         ItemSetBlobBs = TMBlobBs::New(GixBlobFNm, Access);
     }
@@ -330,30 +781,116 @@ TGix<TKey, TItem>::TGix(const TStr& Nm, const TStr& FPath, const TFAccess& _Acce
 
 template <class TKey, class TItem>
 TGix<TKey, TItem>::~TGix() {
-    if ((Access == faCreate) || (Access == faUpdate)) {
+    if (((Access == faCreate) || (Access == faUpdate)) && !CheckpointP) {
         // flush all the latest changes in cache to the disk
-        ItemSetCache.Flush();
+        for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+            CacheShardV[ShardN]->ItemSetCache.Flush(); }
         // save the rest to GixFNm
-        TFOut FOut(GixFNm); KeyIdH.Save(FOut);
+        SaveKeyIdH(GixFNm, KeyIdH);
+        // and keys for read-only mapping
+        if (FlatKeysP) { TGixFlatKeys<TKey>::Save(GixKeyFNm, KeyIdH); }
+        // deltas are included in the new snapshot
+        KeyDelta.DelDeltas();
     }
 }
 
+template <class TKey, class TItem>
+TPt<TGixItemSet<TKey, TItem> > TGix<TKey, TItem>::LoadItemSet(const TBlobPt& KeyId) const {
+    // positional read, blob storage keeps no shared file position for it
+    PSIn ItemSetSIn = ItemSetBlobBs->GetBlobAt(KeyId);
+    return TGixItemSet<TKey, TItem>::Load(*ItemSetSIn, Merger);
+}
+
+template <class TKey, class TItem>
+template <class TRead>
+void TGix<TKey, TItem>::ReadItemSet(const TBlobPt& KeyId, const TRead& Read) const {
+    _TGixCacheShard& CacheShard = GetCacheShard(KeyId);
+    {
+        TSysCsLock Lock(CacheShard.Cs);
+        PGixItemSet ItemSet;
+        if (CacheShard.ItemSetCache.Get(KeyId, ItemSet)) {
+            // bring the itemset to the top of the cache
+            CacheShard.ItemSetCache.Put(KeyId, ItemSet);
+            // merge pending changes, so readers see sorted and unique items
+            ItemSet->Def(); Read(ItemSet);
+            return;
+        }
+    }
+    // have to load it from the hard drive...
+    PGixItemSet LoadedItemSet = LoadItemSet(KeyId);
+    TSysCsLock Lock(CacheShard.Cs);
+    PGixItemSet ItemSet;
+    if (CacheShard.ItemSetCache.Get(KeyId, ItemSet)) {
+        // another reader loaded it in the meantime
+        CacheShard.ItemSetCache.Put(KeyId, ItemSet);
+    } else {
+        ItemSet = LoadedItemSet;
+        // making space can store dirty item sets, which is left to the writer
+        if (IsReadOnly() || !CacheShard.ItemSetCache.IsFull(KeyId, ItemSet)) {
+            CacheShard.ItemSetCache.Put(KeyId, ItemSet);
+        }
+    }
+    // reference counts of cached item sets only change under the lock
+    LoadedItemSet.Clr();
+    ItemSet->Def(); Read(ItemSet);
+}
+
 template <class TKey, class TItem>
 TPt<TGixItemSet<TKey, TItem> > TGix<TKey, TItem>::GetItemSet(const TKey& Key) const {
     PGixItemSet ItemSet;
     // load the item set, if possible from cache
     TBlobPt KeyId = GetKeyId(Key);
     if (KeyId.Empty()) { return NULL; }
+    TCache<TBlobPt, PGixItemSet>& ItemSetCache = GetCacheShard(KeyId).ItemSetCache;
     if (!ItemSetCache.Get(KeyId, ItemSet)) {
         // have to load it from the hard drive...
-        PSIn ItemSetSIn = ItemSetBlobBs->GetBlob(KeyId);
-        ItemSet = TGixItemSet<TKey, TItem>::Load(*ItemSetSIn, Merger);
+        ItemSet = LoadItemSet(KeyId);
     }
     // bring the itemset to the top of the cache
     ItemSetCache.Put(KeyId, ItemSet);
     return ItemSet;    
 }
 
+template <class TKey, class TItem>
+bool TGix<TKey, TItem>::GetItemV(const TKey& Key, TVec<TItem>& ItemV) const {
+    TBlobPt KeyId = GetKeyId(Key);
+    if (KeyId.Empty()) { return false; }
+    // item set is only touched while its shard is locked
+    ReadItemSet(KeyId, [&](const PGixItemSet& ItemSet) { ItemSet->GetItemV(ItemV); });
+    return true;
+}
+
+template <class TKey, class TItem>
+bool TGix<TKey, TItem>::GetItemV(const TKey& Key, const TVec<TItem>& FilterItemV, TVec<TItem>& ItemV) const {
+    TBlobPt KeyId = GetKeyId(Key);
+    if (KeyId.Empty()) { return false; }
+    ReadItemSet(KeyId, [&](const PGixItemSet& ItemSet) { ItemSet->GetItemV(FilterItemV, ItemV); });
+    return true;
+}
+
+template <class TKey, class TItem>
+int TGix<TKey, TItem>::GetItems(const TKey& Key) const {
+    TBlobPt KeyId = GetKeyId(Key);
+    if (KeyId.Empty()) { return 0; }
+    int Items = 0;
+    ReadItemSet(KeyId, [&](const PGixItemSet& ItemSet) { Items = ItemSet->GetItems(); });
+    return Items;
+}
+
+template <class TKey, class TItem>
+int TGix<TKey, TItem>::GetItemsEst(const TKey& Key) const {
+    const TGixKeyDat KeyDat = GetKeyDat(Key);
+    if (KeyDat.Val1.Empty()) { return 0; }
+    // key table from before item counts were kept
+    if (KeyDat.Val2 < 0) { return GetItems(Key); }
+    // cached item set can have changes not stored yet
+    _TGixCacheShard& CacheShard = GetCacheShard(KeyDat.Val1);
+    TSysCsLock Lock(CacheShard.Cs);
+    PGixItemSet ItemSet;
+    if (CacheShard.ItemSetCache.Get(KeyDat.Val1, ItemSet)) { return ItemSet->GetItems(); }
+    return KeyDat.Val2;
+}
+
 template <class TKey, class TItem>
 void TGix<TKey, TItem>::AddItem(const TKey& Key, const TItem& Item) {
     AssertReadOnly(); // check if we are allowed to write
@@ -416,34 +953,101 @@ void TGix<TKey, TItem>::MergeIndex(const TPt<TGix<TKey, TItem> >& TmpGix) {
     }
 }
 
+template <class TKey, class TItem>
+int64 TGix<TKey, TItem>::GetMxCacheSize() const {
+    int64 MxCacheSize = 0;
+    for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+        MxCacheSize += CacheShardV[ShardN]->ItemSetCache.GetMxMemUsed(); }
+    return MxCacheSize;
+}
+
+template <class TKey, class TItem>
+int64 TGix<TKey, TItem>::GetCacheSize() const {
+    int64 CacheSize = 0;
+    for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+        CacheSize += CacheShardV[ShardN]->ItemSetCache.GetMemUsed(); }
+    return CacheSize;
+}
+
 template <class TKey, class TItem>
 void TGix<TKey, TItem>::RefreshMemUsed() {
     // check if we have to drop anything from the cache
     if (NewCacheSizeInc > CacheResetThreshold) {
         printf("Cache clean-up [%s] ... ", 
             TUInt64::GetMegaStr(NewCacheSizeInc).CStr());
-        // pack all the item sets
-        TBlobPt BlobPt; PGixItemSet ItemSet;
-        void* KeyDatP = ItemSetCache.FFirstKeyDat();
-        while (ItemSetCache.FNextKeyDat(KeyDatP, BlobPt, ItemSet)) { ItemSet->Def(); }
-        // clean-up cache
-        CacheFullP = ItemSetCache.RefreshMemUsed(); 
+        CacheFullP = false;
+        for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+            TCache<TBlobPt, PGixItemSet>& ItemSetCache = CacheShardV[ShardN]->ItemSetCache;
+            // pack all the item sets
+            TBlobPt BlobPt; PGixItemSet ItemSet;
+            void* KeyDatP = ItemSetCache.FFirstKeyDat();
+            while (ItemSetCache.FNextKeyDat(KeyDatP, BlobPt, ItemSet)) { ItemSet->Def(); }
+            // clean-up cache
+            if (ItemSetCache.RefreshMemUsed()) { CacheFullP = true; }
+        }
         NewCacheSizeInc = 0; 
-        const uint64 NewSize = ItemSetCache.GetMemUsed();
+        const uint64 NewSize = GetCacheSize();
         printf("Done [%s]\n", TUInt64::GetMegaStr(NewSize).CStr());
     }
 }
 
 template <class TKey, class TItem>
-void TGix<TKey, TItem>::StoreItemSet(const TBlobPt& KeyId) {
+TBlobPt TGix<TKey, TItem>::StoreItemSet(const TBlobPt& KeyId) {
     AssertReadOnly(); // check if we are allowed to write
     // get the pointer to the item set
-    PGixItemSet ItemSet; EAssert(ItemSetCache.Get(KeyId, ItemSet));
+    PGixItemSet ItemSet; EAssert(GetCacheShard(KeyId).ItemSetCache.Get(KeyId, ItemSet));
     // store the current version to the blob
     TMOut MOut; ItemSet->Save(MOut);
     TBlobPt NewKeyId = ItemSetBlobBs->PutBlob(KeyId, MOut.GetSIn());
-    // and update the KeyId in the hash table
-    KeyIdH.GetDat(ItemSet->GetKey()) = NewKeyId;
+    // and update the KeyId and number of items in the hash table
+    TGixKeyDat& KeyDat = KeyIdH.GetDat(ItemSet->GetKey());
+    const TGixKeyDat NewKeyDat(NewKeyId, ItemSet->GetItems());
+    if (CheckpointP && !(KeyDat == NewKeyDat)) { ChangedKeySet.AddKey(ItemSet->GetKey()); }
+    KeyDat = NewKeyDat;
+    return NewKeyId;
+}
+
+template <class TKey, class TItem>
+void TGix<TKey, TItem>::Checkpoint(TFCommit& Commit) {
+    AssertReadOnly(); // check if we are allowed to write
+    // store changed cached item sets, they stay in the cache
+    TBlobPtV OldKeyIdV; TVec<TPair<TBlobPt, PGixItemSet> > MovedV;
+    for (int ShardN = 0; ShardN < CacheShardV.Len(); ShardN++) {
+        TCache<TBlobPt, PGixItemSet>& ItemSetCache = CacheShardV[ShardN]->ItemSetCache;
+        TBlobPtV KeyIdV; TBlobPt KeyId; PGixItemSet ItemSet;
+        void* KeyDatP = ItemSetCache.FFirstKeyDat();
+        while (ItemSetCache.FNextKeyDat(KeyDatP, KeyId, ItemSet)) { 
+            if (ItemSet->IsChanged()) { KeyIdV.Add(KeyId); } }
+        for (int KeyIdN = 0; KeyIdN < KeyIdV.Len(); KeyIdN++) {
+            const TBlobPt NewKeyId = StoreItemSet(KeyIdV[KeyIdN]);
+            if (NewKeyId == KeyIdV[KeyIdN]) { continue; }
+            ItemSetCache.Get(KeyIdV[KeyIdN], ItemSet);
+            OldKeyIdV.Add(KeyIdV[KeyIdN]); MovedV.Add(TPair<TBlobPt, PGixItemSet>(NewKeyId, ItemSet));
+        }
+    }
+    // item sets stored to a new place are cached under their new key id; old
+    // ids go first, as a freed blob can already be taken by another item set
+    for (int MovedN = 0; MovedN < OldKeyIdV.Len(); MovedN++) {
+        GetCacheShard(OldKeyIdV[MovedN]).ItemSetCache.Del(OldKeyIdV[MovedN], false); }
+    for (int MovedN = 0; MovedN < MovedV.Len(); MovedN++) {
+        const TBlobPt& NewKeyId = MovedV[MovedN].Val1;
+        GetCacheShard(NewKeyId).ItemSetCache.Put(NewKeyId, MovedV[MovedN].Val2);
+    }
+    // key table, changes are tracked only after the first checkpoint
+    if (!CheckpointP || KeyDelta.IsSnapshotDue(KeyIdH.Len())) {
+        SaveKeyIdH(KeyDelta.AddSnapshot(Commit), KeyIdH);
+        if (FlatKeysP) { TGixFlatKeys<TKey>::Save(Commit.AddFNm(GixKeyFNm), KeyIdH); }
+    } else if (!ChangedKeySet.Empty()) {
+        THash<TKey, TGixKeyDat> DeltaKeyIdH(ChangedKeySet.Len());
+        int KeyId = ChangedKeySet.FFirstKeyId();
+        while (ChangedKeySet.FNextKeyId(KeyId)) {
+            const TKey& Key = ChangedKeySet.GetKey(KeyId);
+            DeltaKeyIdH.AddDat(Key, KeyIdH.GetDat(Key));
+        }
+        SaveKeyIdH(KeyDelta.AddDelta(Commit, DeltaKeyIdH.Len()), DeltaKeyIdH);
+    }
+    ItemSetBlobBs->Checkpoint(Commit);
+    CheckpointP = true;
 }
 
 template <class TKey, class TItem>
@@ -470,7 +1074,7 @@ void TGix<TKey, TItem>::SaveTxt(const TStr& FNm, const PGixKeyStr& KeyStr) const
 
 /////////////////////////////////////////////////
 // General-Inverted-Index Expression-Item
-typedef enum { getUndef, getEmpty, getOr, getAnd, getNot, getKey } TGixExpType;
+typedef enum { getUndef, getEmpty, getOr, getAnd, getNot, getKey, getItemV } TGixExpType;
 
 template <class TKey, class TItem>
 class TGixExpItem {
@@ -485,15 +1089,18 @@ private:
     PGixExpItem LeftExpItem;
     PGixExpItem RightExpItem;
     TKey Key;
+    // precomputed items (e.g. result of a range scan outside the index)
+    TVec<TItem> ItemV;
 
     TGixExpItem(const TGixExpType& _ExpType, const PGixExpItem& _LeftExpItem, 
       const PGixExpItem& _RightExpItem): ExpType(_ExpType), 
         LeftExpItem(_LeftExpItem), RightExpItem(_RightExpItem) { }
     TGixExpItem(const TKey& _Key): ExpType(getKey), Key(_Key) { }
+    TGixExpItem(const TVec<TItem>& _ItemV): ExpType(getItemV), ItemV(_ItemV) { }
     TGixExpItem(): ExpType(getEmpty) { }
 	TGixExpItem(const TGixExpItem& ExpItem): ExpType(ExpItem.ExpType),
 		LeftExpItem(ExpItem.LeftExpItem), RightExpItem(ExpItem.RightExpItem),
-		Key(ExpItem.Key) { }
+		Key(ExpItem.Key), ItemV(ExpItem.ItemV) { }
 
 	void PutAnd(const PGixExpItem& _LeftExpItem, const PGixExpItem& _RightExpItem);
 	void PutOr(const PGixExpItem& _LeftExpItem, const PGixExpItem& _RightExpItem);
@@ -507,6 +1114,9 @@ public:
         return new TGixExpItem(getNot, NULL, RightExpItem); }
     static PGixExpItem NewItem(const TKey& Key) { 
         return new TGixExpItem(Key); }
+    // items must be sorted and merged
+    static PGixExpItem NewItemV(const TVec<TItem>& ItemV) { 
+        return new TGixExpItem(ItemV); }
     static PGixExpItem NewEmpty() { 
         return new TGixExpItem(); }
 
@@ -515,11 +1125,16 @@ public:
 	static PGixExpItem NewOrV(const TVec<PGixExpItem>& ExpItemV);
 	static PGixExpItem NewAndV(const TVec<TKey>& KeyV);
 	static PGixExpItem NewOrV(const TVec<TKey>& KeyV);
+	// AND with children ordered by estimated number of items, so that
+	// intersections start with the shortest item sets
+	static PGixExpItem NewAndV(const PGix& Gix, const TVec<PGixExpItem>& ExpItemV);
 
     bool IsEmpty() const { return (ExpType == getEmpty); }
     TGixExpType GetExpType() const { return ExpType; }
 	TKey GetKey() const { return Key; }
 	PGixExpItem Clone() const { return new TGixExpItem(*this); }
+	// upper bound on the number of items returned by evaluating the expression
+	int GetItemsEst(const PGix& Gix) const;
     bool Eval(const PGix& Gix, TVec<TItem>& ResItemV, 
 		const TPt<TGixMerger<TKey, TItem> >& Merger = _TGixDefMerger::New());
 
@@ -618,6 +1233,44 @@ TPt<TGixExpItem<TKey, TItem> > TGixExpItem<TKey, TItem>::NewOrV(const TVec<TKey>
 	return NewOrV(ExpItemV);
 }
 
+template <class TKey, class TItem>
+TPt<TGixExpItem<TKey, TItem> > TGixExpItem<TKey, TItem>::NewAndV(const TPt<TGix<TKey, TItem> >& Gix,
+		const TVec<TPt<TGixExpItem<TKey, TItem> > >& ExpItemV) {
+
+	// return empty item if no key is given
+	if (ExpItemV.Empty()) { return TGixExpItem<TKey, TItem>::NewEmpty(); }
+	// sort children by their estimated size
+	TIntPrV EstItemNV(ExpItemV.Len(), 0);
+	for (int ExpItemN = 0; ExpItemN < ExpItemV.Len(); ExpItemN++) {
+		EstItemNV.Add(TIntPr(ExpItemV[ExpItemN]->GetItemsEst(Gix), ExpItemN));
+	}
+	EstItemNV.Sort();
+	// chain them so the result of the smallest intersection is carried on
+	TPt<TGixExpItem<TKey, TItem> > TopExpItem = ExpItemV[EstItemNV[0].Val2];
+	for (int EstItemN = 1; EstItemN < EstItemNV.Len(); EstItemN++) {
+		TopExpItem = NewAnd(TopExpItem, ExpItemV[EstItemNV[EstItemN].Val2]);
+	}
+	return TopExpItem;
+}
+
+template <class TKey, class TItem>
+int TGixExpItem<TKey, TItem>::GetItemsEst(const TPt<TGix<TKey, TItem> >& Gix) const {
+	if (ExpType == getOr) {
+		const int64 Items = int64(LeftExpItem->GetItemsEst(Gix)) + int64(RightExpItem->GetItemsEst(Gix));
+		return (Items < int64(TInt::Mx)) ? int(Items) : TInt::Mx;
+	} else if (ExpType == getAnd) {
+		return TInt::GetMn(LeftExpItem->GetItemsEst(Gix), RightExpItem->GetItemsEst(Gix));
+	} else if (ExpType == getKey) {
+		return Gix->GetItemsEst(Key);
+	} else if (ExpType == getItemV) {
+		return ItemV.Len();
+	} else if (ExpType == getEmpty) {
+		return 0;
+	}
+	// negations can return almost anything
+	return TInt::Mx;
+}
+
 template <class TKey, class TItem>
 bool TGixExpItem<TKey, TItem>::Eval(const TPt<TGix<TKey, TItem> >& Gix, 
         TVec<TItem>& ResItemV, const TPt<TGixMerger<TKey, TItem> >& Merger) {
@@ -644,6 +1297,16 @@ bool TGixExpItem<TKey, TItem>::Eval(const TPt<TGix<TKey, TItem> >& Gix,
         EAssert(!LeftExpItem.Empty() && !RightExpItem.Empty());
         TVec<TItem> RightItemV;
         const bool NotLeft = LeftExpItem->Eval(Gix, ResItemV, Merger);
+        // nothing to intersect with, no need to evaluate the right side
+        if (!NotLeft && ResItemV.Empty()) { return false; }
+        if (!NotLeft && RightExpItem->ExpType == getKey) {
+            // read only the parts of the right item set which can intersect
+            if (Gix->GetItemV(RightExpItem->Key, ResItemV, RightItemV)) {
+                Merger->Def(RightExpItem->Key, RightItemV);
+            }
+            Merger->Intrs(ResItemV, RightItemV);
+            return false;
+        }
         const bool NotRight = RightExpItem->Eval(Gix, RightItemV, Merger);
         if (NotLeft && NotRight) { 
             Merger->Union(ResItemV, RightItemV);
@@ -657,13 +1320,13 @@ bool TGixExpItem<TKey, TItem>::Eval(const TPt<TGix<TKey, TItem> >& Gix,
         }
         return (NotLeft && NotRight);
     } else if (ExpType == getKey) {
-        PGixItemSet ItemSet = Gix->GetItemSet(Key);
-        if (!ItemSet.Empty()) { 
-            ItemSet->Def();
-            ItemSet->GetItemV(ResItemV); 
-            Merger->Def(ItemSet->GetKey(), ResItemV);
+        if (Gix->GetItemV(Key, ResItemV)) { 
+            Merger->Def(Key, ResItemV);
         }
         return false;
+    } else if (ExpType == getItemV) {
+        ResItemV = ItemV;
+        return false;
     } else if (ExpType == getNot) {
         return !RightExpItem->Eval(Gix, ResItemV, Merger);
     } else if (ExpType == getEmpty) {
@@ -1010,6 +1010,9 @@ public:
   int64 GetMemUsed() const;
   int64 GetMxMemUsed() const { return MxMemUsed; }
   bool RefreshMemUsed();
+  // true when adding new Key would push something out of the cache
+  bool IsFull(const TKey& Key, const TDat& Dat) const {
+    return CurMemUsed+int64(Key.GetMemUsed()+Dat->GetMemUsed())>MxMemUsed;}
 
   void Put(const TKey& Key, const TDat& Dat);
   bool Get(const TKey& Key, TDat& Dat);
@@ -1138,6 +1141,179 @@ bool TCache<TKey, TDat, THashFunc>::FNextKeyDat(void*& KeyDatP, TKey& Key, TDat&
   }
 }
 
+/////////////////////////////////////////////////
+// 2Q-Cache
+//   Cache with scan-resistant 2Q replacement. New keys enter a FIFO queue
+//   (In), which holds about a quarter of the memory. Keys dropped from it
+//   are remembered without data in a ghost queue (Out). Only keys which are
+//   put again while remembered in Out enter the main LRU queue (Main), so a
+//   single pass over many keys cycles through In and does not push the
+//   working set out of Main. Memory of each entry is remembered when put
+//   and refreshed by UpdateMemUsed, so usage is tracked without walking
+//   the cache.
+template <class TKey, class TDat, class THashFunc = TDefaultHashFunc<TKey> >
+class TQCache{
+private:
+  typedef TLst<TKey> TKeyL; typedef TLstNd<TKey>* TKeyLN;
+  class TKeyDat{
+  public:
+    TKeyLN KeyLN; bool MainP; int64 MemUsed; TDat Dat;
+    TKeyDat(): KeyLN(NULL), MainP(false), MemUsed(0){}
+  };
+  int64 MxMemUsed;
+  int64 CurMemUsed;
+  int64 InMemUsed;
+  THash<TKey, TKeyDat, THashFunc> KeyDatH;
+  TKeyL InKeyL, MainKeyL;
+  THash<TKey, TKeyLN, THashFunc> OutKeyH;
+  TKeyL OutKeyL;
+  void* RefToBs;
+  int64 Hits, Misses, Evictions;
+  int64 GetKeyDatMem(const TKey& Key, const TDat& Dat) const {
+    return int64(Key.GetMemUsed()+Dat->GetMemUsed());}
+  void AddOutKey(const TKey& Key);
+  bool Evict(const int& KeepKeyId);
+  void Purge(const int64& MemToPurge, const int& KeepKeyId=-1);
+  UndefCopyAssign(TQCache);
+public:
+  TQCache(const int64& _MxMemUsed, void* _RefToBs):
+    MxMemUsed(_MxMemUsed), CurMemUsed(0), InMemUsed(0), RefToBs(_RefToBs),
+    Hits(0), Misses(0), Evictions(0){}
+
+  int64 GetMemUsed() const {return CurMemUsed;}
+  int64 GetMxMemUsed() const {return MxMemUsed;}
+  int GetKeys() const {return KeyDatH.Len();}
+  // true when adding new Key would push something out of the cache
+  bool IsFull(const TKey& Key, const TDat& Dat) const {
+    return CurMemUsed+GetKeyDatMem(Key, Dat)>MxMemUsed;}
+  // counters of Get calls and of dropped entries
+  int64 GetHits() const {return Hits;}
+  int64 GetMisses() const {return Misses;}
+  int64 GetEvictions() const {return Evictions;}
+
+  void Put(const TKey& Key, const TDat& Dat);
+  bool Get(const TKey& Key, TDat& Dat);
+  // refresh remembered memory of Key after its data changed
+  void UpdateMemUsed(const TKey& Key);
+  void Del(const TKey& Key, const bool& DoEventCall=true);
+  void Flush();
+  void FlushAndClr();
+};
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::AddOutKey(const TKey& Key){
+  if (OutKeyH.IsKey(Key)){return;}
+  OutKeyH.AddDat(Key, OutKeyL.AddFront(Key));
+  // remember at most as many keys as are in the cache
+  while (OutKeyL.Len()>TInt::GetMx(KeyDatH.Len(), 16)){
+    OutKeyH.DelKey(OutKeyL.Last()->GetVal()); OutKeyL.Del(OutKeyL.Last());
+  }
+}
+
+template <class TKey, class TDat, class THashFunc>
+bool TQCache<TKey, TDat, THashFunc>::Evict(const int& KeepKeyId){
+  // take from In when over its share or when Main is empty
+  const bool InP=(InMemUsed>MxMemUsed/4)||MainKeyL.Empty();
+  TKeyL& KeyL=InP ? InKeyL : MainKeyL;
+  TKeyL& OtherKeyL=InP ? MainKeyL : InKeyL;
+  TKeyLN KeyLN=KeyL.Last();
+  if (KeyLN!=NULL&&KeyDatH.GetKeyId(KeyLN->GetVal())==KeepKeyId){KeyLN=KeyLN->Prev();}
+  if (KeyLN==NULL){KeyLN=OtherKeyL.Last();}
+  if (KeyLN!=NULL&&KeyDatH.GetKeyId(KeyLN->GetVal())==KeepKeyId){KeyLN=KeyLN->Prev();}
+  if (KeyLN==NULL){return false;}
+  const TKey Key=KeyLN->GetVal();
+  const bool MainP=KeyDatH.GetDat(Key).MainP;
+  Del(Key); Evictions++;
+  if (!MainP){AddOutKey(Key);}
+  return true;
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::Purge(const int64& MemToPurge, const int& KeepKeyId){
+  const int64 StartMemUsed=CurMemUsed;
+  while ((StartMemUsed-CurMemUsed<MemToPurge)&&Evict(KeepKeyId)){}
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::Put(const TKey& Key, const TDat& Dat){
+  int KeyId=KeyDatH.GetKeyId(Key);
+  if (KeyId==-1){
+    // keys seen recently go to main queue, others to the in queue
+    TKeyDat KeyDat; KeyDat.Dat=Dat; KeyDat.MainP=OutKeyH.IsKey(Key);
+    const int64 KeyDatMem=GetKeyDatMem(Key, Dat); KeyDat.MemUsed=KeyDatMem;
+    if (CurMemUsed+KeyDatMem>MxMemUsed){Purge(CurMemUsed+KeyDatMem-MxMemUsed);}
+    if (OutKeyH.IsKey(Key)){OutKeyL.Del(OutKeyH.GetDat(Key)); OutKeyH.DelKey(Key);}
+    if (KeyDat.MainP){
+      KeyDat.KeyLN=MainKeyL.AddFront(Key);
+    } else {
+      KeyDat.KeyLN=InKeyL.AddFront(Key); InMemUsed+=KeyDatMem;
+    }
+    CurMemUsed+=KeyDatMem;
+    KeyDatH.AddDat(Key, KeyDat);
+  } else {
+    TKeyDat& KeyDat=KeyDatH[KeyId];
+    KeyDat.Dat=Dat;
+    // in queue keeps insertion order
+    if (KeyDat.MainP){MainKeyL.PutFront(KeyDat.KeyLN);}
+    UpdateMemUsed(Key);
+  }
+}
+
+template <class TKey, class TDat, class THashFunc>
+bool TQCache<TKey, TDat, THashFunc>::Get(const TKey& Key, TDat& Dat){
+  int KeyId=KeyDatH.GetKeyId(Key);
+  if (KeyId==-1){
+    Misses++; return false;
+  } else {
+    TKeyDat& KeyDat=KeyDatH[KeyId];
+    if (KeyDat.MainP){MainKeyL.PutFront(KeyDat.KeyLN);}
+    Dat=KeyDat.Dat; Hits++; return true;
+  }
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::UpdateMemUsed(const TKey& Key){
+  const int KeyId=KeyDatH.GetKeyId(Key);
+  if (KeyId==-1){return;}
+  TKeyDat& KeyDat=KeyDatH[KeyId];
+  const int64 KeyDatMem=GetKeyDatMem(Key, KeyDat.Dat);
+  const int64 MemDiff=KeyDatMem-KeyDat.MemUsed;
+  KeyDat.MemUsed=KeyDatMem; CurMemUsed+=MemDiff;
+  if (!KeyDat.MainP){InMemUsed+=MemDiff;}
+  // make space without dropping the updated key
+  if (CurMemUsed>MxMemUsed){Purge(CurMemUsed-MxMemUsed, KeyId);}
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::Del(const TKey& Key, const bool& DoEventCall){
+  int KeyId=KeyDatH.GetKeyId(Key);
+  if (KeyId!=-1){
+    TKeyDat& KeyDat=KeyDatH[KeyId];
+    if (DoEventCall){
+      KeyDat.Dat->OnDelFromCache(Key, RefToBs);}
+    CurMemUsed-=KeyDat.MemUsed;
+    if (KeyDat.MainP){MainKeyL.Del(KeyDat.KeyLN);}
+    else {InKeyL.Del(KeyDat.KeyLN); InMemUsed-=KeyDat.MemUsed;}
+    KeyDatH.DelKeyId(KeyId);
+  }
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::Flush(){
+  int KeyId=KeyDatH.FFirstKeyId();
+  while (KeyDatH.FNextKeyId(KeyId)){
+    KeyDatH[KeyId].Dat->OnDelFromCache(KeyDatH.GetKey(KeyId), RefToBs);
+  }
+}
+
+template <class TKey, class TDat, class THashFunc>
+void TQCache<TKey, TDat, THashFunc>::FlushAndClr(){
+  Flush();
+  CurMemUsed=0; InMemUsed=0;
+  KeyDatH.Clr(); InKeyL.Clr(); MainKeyL.Clr();
+  OutKeyH.Clr(); OutKeyL.Clr();
+}
+
 /////////////////////////////////////////////////
 // Old-Hash-Functions
 
@@ -34,6 +34,7 @@ const TStr THttp::CacheCtrlFldNm="Cache-Control";
 const TStr THttp::AcceptFldNm="Accept";
 const TStr THttp::SrvFldNm="Server";
 const TStr THttp::ConnFldNm="Connection";
+const TStr THttp::TransferEncodingFldNm="Transfer-Encoding";
 const TStr THttp::FetchIdFldNm="FetchId";
 const TStr THttp::LocFldNm="Location";
 const TStr THttp::SetCookieFldNm="Set-Cookie";
@@ -56,6 +57,8 @@ const TStr THttp::AppSoapXmlFldVal="application/soap+xml";
 const TStr THttp::AppW3FormFldVal="application/x-www-form-urlencoded";
 const TStr THttp::AppJSonFldVal = "application/json";
 const TStr THttp::ConnKeepAliveFldVal="keep-alive";
+const TStr THttp::ConnCloseFldVal="close";
+const TStr THttp::ChunkedFldVal="chunked";
 
 // file extensions
 bool THttp::IsHtmlFExt(const TStr& FExt){
@@ -674,6 +677,24 @@ const TStr& THttpRq::GetMethodNm() const {
   }
 }
 
+bool THttpRq::IsKeepAlive() const {
+  if ((MajorVerN>1)||((MajorVerN==1)&&(MinorVerN>=1))){
+    return !IsFldVal(THttp::ConnFldNm, THttp::ConnCloseFldVal);
+  } else {
+    return IsFldVal(THttp::ConnFldNm, THttp::ConnKeepAliveFldVal);
+  }
+}
+
+int THttpRq::GetLen() const {
+  if (IsFldNm(THttp::ContLenFldNm)){return HdStr.Len()+BodyMem.Len();}
+  switch (Method){
+    case hrmGet: case hrmHead: case hrmOptions: case hrmDelete:
+      return HdStr.Len();
+    default:
+      return HdStr.Len()+BodyMem.Len();
+  }
+}
+
 bool THttpRq::IsFldNm(const TStr& FldNm) const {
   return FldNmToValH.IsKey(THttpLx::GetNrStr(FldNm));
 }
@@ -908,6 +929,17 @@ bool THttpResp::IsFldVal(const TStr& FldNm, const TStr& FldVal) const {
   return THttpLx::GetNrStr(FldVal)==THttpLx::GetNrStr(GetFldVal(FldNm));
 }
 
+void THttpResp::PutVer(const int& _MajorVerN, const int& _MinorVerN){
+  MajorVerN=_MajorVerN; MinorVerN=_MinorVerN;
+  const int SpaceChN=HdStr.SearchCh(' ');
+  if (HdStr.StartsWith("HTTP/")&&(SpaceChN!=-1)){
+    TChA HdChA;
+    HdChA+="HTTP/"; HdChA+=TInt::GetStr(MajorVerN); HdChA+=".";
+    HdChA+=TInt::GetStr(MinorVerN); HdChA+=HdStr.GetSubStr(SpaceChN);
+    HdStr=HdChA;
+  }
+}
+
 void THttpResp::AddFldVal(const TStr& FldNm, const TStr& FldVal){
   TStr NrFldNm=THttpLx::GetNrStr(FldNm);
   FldNmToValVH.AddDat(NrFldNm).Add(FldVal);
@@ -36,6 +36,7 @@ public:
   static const TStr AcceptFldNm;
   static const TStr SrvFldNm;
   static const TStr ConnFldNm;
+  static const TStr TransferEncodingFldNm;
   static const TStr FetchIdFldNm;
   static const TStr LocFldNm;
   static const TStr SetCookieFldNm;
@@ -57,6 +58,8 @@ public:
   static const TStr AppW3FormFldVal;
   static const TStr AppJSonFldVal;
   static const TStr ConnKeepAliveFldVal;
+  static const TStr ConnCloseFldVal;
+  static const TStr ChunkedFldVal;
   // file extensions
   static bool IsHtmlFExt(const TStr& FExt);
   static bool IsGifFExt(const TStr& FExt);
@@ -135,6 +138,10 @@ public:
   // component-retrieval
   bool IsOk() const {return Ok;}
   bool IsComplete() const {return CompleteP;}
+  int GetMajorVerN() const {return MajorVerN;}
+  int GetMinorVerN() const {return MinorVerN;}
+  // http/1.1 keeps connection unless asked to close, http/1.0 only when asked
+  bool IsKeepAlive() const;
   THttpRqMethod GetMethod() const {return Method;}
   const TStr& GetMethodNm() const;
   PUrl GetUrl() const {return Url;}
@@ -158,6 +165,10 @@ public:
   PSIn GetBodyAsSIn() const { return TMemIn::New(BodyMem); }
   void GetBodyAsMem(TMem& Mem) const {Mem.Clr(); Mem += BodyMem;}
   void GetAsMem(TMem& Mem) const {Mem.Clr(); Mem+=HdStr; Mem+=BodyMem;}
+  // number of bytes the request takes in the parsed stream; requests
+  // without content-length and body end with the header, so the rest of
+  // the stream can hold further (pipelined) requests
+  int GetLen() const;
 
   // content-type
   bool IsContType(const TStr& ContTypeStr) const {
@@ -200,6 +211,8 @@ public:
   THttpResp& operator=(const THttpResp&){Fail; return *this;}
 
   bool IsOk() const {return Ok;}
+  // change http version in the status line
+  void PutVer(const int& _MajorVerN, const int& _MinorVerN);
   int Len() const {return HdStr.Len()+BodyMem.Len();}
   bool IsContLenOk() const {int ContLen;
     return IsOk()&&IsContLen(ContLen)&&(ContLen==BodyMem.Len());}
@@ -548,3 +548,276 @@ PJsonVal TBsonObj::GetJsonRecursive(TSIn& SIn, TStrHash<TInt, TBigStrPool>* Voc)
 	}
 	return res;
 }
+
+///////////////////////////////////////////////////////////////////////////////////
+// Json-Reader
+void TJsonReader::Throw(const TStr& MsgStr) const {
+  TExcept::Throw(TStr::Fmt("JSON %s at character %d.", MsgStr.CStr(), BfC));
+}
+
+void TJsonReader::SkipWs() {
+  while (BfC < BfL) {
+    const char Ch = Bf[BfC];
+    if (Ch != ' ' && Ch != '\t' && Ch != '\n' && Ch != '\r') { break; }
+    BfC++;
+  }
+}
+
+char TJsonReader::GetCh() {
+  if (BfC >= BfL) { Throw("unexpected end of input"); }
+  return Bf[BfC++];
+}
+
+void TJsonReader::ExpectCh(const char& Ch) {
+  SkipWs();
+  if (BfC >= BfL || Bf[BfC] != Ch) { Throw(TStr::Fmt("expected '%c'", Ch)); }
+  BfC++;
+}
+
+void TJsonReader::ExpectWord(const char* Word) {
+  for (const char* WordCh = Word; *WordCh != 0; WordCh++) {
+    if (BfC >= BfL || Bf[BfC] != *WordCh) { Throw("unexpected symbol"); }
+    BfC++;
+  }
+}
+
+void TJsonReader::ReadStr() {
+  // opening quote was already consumed
+  Str.Clr();
+  forever {
+    // copy unescaped part in one go
+    const int StartBfC = BfC;
+    while (BfC < BfL && Bf[BfC] != '"' && Bf[BfC] != '\\') { BfC++; }
+    if (BfC > StartBfC) { Str.AddBf(Bf + StartBfC, BfC - StartBfC); }
+    const char Ch = GetCh();
+    if (Ch == '"') { break; }
+    // escape sequence
+    const char EscCh = GetCh();
+    switch (EscCh) {
+      case '"': Str.AddCh('"'); break;
+      case '\\': Str.AddCh('\\'); break;
+      case '\'': Str.AddCh('\''); break;
+      case '/': Str.AddCh('/'); break;
+      case 'b': Str.AddCh('\b'); break;
+      case 'f': Str.AddCh('\f'); break;
+      case 'n': Str.AddCh('\n'); break;
+      case 'r': Str.AddCh('\r'); break;
+      case 't': Str.AddCh('\t'); break;
+      case 'u': {
+        uint UCh = 0;
+        for (int HexN = 0; HexN < 4; HexN++) {
+          const char HexCh = GetCh();
+          if (!TCh::IsHex(HexCh)) { Throw("invalid unicode escape"); }
+          UCh = 16 * UCh + TCh::GetHex(HexCh);
+        }
+        // each escape is encoded on its own, same as in TILx
+        TUnicode::EncodeUtf8(UCh, Str);
+        break;
+      }
+      default: Throw("invalid escape sequence");
+    }
+  }
+}
+
+void TJsonReader::ReadNum() {
+  const int StartBfC = BfC;
+  if (BfC < BfL && (Bf[BfC] == '-' || Bf[BfC] == '+')) { BfC++; }
+  const int DigitBfC = BfC;
+  while (BfC < BfL && TCh::IsNum(Bf[BfC])) { BfC++; }
+  if (BfC == DigitBfC) { Throw("unexpected symbol"); }
+  if (BfC < BfL && Bf[BfC] == '.') {
+    BfC++;
+    while (BfC < BfL && TCh::IsNum(Bf[BfC])) { BfC++; }
+  }
+  if (BfC < BfL && (Bf[BfC] == 'e' || Bf[BfC] == 'E')) {
+    BfC++;
+    if (BfC < BfL && (Bf[BfC] == '-' || Bf[BfC] == '+')) { BfC++; }
+    const int ExpBfC = BfC;
+    while (BfC < BfL && TCh::IsNum(Bf[BfC])) { BfC++; }
+    if (BfC == ExpBfC) { Throw("invalid number"); }
+  }
+  // copy to a terminated buffer, input is not necessarily zero-terminated
+  Str.Clr(); Str.AddBf(Bf + StartBfC, BfC - StartBfC);
+  Num = atof(Str.CStr());
+}
+
+void TJsonReader::ReadVal() {
+  SkipWs();
+  const char Ch = GetCh();
+  switch (Ch) {
+    case '{': TokenType = jrtObjStart; ObjStackV.Add(true); ValP = false; return;
+    case '[': TokenType = jrtArrStart; ObjStackV.Add(false); ValP = false; return;
+    case '"': TokenType = jrtStr; ReadStr(); break;
+    case 't': ExpectWord("rue"); TokenType = jrtBool; Bool = true; break;
+    case 'f': ExpectWord("alse"); TokenType = jrtBool; Bool = false; break;
+    case 'n': ExpectWord("ull"); TokenType = jrtNull; break;
+    default: BfC--; ReadNum(); TokenType = jrtNum;
+  }
+  ValP = true;
+}
+
+bool TJsonReader::Next() {
+  if (TokenType == jrtEof) { return false; }
+  if (ObjStackV.Empty()) {
+    if (ValP) {
+      // single top-level value, only whitespace can follow
+      SkipWs();
+      if (BfC < BfL) { Throw("unexpected symbol after the end of value"); }
+      TokenType = jrtEof; return false;
+    }
+    ReadVal(); return true;
+  }
+  const bool ObjP = ObjStackV.Last();
+  if (KeyP) {
+    // value of the last key
+    KeyP = false; ExpectCh(':'); ReadVal(); return true;
+  }
+  SkipWs();
+  if (BfC < BfL && Bf[BfC] == (ObjP ? '}' : ']')) {
+    BfC++; ObjStackV.DelLast();
+    TokenType = ObjP ? jrtObjEnd : jrtArrEnd; ValP = true;
+    return true;
+  }
+  if (ValP) { ExpectCh(','); }
+  if (ObjP) {
+    ExpectCh('"'); ReadStr();
+    TokenType = jrtKey; KeyP = true; ValP = false;
+  } else {
+    ReadVal();
+  }
+  return true;
+}
+
+void TJsonReader::SkipVal() {
+  if (TokenType == jrtObjStart || TokenType == jrtArrStart) {
+    const int Depth = GetDepth();
+    while (GetDepth() >= Depth) { Next(); }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Json-Writer
+void TJsonWriter::PutSep() {
+  if (KeyP) { KeyP = false; return; }
+  if (EmptyStackV.Empty()) { return; }
+  if (EmptyStackV.Last()) { EmptyStackV.Last() = false; } else { ChA += ','; }
+}
+
+void TJsonWriter::PutEscStr(const char* CStr, const int& Len) {
+  ChA += '"';
+  int StartChN = 0;
+  for (int ChN = 0; ChN < Len; ChN++) {
+    const uchar Ch = (uchar)CStr[ChN];
+    if (Ch >= 0x20 && Ch != '"' && Ch != '\\') { continue; }
+    // copy characters which need no escaping in one go
+    if (ChN > StartChN) { ChA.AddBf(CStr + StartChN, ChN - StartChN); }
+    StartChN = ChN + 1;
+    switch (Ch) {
+      case '"': ChA += "\\\""; break;
+      case '\\': ChA += "\\\\"; break;
+      case '\b': ChA += "\\b"; break;
+      case '\f': ChA += "\\f"; break;
+      case '\n': ChA += "\\n"; break;
+      case '\r': ChA += "\\r"; break;
+      case '\t': ChA += "\\t"; break;
+      default: ChA += TStr::Fmt("\\u%04x", (int)Ch);
+    }
+  }
+  if (Len > StartChN) { ChA.AddBf(CStr + StartChN, Len - StartChN); }
+  ChA += '"';
+}
+
+void TJsonWriter::PutObjStart() {
+  PutSep(); ChA += '{'; EmptyStackV.Add(true);
+}
+
+void TJsonWriter::PutObjEnd() {
+  EAssertR(!EmptyStackV.Empty() && !KeyP, "TJsonWriter: no object to close");
+  EmptyStackV.DelLast(); ChA += '}'; PutChunk();
+}
+
+void TJsonWriter::PutArrStart() {
+  PutSep(); ChA += '['; EmptyStackV.Add(true);
+}
+
+void TJsonWriter::PutArrEnd() {
+  EAssertR(!EmptyStackV.Empty() && !KeyP, "TJsonWriter: no array to close");
+  EmptyStackV.DelLast(); ChA += ']'; PutChunk();
+}
+
+void TJsonWriter::PutKey(const TStr& KeyStr) {
+  EAssertR(!KeyP, "TJsonWriter: key without value");
+  PutSep(); PutEscStr(KeyStr.CStr(), KeyStr.Len()); ChA += ':'; KeyP = true;
+}
+
+void TJsonWriter::PutNull() {
+  PutSep(); ChA += "null"; PutChunk();
+}
+
+void TJsonWriter::PutBool(const bool& Bool) {
+  PutSep(); ChA += Bool ? "true" : "false"; PutChunk();
+}
+
+void TJsonWriter::PutNum(const double& Num) {
+  PutSep();
+  if (!TFlt::IsNum(Num)) {
+    ChA += "null";
+  } else {
+    char NumCStr[32];
+    if (Num == floor(Num) && fabs(Num) < 1e15) {
+      sprintf(NumCStr, "%.0f", Num);
+    } else {
+      sprintf(NumCStr, "%.17g", Num);
+    }
+    ChA += NumCStr;
+  }
+  PutChunk();
+}
+
+void TJsonWriter::PutStr(const TStr& Str) {
+  PutSep(); PutEscStr(Str.CStr(), Str.Len()); PutChunk();
+}
+
+void TJsonWriter::PutStr(const char* CStr) {
+  PutSep(); PutEscStr(CStr, (int)strlen(CStr)); PutChunk();
+}
+
+void TJsonWriter::PutStr(const char* Bf, const int& BfL) {
+  PutSep(); PutEscStr(Bf, BfL); PutChunk();
+}
+
+void TJsonWriter::PutVal(const PJsonVal& Val) {
+  switch (Val->GetJsonValType()) {
+    case jvtNull: PutNull(); break;
+    case jvtBool: PutBool(Val->GetBool()); break;
+    case jvtNum: PutNum(Val->GetNum()); break;
+    case jvtStr: PutStr(Val->GetStr()); break;
+    case jvtArr:
+      PutArrStart();
+      for (int ArrValN = 0; ArrValN < Val->GetArrVals(); ArrValN++) {
+        PutVal(Val->GetArrVal(ArrValN));
+      }
+      PutArrEnd();
+      break;
+    case jvtObj:
+      PutObjStart();
+      for (int ObjKeyN = 0; ObjKeyN < Val->GetObjKeys(); ObjKeyN++) {
+        TStr ObjKey; PJsonVal ObjVal; Val->GetObjKeyVal(ObjKeyN, ObjKey, ObjVal);
+        PutKey(ObjKey); PutVal(ObjVal);
+      }
+      PutObjEnd();
+      break;
+    default: TExcept::Throw("Error serializing json to string");
+  }
+}
+
+void TJsonWriter::PutLn() {
+  EAssertR(EmptyStackV.Empty(), "TJsonWriter: new line inside a value");
+  ChA += '\n'; PutChunk();
+}
+
+void TJsonWriter::Flush() {
+  if (SOut.Empty()) { return; }
+  if (ChA.Len() > 0) { SOut->PutBf(ChA.CStr(), ChA.Len()); ChA.Clr(); }
+  SOut->Flush();
+}
@@ -204,3 +204,137 @@ private:
 	static int64 GetMemUsedRecursive(const TJsonVal& JsonVal, bool UseVoc);
 	static PJsonVal GetJsonRecursive(TSIn& SIn, TStrHash<TInt, TBigStrPool>* Voc);
 };
+
+//////////////////////////////////////////////////////////////////////////////
+// Json-Reader
+//  pull parser walking over json string one token at a time, without
+//  building TJsonVal tree; string values and keys are decoded into a buffer
+//  which is reused between tokens, so parsing allocates only for long strings
+
+typedef enum {
+  jrtUndef, jrtNull, jrtBool, jrtNum, jrtStr, jrtKey,
+  jrtObjStart, jrtObjEnd, jrtArrStart, jrtArrEnd, jrtEof} TJsonReaderTokenType;
+
+class TJsonReader {
+private:
+  // input buffer, must outlive the reader
+  const char* Bf;
+  int BfL, BfC;
+  // current token
+  TJsonReaderTokenType TokenType;
+  TBool Bool;
+  TFlt Num;
+  TChA Str;
+  // stack of open containers (true for object, false for array)
+  TBoolV ObjStackV;
+  // last token completed a value
+  TBool ValP;
+  // last token was an object key
+  TBool KeyP;
+
+  UndefCopyAssign(TJsonReader);
+
+  void Throw(const TStr& MsgStr) const;
+  void SkipWs();
+  char GetCh();
+  void ExpectCh(const char& Ch);
+  void ExpectWord(const char* Word);
+  void ReadStr();
+  void ReadNum();
+  void ReadVal();
+
+public:
+  TJsonReader(const char* _Bf, const int& _BfL): Bf(_Bf), BfL(_BfL), BfC(0),
+    TokenType(jrtUndef), ValP(false), KeyP(false) { }
+  TJsonReader(const char* CStr): Bf(CStr), BfL((int)strlen(CStr)), BfC(0),
+    TokenType(jrtUndef), ValP(false), KeyP(false) { }
+  TJsonReader(const TStr& JsonStr): Bf(JsonStr.CStr()), BfL(JsonStr.Len()), BfC(0),
+    TokenType(jrtUndef), ValP(false), KeyP(false) { }
+
+  // moves to next token, returns false at the end of input;
+  // throws exception on malformed input
+  bool Next();
+  // skips current value, when positioned on object or array start
+  // moves to its matching end
+  void SkipVal();
+
+  TJsonReaderTokenType GetTokenType() const { return TokenType; }
+  bool IsNull() const { return TokenType == jrtNull; }
+  bool IsBool() const { return TokenType == jrtBool; }
+  bool IsNum() const { return TokenType == jrtNum; }
+  bool IsStr() const { return TokenType == jrtStr; }
+  bool IsKey() const { return TokenType == jrtKey; }
+  bool IsObjStart() const { return TokenType == jrtObjStart; }
+  bool IsObjEnd() const { return TokenType == jrtObjEnd; }
+  bool IsArrStart() const { return TokenType == jrtArrStart; }
+  bool IsArrEnd() const { return TokenType == jrtArrEnd; }
+  bool IsEof() const { return TokenType == jrtEof; }
+
+  bool GetBool() const { EAssert(IsBool()); return Bool; }
+  double GetNum() const { EAssert(IsNum()); return Num; }
+  int GetInt() const { EAssert(IsNum()); return TFlt::Round(Num); }
+  // value of string token or key, valid until next call to Next()
+  const TChA& GetStr() const { EAssert(IsStr() || IsKey()); return Str; }
+  // number of open objects and arrays
+  int GetDepth() const { return ObjStackV.Len(); }
+  // position of the reader in the input
+  int GetBfC() const { return BfC; }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Json-Writer
+//  writes json text directly, without building TJsonVal tree; output is
+//  collected in a buffer, or, when writing to a stream, passed on to the
+//  stream in chunks of approximately ChunkLen characters
+
+class TJsonWriter {
+private:
+  // output buffer
+  TChA ChA;
+  // stream receiving the output (optional)
+  PSOut SOut;
+  int ChunkLen;
+  // stack of open containers, true while container has no elements
+  TBoolV EmptyStackV;
+  // last token was an object key
+  TBool KeyP;
+
+  UndefCopyAssign(TJsonWriter);
+
+  // separate value from the previous one
+  void PutSep();
+  // pass full chunks to the stream
+  void PutChunk() { if (!SOut.Empty() && ChA.Len() >= ChunkLen) { Flush(); } }
+  void PutEscStr(const char* CStr, const int& Len);
+
+public:
+  TJsonWriter(): ChunkLen(TInt::Mx), KeyP(false) { }
+  TJsonWriter(const PSOut& _SOut, const int& _ChunkLen = 65536):
+    SOut(_SOut), ChunkLen(_ChunkLen), KeyP(false) { }
+
+  void PutObjStart();
+  void PutObjEnd();
+  void PutArrStart();
+  void PutArrEnd();
+  void PutKey(const TStr& KeyStr);
+  void PutNull();
+  void PutBool(const bool& Bool);
+  // integral values are written without decimals, others with full precision;
+  // values which are not numbers are written as null
+  void PutNum(const double& Num);
+  void PutStr(const TStr& Str);
+  void PutStr(const char* CStr);
+  void PutStr(const char* Bf, const int& BfL);
+  // write existing json value
+  void PutVal(const PJsonVal& Val);
+  // end of top-level value when writing one value per line (JSON lines)
+  void PutLn();
+
+  // number of open objects and arrays
+  int GetDepth() const { return EmptyStackV.Len(); }
+  // pass buffered output to the stream, must be called at the end
+  void Flush();
+  // output written so far, when not writing to a stream
+  const TChA& GetChA() const { return ChA; }
+  TStr GetStr() const { return ChA; }
+};
@@ -1246,12 +1246,17 @@ void TLinAlg::Multiply(const TFltVV& A, const TFltVV& B, TFltVV& C) {
 	Assert(A.GetRows() == C.GetRows() && B.GetCols() == C.GetCols() && A.GetCols() == B.GetRows());
 
 	int n = C.GetRows(), m = C.GetCols(), l = A.GetCols();
+	C.PutAll(0.0);
+	if (m == 0) { return; }
+	// i-k-j order walks rows of B and C, so the inner loop is over 
+	// contiguous memory and vectorizes; each C(i,j) still sums over k in order
 	for (int i = 0; i < n; i++) {
-		for (int j = 0; j < m; j++) {
-			double sum = 0.0;
-			for (int k = 0; k < l; k++)
-				sum += A(i, k)*B(k, j);
-			C(i, j) = sum;
+		double* CRow = &C(i, 0).Val;
+		for (int k = 0; k < l; k++) {
+			const double Aik = A(i, k);
+			const double* BRow = &B(k, 0).Val;
+			for (int j = 0; j < m; j++)
+				CRow[j] += Aik * BRow[j];
 		}
 	}
 }
@@ -1279,13 +1284,17 @@ void TLinAlg::MultiplyT(const TFltVV& A, const TFltVV& B, TFltVV& C) {
 #else
 void TLinAlg::MultiplyT(const TFltVV& A, const TFltVV& B, TFltVV& C) {
     Assert(A.GetCols() == C.GetRows() && B.GetCols() == C.GetCols() && A.GetRows() == B.GetRows());
-	int n = C.GetRows(), m = C.GetCols(), l = A.GetRows(); double sum;
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            sum = 0.0;
-            for (int k = 0; k < l; k++)
-                sum += A(k,i)*B(k,j);
-            C(i,j) = sum;
+	int n = C.GetRows(), m = C.GetCols(), l = A.GetRows();
+	C.PutAll(0.0);
+	if (m == 0) { return; }
+	// k-i-j order walks rows of A, B and C, see Multiply
+    for (int k = 0; k < l; k++) {
+        const double* BRow = &B(k, 0).Val;
+        for (int i = 0; i < n; i++) {
+            const double Aki = A(k, i);
+            double* CRow = &C(i, 0).Val;
+            for (int j = 0; j < m; j++)
+                CRow[j] += Aki * BRow[j];
         }
     }
 }
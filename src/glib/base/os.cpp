@@ -756,12 +756,13 @@ uint64 TSysTm::GetPerfTimerTicks(){
   struct timespec ts;
   int ErrCd=clock_gettime(CLOCK_MONOTONIC, &ts);
   //Assert(ErrCd==0); //J: vcasih se prevede in ne dela
-  if (ErrCd != 0) {
+  if (ErrCd == 0) {
     return (uint64)ts.tv_sec*1000000000ll + (uint64)ts.tv_nsec; }
   else {
+    // fall back to microseconds scaled to the declared frequency
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    return (uint64)tv.tv_usec + ((uint64)tv.tv_sec)*1000000;
+    return ((uint64)tv.tv_usec + ((uint64)tv.tv_sec)*1000000)*1000;
   }
 #else
   //#warning "CLOCK_MONOTONIC not available; using gettimeofday()"
@@ -869,3 +870,42 @@ int TStdIOPipe::Read(char *Bf, const int& BfMxLen) {
 
 #endif
 
+/////////////////////////////////////////////////
+// System-Critical-Section
+#ifdef GLib_WIN
+
+TSysCs::TSysCs() { InitializeCriticalSection(&Cs); }
+TSysCs::~TSysCs() { DeleteCriticalSection(&Cs); }
+void TSysCs::Enter() { EnterCriticalSection(&Cs); }
+void TSysCs::Leave() { LeaveCriticalSection(&Cs); }
+
+#else
+
+TSysCs::TSysCs() { EAssert(pthread_mutex_init(&Cs, NULL) == 0); }
+TSysCs::~TSysCs() { pthread_mutex_destroy(&Cs); }
+void TSysCs::Enter() { EAssert(pthread_mutex_lock(&Cs) == 0); }
+void TSysCs::Leave() { EAssert(pthread_mutex_unlock(&Cs) == 0); }
+
+#endif
+
+/////////////////////////////////////////////////
+// System-Read-Write-Lock
+#ifdef GLib_WIN
+
+TSysRWLock::TSysRWLock() { InitializeSRWLock(&Lock); }
+TSysRWLock::~TSysRWLock() { }
+void TSysRWLock::EnterRead() { AcquireSRWLockShared(&Lock); }
+void TSysRWLock::LeaveRead() { ReleaseSRWLockShared(&Lock); }
+void TSysRWLock::EnterWrite() { AcquireSRWLockExclusive(&Lock); }
+void TSysRWLock::LeaveWrite() { ReleaseSRWLockExclusive(&Lock); }
+
+#else
+
+TSysRWLock::TSysRWLock() { EAssert(pthread_rwlock_init(&Lock, NULL) == 0); }
+TSysRWLock::~TSysRWLock() { pthread_rwlock_destroy(&Lock); }
+void TSysRWLock::EnterRead() { EAssert(pthread_rwlock_rdlock(&Lock) == 0); }
+void TSysRWLock::LeaveRead() { EAssert(pthread_rwlock_unlock(&Lock) == 0); }
+void TSysRWLock::EnterWrite() { EAssert(pthread_rwlock_wrlock(&Lock) == 0); }
+void TSysRWLock::LeaveWrite() { EAssert(pthread_rwlock_unlock(&Lock) == 0); }
+
+#endif
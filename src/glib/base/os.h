@@ -273,3 +273,53 @@ public:
 };
 
 #endif
+
+/////////////////////////////////////////////////
+// System-Critical-Section
+//   Non-recursive mutex for guarding shared structures between threads
+class TSysCs {
+private:
+#ifdef GLib_WIN
+  CRITICAL_SECTION Cs;
+#else
+  pthread_mutex_t Cs;
+#endif
+  UndefCopyAssign(TSysCs);
+public:
+  TSysCs();
+  ~TSysCs();
+
+  void Enter();
+  void Leave();
+};
+
+// Enters critical section on construction and leaves it on destruction
+class TSysCsLock {
+private:
+  TSysCs& Cs;
+  UndefCopyAssign(TSysCsLock);
+public:
+  TSysCsLock(TSysCs& _Cs): Cs(_Cs) { Cs.Enter(); }
+  ~TSysCsLock() { Cs.Leave(); }
+};
+
+/////////////////////////////////////////////////
+// System-Read-Write-Lock
+//   Many readers or one writer; neither side is recursive
+class TSysRWLock {
+private:
+#ifdef GLib_WIN
+  SRWLOCK Lock;
+#else
+  pthread_rwlock_t Lock;
+#endif
+  UndefCopyAssign(TSysRWLock);
+public:
+  TSysRWLock();
+  ~TSysRWLock();
+
+  void EnterRead();
+  void LeaveRead();
+  void EnterWrite();
+  void LeaveWrite();
+};
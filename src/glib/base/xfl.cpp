@@ -350,3 +350,114 @@ void TFileLock::Unlock() {
   // delete the lock file (relasing the lock)
   EAssertR(TFile::Del(LockFNm, false), "Error deleting lock file");
 }
+
+/////////////////////////////////////////////////
+// File-Commit
+TFCommit::~TFCommit(){
+  if (!CommitP){
+    // remove temporary files of an abandoned commit
+    for (int FNmN=0; FNmN<FNmV.Len(); FNmN++){
+      TFile::Del(GetTmpFNm(FNmV[FNmN]), false);}
+  }
+}
+
+TStr TFCommit::GetDirNm(const TStr& FNm){
+  TStr DirNm=FNm.GetFPath();
+  return DirNm.Empty() ? TStr("./") : DirNm;
+}
+
+void TFCommit::SyncDirs(const TStrV& FNmV){
+  TStrSet DirNmSet;
+  for (int FNmN=0; FNmN<FNmV.Len(); FNmN++){
+    DirNmSet.AddKey(GetDirNm(FNmV[FNmN]));}
+  int KeyId=DirNmSet.FFirstKeyId();
+  while (DirNmSet.FNextKeyId(KeyId)){
+    TFile::Sync(DirNmSet.GetKey(KeyId));}
+}
+
+void TFCommit::Finish(const TStr& CommitFNm, const TStrV& FNmV, const TStrV& DelFNmV){
+  for (int FNmN=0; FNmN<FNmV.Len(); FNmN++){
+    const TStr TmpFNm=GetTmpFNm(FNmV[FNmN]);
+    // already moved when finishing after a crash during previous attempt
+    if (TFile::Exists(TmpFNm)){TFile::Replace(TmpFNm, FNmV[FNmN]);}
+  }
+  for (int FNmN=0; FNmN<DelFNmV.Len(); FNmN++){
+    TFile::Del(DelFNmV[FNmN], false);}
+  TStrV DirFNmV=FNmV; DirFNmV.AddV(DelFNmV); SyncDirs(DirFNmV);
+  // commit fully applied, forget it
+  TFile::Del(CommitFNm); TFile::Sync(GetDirNm(CommitFNm));
+}
+
+TStr TFCommit::AddFNm(const TStr& FNm){
+  EAssert(!CommitP);
+  if (!FNmV.IsIn(FNm)){FNmV.Add(FNm);}
+  return GetTmpFNm(FNm);
+}
+
+void TFCommit::DelFNm(const TStr& FNm){
+  EAssert(!CommitP);
+  if (!DelFNmV.IsIn(FNm)){DelFNmV.Add(FNm);}
+}
+
+void TFCommit::Commit(){
+  EAssert(!CommitP);
+  // new versions must be on disk before commit record points to them
+  for (int FNmN=0; FNmN<FNmV.Len(); FNmN++){
+    TFile::Sync(GetTmpFNm(FNmV[FNmN]));}
+  SyncDirs(FNmV);
+  // write commit record; after it is in place the commit is done
+  const TStr TmpCommitFNm=GetTmpFNm(CommitFNm);
+  {TFOut FOut(TmpCommitFNm); FNmV.Save(FOut); DelFNmV.Save(FOut);}
+  TFile::Sync(TmpCommitFNm);
+  TFile::Replace(TmpCommitFNm, CommitFNm);
+  TFile::Sync(GetDirNm(CommitFNm));
+  CommitP=true;
+  // move new versions in place
+  Finish(CommitFNm, FNmV, DelFNmV);
+}
+
+bool TFCommit::Recover(const TStr& CommitFNm){
+  // commit record not completely written, the commit never happened
+  TFile::Del(GetTmpFNm(CommitFNm), false);
+  if (!TFile::Exists(CommitFNm)){return false;}
+  TStrV FNmV, DelFNmV;
+  {TFIn FIn(CommitFNm); FNmV.Load(FIn); DelFNmV.Load(FIn);}
+  Finish(CommitFNm, FNmV, DelFNmV);
+  return true;
+}
+
+/////////////////////////////////////////////////
+// File-Delta
+TFDelta::TFDelta(const TStr& _FNm):
+  FNm(_FNm), Deltas(0), DeltaItems(0),
+  PendingP(false), PendingSnapshotP(false), PendingItems(0){
+  while (TFile::Exists(GetDeltaFNm(Deltas))){Deltas++;}
+}
+
+TStr TFDelta::AddSnapshot(TFCommit& Commit){
+  for (int DeltaN=0; DeltaN<Deltas; DeltaN++){
+    Commit.DelFNm(GetDeltaFNm(DeltaN));}
+  PendingP=true; PendingSnapshotP=true; PendingItems=0;
+  return Commit.AddFNm(FNm);
+}
+
+TStr TFDelta::AddDelta(TFCommit& Commit, const uint64& Items){
+  PendingP=true; PendingSnapshotP=false; PendingItems=Items;
+  return Commit.AddFNm(GetDeltaFNm(Deltas));
+}
+
+void TFDelta::OnCommit(){
+  if (!PendingP){return;}
+  if (PendingSnapshotP){
+    Deltas=0; DeltaItems=0;
+  } else {
+    Deltas++; DeltaItems+=PendingItems;
+  }
+  PendingP=false; PendingSnapshotP=false; PendingItems=0;
+}
+
+void TFDelta::DelDeltas(){
+  for (int DeltaN=0; DeltaN<Deltas; DeltaN++){
+    TFile::Del(GetDeltaFNm(DeltaN), false);}
+  Deltas=0; DeltaItems=0;
+}
@@ -142,3 +142,79 @@ public:
   // remove lock
   void Unlock();
 };
+
+/////////////////////////////////////////////////
+// File-Commit
+//   Atomically replaces a set of files. New versions are written to
+//   temporary files returned by AddFNm, Commit makes them durable and
+//   writes a commit record, after which they are moved in place. If the
+//   process dies before the commit record is written, old versions stay;
+//   if it dies after, Recover completes the moves on the next start.
+class TFCommit{
+private:
+  TStr CommitFNm;
+  TStrV FNmV, DelFNmV;
+  bool CommitP;
+private:
+  static TStr GetTmpFNm(const TStr& FNm){return FNm+".tmp";}
+  static TStr GetDirNm(const TStr& FNm);
+  static void SyncDirs(const TStrV& FNmV);
+  static void Finish(const TStr& CommitFNm, const TStrV& FNmV, const TStrV& DelFNmV);
+  UndefDefaultCopyAssign(TFCommit);
+public:
+  TFCommit(const TStr& _CommitFNm): CommitFNm(_CommitFNm), CommitP(false){}
+  ~TFCommit();
+
+  // returns name of the temporary file to write the new version of FNm to
+  TStr AddFNm(const TStr& FNm);
+  // file is deleted when commit is applied
+  void DelFNm(const TStr& FNm);
+  bool Empty() const {return FNmV.Empty()&&DelFNmV.Empty();}
+  void Commit();
+  bool IsCommit() const {return CommitP;}
+
+  // completes commit interrupted by a crash, returns true if there was one
+  static bool Recover(const TStr& CommitFNm);
+};
+
+/////////////////////////////////////////////////
+// File-Delta
+//   File FNm holds a full snapshot, changes made after it are kept in
+//   delta files FNm.Delta0, FNm.Delta1, ... added by checkpoints. Once
+//   deltas are long compared to the snapshot, they are folded into a new
+//   snapshot. Counters change only after the checkpoint is committed.
+class TFDelta{
+private:
+  // snapshot is written after this many deltas at the latest
+  enum {MxDeltas=64};
+  TStr FNm;
+  int Deltas;
+  uint64 DeltaItems;
+  // change added by the last checkpoint, applied by OnCommit
+  bool PendingP, PendingSnapshotP;
+  uint64 PendingItems;
+public:
+  TFDelta(): Deltas(0), DeltaItems(0),
+    PendingP(false), PendingSnapshotP(false), PendingItems(0){}
+  // counts existing delta files
+  TFDelta(const TStr& _FNm);
+
+  TStr GetFNm() const {return FNm;}
+  int GetDeltas() const {return Deltas;}
+  TStr GetDeltaFNm(const int& DeltaN) const {
+    return FNm+".Delta"+TInt::GetStr(DeltaN);}
+  // counts items of deltas loaded after the snapshot
+  void AddDeltaItems(const uint64& Items){DeltaItems+=Items;}
+  // deltas hold more than half of the snapshot items or there are too many
+  bool IsSnapshotDue(const uint64& SnapshotItems) const {
+    return (Deltas>=MxDeltas)||(DeltaItems>SnapshotItems/2);}
+
+  // returns temporary file for the new snapshot, deltas are deleted by the commit
+  TStr AddSnapshot(TFCommit& Commit);
+  // returns temporary file for the next delta with Items changes
+  TStr AddDelta(TFCommit& Commit, const uint64& Items);
+  // called after the commit was applied
+  void OnCommit();
+  // deletes deltas after a snapshot was saved directly to FNm
+  void DelDeltas();
+};
@@ -216,7 +216,10 @@ void TMultinomial::AddFtr(const TStrV& StrV, TFltV& FullV, int& Offset) const {
 // Tokenizable-Feature-Generator
 TBagOfWords::TBagOfWords(const bool& TfP, const bool& IdfP, const bool& NormalizeP, 
         PTokenizer _Tokenizer, const int& _HashDim, const bool& KHT,
-        const int& _NStart, const int& _NEnd): Tokenizer(_Tokenizer) {
+        const int& _NStart, const int& _NEnd, const int& _MxVocabSize): 
+            Tokenizer(_Tokenizer), MxVocabSize(_MxVocabSize) {
+
+    EAssertR(MxVocabSize == -1 || MxVocabSize > 0, "Vocabulary size must be positive");
 
     // get settings flags
     Type = 0;
@@ -243,10 +246,18 @@ TBagOfWords::TBagOfWords(const bool& TfP, const bool& IdfP, const bool& Normaliz
 TBagOfWords::TBagOfWords(TSIn& SIn): Type(SIn),
     Tokenizer(TTokenizer::Load(SIn)), TokenSet(SIn), HashDim(SIn), KeepHashTable(SIn),
     NStart(SIn),NEnd(SIn), Docs(SIn), DocFqV(SIn), ForgetP(SIn), OldDocs(SIn),
-    OldDocFqV(SIn), HashTable(SIn) { }
+    OldDocFqV(SIn), HashTable(SIn), MxVocabSize(-1) { 
+
+    // streams saved before vocabulary size limit have unbounded vocabulary
+    if ((Type & btSavedVocabSize) != 0) {
+        Type = Type & ~btSavedVocabSize;
+        MxVocabSize.Load(SIn);
+        RemappedDimSet.Load(SIn);
+    }
+}
 
 void TBagOfWords::Save(TSOut& SOut) const {
-    Type.Save(SOut);
+    TInt(Type | btSavedVocabSize).Save(SOut);
     Tokenizer->Save(SOut);
     TokenSet.Save(SOut);
     HashDim.Save(SOut);
@@ -259,6 +270,8 @@ void TBagOfWords::Save(TSOut& SOut) const {
     OldDocs.Save(SOut);
     OldDocFqV.Save(SOut);
     HashTable.Save(SOut);
+    MxVocabSize.Save(SOut);
+    RemappedDimSet.Save(SOut);
 }
 
 void TBagOfWords::Clr() {
@@ -270,9 +283,66 @@ void TBagOfWords::Clr() {
     } else {
         // if normal vector space, just forget the existing tokens and document counts
         TokenSet.Clr(); DocFqV.Clr(); OldDocFqV.Clr();
+        RemappedDimSet.Clr(); FqHeapV.Clr(); FqHeapPosV.Clr();
     }
 }
 
+void TBagOfWords::FqHeapBuild() {
+    const int Dims = TokenSet.Len();
+    FqHeapV.Gen(Dims); FqHeapPosV.Gen(Dims);
+    for (int Dim = 0; Dim < Dims; Dim++) { FqHeapV[Dim] = Dim; FqHeapPosV[Dim] = Dim; }
+    for (int PosN = Dims / 2 - 1; PosN >= 0; PosN--) { FqHeapDown(PosN); }
+}
+
+void TBagOfWords::FqHeapSwap(const int& PosN1, const int& PosN2) {
+    FqHeapV.Swap(PosN1, PosN2);
+    FqHeapPosV[FqHeapV[PosN1]] = PosN1;
+    FqHeapPosV[FqHeapV[PosN2]] = PosN2;
+}
+
+void TBagOfWords::FqHeapUp(int PosN) {
+    while (PosN > 0) {
+        const int ParentPosN = (PosN - 1) / 2;
+        if (!IsFqLess(FqHeapV[PosN], FqHeapV[ParentPosN])) { break; }
+        FqHeapSwap(PosN, ParentPosN); PosN = ParentPosN;
+    }
+}
+
+void TBagOfWords::FqHeapDown(int PosN) {
+    const int Dims = FqHeapV.Len();
+    forever {
+        const int LeftPosN = 2 * PosN + 1, RightPosN = 2 * PosN + 2;
+        int MnPosN = PosN;
+        if (LeftPosN < Dims && IsFqLess(FqHeapV[LeftPosN], FqHeapV[MnPosN])) { MnPosN = LeftPosN; }
+        if (RightPosN < Dims && IsFqLess(FqHeapV[RightPosN], FqHeapV[MnPosN])) { MnPosN = RightPosN; }
+        if (MnPosN == PosN) { break; }
+        FqHeapSwap(PosN, MnPosN); PosN = MnPosN;
+    }
+}
+
+int TBagOfWords::AddBoundedToken(const TStr& TokenStr, bool& NewDimP) {
+    if (TokenSet.Len() < MxVocabSize) {
+        // still have space, add new dimension
+        NewDimP = true;
+        const int TokenId = TokenSet.AddKey(TokenStr);
+        DocFqV.Add(0); OldDocFqV.Add(0.0);
+        IAssert(TokenId == DocFqV.Len() - 1);
+        FqHeapPosV.Add(FqHeapV.Add(TokenId));
+        FqHeapUp(FqHeapPosV[TokenId]);
+        return TokenId;
+    }
+    // replace the least frequent token; new token inherits its counts,
+    // which are the upper bound on how often the new token was seen so far
+    NewDimP = false;
+    const int TokenId = FqHeapV[0];
+    TokenSet.DelKey(TStr(TokenSet.GetKey(TokenId)));
+    // hash set reuses the last freed key id
+    const int NewTokenId = TokenSet.AddKey(TokenStr);
+    IAssert(NewTokenId == TokenId);
+    RemappedDimSet.AddKey(TokenId);
+    return TokenId;
+}
+
 void TBagOfWords::GetFtr(const TStr& Str, TStrV& TokenStrV) const {
     // outsource to tokenizer
     EAssertR(!Tokenizer.Empty(), "Missing tokenizer in TFtrGen::TBagOfWords");
@@ -332,6 +402,8 @@ bool TBagOfWords::Update(const TStrV& TokenStrV) {
             DocFqV[TokenId]++;
         }
     } else {
+        // heap is not saved and is invalidated by forgetting
+        if (IsBoundedVocab() && FqHeapV.Len() != TokenSet.Len()) { FqHeapBuild(); }
         // consolidate tokens
         TStrH TokenStrH;
         for (int TokenStrN = 0; TokenStrN < NgramStrV.Len(); TokenStrN++) {
@@ -345,7 +417,12 @@ bool TBagOfWords::Update(const TStrV& TokenStrV) {
             const TStr& TokenStr = TokenStrH.GetKey(KeyId);
             // different processing for hashing
             int TokenId = TokenSet.GetKeyId(TokenStr);
-            if (TokenId == -1) {
+            if (TokenId == -1 && IsBoundedVocab()) {
+                // new token in bounded vocabulary, might reuse existing dimension
+                bool NewDimP = false;
+                TokenId = AddBoundedToken(TokenStr, NewDimP);
+                UpdateP = UpdateP || NewDimP;
+            } else if (TokenId == -1) {
                 // new token, remember the dimensionality change
                 UpdateP = true;
                 // remember the new token
@@ -360,6 +437,8 @@ bool TBagOfWords::Update(const TStrV& TokenStrV) {
             }
             // document count update
             DocFqV[TokenId]++;
+            // keep the least frequent dimension on top
+            if (IsBoundedVocab()) { FqHeapDown(FqHeapPosV[TokenId]); }
         }
     }
     // update document count
@@ -487,6 +566,13 @@ void TBagOfWords::Forget(const double& Factor) {
         // reset current count
         DocFqV[Dim] = 0;
     }
+    // order of frequencies changed, rebuild heap on next update
+    FqHeapV.Clr(); FqHeapPosV.Clr();
+}
+
+void TBagOfWords::GetRemappedDimV(TIntV& DimV) {
+    RemappedDimSet.GetKeyV(DimV); DimV.Sort();
+    RemappedDimSet.Clr();
 }
 
 ///////////////////////////////////////
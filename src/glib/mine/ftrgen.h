@@ -128,7 +128,9 @@ private:
         btTf = (1 << 0),
         btIdf = (1 << 1),
         btNormalize = (1 << 2),
-        btHashing = (1 << 3)
+        btHashing = (1 << 3),
+        /// only in saved type, marks streams with vocabulary size limit
+        btSavedVocabSize = (1 << 4)
     } TBagOfWordsType;
     
 private:
@@ -167,11 +169,40 @@ private:
     /// Set of tokens that hash into specific dimension
     TVec<TStrSet> HashTable;
 
+    /// Maximal vocabulary size, -1 for unbounded (not used when hashing).
+    /// Bounded vocabulary is maintained as a Space-Saving heavy-hitter sketch:
+    /// when full, a new token replaces the least frequent one and inherits
+    /// its dimension and document frequency
+    TInt MxVocabSize;
+    /// Dimensions which got a new token since last GetRemappedDimV call
+    TIntSet RemappedDimSet;
+    /// Min-heap of dimensions by document frequency (bounded vocabulary only,
+    /// not saved and rebuilt on demand)
+    TIntV FqHeapV;
+    /// Position of each dimension in the heap
+    TIntV FqHeapPosV;
+
+    /// Document frequency of dimension, including forgotten counts
+    double GetDimFq(const int& Dim) const { return double(DocFqV[Dim]) + OldDocFqV[Dim]; }
+    /// Heap order, ties broken by dimension so the evicted dimension does 
+    /// not depend on the heap layout
+    bool IsFqLess(const int& Dim1, const int& Dim2) const {
+        const double Fq1 = GetDimFq(Dim1), Fq2 = GetDimFq(Dim2);
+        return (Fq1 < Fq2) || ((Fq1 == Fq2) && (Dim1 < Dim2)); }
+    /// Heap maintenance
+    void FqHeapBuild();
+    void FqHeapSwap(const int& PosN1, const int& PosN2);
+    void FqHeapUp(int PosN);
+    void FqHeapDown(int PosN);
+    /// Adds new token to the bounded vocabulary, evicting the least frequent
+    /// one when full. Returns the token's dimension.
+    int AddBoundedToken(const TStr& TokenStr, bool& NewDimP);
+
 public:
-    TBagOfWords() { }
+    TBagOfWords(): MxVocabSize(-1) { }
     TBagOfWords(const bool& TfP, const bool& IdfP, const bool& NormalizeP,
         PTokenizer _Tokenizer = NULL, const int& _HashDim = -1, const bool& KHT = false,
-        const int& NStart = 1, const int& NEnd = 1);
+        const int& NStart = 1, const int& NEnd = 1, const int& _MxVocabSize = -1);
     TBagOfWords(TSIn& SIn);
     void Save(TSOut& SOut) const;
 
@@ -181,6 +212,10 @@ public:
     bool IsNormalize() const { return ((Type & btNormalize) != 0); }
     bool IsHashing() const { return ((Type & btHashing) != 0); }
     bool IsKeepingHashTable() const { return KeepHashTable; }
+    bool IsBoundedVocab() const { return !IsHashing() && (MxVocabSize != -1); }
+    int GetMxVocabSize() const { return MxVocabSize; }
+    /// True when tokenization can be called from multiple threads
+    bool IsThreadSafe() const { return Tokenizer.Empty() || Tokenizer->IsThreadSafe(); }
     
     void Clr();
     void GetFtr(const TStr& Str, TStrV& TokenStrV) const;
@@ -195,6 +230,10 @@ public:
     
     /// Forgetting, assumes calling on equally spaced time interval.
     void Forget(const double& Factor);
+    /// Sorted dimensions reassigned to new tokens by the bounded vocabulary 
+    /// since the previous call. Features extracted before for these
+    /// dimensions are stale.
+    void GetRemappedDimV(TIntV& DimV);
 
     /// Hashing Related Functions
     int GetDim() const { return IsHashing() ? HashDim.Val : TokenSet.Len(); }
@@ -21,19 +21,20 @@ namespace TSignalProc {
     
 /////////////////////////////////////////////////
 // Online Moving Average 
-void TMa::Update(const double& InVal, const uint64& InTmMSecs, 
-        const TFltV& OutValV, const TUInt64V& OutTmMSecsV, const int& N){
+void TMa::Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+        const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN, const int& N){
     
-    int tempN = N - 1 + OutValV.Len();
+    const int Outs = OutEValN - OutBValN;
+    int tempN = N - 1 + Outs;
     double delta;    
 	// check if all the values are removed
-	if (OutValV.Len() >= tempN) {
+	if (Outs >= tempN) {
 		Ma = 0;		
 		tempN = 0;
 	}
 	else {
 		// remove old values from the mean
-		for (int ValN = 0; ValN < OutValV.Len(); ValN++)
+		for (int ValN = OutBValN; ValN < OutEValN; ValN++)
 		{
 			tempN--;
 			delta = OutValV[ValN] - Ma;
@@ -60,11 +61,11 @@ void TMa::Save(TSOut& SOut) const {
 
 /////////////////////////////////////////////////
 // Online Summa 
-void TSum::Update(const double& InVal, const uint64& InTmMSecs,
-	const TFltV& OutValV, const TUInt64V& OutTmMSecsV){
+void TSum::Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+	const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN){
 
 	// remove old values from the sum
-	for (int ValN = 0; ValN < OutValV.Len(); ValN++)
+	for (int ValN = OutBValN; ValN < OutEValN; ValN++)
 	{
 		Sum -= OutValV[ValN];
 	}
@@ -85,29 +86,31 @@ void TSum::Save(TSOut& SOut) const {
 
 /////////////////////////////////////////////////
 // Online Min 
-void TMin::Update(const double& InVal, const uint64& InTmMSecs,
-	const TFltV& OutValV, const TUInt64V& OutTmMSecsV){
+void TMin::Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+	const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN){
 		
-	while (!AllValV.Empty() && AllValV[AllValV.Len() - 1].Val1 >= InVal) {
+	while (AllValV.Len() > FirstValN && AllValV.Last().Val1 >= InVal) {
 		// pop back
 		AllValV.DelLast();
 	}
+	// drop popped front values once they take up half of the vector
+	if (FirstValN > 0 && 2 * FirstValN >= AllValV.Len()) {
+		AllValV.Del(0, TInt::GetMn(FirstValN, AllValV.Len()) - 1); FirstValN = 0;
+	}
 	// push back
 	AllValV.Add(TFltUInt64Pr(InVal, InTmMSecs));
-	
 
-	if (!OutTmMSecsV.Empty()) {
+	if (OutBValN < OutEValN) {
 		// find maximum timestamp of outgoing measurements
-		uint64 MaxOutTm = OutTmMSecsV[0];
-
-		while (AllValV[0].Val2 < MaxOutTm) {
+		const uint64 MaxOutTm = OutTmMSecsV[OutEValN - 1];
+		while (FirstValN < AllValV.Len() - 1 && AllValV[FirstValN].Val2 <= MaxOutTm) {
 			// pop front
-			AllValV.Del(0);
+			FirstValN++;
 		}
 	}
 
 	TmMSecs = InTmMSecs;
-	Min = AllValV[0].Val1;
+	Min = AllValV[FirstValN].Val1;
 }
 
 void TMin::Load(TSIn& SIn) {
@@ -118,35 +121,39 @@ void TMin::Save(TSOut& SOut) const {
 	// parameters
 	Min.Save(SOut);
 	TmMSecs.Save(SOut);
-	AllValV.Save(SOut);
+	// save only values still in the window
+	TFltUInt64PrV ValV(AllValV.Len() - FirstValN, 0);
+	for (int ValN = FirstValN; ValN < AllValV.Len(); ValN++) { ValV.Add(AllValV[ValN]); }
+	ValV.Save(SOut);
 }
 
 /////////////////////////////////////////////////
 // Online Max 
-void TMax::Update(const double& InVal, const uint64& InTmMSecs,
-	const TFltV& OutValV, const TUInt64V& OutTmMSecsV){
-
-	
-	while (!AllValV.Empty() && AllValV[AllValV.Len() - 1].Val1 <= InVal) {
+void TMax::Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+	const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN){
+		
+	while (AllValV.Len() > FirstValN && AllValV.Last().Val1 <= InVal) {
 		// pop back
 		AllValV.DelLast();
 	}
+	// drop popped front values once they take up half of the vector
+	if (FirstValN > 0 && 2 * FirstValN >= AllValV.Len()) {
+		AllValV.Del(0, TInt::GetMn(FirstValN, AllValV.Len()) - 1); FirstValN = 0;
+	}
 	// push back
 	AllValV.Add(TFltUInt64Pr(InVal, InTmMSecs));
 
-
-	if (!OutTmMSecsV.Empty()) {
+	if (OutBValN < OutEValN) {
 		// find maximum timestamp of outgoing measurements
-		uint64 MaxOutTm = OutTmMSecsV[0];
-
-		while (AllValV[0].Val2 < MaxOutTm) {
+		const uint64 MaxOutTm = OutTmMSecsV[OutEValN - 1];
+		while (FirstValN < AllValV.Len() - 1 && AllValV[FirstValN].Val2 <= MaxOutTm) {
 			// pop front
-			AllValV.Del(0);
+			FirstValN++;
 		}
 	}
 
 	TmMSecs = InTmMSecs;
-	Max = AllValV[0].Val1;
+	Max = AllValV[FirstValN].Val1;
 }
 
 void TMax::Load(TSIn& SIn) {
@@ -157,7 +164,10 @@ void TMax::Save(TSOut& SOut) const {
 	// parameters
 	Max.Save(SOut);
 	TmMSecs.Save(SOut);
-	AllValV.Save(SOut);
+	// save only values still in the window
+	TFltUInt64PrV ValV(AllValV.Len() - FirstValN, 0);
+	for (int ValN = FirstValN; ValN < AllValV.Len(); ValN++) { ValV.Add(AllValV[ValN]); }
+	ValV.Save(SOut);
 }
 
 /////////////////////////////////////////////////
@@ -284,21 +294,22 @@ void TEma::Update(const double& Val, const uint64& NewTmMSecs) {
 
 /////////////////////////////////////////////////
 // Online Moving Standard M2 
-void TVar::Update(const double& InVal, const uint64& InTmMSecs, 
-        const TFltV& OutValV, const TUInt64V& OutTmMSecsV, const int& N) {
+void TVar::Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+        const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN, const int& N) {
 		
     pNo = N;
-    int tempN = N - 1 + OutValV.Len();
+    const int Outs = OutEValN - OutBValN;
+    int tempN = N - 1 + Outs;
     double delta;    
     
 	// check if all the values are removed	
-	if (OutValV.Len() >= tempN) {
+	if (Outs >= tempN) {
 		Ma = 0;
 		M2 = 0;
 		tempN = 0;
 	} else {
 		// remove old values from the mean
-		for (int ValN = 0; ValN < OutValV.Len(); ValN++)
+		for (int ValN = OutBValN; ValN < OutEValN; ValN++)
 		{
 			tempN--;			
 			delta = OutValV[ValN] - Ma;
@@ -328,14 +339,15 @@ void TVar::Save(TSOut& SOut) const {
 
 /////////////////////////////////////////////////
 // Online Moving Covariance (assumes X and Y have the same time stamp)
-void TCov::Update(const double& InValX, const double& InValY, const uint64& InTmMSecs, 
-        const TFltV& OutValVX, const TFltV& OutValVY, const TUInt64V& OutTmMSecsV, const int& N){
+void TCov::Update(const double& InValX, const double& InValY, const uint64& InTmMSecs,
+        const TFltV& OutValVX, const TFltV& OutValVY, const TUInt64V& OutTmMSecsV,
+        const int& OutBValN, const int& OutEValN, const int& N){
     
     pNo = N;
-    int tempN = N - 1 + OutValVX.Len();
+    int tempN = N - 1 + OutEValN - OutBValN;
     double deltaX, deltaY;    
     // remove old values from the mean
-    for (int ValN = 0; ValN < OutValVX.Len(); ValN++)
+    for (int ValN = OutBValN; ValN < OutEValN; ValN++)
     {        
         tempN--;       
         deltaX = OutValVX[ValN] - MaX;
@@ -483,46 +495,80 @@ bool TLinear::CanInterpolate(const uint64& Tm) const {
 			(Buff.Len() >= 2 && Buff.GetOldest().Val1 <= Tm && Buff.GetOldest(1).Val1 >= Tm);
 }
 
-///////////////////////////////////////////////////////////////////
-// Neural Networks - Neuron
-TRnd TNNet::TNeuron::Rnd = 0;
-
-TNNet::TNeuron::TNeuron(){
-}
+/////////////////////////////////////////////////////////////////////////
+//// Neural Networks - Layer of Neurons
+TRnd TNNet::TLayer::Rnd = 0;
 
-TNNet::TNeuron::TNeuron(TInt OutputsN, TInt MyId, TTFunc TransFunc){
+TNNet::TLayer::TLayer(const TInt& _NeuronsN, const TInt& OutputsN, const TTFunc& TransFunc): 
+        TFuncNm(TransFunc), NeuronsN(_NeuronsN), WgtVV(_NeuronsN + 1, OutputsN),
+        DeltaWgtVV(_NeuronsN + 1, OutputsN), SumDeltaWgtVV(_NeuronsN + 1, OutputsN) {
 
-    TFuncNm = TransFunc;
-    for(int c = 0; c < OutputsN; ++c){
-        // define the edges, 0 element is weight, 1 element is weight delta
-        TFlt RandWeight = RandomWeight();
-        OutEdgeV.Add(TIntFltFltTr(c, RandWeight, 0.0));
-        SumDeltaWeight.Add(0.0);
+    // random weights for edges of all neurons, including the bias neuron
+    for (int NeuronN = 0; NeuronN <= NeuronsN; ++NeuronN) {
+        for (int OutputN = 0; OutputN < OutputsN; ++OutputN) {
+            WgtVV(NeuronN, OutputN) = Rnd.GetUniDev();
+        }
     }
-
-    Id = MyId;
+    SetSamples(1);
+}
+
+TNNet::TLayer::TLayer(TSIn& SIn) {
+    TFuncNm = LoadEnum<TTFunc>(SIn);
+    NeuronsN.Load(SIn);
+    WgtVV.Load(SIn);
+    DeltaWgtVV.Load(SIn);
+    SumDeltaWgtVV.Load(SIn);
+    SetSamples(1);
+}
+
+TNNet::TLayer TNNet::TLayer::LoadNeuronLayout(TSIn& SIn) {
+    // vector of neurons, last one is the bias neuron
+    int MxNeurons, Neurons; SIn.Load(MxNeurons); SIn.Load(Neurons);
+    EAssertR(Neurons > 0, "TNNet::TLayer: layer without neurons");
+    TLayer Layer; Layer.NeuronsN = Neurons - 1;
+    for (int NeuronN = 0; NeuronN < Neurons; ++NeuronN) {
+        // output value and gradient are not needed after load
+        TFlt OutVal(SIn), Gradient(SIn);
+        Layer.TFuncNm = LoadEnum<TTFunc>(SIn);
+        TFltV SumDeltaWgtV(SIn);
+        // outgoing edges with target id, weight and weight delta
+        TVec<TIntFltFltTr> OutEdgeV(SIn);
+        TInt Id(SIn);
+        if (NeuronN == 0) {
+            Layer.WgtVV.Gen(Neurons, OutEdgeV.Len());
+            Layer.DeltaWgtVV.Gen(Neurons, OutEdgeV.Len());
+            Layer.SumDeltaWgtVV.Gen(Neurons, OutEdgeV.Len());
+        }
+        EAssertR(OutEdgeV.Len() == Layer.WgtVV.GetCols(), "TNNet::TLayer: neurons with different number of edges");
+        for (int EdgeN = 0; EdgeN < OutEdgeV.Len(); ++EdgeN) {
+            Layer.WgtVV(NeuronN, EdgeN) = OutEdgeV[EdgeN].Val2;
+            Layer.DeltaWgtVV(NeuronN, EdgeN) = OutEdgeV[EdgeN].Val3;
+            Layer.SumDeltaWgtVV(NeuronN, EdgeN) = SumDeltaWgtV[EdgeN];
+        }
+    }
+    Layer.SetSamples(1);
+    return Layer;
 }
-TNNet::TNeuron::TNeuron(TSIn& SIn){
-	OutputVal.Load(SIn);
-	Gradient.Load(SIn);
-	TFuncNm = LoadEnum<TTFunc>(SIn);
-    SumDeltaWeight.Load(SIn);
-    OutEdgeV.Load(SIn);
-    Id.Load(SIn);
+
+void TNNet::TLayer::Save(TSOut& SOut) const {
+    SaveEnum<TTFunc>(SOut, TFuncNm);
+    NeuronsN.Save(SOut);
+    WgtVV.Save(SOut);
+    DeltaWgtVV.Save(SOut);
+    SumDeltaWgtVV.Save(SOut);
 }
 
-void TNNet::TNeuron::FeedFwd(const TLayer& PrevLayer){
-    TFlt SumIn = 0.0;
-    // get the previous layer's outputs and sum them up
-    for(int NeuronN = 0; NeuronN < PrevLayer.GetNeuronN(); ++NeuronN){
-        SumIn += PrevLayer.GetOutVal(NeuronN) * 
-                PrevLayer.GetWeight(NeuronN, Id);
+void TNNet::TLayer::SetSamples(const int& SamplesN) {
+    if (OutValVV.GetRows() == SamplesN && OutValVV.GetCols() == NeuronsN + 1) { return; }
+    OutValVV.Gen(SamplesN, NeuronsN + 1);
+    GradientVV.Gen(SamplesN, NeuronsN);
+    // Force the bias node's output value to 1.0
+    for (int SampleN = 0; SampleN < SamplesN; ++SampleN) {
+        OutValVV(SampleN, NeuronsN) = 1.0;
     }
-    // not sure if static. maybe different fcn for output nodes
-    OutputVal = TNeuron::TransferFcn(SumIn);
 }
 
-TFlt TNNet::TNeuron::TransferFcn(TFlt Sum){
+double TNNet::TLayer::TransferFcn(const double& Sum) const {
     switch (TFuncNm){
         case tanHyper:
             // tanh output range [-1.0..1.0]
@@ -538,18 +584,18 @@ TFlt TNNet::TNeuron::TransferFcn(TFlt Sum){
         case fastTanh:
            // sigmoid output range [-1.0..1.0]
            // training data should be scaled to what the transfer function can handle
-           return Sum / (1.0 + abs(Sum));
+           return Sum / (1.0 + TFlt::Abs(Sum));
         case fastSigmoid:
            // sigmoid output range [0.0..1.0]
            // training data should be scaled to what the transfer function can handle
-           return (Sum / 2.0) / (1.0 + abs(Sum)) + 0.5;
+           return (Sum / 2.0) / (1.0 + TFlt::Abs(Sum)) + 0.5;
         case linear:
             return Sum;         
     };
     throw TExcept::New("Unknown transfer function type");
 }
 
-TFlt TNNet::TNeuron::TransferFcnDeriv(TFlt Sum){
+double TNNet::TLayer::TransferFcnDeriv(const double& Sum) const {
     switch (TFuncNm){
         case tanHyper:
             // tanh derivative approximation
@@ -562,103 +608,115 @@ TFlt TNNet::TNeuron::TransferFcnDeriv(TFlt Sum){
            return Fun * (1.0 - Fun);
         }
         case fastTanh:
-           return 1.0 / ((1.0 + abs(Sum)) * (1.0 + abs(Sum)));
+           return 1.0 / ((1.0 + TFlt::Abs(Sum)) * (1.0 + TFlt::Abs(Sum)));
         case fastSigmoid:
-           return 1.0 / (2.0 * (1.0 + abs(Sum)) * (1.0 + abs(Sum)));
+           return 1.0 / (2.0 * (1.0 + TFlt::Abs(Sum)) * (1.0 + TFlt::Abs(Sum)));
         case linear:
             return 1;         
     };
     throw TExcept::New("Unknown transfer function type");
 }
 
-void TNNet::TNeuron::CalcOutGradient(TFlt TargVal){
-    TFlt Delta = TargVal - OutputVal;
-    // TODO: different ways of calculating gradients
-    Gradient = Delta * TNeuron::TransferFcnDeriv(OutputVal);
+void TNNet::TLayer::SetOutVal(const TFltVV& InValVV) {
+    // check if number of input values same as number of input neurons
+    EAssertR(InValVV.GetCols() == NeuronsN, "Number of input values must match number of input neurons");
+    SetSamples(InValVV.GetRows());
+    for (int SampleN = 0; SampleN < InValVV.GetRows(); ++SampleN) {
+        for (int NeuronN = 0; NeuronN < NeuronsN; ++NeuronN) {
+            OutValVV(SampleN, NeuronN) = InValVV(SampleN, NeuronN);
+        }
+    }
 }
 
-void TNNet::TNeuron::CalcHiddenGradient(const TLayer& NextLayer){
-    // calculate error by summing the derivatives of the weights next layer
-    TFlt DerivsOfWeights = SumDOW(NextLayer);
-    Gradient = DerivsOfWeights * TNeuron::TransferFcnDeriv(OutputVal);
+void TNNet::TLayer::FeedFwd(const TLayer& PrevLayer) {
+    const int SamplesN = PrevLayer.GetSamplesN();
+    SetSamples(SamplesN);
+    // sum up the previous layer's outputs for all samples at once
+    if (TmpVV.GetRows() != SamplesN || TmpVV.GetCols() != NeuronsN) { TmpVV.Gen(SamplesN, NeuronsN); }
+    TLinAlg::Multiply(PrevLayer.OutValVV, PrevLayer.WgtVV, TmpVV);
+    for (int SampleN = 0; SampleN < SamplesN; ++SampleN) {
+        for (int NeuronN = 0; NeuronN < NeuronsN; ++NeuronN) {
+            OutValVV(SampleN, NeuronN) = TransferFcn(TmpVV(SampleN, NeuronN));
+        }
+    }
 }
 
-TFlt TNNet::TNeuron::SumDOW(const TLayer& NextLayer) const{
-    TFlt sum = 0.0;
-    // sum our contributions of the errors at the nodes we feed
-    for(int NeuronN = 0; NeuronN < NextLayer.GetNeuronN() - 1; ++NeuronN){
-        // weight from us to next layer neuron times its gradient
-        sum += GetWeight(NeuronN) * NextLayer.GetGradient(NeuronN);
+void TNNet::TLayer::CalcOutGradient(const TFltVV& TargValVV) {
+    EAssertR(TargValVV.GetRows() == GetSamplesN() && TargValVV.GetCols() == NeuronsN, 
+        "Target values must match the outputs of the last feed forward step");
+    for (int SampleN = 0; SampleN < GetSamplesN(); ++SampleN) {
+        for (int NeuronN = 0; NeuronN < NeuronsN; ++NeuronN) {
+            const double OutVal = OutValVV(SampleN, NeuronN);
+            const double Delta = TargValVV(SampleN, NeuronN) - OutVal;
+            // TODO: different ways of calculating gradients
+            GradientVV(SampleN, NeuronN) = Delta * TransferFcnDeriv(OutVal);
+        }
     }
+}
+
+void TNNet::TLayer::CalcHiddenGradient(const TLayer& NextLayer) {
+    const int SamplesN = GetSamplesN();
+    // sum derivatives of weights in the next layer, weight from 
+    // us to next layer neuron times its gradient
+    if (TmpVV.GetRows() != SamplesN || TmpVV.GetCols() != NeuronsN + 1) { TmpVV.Gen(SamplesN, NeuronsN + 1); }
+#ifdef BLAS
+    TLinAlg::Multiply(NextLayer.GradientVV, WgtVV, TmpVV, TLinAlg::TLinAlgBlasTranspose::NOTRANS, 
+        TLinAlg::TLinAlgBlasTranspose::TRANS);
+#else
+    // rows of both matrices are contiguous, so no need to transpose the weights
+    const int OutputsN = WgtVV.GetCols();
+    for (int SampleN = 0; SampleN < SamplesN; ++SampleN) {
+        const TFlt* NextGradV = &NextLayer.GradientVV(SampleN, 0);
+        for (int NeuronN = 0; NeuronN < NeuronsN; ++NeuronN) {
+            const TFlt* WgtV = &WgtVV(NeuronN, 0);
+            double Sum = 0.0;
+            for (int OutputN = 0; OutputN < OutputsN; ++OutputN) {
+                Sum += WgtV[OutputN].Val * NextGradV[OutputN].Val;
+            }
+            TmpVV(SampleN, NeuronN) = Sum;
+        }
+    }
+#endif
+    for (int SampleN = 0; SampleN < SamplesN; ++SampleN) {
+        for (int NeuronN = 0; NeuronN < NeuronsN; ++NeuronN) {
+            GradientVV(SampleN, NeuronN) = TmpVV(SampleN, NeuronN) * 
+                TransferFcnDeriv(OutValVV(SampleN, NeuronN));
+        }
+    }
+}
+
+void TNNet::TLayer::UpdateOutputWeights(const TLayer& NextLayer, const TFlt& LearnRate, 
+        const TFlt& Momentum, const TBool& UpdateWeights) {
 
-    return sum;
-}
-
-void TNNet::TNeuron::UpdateInputWeights(TLayer& PrevLayer, const TFlt& LearnRate, const TFlt& Momentum, const TBool& UpdateWeights){
-    // the weights to be updated are in the OutEdgeV
-    // in the neurons in the preceding layer
-    for(int NeuronN = 0; NeuronN < PrevLayer.GetNeuronN(); ++NeuronN){
-        TNeuron& Neuron = PrevLayer.GetNeuron(NeuronN);
-        TFlt OldDeltaWeight = Neuron.GetDeltaWeight(Id);
-        //TFlt OldWeight = Neuron.GetWeight(Id);
-        TFlt OldSumDeltaWeight = Neuron.GetSumDeltaWeight(Id);
-        
-        TFlt NewDeltaWeight = 
-                // individual input magnified by the gradient and train rate
-                LearnRate
-                * Neuron.GetOutVal()
-                * Gradient
+    // individual inputs magnified by the gradients, summed over all samples
+    if (TmpVV.GetRows() != WgtVV.GetRows() || TmpVV.GetCols() != WgtVV.GetCols()) { 
+        TmpVV.Gen(WgtVV.GetRows(), WgtVV.GetCols()); }
+    TLinAlg::MultiplyT(OutValVV, NextLayer.GradientVV, TmpVV);
+
+    TFltV& WgtV = WgtVV.Get1DVec();
+    TFltV& DeltaWgtV = DeltaWgtVV.Get1DVec();
+    TFltV& SumDeltaWgtV = SumDeltaWgtVV.Get1DVec();
+    const TFltV& GradDeltaWgtV = TmpVV.Get1DVec();
+    for (int EdgeN = 0; EdgeN < WgtV.Len(); ++EdgeN) {
+        const double OldDeltaWeight = DeltaWgtV[EdgeN];
+        const double OldSumDeltaWeight = SumDeltaWgtV[EdgeN];
+        double NewDeltaWeight = LearnRate * GradDeltaWgtV[EdgeN]
                 // add momentum = fraction of previous delta weight, if we are not in batch mode
-                + (UpdateWeights  && OldSumDeltaWeight == 0.0 ? Momentum : TFlt())
+                + (UpdateWeights && OldSumDeltaWeight == 0.0 ? Momentum.Val : 0.0)
                 * OldDeltaWeight;
-        
-        if(UpdateWeights){
-            if(OldSumDeltaWeight != 0.0){
+
+        if (UpdateWeights) {
+            if (OldSumDeltaWeight != 0.0) {
                 NewDeltaWeight = OldSumDeltaWeight + NewDeltaWeight;
-                Neuron.SetSumDeltaWeight(Id, 0.0);
+                SumDeltaWgtV[EdgeN] = 0.0;
             }
-            Neuron.SetDeltaWeight(Id, NewDeltaWeight);
-            Neuron.UpdateWeight(Id, NewDeltaWeight);
-       }
-        else{
-            Neuron.SumDeltaWeights(Id, NewDeltaWeight);
+            DeltaWgtV[EdgeN] = NewDeltaWeight;
+            WgtV[EdgeN] += NewDeltaWeight;
+        } else {
+            SumDeltaWgtV[EdgeN] += NewDeltaWeight;
         }
     }
 }
-void TNNet::TNeuron::Save(TSOut& SOut) {
-	OutputVal.Save(SOut);
-	Gradient.Save(SOut);
-    SaveEnum<TTFunc>(SOut, TFuncNm);
-    SumDeltaWeight.Save(SOut);
-    OutEdgeV.Save(SOut);
-    Id.Save(SOut);
-}
-    
-/////////////////////////////////////////////////////////////////////////
-//// Neural Networks - Layer of Neurons
-// TODO: why do we need this empty constructor?
-TNNet::TLayer::TLayer(){
-}
-
-TNNet::TLayer::TLayer(const TInt& NeuronsN, const TInt& OutputsN, const TTFunc& TransFunc){
-    // Add neurons to the layer, plus bias neuron
-    for(int NeuronN = 0; NeuronN <= NeuronsN; ++NeuronN){
-        NeuronV.Add(TNeuron(OutputsN, NeuronN, TransFunc));
-        printf("Made a neuron!");
-        printf(" Neuron N: %d", NeuronN);
-        printf(" Neuron H: %d", NeuronV.Len());
-        printf("\n");
-    } 
-    // Force the bias node's output value to 1.0
-    NeuronV.Last().SetOutVal(1.0);
-    printf("\n");
-}
-TNNet::TLayer::TLayer(TSIn& SIn){
-	NeuronV.Load(SIn);
-}
-void TNNet::TLayer::Save(TSOut& SOut) {
-	NeuronV.Save(SOut);
-}
 
 /////////////////////////////////////////////////////////////////////////
 //// Neural Networks - Neural Net
@@ -679,14 +737,27 @@ TNNet::TNNet(const TIntV& LayoutV, const TFlt& _LearnRate,
         TInt NeuronsN = LayoutV[LayerN];
         // Add a layer to the net
         LayerV.Add(TLayer(NeuronsN, OutputsN, TransFunc));
-        printf("LayerV.Len(): %d \n", LayerV.Len() );
     }
 }
 
-TNNet::TNNet(TSIn& SIn):
-		LearnRate(SIn),
-		Momentum(SIn) {
-	LayerV.Load(SIn);
+TNNet::TNNet(TSIn& SIn) {
+    // versioned models start with a negative tag, older ones with the learn rate
+    TFlt Tag(SIn);
+    if (Tag < 0.0) {
+        TInt Version(SIn);
+        EAssertR(Version == 1, TStr::Fmt("TNNet: unknown model version %d", Version.Val));
+        LearnRate.Load(SIn);
+        Momentum.Load(SIn);
+        LayerV.Load(SIn);
+    } else {
+        // layers are saved as vectors of neurons
+        LearnRate = Tag;
+        Momentum.Load(SIn);
+        int MxLayers, Layers; SIn.Load(MxLayers); SIn.Load(Layers);
+        for (int LayerN = 0; LayerN < Layers; ++LayerN) {
+            LayerV.Add(TLayer::LoadNeuronLayout(SIn));
+        }
+    }
 }
 
 PNNet TNNet::Load(TSIn& SIn) {
@@ -694,74 +765,83 @@ PNNet TNNet::Load(TSIn& SIn) {
 }
 
 void TNNet::FeedFwd(const TFltV& InValV){
-    // check if number of input values same as number of input neurons
-    Assert(InValV.Len() == LayerV[0].GetNeuronN() - 1);
-    // assign input values to input neurons
-    for(int InputN = 0; InputN < InValV.Len(); ++InputN){
-        LayerV[0].SetOutVal(InputN, InValV[InputN]);
+    TFltVV InValVV(1, InValV.Len());
+    for (int InputN = 0; InputN < InValV.Len(); ++InputN) {
+        InValVV(0, InputN) = InValV[InputN];
     }
+    FeedFwd(InValVV);
+}
 
+void TNNet::FeedFwd(const TFltVV& InValVV){
+    // assign input values to input neurons
+    LayerV[0].SetOutVal(InValVV);
     // forward propagation
     for(int LayerN = 1; LayerN < LayerV.Len(); ++LayerN){
-        TLayer& PrevLayer = LayerV[LayerN - 1];
-        for(int NeuronN = 0; NeuronN < LayerV[LayerN].GetNeuronN() - 1; ++NeuronN){
-            LayerV[LayerN].FeedFwd(NeuronN, PrevLayer);
-        }
+        LayerV[LayerN].FeedFwd(LayerV[LayerN - 1]);
     }
 }
 
 void TNNet::BackProp(const TFltV& TargValV, const TBool& UpdateWeights){
-    // calculate overall net error (RMS of output neuron errors)
+    TFltVV TargValVV(1, TargValV.Len());
+    for (int OutputN = 0; OutputN < TargValV.Len(); ++OutputN) {
+        TargValVV(0, OutputN) = TargValV[OutputN];
+    }
+    BackProp(TargValVV, UpdateWeights);
+}
+
+void TNNet::BackProp(const TFltVV& TargValVV, const TBool& UpdateWeights){
+    // Calculate output layer gradients
     TLayer& OutputLayer = LayerV.Last();
+    OutputLayer.CalcOutGradient(TargValVV);
+    // calculate overall net error (RMS of output neuron errors, averaged over samples)
     Error = 0.0;
-
-    for(int NeuronN = 0; NeuronN < OutputLayer.GetNeuronN() - 1; ++NeuronN){
-        TFlt Delta = TargValV[NeuronN] - OutputLayer.GetOutVal(NeuronN);
-        Error += Delta * Delta;
+    for (int SampleN = 0; SampleN < OutputLayer.GetSamplesN(); ++SampleN) {
+        double SampleError = 0.0;
+        for (int NeuronN = 0; NeuronN < OutputLayer.GetNeuronN(); ++NeuronN) {
+            const double Delta = TargValVV(SampleN, NeuronN) - OutputLayer.GetOutVal(SampleN, NeuronN);
+            SampleError += Delta * Delta;
+        }
+        Error += sqrt(SampleError / OutputLayer.GetNeuronN()); // RMS
     }
-    Error /= OutputLayer.GetNeuronN() - 1;
-    Error = sqrt(Error); // RMS
+    Error /= OutputLayer.GetSamplesN();
     
     // recent avg error measurement
     RecentAvgError = (RecentAvgError * RecentAvgSmoothingFactor + Error)
             / (RecentAvgSmoothingFactor + 1.0);
-    // Calculate output layer gradients
-    for(int NeuronN = 0; NeuronN < OutputLayer.GetNeuronN() - 1; ++NeuronN){
-        OutputLayer.CalcOutGradient(NeuronN, TargValV[NeuronN]);
-    }        
     // Calculate gradients on hidden layers
     for(int LayerN = LayerV.Len() - 2; LayerN > 0; --LayerN){
-        TLayer& HiddenLayer = LayerV[LayerN];
-        TLayer& NextLayer = LayerV[LayerN + 1];
-
-        for(int NeuronN = 0; NeuronN < HiddenLayer.GetNeuronN() - 1; ++NeuronN){
-            HiddenLayer.CalcHiddenGradient(NeuronN, NextLayer);
-        }
-
+        LayerV[LayerN].CalcHiddenGradient(LayerV[LayerN + 1]);
     }
     // For all layers from output to first hidden layer
     // update connection weights
     for(int LayerN = LayerV.Len() - 1; LayerN > 0; --LayerN){
-        TLayer& Layer = LayerV[LayerN];
-        TLayer& PrevLayer = LayerV[LayerN - 1];
-
-        for(int NeuronN = 0; NeuronN < Layer.GetNeuronN() - 1; ++NeuronN){
-            Layer.UpdateInputWeights(NeuronN, PrevLayer, LearnRate, Momentum, UpdateWeights);
-        }
+        LayerV[LayerN - 1].UpdateOutputWeights(LayerV[LayerN], LearnRate, Momentum, UpdateWeights);
     }
 }
 
 void TNNet::GetResults(TFltV& ResultV) const{
     ResultV.Clr(true, -1);
 
-    for(int NeuronN = 0; NeuronN < LayerV.Last().GetNeuronN() - 1; ++NeuronN){
-        ResultV.Add(LayerV.Last().GetOutVal(NeuronN));
+    for(int NeuronN = 0; NeuronN < LayerV.Last().GetNeuronN(); ++NeuronN){
+        ResultV.Add(LayerV.Last().GetOutVal(0, NeuronN));
+    }
+}
+
+void TNNet::GetResults(TFltVV& ResultVV) const{
+    const TLayer& OutputLayer = LayerV.Last();
+    ResultVV.Gen(OutputLayer.GetSamplesN(), OutputLayer.GetNeuronN());
+    for (int SampleN = 0; SampleN < OutputLayer.GetSamplesN(); ++SampleN) {
+        for (int NeuronN = 0; NeuronN < OutputLayer.GetNeuronN(); ++NeuronN) {
+            ResultVV(SampleN, NeuronN) = OutputLayer.GetOutVal(SampleN, NeuronN);
+        }
     }
 }
 
 void TNNet::Save(TSOut& SOut) const {
 
-	// Save model variables
+	// Save version tag and model variables
+	TFlt(-1.0).Save(SOut);
+	TInt(1).Save(SOut);
 	LearnRate.Save(SOut);
 	Momentum.Save(SOut);
 	LayerV.Save(SOut);
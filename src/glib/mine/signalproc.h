@@ -34,7 +34,11 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void Update(const double& InVal, const uint64& InTmMSecs, 
-        const TFltV& OutValV, const TUInt64V& OutTmMSecs, const int& N);	
+        const TFltV& OutValV, const TUInt64V& OutTmMSecs, const int& N) {
+        Update(InVal, InTmMSecs, OutValV, OutTmMSecs, 0, OutValV.Len(), N); }
+    // outgoing values are OutValV[OutBValN], ..., OutValV[OutEValN - 1]
+	void Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+        const TUInt64V& OutTmMSecs, const int& OutBValN, const int& OutEValN, const int& N);
 	double GetMa() const { return Ma; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
 };
@@ -55,7 +59,11 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void Update(const double& InVal, const uint64& InTmMSecs,
-		const TFltV& OutValV, const TUInt64V& OutTmMSecs);
+		const TFltV& OutValV, const TUInt64V& OutTmMSecs) {
+		Update(InVal, InTmMSecs, OutValV, OutTmMSecs, 0, OutValV.Len()); }
+	// outgoing values are OutValV[OutBValN], ..., OutValV[OutEValN - 1]
+	void Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+		const TUInt64V& OutTmMSecs, const int& OutBValN, const int& OutEValN);
 	double GetSum() const { return Sum; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
 };
@@ -67,6 +75,7 @@ private:
 	TFlt Min; // current computed SUM value 
 	TUInt64 TmMSecs; // timestamp of current MA	   
 	TFltUInt64PrV AllValV; // sorted vector of values	
+	TInt FirstValN; // position of the first value still in the window
 public:
 	TMin() { Min = TFlt::Mx; TmMSecs = 0; };
 	TMin(TSIn& SIn) : Min(SIn), TmMSecs(SIn), AllValV(SIn) { }
@@ -76,7 +85,11 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void Update(const double& InVal, const uint64& InTmMSecs,
-		const TFltV& OutValV, const TUInt64V& OutTmMSecs);
+		const TFltV& OutValV, const TUInt64V& OutTmMSecs) {
+		Update(InVal, InTmMSecs, OutValV, OutTmMSecs, 0, OutValV.Len()); }
+	// outgoing values are OutValV[OutBValN], ..., OutValV[OutEValN - 1]
+	void Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+		const TUInt64V& OutTmMSecs, const int& OutBValN, const int& OutEValN);
 	double GetMin() const { return Min; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
 };
@@ -88,6 +101,7 @@ private:
 	TFlt Max; // current computed SUM value 
 	TUInt64 TmMSecs; // timestamp of current MA	   
 	TFltUInt64PrV AllValV; // sorted vector of values	
+	TInt FirstValN; // position of the first value still in the window
 public:
 	TMax() { Max = TFlt::Mn; TmMSecs = 0; };
 	TMax(TSIn& SIn) : Max(SIn), TmMSecs(SIn), AllValV(SIn) { }
@@ -97,7 +111,11 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void Update(const double& InVal, const uint64& InTmMSecs,
-		const TFltV& OutValV, const TUInt64V& OutTmMSecs);
+		const TFltV& OutValV, const TUInt64V& OutTmMSecs) {
+		Update(InVal, InTmMSecs, OutValV, OutTmMSecs, 0, OutValV.Len()); }
+	// outgoing values are OutValV[OutBValN], ..., OutValV[OutEValN - 1]
+	void Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+		const TUInt64V& OutTmMSecs, const int& OutBValN, const int& OutEValN);
 	double GetMax() const { return Max; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
 };
@@ -157,7 +175,11 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void Update(const double& InVal, const uint64& InTmMSecs, 
-        const TFltV& OutValV, const TUInt64V& OutTmMSecsV, const int& N);
+        const TFltV& OutValV, const TUInt64V& OutTmMSecsV, const int& N) {
+        Update(InVal, InTmMSecs, OutValV, OutTmMSecsV, 0, OutValV.Len(), N); }
+    // outgoing values are OutValV[OutBValN], ..., OutValV[OutEValN - 1]
+	void Update(const double& InVal, const uint64& InTmMSecs, const TFltV& OutValV,
+        const TUInt64V& OutTmMSecsV, const int& OutBValN, const int& OutEValN, const int& N);
 	// current status	
 	double GetM2() const { return M2 / pNo; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
@@ -176,7 +198,12 @@ public:
     TCov(const PJsonVal& ParamVal) { TCov(); };
 
 	void Update(const double& InValX, const double& InValY, const uint64& InTmMSecs, 
-        const TFltV& OutValVX, const TFltV& OutValVY, const TUInt64V& OutTmMSecsV, const int& N);	
+        const TFltV& OutValVX, const TFltV& OutValVY, const TUInt64V& OutTmMSecsV, const int& N) {
+        Update(InValX, InValY, InTmMSecs, OutValVX, OutValVY, OutTmMSecsV, 0, OutValVX.Len(), N); }
+    // outgoing values are OutValV*[OutBValN], ..., OutValV*[OutEValN - 1]
+	void Update(const double& InValX, const double& InValY, const uint64& InTmMSecs,
+        const TFltV& OutValVX, const TFltV& OutValVY, const TUInt64V& OutTmMSecsV,
+        const int& OutBValN, const int& OutEValN, const int& N);
 	double GetCov() const { return Cov/pNo; }
 	uint64 GetTmMSecs() const { return TmMSecs; }
 };
@@ -462,78 +489,56 @@ typedef enum { tanHyper, sigmoid, fastTanh, fastSigmoid, linear, softPlus } TTFu
 ClassTP(TNNet, PNNet) //{
 private:
     /////////////////////////////////////////
-    // Neural Networks - Neuron
-    class TLayer;    
-    class TNeuron {
+    // Neural Networks - Layer of neurons
+    // Weights of the edges going out of the layer are kept in a dense matrix with 
+    // one row per neuron (last row is the bias neuron) and one column per neuron 
+    // in the next layer. Outputs and gradients are kept in matrices with one row 
+    // per sample, so passes over a mini-batch are matrix products.
+    class TLayer {
     private:
         static TRnd Rnd; //TODO: initialize it in the constructor with the 0
 
-        TFlt RandomWeight(void) { return TFlt(Rnd.GetUniDev()); }
-        TFlt TransferFcn(TFlt Sum);
-        TFlt TransferFcnDeriv(TFlt Sum); // for back propagation learning
-        // sum derivatives of weights in the next layer
-        TFlt SumDOW(const TLayer& NextLayer) const;
-        TFlt OutputVal;
-        TFlt Gradient;
         TTFunc TFuncNm; // transfer function name
-        TFltV SumDeltaWeight;
-        // hash containing weight[0] and delta weight[1] for each outgoing edge
-        TVec<TIntFltFltTr> OutEdgeV; 
-        // Id of this neuron
-        TInt Id;
+        // number of neurons, without the bias neuron
+        TInt NeuronsN;
+        // weight, last weight delta and delta summed in batch mode for each outgoing edge
+        TFltVV WgtVV;
+        TFltVV DeltaWgtVV;
+        TFltVV SumDeltaWgtVV;
+        // outputs of the neurons for each sample, last column is the bias
+        TFltVV OutValVV;
+        // gradients of the neurons for each sample
+        TFltVV GradientVV;
+        // scratch space for matrix products
+        TFltVV TmpVV;
+
+        double TransferFcn(const double& Sum) const;
+        double TransferFcnDeriv(const double& Sum) const; // for back propagation learning
+        // prepare output and gradient matrices for the given number of samples
+        void SetSamples(const int& SamplesN);
 
     public:
-        TNeuron();
-        TNeuron(TInt OutputsN, TInt MyId, TTFunc TransFunc);
-        TNeuron(TSIn& SIn);
-
-        void SetOutVal(const TFlt& Val) { OutputVal = Val; }
-        void SetDeltaWeight(const TInt& InNodeId, const TFlt& Val) { OutEdgeV[InNodeId].Val3 = Val; }
-        void SetSumDeltaWeight(const TInt& InNodeId, const TFlt& Val) { SumDeltaWeight[InNodeId] = Val; }
-        void SumDeltaWeights(const TInt& InNodeId, const TFlt& Val) { SumDeltaWeight[InNodeId] += Val; }
-        void UpdateWeight(const TInt& InNodeId, const TFlt& Val) { OutEdgeV[InNodeId].Val2 += Val; }
-        void UpdateInputWeights(TLayer& PrevLayer, const TFlt& LearnRate, const TFlt& Momentum, const TBool& UpdateWeights);
-
-        TFlt GetOutVal(void) const { return OutputVal; }
-        TFlt GetGradient(void) const { return Gradient; }
-        TFlt GetDeltaWeight(const TInt& InNodeId) { return OutEdgeV[InNodeId].Val3; };
-        TFlt GetWeight(const TInt& InNodeId) const { return OutEdgeV[InNodeId].Val2; };
-        TFlt GetSumDeltaWeight(const TInt& InNodeId) const { return SumDeltaWeight[InNodeId]; };
-
-        void FeedFwd(const TLayer& PrevLayer);
-        void CalcOutGradient(TFlt TargVal);
-        void CalcHiddenGradient(const TLayer& NextLayer);
-        // Save the model
-        void Save(TSOut& SOut);
-    };
-
-    /////////////////////////////////////////
-    // Neural Networks - Layer of neurons
-    class TLayer {
-    private:
-        TVec<TNeuron> NeuronV;
-
-    public:
-        TLayer();
+        TLayer() { }
         TLayer(const TInt& NeuronsN, const TInt& OutputsN, const TTFunc& TransFunc);
         TLayer(TSIn& SIn);
+        // load layer saved as a vector of neurons, before weights were kept in matrices
+        static TLayer LoadNeuronLayout(TSIn& SIn);
 
-        int GetNeuronN() const { return NeuronV.Len(); };
-        TNeuron& GetNeuron(const TInt& NeuronN) { return NeuronV[NeuronN]; };
-        TFlt GetOutVal(const TInt& NeuronN) const { return NeuronV[NeuronN].GetOutVal(); };
-        TFlt GetGradient(const TInt& NeuronN) const { return NeuronV[NeuronN].GetGradient(); };
-        TFlt GetWeight(const TInt& NeuronN, const TInt TargetId) const { return NeuronV[NeuronN].GetWeight(TargetId); };
-
-        void SetOutVal(const TInt& NeuronN, const TFlt& Val) { NeuronV[NeuronN].SetOutVal(Val); };
-        void UpdateInputWeights(const TInt& NeuronN, TLayer& PrevLayer,
-        const TFlt& LearnRate, const TFlt& Momentum,
-        const TBool& UpdateWeights) { NeuronV[NeuronN].UpdateInputWeights(PrevLayer, LearnRate, Momentum, UpdateWeights); };
+        int GetNeuronN() const { return NeuronsN; }
+        int GetSamplesN() const { return OutValVV.GetRows(); }
+        TFlt GetOutVal(const int& SampleN, const int& NeuronN) const { return OutValVV(SampleN, NeuronN); }
+        TFlt GetWeight(const int& NeuronN, const int& TargetId) const { return WgtVV(NeuronN, TargetId); }
 
-        void CalcOutGradient(int& NeuronN, const TFlt& TargVal) { NeuronV[NeuronN].CalcOutGradient(TargVal); };
-        void CalcHiddenGradient(int& NeuronN, const TLayer& NextLayer) { NeuronV[NeuronN].CalcHiddenGradient(NextLayer); };
-        void FeedFwd(const TInt& NeuronN, const TLayer& PrevLayer) { NeuronV[NeuronN].FeedFwd(PrevLayer); };
+        // set outputs of the input layer, one row per sample
+        void SetOutVal(const TFltVV& InValVV);
+        void FeedFwd(const TLayer& PrevLayer);
+        void CalcOutGradient(const TFltVV& TargValVV);
+        void CalcHiddenGradient(const TLayer& NextLayer);
+        // update weights of edges going into the next layer
+        void UpdateOutputWeights(const TLayer& NextLayer, const TFlt& LearnRate, 
+            const TFlt& Momentum, const TBool& UpdateWeights);
         // Save the model
-        void Save(TSOut& SOut);
+        void Save(TSOut& SOut) const;
     };
 
     TVec<TLayer> LayerV; 
@@ -557,10 +562,16 @@ public:
 	static PNNet Load(TSIn& SIn);
     // Feed forward step
     void FeedFwd(const TFltV& InValV);
+    // Feed forward step for a mini-batch, one sample per row
+    void FeedFwd(const TFltVV& InValVV);
     // Back propagation step
     void BackProp(const TFltV& TargValV, const TBool& UpdateWeights = true);
-    // TODO: try to make backprop in less for loops
+    // Back propagation step for the mini-batch from the last feed forward step, 
+    // one sample per row; deltas of all samples are summed
+    void BackProp(const TFltVV& TargValVV, const TBool& UpdateWeights = true);
     void GetResults(TFltV& ResultV) const;
+    // Results for the mini-batch, one sample per row
+    void GetResults(TFltVV& ResultVV) const;
     // Set learn rate
     void SetLearnRate(const TFlt& NewLearnRate) { LearnRate = NewLearnRate; };
     // Save the model
@@ -57,6 +57,8 @@ public:
 
   TStemmerType GetStemmerType(){
     return (TStemmerType)(int)StemmerType;}
+  // stemming with real words updates the stem-to-word map
+  bool IsRealWordP() const {return RealWordP;}
 
   // stemmer creators
   static void GetStemmerTypeNmV(TStrV& StemmerTypeNmV, TStrV& StemmerTypeDNmV);
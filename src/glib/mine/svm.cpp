@@ -19,4 +19,91 @@
 
 namespace TSvm {
 
+///////////////////////////////////////////////////////////////////////////////
+// Linear model
+void TLinModel::Predict(const TFltVV& Mat, TFltV& PredV) const {
+    const int Cols = Mat.GetCols();
+    PredV.Gen(Cols);
+    #pragma omp parallel for
+    for (int ColN = 0; ColN < Cols; ColN++) {
+        PredV[ColN] = TLinAlg::DotProduct(Mat, ColN, WgtV) + Bias;
+    }
+}
+
+void TLinModel::Predict(const TVec<TIntFltKdV>& SpMat, TFltV& PredV) const {
+    const int Cols = SpMat.Len();
+    PredV.Gen(Cols);
+    #pragma omp parallel for
+    for (int ColN = 0; ColN < Cols; ColN++) {
+        PredV[ColN] = TLinAlg::DotProduct(WgtV, SpMat[ColN]) + Bias;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scaled weight vector
+TScaledWgtV::TScaledWgtV(const TFltV& _WgtV): WgtV(_WgtV), Scale(1.0), SqNorm(0.0) {
+    SqNorm = TLinAlg::Norm2(WgtV);
+}
+
+void TScaledWgtV::Rescale() {
+    TLinAlg::MultiplyScalar(Scale, WgtV, WgtV);
+    SqNorm = TLinAlg::Norm2(WgtV);
+    Scale = 1.0;
+}
+
+double TScaledWgtV::DotProduct(const TIntFltKdV& SpV) const {
+    return Scale * TLinAlg::DotProduct(WgtV, SpV);
+}
+
+void TScaledWgtV::AddVec(const double& k, const TIntFltKdV& SpV) {
+    const double UnscaledK = k / Scale;
+    for (int ElN = 0; ElN < SpV.Len(); ElN++) {
+        TFlt& Wgt = WgtV[SpV[ElN].Key];
+        const double NewWgt = Wgt + UnscaledK * SpV[ElN].Dat;
+        SqNorm += NewWgt * NewWgt - Wgt * Wgt;
+        Wgt = NewWgt;
+    }
+}
+
+void TScaledWgtV::MultiplyScalar(const double& k) {
+    if (k == 0.0) {
+        WgtV.PutAll(0.0); Scale = 1.0; SqNorm = 0.0;
+        return;
+    }
+    Scale *= k;
+    // keep the scale away from underflow, this also resets the
+    // numerical drift of the incrementally maintained norm
+    if (TFlt::Abs(Scale) < 1e-9 || TFlt::Abs(Scale) > 1e9) { Rescale(); }
+}
+
+void TScaledWgtV::GetWgtV(TFltV& _WgtV) const {
+    _WgtV.Gen(WgtV.Len());
+    TLinAlg::MultiplyScalar(Scale, WgtV, _WgtV);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Solver weight vectors
+double TDenseWgtV::Project(const double& Lambda) {
+    // project the current solution on to a ball
+    const double WgtNorm = 1.0 / (TLinAlg::Norm(NewWgtV) * TMath::Sqrt(Lambda));
+    if (WgtNorm < 1.0) { TLinAlg::MultiplyScalar(WgtNorm, NewWgtV, NewWgtV); }
+    // compute the difference with respect to the previous iteration
+    const double Diff = 2.0 * TLinAlg::EuclDist(WgtV, NewWgtV) / (TLinAlg::Norm(WgtV) + TLinAlg::Norm(NewWgtV));
+    // remember new solution
+    WgtV = NewWgtV;
+    return Diff;
+}
+
+double TSparseWgtV::Project(const double& Lambda) {
+    // project the current solution on to a ball
+    double ProjScale = 1.0 / (WgtV.GetNorm() * TMath::Sqrt(Lambda));
+    if (ProjScale < 1.0) { WgtV.MultiplyScalar(ProjScale); } else { ProjScale = 1.0; }
+    // compute the difference with respect to the previous iteration:
+    //  |new - old|^2 = |new|^2 - 2 <new, old> + |old|^2
+    const double NewSqNorm = WgtV.GetSqNorm();
+    const double NewOldDot = ProjScale * (WgtScale * OldSqNorm + UpdateDot);
+    const double DiffSqNorm = TFlt::GetMx(NewSqNorm - 2.0 * NewOldDot + OldSqNorm, 0.0);
+    return 2.0 * TMath::Sqrt(DiffSqNorm) / (TMath::Sqrt(OldSqNorm) + TMath::Sqrt(NewSqNorm));
+}
+
 }
@@ -51,13 +51,207 @@ public:
     double Predict(const TIntFltKdV& SpVec) const { 
         return TLinAlg::DotProduct(WgtV, SpVec) + Bias;
     }
+
+    /// Classify all columns of a full matrix, in parallel
+    void Predict(const TFltVV& Mat, TFltV& PredV) const;
+    /// Classify all sparse column vectors, in parallel
+    void Predict(const TVec<TIntFltKdV>& SpMat, TFltV& PredV) const;
+};
+
+/// Adds the mini-batch sub-gradient update to NewWgtV. CoefF(VecN, Dot) returns the
+/// update coefficient for the VecN-th example given its dot product with WgtV, zero
+/// means no update. With more than one thread the sample is split into Threads
+/// chunks, each accumulating its updates into its own partial vector, and the
+/// partial vectors are summed in chunk order, so the result is deterministic for
+/// a given number of threads. Returns the number of updated examples.
+template <class TVecV, class TCoefF>
+int AddBatchUpdate(const TVecV& VecV, const TIntV& SampleVecNV, const TFltV& WgtV,
+        const TCoefF& CoefF, const int& Threads, TVec<TFltV>& PartWgtVV, TFltV& NewWgtV) {
+
+    const int Samples = SampleVecNV.Len();
+    if (Threads <= 1) {
+        int Updates = 0;
+        for (int SampleN = 0; SampleN < Samples; SampleN++) {
+            const int VecN = SampleVecNV[SampleN];
+            const double Coef = CoefF(VecN, TLinAlg::DotProduct(VecV, VecN, WgtV));
+            if (Coef != 0.0) { TLinAlg::AddVec(Coef, VecV, VecN, NewWgtV, NewWgtV); Updates++; }
+        }
+        return Updates;
+    }
+    // one partial update vector per chunk
+    const int Dims = NewWgtV.Len();
+    if (PartWgtVV.Len() != Threads) { PartWgtVV.Gen(Threads); }
+    TIntV ChunkUpdatesV(Threads); 
+    #pragma omp parallel for num_threads(Threads) schedule(static, 1)
+    for (int ChunkN = 0; ChunkN < Threads; ChunkN++) {
+        TFltV& PartWgtV = PartWgtVV[ChunkN];
+        if (PartWgtV.Len() != Dims) { PartWgtV.Gen(Dims); } else { PartWgtV.PutAll(0.0); }
+        const int MnSampleN = (int)((int64)Samples * ChunkN / Threads);
+        const int MxSampleN = (int)((int64)Samples * (ChunkN + 1) / Threads);
+        for (int SampleN = MnSampleN; SampleN < MxSampleN; SampleN++) {
+            const int VecN = SampleVecNV[SampleN];
+            const double Coef = CoefF(VecN, TLinAlg::DotProduct(VecV, VecN, WgtV));
+            if (Coef != 0.0) { TLinAlg::AddVec(Coef, VecV, VecN, PartWgtV, PartWgtV); ChunkUpdatesV[ChunkN]++; }
+        }
+    }
+    // reduce partial updates in chunk order
+    #pragma omp parallel for num_threads(Threads)
+    for (int DimN = 0; DimN < Dims; DimN++) {
+        for (int ChunkN = 0; ChunkN < Threads; ChunkN++) {
+            if (ChunkUpdatesV[ChunkN] > 0) { NewWgtV[DimN] += PartWgtVV[ChunkN][DimN]; }
+        }
+    }
+    int Updates = 0;
+    for (int ChunkN = 0; ChunkN < Threads; ChunkN++) { Updates += ChunkUpdatesV[ChunkN]; }
+    return Updates;
+}
+
+/// Weight vector stored as Scale * WgtV. Scaling is O(1) and adding a sparse
+/// vector is O(nnz), the squared norm is maintained incrementally. Used by the
+/// sparse solvers, where the dense per-iteration work would otherwise dominate.
+class TScaledWgtV {
+private:
+    /// Unscaled weights
+    TFltV WgtV;
+    /// Scale applied to all weights
+    double Scale;
+    /// Squared norm of the unscaled weights
+    double SqNorm;
+
+    /// Fold the scale into the weights once it gets too small or too large
+    void Rescale();
+public:
+    TScaledWgtV(const TFltV& _WgtV);
+
+    /// Dot product with a sparse vector
+    double DotProduct(const TIntFltKdV& SpV) const;
+    /// Dot product with ColId-th column of sparse matrix
+    double DotProduct(const TVec<TIntFltKdV>& SpVV, const int& ColId) const { return DotProduct(SpVV[ColId]); }
+    /// Adds k * SpV
+    void AddVec(const double& k, const TIntFltKdV& SpV);
+    /// Adds k * ColId-th column of sparse matrix
+    void AddVec(const double& k, const TVec<TIntFltKdV>& SpVV, const int& ColId) { AddVec(k, SpVV[ColId]); }
+    /// Multiplies all weights with k
+    void MultiplyScalar(const double& k);
+    
+    /// Squared norm of the weights
+    double GetSqNorm() const { return Scale * Scale * SqNorm; }
+    /// Norm of the weights
+    double GetNorm() const { return TMath::Sqrt(GetSqNorm()); }
+    /// Get weight vector
+    void GetWgtV(TFltV& _WgtV) const;
+};
+
+/// Weight vector of the solvers for full examples. New weights are computed
+/// into a separate vector, with the updates added by AddBatchUpdate.
+class TDenseWgtV {
+private:
+    /// Current weights
+    TFltV WgtV;
+    /// Weights after the last update
+    TFltV NewWgtV;
+    /// Partial updates of parallel chunks
+    TVec<TFltV> PartWgtVV;
+    /// Number of threads for the updates
+    int Threads;
+public:
+    TDenseWgtV(const TFltV& _WgtV, const int& _Threads): 
+        WgtV(_WgtV), NewWgtV(_WgtV.Len()), Threads(_Threads) { }
+
+    /// Multiplies weights with WgtScale and adds CoefF(VecN, Dot) times each 
+    /// example from the sample. Returns the number of updated examples.
+    template <class TVecV, class TCoefF>
+    int Update(const TVecV& VecV, const TIntV& SampleVecNV, const double& WgtScale, const TCoefF& CoefF) {
+        TLinAlg::MultiplyScalar(WgtScale, WgtV, NewWgtV);
+        return AddBatchUpdate(VecV, SampleVecNV, WgtV, CoefF, Threads, PartWgtVV, NewWgtV);
+    }
+    /// Projects weights on to a ball with radius 1/sqrt(Lambda) and returns
+    /// their relative difference with respect to the weights before the update
+    double Project(const double& Lambda);
+    /// Get weight vector
+    void GetWgtV(TFltV& _WgtV) const { _WgtV = WgtV; }
+};
+
+/// Weight vector of the solvers for sparse examples. Weights are kept in 
+/// TScaledWgtV, so that one iteration costs O(nnz of the sample) instead of 
+/// O(Dims). With more than one thread only the dot products are parallel.
+class TSparseWgtV {
+private:
+    /// Current weights
+    TScaledWgtV WgtV;
+    /// Number of threads for the dot products
+    int Threads;
+    /// Dot products of the sample with the weights
+    TFltV SampleDotV;
+    /// Examples updated in the last update and their coefficients
+    TIntV UpdateVecNV; TFltV UpdateV;
+    /// Squared norm of the weights before the last update
+    double OldSqNorm;
+    /// Scale of the weights in the last update
+    double WgtScale;
+    /// Sum of coefficients times dot products in the last update
+    double UpdateDot;
+public:
+    TSparseWgtV(const TFltV& _WgtV, const int& _Threads): WgtV(_WgtV), Threads(_Threads),
+        OldSqNorm(0.0), WgtScale(1.0), UpdateDot(0.0) { }
+
+    /// Multiplies weights with WgtScale and adds CoefF(VecN, Dot) times each 
+    /// example from the sample. Returns the number of updated examples.
+    template <class TCoefF>
+    int Update(const TVec<TIntFltKdV>& VecV, const TIntV& SampleVecNV, const double& _WgtScale, const TCoefF& CoefF);
+    /// Projects weights on to a ball with radius 1/sqrt(Lambda) and returns
+    /// their relative difference with respect to the weights before the update
+    double Project(const double& Lambda);
+    /// Get weight vector
+    void GetWgtV(TFltV& _WgtV) const { WgtV.GetWgtV(_WgtV); }
+};
+
+template <class TCoefF>
+int TSparseWgtV::Update(const TVec<TIntFltKdV>& VecV, const TIntV& SampleVecNV, 
+        const double& _WgtScale, const TCoefF& CoefF) {
+
+    const int Samples = SampleVecNV.Len();
+    if (SampleDotV.Len() != Samples) { SampleDotV.Gen(Samples); }
+    #pragma omp parallel for num_threads(Threads) if (Threads > 1)
+    for (int SampleN = 0; SampleN < Samples; SampleN++) {
+        SampleDotV[SampleN] = WgtV.DotProduct(VecV, SampleVecNV[SampleN]);
+    }
+    // collect updates, and the sum of updates dot current weights for the difference
+    UpdateVecNV.Clr(false); UpdateV.Clr(false); UpdateDot = 0.0;
+    for (int SampleN = 0; SampleN < Samples; SampleN++) {
+        const double Coef = CoefF(SampleVecNV[SampleN], SampleDotV[SampleN]);
+        if (Coef != 0.0) { 
+            UpdateVecNV.Add(SampleVecNV[SampleN]); UpdateV.Add(Coef);
+            UpdateDot += Coef * SampleDotV[SampleN];
+        }
+    }
+    // scale and apply the updates
+    OldSqNorm = WgtV.GetSqNorm(); WgtScale = _WgtScale;
+    WgtV.MultiplyScalar(WgtScale);
+    for (int UpdateN = 0; UpdateN < UpdateVecNV.Len(); UpdateN++) {
+        WgtV.AddVec(UpdateV[UpdateN], VecV, UpdateVecNV[UpdateN]);
+    }
+    return UpdateVecNV.Len();
+}
+
+/// Weight vector used by the solvers for given type of examples
+template <class TVecV> 
+class TSolverWgtV { 
+public:
+    typedef TDenseWgtV TWgtV; 
+};
+
+template <> 
+class TSolverWgtV<TVec<TIntFltKdV> > { 
+public:
+    typedef TSparseWgtV TWgtV; 
 };
 
 template <class TVecV>
 TLinModel SolveClassify(const TVecV& VecV, const int& Dims, const int& Vecs,
         const TFltV& TargetV, const double& Cost, const double& UnbalanceWgt,
         const int& MxMSecs, const int& MxIter, const double& MnDiff, 
-        const int& SampleSize, const PNotify& Notify = TStdNotify::New()) {
+        const int& SampleSize, const PNotify& Notify = TStdNotify::New(), const int& Threads = 1) {
 
     // asserts for input parameters
     EAssertR(Dims > 0, "Dimensionality must be positive!");
@@ -73,11 +267,12 @@ TLinModel SolveClassify(const TVecV& VecV, const int& Dims, const int& Vecs,
     TRnd Rnd(1); 
     const double Lambda = 1.0 / (double(Vecs) * Cost);
     // we start with random normal vector
-    TFltV WgtV(Dims); TLAMisc::FillRnd(WgtV, Rnd); TLinAlg::Normalize(WgtV);
+    TFltV InitWgtV(Dims); TLAMisc::FillRnd(InitWgtV, Rnd); TLinAlg::Normalize(InitWgtV);
     // make it of appropriate length
-    TLinAlg::MultiplyScalar(1.0 / (2.0 * TMath::Sqrt(Lambda)), WgtV, WgtV);
-    // allocate space for updates
-    TFltV NewWgtV(Dims);
+    TLinAlg::MultiplyScalar(1.0 / (2.0 * TMath::Sqrt(Lambda)), InitWgtV, InitWgtV);
+    typename TSolverWgtV<TVecV>::TWgtV WgtV(InitWgtV, Threads); InitWgtV.Clr();
+    // examples in the current sample
+    TIntV SampleVecNV(SampleSize, 0);
 
     // split vectors into positive and negative 
     TIntV PosVecIdV, NegVecIdV;
@@ -102,7 +297,6 @@ TLinModel SolveClassify(const TVecV& VecV, const int& Dims, const int& Vecs,
     Notify->OnStatusFmt("Limits: %d iterations, %.3f seconds, %.8f weight difference", MxIter, (double)MxMSecs /1000.0, MnDiff);
     // initialize profiler    
     TTmProfiler Profiler;
-    const int ProfilerPre = Profiler.AddTimer("Pre");
     const int ProfilerBatch = Profiler.AddTimer("Batch");
     const int ProfilerPost = Profiler.AddTimer("Post");
 
@@ -118,46 +312,36 @@ TLinModel SolveClassify(const TVecV& VecV, const int& Dims, const int& Vecs,
     for (int IterN = 0; IterN < MxIter; IterN++) {
         if (IterN % 100 == 0) { ProgressNotify(); }
         
-        Profiler.StartTimer(ProfilerPre);
         // tells how much we can move
-        const double Nu = 1.0 / (Lambda * double(IterN + 2)); // ??
+        const double Nu = 1.0 / (Lambda * double(IterN + 2));
         const double VecUpdate = Nu / double(SampleSize);
-        // initialize updated normal vector
-        TLinAlg::MultiplyScalar((1.0 - Nu * Lambda), WgtV, NewWgtV);
-        Profiler.StopTimer(ProfilerPre);
         
         // classify examples from the sample
         Profiler.StartTimer(ProfilerBatch);
-        int DiffCount = 0;
+        SampleVecNV.Clr(false);
         for (int SampleN = 0; SampleN < SampleSize; SampleN++) {
-            int VecN = 0;
             if (Rnd.GetUniDev() > SamplingRatio) {
                 // we select negative vector
-                VecN = NegVecIdV[Rnd.GetUniDevInt(NegVecs)];
+                SampleVecNV.Add(NegVecIdV[Rnd.GetUniDevInt(NegVecs)]);
                 NegCount++;
             } else {
                 // we select positive vector
-                VecN = PosVecIdV[Rnd.GetUniDevInt(PosVecs)];
+                SampleVecNV.Add(PosVecIdV[Rnd.GetUniDevInt(PosVecs)]);
                 PosCount++;
             }
-            const double VecCfyVal = TargetV[VecN];
-            const double CfyVal = VecCfyVal * TLinAlg::DotProduct(VecV, VecN, WgtV);
-            if (CfyVal < 1.0) { 
-                // with update from the stochastic sub-gradient
-                TLinAlg::AddVec(VecUpdate * VecCfyVal, VecV, VecN, NewWgtV, NewWgtV);
-                DiffCount++;
-            }
         }
+        // scale and update from the stochastic sub-gradient for misclassified examples
+        const int DiffCount = WgtV.Update(VecV, SampleVecNV, 1.0 - Nu * Lambda, 
+            [&](const int& VecN, const double& Dot) {
+                const double VecCfyVal = TargetV[VecN];
+                return (VecCfyVal * Dot < 1.0) ? VecUpdate * VecCfyVal : 0.0;
+            });
         Profiler.StopTimer(ProfilerBatch);
 
         Profiler.StartTimer(ProfilerPost);
-        // project the current solution on to a ball
-        const double WgtNorm = 1.0 / (TLinAlg::Norm(NewWgtV) * TMath::Sqrt(Lambda));
-        if (WgtNorm < 1.0) { TLinAlg::MultiplyScalar(WgtNorm, NewWgtV, NewWgtV); }
-        // compute the difference with respect to the previous iteration
-        Diff = 2.0 * TLinAlg::EuclDist(WgtV, NewWgtV) / (TLinAlg::Norm(WgtV) + TLinAlg::Norm(NewWgtV));
-        // remember new solution, but only when we actually did some changes
-        WgtV = NewWgtV;
+        // project the current solution on to a ball and compute 
+        // the difference with respect to the previous iteration
+        Diff = WgtV.Project(Lambda);
         Profiler.StopTimer(ProfilerPost);
 
         // count
@@ -181,14 +365,15 @@ TLinModel SolveClassify(const TVecV& VecV, const int& Dims, const int& Vecs,
     ProgressNotify();
     Profiler.PrintReport(Notify);
             
-    return TLinModel(WgtV);
+    TFltV ResWgtV; WgtV.GetWgtV(ResWgtV);
+    return TLinModel(ResWgtV);
 }
         
 template <class TVecV>
 TLinModel SolveRegression(const TVecV& VecV, const int& Dims, const int& Vecs,
         const TFltV& TargetV, const double& Cost, const double& Eps,
         const int& MxMSecs, const int& MxIter, const double& MnDiff, 
-        const int& SampleSize, const PNotify& Notify = TStdNotify::New()) {
+        const int& SampleSize, const PNotify& Notify = TStdNotify::New(), const int& Threads = 1) {
 
     // asserts for input parameters
     EAssertR(Dims > 0, "Dimensionality must be positive!");
@@ -202,17 +387,17 @@ TLinModel SolveRegression(const TVecV& VecV, const int& Dims, const int& Vecs,
     TRnd Rnd(1); 
     const double Lambda = 1.0 / (double(Vecs) * Cost);
     // we start with random normal vector
-    TFltV WgtV(Dims); TLAMisc::FillRnd(WgtV, Rnd); TLinAlg::Normalize(WgtV);
+    TFltV InitWgtV(Dims); TLAMisc::FillRnd(InitWgtV, Rnd); TLinAlg::Normalize(InitWgtV);
     // make it of appropriate length
-    TLinAlg::MultiplyScalar(1.0 / (2.0 * TMath::Sqrt(Lambda)), WgtV, WgtV);
-    // allocate space for updates
-    TFltV NewWgtV(Dims);
+    TLinAlg::MultiplyScalar(1.0 / (2.0 * TMath::Sqrt(Lambda)), InitWgtV, InitWgtV);
+    typename TSolverWgtV<TVecV>::TWgtV WgtV(InitWgtV, Threads); InitWgtV.Clr();
+    // examples in the current sample
+    TIntV SampleVecNV(SampleSize, 0);
 
     TTmTimer Timer(MxMSecs); int Iters = 0; double Diff = 1.0;
     Notify->OnStatusFmt("Limits: %d iterations, %.3f seconds, %.8f weight difference", MxIter, (double)MxMSecs / 1000.0, MnDiff);
     // initialize profiler    
     TTmProfiler Profiler;
-    const int ProfilerPre = Profiler.AddTimer("Pre");
     const int ProfilerBatch = Profiler.AddTimer("Batch");
     const int ProfilerPost = Profiler.AddTimer("Post");
 
@@ -225,43 +410,37 @@ TLinModel SolveRegression(const TVecV& VecV, const int& Dims, const int& Vecs,
     for (int IterN = 0; IterN < MxIter; IterN++) {
         if (IterN % 100 == 0) { ProgressNotify(); }
         
-        Profiler.StartTimer(ProfilerPre);
         // tells how much we can move
         const double Nu = 1.0 / (Lambda * double(IterN + 2));
         const double VecUpdate = Nu / double(SampleSize);
-        // initialize updated normal vector
-        TLinAlg::MultiplyScalar((1.0 - Nu * Lambda), WgtV, NewWgtV);
-        Profiler.StopTimer(ProfilerPre);
         
         // process examples from the sample
         Profiler.StartTimer(ProfilerBatch);
+        SampleVecNV.Clr(false);
         for (int SampleN = 0; SampleN < SampleSize; SampleN++) {            
-            const int VecN = Rnd.GetUniDevInt(Vecs);
-            // target
-            const double Target = TargetV[VecN];
-            // prediction
-            const double Pred = TLinAlg::DotProduct(VecV, VecN, WgtV);
-            // difference
-            const double Loss = Target - Pred;
-            // do the update based on the difference
-            if (Loss < -Eps) { // y - z < -eps
-                // update from the stochastic sub-gradient: x
-                TLinAlg::AddVec(-VecUpdate, VecV, VecN, NewWgtV, NewWgtV);                
-            } else if (Loss > Eps) { // y - z > eps
-                // update from the stochastic sub-gradient: -x
-                TLinAlg::AddVec(VecUpdate, VecV, VecN, NewWgtV, NewWgtV);
-            } // else nothing to do, we are within the epsilon tube
+            SampleVecNV.Add(Rnd.GetUniDevInt(Vecs));
         }
+        // scale and update from the stochastic sub-gradient
+        WgtV.Update(VecV, SampleVecNV, 1.0 - Nu * Lambda, 
+            [&](const int& VecN, const double& Pred) {
+                // difference between target and prediction
+                const double Loss = TargetV[VecN] - Pred;
+                // do the update based on the difference
+                if (Loss < -Eps) { // y - z < -eps
+                    // update from the stochastic sub-gradient: x
+                    return -VecUpdate;
+                } else if (Loss > Eps) { // y - z > eps
+                    // update from the stochastic sub-gradient: -x
+                    return VecUpdate;
+                } // else nothing to do, we are within the epsilon tube
+                return 0.0;
+            });
         Profiler.StopTimer(ProfilerBatch);
 
         Profiler.StartTimer(ProfilerPost);
-        // project the current solution on to a ball
-        const double WgtNorm = 1.0 / (TLinAlg::Norm(NewWgtV) * TMath::Sqrt(Lambda));
-        if (WgtNorm < 1.0) { TLinAlg::MultiplyScalar(WgtNorm, NewWgtV, NewWgtV); }
-        // compute the difference with respect to the previous iteration
-        Diff = 2.0 * TLinAlg::EuclDist(WgtV, NewWgtV) / (TLinAlg::Norm(WgtV) + TLinAlg::Norm(NewWgtV));
-        // remember new solution
-        WgtV = NewWgtV;
+        // project the current solution on to a ball and compute 
+        // the difference with respect to the previous iteration
+        Diff = WgtV.Project(Lambda);
         Profiler.StopTimer(ProfilerPost);
 
         // count
@@ -285,7 +464,8 @@ TLinModel SolveRegression(const TVecV& VecV, const int& Dims, const int& Vecs,
 	
     Profiler.PrintReport(Notify);
             
-    return TLinModel(WgtV);
+    TFltV ResWgtV; WgtV.GetWgtV(ResWgtV);
+    return TLinModel(ResWgtV);
 }
 
 };
@@ -53,6 +53,8 @@ public:
 	virtual void GetTokens(const PSIn& SIn, TStrV& TokenV) const = 0;
 	void GetTokens(const TStr& Text, TStrV& TokenV) const;
 	void GetTokens(const TStrV& TextV, TVec<TStrV>& TokenVV) const;
+	/// True when GetTokens can be called from multiple threads
+	virtual bool IsThreadSafe() const { return false; }
 };
 
 namespace TTokenizers {
@@ -78,6 +80,7 @@ public:
 	void Save(TSOut& SOut) const;
 
 	void GetTokens(const PSIn& SIn, TStrV& TokenV) const;
+	bool IsThreadSafe() const { return Stemmer.Empty() || !Stemmer->IsRealWordP(); }
     
     static TStr GetType() { return "simple"; }
 };
@@ -85,7 +88,7 @@ public:
 ///////////////////////////////
 // Tokenizer-Html
 //   HTML-aware tough tokenizer with stopwords and stemming.
-//   WARNING - NOT THREAD SAFE. WILL SEGFAULT
+//   WARNING - NOT THREAD SAFE WHEN STEMMER MAPS STEMS TO REAL WORDS
 class THtml : public TTokenizer {
 protected:
 	PSwSet SwSet;
@@ -105,6 +108,7 @@ public:
     void Save(TSOut& SOut) const { Save(SOut, true); }
 
 	void GetTokens(const PSIn& SIn, TStrV& TokenV) const;
+	bool IsThreadSafe() const { return Stemmer.Empty() || !Stemmer->IsRealWordP(); }
     
     static TStr GetType() { return "html"; }
 };
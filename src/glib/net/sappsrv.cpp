@@ -24,6 +24,59 @@ void TSAppSrvRqEnv::ExecFun(const TStr& FunNm, const TStrKdV& FldNmValPrV) {
 	FunNmToFunH.GetDat(FunNm)->Exec(FldNmValPrV, this); 
 }
 
+void TSAppSrvRqEnv::SendHttpResp(const PHttpResp& _HttpResp) {
+	{ TSysCsLock Lock(RespCs); HttpResp = _HttpResp; StatusCd = HttpResp->GetStatusCd(); }
+	// on the worker, the response is sent when work is done
+	if (Work == NULL) { FlushResp(true); }
+}
+
+void TSAppSrvRqEnv::SendHttpChunk(const TStr& ContTypeVal, const char* Bf, const int& BfL) {
+	{
+		TSysCsLock Lock(RespCs);
+		if (!ChunksP) { ChunksP = true; ChunkContTypeVal = ContTypeVal; StatusCd = THttp::OkStatusCd; }
+		ChunkV.Add(TMem(Bf, BfL));
+	}
+	if (Work == NULL) { FlushResp(false); } else { Work->Notify(); }
+}
+
+void TSAppSrvRqEnv::EndHttpChunks() {
+	{ TSysCsLock Lock(RespCs); ChunksEndP = true; }
+	if (Work == NULL) { FlushResp(true); }
+}
+
+void TSAppSrvRqEnv::AbortHttpResp() {
+	{ TSysCsLock Lock(RespCs); AbortP = true; StatusCd = THttp::InternalErrStatusCd; }
+	if (Work == NULL) { FlushResp(true); }
+}
+
+void TSAppSrvRqEnv::FlushResp(const bool& DoneP) {
+	// take the output, so we do not hold the lock while sending
+	TVec<TMem> _ChunkV; bool _ChunksP, SendHdP;
+	{
+		TSysCsLock Lock(RespCs);
+		_ChunkV.MoveFrom(ChunkV);
+		_ChunksP = ChunksP; SendHdP = ChunksP && !ChunksSentP;
+		if (SendHdP) { ChunksSentP = true; }
+	}
+	if (DoneP && AbortP) { WebSrv->AbortHttpResp(SockId); return; }
+	// header of the chunked response
+	if (SendHdP) {
+		PHttpResp ChunksHttpResp = THttpResp::New(THttp::OkStatusCd, ChunkContTypeVal, false, NULL);
+		ChunksHttpResp->AddFldVal(THttp::ContTypeFldNm, ChunkContTypeVal);
+		WebSrv->StartHttpChunks(SockId, ChunksHttpResp);
+	}
+	for (int ChunkN = 0; ChunkN < _ChunkV.Len(); ChunkN++) {
+		WebSrv->SendHttpChunk(SockId, _ChunkV[ChunkN].GetBf(), _ChunkV[ChunkN].Len());
+	}
+	if (DoneP) {
+		if (_ChunksP) {
+			if (ChunksEndP) { WebSrv->EndHttpChunks(SockId); }
+		} else if (!HttpResp.Empty()) {
+			WebSrv->SendHttpResp(SockId, HttpResp);
+		}
+	}
+}
+
 //////////////////////////////////////
 // Simple-App-Server-Function
 bool TSAppSrvFun::IsFldNm(const TStrKdV& FldNmValPrV, const TStr& FldNm) {
@@ -110,6 +163,21 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
 			TStr ResStr = ExecJSon(FldNmValPrV, RqEnv);
 			BodySIn = TMIn::New(ResStr);
 			ContTypeVal = THttp::AppJSonFldVal;
+		} else if (GetFunOutType() == saotJSonStream) {
+			// full chunks go to the client as soon as they are written
+			ContTypeVal = THttp::AppJSonFldVal;
+			PSOut ChunkOut = RqEnv->IsChunkedResp() ?
+				TSAppSrvChunkOut::New(RqEnv(), ContTypeVal) : PSOut();
+			TJsonWriter Writer(ChunkOut);
+			ExecJSonStream(FldNmValPrV, RqEnv, Writer);
+			if (RqEnv->IsHttpChunks()) {
+				Writer.Flush(); RqEnv->EndHttpChunks();
+				Notify->OnStatus(TStr::Fmt("[AppSrv] RequestFinish %s [%d ms]", 
+					FunNm.CStr(), StopWatch.GetMSecInt()));
+				return;
+			}
+			// everything fits in one chunk, send as normal response
+			BodySIn = TMIn::New(Writer.GetChA());
 		} else {
 			BodySIn = ExecSIn(FldNmValPrV, RqEnv, ContTypeVal);
 		}
@@ -120,6 +188,12 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
 		HttpResp = THttpResp::New(THttp::OkStatusCd, 
 			ContTypeVal, false, BodySIn);
     } catch (PExcept Except) {
+		// part of the response already sent, can only drop the connection
+		if (RqEnv->IsHttpChunks()) { 
+			Notify->OnStatus(TStr::Fmt("[AppSrv] RequestAbort %s: %s", 
+				FunNm.CStr(), Except->GetMsgStr().CStr()));
+			RqEnv->AbortHttpResp(); return;
+		}
 		// known internal error
         TStr ResStr, ContTypeVal = THttp::TextPlainFldVal;
 		if (GetFunOutType() == saotXml) {
@@ -129,7 +203,7 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
 			PXmlDoc ErrorXmlDoc = TXmlDoc::New(TopTok); 
 			ResStr = XmlHdStr + ErrorXmlDoc->SaveStr();
             ContTypeVal = THttp::TextXmlFldVal;
-		} else if (GetFunOutType() == saotJSon) {
+		} else if (GetFunOutType() == saotJSon || GetFunOutType() == saotJSonStream) {
 			PJsonVal ResVal = TJsonVal::NewObj();
 			ResVal->AddToObj("message", Except->GetMsgStr());
 			ResVal->AddToObj("location", Except->GetLocStr());
@@ -140,13 +214,15 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
         HttpResp = THttpResp::New(THttp::InternalErrStatusCd, 
             ContTypeVal, false, TMIn::New(ResStr));        
     } catch (...) {
+		// part of the response already sent, can only drop the connection
+		if (RqEnv->IsHttpChunks()) { RqEnv->AbortHttpResp(); return; }
 		// unknown internal error
 		TStr ResStr, ContTypeVal = THttp::TextPlainFldVal;
 		if (GetFunOutType() == saotXml) {
 			PXmlDoc ErrorXmlDoc = TXmlDoc::New(TXmlTok::New("error")); 
 			ResStr = XmlHdStr + ErrorXmlDoc->SaveStr();
             ContTypeVal = THttp::TextXmlFldVal;            
-		} else if (GetFunOutType() == saotJSon) {
+		} else if (GetFunOutType() == saotJSon || GetFunOutType() == saotJSonStream) {
 			ResStr = TJsonVal::NewObj("error", "Unknown")->SaveStr();
             ContTypeVal = THttp::AppJSonFldVal;
 		}
@@ -155,7 +231,38 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
             ContTypeVal, false, TMIn::New(ResStr));
     }
 	// send response
-	RqEnv->GetWebSrv()->SendHttpResp(RqEnv->GetSockId(), HttpResp); 
+	RqEnv->SendHttpResp(HttpResp); 
+}
+
+//////////////////////////////////////
+// Simple-App-Server-Function-Statistics
+const int TSAppSrvFunStat::Buckets = 16;
+
+void TSAppSrvFunStat::Add(const double& MSecs, const bool& ErrP) {
+	Reqs++; if (ErrP) { Errs++; }
+	SumMSecs += MSecs; MxMSecs = TFlt::GetMx(MxMSecs, MSecs);
+	int BucketN = 0; double BucketMSecs = 1.0;
+	while (BucketN < Buckets - 1 && MSecs >= BucketMSecs) { BucketN++; BucketMSecs *= 2.0; }
+	BucketV[BucketN]++;
+}
+
+PJsonVal TSAppSrvFunStat::GetJson() const {
+	PJsonVal StatVal = TJsonVal::NewObj();
+	StatVal->AddToObj("requests", Reqs);
+	StatVal->AddToObj("errors", Errs);
+	StatVal->AddToObj("avgMSecs", (Reqs > 0) ? SumMSecs / double(Reqs) : 0.0);
+	StatVal->AddToObj("maxMSecs", MxMSecs);
+	// non-empty buckets, named by their upper bound in milliseconds
+	PJsonVal HistVal = TJsonVal::NewObj(); int BucketMSecs = 1;
+	for (int BucketN = 0; BucketN < Buckets; BucketN++) {
+		if (BucketV[BucketN] > 0) {
+			const TStr BucketNm = (BucketN < Buckets - 1) ? TInt::GetStr(BucketMSecs) : TStr("more");
+			HistVal->AddToObj(BucketNm, BucketV[BucketN]);
+		}
+		BucketMSecs *= 2;
+	}
+	StatVal->AddToObj("histogram", HistVal);
+	return StatVal;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -163,11 +270,12 @@ void TSAppSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
 #include "favicon.cpp"
 
 TSAppSrv::TSAppSrv(const int& PortN, const TSAppSrvFunV& SrvFunV, const PNotify& Notify, 
-		const bool& _ShowParamP, const bool& _ListFunP): TWebSrv(PortN, true, Notify), 
-		Favicon(Favicon_bf, Favicon_len) {
+		const bool& _ShowParamP, const bool& _ListFunP, const bool& _WorkersP): 
+		TWebSrv(PortN, true, Notify), Favicon(Favicon_bf, Favicon_len) {
 
     ShowParamP = _ShowParamP;
     ListFunP = _ListFunP;
+	WorkersP = _WorkersP;
     // initiaize hash-table with mappings
     for (int SrvFunN = 0; SrvFunN < SrvFunV.Len(); SrvFunN++) {
         PSAppSrvFun SrvFun =  SrvFunV[SrvFunN];
@@ -175,6 +283,13 @@ TSAppSrv::TSAppSrv(const int& PortN, const TSAppSrvFunV& SrvFunV, const PNotify&
     }
 }
 
+void TSAppSrv::AddFunStat(const TStr& FunNm, const uint64& StartTicks, const int& StatusCd) {
+	const double MSecs = 1000.0 * double(TSysTm::GetPerfTimerTicks() - StartTicks) /
+		double(TSysTm::GetPerfTimerFq());
+	const bool ErrP = (StatusCd != 0) && (StatusCd != THttp::OkStatusCd);
+	FunNmToStatH.AddDat(FunNm).Add(MSecs, ErrP);
+}
+
 void TSAppSrv::OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq) {
 	// last appropriate error code, start with bad request
 	int ErrStatusCd = THttp::BadRqStatusCd;
@@ -216,12 +331,20 @@ void TSAppSrv::OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq) {
 		ErrStatusCd = THttp::InternalErrStatusCd;
 		// processed requested function
 		if (!FunNm.Empty()) {
+			const uint64 StartTicks = TSysTm::GetPerfTimerTicks();
 			// prepare request environment
 			PSAppSrvRqEnv RqEnv = TSAppSrvRqEnv::New(this, SockId, HttpRq, FunNmToFunH);
 			// retrieve function
 			PSAppSrvFun SrvFun = FunNmToFunH.GetDat(FunNm);
-			// call function
-			SrvFun->Exec(FldNmValPrV, RqEnv);
+			if (WorkersP && SrvFun->IsReadOnly()) {
+				// execute on a worker thread, response is sent when done
+				TLoopWork::Queue(TSAppSrvWork::New(this, SrvFun(), FldNmValPrV, RqEnv, StartTicks));
+				ActiveWorks++;
+			} else {
+				// call function
+				SrvFun->Exec(FldNmValPrV, RqEnv);
+				AddFunStat(FunNm, StartTicks, RqEnv->GetStatusCd());
+			}
 		} else {
 			// internal SAppSrv call
 			if (!ListFunP) {
@@ -233,11 +356,18 @@ void TSAppSrv::OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq) {
             PJsonVal FunArrVal = TJsonVal::NewArr();
 			int KeyId = FunNmToFunH.FFirstKeyId();
 			while (FunNmToFunH.FNextKeyId(KeyId)) {
-                FunArrVal->AddToArr(TJsonVal::NewObj("name", FunNmToFunH.GetKey(KeyId)));
+				const TStr& FunNm = FunNmToFunH.GetKey(KeyId);
+				PJsonVal FunVal = TJsonVal::NewObj("name", FunNm);
+				FunVal->AddToObj("readOnly", FunNmToFunH[KeyId]->IsReadOnly());
+				if (FunNmToStatH.IsKey(FunNm)) { 
+					FunVal->AddToObj("stat", FunNmToStatH.GetDat(FunNm).GetJson()); }
+                FunArrVal->AddToArr(FunVal);
 			}
             PJsonVal ResVal = TJsonVal::NewObj();
             ResVal->AddToObj("port", GetPortN());
             ResVal->AddToObj("connections", GetConns());            
+            ResVal->AddToObj("workers", WorkersP);
+            ResVal->AddToObj("activeWorkers", ActiveWorks);
             ResVal->AddToObj("functions", FunArrVal);
 			TStr ResStr = ResVal->SaveStr();
 			// prepare response
@@ -270,6 +400,41 @@ void TSAppSrv::OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq) {
     }
 }
 
+//////////////////////////////////////
+// Simple-App-Server-Work
+TSAppSrvWork::TSAppSrvWork(TSAppSrv* _SAppSrv, TSAppSrvFun* _SrvFun, const TStrKdV& _FldNmValPrV,
+		const PSAppSrvRqEnv& _RqEnv, const uint64& _StartTicks): SAppSrv(_SAppSrv), 
+		SrvFun(_SrvFun), FldNmValPrV(_FldNmValPrV), RqEnv(_RqEnv), StartTicks(_StartTicks) { 
+	
+	RqEnv->PutWork(this);
+}
+
+void TSAppSrvWork::OnExec() {
+	// errors of the function are reported in the response, others would get 
+	// lost on the worker thread, drop the connection so client is not left waiting
+	try {
+		SrvFun->Exec(FldNmValPrV, RqEnv);
+	} catch (PExcept Except) {
+		ErrMsgStr = Except->GetMsgStr(); RqEnv->AbortHttpResp();
+	} catch (...) {
+		ErrMsgStr = "Unknown error"; RqEnv->AbortHttpResp();
+	}
+}
+
+void TSAppSrvWork::OnProgress() {
+	RqEnv->FlushResp(false);
+}
+
+void TSAppSrvWork::OnDone() {
+	if (!ErrMsgStr.Empty()) {
+		SAppSrv->GetNotify()->OnStatus(TStr::Fmt("[AppSrv] RequestAbort %s: %s", 
+			SrvFun->GetFunNm().CStr(), ErrMsgStr.CStr()));
+	}
+	RqEnv->FlushResp(true);
+	SAppSrv->ActiveWorks--;
+	SAppSrv->AddFunStat(SrvFun->GetFunNm(), StartTicks, RqEnv->GetStatusCd());
+}
+
 //////////////////////////////////////
 // File-Download-Function
 PSIn TSASFunFPath::ExecSIn(const TStrKdV& FldNmValPrV, 
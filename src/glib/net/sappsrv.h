@@ -21,17 +21,34 @@ ClassHdTPV(TSAppSrvFun, PSAppSrvFun, TSAppSrvFunV);
 
 //////////////////////////////////////
 // Simple-App-Server-Request-Environment
+//   response goes through the environment, so that a function running on
+//   a worker thread only queues it and the loop thread sends it in FlushResp
 ClassTP(TSAppSrvRqEnv, PSAppSrvRqEnv)//{
 private:
 	TWebSrv* WebSrv;
 	TUInt64 SockId;
 	PHttpRq HttpRq;
 	const THash<TStr, PSAppSrvFun>& FunNmToFunH;
+	// client accepts chunked response
+	TBool ChunkedRespP;
+	// work executing the request, NULL when executed on the loop thread
+	TLoopWork* Work;
 
+	// output waiting to be sent
+	TSysCs RespCs;
+	PHttpResp HttpResp;
+	TStr ChunkContTypeVal;
+	TVec<TMem> ChunkV;
+	TBool ChunksP, ChunksSentP, ChunksEndP, AbortP;
+	// status of the response, for statistics
+	TInt StatusCd;
+
+	UndefCopyAssign(TSAppSrvRqEnv);
 public:
 	TSAppSrvRqEnv(TWebSrv* _WebSrv, uint64 _SockId, const PHttpRq& _HttpRq, 
 		const THash<TStr, PSAppSrvFun>& _FunNmToFunH): WebSrv(_WebSrv), SockId(_SockId), 
-			HttpRq(_HttpRq), FunNmToFunH(_FunNmToFunH) { }
+			HttpRq(_HttpRq), FunNmToFunH(_FunNmToFunH), 
+			ChunkedRespP(_WebSrv->IsChunkedResp(_SockId)), Work(NULL) { }
 	static PSAppSrvRqEnv New(TWebSrv* WebSrv, uint64 SockId, const PHttpRq& HttpRq,
 		const THash<TStr, PSAppSrvFun>& FunNmToFunH) { 
 			return new TSAppSrvRqEnv(WebSrv, SockId, HttpRq, FunNmToFunH); }
@@ -41,11 +58,50 @@ public:
 	const PHttpRq& GetHttpRq() const { return HttpRq; }
 	bool IsFunNm(const TStr& FunNm) const { return FunNmToFunH.IsKey(FunNm); }
 	void ExecFun(const TStr& FunNm, const TStrKdV& FldNmValPrV);
+
+	// set when executed on a worker thread
+	void PutWork(TLoopWork* _Work) { Work = _Work; }
+
+	// send complete response
+	void SendHttpResp(const PHttpResp& _HttpResp);
+	// chunked response, only when client accepts it
+	bool IsChunkedResp() const { return ChunkedRespP; }
+	bool IsHttpChunks() const { return ChunksP; }
+	void SendHttpChunk(const TStr& ContTypeVal, const char* Bf, const int& BfL);
+	void EndHttpChunks();
+	// drop the connection, for errors in the middle of chunked response
+	void AbortHttpResp();
+	// status code of the response, zero when not known yet
+	int GetStatusCd() const { return StatusCd; }
+
+	// send queued output to the client, called on the loop thread;
+	// complete response and end of chunks are sent only when DoneP
+	void FlushResp(const bool& DoneP);
+};
+
+//////////////////////////////////////
+// Simple-App-Server-Chunked-Output
+//   stream passing its output to the client as chunks of the response
+class TSAppSrvChunkOut : public TSOut {
+private:
+	TSAppSrvRqEnv* RqEnv;
+	TStr ContTypeVal;
+
+	TSAppSrvChunkOut(TSAppSrvRqEnv* _RqEnv, const TStr& _ContTypeVal):
+		TSBase("Chunked-Output"), TSOut(), RqEnv(_RqEnv), ContTypeVal(_ContTypeVal) { }
+public:
+	static PSOut New(TSAppSrvRqEnv* RqEnv, const TStr& ContTypeVal) {
+		return new TSAppSrvChunkOut(RqEnv, ContTypeVal); }
+
+	int PutCh(const char& Ch) { RqEnv->SendHttpChunk(ContTypeVal, &Ch, 1); return Ch; }
+	int PutBf(const void* LBf, const TSize& LBfL) {
+		RqEnv->SendHttpChunk(ContTypeVal, (const char*)LBf, (int)LBfL); return 0; }
+	void Flush() { }
 };
 
 //////////////////////////////////////
 // Simple-App-Server-Function
-typedef enum { saotUndef, saotXml, saotJSon, saotCustom } TSAppOutType;
+typedef enum { saotUndef, saotXml, saotJSon, saotCustom, saotJSonStream } TSAppOutType;
 ClassTPV(TSAppSrvFun, PSAppSrvFun, TSAppSrvFunV)//{
 public:
 	static bool IsFldNm(const TStrKdV& FldNmValPrV, const TStr& FldNm);
@@ -74,6 +130,10 @@ protected:
     // executes function using parameters passed after ? and returns JavaScript doc
 	virtual PSIn ExecSIn(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv,
 		TStr& ContTypeStr) { EAssert(OutType != saotCustom); return NULL; };
+    // executes function using parameters passed after ? and writes JSon doc,
+    // sent in chunks when it does not fit in one
+	virtual void ExecJSonStream(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv,
+		TJsonWriter& Writer) { EAssert(OutType != saotJSonStream); };
 
 public:
 	TSAppSrvFun(const TStr& _FunNm, const TSAppOutType& _OutType = saotXml): 
@@ -84,30 +144,89 @@ public:
 	TSAppOutType GetFunOutType() const { return OutType; }
     // name of the function, corresponds to URL path
 	TStr GetFunNm() const { return FunNm; }
+	// function does not change any shared state and can be executed on a
+	// worker thread, in parallel with other read-only functions; functions
+	// lock the data they share with others themselves
+	virtual bool IsReadOnly() const { return false; }
 	// executed by server
 	virtual void Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv);
 };
 
+//////////////////////////////////////
+// Simple-App-Server-Function-Statistics
+//   number of requests and latency histogram with power-of-two millisecond 
+//   buckets, bucket N counts requests faster than 2^N ms, last one the rest
+class TSAppSrvFunStat {
+public:
+	static const int Buckets;
+private:
+	TInt Reqs, Errs;
+	TFlt SumMSecs, MxMSecs;
+	TIntV BucketV;
+public:
+	TSAppSrvFunStat(): BucketV(Buckets) { }
+
+	void Add(const double& MSecs, const bool& ErrP);
+	int GetReqs() const { return Reqs; }
+	PJsonVal GetJson() const;
+};
+
 //////////////////////////////////////
 // Simple-App-Server
+//   with workers enabled, read-only functions are executed on the libuv 
+//   thread pool and others on the loop thread
 class TSAppSrv : public TWebSrv {
 private:
 	TMem Favicon;
     TBool ShowParamP;
 	TBool ListFunP;
+	TBool WorkersP;
     THash<TStr, PSAppSrvFun> FunNmToFunH;
+	// statistics, updated on the loop thread
+	THash<TStr, TSAppSrvFunStat> FunNmToStatH;
+	TInt ActiveWorks;
 private:
 	static unsigned char Favicon_bf[];
 	static unsigned int Favicon_len;
 
+	void AddFunStat(const TStr& FunNm, const uint64& StartTicks, const int& StatusCd);
+
 public:
     TSAppSrv(const int& PortN, const TSAppSrvFunV& SrvFunV, const PNotify& Notify, 
-		const bool& _ShowParamP = false, const bool& _ListFunP = true);
+		const bool& _ShowParamP = false, const bool& _ListFunP = true, const bool& _WorkersP = false);
     static PWebSrv New(const int& PortN, const TSAppSrvFunV& SrvFunV, const PNotify& Notify, 
-		const bool& ShowParamP = false, const bool& ListFunP = true) { 
-            return new TSAppSrv(PortN, SrvFunV, Notify, ShowParamP, ListFunP); }
+		const bool& ShowParamP = false, const bool& ListFunP = true, const bool& WorkersP = false) { 
+            return new TSAppSrv(PortN, SrvFunV, Notify, ShowParamP, ListFunP, WorkersP); }
     
     virtual void OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq);
+
+	friend class TSAppSrvWork;
+};
+
+//////////////////////////////////////
+// Simple-App-Server-Work
+//   executes read-only function on a worker thread
+class TSAppSrvWork : public TLoopWork {
+private:
+	TSAppSrv* SAppSrv;
+	// function objects are shared between threads, no reference counting
+	TSAppSrvFun* SrvFun;
+	TStrKdV FldNmValPrV;
+	PSAppSrvRqEnv RqEnv;
+	TUInt64 StartTicks;
+	// error thrown past the function, reported on the loop thread
+	TStr ErrMsgStr;
+
+	TSAppSrvWork(TSAppSrv* _SAppSrv, TSAppSrvFun* _SrvFun, const TStrKdV& _FldNmValPrV,
+		const PSAppSrvRqEnv& _RqEnv, const uint64& _StartTicks);
+public:
+	static PLoopWork New(TSAppSrv* SAppSrv, TSAppSrvFun* SrvFun, const TStrKdV& FldNmValPrV,
+		const PSAppSrvRqEnv& RqEnv, const uint64& StartTicks) {
+			return new TSAppSrvWork(SAppSrv, SrvFun, FldNmValPrV, RqEnv, StartTicks); }
+
+	void OnExec();
+	void OnProgress();
+	void OnDone();
 };
 
 //////////////////////////////////////
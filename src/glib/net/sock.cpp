@@ -39,6 +39,16 @@ void TLoop::Unref() {
 	SockSys.UnrefLoop();
 }
 
+/////////////////////////////////////////////////
+// Loop-Work
+void TLoopWork::Notify() {
+	if (WorkHnd != 0) { SockSys.NotifyWork(WorkHnd); }
+}
+
+void TLoopWork::Queue(const PLoopWork& Work) {
+	SockSys.QueueWork(Work);
+}
+
 /////////////////////////////////////////////////
 // Socket-Event
 uint64 TSockEvent::LastSockEventId = 0;
@@ -38,6 +38,37 @@ public:
 	static void Unref();
 };
 
+/////////////////////////////////////////////////
+// Loop-Work
+//   work executed on the libuv thread pool (size set by UV_THREADPOOL_SIZE);
+//   OnExec runs on a worker thread, OnProgress and OnDone on the loop thread
+ClassTP(TLoopWork, PLoopWork)//{
+private:
+	// handle used in SockSys, zero when not queued
+	TUInt64 WorkHnd;
+
+	UndefCopyAssign(TLoopWork);
+public:
+	TLoopWork(): WorkHnd() { }
+	virtual ~TLoopWork() { }
+
+	// executed on a worker thread
+	virtual void OnExec() = 0;
+	// executed on the loop thread after Notify() and before OnDone()
+	virtual void OnProgress() { }
+	// executed on the loop thread when OnExec is finished
+	virtual void OnDone() = 0;
+
+	// can be called from OnExec to schedule OnProgress on the loop thread,
+	// calls made before the loop gets to it are merged into one
+	void Notify();
+
+	// queue work, must be called from the loop thread
+	static void Queue(const PLoopWork& Work);
+
+	friend class TSockSys;
+};
+
 /////////////////////////////////////////////////
 // Socket-Event
 //   callbacks for handling socket events
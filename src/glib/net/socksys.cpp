@@ -41,6 +41,8 @@ public:
 	// timers
 	THash<TUInt64, uv_timer_t*> SockIdToTimerHndH;
 	THash<TUInt64, TUInt64> TimerHndToSockIdH;
+	// work queued on the thread pool
+	THash<TUInt64, PLoopWork> WorkHndToWorkH;
 	
 private:
 	// we attache buffer information to write request, 
@@ -49,6 +51,13 @@ private:
 		uv_write_t WriteReq;
 		uv_buf_t Buffer;
 	} uv_write_req_t;
+	// work request with async handle for progress notifications; worker
+	// thread only sees the raw pointer, reference is kept in WorkHndToWorkH
+	typedef struct {
+		uv_work_t WorkReq;
+		uv_async_t AsyncHnd;
+		TLoopWork* Work;
+	} uv_loop_work_t;
 
 	UndefCopyAssign(TSockSys);
 
@@ -104,6 +113,12 @@ public:
 	// get local IP address
 	TStr GetLocalIpNum(const uint64& SockId);
 
+  // work
+	// queue work on the thread pool
+	void QueueWork(const PLoopWork& Work);
+	// wake up the loop to call OnProgress, thread-safe
+	void NotifyWork(const uint64& WorkHnd);
+
   // callbacks for socket and host events
 	// called as response to DNS resolving (uv_getaddrinfo)
 	static void OnGetHost(uv_getaddrinfo_t* RequestHnd, int Status, struct addrinfo* AddrInfo);
@@ -122,6 +137,16 @@ public:
 	// called on socket timeout
 	static void OnTimeOut(uv_timer_t* TimerHnd, int Status);
 
+  // callbacks for work
+	// called on worker thread
+	static void OnWorkExec(uv_work_t* WorkReq);
+	// called after notify from worker thread
+	static void OnWorkProgress(uv_async_t* AsyncHnd, int Status);
+	// called when work is finished
+	static void OnWorkDone(uv_work_t* WorkReq, int Status);
+	// called when async handle is closed
+	static void OnWorkClose(uv_handle_t* AsyncHnd);
+
   // statistics
 	// traffic count
 	uint64 GetSockBytesRead() { return SockBytesRead; }
@@ -699,6 +724,67 @@ void TSockSys::OnTimeOut(uv_timer_t* TimerHnd, int Status) {
 	SockSys.TimerHndToSockIdH.DelKey((uint64)TimerHnd);
 }
 
+void TSockSys::QueueWork(const PLoopWork& Work) {
+	IAssert(Work->WorkHnd == 0);
+	uv_loop_work_t* WorkHnd = (uv_loop_work_t*)malloc(sizeof(uv_loop_work_t));
+	WorkHnd->Work = Work();
+	WorkHnd->WorkReq.data = WorkHnd;
+	WorkHnd->AsyncHnd.data = WorkHnd;
+	// async handle must be initialized on the loop thread
+	uv_async_init(Loop, &WorkHnd->AsyncHnd, OnWorkProgress);
+	const int ResCd = uv_queue_work(Loop, &WorkHnd->WorkReq, OnWorkExec, OnWorkDone);
+	if (ResCd != 0) {
+		uv_close((uv_handle_t*)&WorkHnd->AsyncHnd, OnWorkClose);
+		throw TExcept::New("SockSys.QueueWork: Error queuing work: " + GetLastErr());
+	}
+	// keep reference until done
+	WorkHndToWorkH.AddDat((uint64)WorkHnd, Work);
+	Work->WorkHnd = (uint64)WorkHnd;
+}
+
+void TSockSys::NotifyWork(const uint64& WorkHnd) {
+	uv_async_send(&((uv_loop_work_t*)WorkHnd)->AsyncHnd);
+}
+
+void TSockSys::OnWorkExec(uv_work_t* WorkReq) {
+	uv_loop_work_t* WorkHnd = (uv_loop_work_t*)WorkReq->data;
+	try {
+		WorkHnd->Work->OnExec();
+	} catch (PExcept Except) {
+		SaveToErrLog(("SockSys.OnWorkExec: " + Except->GetMsgStr()).CStr());
+	} catch (...) {
+		SaveToErrLog("SockSys.OnWorkExec: Unknown error");
+	}
+}
+
+void TSockSys::OnWorkProgress(uv_async_t* AsyncHnd, int Status) {
+	uv_loop_work_t* WorkHnd = (uv_loop_work_t*)AsyncHnd->data;
+	WorkHnd->Work->OnProgress();
+}
+
+void TSockSys::OnWorkDone(uv_work_t* WorkReq, int Status) {
+	uv_loop_work_t* WorkHnd = (uv_loop_work_t*)WorkReq->data;
+	// take the reference, released at the end of the callback
+	PLoopWork Work = SockSys.WorkHndToWorkH.GetDat((uint64)WorkHnd);
+	SockSys.WorkHndToWorkH.DelKey((uint64)WorkHnd);
+	Work->WorkHnd = 0;
+	// no more notifications, close the async handle
+	uv_close((uv_handle_t*)&WorkHnd->AsyncHnd, OnWorkClose);
+	// notifications not yet delivered are covered by last progress call
+	try {
+		Work->OnProgress();
+		Work->OnDone();
+	} catch (PExcept Except) {
+		SaveToErrLog(("SockSys.OnWorkDone: " + Except->GetMsgStr()).CStr());
+	} catch (...) {
+		SaveToErrLog("SockSys.OnWorkDone: Unknown error");
+	}
+}
+
+void TSockSys::OnWorkClose(uv_handle_t* AsyncHnd) {
+	free(AsyncHnd->data);
+}
+
 TStr TSockSys::GetLastErr() const { 
 	return TStr(uv_err_name(uv_last_error(Loop)));
 }
@@ -709,5 +795,6 @@ TStr TSockSys::GetStatusStr(){
   ChA+="Host-Resolutions: "; ChA+=TInt::GetStr(HndToSockHostH.Len()); ChA+="\r\n";
   ChA+="Socket-Events: "; ChA+=TInt::GetStr(IdToSockEventH.Len()); ChA+="\r\n";
   ChA+="Timers: "; ChA+=TInt::GetStr(SockIdToTimerHndH.Len()); ChA+="\r\n";
+  ChA+="Work: "; ChA+=TInt::GetStr(WorkHndToWorkH.Len()); ChA+="\r\n";
   return ChA;
 }
@@ -41,6 +41,8 @@ void TWebSrvSockEvent::OnGetHost(const PSockHost& SockHost){
 
 /////////////////////////////////////////////////
 // Web-Server
+const int TWebSrv::TimeOutMSecs=25*1000;
+
 TWebSrv::TWebSrv(
  const int& _PortN, const bool& FixedPortNP, const PNotify& _Notify):
   Notify(_Notify),
@@ -77,8 +79,18 @@ void TWebSrv::OnRead(const uint64& SockId, const PSIn& SIn){
   // return & do nothing if empty packet
   if (PckChA.Empty()){return;}
   // save packet to request string
-  TChA& HttpRqChA=GetConn(SockId)->GetHttpRqChA();
-  HttpRqChA+=PckChA;
+  PWebSrvConn Conn;
+  if (!IsConn(SockId, Conn)){return;}
+  Conn->GetHttpRqChA()+=PckChA;
+  // pipelined requests wait until the current response is sent
+  if (Conn->GetType()==wsctReceiving){
+    ProcHttpRqChA(SockId);}
+}
+
+void TWebSrv::ProcHttpRqChA(const uint64& SockId){
+  PWebSrvConn Conn=GetConn(SockId);
+  TChA& HttpRqChA=Conn->GetHttpRqChA();
+  if (HttpRqChA.Empty()){return;}
   // test if the request is ok
   PSIn HttpRqSIn=TMIn::New(HttpRqChA);
   PHttpRq HttpRq=THttpRq::New(HttpRqSIn);
@@ -86,15 +98,36 @@ void TWebSrv::OnRead(const uint64& SockId, const PSIn& SIn){
   //{PSOut HttpRqSIn=TFOut::New("HttpRq.txt"); HttpRqSIn->PutStr(HttpRqChA);} //**
   // send request if http-request complete
   if (HttpRq->IsComplete()){
-    GetConn(SockId)->PutType(wsctWaitingToRespond);
+    // keep what follows the request for the next one
+    const int HttpRqLen=HttpRq->GetLen();
+    if ((0<HttpRqLen)&&(HttpRqLen<HttpRqChA.Len())){
+      HttpRqChA=HttpRqChA.GetSubStr(HttpRqLen, HttpRqChA.Len()-1);
+    } else {
+      HttpRqChA.Clr();
+    }
+    Conn->KeepAliveP=HttpRq->IsOk()&&HttpRq->IsKeepAlive();
+    Conn->ChunkedP=HttpRq->IsOk()&&(HttpRq->GetMajorVerN()==1)&&(HttpRq->GetMinorVerN()>=1);
+    Conn->PutType(wsctWaitingToRespond);
+    // each request gets full timeout
+    Conn->GetSock()->PutTimeOut(TimeOutMSecs);
     OnHttpRq(SockId, HttpRq);
   }
 }
 
 void TWebSrv::OnWrite(const uint64& SockId){
-  if (IsConn(SockId) && GetConn(SockId)->GetType()==wsctSending){
-    // delete connection when everything sent
-    DelConn(SockId);
+  PWebSrvConn Conn;
+  if (!IsConn(SockId, Conn)){return;}
+  Conn->Writes--;
+  if ((Conn->GetType()==wsctSending)&&(!Conn->IsWriting())){
+    if (Conn->IsKeepAlive()){
+      // everything sent, wait for next request
+      Conn->PutType(wsctReceiving);
+      Conn->GetSock()->PutTimeOut(TimeOutMSecs);
+      ProcHttpRqChA(SockId);
+    } else {
+      // delete connection when everything sent
+      DelConn(SockId);
+    }
   }
 }
 
@@ -102,7 +135,7 @@ void TWebSrv::OnAccept(const uint64& SockId, const PSock& Sock){
   // create new connection
   PWebSrvConn Conn=TWebSrvConn::New(Sock, this);
   AddConn(SockId, Conn);
-  Sock->PutTimeOut(25*1000);
+  Sock->PutTimeOut(TimeOutMSecs);
   Conn->PutType(wsctReceiving);
   // send message
   //TStr MsgStr=TStr("New Request [")+TInt::GetStr(SockId)+"]"; //**
@@ -214,16 +247,68 @@ void TWebSrv::OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq){
   }
 }
 
+void TWebSrv::PrepHttpResp(const PWebSrvConn& Conn, const PHttpResp& HttpResp){
+  // answer http/1.1 clients with http/1.1
+  if (Conn->IsChunked()){HttpResp->PutVer(1, 1);}
+  // with kept connection client needs to know where the response ends
+  if ((!HttpResp->IsFldNm(THttp::ContLenFldNm))&&
+   (!HttpResp->IsFldNm(THttp::TransferEncodingFldNm))){
+    HttpResp->AddFldVal(THttp::ContLenFldNm, "0");}
+  HttpResp->AddFldVal(THttp::ConnFldNm, Conn->IsKeepAlive() ?
+   THttp::ConnKeepAliveFldVal : THttp::ConnCloseFldVal);
+}
+
 void TWebSrv::SendHttpResp(const uint64& SockId, const PHttpResp& HttpResp){
   PWebSrvConn Conn;
   if (IsConn(SockId, Conn)){
     if (Conn->GetType()==wsctWaitingToRespond){
+      PrepHttpResp(Conn, HttpResp);
+      Conn->PutType(wsctSending);
       Conn->Send(HttpResp->GetSIn());
-      GetConn(SockId)->PutType(wsctSending);
+      // nothing to wait for when send failed
+      if (!Conn->IsWriting()){DelConn(SockId);}
     } else {
       OnError(SockId, -1, "Connection is not ready for http-response");
     }
   }
 }
 
+bool TWebSrv::IsChunkedResp(const uint64& SockId) const {
+  PWebSrvConn Conn;
+  return IsConn(SockId, Conn)&&Conn->IsChunked();
+}
+
+void TWebSrv::StartHttpChunks(const uint64& SockId, const PHttpResp& HttpResp){
+  PWebSrvConn Conn;
+  if (IsConn(SockId, Conn)){
+    if ((Conn->GetType()==wsctWaitingToRespond)&&(Conn->IsChunked())){
+      HttpResp->AddFldVal(THttp::TransferEncodingFldNm, THttp::ChunkedFldVal);
+      PrepHttpResp(Conn, HttpResp);
+      Conn->PutType(wsctSendingChunks);
+      Conn->Send(HttpResp->GetSIn());
+      if (!Conn->IsWriting()){DelConn(SockId);}
+    } else {
+      OnError(SockId, -1, "Connection is not ready for chunked http-response");
+    }
+  }
+}
+
+void TWebSrv::SendHttpChunk(const uint64& SockId, const char* Bf, const int& BfL){
+  PWebSrvConn Conn;
+  // empty chunk would mark the end of the response
+  if (IsConn(SockId, Conn)&&(Conn->GetType()==wsctSendingChunks)&&(BfL>0)){
+    // chunk length in hex, data, crlf
+    TMOut MOut(BfL+16);
+    MOut.PutStr(TStr::Fmt("%x\r\n", BfL)); MOut.PutBf(Bf, BfL); MOut.PutStr("\r\n");
+    Conn->Send(MOut.GetSIn());
+  }
+}
 
+void TWebSrv::EndHttpChunks(const uint64& SockId){
+  PWebSrvConn Conn;
+  if (IsConn(SockId, Conn)&&(Conn->GetType()==wsctSendingChunks)){
+    Conn->PutType(wsctSending);
+    Conn->Send(TMIn::New("0\r\n\r\n"));
+    if (!Conn->IsWriting()){DelConn(SockId);}
+  }
+}
@@ -44,8 +44,11 @@ public:
 
 /////////////////////////////////////////////////
 // Web-Server-Connection
+//   connection is kept alive between requests when client asks for it;
+//   pipelined requests wait in HttpRqChA until the previous response is sent
 typedef enum {
-  wsctUndef, wsctReceiving, wsctWaitingToRespond, wsctSending} TWebSrvConnType;
+  wsctUndef, wsctReceiving, wsctWaitingToRespond,
+  wsctSendingChunks, wsctSending} TWebSrvConnType;
 
 ClassTP(TWebSrvConn, PWebSrvConn)//{
 private:
@@ -53,6 +56,12 @@ private:
   TWebSrvConnType Type;
   PSock Sock;
   TChA HttpRqChA;
+  // keep connection after the response
+  TBool KeepAliveP;
+  // response can be sent in chunks (http/1.1)
+  TBool ChunkedP;
+  // number of writes not yet confirmed
+  TInt Writes;
   UndefDefaultCopyAssign(TWebSrvConn);
 public:
   TWebSrvConn(const PSock& _Sock, TWebSrv* _WebSrv):
@@ -65,7 +74,12 @@ public:
   TWebSrvConnType GetType() const {return Type;}
 
   PSock GetSock() const {return Sock;}
-  void Send(const PSIn& SIn) const {Sock->SendSafe(SIn);}
+  void Send(const PSIn& SIn){
+    bool Ok; TStr Msg; Sock->Send(SIn, Ok, Msg); if (Ok){Writes++;}}
+  bool IsWriting() const {return Writes>0;}
+
+  bool IsKeepAlive() const {return KeepAliveP;}
+  bool IsChunked() const {return ChunkedP;}
 
   TChA& GetHttpRqChA(){return HttpRqChA;}
 
@@ -84,6 +98,10 @@ private:
   THash<TUInt64, PWebSrvConn> SockIdToConnH;
   UndefDefaultCopyAssign(TWebSrv);
 private:
+  // parse next request from connection buffer and process it when complete
+  void ProcHttpRqChA(const uint64& SockId);
+  // set version and connection fields to match the request
+  void PrepHttpResp(const PWebSrvConn& Conn, const PHttpResp& HttpResp);
   void OnRead(const uint64& SockId, const PSIn& SIn);
   void OnWrite(const uint64& SockId);
   void OnAccept(const uint64& SockId, const PSock& Sock);
@@ -101,7 +119,7 @@ public:
     return PWebSrv(new TWebSrv(PortN, FixedPortNP, Notify));}
   virtual ~TWebSrv();
 
-  PNotify GetNotify() const {return Notify;}
+  const PNotify& GetNotify() const {return Notify;}
   int GetPortN() const {return PortN;}
   TStr GetHomeNrFPath() const {return HomeNrFPath;}
 
@@ -119,8 +137,20 @@ public:
   TStr GetPeerIpNum(const uint64& SockId) const {
     return GetConn(SockId)->Sock->GetPeerIpNum();}
 
+  // idle time after which connection is closed
+  static const int TimeOutMSecs;
+
   virtual void OnHttpRq(const uint64& SockId, const PHttpRq& HttpRq);
+  // send complete response
   void SendHttpResp(const uint64& SockId, const PHttpResp& HttpResp);
+  // chunked response: header, any number of chunks and the end;
+  // only when IsChunkedResp() (client speaks http/1.1)
+  bool IsChunkedResp(const uint64& SockId) const;
+  void StartHttpChunks(const uint64& SockId, const PHttpResp& HttpResp);
+  void SendHttpChunk(const uint64& SockId, const char* Bf, const int& BfL);
+  void EndHttpChunks(const uint64& SockId);
+  // drop the connection, e.g. after error in the middle of a response
+  void AbortHttpResp(const uint64& SockId){DelConn(SockId);}
 
   friend class TWebSrvSockEvent;
 };
@@ -16,6 +16,7 @@ TNodeJsSvmModel::TNodeJsSvmModel(const PJsonVal& ParamVal):
 		MxTime(1000*1),
 		MnDiff(1e-6),
 		Verbose(false),
+		Threads(1),
 		Notify(TNotify::NullNotify),
 		Model(nullptr) {
 
@@ -32,6 +33,7 @@ TNodeJsSvmModel::TNodeJsSvmModel(TSIn& SIn):
 	MxTime(TInt(SIn)),
 	MnDiff(TFlt(SIn)),
 	Verbose(TBool(SIn)),
+	Threads(1),
 	Notify(TNotify::NullNotify),
 	Model(nullptr) {
 
@@ -181,6 +183,16 @@ void TNodeJsSvmModel::predict(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 			const double Res = Model->Model->Predict(SpVec->Vec);
 			Args.GetReturnValue().Set(v8::Number::New(Isolate, Res));
 		}
+		else if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltVV::ClassId)) {
+			TNodeJsFltVV* Mat = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[0]->ToObject());
+			TFltV PredV; Model->Model->Predict(Mat->Mat, PredV);
+			Args.GetReturnValue().Set(TNodeJsFltV::New(PredV));
+		}
+		else if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsSpMat::ClassId)) {
+			TNodeJsSpMat* SpMat = ObjectWrap::Unwrap<TNodeJsSpMat>(Args[0]->ToObject());
+			TFltV PredV; Model->Model->Predict(SpMat->Mat, PredV);
+			Args.GetReturnValue().Set(TNodeJsFltV::New(PredV));
+		}
 		else {
 			throw TQm::TQmExcept::New("svm.predict: unsupported type of the first argument");
 		}
@@ -199,6 +211,7 @@ void TNodeJsSvmModel::UpdateParams(const PJsonVal& ParamVal) {
 	if (ParamVal->IsObjKey("maxIterations")) MxIter = ParamVal->GetObjInt("maxIterations");
 	if (ParamVal->IsObjKey("maxTime")) MxTime = 1000*ParamVal->GetObjInt("maxTime");
 	if (ParamVal->IsObjKey("minDiff")) MnDiff = ParamVal->GetObjNum("minDiff");
+	if (ParamVal->IsObjKey("threads")) Threads = ParamVal->GetObjInt("threads");
 	if (ParamVal->IsObjKey("verbose")) {
 		Verbose = ParamVal->GetObjBool("verbose");
 		Notify = Verbose ? TNotify::StdNotify : TNotify::NullNotify;
@@ -217,6 +230,7 @@ PJsonVal TNodeJsSvmModel::GetParams() const {
 	ParamVal->AddToObj("maxTime", MxTime);
 	ParamVal->AddToObj("minDiff", MnDiff);
 	ParamVal->AddToObj("verbose", Verbose);
+	ParamVal->AddToObj("threads", Threads);
 
 	return ParamVal;
 }
@@ -263,6 +277,7 @@ void TNodeJsSVC::Init(v8::Handle<v8::Object> exports) {
 	NODE_SET_PROTOTYPE_METHOD(tpl, "save", _save);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "predict", _predict);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "fit", _fit);	
+	NODE_SET_PROTOTYPE_METHOD(tpl, "fitAsync", _fitAsync);
 
 	// properties
 	tpl->InstanceTemplate()->SetAccessor(v8::String::NewFromUtf8(Isolate, "weights"), _weights);
@@ -288,34 +303,11 @@ void TNodeJsSVC::fit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 		TFltV& ClsV = ObjectWrap::Unwrap<TNodeJsFltV>(Args[1]->ToObject())->Vec;
 		if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsSpMat::ClassId)) {
 			TVec<TIntFltKdV>& VecV = ObjectWrap::Unwrap<TNodeJsSpMat>(Args[0]->ToObject())->Mat;
-			if (Model->Algorithm == "SGD") {
-				Model->Model = new TSvm::TLinModel(TSvm::SolveClassify<TVec<TIntFltKdV>>(VecV, TLAMisc::GetMaxDimIdx(VecV) + 1,
-					VecV.Len(), ClsV, Model->SvmCost, Model->SvmUnbalance, Model->MxTime,
-					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify));
-			}
-			else if (Model->Algorithm == "PR_LOQO") {
-				PSVMTrainSet TrainSet = TRefSparseTrainSet::New(VecV, ClsV);
-				PSVMModel SvmModel = TSVMModel::NewClsLinear(TrainSet, Model->SvmCost, Model->SvmUnbalance,
-					TIntV(), TSVMLearnParam::Lin(Model->MxTime, Model->Verbose ? 2 : 0));
-
-				Model->Model = new TSvm::TLinModel(SvmModel->GetWgtV(), SvmModel->GetThresh());
-			}
+			Model->Model = FitClassify(Model, VecV, ClsV);
 		}
 		else if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltVV::ClassId)) {
 			TFltVV& VecV = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[0]->ToObject())->Mat;
-			if (Model->Algorithm == "SGD") {
-				Model->Model = new TSvm::TLinModel(TSvm::SolveClassify<TFltVV>(VecV, VecV.GetRows(),
-					VecV.GetCols(), ClsV, Model->SvmCost, Model->SvmUnbalance, Model->MxTime,
-					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify));
-			}
-			else if (Model->Algorithm == "PR_LOQO") {
-				PSVMTrainSet TrainSet = TRefDenseTrainSet::New(VecV, ClsV);
-				PSVMModel SvmModel = TSVMModel::NewClsLinear(TrainSet, Model->SvmCost, Model->SvmUnbalance,
-					TIntV(), TSVMLearnParam::Lin(Model->MxTime, Model->Verbose ? 2 : 0));
-
-
-				Model->Model = new TSvm::TLinModel(SvmModel->GetWgtV(), SvmModel->GetThresh());
-			}
+			Model->Model = FitClassify(Model, VecV, ClsV);
 		}
 		Args.GetReturnValue().Set(Args.Holder());
 	}
@@ -324,6 +316,104 @@ void TNodeJsSVC::fit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	}
 }
 
+// Fits classification model on the thread pool. The examples and targets are
+// pinned for the duration of the task, the new model replaces the old one
+// on the main thread once fitting is done.
+class TNodeJsSVCFitTask : public TNodeJsAsyncTask {
+private:
+	TNodeJsSvmModel* Model;
+	TFltV& ClsV;
+	TVec<TIntFltKdV>* SpVecV;
+	TFltVV* VecV;
+	TSvm::TLinModel* NewModel;
+public:
+	TNodeJsSVCFitTask(const v8::Local<v8::Function>& Callback, TNodeJsSvmModel* _Model,
+		TFltV& _ClsV, TVec<TIntFltKdV>* _SpVecV, TFltVV* _VecV):
+		TNodeJsAsyncTask(Callback), Model(_Model), ClsV(_ClsV), SpVecV(_SpVecV), VecV(_VecV), NewModel(nullptr) { }
+	~TNodeJsSVCFitTask() { if (NewModel != nullptr) { delete NewModel; } }
+
+	void Run() {
+		NewModel = (SpVecV != nullptr) ?
+			TNodeJsSVC::FitClassify(Model, *SpVecV, ClsV) :
+			TNodeJsSVC::FitClassify(Model, *VecV, ClsV);
+	}
+
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) {
+		Model->ClrModel();
+		Model->Model = NewModel;
+		NewModel = nullptr;
+		return Model->handle();
+	}
+};
+
+void TNodeJsSVC::fitAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+
+	QmAssertR(Args.Length() == 3, "SVC.fitAsync: expects 3 arguments");
+	QmAssertR(Args[0]->IsObject(), "first argument expected to be object");
+	QmAssertR(Args[1]->IsObject(), "SCV.fitAsync: second argument expected to be object");
+
+	try {
+		TNodeJsSvmModel* Model = ObjectWrap::Unwrap<TNodeJsSvmModel>(Args.Holder());
+		v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, 2);
+
+		TFltV& ClsV = ObjectWrap::Unwrap<TNodeJsFltV>(Args[1]->ToObject())->Vec;
+		TNodeJsSVCFitTask* Task = nullptr;
+		if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsSpMat::ClassId)) {
+			TVec<TIntFltKdV>& VecV = ObjectWrap::Unwrap<TNodeJsSpMat>(Args[0]->ToObject())->Mat;
+			Task = new TNodeJsSVCFitTask(Callback, Model, ClsV, &VecV, nullptr);
+		}
+		else if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltVV::ClassId)) {
+			TFltVV& VecV = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[0]->ToObject())->Mat;
+			Task = new TNodeJsSVCFitTask(Callback, Model, ClsV, nullptr, &VecV);
+		}
+		else {
+			throw TQm::TQmExcept::New("SVC.fitAsync: unsupported type of the first argument");
+		}
+		// model, examples and targets must stay alive until fitted
+		Task->Pin(Args.Holder());
+		Task->Pin(Args[0]);
+		Task->Pin(Args[1]);
+		TNodeJsAsyncTask::Queue(Task);
+	}
+	catch (const PExcept& Except) {
+		throw TQm::TQmExcept::New(Except->GetMsgStr(), "SVC.fitAsync");
+	}
+}
+
+TSvm::TLinModel* TNodeJsSVC::FitClassify(const TNodeJsSvmModel* Model, TVec<TIntFltKdV>& VecV, TFltV& ClsV) {
+	if (Model->Algorithm == "SGD") {
+		return new TSvm::TLinModel(TSvm::SolveClassify<TVec<TIntFltKdV>>(VecV, TLAMisc::GetMaxDimIdx(VecV) + 1,
+			VecV.Len(), ClsV, Model->SvmCost, Model->SvmUnbalance, Model->MxTime,
+			Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify, Model->Threads));
+	}
+	else if (Model->Algorithm == "PR_LOQO") {
+		PSVMTrainSet TrainSet = TRefSparseTrainSet::New(VecV, ClsV);
+		PSVMModel SvmModel = TSVMModel::NewClsLinear(TrainSet, Model->SvmCost, Model->SvmUnbalance,
+			TIntV(), TSVMLearnParam::Lin(Model->MxTime, Model->Verbose ? 2 : 0));
+
+		return new TSvm::TLinModel(SvmModel->GetWgtV(), SvmModel->GetThresh());
+	}
+	return nullptr;
+}
+
+TSvm::TLinModel* TNodeJsSVC::FitClassify(const TNodeJsSvmModel* Model, TFltVV& VecV, TFltV& ClsV) {
+	if (Model->Algorithm == "SGD") {
+		return new TSvm::TLinModel(TSvm::SolveClassify<TFltVV>(VecV, VecV.GetRows(),
+			VecV.GetCols(), ClsV, Model->SvmCost, Model->SvmUnbalance, Model->MxTime,
+			Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify, Model->Threads));
+	}
+	else if (Model->Algorithm == "PR_LOQO") {
+		PSVMTrainSet TrainSet = TRefDenseTrainSet::New(VecV, ClsV);
+		PSVMModel SvmModel = TSVMModel::NewClsLinear(TrainSet, Model->SvmCost, Model->SvmUnbalance,
+			TIntV(), TSVMLearnParam::Lin(Model->MxTime, Model->Verbose ? 2 : 0));
+
+		return new TSvm::TLinModel(SvmModel->GetWgtV(), SvmModel->GetThresh());
+	}
+	return nullptr;
+}
+
 v8::Persistent<v8::Function> TNodeJsSVR::constructor;
 
 void TNodeJsSVR::Init(v8::Handle<v8::Object> exports) {
@@ -369,7 +459,7 @@ void TNodeJsSVR::fit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 			if (Model->Algorithm == "SGD") {
 				Model->Model = new TSvm::TLinModel(TSvm::SolveRegression<TVec<TIntFltKdV>>(VecV, TLAMisc::GetMaxDimIdx(VecV) + 1,
 					VecV.Len(), ValV, Model->SvmCost, Model->SvmEps, Model->MxTime,
-					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify));
+					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify, Model->Threads));
 			}
 			else if (Model->Algorithm == "PR_LOQO") {
 				PSVMTrainSet TrainSet = TRefSparseTrainSet::New(VecV, ValV);
@@ -384,7 +474,7 @@ void TNodeJsSVR::fit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 			if (Model->Algorithm == "SGD") {
 				Model->Model = new TSvm::TLinModel(TSvm::SolveRegression<TFltVV>(VecV, VecV.GetRows(),
 					VecV.GetCols(), ValV, Model->SvmCost, Model->SvmEps, Model->MxTime,
-					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify));
+					Model->MxIter, Model->MnDiff, Model->SampleSize, Model->Notify, Model->Threads));
 			}
 			else if (Model->Algorithm == "PR_LOQO") {
 				PSVMTrainSet TrainSet = TRefDenseTrainSet::New(VecV, ValV);
@@ -1345,20 +1435,9 @@ void TNodeJsNNet::fit(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	    else if(TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltVV::ClassId)){
 			TNodeJsFltVV* JsVVecIn = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[0]->ToObject());
 			TNodeJsFltVV* JsVVecTarget = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[1]->ToObject());
-	        for(int Row = 0; Row < JsVVecIn->Mat.GetRows(); Row++){
-	            TFltV InFltV;
-	            JsVVecIn->Mat.GetRow(Row, InFltV);
-	            Model->Model->FeedFwd(InFltV);
-	            // then check how we performed and learn
-	            TFltV TargFltV;
-	            JsVVecTarget->Mat.GetRow(Row, TargFltV);
-	            if(Row == JsVVecIn->Mat.GetRows() - 1){
-	                Model->Model->BackProp(TargFltV);
-	            }
-	            else {
-	                Model->Model->BackProp(TargFltV, false);
-	            }
-	        }
+			// process the whole mini-batch (one sample per row) at once
+			Model->Model->FeedFwd(JsVVecIn->Mat);
+			Model->Model->BackProp(JsVVecTarget->Mat);
 	    }
 	    else {
 	    	// TODO: throw an error
@@ -1380,8 +1459,20 @@ void TNodeJsNNet::predict(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	try {
 		TNodeJsNNet* Model = ObjectWrap::Unwrap<TNodeJsNNet>(Args.Holder());
 
+		if (TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltVV::ClassId)) {
+			TNodeJsFltVV* JsVVec = ObjectWrap::Unwrap<TNodeJsFltVV>(Args[0]->ToObject());
+
+			Model->Model->FeedFwd(JsVVec->Mat);
+
+			TFltVV FltVV;
+			Model->Model->GetResults(FltVV);
+
+			Args.GetReturnValue().Set(TNodeJsFltVV::New(FltVV));
+			return;
+		}
+
 		QmAssertR(TNodeJsUtil::IsArgClass(Args, 0, TNodeJsFltV::GetClassId()),
-				"NNet.predict: The first argument must be a JsTFltV (js linalg full vector)");
+				"NNet.predict: The first argument must be a JsTFltV or JsTFltVV (js linalg full vector or matrix)");
 		TNodeJsFltV* JsVec = ObjectWrap::Unwrap<TNodeJsFltV>(Args[0]->ToObject());
 
 		Model->Model->FeedFwd(JsVec->Vec);
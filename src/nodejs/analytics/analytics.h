@@ -21,6 +21,7 @@ class TNodeJsSvmModel : public node::ObjectWrap {
 	friend class TNodeJsUtil;
 	friend class TNodeJsSVC;
 	friend class TNodeJsSVR;
+	friend class TNodeJsSVCFitTask;
 private:
 	TStr Algorithm;	
 	double SvmCost;	
@@ -31,6 +32,7 @@ private:
 	int MxTime;
 	double MnDiff;
 	bool Verbose;
+	int Threads; // not persisted
 	PNotify Notify;
 
 	TSvm::TLinModel* Model;
@@ -57,6 +59,8 @@ public:
 	JsDeclareFunction(save);
 	//- `num = svmModel.predict(vec)` -- sends vector `vec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
 	//- `num = svmModel.predict(spVec)` -- sends sparse vector `spVec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
+	//- `vec = svmModel.predict(mat)` -- sends each column of matrix `mat` through the model and returns the predictions as a vector `vec`
+	//- `vec = svmModel.predict(spMat)` -- sends each column of sparse matrix `spMat` through the model and returns the predictions as a vector `vec`
 	JsDeclareFunction(predict);
 
 private:
@@ -73,6 +77,7 @@ private:
 //#
 //# Holds a SVM classification model. This object is result of `new analytics.SVC(...)`.
 class TNodeJsSVC : public TNodeJsSvmModel {
+	friend class TNodeJsSVCFitTask;
 	static v8::Persistent <v8::Function> constructor;
 public:
 	static void Init(v8::Handle<v8::Object> exports);
@@ -80,8 +85,8 @@ public:
 	//# **Constructor:**
 	//#
 	//#- `svmModel = new analytics.SVC(fin)` -- constructs a new support vector classifier
-	//#- `svmModel = new analytics.SVC(svmParameters)` -- constructs a new support vector classifier using `svmParameters`, which is a JSON object. `svmParameters = {c: 1.0, j: 1.0, batchSize: 10000, maxIterations: 10000, maxTime: 600, minDiff: 1e-6, verbose: false}`. 
-	//#     The parameter `c` is the SVM cost parameter, `j` (factor to multiply SVM cost parameter for positive examples with (default is 1.0)), `batchSize` controls the sample size for stochastic subgradient calculations, `maxIterations` limits the number of subgradient steps, `maxTime` limits the runtime in seconds, `minDiff` is a tolerance that is used as a stopping condition, `verbose` controls verbosity of the algorithm; result is a linear model
+	//#- `svmModel = new analytics.SVC(svmParameters)` -- constructs a new support vector classifier using `svmParameters`, which is a JSON object. `svmParameters = {c: 1.0, j: 1.0, batchSize: 10000, maxIterations: 10000, maxTime: 600, minDiff: 1e-6, verbose: false, threads: 1}`. 
+	//#     The parameter `c` is the SVM cost parameter, `j` (factor to multiply SVM cost parameter for positive examples with (default is 1.0)), `batchSize` controls the sample size for stochastic subgradient calculations, `maxIterations` limits the number of subgradient steps, `maxTime` limits the runtime in seconds, `minDiff` is a tolerance that is used as a stopping condition, `verbose` controls verbosity of the algorithm, `threads` is the number of threads used to process each batch (results are reproducible for a fixed number of threads); result is a linear model
 	//#
 	//# **Functions and properties:**
 	//#
@@ -91,9 +96,21 @@ public:
 	//#- `fout = SVC.save(fout)` -- saves model to output stream `fout`. Returns `fout`.
 	//#- `num = SVC.predict(vec)` -- sends vector `vec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
 	//#- `num = SVC.predict(spVec)` -- sends sparse vector `spVec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
+	//#- `vec = SVC.predict(mat)` -- sends each column of matrix `mat` through the model and returns the predictions as a vector `vec`
+	//#- `vec = SVC.predict(spMat)` -- sends each column of sparse matrix `spMat` through the model and returns the predictions as a vector `vec`
 	//#- `svmModel = SVC.fit(spMat,vec)` -- fits an SVM model, given column examples in a sparse matrix `spMat` and vector of targets `vec`
 	//#- `svmModel = SVC.fit(mat,vec)` -- fits an SVM model, given column examples in a matrix `mat` and vector of targets `vec`
 	JsDeclareFunction(fit);
+	//#- `SVC.fitAsync(spMat,vec,callback)` -- fits an SVM model on the thread pool, given column examples in a sparse matrix `spMat` and vector of targets `vec`,
+	//#     and calls `callback(err, svmModel)` when done. Until then the previous model is used for predictions.
+	//#- `SVC.fitAsync(mat,vec,callback)` -- fits an SVM model on the thread pool, given column examples in a matrix `mat` and vector of targets `vec`,
+	//#     and calls `callback(err, svmModel)` when done. Until then the previous model is used for predictions.
+	JsDeclareFunction(fitAsync);
+
+private:
+	// fits a new classification model using parameters from Model
+	static TSvm::TLinModel* FitClassify(const TNodeJsSvmModel* Model, TVec<TIntFltKdV>& VecV, TFltV& ClsV);
+	static TSvm::TLinModel* FitClassify(const TNodeJsSvmModel* Model, TFltVV& VecV, TFltV& ClsV);
 };
 
 ///////////////////////////////
@@ -110,8 +127,8 @@ public:
 	//# **Constructor:**
 	//#
 	//#- `svmModel = new analytics.SVR(fin)` -- constructs a new support vector classifier
-	//#- `svmModel = new analytics.SVR(svmParameters)` -- constructs a new support vector regression using `svmParameters`, which is a JSON object. `svmParameters = {c: 1.0, j: 1.0, batchSize: 10000, maxIterations: 10000, maxTime: 600, minDiff: 1e-6, verbose: false}`. 
-	//#     The parameter `c` is the SVM cost parameter, `j` (factor to multiply SVM cost parameter for positive examples with (default is 1.0)), `batchSize` controls the sample size for stochastic subgradient calculations, `maxIterations` limits the number of subgradient steps, `maxTime` limits the runtime in seconds, `minDiff` is a tolerance that is used as a stopping condition, `verbose` controls verbosity of the algorithm; result is a linear model
+	//#- `svmModel = new analytics.SVR(svmParameters)` -- constructs a new support vector regression using `svmParameters`, which is a JSON object. `svmParameters = {c: 1.0, j: 1.0, batchSize: 10000, maxIterations: 10000, maxTime: 600, minDiff: 1e-6, verbose: false, threads: 1}`. 
+	//#     The parameter `c` is the SVM cost parameter, `j` (factor to multiply SVM cost parameter for positive examples with (default is 1.0)), `batchSize` controls the sample size for stochastic subgradient calculations, `maxIterations` limits the number of subgradient steps, `maxTime` limits the runtime in seconds, `minDiff` is a tolerance that is used as a stopping condition, `verbose` controls verbosity of the algorithm, `threads` is the number of threads used to process each batch (results are reproducible for a fixed number of threads); result is a linear model
 	//#
 	//# **Functions and properties:**
 	//#
@@ -123,6 +140,8 @@ public:
 	//#- `svmModel = SVR.fit(mat,vec)` -- fits an SVM model, given column examples in a matrix `mat` and vector of targets `vec`
 	//#- `num = SVR.predict(vec)` -- sends vector `vec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
 	//#- `num = SVR.predict(spVec)` -- sends sparse vector `spVec` through the model and returns the prediction as a real number `num` (-1 or 1 for classification)
+	//#- `vec = SVR.predict(mat)` -- sends each column of matrix `mat` through the model and returns the predictions as a vector `vec`
+	//#- `vec = SVR.predict(spMat)` -- sends each column of sparse matrix `spMat` through the model and returns the predictions as a vector `vec`
 	JsDeclareFunction(fit);	
 };
 
@@ -299,10 +318,13 @@ public:
 
 	JsDeclareFunction(New);
     //#- `NNet = NNet.fit(vec,vec)` -- fits the NNet model in online mode
-    //#- `NNet = NNet.fit(mat,mat)` -- fits the NNet model in batch mode
+    //#- `NNet = NNet.fit(mat,mat)` -- fits the NNet model in batch mode, processing
+    //#     all samples (rows of the input and target matrices) at once
 	JsDeclareFunction(fit);
     //#- `vec = NNet.predict(vec)` -- sends vector `vec` through the
     //#     model and returns the prediction as a vector `vec`
+    //#- `mat2 = NNet.predict(mat)` -- sends each row of matrix `mat` through the
+    //#     model and returns the predictions as rows of matrix `mat2`
 	JsDeclareFunction(predict);
 	//#- `NNet.setLearnRate(num)` -- Sets the new learn rate for the network
 	JsDeclareFunction(setLearnRate);
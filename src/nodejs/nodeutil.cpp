@@ -104,6 +104,18 @@ v8::Local<v8::Value> TNodeJsUtil::ParseJson(v8::Isolate* Isolate, const PJsonVal
     }
 }
 
+v8::Local<v8::Value> TNodeJsUtil::ParseJsonStr(v8::Isolate* Isolate, const TChA& JsonChA) {
+    v8::EscapableHandleScope HandleScope(Isolate);
+
+    v8::Handle<v8::Context> Context = Isolate->GetCurrentContext();
+    v8::Local<v8::Object> JSON = Context->Global()->Get(v8::String::NewFromUtf8(Isolate, "JSON"))->ToObject();
+    v8::Local<v8::Function> Fun = v8::Local<v8::Function>::Cast(JSON->Get(v8::String::NewFromUtf8(Isolate, "parse")));
+
+    v8::Local<v8::Value> ArgV[1] = { v8::String::NewFromUtf8(Isolate, JsonChA.CStr(),
+        v8::String::kNormalString, JsonChA.Len()) };
+    return HandleScope.Escape(Fun->Call(Context->Global(), 1, ArgV));
+}
+
 TStr TNodeJsUtil::GetStr(const v8::Local<v8::String>& V8Str) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -147,6 +159,15 @@ bool TNodeJsUtil::IsArgFun(const v8::FunctionCallbackInfo<v8::Value>& Args, cons
     return Val->IsFunction();
 }
 
+v8::Local<v8::Function> TNodeJsUtil::GetArgFun(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::EscapableHandleScope HandleScope(Isolate);
+
+    EAssertR(IsArgFun(Args, ArgN), TStr::Fmt("Argument %d expected to be function", ArgN).CStr());
+
+    return HandleScope.Escape(v8::Local<v8::Function>::Cast(Args[ArgN]));
+}
+
 bool TNodeJsUtil::IsArgObj(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::HandleScope HandleScope(Isolate);
@@ -365,8 +386,8 @@ v8::Local<v8::Value> TNodeJsUtil::V8JsonToV8Str(const v8::Handle<v8::Value>& Jso
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
 	v8::EscapableHandleScope HandleScope(Isolate);
 
-	v8::Handle<v8::Context> Context = v8::Context::New(Isolate);
-	v8::Context::Scope ContextScope(Context);
+	// use the calling context, creating a new one for each call is expensive
+	v8::Handle<v8::Context> Context = Isolate->GetCurrentContext();
 
 	v8::Local<v8::Object> JSON = Context->Global()->Get(v8::String::NewFromUtf8(Isolate, "JSON"))->ToObject();
 	v8::Local<v8::Value> FunObj = JSON->Get(v8::String::NewFromUtf8(Isolate, "stringify"));
@@ -381,6 +402,26 @@ v8::Local<v8::Value> TNodeJsUtil::V8JsonToV8Str(const v8::Handle<v8::Value>& Jso
 	return HandleScope.Escape(JsonStr);
 }
 
+bool TNodeJsUtil::IsPlainJson(const v8::Local<v8::Value>& Val) {
+	if (Val->IsNull() || Val->IsBoolean() || Val->IsString()) { return true; }
+	if (Val->IsNumber()) { return TFlt::IsNum(Val->NumberValue()); }
+	if (!Val->IsObject() || Val->IsFunction() || Val->IsDate() || Val->IsRegExp() ||
+		Val->IsBooleanObject() || Val->IsNumberObject() || Val->IsStringObject()) { return false; }
+	if (Val->IsArray()) {
+		v8::Local<v8::Array> Arr = v8::Local<v8::Array>::Cast(Val);
+		for (uint ElN = 0; ElN < Arr->Length(); ElN++) {
+			if (!IsPlainJson(Arr->Get(ElN))) { return false; }
+		}
+		return true;
+	}
+	v8::Local<v8::Object> Obj = Val->ToObject();
+	v8::Local<v8::Array> FldNmV = Obj->GetOwnPropertyNames();
+	for (uint FldN = 0; FldN < FldNmV->Length(); FldN++) {
+		if (!IsPlainJson(Obj->Get(FldNmV->Get(FldN)))) { return false; }
+	}
+	return true;
+}
+
 v8::Local<v8::Value> TNodeJsUtil::GetStrArr(const TStrV& StrV) {
     v8::Isolate* Isolate = v8::Isolate::GetCurrent();
     v8::EscapableHandleScope EscapableHandleScope(Isolate);
@@ -402,4 +443,115 @@ PMem TNodeJsUtil::GetArgMem(const v8::FunctionCallbackInfo<v8::Value>& Args, con
 	if (ExternalType != v8::ExternalArrayType::kExternalUint8Array) return TMem::New();
 	int Len = Obj->GetIndexedPropertiesExternalArrayDataLength();
 	return TMem::New(static_cast<char*>(Obj->GetIndexedPropertiesExternalArrayData()), Len);
-}
\ No newline at end of file
+}
+//////////////////////////////////////////////////////
+// Node - Asynchronous Task
+int TNodeJsAsyncTask::Pending = 0;
+TNodeJsAsyncTask* TNodeJsAsyncTask::FirstSerial = NULL;
+TNodeJsAsyncTask* TNodeJsAsyncTask::LastSerial = NULL;
+
+TNodeJsAsyncTask::TNodeJsAsyncTask(const v8::Local<v8::Function>& _Callback, const bool& _SerialP):
+        Pins(0), SerialP(_SerialP), NextSerial(NULL) {
+
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    Request.data = this;
+    Callback.Reset(Isolate, _Callback);
+    PinV.Reset(Isolate, v8::Array::New(Isolate));
+}
+
+TNodeJsAsyncTask::~TNodeJsAsyncTask() {
+    Callback.Reset();
+    PinV.Reset();
+}
+
+void TNodeJsAsyncTask::Pin(const v8::Local<v8::Value>& Val) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    v8::Local<v8::Array> Arr = v8::Local<v8::Array>::New(Isolate, PinV);
+    Arr->Set(Pins++, Val);
+}
+
+void TNodeJsAsyncTask::Queue(TNodeJsAsyncTask* Task) {
+    if (Task->SerialP && LastSerial != NULL) {
+        // wait for the running serial task to finish
+        LastSerial->NextSerial = Task; LastSerial = Task;
+        Pending++; return;
+    }
+    const int Err = uv_queue_work(uv_default_loop(), &Task->Request, RunCb, AfterRunCb);
+    if (Err != 0) {
+        delete Task;
+        throw TExcept::New(TStr::Fmt("Unable to queue asynchronous task: %s", uv_strerror(Err)));
+    }
+    if (Task->SerialP) { FirstSerial = LastSerial = Task; }
+    Pending++;
+}
+
+void TNodeJsAsyncTask::RunCb(uv_work_t* Req) {
+    TNodeJsAsyncTask* Task = static_cast<TNodeJsAsyncTask*>(Req->data);
+    // exceptions must not leave the worker thread
+    try {
+        Task->Run();
+    } catch (const PExcept& Except) {
+        Task->ErrorMsg = Except->GetMsgStr();
+    } catch (const std::exception& Except) {
+        Task->ErrorMsg = Except.what();
+    } catch (...) {
+        Task->ErrorMsg = "Unknown exception";
+    }
+}
+
+void TNodeJsAsyncTask::AfterRunCb(uv_work_t* Req, int Status) {
+    TNodeJsAsyncTask* Task = static_cast<TNodeJsAsyncTask*>(Req->data);
+    Pending--;
+    // start next serial task
+    TVec<TNodeJsAsyncTask*> FailedTaskV;
+    if (Task->SerialP) {
+        FirstSerial = Task->NextSerial;
+        QueueNextSerial(FailedTaskV);
+    }
+    Finish(Task);
+    // tasks which could not be started get the error
+    for (int TaskN = 0; TaskN < FailedTaskV.Len(); TaskN++) {
+        Finish(FailedTaskV[TaskN]);
+    }
+}
+
+void TNodeJsAsyncTask::QueueNextSerial(TVec<TNodeJsAsyncTask*>& FailedTaskV) {
+    while (FirstSerial != NULL) {
+        const int Err = uv_queue_work(uv_default_loop(), &FirstSerial->Request, RunCb, AfterRunCb);
+        if (Err == 0) { return; }
+        // drop the task from the queue and try the next one
+        FirstSerial->ErrorMsg = TStr::Fmt("Unable to queue asynchronous task: %s", uv_strerror(Err));
+        FailedTaskV.Add(FirstSerial); Pending--;
+        FirstSerial = FirstSerial->NextSerial;
+    }
+    LastSerial = NULL;
+}
+
+void TNodeJsAsyncTask::Finish(TNodeJsAsyncTask* Task) {
+    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope HandleScope(Isolate);
+
+    // prepare arguments for callback(err, result)
+    v8::Handle<v8::Value> ArgV[2] = { v8::Null(Isolate), v8::Undefined(Isolate) };
+    if (Task->ErrorMsg.Empty()) {
+        try {
+            ArgV[1] = Task->GetResult(Isolate);
+        } catch (const PExcept& Except) {
+            Task->ErrorMsg = Except->GetMsgStr();
+        }
+    }
+    if (!Task->ErrorMsg.Empty()) {
+        ArgV[0] = v8::Exception::Error(v8::String::NewFromUtf8(Isolate,
+            TStr("[addon] Exception: " + Task->ErrorMsg).CStr()));
+        ArgV[1] = v8::Undefined(Isolate);
+    }
+    v8::Local<v8::Function> Fun = v8::Local<v8::Function>::New(Isolate, Task->Callback);
+    // release the task before calling back, so the callback sees
+    // the state without this task (e.g. base can be closed)
+    delete Task;
+    node::MakeCallback(Isolate, Isolate->GetCurrentContext()->Global(), Fun, 2, ArgV);
+}
@@ -7,6 +7,7 @@
 
 #include <node.h>
 #include <node_object_wrap.h>
+#include <uv.h>
 #include "base.h"
 
 #define JsDeclareProperty(Function) \
@@ -119,6 +120,8 @@ public:
     static PJsonVal GetObjProps(const v8::Local<v8::Object>& Obj) { return GetObjJson(Obj, true); }
     /// Convert GLib Json (PJsonVal) to v8 Json
     static v8::Local<v8::Value> ParseJson(v8::Isolate* Isolate, const PJsonVal& JsonVal);
+    /// Convert serialized JSON (e.g. output of TJsonWriter) to v8 Json using JSON.parse
+    static v8::Local<v8::Value> ParseJsonStr(v8::Isolate* Isolate, const TChA& JsonChA);
 
     /// Transform V8 string to TStr
     static TStr GetStr(const v8::Local<v8::String>& V8Str);
@@ -137,6 +140,8 @@ public:
     static bool IsArgClass(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN, const TStr& ClassNm);
     /// Check if is argument ArgN of type v8::Function
     static bool IsArgFun(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN);
+    /// Extract argument ArgN as a function
+    static v8::Local<v8::Function> GetArgFun(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN);
     /// Check if is argument ArgN of type v8::Object
     static bool IsArgObj(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN);
     /// Check if is argument ArgN of type v8::Bool
@@ -200,6 +205,9 @@ public:
 
 	static v8::Local<v8::Value> V8JsonToV8Str(const v8::Handle<v8::Value>& Json);
 	static TStr JSONStringify(const v8::Handle<v8::Value>& Json) { return GetStr(V8JsonToV8Str(Json)->ToString()); }
+	/// Checks that JSON.stringify keeps all values as GetObjJson sees them: no NaN or
+	/// infinite numbers (stringified as null), dates, regular expressions, functions or undefined
+	static bool IsPlainJson(const v8::Local<v8::Value>& Val);
 
     /// TStrV -> v8 string array
     static v8::Local<v8::Value> GetStrArr(const TStrV& StrV);	
@@ -208,6 +216,63 @@ public:
 	static PMem GetArgMem(const v8::FunctionCallbackInfo<v8::Value>& Args, const int& ArgN);
 };
 
+//////////////////////////////////////////////////////
+// Node - Asynchronous Task
+/// Work executed on the libuv thread pool, off the event loop. Arguments are
+/// extracted and the JavaScript objects the work depends on are pinned on the
+/// main thread, Run() is executed on a worker thread and must not touch V8,
+/// GetResult() converts the result back on the main thread, which is then
+/// passed to the node-style callback `callback(err, result)`. Serial tasks
+/// (e.g. writes) are executed one at a time in the order they were queued.
+class TNodeJsAsyncTask {
+private:
+    /// Number of queued tasks that did not finish yet
+    static int Pending;
+    /// Serial tasks waiting for execution, first one is running
+    static TNodeJsAsyncTask* FirstSerial;
+    static TNodeJsAsyncTask* LastSerial;
+
+    uv_work_t Request;
+    /// Callback called with the result
+    v8::Persistent<v8::Function> Callback;
+    /// Objects which must stay alive until the task finishes
+    v8::Persistent<v8::Array> PinV;
+    int Pins;
+    /// Executed after all previously queued serial tasks
+    bool SerialP;
+    TNodeJsAsyncTask* NextSerial;
+    /// Set when Run() throws
+    TStr ErrorMsg;
+
+    static void RunCb(uv_work_t* Req);
+    static void AfterRunCb(uv_work_t* Req, int Status);
+    /// Start the first waiting serial task. Tasks which can not be started
+    /// are removed from the queue and added to FailedTaskV.
+    static void QueueNextSerial(TVec<TNodeJsAsyncTask*>& FailedTaskV);
+    /// Call the callback with the result or the error and delete the task
+    static void Finish(TNodeJsAsyncTask* Task);
+
+protected:
+    TNodeJsAsyncTask(const v8::Local<v8::Function>& _Callback, const bool& _SerialP = false);
+
+    /// Executed on a worker thread, no V8 calls allowed
+    virtual void Run() = 0;
+    /// Executed on the main thread after Run() finished successfully
+    virtual v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) { return v8::Undefined(Isolate); }
+
+public:
+    virtual ~TNodeJsAsyncTask();
+
+    /// Keep JavaScript object alive until the task finishes
+    void Pin(const v8::Local<v8::Value>& Val);
+    /// Queue task on the thread pool; the queue takes ownership of the task
+    static void Queue(TNodeJsAsyncTask* Task);
+    /// Number of queued tasks that did not finish yet
+    static int GetPending() { return Pending; }
+    /// True when there are serial tasks queued or running
+    static bool IsSerialPending() { return FirstSerial != NULL; }
+};
+
 template <class TVal>
 void TNodeJsUtil::ExecuteVoid(const v8::Handle<v8::Function>& Fun, const v8::Local<TVal>& Arg) {
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
@@ -91,6 +91,8 @@ void TNodeJsQm::create(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 		TWPt<TQm::TBase> Base_ = TQm::TStorage::NewBase(Param.DbFPath, SchemaVal, Param.IndexCacheSize, Param.DefStoreCacheSize);
 		// save base		
 		TQm::TStorage::SaveBase(Base_);
+		// log updates when configured
+		if (Param.WalP) { Base_->InitWal(Param.WalCommitMSecs, Param.WalCheckpointLen, Param.WalCheckpointMSecs); }
 		Args.GetReturnValue().Set(TNodeJsBase::New(Base_));
 		// once the base is open we need to setup the custom record templates for each store
 		if (!TNodeJsQm::BaseFPathToId.IsKey(Base_->GetFPath())) {
@@ -134,6 +136,8 @@ void TNodeJsQm::open(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 		// load base
 		TWPt<TQm::TBase> Base_ = TQm::TStorage::LoadBase(Param.DbFPath, FAccess,
 			Param.IndexCacheSize, Param.DefStoreCacheSize, Param.StoreNmCacheSizeH);
+		// log updates when configured, replaying log left by a crash
+		if (Param.WalP && !RdOnlyP) { Base_->InitWal(Param.WalCommitMSecs, Param.WalCheckpointLen, Param.WalCheckpointMSecs); }
 		Args.GetReturnValue().Set(TNodeJsBase::New(Base_));
 		// once the base is open we need to setup the custom record templates for each store
 		if (!TNodeJsQm::BaseFPathToId.IsKey(Base_->GetFPath())) {
@@ -169,6 +173,7 @@ void TNodeJsBase::Init(v8::Handle<v8::Object> exports) {
    NODE_SET_PROTOTYPE_METHOD(tpl, "getStoreList", _getStoreList);
    NODE_SET_PROTOTYPE_METHOD(tpl, "createStore", _createStore);
    NODE_SET_PROTOTYPE_METHOD(tpl, "search", _search);
+   NODE_SET_PROTOTYPE_METHOD(tpl, "searchAsync", _searchAsync);
    NODE_SET_PROTOTYPE_METHOD(tpl, "gc", _gc);
    NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggr", _getStreamAggr);
    NODE_SET_PROTOTYPE_METHOD(tpl, "getStreamAggrNames", _getStreamAggrNames);
@@ -247,6 +252,8 @@ void TNodeJsBase::close(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	v8::HandleScope HandleScope(Isolate);
 	// unwrap
 	TNodeJsBase* JsBase = ObjectWrap::Unwrap<TNodeJsBase>(Args.Holder());
+	// tasks on the thread pool may still use the base
+	QmAssertR(TNodeJsAsyncTask::GetPending() == 0, "base.close: asynchronous operations still running");
 	if (!JsBase->Base.Empty()) {
 		// save base
 		TQm::TStorage::SaveBase(JsBase->Base);
@@ -298,6 +305,7 @@ void TNodeJsBase::createStore(const v8::FunctionCallbackInfo<v8::Value>& Args) {
    TNodeJsBase* JsBase = ObjectWrap::Unwrap<TNodeJsBase>(Args.Holder());
    TWPt<TQm::TBase> Base = JsBase->Base;
    QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+   AssertNoAsyncTask("base.createStore");
    // parse arguments
    PJsonVal SchemaVal = TNodeJsUtil::GetArgJson(Args, 0);
    uint64 DefStoreSize = (uint64)TNodeJsUtil::GetArgInt32(Args, 1, 1024);
@@ -332,18 +340,55 @@ void TNodeJsBase::search(const v8::FunctionCallbackInfo<v8::Value>& Args) {
    TWPt<TQm::TBase> Base = JsBase->Base;
 
    PJsonVal QueryVal = TNodeJsUtil::GetArgJson(Args, 0);
-   // execute the query
+   // execute the query, asynchronous adds may be running
+   TQm::TBase::TReadLock Lock(*Base);
    TQm::PRecSet RecSet = JsBase->Base->Search(QueryVal);
    // return results
    Args.GetReturnValue().Set(TNodeJsRecSet::New(RecSet));   
 }
 
+// Changes made from javascript would race with tasks reading the base on the thread pool
+static void AssertNoAsyncTask(const TStr& FunNm) {
+	QmAssertR(TNodeJsAsyncTask::GetPending() == 0, FunNm + ": asynchronous operations in progress");
+}
+
+// Executes query on the thread pool
+class TNodeJsSearchTask : public TNodeJsAsyncTask {
+private:
+	TWPt<TQm::TBase> Base;
+	PJsonVal QueryVal;
+	TQm::PRecSet RecSet;
+public:
+	TNodeJsSearchTask(const v8::Local<v8::Function>& Callback, const TWPt<TQm::TBase>& _Base,
+		const PJsonVal& _QueryVal): TNodeJsAsyncTask(Callback), Base(_Base), QueryVal(_QueryVal) { }
+
+	void Run() { TQm::TBase::TReadLock Lock(*Base); RecSet = Base->Search(QueryVal); }
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) { return TNodeJsRecSet::New(RecSet); }
+};
+
+void TNodeJsBase::searchAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+   v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+   v8::HandleScope HandleScope(Isolate);
+
+   // unwrap
+   TNodeJsBase* JsBase = ObjectWrap::Unwrap<TNodeJsBase>(Args.Holder());
+   QmAssertR(!JsBase->Base.Empty(), "base.searchAsync: base is closed");
+
+   PJsonVal QueryVal = TNodeJsUtil::GetArgJson(Args, 0);
+   v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, 1);
+   // execute the query on the thread pool
+   TNodeJsSearchTask* Task = new TNodeJsSearchTask(Callback, JsBase->Base, QueryVal);
+   Task->Pin(Args.Holder());
+   TNodeJsAsyncTask::Queue(Task);
+}
+
 void TNodeJsBase::gc(const v8::FunctionCallbackInfo<v8::Value>& Args) {
    v8::Isolate* Isolate = v8::Isolate::GetCurrent();
    v8::HandleScope HandleScope(Isolate);
    // unwrap
    TNodeJsBase* JsBase = ObjectWrap::Unwrap<TNodeJsBase>(Args.Holder());
    TWPt<TQm::TBase> Base = JsBase->Base;
+   AssertNoAsyncTask("base.gc");
 
    Base->GarbageCollect();   
    Args.GetReturnValue().Set(v8::Undefined(Isolate));
@@ -849,8 +894,7 @@ void TNodeJsSA::getOutFltV(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	if (Aggr.Empty()) {
 		throw TQm::TQmExcept::New("TNodeJsSA::getOutFltV : stream aggregate does not implement IFltTmIO: " + JsSA->SA->GetAggrNm());
 	}
-	TFltV Res;
-	Aggr->GetOutFltV(Res);
+	const TFltV& Res = Aggr->GetOutFltV();
 	
 	Args.GetReturnValue().Set(TNodeJsVec<TFlt, TAuxFltV>::New(Res));
 }
@@ -866,8 +910,7 @@ void TNodeJsSA::getOutTmV(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	if (Aggr.Empty()) {
 		throw TQm::TQmExcept::New("TNodeJsSA::getOutTmV : stream aggregate does not implement IFltTmIO: " + JsSA->SA->GetAggrNm());
 	}
-	TUInt64V Res;
-	Aggr->GetOutTmMSecsV(Res);
+	const TUInt64V& Res = Aggr->GetOutTmMSecsV();
 	int Len = Res.Len();
 	TFltV FltRes(Len);
 	for (int ElN = 0; ElN < Len; ElN++) {
@@ -1233,10 +1276,10 @@ double TNodeJsStreamAggr::GetInFlt() const {
 uint64 TNodeJsStreamAggr::GetInTmMSecs() const {
 	throw  TQm::TQmExcept::New("TNodeJsStreamAggr, name: " + GetAggrNm() + ", GetInTmMSecs not implemented");
 }
-void TNodeJsStreamAggr::GetOutFltV(TFltV& ValV) const {
+const TFltV& TNodeJsStreamAggr::GetOutFltV() const {
 	throw  TQm::TQmExcept::New("TNodeJsStreamAggr, name: " + GetAggrNm() + ", GetOutFltV not implemented");
 }
-void TNodeJsStreamAggr::GetOutTmMSecsV(TUInt64V& MSecsV) const {
+const TUInt64V& TNodeJsStreamAggr::GetOutTmMSecsV() const {
 	throw  TQm::TQmExcept::New("TNodeJsStreamAggr, name: " + GetAggrNm() + ", GetOutTmMSecsV not implemented");
 }
 int TNodeJsStreamAggr::GetN() const {
@@ -1300,6 +1343,8 @@ void TNodeJsStore::Init(v8::Handle<v8::Object> exports) {
 	NODE_SET_PROTOTYPE_METHOD(tpl, "each", _each);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "map", _map);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "add", _add);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "addAsync", _addAsync);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "loadJson", _loadJson);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "newRec", _newRec);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "newRecSet", _newRecSet);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sample", _sample);
@@ -1479,6 +1524,7 @@ void TNodeJsStore::rec(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 		TNodeJsStore* JsStore = ObjectWrap::Unwrap<TNodeJsStore>(Args.Holder());
 
 		const TStr RecNm = TNodeJsUtil::GetArgStr(Args, 0);
+		TQm::TBase::TReadLock Lock(*JsStore->Store->GetBase());
 		if (JsStore->Store->IsRecNm(RecNm)) {
 			Args.GetReturnValue().Set(TNodeJsRec::New(JsStore->Store->GetRec(RecNm)));
 		}
@@ -1589,11 +1635,111 @@ void TNodeJsStore::add(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 
 		// check we can write
 		QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+		// asynchronous tasks are not synchronized with the synchronous adds
+		AssertNoAsyncTask("store.add");
+
+		// records with plain fields are serialized directly from their JSON string, which
+		// skips building the TJsonVal tree; others (e.g. with joins) go through AddRec, as do
+		// records with values JSON.stringify would change (e.g. NaN in a float field)
+		uint64 RecId = TUInt64::Mx; bool AddedP = false;
+		if (Args.Length() > 0 && Args[0]->IsObject() && TNodeJsUtil::IsPlainJson(Args[0])) {
+			v8::TryCatch TryCatch;
+			v8::Local<v8::Value> RecJsonStr = TNodeJsUtil::V8JsonToV8Str(Args[0]);
+			if (!RecJsonStr.IsEmpty() && RecJsonStr->IsString()) {
+				AddedP = Store->TryAddRecJsonStr(TNodeJsUtil::GetStr(RecJsonStr->ToString()), RecId);
+			} else {
+				TryCatch.Reset();
+			}
+		}
+		if (!AddedP) {
+			PJsonVal RecVal = TNodeJsUtil::GetArgJson(Args, 0);
+			RecId = Store->AddRec(RecVal);
+		}
+
+		Args.GetReturnValue().Set(v8::Integer::NewFromUnsigned(Isolate, RecId));
+	}
+	catch (const PExcept& Except) {
+		throw TQm::TQmExcept::New("[except] " + Except->GetMsgStr());
+	}
+}
+
+void TNodeJsStore::loadJson(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+
+	try {
+		TNodeJsStore* JsStore = ObjectWrap::Unwrap<TNodeJsStore>(Args.Holder());
+		TWPt<TQm::TStore> Store = JsStore->Store;
+		TWPt<TQm::TBase> Base = JsStore->Store->GetBase();
+
+		// check we can write
+		QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+		AssertNoAsyncTask("store.loadJson");
+
+		const TStr FNm = TNodeJsUtil::GetArgStr(Args, 0);
+		QmAssertR(TFile::Exists(FNm), "store.loadJson: file does not exist: " + FNm);
+		const int BatchLen = TNodeJsUtil::GetArgInt32(Args, 1, "batchSize", 10000);
+		const int IndexCacheMB = TNodeJsUtil::GetArgInt32(Args, 1, "indexCache", 1024);
+		const bool TriggerP = TNodeJsUtil::GetArgBool(Args, 1, "triggers", true);
+		QmAssertR(BatchLen > 0, "store.loadJson: batchSize must be positive");
+		QmAssertR(IndexCacheMB > 0, "store.loadJson: indexCache must be positive");
+
+		const uint64 Recs = Store->AddRecBulk(TFIn::New(FNm), BatchLen, int64(IndexCacheMB) * int64(TInt::Mega), TriggerP);
+		Args.GetReturnValue().Set(v8::Number::New(Isolate, (double)Recs));
+	}
+	catch (const PExcept& Except) {
+		throw TQm::TQmExcept::New("[except] " + Except->GetMsgStr());
+	}
+}
+
+// Checks if any of the stream aggregates triggered by adding records is implemented in JavaScript
+static bool IsJsStreamAggr(const TWPt<TQm::TBase>& Base) {
+	for (int StoreN = 0; StoreN < Base->GetStores(); StoreN++) {
+		const uint StoreId = Base->GetStoreByStoreN(StoreN)->GetStoreId();
+		TQm::PStreamAggrBase SABase = Base->GetStreamAggrBase(StoreId);
+		if (SABase.Empty()) { continue; }
+		int AggrId = SABase->GetFirstStreamAggrId();
+		while (SABase->GetNextStreamAggrId(AggrId)) {
+			if (dynamic_cast<TNodeJsStreamAggr*>(SABase->GetStreamAggr(AggrId)()) != NULL) { return true; }
+		}
+	}
+	return false;
+}
+
+// Adds record on the thread pool
+class TNodeJsAddTask : public TNodeJsAsyncTask {
+private:
+	TWPt<TQm::TStore> Store;
+	PJsonVal RecVal;
+	uint64 RecId;
+public:
+	TNodeJsAddTask(const v8::Local<v8::Function>& Callback, const TWPt<TQm::TStore>& _Store,
+		const PJsonVal& _RecVal): TNodeJsAsyncTask(Callback, true), Store(_Store), RecVal(_RecVal) { }
+
+	void Run() { TQm::TBase::TWriteLock Lock(*Store->GetBase()); RecId = Store->AddRec(RecVal); }
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) { return v8::Integer::NewFromUnsigned(Isolate, RecId); }
+};
+
+void TNodeJsStore::addAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+
+	try {
+		TNodeJsStore* JsStore = ObjectWrap::Unwrap<TNodeJsStore>(Args.Holder());
+		TWPt<TQm::TStore> Store = JsStore->Store;
+		TWPt<TQm::TBase> Base = JsStore->Store->GetBase();
+
+		// check we can write
+		QmAssertR(!Base->IsRdOnly(), "Base opened as read-only");
+		// javascript callbacks can not be called from the thread pool
+		QmAssertR(!IsJsStreamAggr(Base), "store.addAsync: not supported with javascript stream aggregates");
 
 		PJsonVal RecVal = TNodeJsUtil::GetArgJson(Args, 0);
-		const uint64 RecId = Store->AddRec(RecVal);
+		v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, 1);
 
-		Args.GetReturnValue().Set(v8::Integer::NewFromUnsigned(Isolate, RecId));
+		TNodeJsAddTask* Task = new TNodeJsAddTask(Callback, Store, RecVal);
+		Task->Pin(Args.Holder());
+		TNodeJsAsyncTask::Queue(Task);
 	}
 	catch (const PExcept& Except) {
 		throw TQm::TQmExcept::New("[except] " + Except->GetMsgStr());
@@ -1784,6 +1930,7 @@ void TNodeJsStore::clear(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	try {
 		TNodeJsStore* JsStore = ObjectWrap::Unwrap<TNodeJsStore>(Args.Holder());
 		const int DelRecs = TNodeJsUtil::GetArgInt32(Args, 0, (int)JsStore->Store->GetRecs());
+		AssertNoAsyncTask("store.clear");
 
 		JsStore->Store->DeleteFirstNRecs(DelRecs);
 		Args.GetReturnValue().Set(v8::Integer::New(Isolate, (int)JsStore->Store->GetRecs()));
@@ -2369,6 +2516,7 @@ void TNodeJsRec::addJoin(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	// check parameters fine
 	QmAssertR(JsRec->Rec.GetStore()->IsJoinNm(JoinNm), "[addJoin] Unknown join " + JsRec->Rec.GetStore()->GetStoreNm() + "." + JoinNm);
 	QmAssertR(JoinFq > 0, "[addJoin] Join frequency must be positive: " + TInt::GetStr(JoinFq));
+	AssertNoAsyncTask("rec.addJoin");
 	// get generic store
 	TWPt<TQm::TStore> Store = JsRec->Rec.GetStore();
 	const int JoinId = Store->GetJoinId(JoinNm);
@@ -2393,6 +2541,7 @@ void TNodeJsRec::delJoin(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	// check parameters fine
 	QmAssertR(JsRec->Rec.GetStore()->IsJoinNm(JoinNm), "[delJoin] Unknown join " + JsRec->Rec.GetStore()->GetStoreNm() + "." + JoinNm);
 	QmAssertR(JoinFq > 0, "[delJoin] Join frequency must be positive: " + TInt::GetStr(JoinFq));
+	AssertNoAsyncTask("rec.delJoin");
 	// get generic store
 	TWPt<TQm::TStore> Store = JsRec->Rec.GetStore();
 	const int JoinId = Store->GetJoinId(JoinNm);
@@ -2416,8 +2565,10 @@ void TNodeJsRec::toJSON(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	const bool FieldsP = true;
 	const bool StoreInfoP = false;
 	
-	PJsonVal RecJson = JsRec->Rec.GetJson(JsRec->Rec.GetStore()->GetBase(), FieldsP, StoreInfoP, JoinRecsP, JoinRecFieldsP);
-	Args.GetReturnValue().Set(TNodeJsUtil::ParseJson(Isolate, RecJson));
+	TJsonWriter Writer;
+	TQm::TBase::TReadLock Lock(*JsRec->Rec.GetStore()->GetBase());
+	JsRec->Rec.WriteJson(JsRec->Rec.GetStore()->GetBase(), Writer, FieldsP, StoreInfoP, JoinRecsP, JoinRecFieldsP);
+	Args.GetReturnValue().Set(TNodeJsUtil::ParseJsonStr(Isolate, Writer.GetChA()));
 }
 
 
@@ -2469,6 +2620,7 @@ void TNodeJsRec::getField(v8::Local<v8::String> Name, const v8::PropertyCallback
 	TStr FieldNm = TNodeJsUtil::GetStr(Name);
 	const int FieldId = Store->GetFieldId(FieldNm);
 	
+	TQm::TBase::TReadLock Lock(*Store->GetBase());
 	Info.GetReturnValue().Set(TNodeJsStore::Field(Rec, FieldId));
 }
 
@@ -2484,6 +2636,7 @@ void TNodeJsRec::setField(v8::Local<v8::String> Name, v8::Local<v8::Value> Value
 	const int FieldId = Store->GetFieldId(FieldNm);
 	//TODO: for now we don't support by-value records, fix this
 	QmAssertR(Rec.IsByRef(), "Only records by reference (from stores) supported for setters.");
+	AssertNoAsyncTask("rec.setField");
 	// not null, get value
 	const TQm::TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
 	if (Value->IsNull()) {
@@ -2611,6 +2764,7 @@ void TNodeJsRec::join(v8::Local<v8::String> Name, const v8::PropertyCallbackInfo
 	TNodeJsRec* JsRec = ObjectWrap::Unwrap<TNodeJsRec>(Self);
 
 	TStr JoinNm = TNodeJsUtil::GetStr(Name);
+	TQm::TBase::TReadLock Lock(*JsRec->Rec.GetStore()->GetBase());
 	TQm::PRecSet RecSet = JsRec->Rec.DoJoin(JsRec->Rec.GetStore()->GetBase(), JoinNm);
 	Info.GetReturnValue().Set(TNodeJsRecSet::New(RecSet));
 }
@@ -2623,6 +2777,7 @@ void TNodeJsRec::sjoin(v8::Local<v8::String> Name, const v8::PropertyCallbackInf
 	TNodeJsRec* JsRec = ObjectWrap::Unwrap<TNodeJsRec>(Self);
 
 	TStr JoinNm = TNodeJsUtil::GetStr(Name);
+	TQm::TBase::TReadLock Lock(*JsRec->Rec.GetStore()->GetBase());
 	TQm::TRec JoinRec = JsRec->Rec.DoSingleJoin(JsRec->Rec.GetStore()->GetBase(), JoinNm);
 	TWPt<TQm::TStore> JoinStore = JoinRec.GetStore();
 	if (JoinRec.IsDef() && JoinStore->IsRecId(JoinRec.GetRecId())) {
@@ -2650,7 +2805,9 @@ void TNodeJsRecSet::Init(v8::Handle<v8::Object> exports) {
 	// Add all prototype methods, getters and setters here.
 	NODE_SET_PROTOTYPE_METHOD(tpl, "clone", _clone);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "join", _join);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "joinAsync", _joinAsync);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "aggr", _aggr);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "aggrAsync", _aggrAsync);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "trunc", _trunc);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sample", _sample);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "shuffle", _shuffle);
@@ -2658,6 +2815,7 @@ void TNodeJsRecSet::Init(v8::Handle<v8::Object> exports) {
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sortById", _sortById);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sortByFq", _sortByFq);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sortByField", _sortByField);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "sortByFieldAsync", _sortByFieldAsync);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "sort", sort);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "filterById", _filterById);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "filterByFq", _filterByFq);
@@ -2743,10 +2901,43 @@ void TNodeJsRecSet::join(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	TNodeJsRecSet* JsRecSet = ObjectWrap::Unwrap<TNodeJsRecSet>(Args.Holder());
 	TStr JoinNm = TNodeJsUtil::GetArgStr(Args, 0);
 	const int SampleSize = TNodeJsUtil::GetArgInt32(Args, 1, -1);
+	TQm::TBase::TReadLock Lock(*JsRecSet->RecSet->GetStore()->GetBase());
 	TQm::PRecSet RecSet = JsRecSet->RecSet->DoJoin(JsRecSet->RecSet->GetStore()->GetBase(), JoinNm, SampleSize);
 	Args.GetReturnValue().Set(TNodeJsRecSet::New(RecSet));
 }
 
+// Executes join on the thread pool. Works on a copy of the record set,
+// so the original can be used from javascript in the meantime.
+class TNodeJsJoinTask : public TNodeJsAsyncTask {
+private:
+	TQm::PRecSet RecSet;
+	TStr JoinNm;
+	int SampleSize;
+	TQm::PRecSet JoinRecSet;
+public:
+	TNodeJsJoinTask(const v8::Local<v8::Function>& Callback, const TQm::PRecSet& _RecSet,
+		const TStr& _JoinNm, const int& _SampleSize): TNodeJsAsyncTask(Callback),
+		RecSet(_RecSet), JoinNm(_JoinNm), SampleSize(_SampleSize) { }
+
+	void Run() {
+		TQm::TBase::TReadLock Lock(*RecSet->GetStore()->GetBase());
+		JoinRecSet = RecSet->DoJoin(RecSet->GetStore()->GetBase(), JoinNm, SampleSize);
+	}
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) { return TNodeJsRecSet::New(JoinRecSet); }
+};
+
+void TNodeJsRecSet::joinAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+	TNodeJsRecSet* JsRecSet = ObjectWrap::Unwrap<TNodeJsRecSet>(Args.Holder());
+	TStr JoinNm = TNodeJsUtil::GetArgStr(Args, 0);
+	const int SampleSize = (Args.Length() > 2) ? TNodeJsUtil::GetArgInt32(Args, 1) : -1;
+	v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, Args.Length() - 1);
+	TNodeJsJoinTask* Task = new TNodeJsJoinTask(Callback, JsRecSet->RecSet->Clone(), JoinNm, SampleSize);
+	Task->Pin(Args.Holder());
+	TNodeJsAsyncTask::Queue(Task);
+}
+
 void TNodeJsRecSet::aggr(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
 	v8::HandleScope HandleScope(Isolate);
@@ -2771,6 +2962,7 @@ void TNodeJsRecSet::aggr(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 			return;
 		}
 		// compute new aggregates
+		TQm::TBase::TReadLock Lock(*Base);
 		v8::Local<v8::Array> AggrValV = v8::Array::New(Isolate, QueryAggrV.Len());
 		for (int QueryAggrN = 0; QueryAggrN < QueryAggrV.Len(); QueryAggrN++) {
 			const TQm::TQueryAggr& QueryAggr = QueryAggrV[QueryAggrN];
@@ -2805,6 +2997,64 @@ void TNodeJsRecSet::aggr(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	}
 }
 
+// Computes aggregates on the thread pool. Works on a copy of the record set,
+// so the original can be used from javascript in the meantime.
+class TNodeJsAggrTask : public TNodeJsAsyncTask {
+private:
+	TWPt<TQm::TBase> Base;
+	TQm::PRecSet RecSet;
+	TQm::TQueryAggrV QueryAggrV;
+	TJsonValV AggrValV;
+public:
+	TNodeJsAggrTask(const v8::Local<v8::Function>& Callback, const TWPt<TQm::TBase>& _Base,
+		const TQm::PRecSet& _RecSet, const TQm::TQueryAggrV& _QueryAggrV): TNodeJsAsyncTask(Callback),
+		Base(_Base), RecSet(_RecSet), QueryAggrV(_QueryAggrV) { }
+
+	void Run() {
+		// if recset empty, not much to do
+		if (RecSet->Empty()) { return; }
+		TQm::TBase::TReadLock Lock(*Base);
+		for (int QueryAggrN = 0; QueryAggrN < QueryAggrV.Len(); QueryAggrN++) {
+			TQm::PAggr Aggr = TQm::TAggr::New(Base, RecSet, QueryAggrV[QueryAggrN]);
+			AggrValV.Add(Aggr->SaveJson());
+		}
+	}
+
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) {
+		v8::EscapableHandleScope HandleScope(Isolate);
+		if (AggrValV.Empty()) { return HandleScope.Escape(v8::Local<v8::Value>(v8::Null(Isolate))); }
+		// if only one, return as object
+		if (AggrValV.Len() == 1) {
+			v8::Local<v8::Value> AggrVal = TNodeJsUtil::ParseJson(Isolate, AggrValV[0]);
+			if (AggrVal->IsObject()) { return HandleScope.Escape(AggrVal); }
+			return HandleScope.Escape(v8::Local<v8::Value>(v8::Null(Isolate)));
+		}
+		// otherwise return as array
+		v8::Local<v8::Array> JsAggrValV = v8::Array::New(Isolate, AggrValV.Len());
+		for (int AggrValN = 0; AggrValN < AggrValV.Len(); AggrValN++) {
+			JsAggrValV->Set(AggrValN, TNodeJsUtil::ParseJson(Isolate, AggrValV[AggrValN]));
+		}
+		return HandleScope.Escape(JsAggrValV);
+	}
+};
+
+void TNodeJsRecSet::aggrAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+	TNodeJsRecSet* JsRecSet = ObjectWrap::Unwrap<TNodeJsRecSet>(Args.Holder());
+
+	// parameters for computing new aggregate
+	PJsonVal AggrVal = TNodeJsUtil::GetArgJson(Args, 0);
+	v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, 1);
+	const TWPt<TQm::TBase>& Base = JsRecSet->RecSet->GetStore()->GetBase();
+	const TWPt<TQm::TStore>& Store = JsRecSet->RecSet->GetStore();
+	TQm::TQueryAggrV QueryAggrV; TQm::TQueryAggr::LoadJson(Base, Store, AggrVal, QueryAggrV);
+	// compute aggregates on the thread pool
+	TNodeJsAggrTask* Task = new TNodeJsAggrTask(Callback, Base, JsRecSet->RecSet->Clone(), QueryAggrV);
+	Task->Pin(Args.Holder());
+	TNodeJsAsyncTask::Queue(Task);
+}
+
 void TNodeJsRecSet::trunc(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
 	v8::HandleScope HandleScope(Isolate);
@@ -2891,11 +3141,57 @@ void TNodeJsRecSet::sortByField(const v8::FunctionCallbackInfo<v8::Value>& Args)
 				TNodeJsUtil::GetArgFlt(Args, 1) > 0;
 	}
 
+	TQm::TBase::TReadLock Lock(*JsRecSet->RecSet->GetStore()->GetBase());
 	JsRecSet->RecSet->SortByField(Asc, SortFieldId);
 
 	Args.GetReturnValue().Set(Args.Holder());
 }
 
+// Sorts a copy of the record set on the thread pool and
+// replaces the records of the javascript record set with it
+class TNodeJsSortByFieldTask : public TNodeJsAsyncTask {
+private:
+	TNodeJsRecSet* JsRecSet;
+	TQm::PRecSet RecSet;
+	bool Asc;
+	int SortFieldId;
+public:
+	TNodeJsSortByFieldTask(const v8::Local<v8::Function>& Callback, const v8::Local<v8::Object>& JsRecSetObj,
+		const bool& _Asc, const int& _SortFieldId): TNodeJsAsyncTask(Callback), Asc(_Asc), SortFieldId(_SortFieldId) {
+
+		JsRecSet = node::ObjectWrap::Unwrap<TNodeJsRecSet>(JsRecSetObj);
+		RecSet = JsRecSet->RecSet->Clone();
+		// wrapper must stay alive, we write the result back into it
+		Pin(JsRecSetObj);
+	}
+
+	void Run() { TQm::TBase::TReadLock Lock(*RecSet->GetStore()->GetBase()); RecSet->SortByField(Asc, SortFieldId); }
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) {
+		JsRecSet->RecSet = RecSet;
+		return JsRecSet->handle();
+	}
+};
+
+void TNodeJsRecSet::sortByFieldAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+	TNodeJsRecSet* JsRecSet = ObjectWrap::Unwrap<TNodeJsRecSet>(Args.Holder());
+
+	const TStr SortFieldNm = TNodeJsUtil::GetArgStr(Args, 0);
+	const int SortFieldId = JsRecSet->RecSet->GetStore()->GetFieldId(SortFieldNm);
+
+	bool Asc = false;
+	if (Args.Length() > 2) {
+		QmAssertR(TNodeJsUtil::IsArgBool(Args, 1) || TNodeJsUtil::IsArgFlt(Args, 1), "TNodeJsRecSet::sortByFieldAsync: Argument 1 expected to be bool or int!");
+		Asc = TNodeJsUtil::IsArgBool(Args, 1) ?
+				TNodeJsUtil::GetArgBool(Args, 1) :
+				TNodeJsUtil::GetArgFlt(Args, 1) > 0;
+	}
+	v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, Args.Length() - 1);
+
+	TNodeJsAsyncTask::Queue(new TNodeJsSortByFieldTask(Callback, Args.Holder(), Asc, SortFieldId));
+}
+
 void TNodeJsRecSet::sort(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
 	v8::HandleScope HandleScope(Isolate);
@@ -2961,6 +3257,7 @@ void TNodeJsRecSet::filterByField(const v8::FunctionCallbackInfo<v8::Value>& Arg
 	const TStr FieldNm = TNodeJsUtil::GetArgStr(Args, 0);
 	const int FieldId = JsRecSet->RecSet->GetStore()->GetFieldId(FieldNm);
 	const TQm::TFieldDesc& Desc = JsRecSet->RecSet->GetStore()->GetFieldDesc(FieldId);
+	TQm::TBase::TReadLock Lock(*JsRecSet->RecSet->GetStore()->GetBase());
 	// parse filter according to field type
 	if (Desc.IsInt()) {
 		const int MnVal = TNodeJsUtil::GetArgInt32(Args, 1);
@@ -3062,10 +3359,12 @@ void TNodeJsRecSet::toJSON(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	const bool StoreInfoP = false;
 	const bool AggrsP = false;
 	
-	PJsonVal JsObj = JsRecSet->RecSet->GetJson(JsRecSet->RecSet->GetStore()->GetBase(),
+	TJsonWriter Writer;
+	TQm::TBase::TReadLock Lock(*JsRecSet->RecSet->GetStore()->GetBase());
+	JsRecSet->RecSet->WriteJson(JsRecSet->RecSet->GetStore()->GetBase(), Writer,
 		MxHits, Offset, FieldsP, AggrsP, StoreInfoP, JoinRecsP, JoinRecFieldsP);
 	
-	Args.GetReturnValue().Set(TNodeJsUtil::ParseJson(Isolate, JsObj));
+	Args.GetReturnValue().Set(TNodeJsUtil::ParseJsonStr(Isolate, Writer.GetChA()));
 }
 
 void TNodeJsRecSet::each(const v8::FunctionCallbackInfo<v8::Value>& Args) {
@@ -3769,6 +4068,7 @@ void TNodeJsFtrSpace::Init(v8::Handle<v8::Object> exports) {
 	NODE_SET_PROTOTYPE_METHOD(tpl, "invFtrVec", _invFtrVec);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "invFtr", _invFtr);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "ftrSpColMat", _ftrSpColMat);
+	NODE_SET_PROTOTYPE_METHOD(tpl, "ftrSpColMatAsync", _ftrSpColMatAsync);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "ftrColMat", _ftrColMat);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "getFtrExtractor", _getFtrExtractor);
 	NODE_SET_PROTOTYPE_METHOD(tpl, "getFtr", _getFtr);
@@ -4117,6 +4417,47 @@ void TNodeJsFtrSpace::ftrSpColMat(const v8::FunctionCallbackInfo<v8::Value>& Arg
 	}
 }
 
+// Extracts sparse feature vectors on the thread pool
+class TNodeJsFtrSpColMatTask : public TNodeJsAsyncTask {
+private:
+	TQm::PFtrSpace FtrSpace;
+	TQm::PRecSet RecSet;
+	TVec<TIntFltKdV> SpMat;
+public:
+	TNodeJsFtrSpColMatTask(const v8::Local<v8::Function>& Callback, const TQm::PFtrSpace& _FtrSpace,
+		const TQm::PRecSet& _RecSet): TNodeJsAsyncTask(Callback), FtrSpace(_FtrSpace), RecSet(_RecSet) { }
+
+	void Run() { TQm::TBase::TReadLock Lock(*RecSet->GetStore()->GetBase()); FtrSpace->GetSpVV(RecSet, SpMat); }
+	v8::Local<v8::Value> GetResult(v8::Isolate* Isolate) { return TNodeJsSpMat::New(SpMat, FtrSpace->GetDim()); }
+};
+
+void TNodeJsFtrSpace::ftrSpColMatAsync(const v8::FunctionCallbackInfo<v8::Value>& Args) {
+	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
+	v8::HandleScope HandleScope(Isolate);
+
+	QmAssertR(Args.Length() == 2, "Should have 2 arguments!");
+
+	try {
+		TNodeJsFtrSpace* JsFtrSpace = ObjectWrap::Unwrap<TNodeJsFtrSpace>(Args.Holder());
+		TNodeJsRecSet* RecSet = ObjectWrap::Unwrap<TNodeJsRecSet>(Args[0]->ToObject());
+		v8::Local<v8::Function> Callback = TNodeJsUtil::GetArgFun(Args, 1);
+
+		// javascript feature extractors can not be called from the thread pool
+		for (int FtrExtN = 0; FtrExtN < JsFtrSpace->FtrSpace->GetFtrExts(); FtrExtN++) {
+			QmAssertR(dynamic_cast<TNodeJsFuncFtrExt*>(JsFtrSpace->FtrSpace->GetFtrExt(FtrExtN)()) == NULL,
+				"Not supported with javascript feature extractors!");
+		}
+
+		// create feature matrix on the thread pool
+		TNodeJsFtrSpColMatTask* Task = new TNodeJsFtrSpColMatTask(Callback, JsFtrSpace->FtrSpace, RecSet->RecSet);
+		Task->Pin(Args.Holder());
+		Task->Pin(Args[0]);
+		TNodeJsAsyncTask::Queue(Task);
+	} catch (const PExcept& Except) {
+		throw TQm::TQmExcept::New(Except->GetMsgStr(), "TNodeJsFtrSpace::ftrSpColMatAsync");
+	}
+}
+
 void TNodeJsFtrSpace::ftrColMat(const v8::FunctionCallbackInfo<v8::Value>& Args) {
 	v8::Isolate* Isolate = v8::Isolate::GetCurrent();
 	v8::HandleScope HandleScope(Isolate);
@@ -58,7 +58,7 @@ private:
 	//# 
 	//# **Functions and properties:**
 	//# 
-	//#- `base.close()` -- closes the base
+	//#- `base.close()` -- closes the base; fails while asynchronous operations are still running
 	JsDeclareFunction(close);
     //#- `store = base.store(storeName)` -- return store with name `storeName`; `store = null` when no such store
 	JsDeclareFunction(store);
@@ -70,6 +70,9 @@ private:
     //#- `rs = base.search(query)` -- execute `query` (Json) specified in [QMiner Query Language](Query Language) 
     //#   and returns a record set `rs` with results
 	JsDeclareFunction(search);   
+    //#- `base.searchAsync(query, callback)` -- executes `query` (Json) on the thread pool, without blocking the event loop,
+    //#   and calls `callback(err, rs)` with the resulting record set `rs`
+	JsDeclareFunction(searchAsync);
     //#- `base.gc()` -- start garbage collection to remove records outside time windows
 	JsDeclareFunction(gc);
 	//#- `sa = base.getStreamAggr(saName)` -- gets the stream aggregate `sa` given name (string).
@@ -250,8 +253,8 @@ public:
 	// IFltTmIO 
 	double GetInFlt() const;
 	uint64 GetInTmMSecs() const;
-	void GetOutFltV(TFltV& ValV) const;
-	void GetOutTmMSecsV(TUInt64V& MSecsV) const;
+	const TFltV& GetOutFltV() const;
+	const TUInt64V& GetOutTmMSecsV() const;
 	int GetN() const;
 	// IFltVec
 	int GetFltLen() const;
@@ -307,8 +310,21 @@ private:
 	//#  - `arr = store.map(function (rec) { return JSON.stringify(rec); })`
 	//#  - `arr = store.map(function (rec, idx) {  return JSON.stringify(rec) + ', ' + idx; })`
 	JsDeclareFunction(map);
-	//#- `recId = store.add(rec)` -- add record `rec` to the store and return its ID `recId`
+	//#- `recId = store.add(rec)` -- add record `rec` to the store and return its ID `recId`. Records
+	//#     with only field values are serialized directly from `JSON.stringify(rec)`.
 	JsDeclareFunction(add);
+	//#- `store.addAsync(rec, callback)` -- add record `rec` to the store on the thread pool and call `callback(err, recId)`.
+	//#     Asynchronous adds are executed one at a time in the order they were called. Not supported when
+	//#     the base has stream aggregates implemented in JavaScript. Synchronous changes of the base
+	//#     (e.g. `store.add`, setting record fields) throw while asynchronous operations are running.
+	JsDeclareFunction(addAsync);
+	//#- `num = store.loadJson(fileName[, params])` -- bulk load records from file `fileName` with one JSON record per line
+	//#     and return the number `num` of added or updated records. Records are serialized in parallel, index is built
+	//#     in temporary runs merged at the end, and joins and triggers are processed in a final pass; the store should
+	//#     not be queried while loading. Stream aggregates get the records in batches, and independent built-in
+	//#     aggregates process a batch in parallel. Optional `params` object: `batchSize` (records per batch, default 10000),
+	//#     `indexCache` (size of temporary index in MB, default 1024), `triggers` (call triggers, default true).
+	JsDeclareFunction(loadJson);
 	//#- `rec = store.newRec(recordJson)` -- creates new record `rec` by (JSON) value `recordJson` (not added to the store)
 	JsDeclareFunction(newRec);
 	//#- `rs = store.newRecSet(idVec)` -- creates new record set from an integer vector record IDs `idVec` (type la.newIntVec);
@@ -455,9 +471,15 @@ private:
 	//#- `rs2 = rs.join(joinName)` -- executes a join `joinName` on the records in the set, result is another record set `rs2`.
 	//#- `rs2 = rs.join(joinName, sampleSize)` -- executes a join `joinName` on a sample of `sampleSize` records in the set, result is another record set `rs2`.
 	JsDeclareFunction(join);
+	//#- `rs.joinAsync(joinName, callback)` -- executes a join `joinName` on the thread pool and calls `callback(err, rs2)` with the resulting record set `rs2`.
+	//#- `rs.joinAsync(joinName, sampleSize, callback)` -- executes a join `joinName` on a sample of `sampleSize` records on the thread pool and calls `callback(err, rs2)`.
+	JsDeclareFunction(joinAsync);
 	//#- `aggrsJSON = rs.aggr()` -- returns an object where keys are aggregate names and values are JSON serialized aggregate values of all the aggregates contained in the records set
 	//#- `aggr = rs.aggr(aggrQueryJSON)` -- computes the aggregates based on the `aggrQueryJSON` parameter JSON object. If only one aggregate is involved and an array of JSON objects when more than one are returned.
 	JsDeclareFunction(aggr);
+	//#- `rs.aggrAsync(aggrQueryJSON, callback)` -- computes the aggregates based on `aggrQueryJSON` on the thread pool and calls `callback(err, aggr)`,
+	//#     where `aggr` is the same as returned by `rs.aggr(aggrQueryJSON)`.
+	JsDeclareFunction(aggrAsync);
 	//#- `rs = rs.trunc(limit_num)` -- truncate to first `limit_num` record and return self.
 	//#- `rs = rs.trunc(limit_num, offset_num)` -- truncate to `limit_num` record starting with `offset_num` and return self.
 	JsDeclareFunction(trunc);
@@ -473,6 +495,9 @@ private:
 	JsDeclareFunction(sortByFq);
 	//#- `rs = rs.sortByField(fieldName, asc)` -- sort records according to value of field `fieldName`; if `asc > 0` sorted in ascending order (default is desc). Returns self.
 	JsDeclareFunction(sortByField);
+	//#- `rs.sortByFieldAsync(fieldName, asc, callback)` -- sorts a copy of the records according to value of field `fieldName` on the thread pool,
+	//#     replaces the records of `rs` with the sorted copy and calls `callback(err, rs)`.
+	JsDeclareFunction(sortByFieldAsync);
 	//#- `rs = rs.sort(comparatorCallback)` -- sort records according to `comparator` callback. Example: rs.sort(function(rec,rec2) {return rec.Val < rec2.Val;} ) sorts rs in ascending order (field Val is assumed to be a num). Returns self.
 	JsDeclareFunction(sort);
 	//#- `rs = rs.filterById(minId, maxId)` -- keeps only records with ids between `minId` and `maxId`. Returns self.
@@ -792,6 +817,9 @@ public:
     //#- `spMat = fsp.ftrSpColMat(rs)` -- extracts sparse feature vectors from
     //#     record set `rs` and returns them as columns in a sparse matrix `spMat`.
 	JsDeclareFunction(ftrSpColMat);
+    //#- `fsp.ftrSpColMatAsync(rs, callback)` -- extracts sparse feature vectors from record set `rs` on the thread pool
+    //#     and calls `callback(err, spMat)`. Not supported for feature spaces with JavaScript feature extractors.
+	JsDeclareFunction(ftrSpColMatAsync);
     //#- `mat = fsp.ftrColMat(rs)` -- extracts feature vectors from
     //#     record set `rs` and returns them as columns in a matrix `mat`.
     JsDeclareFunction(ftrColMat);
@@ -117,6 +117,14 @@ public:
 	uint64 DefStoreCacheSize;
 	// store specific cache sizes
 	TStrUInt64H StoreNmCacheSizeH;
+	// write-ahead log enabled
+	bool WalP;
+	// write-ahead log commit interval
+	uint64 WalCommitMSecs;
+	// write-ahead log length which triggers checkpoint
+	uint64 WalCheckpointLen;
+	// write-ahead log age which triggers checkpoint
+	uint64 WalCheckpointMSecs;
 	// javascript parameters
 	TVec<TJsParam> JsParamV;
 	// file serving folders
@@ -169,6 +177,18 @@ public:
 			DefStoreCacheSize = int64(1024) * int64(TInt::Mega);
 		}
 
+		// parse write-ahead log
+		WalP = ConfigVal->IsObjKey("wal");
+		if (WalP) {
+			PJsonVal WalVal = ConfigVal->GetObjKey("wal");
+			// sync to disk every second, checkpoint every 64MB or 10 minutes by default
+			WalCommitMSecs = uint64(WalVal->GetObjNum("commit", 1000));
+			WalCheckpointLen = uint64(WalVal->GetObjNum("checkpoint", 64)) * uint64(TInt::Mega);
+			WalCheckpointMSecs = uint64(WalVal->GetObjNum("checkpointSec", 600)) * uint64(1000);
+		} else {
+			WalCommitMSecs = 0; WalCheckpointLen = 0; WalCheckpointMSecs = 0;
+		}
+
 		// load scripts
 		if (ConfigVal->IsObjKey("script")) {
 			// we have configuration file, read it
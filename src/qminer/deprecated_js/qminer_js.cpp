@@ -863,6 +863,8 @@ TStr TScript::GetLibFNm(const TStr& LibNm) {
 ///////////////////////////////
 // QMiner-JavaScript-Server-Function
 void TJsSrvFun::Exec(const TStrKdV& FldNmValKdV, const PSAppSrvRqEnv& RqEnv) {
+	// scripts can change the base, wait for read-only functions on workers
+	TBase::TWriteLock WriteLock(*Js->Base);
 	PHttpRq HttpRq = RqEnv->GetHttpRq();
 	PUrl Url = HttpRq->GetUrl();
 
@@ -981,9 +983,10 @@ void TJsStoreTrigger::OnDelete(const TRec& Rec) {
 ///////////////////////////////
 // QMiner-JavaScript-WebPgFetch
 void TJsFetch::OnFetch(const int& FId, const PWebPg& WebPg) {
-	// execute callback
+	// execute callback, it can change the base
 	{
         QmAssert(CallbackH.IsKey(FId));
+		TBase::TWriteLock WriteLock(*Js->Base);
 		const TJsFetchRq& Rq = CallbackH.GetDat(FId);
 		//TEnv::Logger->OnStatusFmt("OnFetch[%s]", Rq.GetUrlStr().CStr());
 		// is there a callback to call
@@ -1012,9 +1015,12 @@ void TJsFetch::OnFetch(const int& FId, const PWebPg& WebPg) {
 }
 
 void TJsFetch::OnError(const int& FId, const TStr& MsgStr) {
-	// execute callback
+	// execute callback, it can change the base; invalid urls are reported from
+	// Fetch before the request is registered, the assert fails before taking
+	// the lock which the calling script already holds
 	{
         QmAssert(CallbackH.IsKey(FId));
+		TBase::TWriteLock WriteLock(*Js->Base);
 		const TJsFetchRq& Rq = CallbackH.GetDat(FId);
 		//TEnv::Logger->OnStatusFmt("OnError[%s]: %s", Rq.GetUrlStr().CStr(), MsgStr.CStr());
 		// is there a callback to call
@@ -1886,8 +1892,7 @@ v8::Handle<v8::Value> TJsSA::getOutFltV(const v8::Arguments& Args) {
 	if (Aggr.Empty()) {
 		throw TQmExcept::New("TJsSA::getOutFltV : stream aggregate does not implement IFltTmIO: " + JsSA->SA->GetAggrNm());
 	}
-	TFltV Res;
-	Aggr->GetOutFltV(Res);
+	const TFltV& Res = Aggr->GetOutFltV();
 	return TJsFltV::New(JsSA->Js, Res);
 }
 
@@ -1899,8 +1904,7 @@ v8::Handle<v8::Value> TJsSA::getOutTmV(const v8::Arguments& Args) {
 	if (Aggr.Empty()) {
 		throw TQmExcept::New("TJsSA::getOutTmV : stream aggregate does not implement IFltTmIO: " + JsSA->SA->GetAggrNm());
 	}
-	TUInt64V Res;
-	Aggr->GetOutTmMSecsV(Res);
+	const TUInt64V& Res = Aggr->GetOutTmMSecsV();
 	int Len = Res.Len();
 	TFltV FltRes(Len);
 	for (int ElN = 0; ElN < Len; ElN++) {
@@ -2148,10 +2152,10 @@ double TJsStreamAggr::GetInFlt() const {
 uint64 TJsStreamAggr::GetInTmMSecs() const {
 	throw  TQmExcept::New("TJsStreamAggr, name: " + GetAggrNm() + ", GetInTmMSecs not implemented");
 }
-void TJsStreamAggr::GetOutFltV(TFltV& ValV) const {
+const TFltV& TJsStreamAggr::GetOutFltV() const {
 	throw  TQmExcept::New("TJsStreamAggr, name: " + GetAggrNm() + ", GetOutFltV not implemented");
 }
-void TJsStreamAggr::GetOutTmMSecsV(TUInt64V& MSecsV) const {
+const TUInt64V& TJsStreamAggr::GetOutTmMSecsV() const {
 	throw  TQmExcept::New("TJsStreamAggr, name: " + GetAggrNm() + ", GetOutTmMSecsV not implemented");
 }
 int TJsStreamAggr::GetN() const {
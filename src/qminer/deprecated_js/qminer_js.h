@@ -1410,8 +1410,8 @@ public:
 	// IFltTmIO 
 	double GetInFlt() const;
 	uint64 GetInTmMSecs() const;
-	void GetOutFltV(TFltV& ValV) const;
-	void GetOutTmMSecsV(TUInt64V& MSecsV) const;
+	const TFltV& GetOutFltV() const;
+	const TUInt64V& GetOutTmMSecsV() const;
 	int GetN() const;
 	// IFltVec
 	int GetFltLen() const;
@@ -380,6 +380,7 @@ int main(int argc, char* argv[]) {
 		if (!Env.IsSilent()) { printf("\nStart parameters:\n"); }
 		const bool RdOnlyP = Env.IsArgStr("-rdonly", "Open database in Read-only mode");
 		const bool NoLoopP = Env.IsArgStr("-noserver", "Do not start server after script execution");
+		const bool WorkersP = Env.IsArgStr("-workers", "Execute read-only requests on worker threads");
 		TStr OnlyScriptNm = Env.GetIfArgPrefixStr("-script=", "", "Only run this script");
 		// read stop-specific parameters
 		if (!Env.IsSilent()) { printf("\nStop parameters:\n"); }
@@ -499,7 +500,7 @@ int main(int argc, char* argv[]) {
 						ScriptV[ScriptN]->RegSrvFun(SrvFunV);
 					}
 					// start server
-					PWebSrv WebSrv = TSAppSrv::New(Param.PortN, SrvFunV, TQm::TEnv::Logger, ShowHttp, true);
+					PWebSrv WebSrv = TSAppSrv::New(Param.PortN, SrvFunV, TQm::TEnv::Logger, ShowHttp, true, WorkersP);
 					// report we started
 					TQm::TEnv::Logger->OnStatusFmt("Server started on port %d", Param.PortN);
 					// wait for the end
@@ -129,8 +129,8 @@ PJsonVal TCount::SaveJson() const {
 
 ///////////////////////////////
 // QMiner-Aggregator-Histogram
-THistogram::THistogram(const TWPt<TBase>& Base, const TStr& AggrNm,
-		const PRecSet& RecSet, const PFtrExt& FtrExt, const int& Buckets):
+THistogram::THistogram(const TWPt<TBase>& Base, const TStr& AggrNm, const PRecSet& RecSet, 
+		const PFtrExt& FtrExt, const int& Buckets, const int& ColumnFieldId):
 			TAggr(Base, AggrNm) {
 
 	// prepare join path string, if necessary
@@ -139,27 +139,33 @@ THistogram::THistogram(const TWPt<TBase>& Base, const TStr& AggrNm,
 	FieldNm = FtrExt->GetNm();
 	// if empty result set no need to do histogams
 	if (RecSet->Empty()) { return; }
-	// find min and max for histogram
-	double MnVal = TFlt::Mx, MxVal = TFlt::Mn;
-	const int Recs = RecSet->GetRecs();
-	for (int RecN = 0; RecN < Recs; RecN++) {
-		TFltV FtrValV; FtrExt->ExtractFltV(RecSet->GetRec(RecN), FtrValV);
-		for (int FtrValN = 0; FtrValN < FtrValV.Len(); FtrValN++) {
-			const double Val = FtrValV[FtrValN];
-			MnVal = TFlt::GetMn(MnVal, Val);
-			MxVal = TFlt::GetMx(MxVal, Val);
+	// extract values once and find min and max for histogram
+	TFltV ValV; double MnVal = TFlt::Mx, MxVal = TFlt::Mn;
+	if (ColumnFieldId != -1) {
+		RecSet->GetStore()->GetFieldFltColumn(RecSet->GetRecIdFqV(), ColumnFieldId, ValV);
+		for (int ValN = 0; ValN < ValV.Len(); ValN++) {
+			MnVal = TFlt::GetMn(MnVal, ValV[ValN]);
+			MxVal = TFlt::GetMx(MxVal, ValV[ValN]);
+		}
+	} else {
+		const int Recs = RecSet->GetRecs();
+		for (int RecN = 0; RecN < Recs; RecN++) {
+			TFltV FtrValV; FtrExt->ExtractFltV(RecSet->GetRec(RecN), FtrValV);
+			for (int FtrValN = 0; FtrValN < FtrValV.Len(); FtrValN++) {
+				const double Val = FtrValV[FtrValN];
+				MnVal = TFlt::GetMn(MnVal, Val);
+				MxVal = TFlt::GetMx(MxVal, Val);
+				ValV.Add(Val);
+			}
 		}
 	}
 	// compute histogram
 	Mom = TMom::New(); Sum = 0.0;
 	Hist = THist(MnVal, MxVal, Buckets);
-	for (int RecN = 0; RecN < Recs; RecN++) {
-		TFltV FtrValV; FtrExt->ExtractFltV(RecSet->GetRec(RecN), FtrValV);
-		for (int FtrValN = 0; FtrValN < FtrValV.Len(); FtrValN++) {
-			const double FtrVal = FtrValV[FtrValN].Val;
-			Mom->Add(FtrVal); Sum += FtrVal;
-			Hist.Add(FtrValV[FtrValN], true); 
-		}
+	for (int ValN = 0; ValN < ValV.Len(); ValN++) {
+		const double FtrVal = ValV[ValN].Val;
+		Mom->Add(FtrVal); Sum += FtrVal;
+		Hist.Add(FtrVal, true); 
 	}
 	Mom->Def();
 }
@@ -182,7 +188,11 @@ PAggr THistogram::New(const TWPt<TBase>& Base, const TStr& AggrNm,
 	const int Buckets = TFlt::Round(JsonVal->GetObjNum("buckets", 10.0));
 	// prepare feature extractor
 	PFtrExt FtrExt = TFtrExts::TNumeric::New(Base, JoinSeq, FieldId);
-	return New(Base, AggrNm, RecSet, FtrExt, Buckets);
+	// read values from column when field has one (nulls are 0 for the extractor)
+	const TFieldDesc& FieldDesc = Store->GetFieldDesc(FieldId);
+	const bool ColumnP = !JoinSeq.IsJoin() && Store->IsFieldColumn(FieldId) && 
+		(FieldDesc.IsInt() || FieldDesc.IsFlt()) && !FieldDesc.IsNullable();
+	return new THistogram(Base, AggrNm, RecSet, FtrExt, Buckets, ColumnP ? FieldId : -1);
 }
 
 PJsonVal THistogram::SaveJson() const { 
@@ -406,8 +416,19 @@ PJsonVal TTimeLine::GetJsonList(const TStrH& StrH) const {
 	return JsonVal;
 }
 
-TTimeLine::TTimeLine(const TWPt<TBase>& Base, const TStr& AggrNm,
-		const PRecSet& RecSet, const PFtrExt& FtrExt): TAggr(Base, AggrNm) {
+void TTimeLine::AddTm(const TTm& Tm) {
+	if (!Tm.IsDef()) { return; }
+	TSecTm SecTm(Tm); Count++;
+	TStr DateStr = Tm.GetWebLogDateStr();
+	AbsDateH.AddDat(DateStr)++;
+	MonthH.AddDat(SecTm.GetMonthNm())++;
+	DayOfWeekH.AddDat(SecTm.GetDayOfWeekNm())++;
+	if (0 <= Tm.GetHour() && Tm.GetHour() < 24) { 
+		HourOfDayH[Tm.GetHour()]++; }
+}
+
+TTimeLine::TTimeLine(const TWPt<TBase>& Base, const TStr& AggrNm, const PRecSet& RecSet, 
+		const PFtrExt& FtrExt, const int& ColumnFieldId): TAggr(Base, AggrNm) {
 
 	// prepare join path string, if necessary
 	JoinPathStr = FtrExt->GetJoinSeq(RecSet->GetStoreId()).GetJoinPathStr(Base);
@@ -421,20 +442,16 @@ TTimeLine::TTimeLine(const TWPt<TBase>& Base, const TStr& AggrNm,
 	for (int HourOfDayN = 0; HourOfDayN < 24; HourOfDayN++) {
 		HourOfDayH.AddKey(TInt::GetStr(HourOfDayN)); }
 	// prepare peichart
-	const int Recs = RecSet->GetRecs();
-	for (int RecN = 0; RecN < Recs; RecN++) {
-		TTmV FtrValV; FtrExt->ExtractTmV(RecSet->GetRec(RecN), FtrValV);
-		for (int FtrValN = 0; FtrValN < FtrValV.Len(); FtrValN++) {
-			const TTm& Tm = FtrValV[FtrValN]; 
-			if (Tm.IsDef()) {
-				TSecTm SecTm(Tm); Count++;
-				TStr DateStr = Tm.GetWebLogDateStr();
-				AbsDateH.AddDat(DateStr)++;
-				MonthH.AddDat(SecTm.GetMonthNm())++;
-				DayOfWeekH.AddDat(SecTm.GetDayOfWeekNm())++;
-				if (0 <= Tm.GetHour() && Tm.GetHour() < 24) { 
-					HourOfDayH[Tm.GetHour()]++; }
-			}
+	if (ColumnFieldId != -1) {
+		TUInt64V MSecsV; RecSet->GetStore()->GetFieldUInt64Column(RecSet->GetRecIdFqV(), ColumnFieldId, MSecsV);
+		for (int MSecsN = 0; MSecsN < MSecsV.Len(); MSecsN++) {
+			AddTm(TTm::GetTmFromMSecs(MSecsV[MSecsN])); }
+	} else {
+		const int Recs = RecSet->GetRecs();
+		for (int RecN = 0; RecN < Recs; RecN++) {
+			TTmV FtrValV; FtrExt->ExtractTmV(RecSet->GetRec(RecN), FtrValV);
+			for (int FtrValN = 0; FtrValN < FtrValV.Len(); FtrValN++) {
+				AddTm(FtrValV[FtrValN]); }
 		}
 	}
 	AbsDateH.SortByKey(true);
@@ -456,7 +473,11 @@ PAggr TTimeLine::New(const TWPt<TBase>& Base, const TStr& AggrNm,
 	const int FieldId = Store->GetFieldId(FieldNm);
 	// is there a join?
 	PFtrExt FtrExt = TFtrExts::TMultinomial::New(Base, JoinSeq, FieldId);
-	return New(Base, AggrNm, RecSet, FtrExt);
+	// read values from column when field has one
+	const TFieldDesc& FieldDesc = Store->GetFieldDesc(FieldId);
+	const bool ColumnP = !JoinSeq.IsJoin() && Store->IsFieldColumn(FieldId) && 
+		FieldDesc.IsTm() && !FieldDesc.IsNullable();
+	return new TTimeLine(Base, AggrNm, RecSet, FtrExt, ColumnP ? FieldId : -1);
 }
 
 PJsonVal TTimeLine::SaveJson() const { 
@@ -633,6 +654,18 @@ void TTimeSeriesTick::OnAddRec(const TRec& Rec) {
     InitP = true;
 }
 
+void TTimeSeriesTick::OnAddRecBatch(const PRecSet& RecSet) {
+	const TWPt<TStore>& Store = RecSet->GetStore();
+	ClrBatch();
+	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+		const uint64 RecId = RecSet->GetRecId(RecN);
+		TickVal = Store->GetFieldFlt(RecId, TickValFieldId);
+		TmMSecs = Store->GetFieldTmMSecs(RecId, TimeFieldId);
+		AddBatch(TickVal, TmMSecs, true);
+	}
+	if (!RecSet->Empty()) { InitP = true; }
+}
+
 TTimeSeriesTick::TTimeSeriesTick(const TWPt<TBase>& Base, const TStr& StoreNm, const TStr& AggrNm, 
         const TStr& TimeFieldNm, const TStr& TickValFieldNm): TStreamAggr(Base, AggrNm) {
 
@@ -704,27 +737,60 @@ PJsonVal TTimeSeriesTick::SaveJson(const int& Limit) const {
 
 ///////////////////////////////
 // Time series winbuf.
+void TTimeSeriesWinBuf::Grow() {
+    TFltUInt64PrV NewValV(TInt::GetMx(16, 2 * AllValV.Len()));
+    for (int ElN = 0; ElN < Vals; ElN++) {
+        NewValV[ElN] = AllValV[GetValN(ElN)];
+    }
+    AllValV.Swap(NewValV); FirstValN = 0;
+}
+
+void TTimeSeriesWinBuf::AddVal(const double& Val, const uint64& TmMSecs, TFltV& _OutValV, TUInt64V& _OutTmMSecsV) {
+    // move elements that fall out of the window to outgoing vectors
+    while (Vals > 0) {
+        const TFltUInt64Pr& OldVal = AllValV[FirstValN];
+        if ((TmMSecs - OldVal.Val2) <= WinSizeMSecs) { break; }
+        _OutValV.Add(OldVal.Val1);
+        _OutTmMSecsV.Add(OldVal.Val2);
+        FirstValN = GetValN(1); Vals--;
+    }
+    
+    // update the interval
+    if (Vals == AllValV.Len()) { Grow(); }
+    AllValV[GetValN(Vals)] = TFltUInt64Pr(Val, TmMSecs); Vals++;
+}
+
 void TTimeSeriesWinBuf::OnAddRec(const TRec& Rec) {
     // get the value and time stamp of the last record
 	InVal = Rec.GetFieldFlt(TickValFieldId);
 	InTmMSecs = Rec.GetFieldTmMSecs(TimeFieldId);
     InitP = true;
-    // empty the former outgoing value vector
-    OutValV.Clr(true); OutTmMSecsV.Clr(true);
-    int ValLen = AllValV.Len();
-    // update the interval    
-    AllValV.Add(TFltUInt64Pr(InVal, InTmMSecs));
-    
-    // prepare the vector of elements that are going to be removed from the window
-    for (int ValN = 0; ValN < ValLen; ValN++) {
-        if ((InTmMSecs - AllValV[ValN].Val2) > WinSizeMSecs) { 
-            OutValV.Add(AllValV[ValN].Val1);
-            OutTmMSecsV.Add(AllValV[ValN].Val2);
-        } else { break; }
+    // empty the former outgoing value vector, keeping its memory
+    OutValV.Clr(false); OutTmMSecsV.Clr(false);
+    AddVal(InVal, InTmMSecs, OutValV, OutTmMSecsV);
+}
+
+void TTimeSeriesWinBuf::OnAddRecBatch(const PRecSet& RecSet) {
+    const int Recs = RecSet->GetRecs();
+    if (Recs == 0) { return; }
+    const TWPt<TStore>& Store = RecSet->GetStore();
+    BatchInValV.Gen(Recs, 0); BatchInTmMSecsV.Gen(Recs, 0); BatchNV.Gen(Recs, 0);
+    BatchOutNV.Gen(Recs + 1, 0); BatchOutValV.Clr(false); BatchOutTmMSecsV.Clr(false);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        const uint64 RecId = RecSet->GetRecId(RecN);
+        InVal = Store->GetFieldFlt(RecId, TickValFieldId);
+        InTmMSecs = Store->GetFieldTmMSecs(RecId, TimeFieldId);
+        BatchOutNV.Add(BatchOutValV.Len());
+        AddVal(InVal, InTmMSecs, BatchOutValV, BatchOutTmMSecsV);
+        BatchInValV.Add(InVal); BatchInTmMSecsV.Add(InTmMSecs); BatchNV.Add(Vals);
+    }
+    BatchOutNV.Add(BatchOutValV.Len());
+    InitP = true;
+    // outgoing values of the last record
+    OutValV.Clr(false); OutTmMSecsV.Clr(false);
+    for (int ValN = BatchOutNV[Recs - 1]; ValN < BatchOutNV[Recs]; ValN++) {
+        OutValV.Add(BatchOutValV[ValN]); OutTmMSecsV.Add(BatchOutTmMSecsV[ValN]);
     }
-    
-    // remove all the elements   
-    if (OutValV.Len() > 0) { AllValV.Del(0, OutValV.Len() - 1); }  
 }
 
 TTimeSeriesWinBuf::TTimeSeriesWinBuf(const TWPt<TBase>& Base, const TStr& StoreNm, const TStr& AggrNm, 
@@ -757,7 +823,7 @@ TTimeSeriesWinBuf::TTimeSeriesWinBuf(const TWPt<TBase>& Base, const PJsonVal& Pa
 }
 
 TTimeSeriesWinBuf::TTimeSeriesWinBuf(const TWPt<TBase>& Base, const TWPt<TStreamAggrBase> SABase, TSIn& SIn) : TStreamAggr(Base, SABase, SIn),
-	TimeFieldId(SIn), TickValFieldId(SIn), WinSizeMSecs(SIn), InitP(SIn), InVal(SIn), InTmMSecs(SIn), OutValV(SIn), OutTmMSecsV(SIn), AllValV(SIn)  { }
+	TimeFieldId(SIn), TickValFieldId(SIn), WinSizeMSecs(SIn), InitP(SIn), InVal(SIn), InTmMSecs(SIn), OutValV(SIn), OutTmMSecsV(SIn), AllValV(SIn), FirstValN(0), Vals(AllValV.Len())  { }
 
 PStreamAggr TTimeSeriesWinBuf::New(const TWPt<TBase>& Base, const TStr& StoreNm, 
         const TStr& AggrNm, const TStr& TimeFieldNm, const TStr& ValFieldNm, 
@@ -781,6 +847,7 @@ void TTimeSeriesWinBuf::_Load(TSIn& SIn) {
 	OutValV.Load(SIn);
 	OutTmMSecsV.Load(SIn);
 	AllValV.Load(SIn);
+	FirstValN = 0; Vals = AllValV.Len();
 }
 
 void TTimeSeriesWinBuf::Save(TSOut& SOut) const {
@@ -801,14 +868,19 @@ void TTimeSeriesWinBuf::_Save(TSOut& SOut) const {
 	InTmMSecs.Save(SOut);
 	OutValV.Save(SOut);
 	OutTmMSecsV.Save(SOut);
-	AllValV.Save(SOut);
+	// save the window from the oldest to the newest value
+	TFltUInt64PrV ValV(Vals);
+	for (int ElN = 0; ElN < Vals; ElN++) {
+		ValV[ElN] = AllValV[GetValN(ElN)];
+	}
+	ValV.Save(SOut);
 }
 
 void TTimeSeriesWinBuf::GetFltV(TFltV& ValV) const {
 	int Len = GetN();
 	ValV.Gen(Len);
 	for (int ElN = 0; ElN < Len; ElN++) {
-		ValV[ElN] = AllValV[ElN].Val1;
+		ValV[ElN] = GetFlt(ElN);
 	}
 }
 
@@ -816,7 +888,7 @@ void TTimeSeriesWinBuf::GetTmV(TUInt64V& MSecsV) const {
 	int Len = GetN();
 	MSecsV.Gen(Len);
 	for (int ElN = 0; ElN < Len; ElN++) {
-		MSecsV[ElN] = AllValV[ElN].Val2;
+		MSecsV[ElN] = GetTm(ElN);
 	}
 }
 
@@ -831,6 +903,18 @@ PJsonVal TTimeSeriesWinBuf::SaveJson(const int& Limit) const {
 
 ///////////////////////////////
 // Moving Window Buffer Count.
+void TWinBufCount::OnAddRecBatch(const PRecSet& RecSet) {
+	const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+	ClrBatch();
+	for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+		AddBatch(InBatch->GetBatchN(RecN), InBatch->GetBatchInTmMSecs(RecN), true);
+	}
+}
+
+bool TWinBufCount::IsBatch() const {
+	return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TWinBufCount::TWinBufCount(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 	const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase) :
 	TStreamAggr(Base, AggrNm) {
@@ -905,14 +989,30 @@ PJsonVal TWinBufCount::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Window Buffer Summa.
 void TWinBufSum::OnAddRec(const TRec& Rec) {
-	TFltV ValV; InAggrVal->GetOutFltV(ValV);
-	TUInt64V TmMSecsV; InAggrVal->GetOutTmMSecsV(TmMSecsV);
+	const TFltV& ValV = InAggrVal->GetOutFltV();
+	const TUInt64V& TmMSecsV = InAggrVal->GetOutTmMSecsV();
 	if (InAggr->IsInit()) {
 		Sum.Update(InAggrVal->GetInFlt(), InAggrVal->GetInTmMSecs(),
 			ValV, TmMSecsV);
 	}
 }
 
+void TWinBufSum::OnAddRecBatch(const PRecSet& RecSet) {
+	const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+	const TFltV& ValV = InBatch->GetBatchOutFltV();
+	const TUInt64V& TmMSecsV = InBatch->GetBatchOutTmMSecsV();
+	ClrBatch();
+	for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+		Sum.Update(InBatch->GetBatchInFlt(RecN), InBatch->GetBatchInTmMSecs(RecN),
+			ValV, TmMSecsV, InBatch->GetBatchOutN(RecN), InBatch->GetBatchOutN(RecN + 1));
+		AddBatch(Sum.GetSum(), Sum.GetTmMSecs(), true);
+	}
+}
+
+bool TWinBufSum::IsBatch() const {
+	return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TWinBufSum::TWinBufSum(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 	const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase) :
 	TStreamAggr(Base, AggrNm) {		
@@ -993,14 +1093,30 @@ PJsonVal TWinBufSum::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Window Buffer Min.
 void TWinBufMin::OnAddRec(const TRec& Rec) {
-	TFltV ValV; InAggrVal->GetOutFltV(ValV);
-	TUInt64V TmMSecsV; InAggrVal->GetOutTmMSecsV(TmMSecsV);	
+	const TFltV& ValV = InAggrVal->GetOutFltV();
+	const TUInt64V& TmMSecsV = InAggrVal->GetOutTmMSecsV();	
 	if (InAggr->IsInit()) {		
 		Min.Update(InAggrVal->GetInFlt(), InAggrVal->GetInTmMSecs(),
 			ValV, TmMSecsV);
 	}
 }
 
+void TWinBufMin::OnAddRecBatch(const PRecSet& RecSet) {
+	const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+	const TFltV& ValV = InBatch->GetBatchOutFltV();
+	const TUInt64V& TmMSecsV = InBatch->GetBatchOutTmMSecsV();
+	ClrBatch();
+	for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+		Min.Update(InBatch->GetBatchInFlt(RecN), InBatch->GetBatchInTmMSecs(RecN),
+			ValV, TmMSecsV, InBatch->GetBatchOutN(RecN), InBatch->GetBatchOutN(RecN + 1));
+		AddBatch(Min.GetMin(), Min.GetTmMSecs(), true);
+	}
+}
+
+bool TWinBufMin::IsBatch() const {
+	return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TWinBufMin::TWinBufMin(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 	const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase) :
 	TStreamAggr(Base, AggrNm) {
@@ -1081,14 +1197,30 @@ PJsonVal TWinBufMin::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Window Buffer Min.
 void TWinBufMax::OnAddRec(const TRec& Rec) {
-	TFltV ValV; InAggrVal->GetOutFltV(ValV);
-	TUInt64V TmMSecsV; InAggrVal->GetOutTmMSecsV(TmMSecsV);
+	const TFltV& ValV = InAggrVal->GetOutFltV();
+	const TUInt64V& TmMSecsV = InAggrVal->GetOutTmMSecsV();
 	if (InAggr->IsInit()) {
 		Max.Update(InAggrVal->GetInFlt(), InAggrVal->GetInTmMSecs(),
 			ValV, TmMSecsV);
 	}
 }
 
+void TWinBufMax::OnAddRecBatch(const PRecSet& RecSet) {
+	const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+	const TFltV& ValV = InBatch->GetBatchOutFltV();
+	const TUInt64V& TmMSecsV = InBatch->GetBatchOutTmMSecsV();
+	ClrBatch();
+	for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+		Max.Update(InBatch->GetBatchInFlt(RecN), InBatch->GetBatchInTmMSecs(RecN),
+			ValV, TmMSecsV, InBatch->GetBatchOutN(RecN), InBatch->GetBatchOutN(RecN + 1));
+		AddBatch(Max.GetMax(), Max.GetTmMSecs(), true);
+	}
+}
+
+bool TWinBufMax::IsBatch() const {
+	return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TWinBufMax::TWinBufMax(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 	const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase) :
 	TStreamAggr(Base, AggrNm) {
@@ -1169,14 +1301,30 @@ PJsonVal TWinBufMax::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Average.
 void TMa::OnAddRec(const TRec& Rec) {
-    TFltV ValV; InAggrVal->GetOutFltV(ValV);
-    TUInt64V TmMSecsV; InAggrVal->GetOutTmMSecsV(TmMSecsV);        
+    const TFltV& ValV = InAggrVal->GetOutFltV();
+    const TUInt64V& TmMSecsV = InAggrVal->GetOutTmMSecsV();        
 	if (InAggr->IsInit()) {
 		Ma.Update(InAggrVal->GetInFlt(), InAggrVal->GetInTmMSecs(),
                 ValV, TmMSecsV, InAggrVal->GetN());
 	}
 }
 
+void TMa::OnAddRecBatch(const PRecSet& RecSet) {
+    const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+    const TFltV& ValV = InBatch->GetBatchOutFltV();
+    const TUInt64V& TmMSecsV = InBatch->GetBatchOutTmMSecsV();
+    ClrBatch();
+    for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+        Ma.Update(InBatch->GetBatchInFlt(RecN), InBatch->GetBatchInTmMSecs(RecN), ValV, TmMSecsV,
+            InBatch->GetBatchOutN(RecN), InBatch->GetBatchOutN(RecN + 1), InBatch->GetBatchN(RecN));
+        AddBatch(Ma.GetMa(), Ma.GetTmMSecs(), true);
+    }
+}
+
+bool TMa::IsBatch() const {
+    return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TMa::TMa(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
         const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase): 
             TStreamAggr(Base, AggrNm), Ma() {
@@ -1262,6 +1410,21 @@ void TEma::OnAddRec(const TRec& Rec) {
 	}
 }
 
+void TEma::OnAddRecBatch(const PRecSet& RecSet) {
+	const TStreamAggrOut::IFltTmBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggr());
+	ClrBatch();
+	for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+		if (InBatch->IsBatchInit(RecN)) {
+			Ema.Update(InBatch->GetBatchFlt(RecN), InBatch->GetBatchTmMSecs(RecN));
+		}
+		AddBatch(Ema.GetEma(), Ema.GetTmMSecs(), Ema.IsInit());
+	}
+}
+
+bool TEma::IsBatch() const {
+	return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggr()) != NULL;
+}
+
 TEma::TEma(const TWPt<TBase>& Base, const TStr& AggrNm, const double& Decay, 
         const double& TmInterval, const TSignalProc::TEmaType& Type, 
         const uint64& InitMinMSecs, const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase): 
@@ -1356,8 +1519,8 @@ PJsonVal TEma::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Variance
 void TVar::OnAddRec(const TRec& Rec) {
-    TFltV ValV; InAggrVal->GetOutFltV(ValV);
-    TUInt64V TmMSecsV; InAggrVal->GetOutTmMSecsV(TmMSecsV);        
+    const TFltV& ValV = InAggrVal->GetOutFltV();
+    const TUInt64V& TmMSecsV = InAggrVal->GetOutTmMSecsV();        
 	if (InAggr->IsInit()) {		
 		TInt N = InAggrVal->GetN();
 		TFlt InFlt = InAggrVal->GetInFlt();
@@ -1366,6 +1529,22 @@ void TVar::OnAddRec(const TRec& Rec) {
 	}
 }
 
+void TVar::OnAddRecBatch(const PRecSet& RecSet) {
+    const TStreamAggrOut::IFltTmIOBatch* InBatch = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr());
+    const TFltV& ValV = InBatch->GetBatchOutFltV();
+    const TUInt64V& TmMSecsV = InBatch->GetBatchOutTmMSecsV();
+    ClrBatch();
+    for (int RecN = 0; RecN < InBatch->GetBatchLen(); RecN++) {
+        Var.Update(InBatch->GetBatchInFlt(RecN), InBatch->GetBatchInTmMSecs(RecN), ValV, TmMSecsV,
+            InBatch->GetBatchOutN(RecN), InBatch->GetBatchOutN(RecN + 1), InBatch->GetBatchN(RecN));
+        AddBatch(Var.GetM2(), Var.GetTmMSecs(), true);
+    }
+}
+
+bool TVar::IsBatch() const {
+    return InAggr->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggr()) != NULL;
+}
+
 TVar::TVar(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
         const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase): 
             TStreamAggr(Base, AggrNm), Var() {
@@ -1451,15 +1630,36 @@ PJsonVal TVar::SaveJson(const int& Limit) const {
 ///////////////////////////////
 // Moving Covariance
 void TCov::OnAddRec(const TRec& Rec) {
-    TFltV ValVX; InAggrValX->GetOutFltV(ValVX);
-    TUInt64V TmMSecsV; InAggrValX->GetOutTmMSecsV(TmMSecsV);        
-    TFltV ValVY; InAggrValY->GetOutFltV(ValVY);
+    const TFltV& ValVX = InAggrValX->GetOutFltV();
+    const TUInt64V& TmMSecsV = InAggrValX->GetOutTmMSecsV();        
+    const TFltV& ValVY = InAggrValY->GetOutFltV();
 	if (InAggrX->IsInit() && InAggrY->IsInit()) {
 		Cov.Update(InAggrValX->GetInFlt(), InAggrValY->GetInFlt(), 
             InAggrValX->GetInTmMSecs(), ValVX, ValVY, TmMSecsV, InAggrValX->GetN());
 	}
 }
 
+void TCov::OnAddRecBatch(const PRecSet& RecSet) {
+    const TStreamAggrOut::IFltTmIOBatch* InBatchX = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggrX());
+    const TStreamAggrOut::IFltTmIOBatch* InBatchY = dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggrY());
+    // as in OnAddRec, both windows are assumed to drop the same number of values
+    const TFltV& ValVX = InBatchX->GetBatchOutFltV();
+    const TUInt64V& TmMSecsV = InBatchX->GetBatchOutTmMSecsV();
+    const TFltV& ValVY = InBatchY->GetBatchOutFltV();
+    ClrBatch();
+    for (int RecN = 0; RecN < InBatchX->GetBatchLen(); RecN++) {
+        Cov.Update(InBatchX->GetBatchInFlt(RecN), InBatchY->GetBatchInFlt(RecN),
+            InBatchX->GetBatchInTmMSecs(RecN), ValVX, ValVY, TmMSecsV,
+            InBatchX->GetBatchOutN(RecN), InBatchX->GetBatchOutN(RecN + 1), InBatchX->GetBatchN(RecN));
+        AddBatch(Cov.GetCov(), Cov.GetTmMSecs(), true);
+    }
+}
+
+bool TCov::IsBatch() const {
+    return InAggrX->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggrX()) != NULL &&
+        InAggrY->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmIOBatch*>(InAggrY()) != NULL;
+}
+
 TCov::TCov(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
         const TStr& InAggrNmX, const TStr& InAggrNmY, const TWPt<TStreamAggrBase> SABase): 
             TStreamAggr(Base, AggrNm), Cov() {
@@ -1551,6 +1751,30 @@ void TCorr::OnAddRec(const TRec& Rec) {
     TmMSecs = InAggrValCov->GetTmMSecs();
 }
 
+void TCorr::OnAddRecBatch(const PRecSet& RecSet) {
+    const TStreamAggrOut::IFltTmBatch* InBatchCov = dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrCov());
+    const TStreamAggrOut::IFltTmBatch* InBatchVarX = dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrVarX());
+    const TStreamAggrOut::IFltTmBatch* InBatchVarY = dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrVarY());
+    ClrBatch();
+    for (int RecN = 0; RecN < InBatchCov->GetBatchLen(); RecN++) {
+        const double Var1 = InBatchVarX->GetBatchFlt(RecN);
+        const double Var2 = InBatchVarY->GetBatchFlt(RecN);
+        if ((Var1 == 0.0) || (Var2 == 0.0)) {
+            Corr = 1;
+        } else {
+            Corr = InBatchCov->GetBatchFlt(RecN) / (sqrt(Var1) * sqrt(Var2));
+        }
+        TmMSecs = InBatchCov->GetBatchTmMSecs(RecN);
+        AddBatch(Corr, TmMSecs, true);
+    }
+}
+
+bool TCorr::IsBatch() const {
+    return InAggrCov->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrCov()) != NULL &&
+        InAggrVarX->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrVarX()) != NULL &&
+        InAggrVarY->IsBatch() && dynamic_cast<TStreamAggrOut::IFltTmBatch*>(InAggrVarY()) != NULL;
+}
+
 TCorr::TCorr(const TWPt<TBase>& Base, const TStr& AggrNm, const TWPt<TStreamAggrBase> SABase,
         const TStr& InAggrNmCov, const TStr& InAggrNmVarX, const TStr& InAggrNmVarY): 
             TStreamAggr(Base, AggrNm) {
@@ -74,12 +74,13 @@ private:
 	PMom Mom;
 	THist Hist;
 
-	THistogram(const TWPt<TBase>& Base, const TStr& AggrNm,
-		const PRecSet& RecSet, const PFtrExt& FtrExt, const int& Buckets);
+	// values are read from the store's column of field ColumnFieldId, when not -1
+	THistogram(const TWPt<TBase>& Base, const TStr& AggrNm, const PRecSet& RecSet, 
+		const PFtrExt& FtrExt, const int& Buckets, const int& ColumnFieldId);
 public:
 	static PAggr New(const TWPt<TBase>& Base, const TStr& AggrNm, 
 		const PRecSet& RecSet, const PFtrExt& FtrExt, const int& Buckets) {
-			return new THistogram(Base, AggrNm, RecSet, FtrExt, Buckets); }
+			return new THistogram(Base, AggrNm, RecSet, FtrExt, Buckets, -1); }
 	static PAggr New(const TWPt<TBase>& Base, const TStr& AggrNm, 
 		const PRecSet& RecSet, const PJsonVal& JsonVal);
 
@@ -176,12 +177,15 @@ private:
 
 	PJsonVal GetJsonList(const TStrH& StrH) const;
 
+	void AddTm(const TTm& Tm);
+
+	// values are read from the store's column of field ColumnFieldId, when not -1
 	TTimeLine(const TWPt<TBase>& Base, const TStr& AggrNm, 
-		const PRecSet& RecSet, const PFtrExt& FtrExt);
+		const PRecSet& RecSet, const PFtrExt& FtrExt, const int& ColumnFieldId);
 public:
 	static PAggr New(const TWPt<TBase>& Base, const TStr& AggrNm, 
 		const PRecSet& RecSet, const PFtrExt& FtrExt) {
-		return new TTimeLine(Base, AggrNm, RecSet, FtrExt); }
+		return new TTimeLine(Base, AggrNm, RecSet, FtrExt, -1); }
 	static PAggr New(const TWPt<TBase>& Base, const TStr& AggrNm,
 		const PRecSet& RecSet, const PJsonVal& JsonVal);
 
@@ -213,6 +217,10 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return Buffer.IsInit(); }
+	// reads only records
+	bool IsBatch() const { return true; }
+	// changes only its own state
+	bool IsThreadSafe() const { return true; }
     
 	// serilization to JSon
 	PJsonVal SaveJson(const int& Limit) const;
@@ -266,6 +274,8 @@ public:
 	void OnAddRec(const TRec& Rec);
     /// For handling callbacks on deleted records from the store
     void OnDeleteRec(const TRec& Rec) { }
+	/// Reads only records, so batches can be added one record at a time
+	bool IsBatch() const { return true; }
 
 	/// Time window start in milliseconds (latest seen record time - time window size)
 	uint64 GetTimeWndStartMSecs() const { return MinTimeMSecs; }
@@ -309,6 +319,9 @@ public:
 	/// Save state of stream aggregate to stream
 	void _Save(TSOut& SOut) const;
 
+	// changes only its own state
+	bool IsThreadSafe() const { return true; }
+
 	// get aggregate value
 	int GetInt() const { return Count; }
 	double GetFlt() const { return (double)Count; }
@@ -321,10 +334,34 @@ public:
 	TStr Type() const { return GetType(); }
 };
 
+///////////////////////////////
+// Batch history of IFltTm stream aggregates.
+// Remembers the value after each record of the last batch, so that
+// aggregates reading this one can process the same batch.
+class TFltTmBatch : public TStreamAggrOut::IFltTmBatch {
+private:
+	TFltV BatchValV;
+	TUInt64V BatchTmMSecsV;
+	TBoolV BatchInitV;
+
+protected:
+	// start new batch
+	void ClrBatch() { BatchValV.Clr(false); BatchTmMSecsV.Clr(false); BatchInitV.Clr(false); }
+	// remember the value after the next record of the batch
+	void AddBatch(const double& Val, const uint64& TmMSecs, const bool& InitP) {
+		BatchValV.Add(Val); BatchTmMSecsV.Add(TmMSecs); BatchInitV.Add(InitP); }
+
+public:
+	int GetBatchLen() const { return BatchValV.Len(); }
+	bool IsBatchInit(const int& RecN) const { return BatchInitV[RecN]; }
+	double GetBatchFlt(const int& RecN) const { return BatchValV[RecN]; }
+	uint64 GetBatchTmMSecs(const int& RecN) const { return BatchTmMSecsV[RecN]; }
+};
+
 ///////////////////////////////
 // Time series tick.
 // Wrapper for exposing time series to signal processing aggregates 
-class TTimeSeriesTick : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TTimeSeriesTick : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	TInt TimeFieldId;
 	TInt TickValFieldId;
@@ -336,6 +373,7 @@ private:
 	
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TTimeSeriesTick(const TWPt<TBase>& Base,  const TStr& StoreNm, const TStr& AggrNm,
 		const TStr& TimeFieldNm, const TStr& TickValFieldNm);
@@ -357,6 +395,10 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return InitP; }
+	// reads only records
+	bool IsBatch() const { return true; }
+	// changes only its own state
+	bool IsThreadSafe() const { return true; }
     
 	// current values
 	double GetFlt() const { return TickVal; }
@@ -372,9 +414,11 @@ public:
 
 ///////////////////////////////
 // Time series window buffer.
-// Wrapper for exposing a window in a time series to signal processing aggregates 
-// TODO; use circular buffer
-class TTimeSeriesWinBuf : public TStreamAggr, public TStreamAggrOut::IFltTmIO, public TStreamAggrOut::IFltVec, public TStreamAggrOut::ITmVec {
+// Wrapper for exposing a window in a time series to signal processing aggregates.
+// Window is kept in a circular buffer, values leaving the window with the last
+// record are exposed to dependent aggregates without copying.
+class TTimeSeriesWinBuf : public TStreamAggr, public TStreamAggrOut::IFltTmIO, public TStreamAggrOut::IFltTmIOBatch,
+        public TStreamAggrOut::IFltVec, public TStreamAggrOut::ITmVec {
 private:
     TInt TimeFieldId;
     TInt TickValFieldId;
@@ -386,11 +430,30 @@ private:
     TUInt64 InTmMSecs;
     TFltV OutValV;
     TUInt64V OutTmMSecsV;
-    // the buffer and the time stamps
+    // the buffer and the time stamps, circular with the oldest value at FirstValN
     TFltUInt64PrV AllValV; 
+    TInt FirstValN;
+    TInt Vals;
+
+    // position of ElN-th oldest value in the circular buffer
+    int GetValN(const int& ElN) const {
+        const int ValN = FirstValN + ElN; return ValN < AllValV.Len() ? ValN : ValN - AllValV.Len(); }
+    // doubles the buffer and moves the oldest value to the start
+    void Grow();
+    // adds new value, values falling out of the window go to the outgoing vectors
+    void AddVal(const double& Val, const uint64& TmMSecs, TFltV& _OutValV, TUInt64V& _OutTmMSecsV);
+
+    // window changes after each record of the last batch
+    TFltV BatchInValV;
+    TUInt64V BatchInTmMSecsV;
+    TIntV BatchOutNV;
+    TFltV BatchOutValV;
+    TUInt64V BatchOutTmMSecsV;
+    TIntV BatchNV;
 	
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TTimeSeriesWinBuf(const TWPt<TBase>& Base,  const TStr& StoreNm, const TStr& AggrNm,
 		const TStr& TimeFieldNm, const TStr& ValFieldNm, const uint64& _WinSizeMSecs);
@@ -412,23 +475,35 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return InitP; }
+	// reads only records
+	bool IsBatch() const { return true; }
+	// changes only its own state
+	bool IsThreadSafe() const { return true; }
     
 	// most recent values
 	double GetInFlt() const { return InVal; }
 	uint64 GetInTmMSecs() const { return InTmMSecs; }
     // oldest values
-	void GetOutFltV(TFltV& ValV) const { ValV = OutValV; }
-	void GetOutTmMSecsV(TUInt64V& MSecsV) const { MSecsV = OutTmMSecsV; }  
-    int GetN() const { return AllValV.Len(); }
+	const TFltV& GetOutFltV() const { return OutValV; }
+	const TUInt64V& GetOutTmMSecsV() const { return OutTmMSecsV; }
+    int GetN() const { return Vals; }
 
 	// IFltVec
-	int GetFltLen() const {	return AllValV.Len(); }
-	double GetFlt(const TInt& ElN) const { return AllValV[ElN].Val1; }
+	int GetFltLen() const {	return Vals; }
+	double GetFlt(const TInt& ElN) const { return AllValV[GetValN(ElN)].Val1; }
 	void GetFltV(TFltV& ValV) const;
 	// ITmVec 
-	int GetTmLen() const { return AllValV.Len(); }
-	uint64 GetTm(const TInt& ElN) const { return AllValV[ElN].Val2; }
+	int GetTmLen() const { return Vals; }
+	uint64 GetTm(const TInt& ElN) const { return AllValV[GetValN(ElN)].Val2; }
 	void GetTmV(TUInt64V& MSecsV) const;
+	// IFltTmIOBatch
+	int GetBatchLen() const { return BatchInValV.Len(); }
+	double GetBatchInFlt(const int& RecN) const { return BatchInValV[RecN]; }
+	uint64 GetBatchInTmMSecs(const int& RecN) const { return BatchInTmMSecsV[RecN]; }
+	int GetBatchOutN(const int& RecN) const { return BatchOutNV[RecN]; }
+	const TFltV& GetBatchOutFltV() const { return BatchOutValV; }
+	const TUInt64V& GetBatchOutTmMSecsV() const { return BatchOutTmMSecsV; }
+	int GetBatchN(const int& RecN) const { return BatchNV[RecN]; }
 
 	// serialization to JSon
 	PJsonVal SaveJson(const int& Limit) const;
@@ -440,7 +515,7 @@ public:
 
 ///////////////////////////////
 // Moving Window Buffer Count.
-class TWinBufCount : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TWinBufCount : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -448,6 +523,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec) { /* nothing */ };
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TWinBufCount(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 		const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);
@@ -472,6 +548,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return InAggrVal->GetN(); }
 	uint64 GetTmMSecs() const { return InAggrVal->GetInTmMSecs(); }
@@ -486,7 +564,7 @@ public:
 
 ///////////////////////////////
 // Moving Window Buffer Summa.
-class TWinBufSum : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TWinBufSum : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -495,6 +573,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TWinBufSum(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 		const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);
@@ -518,6 +597,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Sum.GetSum(); }
 	uint64 GetTmMSecs() const { return Sum.GetTmMSecs(); }
@@ -532,7 +613,7 @@ public:
 
 ///////////////////////////////
 // Moving Window Buffer Min.
-class TWinBufMin : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TWinBufMin : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -541,6 +622,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TWinBufMin(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 		const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);
@@ -564,6 +646,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Min.GetMin(); }
 	uint64 GetTmMSecs() const { return Min.GetTmMSecs(); }
@@ -578,7 +662,7 @@ public:
 
 ///////////////////////////////
 // Moving Window Buffer Max.
-class TWinBufMax : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TWinBufMax : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -587,6 +671,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
 
 	TWinBufMax(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize,
 		const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);
@@ -610,6 +695,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Max.GetMax(); }
 	uint64 GetTmMSecs() const { return Max.GetTmMSecs(); }
@@ -624,7 +711,7 @@ public:
 
 ///////////////////////////////
 // Moving Average.
-class TMa : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TMa : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -634,6 +721,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
     
 	TMa(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
 			const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);
@@ -657,6 +745,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Ma.GetMa(); }
 	uint64 GetTmMSecs() const { return Ma.GetTmMSecs(); }
@@ -671,7 +761,7 @@ public:
 
 ///////////////////////////////
 // Exponential Moving Average.
-class TEma : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TEma : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -681,6 +771,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
     
 	TEma(const TWPt<TBase>& Base, const TStr& AggrNm, const double& Decay, 
         const double& TmInterval, const TSignalProc::TEmaType& Type, 
@@ -714,6 +805,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return Ema.IsInit(); }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Ema.GetEma(); }
 	uint64 GetTmMSecs() const { return Ema.GetTmMSecs(); }
@@ -728,7 +821,7 @@ public:
 
 ///////////////////////////////
 // Moving Variance.
-class TVar : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TVar : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggr;
@@ -738,6 +831,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
     
 	TVar(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
         const TStr& InAggrNm, const TWPt<TStreamAggrBase> SABase);	
@@ -761,6 +855,8 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Var.GetM2(); }
 	uint64 GetTmMSecs() const { return Var.GetTmMSecs(); }
@@ -775,7 +871,7 @@ public:
 
 ///////////////////////////////
 // Moving Covariance.
-class TCov : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TCov : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:
 	// input
 	TWPt<TStreamAggr> InAggrX, InAggrY;
@@ -785,6 +881,7 @@ private:
 
 protected:
 	void OnAddRec(const TRec& Rec);
+	void OnAddRecBatch(const PRecSet& RecSet);
     
 	TCov(const TWPt<TBase>& Base, const TStr& AggrNm, const uint64& TmWinSize, 
         const TStr& InAggrNmX, const TStr& InAggrNmY, const TWPt<TStreamAggrBase> SABase);	
@@ -800,6 +897,8 @@ public:
     
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Cov.GetCov(); }
 	uint64 GetTmMSecs() const { return Cov.GetTmMSecs(); }
@@ -815,7 +914,7 @@ public:
 
 ///////////////////////////////
 // Moving Correlation.
-class TCorr : public TStreamAggr, public TStreamAggrOut::IFltTm {
+class TCorr : public TStreamAggr, public TStreamAggrOut::IFltTm, public TFltTmBatch {
 private:    
 	// input
 	TWPt<TStreamAggr> InAggrCov, InAggrVarX, InAggrVarY;
@@ -830,6 +929,7 @@ private:
     
 protected:
 	void OnAddRec(const TRec& Rec);    
+	void OnAddRecBatch(const PRecSet& RecSet);
     
 	TCorr(const TWPt<TBase>& Base, const TStr& AggrNm, const TWPt<TStreamAggrBase> SABase,
         const TStr& InAggrNmCov, const TStr& InAggrNmVarX, const TStr& InAggrNmVarY);
@@ -858,6 +958,8 @@ public:
     
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	bool IsBatch() const;
+	bool IsThreadSafe() const { return true; }
 	// current values
 	double GetFlt() const { return Corr; }
 	uint64 GetTmMSecs() const { return 0; }
@@ -1090,6 +1192,10 @@ public:
 
 	// did we finish initialization
 	bool IsInit() const { return true; }
+	// reads only records
+	bool IsBatch() const { return true; }
+	// feature extraction can run in parallel when all extractors allow it
+	bool IsThreadSafe() const { return FtrSpace->IsThreadSafe(); }
 	// retrieving vector of values from the aggregate
 	int GetFltLen() const { return FtrSpace->GetDim(); }
 	void GetFltV(TFltV& ValV) const { ValV = Vec; }
@@ -332,6 +332,14 @@ bool TStoreIterVec::Next() {
 	return true;
 }
 
+///////////////////////////////
+// QMiner-Store-Trigger
+void TStoreTrigger::OnAddBatch(const PRecSet& RecSet) {
+    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+        OnAdd(RecSet->GetRec(RecN));
+    }
+}
+
 ///////////////////////////////
 // QMiner-Store
 void TStore::LoadStore(TSIn& SIn) {	
@@ -349,14 +357,14 @@ void TStore::LoadStore(TSIn& SIn) {
 }
 
 TStore::TStore(const TWPt<TBase>& _Base, uint _StoreId, const TStr& _StoreNm): 
-    Base(_Base), Index(_Base->GetIndex()), StoreId(_StoreId), StoreNm(_StoreNm) {   
+    Base(_Base), Index(_Base->GetIndex()), StoreId(_StoreId), StoreNm(_StoreNm), TriggerP(true) {   
         TValidNm::AssertValidNm(StoreNm); }
     
 TStore::TStore(const TWPt<TBase>& _Base, TSIn& SIn): 
-    Base(_Base), Index(_Base->GetIndex()) { LoadStore(SIn); }
+    Base(_Base), Index(_Base->GetIndex()), TriggerP(true) { LoadStore(SIn); }
 
 TStore::TStore(const TWPt<TBase>& _Base, const TStr& FNm):
-    Base(_Base), Index(_Base->GetIndex()) { TFIn FIn(FNm); LoadStore(FIn); }
+    Base(_Base), Index(_Base->GetIndex()), TriggerP(true) { TFIn FIn(FNm); LoadStore(FIn); }
 
 void TStore::SaveStore(TSOut& SOut) const { 
     StoreId.Save(SOut); StoreNm.Save(SOut); 
@@ -385,19 +393,63 @@ PExcept TStore::FieldError(const int& FieldId, const TStr& TypeStr) const {
 	return TQmExcept::New(TStr::Fmt("Wrong field-type combination requested: [%d:%s]!", FieldId, TypeStr.CStr())); 
 }
 
+void TStore::GetJsonLnBatch(const PSIn& SIn, const int& BatchLen, TStrV& LnV) {
+    LnV.Gen(BatchLen, 0); TChA LnChA;
+    while (LnV.Len() < BatchLen && SIn->GetNextLn(LnChA)) {
+        // skip empty lines
+        TStr LnStr = LnChA; if (LnStr.IsWs()) { continue; }
+        LnV.Add(LnStr);
+    }
+}
+
+PJsonVal TStore::GetJsonLnRecVal(const TStr& LnStr) {
+    bool Ok = true; TStr MsgStr;
+    PJsonVal RecVal = TJsonVal::GetValFromStr(LnStr, Ok, MsgStr);
+    if (!Ok || !RecVal->IsObj()) {
+        ErrorLog("[TStore::GetJsonLnRecVal] Invalid JSon line: " + (Ok ? TStr("not an object") : MsgStr));
+        return PJsonVal();
+    }
+    return RecVal;
+}
+
 void TStore::OnAdd(const uint64& RecId) {
+    if (!TriggerP) { return; }
+    TWalOp::TTriggerScope WalTriggerScope(Base);
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnAdd(GetRec(RecId));
     }
 }
 
+void TStore::OnAddBatch(const TUInt64V& RecIdV) {
+    if (!TriggerP) { return; }
+    // triggers see whole batch one after another only when none of them
+    // depends on the others seeing each record first
+    bool BatchP = true;
+    for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
+        if (!TriggerV[TriggerN]->IsBatch()) { BatchP = false; break; }
+    }
+    if (BatchP) {
+        TWalOp::TTriggerScope WalTriggerScope(Base);
+        PRecSet RecSet = TRecSet::New(this, RecIdV);
+        for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
+            TriggerV[TriggerN]->OnAddBatch(RecSet);
+        }
+    } else {
+        for (int RecN = 0; RecN < RecIdV.Len(); RecN++) { OnAdd(RecIdV[RecN]); }
+    }
+}
+
 void TStore::OnUpdate(const uint64& RecId) {
+    if (!TriggerP) { return; }
+    TWalOp::TTriggerScope WalTriggerScope(Base);
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnUpdate(GetRec(RecId));
     }
 }
 
 void TStore::OnDelete(const uint64& RecId) {
+    if (!TriggerP) { return; }
+    TWalOp::TTriggerScope WalTriggerScope(Base);
     for (int TriggerN = 0; TriggerN < TriggerV.Len(); TriggerN++) {
         TriggerV[TriggerN]->OnDelete(GetRec(RecId));
     }
@@ -553,6 +605,8 @@ PRecSet TStore::GetRndRecs(const uint64& SampleSize) {
 }
 
 void TStore::AddJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
+    TWalOp WalOp(Base);
+    if (WalOp.IsLog()) { WalOp.GetWal().AddJoin(StoreId, WalOp.GetOpMSecs(), JoinId, RecId, JoinRecId, JoinFq); }
     const TJoinDesc& JoinDesc = GetJoinDesc(JoinId);
     // different handling for field and index joins
     if (JoinDesc.IsIndexJoin()) {
@@ -579,7 +633,31 @@ void TStore::AddJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRe
     }
 }
 
+uint64 TStore::AddRecBulk(const PSIn& SIn, const int& BatchLen, const int64& IndexCacheSize, const bool& _TriggerP) {
+    uint64 Recs = 0; TStrV LnV;
+    PutTriggerP(_TriggerP);
+    try {
+        while (!SIn->Eof()) {
+            GetJsonLnBatch(SIn, BatchLen, LnV);
+            for (int LnN = 0; LnN < LnV.Len(); LnN++) {
+                uint64 RecId = TUInt64::Mx;
+                if (!TryAddRecJsonStr(LnV[LnN], RecId)) {
+                    PJsonVal RecVal = GetJsonLnRecVal(LnV[LnN]);
+                    if (!RecVal.Empty()) { RecId = AddRec(RecVal); }
+                }
+                if (RecId != TUInt64::Mx) { Recs++; }
+            }
+        }
+    } catch (const PExcept& Except) {
+        PutTriggerP(true); throw Except;
+    }
+    PutTriggerP(true);
+    return Recs;
+}
+
 void TStore::DelJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
+    TWalOp WalOp(Base);
+    if (WalOp.IsLog()) { WalOp.GetWal().DelJoin(StoreId, WalOp.GetOpMSecs(), JoinId, RecId, JoinRecId, JoinFq); }
     const TJoinDesc& JoinDesc = GetJoinDesc(JoinId);
     // different handling for field and index joins
     if (JoinDesc.IsIndexJoin()) {
@@ -657,6 +735,32 @@ void TStore::GetFieldBowSpV(const uint64& RecId, const int& FieldId, PBowSpV& Sp
 	throw FieldError(FieldId, "BowSpV"); 
 }
 
+TStrView TStore::GetFieldStrView(const uint64& RecId, const int& FieldId, TMem& RecMem) const {
+	const TStr Str = GetFieldStr(RecId, FieldId);
+	RecMem.Clr(false); RecMem.AddBf(Str.CStr(), Str.Len());
+	return TStrView(RecMem.GetBf(), Str.Len());
+}
+
+void TStore::GetFieldFltColumn(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TFltV& ValV) const {
+	const TFieldDesc& Desc = GetFieldDesc(FieldId);
+	QmAssertR(Desc.IsInt() || Desc.IsFlt(), "Wrong field type, numeric expected");
+	ValV.Gen(RecIdFqV.Len(), 0);
+	for (int RecN = 0; RecN < RecIdFqV.Len(); RecN++) {
+		const uint64 RecId = RecIdFqV[RecN].Key;
+		ValV.Add(Desc.IsInt() ? (double)GetFieldInt(RecId, FieldId) : GetFieldFlt(RecId, FieldId));
+	}
+}
+
+void TStore::GetFieldUInt64Column(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TUInt64V& ValV) const {
+	const TFieldDesc& Desc = GetFieldDesc(FieldId);
+	QmAssertR(Desc.IsUInt64() || Desc.IsTm(), "Wrong field type, uint64 or time expected");
+	ValV.Gen(RecIdFqV.Len(), 0);
+	for (int RecN = 0; RecN < RecIdFqV.Len(); RecN++) {
+		const uint64 RecId = RecIdFqV[RecN].Key;
+		ValV.Add(Desc.IsTm() ? GetFieldTmMSecs(RecId, FieldId) : GetFieldUInt64(RecId, FieldId));
+	}
+}
+
 bool TStore::IsFieldNmNull(const uint64& RecId, const TStr& FieldNm) const { 
 	return IsFieldNull(RecId, GetFieldId(FieldNm)); 
 }
@@ -896,6 +1000,58 @@ TStr TStore::GetFieldText(const uint64& RecId, const int& FieldId) const {
 	throw FieldError(FieldId, "GetDisplayText");
 }
 
+void TStore::WriteFieldJson(const uint64& RecId, const int& FieldId, TJsonWriter& Writer) const {
+    const TFieldDesc& Desc = GetFieldDesc(FieldId);
+    if (Desc.IsInt()) {
+		Writer.PutNum((double)GetFieldInt(RecId, FieldId));
+    } else if (Desc.IsIntV()) {
+        TIntV FieldIntV; GetFieldIntV(RecId, FieldId, FieldIntV);
+		Writer.PutArrStart();
+		for (int ValN = 0; ValN < FieldIntV.Len(); ValN++) { Writer.PutNum((double)FieldIntV[ValN]); }
+		Writer.PutArrEnd();
+    } else if (Desc.IsUInt64()) {
+		Writer.PutNum((double)GetFieldUInt64(RecId, FieldId));
+	} else if (Desc.IsStr()) {
+        Writer.PutStr(GetFieldStr(RecId, FieldId));
+    } else if (Desc.IsStrV()) {
+        TStrV FieldStrV; GetFieldStrV(RecId, FieldId, FieldStrV);
+		Writer.PutArrStart();
+		for (int ValN = 0; ValN < FieldStrV.Len(); ValN++) { Writer.PutStr(FieldStrV[ValN]); }
+		Writer.PutArrEnd();
+    } else if (Desc.IsBool()) {
+        Writer.PutBool(GetFieldBool(RecId, FieldId));
+    } else if (Desc.IsFlt()) {
+		Writer.PutNum(GetFieldFlt(RecId, FieldId));
+    } else if (Desc.IsFltPr()) {
+        const TFltPr FieldFltPr = GetFieldFltPr(RecId, FieldId);
+		Writer.PutArrStart(); Writer.PutNum(FieldFltPr.Val1); Writer.PutNum(FieldFltPr.Val2); Writer.PutArrEnd();
+	} else if (Desc.IsFltV()) {
+        TFltV FieldFltV; GetFieldFltV(RecId, FieldId, FieldFltV);
+		Writer.PutArrStart();
+		for (int ValN = 0; ValN < FieldFltV.Len(); ValN++) { Writer.PutNum(FieldFltV[ValN]); }
+		Writer.PutArrEnd();
+    } else if (Desc.IsTm()) {
+        TTm FieldTm; GetFieldTm(RecId, FieldId, FieldTm);
+		if (FieldTm.IsDef()) { Writer.PutStr(FieldTm.GetWebLogDateTimeStr(true, "T", false)); } else { Writer.PutNull(); }
+	} else if (Desc.IsNumSpV()) {
+		TIntFltKdV FieldIntFltKdV; GetFieldNumSpV(RecId, FieldId, FieldIntFltKdV);
+		Writer.PutStr(TStrUtil::GetStr(FieldIntFltKdV));
+	} else if (Desc.IsBowSpV()) {
+		Writer.PutStr("[PBowSpV]"); //TODO
+    } else {
+		throw FieldError(FieldId, "WriteFieldJson");
+	}
+}
+
+void TStore::WriteRecFieldsJson(const uint64& RecId, const TIntV& FieldIdV, TJsonWriter& Writer) const {
+	for (int FieldN = 0; FieldN < FieldIdV.Len(); FieldN++) {
+		const int FieldId = FieldIdV[FieldN];
+		if (IsFieldNull(RecId, FieldId)) { continue; }
+		Writer.PutKey(GetFieldNm(FieldId));
+		WriteFieldJson(RecId, FieldId, Writer);
+	}
+}
+
 PJsonVal TStore::GetFieldNmJson(const uint64& RecId, const TStr& FieldNm) const { 
 	return GetFieldJson(RecId, GetFieldId(FieldNm)); 
 }
@@ -993,6 +1149,7 @@ PJsonVal TStore::GetStoreJson(const TWPt<TBase>& Base) const {
 	StoreVal->AddToObj("fields", GetStoreFieldsJson());
 	StoreVal->AddToObj("keys", GetStoreKeysJson(Base));
 	StoreVal->AddToObj("joins", GetStoreJoinsJson(Base));
+	StoreVal->AddToObj("stats", GetStoreStatJson());
 	return StoreVal;
 }
 
@@ -1764,6 +1921,79 @@ PJsonVal TRec::GetJson(const TWPt<TBase>& Base, const bool& FieldsP,
 	return RecVal;
 }
 
+void TRec::WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const bool& FieldsP,
+		const bool& StoreInfoP, const bool& JoinRecsP, const bool& JoinRecFieldsP,
+		const bool& RecInfoP, const TIntV& FieldIdV) const {
+
+	WriteJson(Base, Writer, FieldsP, StoreInfoP, JoinRecsP, JoinRecFieldsP, RecInfoP, FieldIdV, -1);
+}
+
+void TRec::GetJsonFieldIdV(const TWPt<TStore>& Store, TIntV& FieldIdV) {
+	FieldIdV.Clr();
+	for (int FieldId = 0; FieldId < Store->GetFields(); FieldId++) {
+		// skip internal fields (e.g. record ids for joins)
+		if (!Store->GetFieldDesc(FieldId).IsInternal()) { FieldIdV.Add(FieldId); }
+	}
+}
+
+void TRec::WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const bool& FieldsP,
+		const bool& StoreInfoP, const bool& JoinRecsP, const bool& JoinRecFieldsP,
+		const bool& RecInfoP, const TIntV& FieldIdV, const int& JoinFq) const {
+
+	Writer.PutObjStart();
+	if (StoreInfoP) {
+		Writer.PutKey("$store"); Writer.PutObjStart();
+		Writer.PutKey("$id"); Writer.PutNum((double)Store->GetStoreId());
+		Writer.PutKey("$name"); Writer.PutStr(Store->GetStoreNm());
+		Writer.PutObjEnd();
+	}
+	// record name and id only if stored by reference
+	if (ByRefP && RecInfoP) {
+		Writer.PutKey("$id"); Writer.PutNum((double)RecId);
+		// put name only when no fields displayed and one exists in the store
+		if (!FieldsP && Store->HasRecNm()) { 
+			Writer.PutKey("$name"); Writer.PutStr(Store->GetRecNm(RecId));
+		}
+	}
+	if (FieldsP) {
+		TIntV AllFieldIdV; if (FieldIdV.Empty()) { GetJsonFieldIdV(Store, AllFieldIdV); }
+		const TIntV& OutFieldIdV = FieldIdV.Empty() ? AllFieldIdV : FieldIdV;
+		if (ByRefP) {
+			Store->WriteRecFieldsJson(RecId, OutFieldIdV, Writer);
+		} else {
+			for (int FieldN = 0; FieldN < OutFieldIdV.Len(); FieldN++) {
+				const int FieldId = OutFieldIdV[FieldN];
+				if (IsFieldNull(FieldId)) { continue; }
+				Writer.PutKey(Store->GetFieldNm(FieldId)); Writer.PutVal(GetFieldJson(FieldId));
+			}
+		}
+	}
+	// get the join fields
+	if (JoinRecsP) {
+		const int Joins = Store->GetJoins();
+		for (int JoinId = 0; JoinId < Joins; JoinId++) {
+			const TJoinDesc& JoinDesc = Store->GetJoinDesc(JoinId);
+			if (JoinDesc.IsIndexJoin()) {
+				PRecSet JoinSet = DoJoin(Base, JoinDesc.GetJoinId());
+				Writer.PutKey(JoinDesc.GetJoinNm()); Writer.PutArrStart();
+				for (int RecN = 0; RecN < JoinSet->GetRecs(); RecN++) {
+					JoinSet->GetRec(RecN).WriteJson(Base, Writer, JoinRecFieldsP, false, false, 
+						false, true, TIntV(), JoinSet->GetRecFq(RecN));
+				}
+				Writer.PutArrEnd();
+			} else if (JoinDesc.IsFieldJoin()) {
+				TRec JoinRec = DoSingleJoin(Base, JoinDesc.GetJoinId());
+				if (JoinRec.IsDef()) {
+					Writer.PutKey(JoinDesc.GetJoinNm());
+					JoinRec.WriteJson(Base, Writer, JoinRecFieldsP, false, false);
+				}
+			}
+		}
+	}
+	if (JoinFq >= 0) { Writer.PutKey("$fq"); Writer.PutNum((double)JoinFq); }
+	Writer.PutObjEnd();
+}
+
 ///////////////////////////////
 // QMiner-ResultSet
 void TRecSet::GetSampleRecIdV(const int& SampleSize, 
@@ -1902,15 +2132,15 @@ void TRecSet::SortByFq(const bool& Asc) {
 void TRecSet::SortByField(const bool& Asc, const int& SortFieldId) {
     // get store and field type
 	const TFieldDesc& Desc = Store->GetFieldDesc(SortFieldId);
-    // apply appropriate comparator
-	if (Desc.IsInt()) {       
-        SortCmp(TRecCmpByFieldInt(Store, SortFieldId, Asc));
-	} else if (Desc.IsFlt()) {
-        SortCmp(TRecCmpByFieldFlt(Store, SortFieldId, Asc));
+    // numeric fields are read once and sorted by value, strings use comparator
+	if (Desc.IsInt() || Desc.IsFlt()) {
+        TFltV ValV; Store->GetFieldFltColumn(RecIdFqV, SortFieldId, ValV);
+        SortByValV(ValV, Asc);
     } else if (Desc.IsStr()) {
         SortCmp(TRecCmpByFieldStr(Store, SortFieldId, Asc));
     } else if (Desc.IsTm()) {
-        SortCmp(TRecCmpByFieldTm(Store, SortFieldId, Asc));
+        TUInt64V ValV; Store->GetFieldUInt64Column(RecIdFqV, SortFieldId, ValV);
+        SortByValV(ValV, Asc);
 	} else {
 		throw TQmExcept::New("Unsupported sort field type!");
 	}
@@ -1941,7 +2171,12 @@ void TRecSet::FilterByFieldInt(const int& FieldId, const int& MinVal, const int&
 	const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsInt(), "Wrong field type, integer expected");
 	// apply the filter
-    FilterBy(TRecFilterByFieldInt(Store, FieldId, MinVal, MaxVal));
+    if (Store->IsFieldColumn(FieldId)) {
+        TFltV ValV; Store->GetFieldFltColumn(RecIdFqV, FieldId, ValV);
+        FilterByValV<TFlt>(ValV, (double)MinVal, (double)MaxVal);
+    } else {
+        FilterBy(TRecFilterByFieldInt(Store, FieldId, MinVal, MaxVal));
+    }
 }
 
 void TRecSet::FilterByFieldFlt(const int& FieldId, const double& MinVal, const double& MaxVal) {
@@ -1949,7 +2184,12 @@ void TRecSet::FilterByFieldFlt(const int& FieldId, const double& MinVal, const d
 	const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsFlt(), "Wrong field type, numeric expected");
 	// apply the filter
-    FilterBy(TRecFilterByFieldFlt(Store, FieldId, MinVal, MaxVal));
+    if (Store->IsFieldColumn(FieldId)) {
+        TFltV ValV; Store->GetFieldFltColumn(RecIdFqV, FieldId, ValV);
+        FilterByValV<TFlt>(ValV, MinVal, MaxVal);
+    } else {
+        FilterBy(TRecFilterByFieldFlt(Store, FieldId, MinVal, MaxVal));
+    }
 }
 
 void TRecSet::FilterByFieldStr(const int& FieldId, const TStr& FldVal) {
@@ -1974,7 +2214,12 @@ void TRecSet::FilterByFieldTm(const int& FieldId, const uint64& MinVal, const ui
 	const TFieldDesc& Desc = Store->GetFieldDesc(FieldId);
     QmAssertR(Desc.IsTm(), "Wrong field type, time expected");
 	// apply the filter
-    FilterBy(TRecFilterByFieldTm(Store, FieldId, MinVal, MaxVal));
+    if (Store->IsFieldColumn(FieldId)) {
+        TUInt64V ValV; Store->GetFieldUInt64Column(RecIdFqV, FieldId, ValV);
+        FilterByValV<TUInt64>(ValV, MinVal, MaxVal);
+    } else {
+        FilterBy(TRecFilterByFieldTm(Store, FieldId, MinVal, MaxVal));
+    }
 }
 
 void TRecSet::FilterByFieldTm(	const int& FieldId, const TTm& MinVal, const TTm& MaxVal) {
@@ -2185,6 +2430,40 @@ PJsonVal TRecSet::GetJson(const TWPt<TBase>& Base, const int& _MxHits, const int
 	return RecSetVal;
 }
 
+void TRecSet::WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const int& _MxHits,
+		const int& Offset, const bool& FieldsP, const bool& AggrsP, const bool& StoreInfoP,
+		const bool& JoinRecsP, const bool& JoinRecFieldsP, const TIntV& FieldIdV) const {
+
+	const int MxHits = (_MxHits == -1) ? GetRecs() : _MxHits;
+	Writer.PutObjStart();
+	if (StoreInfoP) {
+		Writer.PutKey("$store"); Writer.PutObjStart();
+		Writer.PutKey("$id"); Writer.PutNum((double)Store->GetStoreId());
+		Writer.PutKey("$name"); Writer.PutStr(Store->GetStoreNm());
+		Writer.PutKey("$wgt"); Writer.PutBool(IsWgt());
+		Writer.PutObjEnd();
+	}
+	const int Recs = GetRecs();
+	Writer.PutKey("$hits"); Writer.PutNum((double)Recs);
+	// resolve the fields once for all the records
+	TIntV OutFieldIdV = FieldIdV;
+	if (FieldsP && OutFieldIdV.Empty()) { TRec::GetJsonFieldIdV(Store, OutFieldIdV); }
+	// output hits
+	Writer.PutKey("records"); Writer.PutArrStart();
+	int Hits = 0;
+	for (int RecN = Offset; RecN < Recs; RecN++) {
+		// deal with offset
+		Hits++; if (Hits > MxHits) { break; }
+		GetRec(RecN).WriteJson(Base, Writer, FieldsP, false, JoinRecsP, JoinRecFieldsP, true, OutFieldIdV);
+	}
+	Writer.PutArrEnd();
+	// output aggregations
+	if (AggrsP) { 
+		Writer.PutKey("aggregates"); Writer.PutVal(GetAggrJson());
+	}
+	Writer.PutObjEnd();
+}
+
 ///////////////////////////////
 // QMiner-Index-Key
 TIndexKey::TIndexKey(const uint& _StoreId, const TStr& _KeyNm, const int& _WordVocId, 
@@ -2223,10 +2502,43 @@ uint64 TIndexWordVoc::AddWordStr(const TStr& WordStr) {
 	const int WordId = WordH.AddKey(WordStr); 
 	// increase the count for the word, used for autocomplete
 	WordH[WordId]++;
+	// remember changed count of a word saved by the last checkpoint
+	if (CheckpointP && WordId < CheckpointWords) { ChangedWordIdSet.AddKey(WordId); }
 	// return the id
 	return (uint64)WordId;
 }
 
+void TIndexWordVoc::SaveDelta(TSOut& SOut) const {
+	// new words with their counts
+	TInt(WordH.Len() - CheckpointWords).Save(SOut);
+	for (int WordId = CheckpointWords; WordId < WordH.Len(); WordId++) {
+		TStr(WordH.GetKey(WordId)).Save(SOut); WordH[WordId].Save(SOut);
+	}
+	// new counts of old words
+	TInt(ChangedWordIdSet.Len()).Save(SOut);
+	int KeyId = ChangedWordIdSet.FFirstKeyId();
+	while (ChangedWordIdSet.FNextKeyId(KeyId)) {
+		const int WordId = ChangedWordIdSet.GetKey(KeyId);
+		TInt(WordId).Save(SOut); WordH[WordId].Save(SOut);
+	}
+}
+
+int TIndexWordVoc::LoadDelta(TSIn& SIn) {
+	// new words get the same ids as before, since words are never deleted
+	TInt NewWords(SIn);
+	for (int WordN = 0; WordN < NewWords; WordN++) {
+		TStr WordStr(SIn); TInt WordFq(SIn);
+		const int WordId = WordH.AddKey(WordStr);
+		QmAssertR(WordId == WordH.Len() - 1, "Word vocabulary delta out of order");
+		WordH[WordId] = WordFq;
+	}
+	TInt ChangedWords(SIn);
+	for (int WordN = 0; WordN < ChangedWords; WordN++) {
+		TInt WordId(SIn); TInt WordFq(SIn); WordH[WordId] = WordFq;
+	}
+	return NewWords + ChangedWords;
+}
+
 void TIndexWordVoc::GetWcWordIdV(const TStr& WcStr, TUInt64V& WcWordIdV) {
     WcWordIdV.Clr();
     int WordId = WordH.FFirstKeyId();
@@ -2318,7 +2630,7 @@ const PIndexWordVoc& TIndexVoc::GetWordVoc(const int& KeyId) const {
 	return WordVocV[KeyH[KeyId].GetWordVocId()];
 }
 
-TIndexVoc::TIndexVoc(TSIn& SIn) {	
+TIndexVoc::TIndexVoc(TSIn& SIn): KeysChangedP(true) {	
     KeyH.Load(SIn);
     StoreIdKeyIdSetH.Load(SIn);
     WordVocV.Load(SIn);
@@ -2329,6 +2641,46 @@ void TIndexVoc::Save(TSOut& SOut) const {
     StoreIdKeyIdSetH.Save(SOut);
     WordVocV.Save(SOut);
 }
+
+void TIndexVoc::SaveDelta(TSOut& SOut) const {
+	QmAssertR(IsDelta(), "Index vocabulary keys changed, full save required");
+	TInt(WordVocV.Len()).Save(SOut);
+	for (int WordVocN = 0; WordVocN < WordVocV.Len(); WordVocN++) {
+		WordVocV[WordVocN]->SaveDelta(SOut);
+	}
+}
+
+uint64 TIndexVoc::LoadDelta(TSIn& SIn) {
+	TInt WordVocs(SIn); uint64 DeltaWords = 0;
+	QmAssertR(WordVocs == WordVocV.Len(), "Index vocabulary delta does not match vocabularies");
+	for (int WordVocN = 0; WordVocN < WordVocV.Len(); WordVocN++) {
+		DeltaWords += (uint64)WordVocV[WordVocN]->LoadDelta(SIn);
+	}
+	return DeltaWords;
+}
+
+uint64 TIndexVoc::GetAllWords() const {
+	uint64 Words = 0;
+	for (int WordVocN = 0; WordVocN < WordVocV.Len(); WordVocN++) {
+		Words += WordVocV[WordVocN]->GetWords();
+	}
+	return Words;
+}
+
+uint64 TIndexVoc::GetDeltaWords() const {
+	uint64 DeltaWords = 0;
+	for (int WordVocN = 0; WordVocN < WordVocV.Len(); WordVocN++) {
+		DeltaWords += (uint64)WordVocV[WordVocN]->GetDeltaWords();
+	}
+	return DeltaWords;
+}
+
+void TIndexVoc::OnCommit() {
+	for (int WordVocN = 0; WordVocN < WordVocV.Len(); WordVocN++) {
+		WordVocV[WordVocN]->OnCommit();
+	}
+	KeysChangedP = false;
+}
 	
 bool TIndexVoc::IsKeyId(const int& KeyId) const { 	
     return KeyH.IsKeyId(KeyId); 
@@ -2371,6 +2723,7 @@ int TIndexVoc::GetWordVoc(const TStr& WordVocNm) const {
 
 void TIndexVoc::SetWordVocNm(const int& WordVocId, const TStr& WordVocNm) {
     WordVocV[WordVocId]->SetWordVocNm(WordVocNm);
+    KeysChangedP = true;
 }
 
 int TIndexVoc::AddKey(const uint& StoreId, const TStr& KeyNm, const int& WordVocId, 
@@ -2383,6 +2736,7 @@ int TIndexVoc::AddKey(const uint& StoreId, const TStr& KeyNm, const int& WordVoc
 	KeyH[KeyId].PutKeyId(KeyId);
 	// add the key to the associated store key set
 	StoreIdKeyIdSetH.AddDat(StoreId).AddKey(KeyId);
+	KeysChangedP = true;
 	return KeyId;
 }
 
@@ -2390,12 +2744,14 @@ int TIndexVoc::AddInternalKey(const uint& StoreId, const TStr& KeyNm, const TStr
 	const int KeyId = KeyH.AddKey(TUIntStrPr(StoreId, KeyNm));
 	KeyH[KeyId] = TIndexKey(StoreId, KeyNm, JoinNm);
 	KeyH[KeyId].PutKeyId(KeyId);
+	KeysChangedP = true;
 	return KeyId;
 }
 
 void TIndexVoc::AddKeyField(const int& KeyId, const uint& StoreId, const int& FieldId) {
 	QmAssert(StoreId == KeyH[KeyId].GetStoreId());
 	KeyH[KeyId].AddField(FieldId);
+	KeysChangedP = true;
 }
 
 bool TIndexVoc::IsStoreKeys(const uint& StoreId) const {
@@ -2543,6 +2899,7 @@ const PTokenizer& TIndexVoc::GetTokenizer(const int& KeyId) const {
 
 void TIndexVoc::PutTokenizer(const int& KeyId, const PTokenizer& Tokenizer) {
     KeyH[KeyId].PutTokenizer(Tokenizer);
+    KeysChangedP = true;
 }
 
 void TIndexVoc::SaveTxt(const TWPt<TBase>& Base, const TStr& FNm) const {
@@ -3240,6 +3597,8 @@ public:
 	void AddKey(const TFltPr& Loc, const uint64& RecId);
 	// delete record
 	void DelKey(const TFltPr& Loc, const uint64& RecId);
+	// add all records from another index
+	void Merge(const PGeoIndex& GeoIndex);
 	// range query (in meters)
 	void SearchRange(const TFltPr& Loc, const double& Radius,
 		const int& Limit, TUInt64V& RecIdV) const;
@@ -3308,6 +3667,17 @@ void TGeoIndex::DelKey(const TFltPr& Loc, const uint64& RecId) {
 	}
 }
 
+void TGeoIndex::Merge(const PGeoIndex& GeoIndex) {
+	int LocKeyId = GeoIndex->LocRecIdH.FFirstKeyId();
+	while (GeoIndex->LocRecIdH.FNextKeyId(LocKeyId)) {
+		// location ids are rounded coordinates, transform them back
+		const TIntPr& LocId = GeoIndex->LocRecIdH.GetKey(LocKeyId);
+		const TFltPr Loc(LocId.Val1 / GeoIndex->Precision, LocId.Val2 / GeoIndex->Precision);
+		const TUInt64V& RecIdV = GeoIndex->LocRecIdH[LocKeyId];
+		for (int RecN = 0; RecN < RecIdV.Len(); RecN++) { AddKey(Loc, RecIdV[RecN]); }
+	}
+}
+
 void TGeoIndex::SearchRange(const TFltPr& Loc, const double& Radius, 
 		const int& Limit, TUInt64V& RecIdV) const {
 
@@ -3325,6 +3695,138 @@ bool TGeoIndex::LocEquals(const TFltPr& Loc1, const TFltPr& Loc2) const {
 	return (LocId1 == LocId2);
 }
 
+///////////////////////////////
+// RangeIndex
+class TRangeIndex {
+private: 
+	// smart-pointer
+	TCRef CRef;
+	friend class TPt<TRangeIndex>;
+
+	// (value, record id) pair with its frequency
+	typedef TKeyDat<TFltUInt64Pr, TInt> TValRecFq;
+	typedef TVec<TValRecFq> TValRecFqV;
+
+	// maximal number of elements in a block before it is split
+	TInt MxBlockLen;
+	// blocks of (value, record id) pairs with frequencies, each block sorted
+	TVec<TValRecFqV> BlockV;
+	// ids of non-empty blocks, sorted by their first element
+	TIntV BlockIdV;
+	// ids of blocks emptied by deletes, reused when splitting
+	TIntV FreeBlockIdV;
+
+	// get empty block
+	int NewBlock();
+	// position in BlockIdV of the block where given element belongs
+	int GetBlockN(const TFltUInt64Pr& ValRecId) const;
+
+public:
+	// create new empty index
+	TRangeIndex(const int& _MxBlockLen): MxBlockLen(_MxBlockLen) { }
+	static PRangeIndex New(const int& MxBlockLen = 1024) { return new TRangeIndex(MxBlockLen); }
+	// load existing index
+	TRangeIndex(TSIn& SIn): MxBlockLen(SIn), BlockV(SIn), BlockIdV(SIn), FreeBlockIdV(SIn) { }
+	static PRangeIndex Load(TSIn& SIn) { return new TRangeIndex(SIn); }
+	// save index
+	void Save(TSOut& SOut) { MxBlockLen.Save(SOut); BlockV.Save(SOut); BlockIdV.Save(SOut); FreeBlockIdV.Save(SOut); }
+
+	// add record, frequencies of the same value and record are summed up
+	void AddKey(const double& Val, const uint64& RecId, const int& Fq);
+	// delete record, pair is removed when its frequency drops to zero
+	void DelKey(const double& Val, const uint64& RecId, const int& Fq);
+	// add all records from another range index
+	void Merge(const PRangeIndex& RangeIndex);
+	// records with values strictly between the bounds with their 
+	// frequencies, ordered by value
+	void SearchRange(const double& MnVal, const double& MxVal, TUInt64IntKdV& RecIdFqV) const;
+};
+
+int TRangeIndex::NewBlock() {
+	if (FreeBlockIdV.Empty()) { return BlockV.Add(); }
+	const int BlockId = FreeBlockIdV.Last(); FreeBlockIdV.DelLast();
+	return BlockId;
+}
+
+int TRangeIndex::GetBlockN(const TFltUInt64Pr& ValRecId) const {
+	// find the last block with first element not greater than the given one
+	int LBlockN = 0, RBlockN = BlockIdV.Len() - 1;
+	while (LBlockN < RBlockN) {
+		const int BlockN = (LBlockN + RBlockN + 1) / 2;
+		if (BlockV[BlockIdV[BlockN]][0].Key <= ValRecId) { LBlockN = BlockN; } else { RBlockN = BlockN - 1; }
+	}
+	return LBlockN;
+}
+
+void TRangeIndex::AddKey(const double& Val, const uint64& RecId, const int& Fq) {
+	const TFltUInt64Pr ValRecId(Val, RecId);
+	// first element gets a new block
+	if (BlockIdV.Empty()) { BlockIdV.Add(NewBlock()); }
+	// insert into the block, or increase frequency when already there
+	const int BlockN = GetBlockN(ValRecId);
+	const int BlockId = BlockIdV[BlockN];
+	int InsValN; const int ValN = BlockV[BlockId].SearchBin(TValRecFq(ValRecId), InsValN);
+	if (ValN != -1) { BlockV[BlockId][ValN].Dat += Fq; return; }
+	BlockV[BlockId].Ins(InsValN, TValRecFq(ValRecId, Fq));
+	// split the block when too big
+	if (BlockV[BlockId].Len() > MxBlockLen) {
+		const int NewBlockId = NewBlock();
+		TValRecFqV& Block = BlockV[BlockId];
+		// when appending to the end (e.g. time) only start a new block, otherwise split in half
+		const bool AppendP = (BlockN == BlockIdV.Len() - 1) && (InsValN == Block.Len() - 1);
+		const int SplitValN = AppendP ? Block.Len() - 1 : Block.Len() / 2;
+		Block.GetSubValV(SplitValN, Block.Len() - 1, BlockV[NewBlockId]);
+		Block.Del(SplitValN, Block.Len() - 1);
+		BlockIdV.Ins(BlockN + 1, NewBlockId);
+	}
+}
+
+void TRangeIndex::DelKey(const double& Val, const uint64& RecId, const int& Fq) {
+	if (BlockIdV.Empty()) { return; }
+	const TFltUInt64Pr ValRecId(Val, RecId);
+	const int BlockN = GetBlockN(ValRecId);
+	const int BlockId = BlockIdV[BlockN];
+	const int ValN = BlockV[BlockId].SearchBin(TValRecFq(ValRecId));
+	if (ValN == -1) { return; }
+	// keep the pair while other occurrences remain, same as gix
+	BlockV[BlockId][ValN].Dat -= Fq;
+	if (BlockV[BlockId][ValN].Dat > 0) { return; }
+	BlockV[BlockId].Del(ValN);
+	// forget the block when empty
+	if (BlockV[BlockId].Empty()) {
+		BlockV[BlockId].Clr();
+		BlockIdV.Del(BlockN);
+		FreeBlockIdV.Add(BlockId);
+	}
+}
+
+void TRangeIndex::Merge(const PRangeIndex& RangeIndex) {
+	for (int BlockN = 0; BlockN < RangeIndex->BlockIdV.Len(); BlockN++) {
+		const TValRecFqV& Block = RangeIndex->BlockV[RangeIndex->BlockIdV[BlockN]];
+		for (int ValN = 0; ValN < Block.Len(); ValN++) {
+			AddKey(Block[ValN].Key.Val1, Block[ValN].Key.Val2, Block[ValN].Dat);
+		}
+	}
+}
+
+void TRangeIndex::SearchRange(const double& MnVal, const double& MxVal, TUInt64IntKdV& RecIdFqV) const {
+	RecIdFqV.Clr();
+	if (BlockIdV.Empty()) { return; }
+	// position right after all elements with value MnVal
+	const TFltUInt64Pr StartValRecId(MnVal, TUInt64::Mx);
+	int BlockN = GetBlockN(StartValRecId);
+	int ValN; BlockV[BlockIdV[BlockN]].SearchBin(TValRecFq(StartValRecId), ValN);
+	// scan until we reach MxVal
+	for (; BlockN < BlockIdV.Len(); BlockN++, ValN = 0) {
+		const TValRecFqV& Block = BlockV[BlockIdV[BlockN]];
+		for (; ValN < Block.Len(); ValN++) {
+			const TFltUInt64Pr& ValRecId = Block[ValN].Key;
+			if (ValRecId.Val1 >= MxVal) { return; }
+			if (ValRecId.Val1 > MnVal) { RecIdFqV.Add(TUInt64IntKd(ValRecId.Val2, Block[ValN].Dat)); }
+		}
+	}
+}
+
 ///////////////////////////////
 // QMiner-Index
 void TIndex::TQmGixDefMerger::Union(
@@ -3348,14 +3850,17 @@ void TIndex::TQmGixDefMerger::Union(
 void TIndex::TQmGixDefMerger::Intrs(
 		TQmGixItemV& MainV, const TQmGixItemV& JoinV) const {
 
-    TQmGixItemV ResV; int ValN1 = 0; int ValN2 = 0;
-    while ((ValN1 < MainV.Len()) && (ValN2 < JoinV.Len())) {
-        const TQmGixItem& Val1 = MainV.GetVal(ValN1);
-        const TQmGixItem& Val2 = JoinV.GetVal(ValN2);
-        if (Val1 < Val2) { ValN1++; }
-        else if (Val1 > Val2) { ValN2++; }
-		else { ResV.Add(TQmGixItem(Val1.Key, Val1.Dat + Val2.Dat)); ValN1++; ValN2++; }
-    }
+	// walk the shorter vector and gallop through the longer one
+	const TQmGixItemV& ShortV = (MainV.Len() <= JoinV.Len()) ? MainV : JoinV;
+	const TQmGixItemV& LongV = (MainV.Len() <= JoinV.Len()) ? JoinV : MainV;
+    TQmGixItemV ResV(ShortV.Len(), 0); int LongValN = 0;
+	for (int ShortValN = 0; ShortValN < ShortV.Len(); ShortValN++) {
+		const TQmGixItem& Val1 = ShortV[ShortValN];
+		LongValN = TGixGallop::GetNextItemN(LongV, Val1, LongValN);
+		if (LongValN == LongV.Len()) { break; }
+		const TQmGixItem& Val2 = LongV[LongValN];
+		if (Val1 == Val2) { ResV.Add(TQmGixItem(Val1.Key, Val1.Dat + Val2.Dat)); LongValN++; }
+	}
     MainV = ResV;
 }
 
@@ -3429,19 +3934,21 @@ void TIndex::TQmGixRmDupMerger::Union(TQmGixItemV& MainV, const TQmGixItemV& Joi
 
 void TIndex::TQmGixRmDupMerger::Intrs(TQmGixItemV& MainV, const TQmGixItemV& JoinV) const
 {
-	TQmGixItemV ResV; int ValN1 = 0; int ValN2 = 0;
-    while ((ValN1 < MainV.Len()) && (ValN2 < JoinV.Len())) {
-        const TQmGixItem& Val1 = MainV.GetVal(ValN1);
-        const TQmGixItem& Val2 = JoinV.GetVal(ValN2);
-        if (Val1 < Val2) { ValN1++; }
-        else if (Val1 > Val2) { ValN2++; }
-		else 
-		{ 
+	// walk the shorter vector and gallop through the longer one
+	const TQmGixItemV& ShortV = (MainV.Len() <= JoinV.Len()) ? MainV : JoinV;
+	const TQmGixItemV& LongV = (MainV.Len() <= JoinV.Len()) ? JoinV : MainV;
+    TQmGixItemV ResV(ShortV.Len(), 0); int LongValN = 0;
+	for (int ShortValN = 0; ShortValN < ShortV.Len(); ShortValN++) {
+		const TQmGixItem& Val1 = ShortV[ShortValN];
+		LongValN = TGixGallop::GetNextItemN(LongV, Val1, LongValN);
+		if (LongValN == LongV.Len()) { break; }
+		const TQmGixItem& Val2 = LongV[LongValN];
+		if (Val1 == Val2) { 
 			int fq1 = TInt::GetMn(1, Val1.Dat);
 			int fq2 = TInt::GetMn(1, Val2.Dat);
-			ResV.Add(TQmGixItem(Val1.Key, fq1 + fq2)); ValN1++; ValN2++; 
+			ResV.Add(TQmGixItem(Val1.Key, fq1 + fq2)); LongValN++;
 		}
-    }
+	}
     MainV = ResV;
 }
 
@@ -3473,8 +3980,42 @@ TStr TIndex::TQmGixKeyStr::GetKeyNm(const TQmGixKey& Key) const {
 	return KeyChA;
 }
 
+bool TIndex::IsRangeKey(const int& KeyId) const {
+	if (!RangeIndexP) { return false; }
+	const TIndexKey& Key = IndexVoc->GetKey(KeyId);
+	return Key.IsValue() && Key.IsSortByFlt();
+}
+
+bool TIndex::IsRangeItem(const TQueryItem& QueryItem) const {
+	return QueryItem.IsLeafGix() && (QueryItem.IsGreater() || QueryItem.IsLess()) &&
+		QueryItem.IsWordIds() && IsRangeKey(QueryItem.GetKeyId());
+}
+
+double TIndex::GetRangeVal(const int& KeyId, const uint64& WordId) const {
+	return IndexVoc->GetWordStr(KeyId, WordId).GetFlt();
+}
+
+TIndex::PQmGixExpItem TIndex::GetRangeExpItem(const int& KeyId, 
+		const double& MnVal, const double& MxVal) const {
+
+	TQmGixItemV ItemV;
+	if (RangeIndexH.IsKey(KeyId)) {
+		RangeIndexH.GetDat(KeyId)->SearchRange(MnVal, MxVal, ItemV);
+		// range is ordered by value, items must be sorted by record id,
+		// frequencies of records with several values in range are summed
+		DefMerger->Merge(ItemV);
+	}
+	return TQmGixExpItem::NewItemV(ItemV);
+}
+
 TIndex::PQmGixExpItem TIndex::ToExpItem(const TQueryItem& QueryItem) const {
-	if (QueryItem.IsLeafGix()) {
+	if (IsRangeItem(QueryItem)) {
+		// > or <, answered by a single scan of the range index
+		const int KeyId = QueryItem.GetKeyId();
+		const double Val = GetRangeVal(KeyId, QueryItem.GetWordId());
+		return QueryItem.IsGreater() ? GetRangeExpItem(KeyId, Val, TFlt::PInf) : 
+			GetRangeExpItem(KeyId, TFlt::NInf, Val);
+	} else if (QueryItem.IsLeafGix()) {
 		// we have a leaf, make it into expresion item
 		if (QueryItem.IsEqual()) {
 			// ==
@@ -3507,10 +4048,28 @@ TIndex::PQmGixExpItem TIndex::ToExpItem(const TQueryItem& QueryItem) const {
 	} else if (QueryItem.IsAnd()) {
 		// we have a vector of AND items
 		TVec<PQmGixExpItem> ExpItemV(QueryItem.GetItems(), 0);
+		// range items over the same key are merged into one scan (between)
+		THash<TInt, TFltPr> KeyRangeH;
 		for (int ItemN = 0; ItemN < QueryItem.GetItems(); ItemN++) {
-			ExpItemV.Add(ToExpItem(QueryItem.GetItem(ItemN)));
+			const TQueryItem& Item = QueryItem.GetItem(ItemN);
+			if (IsRangeItem(Item)) {
+				const int KeyId = Item.GetKeyId();
+				const double Val = GetRangeVal(KeyId, Item.GetWordId());
+				if (!KeyRangeH.IsKey(KeyId)) { KeyRangeH.AddDat(KeyId, TFltPr(TFlt::NInf, TFlt::PInf)); }
+				TFltPr& Range = KeyRangeH.GetDat(KeyId);
+				if (Item.IsGreater()) { Range.Val1 = TFlt::GetMx(Range.Val1, Val); } 
+				else { Range.Val2 = TFlt::GetMn(Range.Val2, Val); }
+			} else {
+				ExpItemV.Add(ToExpItem(Item));
+			}
 		}
-		return TQmGixExpItem::NewAndV(ExpItemV);
+		int KeyRangeId = KeyRangeH.FFirstKeyId();
+		while (KeyRangeH.FNextKeyId(KeyRangeId)) {
+			const TFltPr& Range = KeyRangeH[KeyRangeId];
+			ExpItemV.Add(GetRangeExpItem(KeyRangeH.GetKey(KeyRangeId), Range.Val1, Range.Val2));
+		}
+		// order by size, so we start with the rarest
+		return TQmGixExpItem::NewAndV(Gix, ExpItemV);
 	} else if (QueryItem.IsOr()) {
 		// we have a vector of OR items
 		TVec<PQmGixExpItem> ExpItemV(QueryItem.GetItems(), 0);
@@ -3546,38 +4105,73 @@ TIndex::TIndex(const TStr& _IndexFPath, const TFAccess& _Access,
     Access = _Access;
     // initialize invered index
 	DefMerger = TQmGixDefMerger::New();
-    Gix = TQmGix::New("Index", IndexFPath, Access, CacheSize, DefMerger);
+    // keys are pairs of numbers, so read-only index can map them from disk
+    Gix = TQmGix::New("Index", IndexFPath, Access, CacheSize, DefMerger, true);
 	// initialize location index
 	TStr SphereFNm = IndexFPath + "Index.Geo";
 	if (TFile::Exists(SphereFNm) && Access != faCreate) {
 		TFIn SphereFIn(SphereFNm); GeoIndexH.Load(SphereFIn); 
 	}
+	// initialize range index
+	TStr RangeFNm = IndexFPath + "Index.Range";
+	if (Access == faCreate) {
+		RangeIndexP = true;
+	} else if (TFile::Exists(RangeFNm)) {
+		TFIn RangeFIn(RangeFNm); RangeIndexH.Load(RangeFIn);
+		RangeIndexP = true;
+	} else {
+		RangeIndexP = false;
+	}
     // initialize vocabularies
     IndexVoc = _IndexVoc;
 }
 
 TIndex::~TIndex() {
-	if (!IsReadOnly()) {
+	if (!IsReadOnly() && CheckpointP) {
+		TEnv::Logger->OnStatus("Closing index, saved by last checkpoint");
+		Gix.Clr();
+	} else if (!IsReadOnly()) {
 		TEnv::Logger->OnStatus("Saving and closing inverted index");
 		Gix.Clr();
 		TEnv::Logger->OnStatus("Saving and closing location index");
 		TFOut SphereFOut(IndexFPath + "Index.Geo"); GeoIndexH.Save(SphereFOut);
+		if (RangeIndexP) {
+			TEnv::Logger->OnStatus("Saving and closing range index");
+			TFOut RangeFOut(IndexFPath + "Index.Range"); RangeIndexH.Save(RangeFOut);
+		}
 		TEnv::Logger->OnStatus("Index closed");
 	} else {
 		TEnv::Logger->OnStatus("Index opened in read-only mode, no saving needed");
 	}
 }
 
+void TIndex::Checkpoint(TFCommit& Commit) {
+	QmAssertR(!IsReadOnly(), "Checkpoint of read-only index");
+	TWriteLock WriteLock(*this);
+	Gix->Checkpoint(Commit);
+	// location and range indices are saved whole, only when changed
+	if (!CheckpointP || GeoChangedP) {
+		TFOut SphereFOut(Commit.AddFNm(IndexFPath + "Index.Geo")); GeoIndexH.Save(SphereFOut);
+	}
+	if (RangeIndexP && (!CheckpointP || RangeChangedP)) {
+		TFOut RangeFOut(Commit.AddFNm(IndexFPath + "Index.Range")); RangeIndexH.Save(RangeFOut);
+	}
+	CheckpointP = true;
+}
+
 void TIndex::Index(const int& KeyId, const uint64& WordId, const uint64& RecId) {
-    Index(KeyId, WordId, RecId, 1);
+	TWriteLock WriteLock(*this);
+    IndexItem(KeyId, WordId, RecId, 1);
 }
 
 void TIndex::Index(const int& KeyId, const TStr& WordStr, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
     const uint64 WordId = IndexVoc->AddWordStr(KeyId, WordStr);
-    Index(KeyId, WordId, RecId, 1);
+    IndexItem(KeyId, WordId, RecId, 1);
 }
 
 void TIndex::Index(const int& KeyId, const TStrV& WordStrV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// load word-counts
 	TUInt64H WordIdH;
 	for (int WordN = 0; WordN < WordStrV.Len(); WordN++) {
@@ -3589,17 +4183,18 @@ void TIndex::Index(const int& KeyId, const TStrV& WordStrV, const uint64& RecId)
     while (WordIdH.FNextKeyId(WordKeyId)) {
         const uint64 WordId = WordIdH.GetKey(WordKeyId);
 		const int WordFq = WordIdH[WordKeyId];
-        Index(KeyId, WordId, RecId, WordFq);
+        IndexItem(KeyId, WordId, RecId, WordFq);
     }
 }
 
 void TIndex::Index(const int& KeyId, const TStrIntPrV& WordStrFqV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
     TIntH WordIdH;
 	for (int WordN = 0; WordN < WordStrFqV.Len(); WordN++) {
 		const TStr WordStr = WordStrFqV[WordN].Val1; //.GetLc();
         const uint64 WordId = IndexVoc->AddWordStr(KeyId, WordStr);
 		const int WordFq = WordStrFqV[WordN].Val2;
-        Index(KeyId, WordId, RecId, WordFq);	
+        IndexItem(KeyId, WordId, RecId, WordFq);	
 	}
 }
 
@@ -3622,17 +4217,19 @@ void TIndex::Index(const uint& StoreId, const TStr& KeyNm,
 }
 
 void TIndex::Index(const uint& StoreId, const TStrPrV& KeyWordV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	for (int KeyWordN = 0; KeyWordN < KeyWordV.Len(); KeyWordN++) {
 		const TStrPr& KeyWord = KeyWordV[KeyWordN];
 		// get key and word id
 		const int KeyId = IndexVoc->GetKeyId(StoreId, KeyWord.Val1);
 		const uint64 WordId = IndexVoc->AddWordStr(KeyId, KeyWord.Val2);
 		// index the record
-		Index(KeyId, WordId, RecId, 1);
+		IndexItem(KeyId, WordId, RecId, 1);
 	}
 }
 
 void TIndex::IndexText(const int& KeyId, const TStr& TextStr, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// tokenize string
 	TUInt64V WordIdV; IndexVoc->AddWordIdV(KeyId, TextStr, WordIdV);
 	// aggregate by word
@@ -3643,7 +4240,7 @@ void TIndex::IndexText(const int& KeyId, const TStr& TextStr, const uint64& RecI
 	// index words
 	int WordKeyId = WordIdFqH.FFirstKeyId();
 	while (WordIdFqH.FNextKeyId(WordKeyId)) {
-		Index(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
+		IndexItem(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
 	}
 }
 
@@ -3654,6 +4251,7 @@ void TIndex::IndexText(const uint& StoreId, const TStr& KeyNm,
 }
 
 void TIndex::IndexText(const int& KeyId, const TStrV& TextStrV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// tokenize string
 	TUInt64V WordIdV; IndexVoc->AddWordIdV(KeyId, TextStrV, WordIdV);
 	// aggregate by word
@@ -3664,7 +4262,7 @@ void TIndex::IndexText(const int& KeyId, const TStrV& TextStrV, const uint64& Re
 	// index words
 	int WordKeyId = WordIdFqH.FFirstKeyId();
 	while (WordIdFqH.FNextKeyId(WordKeyId)) {
-		Index(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
+		IndexItem(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
 	}
 }
 
@@ -3687,20 +4285,33 @@ void TIndex::IndexJoin(const TWPt<TStore>& Store, const TStr& JoinNm,
 }
 
 void TIndex::Index(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq) {
+	TWriteLock WriteLock(*this);
+	IndexItem(KeyId, WordId, RecId, RecFq);
+}
+
+void TIndex::IndexItem(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq) {
 	// -1 should never come to here 
 	Assert(KeyId != -1);
 	// we shouldn't modify read-only index
 	QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
 	// index
     Gix->AddItem(TKeyWord(KeyId, WordId), TQmGixItem(RecId, RecFq));
+	// keep range index up to date for numeric keys
+	if (IsRangeKey(KeyId)) {
+		if (!RangeIndexH.IsKey(KeyId)) { RangeIndexH.AddDat(KeyId, TRangeIndex::New()); }
+		RangeIndexH.GetDat(KeyId)->AddKey(GetRangeVal(KeyId, WordId), RecId, RecFq);
+		RangeChangedP = true;
+	}
 }
 
 void TIndex::Delete(const int& KeyId, const TStr& WordStr, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	const uint64 WordId = IndexVoc->AddWordStr(KeyId, WordStr);
-	Delete(KeyId, WordId, RecId, 1);
+	DeleteItem(KeyId, WordId, RecId, 1);
 }
 
 void TIndex::Delete(const int& KeyId, const TStrV& WordStrV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// load word-counts
 	TUInt64H WordIdH;
 	for (int WordN = 0; WordN < WordStrV.Len(); WordN++) {
@@ -3712,33 +4323,37 @@ void TIndex::Delete(const int& KeyId, const TStrV& WordStrV, const uint64& RecId
     while (WordIdH.FNextKeyId(WordKeyId)) {
         const uint64 WordId = WordIdH.GetKey(WordKeyId);
 		const int WordFq = WordIdH[WordKeyId];
-        Delete(KeyId, WordId, RecId, WordFq);
+        DeleteItem(KeyId, WordId, RecId, WordFq);
     }
 }
 
 void TIndex::Delete(const uint& StoreId, const TStr& KeyNm, const TStr& WordStr, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	const int KeyId = IndexVoc->GetKeyId(StoreId, KeyNm);
 	const uint64 WordId = IndexVoc->AddWordStr(KeyId, WordStr);
-	Delete(KeyId, WordId, RecId, 1);
+	DeleteItem(KeyId, WordId, RecId, 1);
 }
 
 void TIndex::Delete(const uint& StoreId, const TStr& KeyNm, const uint64& WordId, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	const int KeyId = IndexVoc->GetKeyId(StoreId, KeyNm);
-	Delete(KeyId, WordId, RecId, 1);
+	DeleteItem(KeyId, WordId, RecId, 1);
 }
 
 void TIndex::Delete(const uint& StoreId, const TStrPrV& KeyWordV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	for (int KeyWordN = 0; KeyWordN < KeyWordV.Len(); KeyWordN++) {
 		const TStrPr& KeyWord = KeyWordV[KeyWordN];
 		// get key and word id
 		const int KeyId = IndexVoc->GetKeyId(StoreId, KeyWord.Val1);
 		const uint64 WordId = IndexVoc->AddWordStr(KeyId, KeyWord.Val2);
 		// index the record
-		Delete(KeyId, WordId, RecId, 1);
+		DeleteItem(KeyId, WordId, RecId, 1);
 	}
 }
 
 void TIndex::DeleteText(const int& KeyId, const TStr& TextStr, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// tokenize string
 	TUInt64V WordIdV; IndexVoc->AddWordIdV(KeyId, TextStr, WordIdV);
 	// aggregate by word
@@ -3749,7 +4364,7 @@ void TIndex::DeleteText(const int& KeyId, const TStr& TextStr, const uint64& Rec
 	// index words
 	int WordKeyId = WordIdFqH.FFirstKeyId();
 	while (WordIdFqH.FNextKeyId(WordKeyId)) {
-		Delete(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
+		DeleteItem(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
 	}
 }
 
@@ -3760,6 +4375,7 @@ void TIndex::DeleteText(const uint& StoreId, const TStr& KeyNm,
 }
 
 void TIndex::DeleteText(const int& KeyId, const TStrV& TextStrV, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// tokenize string
 	TUInt64V WordIdV; IndexVoc->AddWordIdV(KeyId, TextStrV, WordIdV);
 	// aggregate by word
@@ -3770,7 +4386,7 @@ void TIndex::DeleteText(const int& KeyId, const TStrV& TextStrV, const uint64& R
 	// index words
 	int WordKeyId = WordIdFqH.FFirstKeyId();
 	while (WordIdFqH.FNextKeyId(WordKeyId)) {
-		Delete(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
+		DeleteItem(KeyId, WordIdFqH.GetKey(WordKeyId), RecId, WordIdFqH[WordKeyId]);
 	}
 }
 
@@ -3793,12 +4409,22 @@ void TIndex::DeleteJoin(const TWPt<TStore>& Store, const TStr& JoinNm,
 }
 
 void TIndex::Delete(const int& KeyId, const uint64& WordId,  const uint64& RecId, const int& RecFq) {
+	TWriteLock WriteLock(*this);
+	DeleteItem(KeyId, WordId, RecId, RecFq);
+}
+
+void TIndex::DeleteItem(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq) {
 	// -1 should never come to here 
 	Assert(KeyId != -1);
 	// we shouldn't modify read-only index
 	QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
 	// delete from index (add item with negative count, merger will delete item if necessary)
 	Gix->AddItem(TKeyWord(KeyId, WordId), TQmGixItem(RecId, -RecFq));
+	// keep range index up to date for numeric keys
+	if (IsRangeKey(KeyId) && RangeIndexH.IsKey(KeyId)) {
+		RangeIndexH.GetDat(KeyId)->DelKey(GetRangeVal(KeyId, WordId), RecId, RecFq);
+		RangeChangedP = true;
+	}
 }
 
 void TIndex::Index(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc, const uint64& RecId) {
@@ -3806,12 +4432,14 @@ void TIndex::Index(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc, co
 }
 
 void TIndex::Index(const int& KeyId, const TFltPr& Loc, const uint64& RecId) {
+	TWriteLock WriteLock(*this);
 	// we shouldn't modify read-only index
 	QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
 	// if new key, create sphere first
 	if (!GeoIndexH.IsKey(KeyId)) { GeoIndexH.AddDat(KeyId, TGeoIndex::New()); }
 	// index new location
 	GeoIndexH.GetDat(KeyId)->AddKey(Loc, RecId);
+	GeoChangedP = true;
 }
 
 void TIndex::Delete(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc, const uint64& RecId) {
@@ -3819,10 +4447,11 @@ void TIndex::Delete(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc, c
 }
 
 void TIndex::Delete(const int& KeyId, const TFltPr& Loc, const uint64& RecId) { 
+	TWriteLock WriteLock(*this);
 	// we shouldn't modify read-only index
 	QmAssertR(!IsReadOnly(), "Cannot edit read-only index!");
 	// delete only if index exist 
-	if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->DelKey(Loc, RecId); }
+	if (GeoIndexH.IsKey(KeyId)) { GeoIndexH.GetDat(KeyId)->DelKey(Loc, RecId); GeoChangedP = true; }
 }
 
 bool TIndex::LocEquals(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc1, const TFltPr& Loc2) const {
@@ -3830,25 +4459,45 @@ bool TIndex::LocEquals(const uint& StoreId, const TStr& KeyNm, const TFltPr& Loc
 }
 
 bool TIndex::LocEquals(const int& KeyId, const TFltPr& Loc1, const TFltPr& Loc2) const {
+	TReadLock ReadLock(*this);
 	return GeoIndexH.IsKey(KeyId) ? GeoIndexH.GetDat(KeyId)->LocEquals(Loc1, Loc2) : false;	
 }
 
 void TIndex::MergeIndex(const TWPt<TIndex>& TmpIndex) {
+	TWriteLock WriteLock(*this);
     Gix->MergeIndex(TmpIndex->Gix);
+	GeoChangedP = true; RangeChangedP = true;
+	// merge location indices
+	int GeoKeyId = TmpIndex->GeoIndexH.FFirstKeyId();
+	while (TmpIndex->GeoIndexH.FNextKeyId(GeoKeyId)) {
+		const int GeoIndexKeyId = TmpIndex->GeoIndexH.GetKey(GeoKeyId);
+		if (!GeoIndexH.IsKey(GeoIndexKeyId)) { GeoIndexH.AddDat(GeoIndexKeyId, TGeoIndex::New()); }
+		GeoIndexH.GetDat(GeoIndexKeyId)->Merge(TmpIndex->GeoIndexH[GeoKeyId]);
+	}
+	// merge range indices, when we maintain them
+	if (!RangeIndexP) { return; }
+	int KeyId = TmpIndex->RangeIndexH.FFirstKeyId();
+	while (TmpIndex->RangeIndexH.FNextKeyId(KeyId)) {
+		const int RangeKeyId = TmpIndex->RangeIndexH.GetKey(KeyId);
+		if (!RangeIndexH.IsKey(RangeKeyId)) { RangeIndexH.AddDat(RangeKeyId, TRangeIndex::New()); }
+		RangeIndexH.GetDat(RangeKeyId)->Merge(TmpIndex->RangeIndexH[KeyId]);
+	}
 }
 
 void TIndex::SearchAnd(const TIntUInt64PrV& KeyWordV, TUInt64IntKdV& StoreRecIdFqV) const {
+	TReadLock ReadLock(*this);
     // prepare the query
 	TVec<PQmGixExpItem> ExpItemV(KeyWordV.Len(), 0);
 	for (int ItemN = 0; ItemN < KeyWordV.Len(); ItemN++) {
 		ExpItemV.Add(TQmGixExpItem::NewItem(KeyWordV[ItemN]));
 	}
-	PQmGixExpItem ExpItem =TQmGixExpItem::NewAndV(ExpItemV);	
+	PQmGixExpItem ExpItem =TQmGixExpItem::NewAndV(Gix, ExpItemV);	
     // execute the query and filter the results to desired item type
     DoQuery(ExpItem, DefMerger, StoreRecIdFqV);
 }
 
 void TIndex::SearchOr(const TIntUInt64PrV& KeyWordV, TUInt64IntKdV& StoreRecIdFqV) const {
+	TReadLock ReadLock(*this);
     // prepare the query
 	TVec<PQmGixExpItem> ExpItemV(KeyWordV.Len(), 0);
 	for (int ItemN = 0; ItemN < KeyWordV.Len(); ItemN++) {
@@ -3861,6 +4510,7 @@ void TIndex::SearchOr(const TIntUInt64PrV& KeyWordV, TUInt64IntKdV& StoreRecIdFq
 
 TPair<TBool, PRecSet> TIndex::Search(const TWPt<TBase>& Base,
 		const TQueryItem& QueryItem, const PQmGixMerger& Merger) const {
+	TReadLock ReadLock(*this);
 
 	// get query result store
 	TWPt<TStore> Store = QueryItem.GetStore(Base);
@@ -3880,6 +4530,7 @@ TPair<TBool, PRecSet> TIndex::Search(const TWPt<TBase>& Base,
 
 PRecSet TIndex::SearchRange(const TWPt<TBase>& Base, const int& KeyId, 
         const TFltPr& Loc, const double& Radius, const int& Limit) const {
+	TReadLock ReadLock(*this);
 
 	TUInt64V RecIdV;
 	const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
@@ -3889,6 +4540,7 @@ PRecSet TIndex::SearchRange(const TWPt<TBase>& Base, const int& KeyId,
 
 PRecSet TIndex::SearchNn(const TWPt<TBase>& Base, const int& KeyId,
         const TFltPr& Loc, const int& Limit) const {
+	TReadLock ReadLock(*this);
     
 	TUInt64V RecIdV;
 	const uint StoreId = IndexVoc->GetKey(KeyId).GetStoreId();
@@ -3897,11 +4549,11 @@ PRecSet TIndex::SearchNn(const TWPt<TBase>& Base, const int& KeyId,
 }
 
 void TIndex::GetJoinRecIdFqV(const int& JoinKeyId, const uint64& RecId, TUInt64IntKdV& JoinRecIdFqV) const {
+	TReadLock ReadLock(*this);
 	TKeyWord KeyWord(JoinKeyId, RecId);
-	if (!Gix->IsKey(KeyWord)) { return; }
-	PQmGixItemSet res = Gix->GetItemSet(KeyWord); res->Def();
-	for (int i=0; i<res->GetItems(); i++) {
-		JoinRecIdFqV.Add(res->GetItem(i));
+	TQmGixItemV JoinItemV;
+	if (Gix->GetItemV(KeyWord, JoinItemV)) {
+		JoinRecIdFqV.AddV(JoinItemV);
 	}
 }
 
@@ -3914,7 +4566,7 @@ void TIndex::SaveTxt(const TWPt<TBase>& Base, const TStr& FNm) {
 void TTempIndex::NewIndex(const PIndexVoc& IndexVoc) {
     // prepare a temporary index path
     TUInt64 NowTmMSec = TTm::GetMSecsFromTm(TTm::GetCurUniTm());
-    TStr TempIndexFPath = TempFPath + NowTmMSec.GetStr() + "/";
+    TStr TempIndexFPath = TempFPath + NowTmMSec.GetStr() + "_" + TInt::GetStr(TempIndexFPathQ.Len()) + "/";
     EAssertR(TDir::GenDir(TempIndexFPath), "Unable to create directory '" + TempIndexFPath + "'");
     TempIndexFPathQ.Push(TempIndexFPath);
 	// prepare new temporary index
@@ -4004,17 +4656,21 @@ void TStreamAggr::Init() {
     Register<TStreamAggrs::THierchCtmc>();
 }
 
+// aggregate state is not in the write-ahead log (see TBase::InitWal)
 TStreamAggr::TStreamAggr(const TWPt<TBase>& _Base, const TStr& _AggrNm): 
     Base(_Base), AggrNm(_AggrNm), Guid(TGuid::GenGuid()) { 
-        TValidNm::AssertValidNm(AggrNm); }
+        TValidNm::AssertValidNm(AggrNm);
+        QmAssertR(Base.Empty() || !Base->IsWal(), "Stream aggregates not supported with write-ahead log"); }
 
 TStreamAggr::TStreamAggr(const TWPt<TBase>& _Base, const PJsonVal& ParamVal):
     Base(_Base), AggrNm(ParamVal->GetObjStr("name")), Guid(TGuid::GenGuid()) { 
-        TValidNm::AssertValidNm(AggrNm); }
+        TValidNm::AssertValidNm(AggrNm);
+        QmAssertR(Base.Empty() || !Base->IsWal(), "Stream aggregates not supported with write-ahead log"); }
     
 // TODO: Possible bug - SABase not used here ... Check!
 TStreamAggr::TStreamAggr(const TWPt<TBase>& _Base, const TWPt<TStreamAggrBase> _SABase, TSIn& SIn) :
-    Base(_Base), AggrNm(SIn), Guid(SIn) { }
+    Base(_Base), AggrNm(SIn), Guid(SIn) {
+        QmAssertR(Base.Empty() || !Base->IsWal(), "Stream aggregates not supported with write-ahead log"); }
 	
 PStreamAggr TStreamAggr::New(const TWPt<TBase>& Base, 
         const TStr& TypeNm, const PJsonVal& ParamVal) {
@@ -4022,6 +4678,12 @@ PStreamAggr TStreamAggr::New(const TWPt<TBase>& Base,
     return NewRouter.Fun(TypeNm)(Base, ParamVal);
 }
 
+void TStreamAggr::OnAddRecBatch(const PRecSet& RecSet) {
+    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+        OnAddRec(RecSet->GetRec(RecN));
+    }
+}
+
 PStreamAggr TStreamAggr::Load(const TWPt<TBase>& Base, const TWPt<TStreamAggrBase> SABase, TSIn& SIn) {
 	TStr TypeNm(SIn); return LoadRouter.Fun(TypeNm)(Base, SABase, SIn);
 }
@@ -4077,7 +4739,37 @@ const PStreamAggr& TStreamAggrBase::GetStreamAggr(const int& StreamAggrId) const
 }
 
 void TStreamAggrBase::AddStreamAggr(const PStreamAggr& StreamAggr) { 	
-	StreamAggrH.AddDat(StreamAggr->GetAggrNm(), StreamAggr); 
+	// aggregate with the same name is replaced, unless other aggregates read from
+	// it: they keep pointers to the old one and their steps follow its step
+	const TStr& AggrNm = StreamAggr->GetAggrNm();
+	int KeyId = StreamAggrH.GetKeyId(AggrNm);
+	if (KeyId != -1) {
+		int OutKeyId = StreamAggrH.FFirstKeyId();
+		while (StreamAggrH.FNextKeyId(OutKeyId)) {
+			TStrV InAggrNmV; StreamAggrH[OutKeyId]->GetInAggrNmV(InAggrNmV);
+			QmAssertR(!InAggrNmV.IsIn(AggrNm), "Stream aggregate " + AggrNm +
+				" cannot be replaced, it is input to " + StreamAggrH.GetKey(OutKeyId));
+		}
+		StepV[AggrStepNV[KeyId]].DelIfIn(KeyId);
+	}
+	KeyId = StreamAggrH.AddKey(AggrNm);
+	StreamAggrH[KeyId] = StreamAggr;
+	// aggregate goes to the step after the steps of its inputs, aggregates
+	// which are not thread safe get a step of their own and act as a barrier
+	int StepN = BarrierStepN;
+	if (StreamAggr->IsThreadSafe()) {
+		TStrV InAggrNmV; StreamAggr->GetInAggrNmV(InAggrNmV);
+		for (int InAggrN = 0; InAggrN < InAggrNmV.Len(); InAggrN++) {
+			const int InKeyId = StreamAggrH.GetKeyId(InAggrNmV[InAggrN]);
+			if (InKeyId != -1) { StepN = TInt::GetMx(StepN, AggrStepNV[InKeyId] + 1); }
+		}
+	} else {
+		StepN = StepV.Len(); BarrierStepN = StepN + 1;
+	}
+	if (StepN == StepV.Len()) { StepV.Add(); }
+	StepV[StepN].Add(KeyId);
+	while (AggrStepNV.Len() <= KeyId) { AggrStepNV.Add(-1); }
+	AggrStepNV[KeyId] = StepN;
 }
 
 int TStreamAggrBase::GetFirstStreamAggrId() const {
@@ -4095,6 +4787,45 @@ void TStreamAggrBase::OnAddRec(const TRec& Rec) {
 	}
 }
 
+void TStreamAggrBase::OnAddRecBatch(const PRecSet& RecSet) {
+	// aggregates can process the batch one after another when each of them
+	// supports it and reads its inputs only from this base, otherwise they
+	// would see the state of their inputs after the last record
+	bool BatchP = true;
+	int KeyId = StreamAggrH.FFirstKeyId();
+	while (BatchP && StreamAggrH.FNextKeyId(KeyId)) {
+		const PStreamAggr& StreamAggr = StreamAggrH[KeyId];
+		if (!StreamAggr->IsBatch()) { BatchP = false; break; }
+		TStrV InAggrNmV; StreamAggr->GetInAggrNmV(InAggrNmV);
+		for (int InAggrN = 0; InAggrN < InAggrNmV.Len(); InAggrN++) {
+			if (!IsStreamAggr(InAggrNmV[InAggrN])) { BatchP = false; break; }
+		}
+	}
+	if (BatchP) {
+		for (int StepN = 0; StepN < StepV.Len(); StepN++) {
+			const TIntV& KeyIdV = StepV[StepN];
+			// exceptions must not leave the parallel region
+			PExcept Except;
+			#pragma omp parallel for schedule(dynamic, 1) if(KeyIdV.Len() > 1)
+			for (int KeyN = 0; KeyN < KeyIdV.Len(); KeyN++) {
+				try {
+					StreamAggrH[KeyIdV[KeyN]]->OnAddRecBatch(RecSet);
+				} catch (PExcept& AggrExcept) {
+					#pragma omp critical
+					{
+						if (Except.Empty()) { Except = AggrExcept; }
+					}
+				}
+			}
+			if (!Except.Empty()) { throw Except; }
+		}
+	} else {
+		for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+			OnAddRec(RecSet->GetRec(RecN));
+		}
+	}
+}
+
 void TStreamAggrBase::OnUpdateRec(const TRec& Rec) {
 	int KeyId = StreamAggrH.FFirstKeyId();
 	while (StreamAggrH.FNextKeyId(KeyId)) {
@@ -4131,6 +4862,10 @@ void TStreamAggrTrigger::OnAdd(const TRec& Rec) {
 	StreamAggrBase->OnAddRec(Rec);
 }
 
+void TStreamAggrTrigger::OnAddBatch(const PRecSet& RecSet) {
+	StreamAggrBase->OnAddRecBatch(RecSet);
+}
+
 void TStreamAggrTrigger::OnUpdate(const TRec& Rec) {
 	StreamAggrBase->OnUpdateRec(Rec);
 }
@@ -4139,13 +4874,312 @@ void TStreamAggrTrigger::OnDelete(const TRec& Rec) {
 	StreamAggrBase->OnDeleteRec(Rec);
 }
 
+///////////////////////////////
+// QMiner-Write-Ahead-Log
+TWal::TWal(const TStr& FNm, const uint64& _LastOpN, const uint64& _CommitMSecs,
+        const uint64& _CheckpointLen, const uint64& _CheckpointMSecs): 
+            LastOpN(_LastOpN), SyncP(false), CommitMSecs(_CommitMSecs),
+            LastCommitMSecs(TTm::GetCurUniMSecs()), CheckpointLen(_CheckpointLen),
+            CheckpointMSecs(_CheckpointMSecs), LastCheckpointMSecs(TTm::GetCurUniMSecs()) {
+
+    FRnd = TFRnd::New(FNm, faCreate);
+}
+
+void TWal::StartOp(TMOut& OpMOut, const TWalOpType& OpType, const uint& StoreId, const uint64& OpMSecs) {
+    LastOpN++; LastOpN.Save(OpMOut);
+    TInt(OpType).Save(OpMOut); TUInt(StoreId).Save(OpMOut); TUInt64(OpMSecs).Save(OpMOut);
+}
+
+void TWal::EndOp(const TMOut& OpMOut) {
+    const int OpLen = OpMOut.Len();
+    BufMOut.Save(OpLen);
+    BufMOut.PutBf(OpMOut.GetBfAddr(), OpLen);
+    BufMOut.Save(TCs::GetCsFromBf(OpMOut.GetBfAddr(), OpLen).Get());
+    // long operations (e.g. bulk loads) write their entries as they go
+    if (BufMOut.Len() > TInt::Mega) { Flush(); }
+}
+
+void TWal::SaveField(const TWPt<TStore>& Store, const uint64& RecId, const int& FieldId, TSOut& SOut) {
+    switch (Store->GetFieldDesc(FieldId).GetFieldType()) {
+        case oftInt: TInt(Store->GetFieldInt(RecId, FieldId)).Save(SOut); break;
+        case oftIntV: { TIntV IntV; Store->GetFieldIntV(RecId, FieldId, IntV); IntV.Save(SOut); break; }
+        case oftUInt64: TUInt64(Store->GetFieldUInt64(RecId, FieldId)).Save(SOut); break;
+        case oftStr: Store->GetFieldStr(RecId, FieldId).Save(SOut); break;
+        case oftStrV: { TStrV StrV; Store->GetFieldStrV(RecId, FieldId, StrV); StrV.Save(SOut); break; }
+        case oftBool: TBool(Store->GetFieldBool(RecId, FieldId)).Save(SOut); break;
+        case oftFlt: TFlt(Store->GetFieldFlt(RecId, FieldId)).Save(SOut); break;
+        case oftFltPr: Store->GetFieldFltPr(RecId, FieldId).Save(SOut); break;
+        case oftFltV: { TFltV FltV; Store->GetFieldFltV(RecId, FieldId, FltV); FltV.Save(SOut); break; }
+        case oftTm: TUInt64(Store->GetFieldTmMSecs(RecId, FieldId)).Save(SOut); break;
+        case oftNumSpV: { TIntFltKdV SpV; Store->GetFieldNumSpV(RecId, FieldId, SpV); SpV.Save(SOut); break; }
+        case oftBowSpV: { PBowSpV SpV; Store->GetFieldBowSpV(RecId, FieldId, SpV); SpV->Save(SOut); break; }
+        default: throw TQmExcept::New("Unsupported field type for field " + Store->GetFieldNm(FieldId));
+    }
+}
+
+void TWal::LoadField(const TWPt<TStore>& Store, const uint64& RecId, const int& FieldId, TSIn& SIn) {
+    switch (Store->GetFieldDesc(FieldId).GetFieldType()) {
+        case oftInt: Store->SetFieldInt(RecId, FieldId, TInt(SIn)); break;
+        case oftIntV: Store->SetFieldIntV(RecId, FieldId, TIntV(SIn)); break;
+        case oftUInt64: Store->SetFieldUInt64(RecId, FieldId, TUInt64(SIn)); break;
+        case oftStr: Store->SetFieldStr(RecId, FieldId, TStr(SIn)); break;
+        case oftStrV: Store->SetFieldStrV(RecId, FieldId, TStrV(SIn)); break;
+        case oftBool: Store->SetFieldBool(RecId, FieldId, TBool(SIn)); break;
+        case oftFlt: Store->SetFieldFlt(RecId, FieldId, TFlt(SIn)); break;
+        case oftFltPr: Store->SetFieldFltPr(RecId, FieldId, TFltPr(SIn)); break;
+        case oftFltV: Store->SetFieldFltV(RecId, FieldId, TFltV(SIn)); break;
+        case oftTm: Store->SetFieldTmMSecs(RecId, FieldId, TUInt64(SIn)); break;
+        case oftNumSpV: Store->SetFieldNumSpV(RecId, FieldId, TIntFltKdV(SIn)); break;
+        case oftBowSpV: Store->SetFieldBowSpV(RecId, FieldId, TBowSpV::Load(SIn)); break;
+        default: throw TQmExcept::New("Unsupported field type for field " + Store->GetFieldNm(FieldId));
+    }
+}
+
+void TWal::ExecOp(const TWalOpType& OpType, const TWPt<TStore>& Store, TSIn& SIn) {
+    if (OpType == wotAddRec) {
+        Store->AddRec(TBsonObj::GetJson(SIn));
+    } else if (OpType == wotAddRecJson) {
+        TStr RecJsonStr(SIn); uint64 RecId;
+        QmAssertR(Store->TryAddRecJsonStr(RecJsonStr, RecId), "Record not added: " + RecJsonStr);
+    } else if (OpType == wotUpdateRec) {
+        TUInt64 RecId(SIn); 
+        Store->UpdateRec(RecId, TBsonObj::GetJson(SIn));
+    } else if (OpType == wotDeleteRecs) {
+        TUInt64V DelRecIdV(SIn);
+        Store->DeleteRecs(DelRecIdV, false);
+    } else if (OpType == wotAddJoin || OpType == wotDelJoin) {
+        TInt JoinId(SIn); TUInt64 RecId(SIn), JoinRecId(SIn); TInt JoinFq(SIn);
+        if (OpType == wotAddJoin) {
+            Store->AddJoin(JoinId, RecId, JoinRecId, JoinFq);
+        } else {
+            Store->DelJoin(JoinId, RecId, JoinRecId, JoinFq);
+        }
+    } else if (OpType == wotSetField) {
+        TUInt64 RecId(SIn); TInt FieldId(SIn); TBool NullP(SIn);
+        if (NullP) {
+            Store->SetFieldNull(RecId, FieldId);
+        } else {
+            LoadField(Store, RecId, FieldId, SIn);
+        }
+    } else {
+        throw TQmExcept::New("Unknown operation type " + TInt::GetStr(OpType));
+    }
+}
+
+void TWal::AddRec(const uint& StoreId, const uint64& OpMSecs, const PJsonVal& RecVal) {
+    TMOut OpMOut; StartOp(OpMOut, wotAddRec, StoreId, OpMSecs);
+    TBsonObj::Serialize(*RecVal, OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::AddRecJson(const uint& StoreId, const uint64& OpMSecs, const TStr& RecJsonStr) {
+    TMOut OpMOut; StartOp(OpMOut, wotAddRecJson, StoreId, OpMSecs);
+    RecJsonStr.Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::AddRecBulk(const uint& StoreId, const uint64& OpMSecs, const TStrV& LnV) {
+    TMOut OpMOut; StartOp(OpMOut, wotAddRecBulk, StoreId, OpMSecs);
+    LnV.Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::AddRecBulkEnd(const uint& StoreId, const uint64& OpMSecs, const int& BatchLen,
+        const int64& IndexCacheSize, const bool& TriggerP) {
+
+    TMOut OpMOut; StartOp(OpMOut, wotAddRecBulkEnd, StoreId, OpMSecs);
+    TInt(BatchLen).Save(OpMOut); OpMOut.Save(IndexCacheSize); TBool(TriggerP).Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::UpdateRec(const uint& StoreId, const uint64& OpMSecs, const uint64& RecId, const PJsonVal& RecVal) {
+    TMOut OpMOut; StartOp(OpMOut, wotUpdateRec, StoreId, OpMSecs);
+    TUInt64(RecId).Save(OpMOut); TBsonObj::Serialize(*RecVal, OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::DeleteRecs(const uint& StoreId, const uint64& OpMSecs, const TUInt64V& DelRecIdV) {
+    TMOut OpMOut; StartOp(OpMOut, wotDeleteRecs, StoreId, OpMSecs);
+    DelRecIdV.Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::AddJoin(const uint& StoreId, const uint64& OpMSecs, const int& JoinId,
+        const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
+
+    TMOut OpMOut; StartOp(OpMOut, wotAddJoin, StoreId, OpMSecs);
+    TInt(JoinId).Save(OpMOut); TUInt64(RecId).Save(OpMOut); 
+    TUInt64(JoinRecId).Save(OpMOut); TInt(JoinFq).Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::DelJoin(const uint& StoreId, const uint64& OpMSecs, const int& JoinId,
+        const uint64& RecId, const uint64 JoinRecId, const int& JoinFq) {
+
+    TMOut OpMOut; StartOp(OpMOut, wotDelJoin, StoreId, OpMSecs);
+    TInt(JoinId).Save(OpMOut); TUInt64(RecId).Save(OpMOut); 
+    TUInt64(JoinRecId).Save(OpMOut); TInt(JoinFq).Save(OpMOut);
+    EndOp(OpMOut);
+}
+
+void TWal::SetField(const TWPt<TStore>& Store, const uint64& OpMSecs, const uint64& RecId, const int& FieldId) {
+    TMOut OpMOut; StartOp(OpMOut, wotSetField, Store->GetStoreId(), OpMSecs);
+    TUInt64(RecId).Save(OpMOut); TInt(FieldId).Save(OpMOut); 
+    const bool NullP = Store->IsFieldNull(RecId, FieldId); TBool(NullP).Save(OpMOut);
+    if (!NullP) { SaveField(Store, RecId, FieldId, OpMOut); }
+    EndOp(OpMOut);
+}
+
+void TWal::Flush() {
+    if (BufMOut.Len() == 0) { return; }
+    FRnd->PutBf(BufMOut.GetBfAddr(), BufMOut.Len()); FRnd->Flush();
+    LogLen += BufMOut.Len(); BufMOut.Clr(); SyncP = true;
+}
+
+void TWal::Commit() {
+    Flush();
+    if (SyncP) { FRnd->Sync(); SyncP = false; }
+    LastCommitMSecs = TTm::GetCurUniMSecs();
+}
+
+bool TWal::IsCommitDue() const {
+    return (SyncP || BufMOut.Len() > 0) && 
+        (TTm::GetCurUniMSecs() >= LastCommitMSecs + CommitMSecs);
+}
+
+bool TWal::IsCheckpointDue() const {
+    const uint64 Len = LogLen + BufMOut.Len();
+    if (Len == 0) { return false; }
+    return (CheckpointLen > 0 && Len >= CheckpointLen) ||
+        (CheckpointMSecs > 0 && TTm::GetCurUniMSecs() >= LastCheckpointMSecs + CheckpointMSecs);
+}
+
+void TWal::Clr() {
+    // reopen truncates the file
+    const TStr FNm = FRnd->GetFNm(); FRnd.Clr();
+    FRnd = TFRnd::New(FNm, faCreate);
+    BufMOut.Clr(); LogLen = 0; SyncP = false;
+    LastCheckpointMSecs = TTm::GetCurUniMSecs();
+}
+
+bool TWal::LoadOp(TFIn& FIn, TMem& OpMem) {
+    // entry length, payload and checksum, incomplete entry was being written at crash
+    if (FIn.Eof() || FIn.Len() < (int)sizeof(int)) { return false; }
+    TInt OpLen(FIn);
+    if (OpLen <= 0 || FIn.Len() < OpLen + (int)sizeof(int)) { return false; }
+    OpMem.Gen(OpLen); FIn.GetBf(OpMem.GetBf(), OpLen);
+    TInt OpCs(FIn);
+    return TCs::GetCsFromBf(OpMem.GetBf(), OpLen).Get() == OpCs;
+}
+
+uint64 TWal::Replay(const TStr& FNm, const TWPt<TBase>& Base, const uint64& CheckpointOpN) {
+    TEnv::Logger->OnStatus("Replaying write-ahead log " + FNm);
+    // lines of bulk loads are collected in a file until the end of the load
+    const TStr BulkFNm = FNm + ".Bulk"; PSOut BulkSOut;
+    TFIn FIn(FNm); uint64 LastOpN = CheckpointOpN; int Ops = 0, Errs = 0;
+    TMem OpMem;
+    while (LoadOp(FIn, OpMem)) {
+        // header
+        TMIn OpMIn(OpMem.GetBf(), OpMem.Len(), false);
+        TUInt64 OpN(OpMIn); TInt OpType(OpMIn); TUInt StoreId(OpMIn); TUInt64 OpMSecs(OpMIn);
+        // skip operations already included in the checkpoint
+        if (OpN <= CheckpointOpN) { continue; }
+        LastOpN = OpN;
+        // execute the operation with its original time
+        Base->WalOpMSecs = OpMSecs;
+        try {
+            QmAssertR(Base->IsStoreId(StoreId), "Unknown store id " + StoreId.GetStr());
+            const TWPt<TStore> Store = Base->GetStoreByStoreId(StoreId);
+            if (OpType == wotAddRecBulk) {
+                if (BulkSOut.Empty()) { BulkSOut = TFOut::New(BulkFNm); }
+                TStrV LnV(OpMIn);
+                for (int LnN = 0; LnN < LnV.Len(); LnN++) { BulkSOut->PutStrLn(LnV[LnN]); }
+            } else if (OpType == wotAddRecBulkEnd) {
+                TInt BatchLen(OpMIn); int64 IndexCacheSize; OpMIn.Load(IndexCacheSize); TBool TriggerP(OpMIn);
+                if (BulkSOut.Empty()) { BulkSOut = TFOut::New(BulkFNm); }
+                BulkSOut.Clr();
+                Store->AddRecBulk(TFIn::New(BulkFNm), BatchLen, IndexCacheSize, TriggerP);
+                TFile::Del(BulkFNm, false);
+            } else {
+                ExecOp((TWalOpType)OpType.Val, Store, OpMIn);
+            }
+        } catch (const PExcept& Except) {
+            ErrorLog("[TWal::Replay] Error replaying operation " + OpN.GetStr() + ":");
+            ErrorLog(Except->GetMsgStr()); Errs++;
+        }
+        Base->WalOpMSecs = 0; Ops++;
+    }
+    // bulk load interrupted by crash never finished, so it is dropped
+    if (!BulkSOut.Empty()) { BulkSOut.Clr(); TFile::Del(BulkFNm, false); }
+    TEnv::Logger->OnStatusFmt("Replayed %d operations, %d failed", Ops, Errs);
+    return LastOpN;
+}
+
+uint64 TWal::GetLastOpN(const TStr& FNm) {
+    TFIn FIn(FNm); uint64 LastOpN = 0; TMem OpMem;
+    while (LoadOp(FIn, OpMem)) {
+        TMIn OpMIn(OpMem.GetBf(), OpMem.Len(), false);
+        LastOpN = TUInt64(OpMIn);
+    }
+    return LastOpN;
+}
+
+///////////////////////////////
+// QMiner-Write-Ahead-Log-Operation
+TWalOp::TWalOp(const TWPt<TBase>& _Base): Base(_Base), LogP(false), TmP(false) {
+    // outermost operation starts with checkpoint when due, but not while
+    // bulk loads keep records in temporary indices
+    if (Base->WalOpDepth == 0 && !Base->Wal.Empty() && 
+            !Base->IsTempIndex() && Base->Wal->IsCheckpointDue()) {
+        Base->Checkpoint();
+    }
+    LogP = !Base->Wal.Empty() && Base->WalLogDepth == 0;
+    if (Base->WalOpMSecs == 0) { Base->WalOpMSecs = TTm::GetCurUniMSecs(); TmP = true; }
+    Base->WalOpDepth++; Base->WalLogDepth++;
+}
+
+TWalOp::~TWalOp() {
+    Base->WalOpDepth--; Base->WalLogDepth--;
+    if (TmP) { Base->WalOpMSecs = 0; }
+    // outermost operation passes its entries to the operating system and commits when due
+    if (Base->WalOpDepth == 0 && !Base->Wal.Empty()) {
+        try {
+            if (Base->Wal->IsCommitDue()) { Base->Wal->Commit(); } else { Base->Wal->Flush(); }
+        } catch (const PExcept& Except) {
+            ErrorLog("[TWalOp] Error writing write-ahead log: " + Except->GetMsgStr());
+        }
+    }
+}
+
+TWal& TWalOp::GetWal() const { 
+    return *Base->Wal; 
+}
+
+uint64 TWalOp::GetOpMSecs() const { 
+    return Base->WalOpMSecs; 
+}
+
+TWalOp::TTriggerScope::TTriggerScope(const TWPt<TBase>& _Base): 
+    Base(_Base), LogDepth(_Base->WalLogDepth) { Base->WalLogDepth = 0; }
+
+TWalOp::TTriggerScope::~TTriggerScope() { 
+    Base->WalLogDepth = LogDepth; 
+}
+
 ///////////////////////////////
 // QMiner-Base
-TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize): InitP(false) {
+TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize): InitP(false), 
+        WalOpDepth(0), WalLogDepth(0), CheckpointP(false) {
+
 	IAssertR(TEnv::IsInit(), "QMiner environment (TQm::TEnv) is not initialized");
 	// open as create
 	FAccess = faCreate; FPath = _FPath;
 	TEnv::Logger->OnStatus("Opening in create mode");
+	// remove log and checkpoint of the previous base
+	TFile::Del(FPath + "Wal.log", false);
+	TFile::Del(FPath + "Checkpoint.commit", false);
+	TFile::Del(FPath + "Checkpoint.dat", false);
+	IndexVocDelta = TFDelta(FPath + "IndexVoc.dat"); IndexVocDelta.DelDeltas();
 	// prepare index
 	IndexVoc = TIndexVoc::New();
 	Index = TIndex::New(FPath, FAccess, IndexVoc, IndexCacheSize);
@@ -4162,7 +5196,9 @@ TBase::TBase(const TStr& _FPath, const int64& IndexCacheSize): InitP(false) {
 	TempFPathP = false;
 }
 
-TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCacheSize): InitP(false) {
+TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCacheSize): InitP(false),
+        WalOpDepth(0), WalLogDepth(0), CheckpointP(false) {
+
 	IAssertR(TEnv::IsInit(), "QMiner environment (TQm::TEnv) is not initialized");
 	// assert open type and remember location
 	FAccess = _FAccess; FPath = _FPath;
@@ -4174,9 +5210,30 @@ TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCac
 	} else if (FAccess == faRestore) {
 		TEnv::Logger->OnStatus("Opening in restore mode");
 	}
-	// load index
-	TFIn IndexVocFIn(FPath + "IndexVoc.dat");
-	IndexVoc = TIndexVoc::Load(IndexVocFIn);
+	// complete checkpoint interrupted by a crash
+	if (FAccess == faRdOnly) {
+		QmAssertR(!TFile::Exists(FPath + "Checkpoint.commit"), 
+			"Base has unfinished checkpoint, it must be opened in update mode first");
+	} else if (TFCommit::Recover(FPath + "Checkpoint.commit")) {
+		TEnv::Logger->OnStatus("Completed interrupted checkpoint");
+	}
+	// check if base is saved by checkpoints
+	if (TFile::Exists(FPath + "Checkpoint.dat")) {
+		TFIn CheckpointFIn(FPath + "Checkpoint.dat"); 
+		CheckpointOpN.Load(CheckpointFIn); CheckpointP = true;
+	}
+	// read-only base can not replay changes logged after the checkpoint
+	if (FAccess == faRdOnly && TFile::Exists(FPath + "Wal.log")) {
+		QmAssertR(TWal::GetLastOpN(FPath + "Wal.log") <= CheckpointOpN,
+			"Base has changes in write-ahead log, it must be opened in update mode first");
+	}
+	// load index, vocabulary changes after its last full save are in deltas
+	{ TFIn IndexVocFIn(FPath + "IndexVoc.dat"); IndexVoc = TIndexVoc::Load(IndexVocFIn); }
+	IndexVocDelta = TFDelta(FPath + "IndexVoc.dat");
+	for (int DeltaN = 0; DeltaN < IndexVocDelta.GetDeltas(); DeltaN++) {
+		TFIn DeltaFIn(IndexVocDelta.GetDeltaFNm(DeltaN));
+		IndexVocDelta.AddDeltaItems(IndexVoc->LoadDelta(DeltaFIn));
+	}
 	Index = TIndex::New(FPath, FAccess, IndexVoc, IndexCacheSize);
 	// add standard operators
 	AddOp(TOpLinSearch::New());
@@ -4192,15 +5249,87 @@ TBase::TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCac
 } 
 
 TBase::~TBase() {
-	if (FAccess != faRdOnly) {
+	if (FAccess != faRdOnly && CheckpointP) {
+		// final checkpoint, after which the log is no longer needed
+		try {
+			Checkpoint();
+			if (!Wal.Empty()) { Wal.Clr(); TFile::Del(FPath + "Wal.log", false); }
+		} catch (const PExcept& Except) {
+			ErrorLog("Final checkpoint failed, changes are kept in the log: " + Except->GetMsgStr());
+		}
+	} else if (FAccess != faRdOnly) {
 		TEnv::Logger->OnStatus("Saving index vocabulary ... ");
-		TFOut IndexVocFOut(FPath + "IndexVoc.dat");
-		IndexVoc->Save(IndexVocFOut);		
+		{ TFOut IndexVocFOut(FPath + "IndexVoc.dat"); IndexVoc->Save(IndexVocFOut); }
+		IndexVocDelta.DelDeltas();
 	} else {
 		TEnv::Logger->OnStatus("No saving of qminer base neccessary!");
 	}
 }
 
+void TBase::Checkpoint() {
+	QmAssertR(!IsRdOnly(), "Checkpoint of read-only base");
+	QmAssertR(WalOpDepth == 0 && !IsTempIndex(), "Checkpoint in the middle of store operation");
+	TEnv::Logger->OnStatus("Checkpoint ...");
+	// everything logged so far is included
+	if (!Wal.Empty()) { Wal->Commit(); CheckpointOpN = Wal->GetLastOpN(); }
+	// new versions of changed files, they replace old ones atomically
+	TFCommit Commit(FPath + "Checkpoint.commit");
+	// index vocabulary is saved whole when keys changed or its deltas got long
+	if (!IndexVoc->IsDelta() || IndexVocDelta.IsSnapshotDue(IndexVoc->GetAllWords())) {
+		TFOut IndexVocFOut(IndexVocDelta.AddSnapshot(Commit)); IndexVoc->Save(IndexVocFOut);
+	} else if (IndexVoc->GetDeltaWords() > 0) {
+		TFOut IndexVocFOut(IndexVocDelta.AddDelta(Commit, IndexVoc->GetDeltaWords()));
+		IndexVoc->SaveDelta(IndexVocFOut);
+	}
+	{ 
+		TFOut StoreListFOut(Commit.AddFNm(FPath + "StoreList.txt"));
+		for (int StoreN = 0; StoreN < GetStores(); StoreN++) {
+			StoreListFOut.PutStrLn(GetStoreByStoreN(StoreN)->GetStoreNm());
+		}
+	}
+	Index->Checkpoint(Commit);
+	for (int StoreN = 0; StoreN < GetStores(); StoreN++) {
+		GetStoreByStoreN(StoreN)->Checkpoint(Commit);
+	}
+	{ TFOut CheckpointFOut(Commit.AddFNm(FPath + "Checkpoint.dat")); CheckpointOpN.Save(CheckpointFOut); }
+	Commit.Commit();
+	// space released before the checkpoint can now be reused
+	IndexVoc->OnCommit(); IndexVocDelta.OnCommit();
+	Index->OnCommit();
+	for (int StoreN = 0; StoreN < GetStores(); StoreN++) {
+		GetStoreByStoreN(StoreN)->OnCommit();
+	}
+	if (!Wal.Empty()) { Wal->Clr(); }
+	CheckpointP = true;
+	TEnv::Logger->OnStatus("Checkpoint done");
+}
+
+void TBase::InitWal(const uint64& CommitMSecs, const uint64& CheckpointLen, const uint64& CheckpointMSecs) {
+	QmAssertR(!IsRdOnly(), "Write-ahead log not possible for read-only base");
+	QmAssertR(Wal.Empty(), "Write-ahead log already enabled");
+	// replay only restores stores and indices, aggregates would miss the replayed
+	// records or count them twice, and checkpoints do not save them either
+	bool StreamAggrP = !StreamAggrDefaultBase->Empty();
+	for (int StoreId = 0; StoreId < StreamAggrBaseV.Len(); StoreId++) {
+		if (!StreamAggrBaseV[StoreId].Empty() && !StreamAggrBaseV[StoreId]->Empty()) { StreamAggrP = true; }
+	}
+	QmAssertR(!StreamAggrP, "Stream aggregates not supported with write-ahead log");
+	// log starts from consistent state on disk
+	ReplayWal(); Checkpoint();
+	Wal = TWal::New(FPath + "Wal.log", CheckpointOpN, CommitMSecs, CheckpointLen, CheckpointMSecs);
+	TFile::Sync(FPath);
+}
+
+void TBase::ReplayWal() {
+	const TStr WalFNm = FPath + "Wal.log";
+	if (IsRdOnly() || !TFile::Exists(WalFNm)) { return; }
+	QmAssertR(Wal.Empty(), "Write-ahead log can not be replayed while enabled");
+	// apply changes logged after the last checkpoint and save them
+	const uint64 LastOpN = TWal::Replay(WalFNm, this, CheckpointOpN);
+	if (LastOpN > CheckpointOpN) { CheckpointOpN = LastOpN; Checkpoint(); }
+	TFile::Del(WalFNm);
+}
+
 void TBase::SaveStreamAggrBaseV(TSOut& SOut) {   
     // get number of stream aggregate bases
     int StreamAggrBases = 0;
@@ -4485,6 +5614,7 @@ const PStreamAggr& TBase::GetStreamAggr(const TStr& StreamAggrNm) const {
 }
 
 void TBase::AddStreamAggr(const uint& StoreId, const PStreamAggr& StreamAggr) {
+	QmAssertR(Wal.Empty(), "Stream aggregates not supported with write-ahead log");
 	// add new aggregate to the stream aggregate base
 	GetStreamAggrBase(StoreId)->AddStreamAggr(StreamAggr);
 }
@@ -4506,6 +5636,7 @@ void TBase::AddStreamAggr(const TStrV& StoreNmV, const PStreamAggr& StreamAggr)
 }
 
 void TBase::AddStreamAggr(const PStreamAggr& StreamAggr) {
+	QmAssertR(Wal.Empty(), "Stream aggregates not supported with write-ahead log");
 	StreamAggrDefaultBase->AddStreamAggr(StreamAggr);
 }
 
@@ -4607,7 +5738,7 @@ uint64 TBase::AddRec(const uint& StoreId, const PJsonVal& RecVal) {
 
 PRecSet TBase::Search(const PQuery& Query) {
 	// do the search
-	TIndex::PQmGixMerger Merger = Index->GetDefMerger();
+	const TIndex::PQmGixMerger& Merger = Index->GetDefMerger();
 	TPair<TBool, PRecSet> NotRecSet = Search(Query->GetQueryItem(), Merger);
 	// when empty, then query can be completly covered by index
 	if (NotRecSet.Val2.Empty()) { 
@@ -4631,11 +5762,23 @@ PRecSet TBase::Search(const TQueryItem& QueryItem) {
 }
 
 PRecSet TBase::Search(const TStr& QueryStr) {
-	return Search(TQuery::New(this, QueryStr));
+	PQuery Query;
+	{
+		// parsing looks up words in the vocabulary, which can be extended by writer
+		TIndex::TReadLock ReadLock(*Index);
+		Query = TQuery::New(this, QueryStr);
+	}
+	return Search(Query);
 }
 
 PRecSet TBase::Search(const PJsonVal& QueryVal) {
-	return Search(TQuery::New(this, QueryVal));
+	PQuery Query;
+	{
+		// parsing looks up words in the vocabulary, which can be extended by writer
+		TIndex::TReadLock ReadLock(*Index);
+		Query = TQuery::New(this, QueryVal);
+	}
+	return Search(Query);
 }
  
 void TBase::GarbageCollect() { 
@@ -4646,7 +5789,8 @@ void TBase::GarbageCollect() {
 }
 
 void TBase::InitTempIndex(const uint64& IndexCacheSize) { 
-	TempIndex = TTempIndex::New(TempFPath, IndexCacheSize); 
+	// without temporary folder, temporary indices are placed next to the main one
+	TempIndex = TTempIndex::New(IsTempFPath() ? TempFPath : FPath, IndexCacheSize); 
 	TempIndex->NewIndex(IndexVoc);
 }
 
@@ -4660,6 +5804,7 @@ bool TBase::SaveJSonDump(const TStr& DumpDir) {
 		const PStore Store = GetStoreByStoreN(S);
 		const TStr StoreNm = Store->GetStoreNm();
 		PSOut OutRecs = TFOut::New(DumpDir + StoreNm + ".json");
+		TJsonWriter RecWriter(OutRecs);
 		PSOut OutJoins = TFOut::New(DumpDir + StoreNm + "-joins.json");
 
 		// joins to store - only index joins and the ones we didn't already store by reverse join
@@ -4690,9 +5835,8 @@ bool TBase::SaveJSonDump(const TStr& DumpDir) {
 			const uint64 RecId = Iter->GetRecId();
 
 			// easy part. dump records
-			const PJsonVal RecJson = Store->GetRec(RecId).GetJson(this, true, false);
-			const TStr JsonStr = TJsonVal::GetStrFromVal(RecJson);
-			OutRecs->PutStrLn(JsonStr);
+			Store->GetRec(RecId).WriteJson(this, RecWriter, true, false);
+			RecWriter.PutLn();
 
 			// dump joins
 			for (int J = 0; J < JoinV.Len(); J++) {
@@ -4713,6 +5857,7 @@ bool TBase::SaveJSonDump(const TStr& DumpDir) {
 				TQm::TEnv::Logger->OnStatusFmt("Record %I64u / %I64u (%.1f%%)\r", RecId, Recs, 100 * RecId / (double) Recs);
             }
 		}
+		RecWriter.Flush();
 	}
 	uint64 DiffSecs = TTm::GetDiffSecs(TTm::GetCurLocTm(), CurrentTime);
 	int Mins = (int) (DiffSecs / 60);
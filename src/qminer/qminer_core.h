@@ -417,6 +417,12 @@ public:
     virtual void Init(const TWPt<TStore>& Store) { }
 	/// Called after record added to the store
     virtual void OnAdd(const TRec& Rec) = 0;
+	/// Called after a batch of records added to the store. Only used when
+	/// IsBatch() of all the store's triggers returns true. Default calls OnAdd for each record.
+    virtual void OnAddBatch(const PRecSet& RecSet);
+	/// True when the trigger does not depend on other triggers seeing
+	/// each record before it sees the next one
+    virtual bool IsBatch() const { return false; }
 	/// Called after record updated in the store
     virtual void OnUpdate(const TRec& Rec) = 0;
 	/// Called before record from the store
@@ -428,6 +434,61 @@ public:
 typedef TPt<TStoreTrigger> PStoreTrigger;
 typedef TVec<PStoreTrigger> TStoreTriggerV;
 
+///////////////////////////////
+/// String view. 
+/// Points to a string field value inside a serialized record without copying it.
+/// Valid only until the record changes or the buffer given to the getter is reused.
+class TStrView {
+private:
+    const char* Bf;
+    int BfL;
+    
+public:
+    TStrView(): Bf(NULL), BfL(0) { }
+    TStrView(const char* _Bf, const int& _BfL): Bf(_Bf), BfL(_BfL) { }
+    TStrView(const TStr& Str): Bf(Str.CStr()), BfL(Str.Len()) { }
+    
+    /// Pointer to the first character, not necessarily null-terminated
+    const char* GetBf() const { return Bf; }
+    int Len() const { return BfL; }
+    bool Empty() const { return BfL == 0; }
+    
+    bool operator==(const TStrView& View) const {
+        return (BfL == View.BfL) && ((BfL == 0) || (memcmp(Bf, View.Bf, BfL) == 0)); }
+    bool operator!=(const TStrView& View) const { return !operator==(View); }
+    
+    /// Copy into a new string
+    TStr GetStr() const { return (BfL == 0) ? TStr() : TStr(TChA(Bf, BfL)); }
+};
+
+///////////////////////////////
+/// Float vector view. 
+/// Points to packed float vector field value inside a serialized record without 
+/// copying it. Valid only until the record changes or the buffer given to the 
+/// getter is reused.
+class TFltVView {
+private:
+    /// Values are not necessarily aligned, so we keep them as bytes
+    const char* Bf;
+    int Vals;
+    
+public:
+    TFltVView(): Bf(NULL), Vals(0) { }
+    TFltVView(const char* _Bf, const int& _Vals): Bf(_Bf), Vals(_Vals) { }
+    TFltVView(const TFltV& FltV): Bf((const char*)FltV.BegI()), Vals(FltV.Len()) { }
+    
+    int Len() const { return Vals; }
+    bool Empty() const { return Vals == 0; }
+    double GetVal(const int& ValN) const {
+        Assert((0 <= ValN) && (ValN < Vals));
+        double Val; memcpy(&Val, Bf + ValN * sizeof(double), sizeof(double)); return Val; }
+    double operator[](const int& ValN) const { return GetVal(ValN); }
+    
+    /// Copy into a new vector
+    void GetFltV(TFltV& FltV) const {
+        FltV.Gen(Vals); for (int ValN = 0; ValN < Vals; ValN++) { FltV[ValN] = GetVal(ValN); } }
+};
+
 ///////////////////////////////
 /// Store. 
 /// Main interface to accessing records and their fields.
@@ -460,6 +521,8 @@ private:
     TStrH FieldNmToIdH;
     /// List of active triggers
     TStoreTriggerV TriggerV;
+    /// Are triggers called (disabled during bulk loads)
+    TBool TriggerP;
 
 	/// Load store from stream (to be called only by base class!)
     void LoadStore(TSIn& SIn);
@@ -486,9 +549,19 @@ protected:
     int AddFieldDesc(const TFieldDesc& FieldDesc);
 	/// Default error when accessing wrong field-type combination
     PExcept FieldError(const int& FieldId, const TStr& TypeStr) const;
-
+    /// Read at most BatchLen non-empty lines from a stream of JSon lines
+    static void GetJsonLnBatch(const PSIn& SIn, const int& BatchLen, TStrV& LnV);
+    /// Parse JSon line into a record. Lines which are not valid JSon objects
+    /// are reported to error log and empty pointer is returned.
+    static PJsonVal GetJsonLnRecVal(const TStr& LnStr);
+
+    /// Enable or disable calling of triggers
+    void PutTriggerP(const bool& _TriggerP) { TriggerP = _TriggerP; }
     /// Should be called after record RecId added; executes OnAdd event in all register triggers
     void OnAdd(const uint64& RecId);
+    /// Should be called after records RecIdV added; executes OnAddBatch event in all
+    /// registered triggers when they support it, otherwise OnAdd for each record
+    void OnAddBatch(const TUInt64V& RecIdV);
     /// Should be called after record RecId updated; executes OnUpdate event in all register triggers
     void OnUpdate(const uint64& RecId);
     /// Should be called before record RecId deleted; executes OnDelete event in all register triggers
@@ -597,8 +670,20 @@ public:
     
 	/// Add new record provided as JSon
 	virtual uint64 AddRec(const PJsonVal& RecVal) = 0;
+	/// Add new record provided as JSon string, without parsing it into TJsonVal.
+	/// Returns false, without adding anything, when the record cannot be added
+	/// directly (e.g. it has nested joins, refers to an existing record or is
+	/// not valid) and should go through AddRec instead. Default implementation
+	/// always returns false.
+	virtual bool TryAddRecJsonStr(const TStr& RecJsonStr, uint64& RecId) { return false; }
 	/// Update existing record with updates in provided JSon
 	virtual void UpdateRec(const uint64& RecId, const PJsonVal& RecVal) = 0;
+    /// Add records from a stream of JSon lines, BatchLen records at a time. Index postings
+    /// are collected in temporary indices of IndexCacheSize bytes and merged into the main
+    /// index at the end. Triggers are called only when TriggerP is set. Default implementation
+    /// adds records one by one. Returns number of added or updated records.
+	virtual uint64 AddRecBulk(const PSIn& SIn, const int& BatchLen = 10000,
+        const int64& IndexCacheSize = int64(TInt::Giga), const bool& TriggerP = true);
     
     /// Add join
     void AddJoin(const int& JoinId, const uint64& RecId, const uint64 JoinRecId, const int& JoinFq);
@@ -609,6 +694,8 @@ public:
 	virtual void GarbageCollect() { }
 	/// Delete the first DelRecs records (the records that were inserted first)
 	virtual void DeleteFirstNRecs(int DelRecs) { };
+	/// Delete given records (default implementation throws exception)
+	virtual void DeleteRecs(const TUInt64V& DelRecIdV, const bool& AssertOK = true) { throw TQmExcept::New("Not implemented"); }
     
     /// Check if the value of given field for a given record is NULL
 	virtual bool IsFieldNull(const uint64& RecId, const int& FieldId) const { return false; }
@@ -638,6 +725,18 @@ public:
     virtual void GetFieldNumSpV(const uint64& RecId, const int& FieldId, TIntFltKdV& SpV) const;
     /// Get field value using field id (default implementation throws exception)
     virtual void GetFieldBowSpV(const uint64& RecId, const int& FieldId, PBowSpV& SpV) const;
+    /// Get view of string field value. RecMem holds the record when it can not be
+    /// read directly from the storage, so reusing it for the whole scan avoids
+    /// allocations (default implementation copies value returned by GetFieldStr)
+	virtual TStrView GetFieldStrView(const uint64& RecId, const int& FieldId, TMem& RecMem) const;
+    /// Check if store keeps a column with values of given field
+    virtual bool IsFieldColumn(const int& FieldId) const { return false; }
+    /// Get values of integer or float field, one for each record in RecIdFqV 
+    /// (default implementation reads the field from each record)
+    virtual void GetFieldFltColumn(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TFltV& ValV) const;
+    /// Get values of uint64 or time field (as milliseconds), one for each record in 
+    /// RecIdFqV (default implementation reads the field from each record)
+    virtual void GetFieldUInt64Column(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TUInt64V& ValV) const;
 
 	/// Check if the value of given field for a given record is NULL
 	bool IsFieldNmNull(const uint64& RecId, const TStr& FieldNm) const;
@@ -734,6 +833,11 @@ public:
 	virtual PJsonVal GetFieldNmJson(const uint64& RecId, const TStr& FieldNm) const;
 	/// Get field value as human-readable text using field name
 	virtual TStr GetFieldNmText(const uint64& RecId, const TStr& FieldNm) const;
+	/// Write field value to JSon writer, same value as returned by GetFieldJson
+	void WriteFieldJson(const uint64& RecId, const int& FieldId, TJsonWriter& Writer) const;
+	/// Write non-null fields with given ids as key-value pairs into an open JSon object.
+	/// Default implementation goes through field getters one field at a time
+	virtual void WriteRecFieldsJson(const uint64& RecId, const TIntV& FieldIdV, TJsonWriter& Writer) const;
 
 	/// Helper function for returning JSon definition of fields
     PJsonVal GetStoreFieldsJson() const;
@@ -743,6 +847,13 @@ public:
     PJsonVal GetStoreJoinsJson(const TWPt<TBase>& Base) const;
 	/// Helper function for returning JSon definition of store
     PJsonVal GetStoreJson(const TWPt<TBase>& Base) const;
+    /// Statistics of store internals, e.g. cache usage (default implementation returns empty object)
+    virtual PJsonVal GetStoreStatJson() const { return TJsonVal::NewObj(); }
+    /// Add store files to the commit of a base checkpoint. After the first checkpoint
+    /// store is saved only by checkpoints (default implementation throws exception)
+    virtual void Checkpoint(TFCommit& Commit) { throw TQmExcept::New("Checkpoint not supported by store " + GetStoreNm()); }
+    /// Called once checkpoint commit is durable
+    virtual void OnCommit() { }
     /// Parse out record id from record JSon serialization
     uint64 GetRecId(const PJsonVal& RecVal) const;
 	
@@ -784,6 +895,10 @@ private:
 private:
 	/// Get QMiner exception for requesting wrong field-type combinations
     PExcept FieldError(const int& FieldId, const TStr& TypeStr) const;
+	/// Write record as JSon object, adding its frequency when JoinFq is not negative
+	void WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const bool& FieldsP,
+		const bool& StoreInfoP, const bool& JoinRecsP, const bool& JoinRecFieldsP,
+		const bool& RecInfoP, const TIntV& FieldIdV, const int& JoinFq) const;
 
 public:
 	/// Create empty record (no reference, no value)
@@ -912,6 +1027,15 @@ public:
 	PJsonVal GetJson(const TWPt<TBase>& Base, const bool& FieldsP = true, 
 		const bool& StoreInfoP = true, const bool& JoinRecsP = false, 
 		const bool& JoinRecFieldsP = false, const bool& RecInfoP = true) const;
+	/// Write record as JSon object directly to the writer, without building
+	/// the JSon tree. Same structure as GetJson. FieldIdV selects the fields
+	/// to output, empty vector means all non-internal fields.
+	void WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const bool& FieldsP = true,
+		const bool& StoreInfoP = true, const bool& JoinRecsP = false,
+		const bool& JoinRecFieldsP = false, const bool& RecInfoP = true,
+		const TIntV& FieldIdV = TIntV()) const;
+	/// Get ids of all non-internal fields, used by WriteJson when no fields given
+	static void GetJsonFieldIdV(const TWPt<TStore>& Store, TIntV& FieldIdV);
 };
 
 ///////////////////////////////
@@ -1136,13 +1260,14 @@ private:
     TInt FieldId;
     /// String value
     const TStr& StrVal;
+    /// Buffer reused for reading records
+    mutable TMem RecMem;
 public:
     TRecFilterByFieldStr(const TWPt<TStore>& _Store, const int& _FieldId, 
         const TStr& _StrVal): Store(_Store), FieldId(_FieldId), StrVal(_StrVal) { }
     
     bool operator()(const TUInt64IntKd& RecIdWgt) const {
-        const TStr RecVal = Store->GetFieldStr(RecIdWgt.Key, FieldId);
-        return StrVal == RecVal;
+        return TStrView(StrVal) == Store->GetFieldStrView(RecIdWgt.Key, FieldId, RecMem);
     }
 };
 
@@ -1245,6 +1370,10 @@ private:
 		const bool& SortedP, TUInt64IntKdV& SampleRecIdFqV) const;
 	/// Removes records from this result set that are not part of the provided
 	void LimitToSampleRecIdV(const TUInt64IntKdV& SampleRecIdFqV);
+	/// Keep records with values between MinVal and MaxVal, ValV has one value per record
+	template <class TVal> void FilterByValV(const TVec<TVal>& ValV, const TVal& MinVal, const TVal& MaxVal);
+	/// Sort records by values, ValV has one value per record
+	template <class TVal> void SortByValV(const TVec<TVal>& ValV, const bool& Asc);
 
 	TRecSet() { }
     TRecSet(const TWPt<TStore>& Store, const uint64& RecId, const int& Wgt);
@@ -1419,6 +1548,13 @@ public:
 	PJsonVal GetJson(const TWPt<TBase>& Base, const int& _MxHits = -1, const int& Offset = 0, 
 		const bool& FieldsP = false, const bool& AggrsP = true, const bool& StoreInfoP = true,
 		const bool& JoinRecsP = false, const bool& JoinRecFieldsP = false) const;
+	/// Write records directly to the writer, without building the JSon tree.
+	/// Same structure as GetJson. FieldIdV selects the fields to output,
+	/// empty vector means all non-internal fields.
+	void WriteJson(const TWPt<TBase>& Base, TJsonWriter& Writer, const int& _MxHits = -1,
+		const int& Offset = 0, const bool& FieldsP = false, const bool& AggrsP = true,
+		const bool& StoreInfoP = true, const bool& JoinRecsP = false, 
+		const bool& JoinRecFieldsP = false, const TIntV& FieldIdV = TIntV()) const;
 };
 typedef TVec<PRecSet> TRecSetV;
 
@@ -1437,6 +1573,38 @@ void TRecSet::FilterBy(const TFilter& Filter) {
 	RecIdFqV = NewRecIdFqV;    
 }
 
+template <class TVal> 
+void TRecSet::FilterByValV(const TVec<TVal>& ValV, const TVal& MinVal, const TVal& MaxVal) {
+	const int Recs = GetRecs();
+	TUInt64IntKdV NewRecIdFqV(Recs, 0);
+    for (int RecN = 0; RecN < Recs; RecN++) {
+        if ((MinVal <= ValV[RecN]) && (ValV[RecN] <= MaxVal)) { NewRecIdFqV.Add(RecIdFqV[RecN]); }
+    }
+	RecIdFqV = NewRecIdFqV;    
+}
+
+template <class TVal> 
+void TRecSet::SortByValV(const TVec<TVal>& ValV, const bool& Asc) {
+	// sort positions by values, ties keep their order
+	const int Recs = GetRecs();
+	TVec<TPair<TVal, TInt> > ValRecNV(Recs, 0);
+	for (int RecN = 0; RecN < Recs; RecN++) { ValRecNV.Add(TPair<TVal, TInt>(ValV[RecN], RecN)); }
+	ValRecNV.Sort(Asc);
+	if (!Asc) { 
+		// restore order of ties
+		int StartN = 0;
+		while (StartN < Recs) {
+			int EndN = StartN + 1;
+			while (EndN < Recs && ValRecNV[EndN].Val1 == ValRecNV[StartN].Val1) { EndN++; }
+			ValRecNV.Reverse(StartN, EndN - 1); StartN = EndN;
+		}
+	}
+	// reorder records
+	TUInt64IntKdV NewRecIdFqV(Recs, 0);
+	for (int RecN = 0; RecN < Recs; RecN++) { NewRecIdFqV.Add(RecIdFqV[ValRecNV[RecN].Val2]); }
+	RecIdFqV = NewRecIdFqV;
+}
+
 template <class TSplitter> 
 TVec<PRecSet> TRecSet::SplitBy(const TSplitter& Splitter) const {
     TRecSetV ResV;
@@ -1598,6 +1766,12 @@ private:
 	TUInt64 Recs; 
 	/// Hash table with all the words
 	TStrHash<TInt> WordH;
+	/// Number of words saved by the last checkpoint, later words are new
+	TInt CheckpointWords;
+	/// Ids of checkpointed words with changed counts, tracked after the first checkpoint
+	TIntSet ChangedWordIdSet;
+	/// True once the vocabulary was saved by a checkpoint
+	TBool CheckpointP;
 
 	TIndexWordVoc() { }
 	TIndexWordVoc(TSIn& SIn): WordVocNm(SIn), WordH(SIn) { }
@@ -1609,6 +1783,14 @@ public:
 	
 	/// Serialize vocabulary to stream
 	void Save(TSOut& SOut) { WordVocNm.Save(SOut); WordH.Save(SOut); }
+	/// Serialize words added or counted since the last checkpoint
+	void SaveDelta(TSOut& SOut) const;
+	/// Apply words serialized by SaveDelta, returns number of changed words
+	int LoadDelta(TSIn& SIn);
+	/// Number of words added or counted since the last checkpoint
+	int GetDeltaWords() const { return WordH.Len() - CheckpointWords + ChangedWordIdSet.Len(); }
+	/// Called once checkpoint is committed
+	void OnCommit() { CheckpointWords = WordH.Len(); ChangedWordIdSet.Clr(); CheckpointP = true; }
 
 	/// Check if word with given ID exists
 	bool IsWordId(const uint64& WordId) const { return WordH.IsKeyId((int)WordId); }
@@ -1672,13 +1854,15 @@ private:
     TIndexWordVocV WordVocV;
 	/// Used to return empty set by reference
 	TIntSet EmptySet;
+	/// Keys or vocabularies changed since the last checkpoint, or there was none yet
+	TBool KeysChangedP;
 
 	/// Get editable word vocabulary for a given key
 	PIndexWordVoc& GetWordVoc(const int& KeyId);
 	/// Get constant word vocabulary for a given key
 	const PIndexWordVoc& GetWordVoc(const int& KeyId) const;
 
-	TIndexVoc() { }
+	TIndexVoc(): KeysChangedP(true) { }
     TIndexVoc(TSIn& SIn);
 public:
 	/// Create new index vocabulary
@@ -1687,6 +1871,19 @@ public:
     static PIndexVoc Load(TSIn& SIn) { return new TIndexVoc(SIn); }
 	/// Serialize vocabulary to stream
     void Save(TSOut& SOut) const;
+	/// True when only words changed since the last checkpoint, so the
+	/// changes can be saved with SaveDelta instead of Save
+	bool IsDelta() const { return !KeysChangedP; }
+	/// Serialize words added or counted since the last checkpoint
+	void SaveDelta(TSOut& SOut) const;
+	/// Apply changes serialized by SaveDelta, returns number of changed words
+	uint64 LoadDelta(TSIn& SIn);
+	/// Number of words in all vocabularies
+	uint64 GetAllWords() const;
+	/// Number of words added or counted since the last checkpoint
+	uint64 GetDeltaWords() const;
+	/// Called once checkpoint is committed
+	void OnCommit();
 
     /// Get number of keys
 	int GetKeys() const { return KeyH.Len(); }
@@ -1706,7 +1903,7 @@ public:
 	const TIndexKey& GetKey(const uint& StoreId, const TStr& KeyNm) const;
 	
 	/// Create new word vocabulary, returns its ID
-	int NewWordVoc() { return WordVocV.Add(TIndexWordVoc::New()); }
+	int NewWordVoc() { KeysChangedP = true; return WordVocV.Add(TIndexWordVoc::New()); }
     /// Get Id of word vocabulary with a given name if one exists, -1 otherwise
     int GetWordVoc(const TStr& WordVocNm) const;
     /// Set the name of word vocabulary 
@@ -2075,6 +2272,11 @@ typedef TPt<TQuery> PQuery;
 //   Implemented in core.cpp, to avoid external dependancy on sphere.h
 class TGeoIndex; typedef TPt<TGeoIndex> PGeoIndex;
 
+///////////////////////////////
+// RangeIndex
+//   Implemented in core.cpp, next to geoindex
+class TRangeIndex; typedef TPt<TRangeIndex> PRangeIndex;
+
 ///////////////////////////////
 /// Index
 class TIndex {
@@ -2140,16 +2342,42 @@ private:
     mutable PQmGix Gix;
 	/// Location index
 	THash<TInt, PGeoIndex> GeoIndexH;
+	/// Range index for keys sorted as numbers
+	THash<TInt, PRangeIndex> RangeIndexH;
+	/// True when range index is kept up to date (false for indices created
+	/// before range index was introduced, which fall back to the vocabulary)
+	TBool RangeIndexP;
     /// Index Vocabulary
     PIndexVoc IndexVoc;
 	/// Inverted Index Default Merger
 	PQmGixMerger DefMerger;
-
+	/// Searches share the lock, updates hold it exclusively. Taken once by
+	/// each public method, which never call each other while holding it.
+	mutable TSysRWLock IndexLock;
+	/// Once checkpointed, index is saved only by checkpoints
+	TBool CheckpointP;
+	/// Location index changed since last checkpoint
+	TBool GeoChangedP;
+	/// Range index changed since last checkpoint
+	TBool RangeChangedP;
+
+	/// Checks if key is maintained in the range index
+	bool IsRangeKey(const int& KeyId) const;
+	/// Checks if query item is a range query that can be answered by range index
+	bool IsRangeItem(const TQueryItem& QueryItem) const;
+	/// Numeric value of a word, as used by range index
+	double GetRangeVal(const int& KeyId, const uint64& WordId) const;
+	/// Scan range index for records with values strictly between the bounds
+	PQmGixExpItem GetRangeExpItem(const int& KeyId, const double& MnVal, const double& MxVal) const;
     /// Converts query item tree to GIX query expression
 	PQmGixExpItem ToExpItem(const TQueryItem& QueryItem) const;
     /// Executes GIX query expression against the index
     bool DoQuery(const PQmGixExpItem& ExpItem, const PQmGixMerger& Merger, 
 		TQmGixItemV& RecIdFqV) const;
+	/// Add (RecId, RecFq) under key (KeyId, WordId), caller holds the write lock
+	void IndexItem(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq);
+	/// Delete (RecId, RecFq) under key (KeyId, WordId), caller holds the write lock
+	void DeleteItem(const int& KeyId, const uint64& WordId, const uint64& RecId, const int& RecFq);
 
     TIndex(const TStr& _IndexFPath, const TFAccess& _Access, 
         const PIndexVoc& IndexVoc, const int64& CacheSize);
@@ -2172,7 +2400,31 @@ public:
     /// Get index vocabulary
     TWPt<TIndexVoc> GetIndexVoc() const { return IndexVoc; }
 	/// Get default index merger
-	PQmGixMerger GetDefMerger() const { return DefMerger; }
+	const PQmGixMerger& GetDefMerger() const { return DefMerger; }
+	/// Add changed parts of the index to the commit of a base checkpoint
+	void Checkpoint(TFCommit& Commit);
+	/// Called once checkpoint commit is durable
+	void OnCommit() { Gix->OnCommit(); GeoChangedP = false; RangeChangedP = false; }
+
+	/// Shared lock, held by searches so they can run in parallel threads.
+	/// Use it when reading index vocabulary while the writer is active.
+	class TReadLock {
+	private:
+		const TIndex& Index;
+		UndefCopyAssign(TReadLock);
+	public:
+		TReadLock(const TIndex& _Index): Index(_Index) { Index.IndexLock.EnterRead(); }
+		~TReadLock() { Index.IndexLock.LeaveRead(); }
+	};
+	/// Exclusive lock, held by updates
+	class TWriteLock {
+	private:
+		TIndex& Index;
+		UndefCopyAssign(TWriteLock);
+	public:
+		TWriteLock(TIndex& _Index): Index(_Index) { Index.IndexLock.EnterWrite(); }
+		~TWriteLock() { Index.IndexLock.LeaveWrite(); }
+	};
 
     /// Index RecId under (Key, Word)
     void Index(const int& KeyId, const uint64& WordId, const uint64& RecId);
@@ -2466,6 +2718,17 @@ public:
 
 	/// Add new record to aggregate
 	virtual void OnAddRec(const TRec& Rec) = 0;
+	/// Add a batch of new records to aggregate. Default calls OnAddRec for each record.
+	virtual void OnAddRecBatch(const PRecSet& RecSet);
+	/// True when OnAddRecBatch gives the same state as adding records one by one.
+	/// This holds for aggregates reading only records, and for aggregates reading
+	/// inputs from the same stream aggregate base through their batch interfaces
+	/// (TStreamAggrOut::IFltTmBatch, TStreamAggrOut::IFltTmIOBatch).
+	virtual bool IsBatch() const { return false; }
+	/// True when adding records only changes the state of this aggregate and reads
+	/// the records and the declared input aggregates (GetInAggrNmV). Such aggregates
+	/// can process a batch in parallel with other aggregates they do not depend on.
+	virtual bool IsThreadSafe() const { return false; }
 	/// Recored already added to the aggregate is being updated
 	virtual void OnUpdateRec(const TRec& Rec) { }
 	/// Recored already added to the aggregate is being deleted from the store 
@@ -2513,11 +2776,36 @@ namespace TStreamAggrOut {
     public:
         virtual double GetInFlt() const = 0;
         virtual uint64 GetInTmMSecs() const = 0;
-		virtual void GetOutFltV(TFltV& ValV) const = 0;
-        virtual void GetOutTmMSecsV(TUInt64V& MSecsV) const = 0;
+        // values that left the window with the last record, valid until the next record
+		virtual const TFltV& GetOutFltV() const = 0;
+        virtual const TUInt64V& GetOutTmMSecsV() const = 0;
         virtual int GetN() const = 0;
     };
 
+    // values after each record of the last batch given to OnAddRecBatch
+    class IFltTmBatch {
+    public:
+        virtual int GetBatchLen() const = 0;
+        virtual bool IsBatchInit(const int& RecN) const = 0;
+        virtual double GetBatchFlt(const int& RecN) const = 0;
+        virtual uint64 GetBatchTmMSecs(const int& RecN) const = 0;
+    };
+
+    // window changes after each record of the last batch given to OnAddRecBatch;
+    // values that left the window with RecN-th record are the elements
+    // GetBatchOutN(RecN), ..., GetBatchOutN(RecN + 1) - 1 of GetBatchOut*V
+    class IFltTmIOBatch {
+    public:
+        virtual int GetBatchLen() const = 0;
+        virtual double GetBatchInFlt(const int& RecN) const = 0;
+        virtual uint64 GetBatchInTmMSecs(const int& RecN) const = 0;
+        virtual int GetBatchOutN(const int& RecN) const = 0;
+        virtual const TFltV& GetBatchOutFltV() const = 0;
+        virtual const TUInt64V& GetBatchOutTmMSecsV() const = 0;
+        // window length after RecN-th record
+        virtual int GetBatchN(const int& RecN) const = 0;
+    };
+
 	class IFltVec {
 	public:
 		// retrieving vector of values from the aggregate
@@ -2562,6 +2850,13 @@ private:
 
 	// stream aggregates
 	THash<TStr, PStreamAggr> StreamAggrH;
+	// batches go through steps one after another, aggregates within one step
+	// do not depend on each other and can run in parallel
+	TVec<TIntV> StepV;
+	// step of each aggregate, indexed by its key id
+	TIntV AggrStepNV;
+	// first step after the last aggregate which is not thread safe
+	TInt BarrierStepN;
 
 	// create emptyp base
 	TStreamAggrBase() { }
@@ -2584,6 +2879,9 @@ public:
 	
 	// forward the calls to stream aggregates
     void OnAddRec(const TRec& Rec);
+    // batches go to each aggregate at once when all of them support it,
+    // independent thread safe aggregates process them in parallel
+    void OnAddRecBatch(const PRecSet& RecSet);
     void OnUpdateRec(const TRec& Rec);
 	void OnDeleteRec(const TRec& Rec);
 	
@@ -2603,10 +2901,166 @@ public:
 
 	// forward the calls to stream aggreagte base
     void OnAdd(const TRec& Rec);
+    void OnAddBatch(const PRecSet& RecSet);
+    bool IsBatch() const { return true; }
     void OnUpdate(const TRec& Rec);
 	void OnDelete(const TRec& Rec);
 };
 
+///////////////////////////////
+/// Write-ahead log operation types
+typedef enum {
+    wotAddRec       = 0, ///< New record given as JSon
+    wotAddRecJson   = 1, ///< New record given as JSon string
+    wotAddRecBulk   = 2, ///< Batch of JSon lines given to bulk load
+    wotAddRecBulkEnd= 3, ///< End of bulk load, with its parameters
+    wotUpdateRec    = 4, ///< Update of existing record
+    wotDeleteRecs   = 5, ///< Deletion of records
+    wotAddJoin      = 6, ///< New join between two records
+    wotDelJoin      = 7, ///< Deleted join between two records
+    wotSetField     = 8  ///< New value of a field
+} TWalOpType;
+
+///////////////////////////////
+/// Write-ahead log.
+/// Changes of stores are appended to the log before they are executed, together 
+/// with the time of the operation, which is also used for insertion timestamps.
+/// Entries are passed to the operating system at the end of each operation and 
+/// synced to disk with group commit, at most every CommitMSecs milliseconds. Each 
+/// entry is framed with its length and checksum, so replay stops at the first torn
+/// entry. Entries are numbered and the log is cleared by each checkpoint of the base, 
+/// entries already included in the checkpoint are skipped by replay.
+class TWal {
+private:
+	// smart-pointer
+	TCRef CRef;
+	friend class TPt<TWal>;
+
+    /// Log file
+    PFRnd FRnd;
+    /// Entries not yet written to the log file
+    TMOut BufMOut;
+    /// Number of the last logged operation
+    TUInt64 LastOpN;
+    /// Bytes written to the log since last checkpoint
+    TUInt64 LogLen;
+    /// True when there are writes not yet synced to disk
+    TBool SyncP;
+    /// Time interval between syncs of the log
+    TUInt64 CommitMSecs;
+    /// Time of the last sync
+    TUInt64 LastCommitMSecs;
+    /// Log length which triggers checkpoint (0 for never)
+    TUInt64 CheckpointLen;
+    /// Time interval which triggers checkpoint (0 for never)
+    TUInt64 CheckpointMSecs;
+    /// Time of the last checkpoint
+    TUInt64 LastCheckpointMSecs;
+
+    TWal(const TStr& FNm, const uint64& _LastOpN, const uint64& _CommitMSecs,
+        const uint64& _CheckpointLen, const uint64& _CheckpointMSecs);
+
+    /// Start new entry
+    void StartOp(TMOut& OpMOut, const TWalOpType& OpType, const uint& StoreId, const uint64& OpMSecs);
+    /// Append the entry with its length and checksum to the buffer
+    void EndOp(const TMOut& OpMOut);
+    /// Save value of a field
+    static void SaveField(const TWPt<TStore>& Store, const uint64& RecId, const int& FieldId, TSOut& SOut);
+    /// Set value of a field saved by SaveField
+    static void LoadField(const TWPt<TStore>& Store, const uint64& RecId, const int& FieldId, TSIn& SIn);
+    /// Execute logged operation
+    static void ExecOp(const TWalOpType& OpType, const TWPt<TStore>& Store, TSIn& SIn);
+    /// Read next entry of the log, false at the end or at a torn entry
+    static bool LoadOp(TFIn& FIn, TMem& OpMem);
+
+public:
+    /// Create new empty log. Operations are numbered after LastOpN
+    static TPt<TWal> New(const TStr& FNm, const uint64& LastOpN, const uint64& CommitMSecs,
+        const uint64& CheckpointLen, const uint64& CheckpointMSecs) { 
+            return new TWal(FNm, LastOpN, CommitMSecs, CheckpointLen, CheckpointMSecs); }
+
+    /// Log new record
+    void AddRec(const uint& StoreId, const uint64& OpMSecs, const PJsonVal& RecVal);
+    /// Log new record given as JSon string
+    void AddRecJson(const uint& StoreId, const uint64& OpMSecs, const TStr& RecJsonStr);
+    /// Log batch of lines given to bulk load
+    void AddRecBulk(const uint& StoreId, const uint64& OpMSecs, const TStrV& LnV);
+    /// Log end of bulk load
+    void AddRecBulkEnd(const uint& StoreId, const uint64& OpMSecs, const int& BatchLen,
+        const int64& IndexCacheSize, const bool& TriggerP);
+    /// Log update of existing record
+    void UpdateRec(const uint& StoreId, const uint64& OpMSecs, const uint64& RecId, const PJsonVal& RecVal);
+    /// Log deletion of records
+    void DeleteRecs(const uint& StoreId, const uint64& OpMSecs, const TUInt64V& DelRecIdV);
+    /// Log new join
+    void AddJoin(const uint& StoreId, const uint64& OpMSecs, const int& JoinId,
+        const uint64& RecId, const uint64 JoinRecId, const int& JoinFq);
+    /// Log deleted join
+    void DelJoin(const uint& StoreId, const uint64& OpMSecs, const int& JoinId,
+        const uint64& RecId, const uint64 JoinRecId, const int& JoinFq);
+    /// Log current value of a field, after it was set
+    void SetField(const TWPt<TStore>& Store, const uint64& OpMSecs, const uint64& RecId, const int& FieldId);
+
+    /// Number of the last logged operation
+    uint64 GetLastOpN() const { return LastOpN; }
+    /// Write buffered entries to the log file
+    void Flush();
+    /// Write buffered entries to the log file and sync it to disk
+    void Commit();
+    /// Is it time to sync the log
+    bool IsCommitDue() const;
+    /// Is log long or old enough for a checkpoint
+    bool IsCheckpointDue() const;
+    /// Clear the log after the checkpoint
+    void Clr();
+
+    /// Replay log, skipping operations up to CheckpointOpN. Returns the number 
+    /// of the last operation in the log.
+    static uint64 Replay(const TStr& FNm, const TWPt<TBase>& Base, const uint64& CheckpointOpN);
+    /// Number of the last complete operation in the log, 0 when there is none
+    static uint64 GetLastOpN(const TStr& FNm);
+};
+typedef TPt<TWal> PWal;
+
+///////////////////////////////
+/// Scope of a store operation, logged in write-ahead log when it is enabled.
+/// Only outermost operations are logged, changes which they make through nested
+/// calls (e.g. nested join records) are repeated by replay. Changes made by triggers
+/// are logged separately. Time of the operation is fixed for its whole scope.
+/// Outermost operation can start with a checkpoint and ends with a group commit.
+class TWalOp {
+private:
+    /// Base of the store
+    TWPt<TBase> Base;
+    /// Is this operation logged
+    bool LogP;
+    /// Did this operation fix the time
+    bool TmP;
+    
+    UndefCopyAssign(TWalOp);
+public:
+    TWalOp(const TWPt<TBase>& _Base);
+    ~TWalOp();
+
+    /// Should this operation be logged
+    bool IsLog() const { return LogP; }
+    /// Write-ahead log
+    TWal& GetWal() const;
+    /// Time of the operation
+    uint64 GetOpMSecs() const;
+
+    /// Triggers are called in this scope, so their changes are logged
+    class TTriggerScope {
+    private:
+        TWPt<TBase> Base;
+        int LogDepth;
+        UndefCopyAssign(TTriggerScope);
+    public:
+        TTriggerScope(const TWPt<TBase>& _Base);
+        ~TTriggerScope();
+    };
+};
+
 ///////////////////////////////
 // QMiner-Base
 class TBase {
@@ -2643,6 +3097,25 @@ private:
 	// temporary indices
 	PTempIndex TempIndex;
 
+	// write-ahead log, empty when disabled
+	PWal Wal;
+	// depth of nested store operations
+	int WalOpDepth;
+	// depth of nested store operations, reset when calling triggers
+	int WalLogDepth;
+	// time of current store operation, or of replayed one (0 when none)
+	TUInt64 WalOpMSecs;
+	// number of the last operation included in the last checkpoint
+	TUInt64 CheckpointOpN;
+	// is base saved by checkpoints
+	TBool CheckpointP;
+	// index vocabulary changes saved after its last full save
+	TFDelta IndexVocDelta;
+	friend class TWal;
+	friend class TWalOp;
+	// shared by readers and held exclusively by writers running on other threads
+	mutable TSysRWLock BaseLock;
+
 private:
     TBase(const TStr& _FPath, const int64& IndexCacheSize);
     TBase(const TStr& _FPath, const TFAccess& _FAccess, const int64& IndexCacheSize);
@@ -2759,6 +3232,45 @@ public:
     /// Execute garbage collection on all stores
     void GarbageCollect();    
 
+    /// Save consistent state of the base with an atomic commit. Once the base is 
+    /// checkpointed it is saved only by checkpoints, including the final one when closed
+    void Checkpoint();
+    /// Is base saved by checkpoints
+    bool IsCheckpoint() const { return CheckpointP; }
+    /// Enable write-ahead log. Log is synced to disk every CommitMSecs, checkpoint 
+    /// is made when log is longer than CheckpointLen bytes or older than CheckpointMSecs.
+    /// Stream aggregates are not logged nor checkpointed, so they can not be registered 
+    /// on a base with the log, and the log can not be enabled once they are registered
+    void InitWal(const uint64& CommitMSecs, const uint64& CheckpointLen, const uint64& CheckpointMSecs);
+    /// Is write-ahead log enabled
+    bool IsWal() const { return !Wal.Empty(); }
+    /// Replay write-ahead log left by a crash and make a checkpoint. Must be called 
+    /// after stores are loaded and before the log is enabled. Read-only base does not
+    /// open when the log has operations after the last checkpoint
+    void ReplayWal();
+    /// Current time, fixed for the duration of a store operation and its replay
+    uint64 GetCurUniMSecs() const { return WalOpMSecs > 0 ? WalOpMSecs.Val : TTm::GetCurUniMSecs(); }
+
+	/// Shared lock over stores, records and indices. Base does not take it itself,
+	/// it is held by callers which read the base from several threads at once.
+	class TReadLock {
+	private:
+		const TBase& Base;
+		UndefCopyAssign(TReadLock);
+	public:
+		TReadLock(const TBase& _Base): Base(_Base) { Base.BaseLock.EnterRead(); }
+		~TReadLock() { Base.BaseLock.LeaveRead(); }
+	};
+	/// Exclusive lock, held by callers changing the base while others may read it
+	class TWriteLock {
+	private:
+		TBase& Base;
+		UndefCopyAssign(TWriteLock);
+	public:
+		TWriteLock(TBase& _Base): Base(_Base) { Base.BaseLock.EnterWrite(); }
+		~TWriteLock() { Base.BaseLock.LeaveWrite(); }
+	};
+
     // is temporary folder defined
 	bool IsTempFPath() const { return TempFPathP; }
 	// get temporary folder
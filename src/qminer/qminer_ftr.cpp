@@ -146,6 +146,17 @@ void TFtrExt::AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const {
         FullV[SpV[SpN].Key] = SpV[SpN].Dat; }
 }
 
+bool TFtrExt::Update(const PRecSet& RecSet) {
+    bool UpdateP = false;
+	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+		if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
+        // update according to the record
+        const bool RecUpdateP = Update(RecSet->GetRec(RecN));
+		UpdateP = UpdateP || RecUpdateP;
+	}
+    return UpdateP;
+}
+
 void TFtrExt::ExtractStrV(const TRec& FtrRec, TStrV& StrV) const { 
 	throw TQmExcept::New("ExtractStrV not implemented!"); 
 }
@@ -252,17 +263,42 @@ bool TFtrSpace::Update(const TRec& Rec) {
 
 bool TFtrSpace::Update(const PRecSet& RecSet) {
     TEnv::Logger->OnStatusFmt("Updating feature space with %d records", RecSet->GetRecs());
+    // feature extractors are independent, so each can go over the whole set 
+    // at once and use its own batch update
     bool UpdateDimP = false;
-	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-		if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-        // update according to the record
-        const bool RecUpdateDimP = Update(RecSet->GetRec(RecN));
-        // check if we did a dimensionality update
-		UpdateDimP = UpdateDimP || RecUpdateDimP;
+	for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+        const PFtrExt& FtrExt = FtrExtV[FtrExtN];       
+		const bool FtrExtUpdateDimP = FtrExt->Update(RecSet);
+        if (FtrExtUpdateDimP) {
+            // update the dimensionality sum (existing - old + new)
+            const int NewDim = FtrExt->GetDim();
+            Dim = Dim - DimV[FtrExtN] + NewDim;
+            DimV[FtrExtN] = NewDim;
+            UpdateDimP = true;
+        }
 	}
     return UpdateDimP;
 }
 
+void TFtrSpace::GetRemappedDimV(TIntV& DimV) {
+    DimV.Clr();
+	for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+        TIntV FtrExtDimV; FtrExtV[FtrExtN]->GetRemappedDimV(FtrExtDimV);
+        // move to the feature space coordinates
+        const int Offset = GetMnFtrN(FtrExtN);
+        for (int DimN = 0; DimN < FtrExtDimV.Len(); DimN++) {
+            DimV.Add(Offset + FtrExtDimV[DimN]);
+        }
+    }
+}
+
+bool TFtrSpace::IsThreadSafe() const {
+	for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
+        if (!FtrExtV[FtrExtN]->IsThreadSafe()) { return false; }
+    }
+    return true;
+}
+
 void TFtrSpace::GetSpV(const TRec& Rec, TIntFltKdV& SpV) const {
 	int Offset = 0;
 	for (int FtrExtN = 0; FtrExtN < FtrExtV.Len(); FtrExtN++) {
@@ -302,30 +338,66 @@ double TFtrSpace::InvertFtr(const int& FtrExtN, const TFlt& FtrVal) const {
 }
 
 void TFtrSpace::GetSpVV(const PRecSet& RecSet, TVec<TIntFltKdV>& SpVV) const {
-    TEnv::Logger->OnStatusFmt("Creating sparse feature vectors from %d records", RecSet->GetRecs());
-	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-		if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-		SpVV.Add(TIntFltKdV()); GetSpV(RecSet->GetRec(RecN), SpVV.Last());
-	}
+    const int Recs = RecSet->GetRecs();
+    TEnv::Logger->OnStatusFmt("Creating sparse feature vectors from %d records", Recs);
+    if (IsThreadSafe()) {
+        // make space for the new vectors and fill them in parallel
+        const int StartSpN = SpVV.Len(); SpVV.Reserve(StartSpN + Recs);
+        for (int RecN = 0; RecN < Recs; RecN++) { SpVV.Add(); }
+        TFtrExt::ParallelChunks(Recs, [&](const int& StartRecN, const int& EndRecN) {
+            for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+                GetSpV(RecSet->GetRec(RecN), SpVV[StartSpN + RecN]);
+            }
+        });
+    } else {
+        for (int RecN = 0; RecN < Recs; RecN++) {
+            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
+            SpVV.Add(TIntFltKdV()); GetSpV(RecSet->GetRec(RecN), SpVV.Last());
+        }
+    }
 }
 
 void TFtrSpace::GetFullVV(const PRecSet& RecSet, TVec<TFltV>& FullVV) const {
-    TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", RecSet->GetRecs());
-	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-		if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-		FullVV.Add(TFltV()); GetFullV(RecSet->GetRec(RecN), FullVV.Last());
-	}
+    const int Recs = RecSet->GetRecs();
+    TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", Recs);
+    if (IsThreadSafe()) {
+        // make space for the new vectors and fill them in parallel
+        const int StartFullN = FullVV.Len(); FullVV.Reserve(StartFullN + Recs);
+        for (int RecN = 0; RecN < Recs; RecN++) { FullVV.Add(); }
+        TFtrExt::ParallelChunks(Recs, [&](const int& StartRecN, const int& EndRecN) {
+            for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+                GetFullV(RecSet->GetRec(RecN), FullVV[StartFullN + RecN]);
+            }
+        });
+    } else {
+        for (int RecN = 0; RecN < Recs; RecN++) {
+            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
+            FullVV.Add(TFltV()); GetFullV(RecSet->GetRec(RecN), FullVV.Last());
+        }
+    }
 }
 
 void TFtrSpace::GetFullVV(const PRecSet& RecSet, TFltVV& FullVV) const {
-    TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", RecSet->GetRecs());
-	FullVV.Gen(GetDim(), RecSet->GetRecs());
-	TFltV Temp(GetDim());
-	for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
-		if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
-		GetFullV(RecSet->GetRec(RecN), Temp);
-		FullVV.SetCol(RecN, Temp);
-	}
+    const int Recs = RecSet->GetRecs();
+    TEnv::Logger->OnStatusFmt("Creating full feature vectors from %d records", Recs);
+	FullVV.Gen(GetDim(), Recs);
+    if (IsThreadSafe()) {
+        // each chunk of records gets its own buffer
+        TFtrExt::ParallelChunks(Recs, [&](const int& StartRecN, const int& EndRecN) {
+            TFltV Temp(GetDim());
+            for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+                GetFullV(RecSet->GetRec(RecN), Temp);
+                FullVV.SetCol(RecN, Temp);
+            }
+        });
+    } else {
+        TFltV Temp(GetDim());
+        for (int RecN = 0; RecN < Recs; RecN++) {
+            if (RecN % 10000 == 0) { TEnv::Logger->OnStatusFmt("%d\r", RecN); }
+            GetFullV(RecSet->GetRec(RecN), Temp);
+            FullVV.SetCol(RecN, Temp);
+        }
+    }
 }
 	
 void TFtrSpace::GetCentroidSpV(const PRecSet& RecSet, 
@@ -743,6 +815,23 @@ bool TCategorical::Update(const TRec& Rec) {
 	return FtrGen.Update(GetVal(Rec));
 }
 
+bool TCategorical::Update(const PRecSet& RecSet) {
+    // read values in parallel
+    TStrV ValV(RecSet->GetRecs());
+    ParallelChunks(ValV.Len(), [&](const int& StartRecN, const int& EndRecN) {
+        for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+            ValV[RecN] = GetVal(RecSet->GetRec(RecN));
+        }
+    });
+    // update the feature generator in the record order
+    bool UpdateP = false;
+    for (int ValN = 0; ValN < ValV.Len(); ValN++) {
+        const bool ValUpdateP = FtrGen.Update(ValV[ValN]);
+        UpdateP = UpdateP || ValUpdateP;
+    }
+    return UpdateP;
+}
+
 void TCategorical::AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const {
 	FtrGen.AddFtr(GetVal(Rec), SpV, Offset);
 }
@@ -1104,6 +1193,26 @@ void TBagOfWords::GetVal(const TRec& Rec, TStrV& StrV) const {
 	}
 }
 
+void TBagOfWords::GetDocTokenVV(const TRec& Rec, TVec<TStrV>& DocTokenVV) const {
+	// get all instances
+	TStrV RecStrV; GetVal(Rec, RecStrV);
+	if (Mode == bowmConcat) {
+		// merge into one document
+        DocTokenVV.Gen(1); FtrGen.GetFtr(TStr::GetStr(RecStrV, "\n"), DocTokenVV[0]);
+	} else if (Mode == bowmCentroid) {
+		// threat each as a separate document
+        DocTokenVV.Gen(RecStrV.Len());
+		for (int RecStrN = 0; RecStrN < RecStrV.Len(); RecStrN++) { 
+            FtrGen.GetFtr(RecStrV[RecStrN], DocTokenVV[RecStrN]);
+        }
+    } else if (Mode == bowmTokenized) {
+        // already tokenized
+        DocTokenVV.Gen(1); DocTokenVV[0] = RecStrV;
+	} else {
+		throw TQmExcept::New("Unknown tokenizer mode for handling multiple instances");
+	}
+}
+
 void TBagOfWords::AddField(const int& FieldId) {
     FieldIdV.Add(FieldId);
     FieldDescV.Add(GetFtrStore()->GetFieldDesc(FieldId));
@@ -1172,6 +1281,9 @@ TBagOfWords::TBagOfWords(const TWPt<TBase>& Base, const PJsonVal& ParamVal):
     const int HashDim = ParamVal->GetObjInt("hashDimension", -1);
     // keep hash table?
     const bool KHT = ParamVal->GetObjBool("hashTable", false);
+    // bounded vocabulary size
+    const int MxVocabSize = ParamVal->GetObjInt("vocabularySize", -1);
+    QmAssertR(MxVocabSize == -1 || MxVocabSize > 0, "Vocabulary size must be positive");
 
     // parse ngrams
     TInt NgramsStart = 1;
@@ -1197,7 +1309,8 @@ TBagOfWords::TBagOfWords(const TWPt<TBase>& Base, const PJsonVal& ParamVal):
     }
 
     // initialize
-    FtrGen = TFtrGen::TBagOfWords(TfP, IdfP, NormalizeP, Tokenizer, HashDim, KHT, NgramsStart, NgramsEnd);
+    FtrGen = TFtrGen::TBagOfWords(TfP, IdfP, NormalizeP, Tokenizer, 
+        HashDim, KHT, NgramsStart, NgramsEnd, MxVocabSize);
     
     // parse input field(s)
     PJsonVal FieldVal = ParamVal->GetObjKey("field");
@@ -1345,6 +1458,34 @@ bool TBagOfWords::Update(const TRec& Rec) {
 	}
 }
 
+bool TBagOfWords::Update(const PRecSet& RecSet) {
+    // forgetting depends on the time of each record, so it goes one by one
+    if (TmWnd.IsInit() || !IsThreadSafe()) { return TFtrExt::Update(RecSet); }
+    // tokenize blocks of records in parallel and update the vocabulary and
+    // document frequencies in the record order, same as updating one by one
+    const int BlockLen = 10000;
+    const int Recs = RecSet->GetRecs();
+    bool UpdateP = false;
+    for (int BlockStartRecN = 0; BlockStartRecN < Recs; BlockStartRecN += BlockLen) {
+        TEnv::Logger->OnStatusFmt("%d\r", BlockStartRecN);
+        const int BlockRecs = TInt::GetMn(BlockLen, Recs - BlockStartRecN);
+        TVec<TVec<TStrV> > RecDocTokenVV(BlockRecs);
+        ParallelChunks(BlockRecs, [&](const int& StartRecN, const int& EndRecN) {
+            for (int RecN = StartRecN; RecN < EndRecN; RecN++) {
+                GetDocTokenVV(RecSet->GetRec(BlockStartRecN + RecN), RecDocTokenVV[RecN]);
+            }
+        });
+        for (int RecN = 0; RecN < BlockRecs; RecN++) {
+            const TVec<TStrV>& DocTokenVV = RecDocTokenVV[RecN];
+            for (int DocN = 0; DocN < DocTokenVV.Len(); DocN++) {
+                const bool DocUpdateP = FtrGen.Update(DocTokenVV[DocN]);
+                UpdateP = UpdateP || DocUpdateP;
+            }
+        }
+    }
+    return UpdateP;
+}
+
 void TBagOfWords::AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const {
 	// get all instances
 	TStrV RecStrV; GetVal(Rec, RecStrV);
@@ -106,6 +106,10 @@ public:
 	/// Update the feature extractor using the info from the given record.
     /// Returns true if the update changes the dimensionality.
 	virtual bool Update(const TRec& Rec) = 0;
+	/// Update the feature extractor using all the records from the given set.
+    /// Default calls Update for each record. Returns true if the update 
+    /// changes the dimensionality.
+	virtual bool Update(const PRecSet& RecSet);
 	/// Attaches features to a given sparse feature vectors with a given offset
 	virtual void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const = 0;
 	/// Attaches features to a given full feature vectors with a given offset
@@ -121,6 +125,19 @@ public:
 	virtual void ExtractFltV(const TRec& Rec, TFltV& FltV) const;
 	virtual void ExtractTmV(const TRec& Rec, TTmV& TmV) const;
 
+    /// Dimensions which changed their meaning since the previous call, e.g.
+    /// when bounded vocabulary replaced a token. Default has none.
+    virtual void GetRemappedDimV(TIntV& DimV) { DimV.Clr(); }
+
+    /// True when AddSpV and AddFullV can be called concurrently from multiple
+    /// threads. Extractors with mutable state or user callbacks must return false.
+    virtual bool IsThreadSafe() const { return false; }
+    /// Calls ExeF(StartRecN, EndRecN) for consecutive chunks of ChunkLen records
+    /// from multiple threads. The first exception thrown by ExeF is re-thrown 
+    /// after all the chunks are processed.
+    template <class TExeF> 
+    static void ParallelChunks(const int& Recs, const TExeF& ExeF, const int& ChunkLen = 256);
+
 	/// Check if the given store is one of the allowed start stores
 	bool IsStartStore(const uint& StoreId) const { return JoinSeqH.IsKey(StoreId); }
 	/// Is there a join to be done when starting from the given store
@@ -133,6 +150,27 @@ public:
 	TWPt<TStore> GetFtrStore() const { return FtrStore; }
 };
 
+template <class TExeF>
+void TFtrExt::ParallelChunks(const int& Recs, const TExeF& ExeF, const int& ChunkLen) {
+    const int Chunks = (Recs + ChunkLen - 1) / ChunkLen;
+    // exceptions must not leave the parallel region
+    PExcept Except;
+    #pragma omp parallel for schedule(dynamic)
+    for (int ChunkN = 0; ChunkN < Chunks; ChunkN++) {
+        const int StartRecN = ChunkN * ChunkLen;
+        const int EndRecN = TInt::GetMn(StartRecN + ChunkLen, Recs);
+        try {
+            ExeF(StartRecN, EndRecN);
+        } catch (PExcept& ChunkExcept) {
+            #pragma omp critical
+            {
+                if (Except.Empty()) { Except = ChunkExcept; }
+            }
+        }
+    }
+    if (!Except.Empty()) { throw Except; }
+}
+
 ///////////////////////////////////////////////
 /// Feature space.
 class TFtrSpace {
@@ -179,15 +217,23 @@ public:
 	bool Update(const TRec& Rec);
 	/// Update feature extractors given a set of records
 	bool Update(const PRecSet& RecSet);
+    /// Dimensions of the space which changed their meaning since the previous
+    /// call. Features extracted before for these dimensions are stale.
+    void GetRemappedDimV(TIntV& DimV);
+    /// True when all feature extractors can extract features from multiple threads
+    bool IsThreadSafe() const;
     /// Extract sparse feature vector from a record
 	void GetSpV(const TRec& Rec, TIntFltKdV& SpV) const;
     /// Extract full feature vector from a record
     void GetFullV(const TRec& Rec, TFltV& FullV) const;
-	/// Extracting sparse feature vectors from a record set
+	/// Extracting sparse feature vectors from a record set. Vectors are
+    /// appended to SpVV and computed in parallel when IsThreadSafe()
 	void GetSpVV(const PRecSet& RecSet, TVec<TIntFltKdV>& SpVV) const;
-	/// Extracting full feature vectors from a record set
+	/// Extracting full feature vectors from a record set. Vectors are
+    /// appended to FullVV and computed in parallel when IsThreadSafe()
 	void GetFullVV(const PRecSet& RecSet, TVec<TFltV>& FullVV) const;
-	/// Extracting full feature vectors (columns) from a record set
+	/// Extracting full feature vectors (columns) from a record set,
+    /// computed in parallel when IsThreadSafe()
 	void GetFullVV(const PRecSet& RecSet, TFltVV& FullVV) const;
 	/// Compute sparse centroid of a given record set
 	void GetCentroidSpV(const PRecSet& RecSet, TIntFltKdV& CentroidSpV, const bool& NormalizeP = true) const;
@@ -255,6 +301,7 @@ public:
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
 	// flat feature extraction
 	void ExtractFltV(const TRec& FtrRec, TFltV& FltV) const;
@@ -344,6 +391,7 @@ public:
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
 	// flat feature extraction
 	void ExtractFltV(const TRec& Rec, TFltV& FltV) const;
@@ -390,10 +438,12 @@ public:
 	void Clr() { FtrGen.Clr(); }
 	// sparse vector extraction
 	bool Update(const TRec& Rec);
+	bool Update(const PRecSet& RecSet);
 	void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
 	// flat feature extraction
 	void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -450,6 +500,7 @@ public:
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
 	// flat feature extraction
 	void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -491,6 +542,8 @@ private:
 	void _GetVal(const PRecSet& FtrRecSet, TStrV& StrV) const; 
 	void _GetVal(const TRec& FtrRec, TStrV& StrV) const; 
 	void GetVal(const TRec& Rec, TStrV& StrV) const; 
+    /// Tokenized documents from the record, as passed to the feature generator
+    void GetDocTokenVV(const TRec& Rec, TVec<TStrV>& DocTokenVV) const;
     
     void AddField(const int& FieldId);
     void AddField(const TStr& FieldNm);
@@ -533,10 +586,13 @@ public:
 
 	// sparse vector extraction
 	bool Update(const TRec& Rec);
+	bool Update(const PRecSet& RecSet);
 	void AddSpV(const TRec& Rec, TIntFltKdV& SpV, int& Offset) const;
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return (Mode == bowmTokenized) || FtrGen.IsThreadSafe(); }
+	void GetRemappedDimV(TIntV& DimV) { FtrGen.GetRemappedDimV(DimV); }
 
 	// flat feature extraction
 	void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -585,6 +641,7 @@ public:
 	//void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
 	// flat feature extraction
 	void ExtractStrV(const TRec& Rec, TStrV& StrV) const;
@@ -637,6 +694,7 @@ public:
 	//void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return FtrExt1->IsThreadSafe() && FtrExt2->IsThreadSafe(); }
 
 	// flat feature extraction
 	void ExtractStrV(const TRec& FtrRec, TStrV& StrV) const;
@@ -692,6 +750,7 @@ public:
 	void AddFullV(const TRec& Rec, TFltV& FullV, int& Offset) const;
 
 	void InvFullV(const TFltV& FullV, int& Offset, TFltV& InvV) const;
+	bool IsThreadSafe() const { return true; }
 
     // feature extractor type name 
     static TStr GetType() { return "dateWindow"; }
@@ -93,6 +93,7 @@ TFieldDescEx TStoreSchema::ParseFieldDescEx(const PJsonVal& FieldVal) {
     // parse flags
 	FieldDescEx.SmallStringP = FieldVal->GetObjBool("shortstring", false);
 	FieldDescEx.CodebookP = FieldVal->GetObjBool("codebook", false);
+	FieldDescEx.ColumnP = FieldVal->GetObjBool("column", false);
 	// load default value (if available)
 	if (FieldVal->IsObjKey("default")) {
 		FieldDescEx.DefaultVal = FieldVal->GetObjKey("default");
@@ -415,59 +416,274 @@ void TStoreSchema::ValidateSchema(const TWPt<TBase>& Base, TStoreSchemaV& Schema
 	}
 }
 
+///////////////////////////////
+// In-memory storage chunk
+TInMemChunk::TInMemChunk(const TStr& FNm, const bool& MMapP): LastPageFree(0), 
+        DataLen(0), GarbageLen(0), MMapOffsetV(NULL), MMapDataBf(NULL), 
+        MMapVals(0), DirtyP(false) {
+
+    if (MMapP) {
+        // layout: number of values, offsets, data
+        PFMMap _MMap = TFMMap::New(FNm);
+        QmAssertR(_MMap->Len() >= sizeof(int64), "Corrupted storage chunk " + FNm);
+        MMapVals = *(const int64*)_MMap->GetBf();
+        MMapOffsetV = (const uint64*)(_MMap->GetBf() + sizeof(int64));
+        MMapDataBf = _MMap->GetBf() + sizeof(int64) + (MMapVals + 1) * sizeof(uint64);
+        QmAssertR(uint64(MMapDataBf - _MMap->GetBf()) + MMapOffsetV[MMapVals] == _MMap->Len(),
+            "Corrupted storage chunk " + FNm);
+        MMap = _MMap;
+    } else {
+        TFIn FIn(FNm);
+        int64 Vals; FIn.Load(Vals);
+        TVec<TUInt64, int64> OffsetV(Vals + 1, 0);
+        for (int64 ValN = 0; ValN <= Vals; ValN++) { OffsetV.Add(TUInt64(FIn)); }
+        // copy values into pages
+        ValLocV.Gen(Vals, 0); TMem Val;
+        for (int64 ValN = 0; ValN < Vals; ValN++) {
+            const int ValLen = int(OffsetV[ValN + 1] - OffsetV[ValN]);
+            Val.Gen(ValLen); if (ValLen > 0) { FIn.GetBf(Val.GetBf(), ValLen); }
+            ValLocV.Add(PutBf(Val.GetBf(), ValLen));
+        }
+    }
+}
+
+TInMemChunk::TValLoc TInMemChunk::PutBf(const char* Bf, const int& Len) {
+    if (Len == 0) { return TValLoc(); }
+    // start new page when value does not fit into the last one
+    if (LastPageFree < Len) {
+        const int NewPageLen = TInt::GetMx(PageLen, Len);
+        PageV.Add(TMem::New(NewPageLen)); LastPageFree = NewPageLen;
+    }
+    TMem& Page = *PageV.Last();
+    const TValLoc ValLoc(PageV.Len() - 1, Page.Len(), Len);
+    Page.AddBf(Bf, Len); LastPageFree -= Len; DataLen += Len;
+    return ValLoc;
+}
+
+void TInMemChunk::Compact() {
+    // only when garbage takes more than half of the pages
+    if ((GarbageLen <= PageLen || 2 * GarbageLen <= DataLen)) { return; }
+    TVec<PMem> OldPageV = PageV;
+    PageV.Clr(); LastPageFree = 0; DataLen = 0; GarbageLen = 0;
+    for (int64 ValN = 0; ValN < ValLocV.Len(); ValN++) {
+        const TValLoc& ValLoc = ValLocV[ValN];
+        if (ValLoc.Len == 0) { continue; }
+        ValLocV[ValN] = PutBf(OldPageV[ValLoc.PageN]->GetBf() + ValLoc.Offset, ValLoc.Len);
+    }
+}
+
+void TInMemChunk::Save(const TStr& FNm) {
+    TFOut FOut(FNm);
+    FOut.Save(ValLocV.Len());
+    // offsets
+    uint64 Offset = 0; TUInt64(Offset).Save(FOut);
+    for (int64 ValN = 0; ValN < ValLocV.Len(); ValN++) {
+        Offset += ValLocV[ValN].Len; TUInt64(Offset).Save(FOut);
+    }
+    // data
+    for (int64 ValN = 0; ValN < ValLocV.Len(); ValN++) {
+        const TValLoc& ValLoc = ValLocV[ValN];
+        if (ValLoc.Len > 0) { 
+            FOut.SaveBf(PageV[ValLoc.PageN]->GetBf() + ValLoc.Offset, ValLoc.Len); }
+    }
+    DirtyP = false;
+}
+
+void TInMemChunk::GetVal(const int64& ValN, TMem& Val) const {
+    const char* Bf; int Len;
+    if (IsMMap()) {
+        const uint64 Offset = MMapOffsetV[ValN];
+        Bf = MMapDataBf + Offset; Len = int(MMapOffsetV[ValN + 1] - Offset);
+    } else {
+        const TValLoc& ValLoc = ValLocV[ValN];
+        Bf = (ValLoc.Len > 0) ? PageV[ValLoc.PageN]->GetBf() + ValLoc.Offset : NULL;
+        Len = ValLoc.Len;
+    }
+    Val.Clr(false); if (Len > 0) { Val.AddBf(Bf, Len); }
+}
+
+TThinMem TInMemChunk::GetThinVal(const int64& ValN) const {
+    if (IsMMap()) {
+        const uint64 Offset = MMapOffsetV[ValN];
+        return TThinMem(MMapDataBf + Offset, int(MMapOffsetV[ValN + 1] - Offset));
+    }
+    const TValLoc& ValLoc = ValLocV[ValN];
+    if (ValLoc.Len == 0) { return TThinMem(); }
+    return TThinMem(PageV[ValLoc.PageN]->GetBf() + ValLoc.Offset, ValLoc.Len);
+}
+
+void TInMemChunk::AddVal(const TMem& Val) {
+    ValLocV.Add(PutBf(Val.GetBf(), Val.Len()));
+    DirtyP = true;
+}
+
+void TInMemChunk::SetVal(const int64& ValN, const TMem& Val) {
+    TValLoc& ValLoc = ValLocV[ValN];
+    if (Val.Len() <= ValLoc.Len) {
+        // fits into old place, rest of it becomes garbage
+        if (Val.Len() > 0) {
+            memcpy(PageV[ValLoc.PageN]->GetBf() + ValLoc.Offset, Val.GetBf(), Val.Len()); }
+        GarbageLen += ValLoc.Len - Val.Len(); ValLoc.Len = Val.Len();
+    } else {
+        FreeVal(ValLoc); ValLoc = PutBf(Val.GetBf(), Val.Len());
+    }
+    DirtyP = true;
+    Compact();
+}
+
+void TInMemChunk::DelVal(const int64& ValN) {
+    if (IsMMap()) { return; }
+    FreeVal(ValLocV[ValN]); ValLocV[ValN] = TValLoc();
+    Compact();
+}
+
 ///////////////////////////////
 // In-memory storage
 TInMemStorage::TInMemStorage(const TStr& _FNm): FNm(_FNm), Access(faCreate) { }
 
 TInMemStorage::TInMemStorage(const TStr& _FNm, const TFAccess& _Access): 
-        FNm(_FNm), Access(_Access) {
-    
-	// load vector
-	TFIn FIn(FNm); ValV.Load(FIn);
-	// load rest
-	FirstValOffset.Load(FIn);
-}
+        FNm(_FNm), Access(_Access) { Load(); }
 
 TInMemStorage::~TInMemStorage() {
-	if (Access != faRdOnly) {
-		// save vector
-		TFOut FOut(FNm); ValV.Save(FOut);
-		// save rest
-		FirstValOffset.Save(FOut);
+	if ((Access != faRdOnly) && !CheckpointP) { Save(); }
+}
+
+void TInMemStorage::Load() {
+	TFIn FIn(FNm);
+	int64 Tag; FIn.Load(Tag);
+	if (Tag != ChunkTag) { LoadFlat(FIn, Tag); return; }
+	// header
+	FirstValOffset.Load(FIn); NextValId.Load(FIn); FirstChunkN.Load(FIn);
+	// chunks, read-only ones are mapped
+	const uint64 EndChunkN = (NextValId + ChunkLen - 1) / ChunkLen;
+	for (uint64 ChunkN = FirstChunkN; ChunkN < EndChunkN; ChunkN++) {
+		ChunkV.Add(TInMemChunk::Load(GetChunkFNm(ChunkN), IsReadOnly()));
+	}
+	// release values deleted after the first chunk was saved
+	for (uint64 ValId = FirstChunkN * ChunkLen; ValId < FirstValOffset; ValId++) {
+		GetChunk(ValId)->DelVal(ValId % ChunkLen);
+	}
+}
+
+void TInMemStorage::LoadFlat(TSIn& SIn, const int64& Tag) {
+	// load all values
+	TVec<TMem, int64> ValV;
+	if (Tag == FlatTag) {
+		// header, offsets, data
+		int64 Vals; FirstValOffset.Load(SIn); SIn.Load(Vals);
+		TVec<TUInt64, int64> OffsetV(Vals + 1, 0);
+		for (int64 ValN = 0; ValN <= Vals; ValN++) { OffsetV.Add(TUInt64(SIn)); }
+		ValV.Gen(Vals, 0);
+		for (int64 ValN = 0; ValN < Vals; ValN++) {
+			const int ValLen = int(OffsetV[ValN + 1] - OffsetV[ValN]);
+			TMem Val(ValLen); Val.Gen(ValLen); SIn.GetBf(Val.GetBf(), ValLen);
+			ValV.Add(Val);
+		}
+	} else {
+		// vector followed by offset, tag was vector capacity
+		int64 Vals; SIn.Load(Vals); ValV.Gen(Vals, 0);
+		for (int64 ValN = 0; ValN < Vals; ValN++) { ValV.Add(TMem(SIn)); }
+		FirstValOffset.Load(SIn);
+	}
+	// split into chunks, the first one is padded up to the first value;
+	// chunks are filled directly, since AddVal refuses read-only storage
+	FirstChunkN = FirstValOffset / ChunkLen;
+	NextValId = FirstChunkN * ChunkLen;
+	const uint64 EndValId = FirstValOffset + ValV.Len();
+	for (; NextValId < EndValId; NextValId++) {
+		if (NextValId % ChunkLen == 0) { ChunkV.Add(TInMemChunk::New()); }
+		if (NextValId < FirstValOffset) { ChunkV.Last()->AddVal(TMem()); }
+		else { ChunkV.Last()->AddVal(ValV[int64(NextValId - FirstValOffset)]); }
 	}
 }
 
+void TInMemStorage::Save() {
+	// changed chunks
+	for (int64 ChunkN = 0; ChunkN < ChunkV.Len(); ChunkN++) {
+		if (ChunkV[ChunkN]->IsDirty()) { 
+			ChunkV[ChunkN]->Save(GetChunkFNm(FirstChunkN + ChunkN)); }
+	}
+	// header
+	SaveHeader(FNm);
+	// dropped chunks are no longer referenced from the header
+	for (int DelChunkN = 0; DelChunkN < DelChunkNV.Len(); DelChunkN++) {
+		TFile::Del(GetChunkFNm(DelChunkNV[DelChunkN]), false);
+	}
+	DelChunkNV.Clr();
+}
+
+void TInMemStorage::SaveHeader(const TStr& HeaderFNm) const {
+	TFOut FOut(HeaderFNm);
+	FOut.Save(int64(ChunkTag));
+	FirstValOffset.Save(FOut); NextValId.Save(FOut); FirstChunkN.Save(FOut);
+}
+
+void TInMemStorage::Checkpoint(TFCommit& Commit) {
+	AssertReadOnly();
+	// same as save, new files replace old ones when commit is applied
+	for (int64 ChunkN = 0; ChunkN < ChunkV.Len(); ChunkN++) {
+		if (ChunkV[ChunkN]->IsDirty()) { 
+			ChunkV[ChunkN]->Save(Commit.AddFNm(GetChunkFNm(FirstChunkN + ChunkN))); }
+	}
+	SaveHeader(Commit.AddFNm(FNm));
+	for (int DelChunkN = 0; DelChunkN < DelChunkNV.Len(); DelChunkN++) {
+		Commit.DelFNm(GetChunkFNm(DelChunkNV[DelChunkN]));
+	}
+	DelChunkNV.Clr();
+	CheckpointP = true;
+}
+
 void TInMemStorage::AssertReadOnly() const {
-	QmAssertR(((Access == faCreate) || (Access == faUpdate)), FNm + " opened in Read-Only mode!");
+	QmAssertR(((Access==faCreate)||(Access==faUpdate)), FNm + " opened in Read-Only mode!");
 }
 
 bool TInMemStorage::IsValId(const uint64& ValId) const {
-	return (ValId >= FirstValOffset.Val) &&
-        (ValId < FirstValOffset.Val + ValV.Len());
+	return (ValId >= FirstValOffset.Val) && (ValId < NextValId.Val);
 }
 
 void TInMemStorage::GetVal(const uint64& ValId, TMem& Val) const {
-	Val = ValV[ValId - FirstValOffset];
+	GetChunk(ValId)->GetVal(ValId % ChunkLen, Val);
+}
+
+TThinMem TInMemStorage::GetThinVal(const uint64& ValId) const {
+	return GetChunk(ValId)->GetThinVal(ValId % ChunkLen);
 }
 
 uint64 TInMemStorage::AddVal(const TMem& Val) {
-	return ValV.Add(Val) + FirstValOffset;
+	// mapped chunks can not be extended
+	QmAssertR(!IsReadOnly(), FNm + " opened in Read-Only mode!");
+	// start new chunk when the last one is full
+	if (NextValId % ChunkLen == 0) { ChunkV.Add(TInMemChunk::New()); }
+	ChunkV.Last()->AddVal(Val);
+	return NextValId++;
 }
 
 void TInMemStorage::SetVal(const uint64& ValId, const TMem& Val) {
 	AssertReadOnly();
-    ValV[ValId - FirstValOffset] = Val;
+    GetChunk(ValId)->SetVal(ValId % ChunkLen, Val);
 }
 
 void TInMemStorage::DelVals(int Vals) {
 	if (Vals > 0) {
-		ValV.Del(0, Vals - 1);
+		// release deleted values
+		for (int ValN = 0; ValN < Vals; ValN++) {
+			const uint64 ValId = FirstValOffset + ValN;
+			GetChunk(ValId)->DelVal(ValId % ChunkLen);
+		}
 		FirstValOffset += Vals;
+		// drop chunks with all values deleted
+		int64 DelChunks = 0;
+		while ((FirstChunkN + DelChunks + 1) * ChunkLen <= FirstValOffset) {
+			DelChunkNV.Add(FirstChunkN + DelChunks); DelChunks++; }
+		if (DelChunks > 0) {
+			ChunkV.Del(0, DelChunks - 1);
+			FirstChunkN += DelChunks;
+		}
 	}
 }
 
 uint64 TInMemStorage::Len() const {
-	return ValV.Len();
+	return NextValId - FirstValOffset;
 }
 
 uint64 TInMemStorage::GetFirstValId() const {
@@ -475,7 +691,7 @@ uint64 TInMemStorage::GetFirstValId() const {
 }
 
 uint64 TInMemStorage::GetLastValId() const {
-	return GetFirstValId() + ValV.Len() - 1;
+	return GetFirstValId() + Len() - 1;
 }
 
 ///////////////////////////////
@@ -506,7 +722,7 @@ void TRecSerializator::TFieldSerialDesc::Load(TSIn& SIn) {
 
 ///////////////////////////////
 /// Thin Input-Memory used within TStoreSerializator
-TRecSerializator::TThinMIn::TThinMIn(const TMem& Mem):
+TRecSerializator::TThinMIn::TThinMIn(const TThinMem& Mem):
         TSBase("Thin input memory"), TSIn("Thin input memory"), Bf(NULL), BfC(0), BfL(0) {
 
     Bf = (uchar*)Mem.GetBf();
@@ -550,7 +766,7 @@ bool TRecSerializator::TThinMIn::GetNextLnBf(TChA& LnChA) {
 
 ///////////////////////////////
 // Serialization and de-serialization of records to TMem
-TStr TRecSerializator::GetErrorMsg(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const {
+TStr TRecSerializator::GetErrorMsg(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const {
     return TStr::Fmt("FPO:%d VIPO:%d VCPO:%d|L:%d|FID:%d NMP:%d NMM:%d FP:%s O:%d",
         FixedPartOffset.Val, VarIndexPartOffset.Val, VarContentPartOffset.Val,
         RecMem.Len(), FieldSerialDesc.FieldId.Val, (int)FieldSerialDesc.NullMapByte.Val,
@@ -564,7 +780,7 @@ const TRecSerializator::TFieldSerialDesc& TRecSerializator::GetFieldSerialDesc(c
     return FieldSerialDescV[FieldIdToSerialDescIdH.GetDat(FieldId)];
 }
 
-uchar* TRecSerializator::GetLocationFixed(const TMem& RecMem,
+uchar* TRecSerializator::GetLocationFixed(const TThinMem& RecMem,
         const TFieldSerialDesc& FieldSerialDesc) const {
 
     uchar* bf = (uchar*)RecMem.GetBf() + FixedPartOffset + FieldSerialDesc.Offset;
@@ -572,7 +788,7 @@ uchar* TRecSerializator::GetLocationFixed(const TMem& RecMem,
     return bf;
 }
 
-int TRecSerializator::GetOffsetVar(const TMem& RecMem,
+int TRecSerializator::GetOffsetVar(const TThinMem& RecMem,
         const TFieldSerialDesc& FieldSerialDesc) const {
 
     uchar* bf = (uchar*)RecMem.GetBf();
@@ -581,7 +797,7 @@ int TRecSerializator::GetOffsetVar(const TMem& RecMem,
     return VarContentPartOffset + Offset;
 }
 
-uchar* TRecSerializator::GetLocationVar(const TMem& RecMem,
+uchar* TRecSerializator::GetLocationVar(const TThinMem& RecMem,
         const TFieldSerialDesc& FieldSerialDesc) const {
 
     uchar* bf = (uchar*)RecMem.GetBf();
@@ -591,7 +807,7 @@ uchar* TRecSerializator::GetLocationVar(const TMem& RecMem,
     return bf2;
 }
 
-int TRecSerializator::GetVarPartBfLen(const TMem& RecMem,
+int TRecSerializator::GetVarPartBfLen(const TThinMem& RecMem,
         const TFieldSerialDesc& FieldSerialDesc) {
 
     uchar* bf = (uchar*)RecMem.GetBf();
@@ -969,6 +1185,31 @@ void TRecSerializator::Save(TSOut& SOut) {
     CodebookH.Save(SOut);
 }
 
+void TRecSerializator::SaveCodebookDelta(TSOut& SOut, const int& CodebookLen) const {
+    TInt(CodebookH.Len() - CodebookLen).Save(SOut);
+    for (int StrId = CodebookLen; StrId < CodebookH.Len(); StrId++) {
+        TStr(CodebookH.GetKey(StrId)).Save(SOut);
+    }
+}
+
+int TRecSerializator::LoadCodebookDelta(TSIn& SIn) {
+    const TInt Strs(SIn);
+    for (int StrN = 0; StrN < Strs; StrN++) {
+        const TStr Str(SIn); const int CodebookLen = CodebookH.Len();
+        // strings keep their ids, which records refer to
+        QmAssertR(CodebookH.AddKey(Str) == CodebookLen, "Codebook delta does not match the snapshot");
+    }
+    return Strs;
+}
+
+bool TRecSerializator::IsThreadSafe() const {
+	for (int FieldSerialDescId = 0; FieldSerialDescId < FieldSerialDescV.Len(); FieldSerialDescId++) {
+		const TFieldSerialDesc& FieldSerialDesc = FieldSerialDescV[FieldSerialDescId];
+		if (FieldSerialDesc.CodebookP || !FieldSerialDesc.DefaultVal.Empty()) { return false; }
+	}
+	return true;
+}
+
 void TRecSerializator::Serialize(const PJsonVal& RecVal, TMem& RecMem, const TWPt<TStore>& Store) {
 	// Reserve fixed space - null map, fixed fields and var-field indexes
 	TMem FixedMem(VarContentPartOffset);
@@ -1030,6 +1271,193 @@ void TRecSerializator::Serialize(const PJsonVal& RecVal, TMem& RecMem, const TWP
     Merge(FixedMem, VarSOut, RecMem);
 }
 
+void TRecSerializator::StartPartRec(TPartRec& PartRec) const {
+    // fixed part starts with zeros, same as in Serialize
+    PartRec.FixedMem.GenZeros(VarContentPartOffset);
+    PartRec.VarSOut.Clr();
+    PartRec.VarPosV.Gen(FieldSerialDescV.Len());
+    PartRec.FieldSetV.Gen(FieldSerialDescV.Len());
+    for (int FieldSerialDescId = 0; FieldSerialDescId < FieldSerialDescV.Len(); FieldSerialDescId++) {
+        PartRec.FieldSetV[FieldSerialDescId] = false;
+    }
+}
+
+void TRecSerializator::SetPartRecFieldJson(TPartRec& PartRec,
+        const TFieldDesc& FieldDesc, TJsonReader& Reader) {
+
+    const int FieldSerialDescId = FieldIdToSerialDescIdH.GetDat(FieldDesc.GetFieldId());
+    const TFieldSerialDesc& FieldSerialDesc = FieldSerialDescV[FieldSerialDescId];
+    const TStr& FieldNm = FieldDesc.GetFieldNm();
+    PartRec.FieldSetV[FieldSerialDescId] = true;
+    // variable-length values are empty until we write them
+    const int VarOffset = PartRec.VarSOut.Len();
+    PartRec.VarPosV[FieldSerialDescId] = TIntPr(VarOffset, 0);
+    if (Reader.IsNull()) {
+        // we are setting field explicitly to null
+        QmAssertR(FieldDesc.IsNullable(), "Non-nullable field " + FieldNm + " set to null");
+        SetFieldNull(PartRec.FixedMem, FieldSerialDesc, true);
+        return;
+    }
+    // field might have already been set to null by a duplicate key
+    SetFieldNull(PartRec.FixedMem, FieldSerialDesc, false);
+    // call type-appropriate setter
+    TMem& FixedMem = PartRec.FixedMem;
+    TMOut& VarSOut = PartRec.VarSOut;
+    switch (FieldDesc.GetFieldType()) {
+        case oftInt:
+            QmAssertR(Reader.IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+            SetFieldInt(FixedMem, FieldSerialDesc, Reader.GetInt());
+            break;
+        case oftUInt64:
+            QmAssertR(Reader.IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+            SetFieldUInt64(FixedMem, FieldSerialDesc, (uint64)Reader.GetInt());
+            break;
+        case oftStr:
+            QmAssertR(Reader.IsStr(), "Provided JSon data field " + FieldNm + " is not string.");
+            if (FieldSerialDesc.FixedPartP) {
+                // this string should be encoded using a codebook
+                SetFieldStr(FixedMem, FieldSerialDesc, TStr(Reader.GetStr()));
+            } else {
+                SetFieldStr(FixedMem, VarSOut, FieldSerialDesc, TStr(Reader.GetStr()));
+            }
+            break;
+        case oftBool:
+            QmAssertR(Reader.IsBool(), "Provided JSon data field " + FieldNm + " is not boolean.");
+            SetFieldBool(FixedMem, FieldSerialDesc, Reader.GetBool());
+            break;
+        case oftFlt:
+            QmAssertR(Reader.IsNum(), "Provided JSon data field " + FieldNm + " is not numeric.");
+            SetFieldFlt(FixedMem, FieldSerialDesc, Reader.GetNum());
+            break;
+        case oftFltPr: {
+            // make sure it's array of length two with numeric elements
+            QmAssertR(Reader.IsArrStart(), "Provided JSon data field " + FieldNm + " is not array.");
+            TFltPr FltPr; int ElN = 0;
+            while (Reader.Next() && !Reader.IsArrEnd()) {
+                QmAssertR(ElN < 2, "Provided JSon data field " + FieldNm + " is not array - expected 2 fields.");
+                QmAssertR(Reader.IsNum(), "Element in the JSon array in data field " + FieldNm + " is not numeric.");
+                if (ElN == 0) { FltPr.Val1 = Reader.GetNum(); } else { FltPr.Val2 = Reader.GetNum(); }
+                ElN++;
+            }
+            QmAssertR(ElN == 2, "Provided JSon data field " + FieldNm + " is not array - expected 2 fields.");
+            SetFieldFltPr(FixedMem, FieldSerialDesc, FltPr);
+            break;
+        }
+        case oftTm: {
+            QmAssertR(Reader.IsStr(), "Provided JSon data field " + FieldNm + " is not string that represents DateTime.");
+            TTm Tm = TTm::GetTmFromWebLogDateTimeStr(TStr(Reader.GetStr()), '-', ':', '.', 'T');
+            SetFieldTm(FixedMem, FieldSerialDesc, Tm);
+            break;
+        }
+        case oftIntV: {
+            QmAssertR(Reader.IsArrStart(), "Provided JSon data field " + FieldNm + " is not array.");
+            TIntV IntV;
+            while (Reader.Next() && !Reader.IsArrEnd()) {
+                QmAssertR(Reader.IsNum(), "Element in the JSon array in data field " + FieldNm + " is not numeric.");
+                IntV.Add(Reader.GetInt());
+            }
+            SetFieldIntV(FixedMem, VarSOut, FieldSerialDesc, IntV);
+            break;
+        }
+        case oftStrV: {
+            QmAssertR(Reader.IsArrStart(), "Provided JSon data field " + FieldNm + " is not array.");
+            TStrV StrV;
+            while (Reader.Next() && !Reader.IsArrEnd()) {
+                QmAssertR(Reader.IsStr(), "Element in the JSon array in data field " + FieldNm + " is not string.");
+                StrV.Add(TStr(Reader.GetStr()));
+            }
+            SetFieldStrV(FixedMem, VarSOut, FieldSerialDesc, StrV);
+            break;
+        }
+        case oftFltV: {
+            QmAssertR(Reader.IsArrStart(), "Provided JSon data field " + FieldNm + " is not array.");
+            TFltV FltV;
+            while (Reader.Next() && !Reader.IsArrEnd()) {
+                QmAssertR(Reader.IsNum(), "Element in the JSon array in data field " + FieldNm + " is not numeric.");
+                FltV.Add(Reader.GetNum());
+            }
+            SetFieldFltV(FixedMem, VarSOut, FieldSerialDesc, FltV);
+            break;
+        }
+        case oftBowSpV:
+            throw TQmExcept::New("Parsing of BowSpV from JSon not yet implemented");
+        case oftNumSpV: {
+            // array of [index, value] pairs
+            QmAssertR(Reader.IsArrStart(), "Provided JSon data field " + FieldNm + " is not array.");
+            TIntFltKdV NumSpV;
+            while (Reader.Next() && !Reader.IsArrEnd()) {
+                QmAssertR(Reader.IsArrStart(), "Element in the JSon array in data field " + FieldNm + " is not array.");
+                QmAssertR(Reader.Next() && Reader.IsNum(), "Sparse vector index in data field " + FieldNm + " is not numeric.");
+                const int Idx = Reader.GetInt();
+                QmAssertR(Reader.Next() && Reader.IsNum(), "Sparse vector value in data field " + FieldNm + " is not numeric.");
+                const double Val = Reader.GetNum();
+                QmAssertR(Reader.Next() && Reader.IsArrEnd(), "Sparse vector element in data field " + FieldNm + " is not a pair.");
+                NumSpV.Add(TIntFltKd(Idx, Val));
+            }
+            NumSpV.Sort();
+            SetFieldNumSpV(FixedMem, VarSOut, FieldSerialDesc, NumSpV);
+            break;
+        }
+        default:
+            throw TQmExcept::New("Unsupported JSon data type for DB storage - " + FieldDesc.GetFieldTypeStr());
+    }
+    // remember length of the variable-length value
+    if (!FieldSerialDesc.FixedPartP) {
+        PartRec.VarPosV[FieldSerialDescId].Val2 = PartRec.VarSOut.Len() - VarOffset;
+    }
+}
+
+void TRecSerializator::SetPartRecFieldTm(TPartRec& PartRec, const int& FieldId, const TTm& Tm) {
+    const int FieldSerialDescId = FieldIdToSerialDescIdH.GetDat(FieldId);
+    const TFieldSerialDesc& FieldSerialDesc = FieldSerialDescV[FieldSerialDescId];
+    QmAssert(FieldSerialDesc.FixedPartP);
+    PartRec.FieldSetV[FieldSerialDescId] = true;
+    SetFieldNull(PartRec.FixedMem, FieldSerialDesc, false);
+    SetFieldTm(PartRec.FixedMem, FieldSerialDesc, Tm);
+}
+
+void TRecSerializator::EndPartRec(TPartRec& PartRec, TMem& RecMem, const TWPt<TStore>& Store) {
+    // figure out values of fields which were not provided
+    int VarLen = 0;
+    for (int FieldSerialDescId = 0; FieldSerialDescId < FieldSerialDescV.Len(); FieldSerialDescId++) {
+        const TFieldSerialDesc& FieldSerialDesc = FieldSerialDescV[FieldSerialDescId];
+        if (!PartRec.FieldSetV[FieldSerialDescId]) {
+            const TFieldDesc& FieldDesc = Store->GetFieldDesc(FieldSerialDesc.FieldId);
+            const int VarOffset = PartRec.VarSOut.Len();
+            if (!FieldSerialDesc.DefaultVal.Empty()) {
+                // use the provided default value
+                if (FieldSerialDesc.FixedPartP) {
+                    SetFixedJsonVal(PartRec.FixedMem, FieldSerialDesc, FieldDesc, FieldSerialDesc.DefaultVal);
+                } else {
+                    SetVarJsonVal(PartRec.FixedMem, PartRec.VarSOut, FieldSerialDesc, FieldDesc, FieldSerialDesc.DefaultVal);
+                }
+            } else if (FieldDesc.IsNullable()) {
+                // value not provided and object is nullable, so we set it to NULL
+                SetFieldNull(PartRec.FixedMem, FieldSerialDesc, true);
+            } else {
+                // report missing field value since no other option available
+                throw TQmExcept::New("JSon data is missing field - expecting " + FieldDesc.GetFieldNm());
+            }
+            PartRec.VarPosV[FieldSerialDescId] = TIntPr(VarOffset, PartRec.VarSOut.Len() - VarOffset);
+        }
+        if (!FieldSerialDesc.FixedPartP) { VarLen += PartRec.VarPosV[FieldSerialDescId].Val2; }
+    }
+    // copy fixed part and lay out variable-length values in the field order,
+    // same as they would be written by Serialize
+    RecMem.Reserve(VarContentPartOffset + VarLen);
+    RecMem.AddBf(PartRec.FixedMem.GetBf(), VarContentPartOffset);
+    const char* VarBf = PartRec.VarSOut.GetBfAddr();
+    int VarOffset = 0;
+    for (int FieldSerialDescId = 0; FieldSerialDescId < FieldSerialDescV.Len(); FieldSerialDescId++) {
+        const TFieldSerialDesc& FieldSerialDesc = FieldSerialDescV[FieldSerialDescId];
+        if (FieldSerialDesc.FixedPartP) { continue; }
+        const TIntPr& VarPos = PartRec.VarPosV[FieldSerialDescId];
+        SetLocationVar(RecMem, FieldSerialDesc, VarOffset);
+        if (VarPos.Val2 > 0) { RecMem.AddBf(VarBf + VarPos.Val1, VarPos.Val2); }
+        VarOffset += VarPos.Val2;
+    }
+}
+
 void TRecSerializator::SerializeUpdate(const PJsonVal& RecVal, const TMem& InRecMem,
         TMem& OutRecMem, const TWPt<TStore>& Store, TIntSet& ChangedFieldIdSet) {
 
@@ -1079,21 +1507,21 @@ void TRecSerializator::SerializeUpdate(const PJsonVal& RecVal, const TMem& InRec
     Merge(FixedMem, VarSOut, OutRecMem);
 }
 
-bool TRecSerializator::IsFieldNull(const TMem& RecMem, const int& FieldId) const {
+bool TRecSerializator::IsFieldNull(const TThinMem& RecMem, const int& FieldId) const {
 
     const TFieldSerialDesc& FieldSerialDesc = GetFieldSerialDesc(FieldId);
     uchar* bf = (uchar*)RecMem.GetBf() + FieldSerialDesc.NullMapByte;
     return ((*bf & FieldSerialDesc.NullMapMask) != 0);
 }
 
-int TRecSerializator::GetFieldInt(const TMem& RecMem, const int& FieldId) const {
+int TRecSerializator::GetFieldInt(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return *((int*)bf);
 }
 
-void TRecSerializator::GetFieldIntV(const TMem& RecMem, const int& FieldId, TIntV& IntV) const {
+void TRecSerializator::GetFieldIntV(const TThinMem& RecMem, const int& FieldId, TIntV& IntV) const {
     // prepare input stream and move to the variable location
     TThinMIn MIn(RecMem);
     MIn.MoveTo(GetOffsetVar(RecMem, GetFieldSerialDesc(FieldId)));
@@ -1101,14 +1529,14 @@ void TRecSerializator::GetFieldIntV(const TMem& RecMem, const int& FieldId, TInt
     IntV.Load(MIn);
 }
 
-uint64 TRecSerializator::GetFieldUInt64(const TMem& RecMem, const int& FieldId) const {
+uint64 TRecSerializator::GetFieldUInt64(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return *((uint64*)bf);
 }
 
-TStr TRecSerializator::GetFieldStr(const TMem& RecMem, const int& FieldId) const {
+TStr TRecSerializator::GetFieldStr(const TThinMem& RecMem, const int& FieldId) const {
     const TFieldSerialDesc& FieldSerialDesc = GetFieldSerialDesc(FieldId);
     if (FieldSerialDesc.FixedPartP) {
         // get pointer to location
@@ -1127,7 +1555,7 @@ TStr TRecSerializator::GetFieldStr(const TMem& RecMem, const int& FieldId) const
     }
 }
 
-void TRecSerializator::GetFieldStrV(const TMem& RecMem, const int& FieldId, TStrV& StrV) const {
+void TRecSerializator::GetFieldStrV(const TThinMem& RecMem, const int& FieldId, TStrV& StrV) const {
     // prepare input stream and move to the variable location
     TThinMIn MIn(RecMem);
     MIn.MoveTo(GetOffsetVar(RecMem, GetFieldSerialDesc(FieldId)));
@@ -1135,28 +1563,28 @@ void TRecSerializator::GetFieldStrV(const TMem& RecMem, const int& FieldId, TStr
     StrV.Load(MIn);
 }
 
-bool TRecSerializator::GetFieldBool(const TMem& RecMem, const int& FieldId) const {
+bool TRecSerializator::GetFieldBool(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return *((bool*)bf);
 }
 
-double TRecSerializator::GetFieldFlt(const TMem& RecMem, const int& FieldId) const {
+double TRecSerializator::GetFieldFlt(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return *((double*)bf);
 }
 
-TFltPr TRecSerializator::GetFieldFltPr(const TMem& RecMem, const int& FieldId) const {
+TFltPr TRecSerializator::GetFieldFltPr(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return TFltPr(*((double*)bf), *(((double*)bf) + 1));
 }
 
-void TRecSerializator::GetFieldFltV(const TMem& RecMem, const int& FieldId, TFltV& FltV) const {
+void TRecSerializator::GetFieldFltV(const TThinMem& RecMem, const int& FieldId, TFltV& FltV) const {
     // prepare input stream and move to the variable location
     TThinMIn MIn(RecMem);
     MIn.MoveTo(GetOffsetVar(RecMem, GetFieldSerialDesc(FieldId)));
@@ -1164,7 +1592,7 @@ void TRecSerializator::GetFieldFltV(const TMem& RecMem, const int& FieldId, TFlt
     FltV.Load(MIn);
 }
 
-void TRecSerializator::GetFieldTm(const TMem& RecMem, const int& FieldId, TTm& Tm) const {
+void TRecSerializator::GetFieldTm(const TThinMem& RecMem, const int& FieldId, TTm& Tm) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
@@ -1172,14 +1600,14 @@ void TRecSerializator::GetFieldTm(const TMem& RecMem, const int& FieldId, TTm& T
     Tm = TTm::GetTmFromMSecs(val);
 }
 
-uint64 TRecSerializator::GetFieldTmMSecs(const TMem& RecMem, const int& FieldId) const {
+uint64 TRecSerializator::GetFieldTmMSecs(const TThinMem& RecMem, const int& FieldId) const {
     // get pointer to location
     uchar* bf = GetLocationFixed(RecMem, GetFieldSerialDesc(FieldId));
     // cast to return value
     return *((uint64*)bf);
 }
 
-void TRecSerializator::GetFieldNumSpV(const TMem& RecMem, const int& FieldId, TIntFltKdV& SpV) const {
+void TRecSerializator::GetFieldNumSpV(const TThinMem& RecMem, const int& FieldId, TIntFltKdV& SpV) const {
     // prepare input stream and move to the variable location
     TThinMIn MIn(RecMem);
     MIn.MoveTo(GetOffsetVar(RecMem, GetFieldSerialDesc(FieldId)));
@@ -1187,7 +1615,7 @@ void TRecSerializator::GetFieldNumSpV(const TMem& RecMem, const int& FieldId, TI
     SpV.Load(MIn);
 }
 
-void TRecSerializator::GetFieldBowSpV(const TMem& RecMem, const int& FieldId, PBowSpV& SpV) const {
+void TRecSerializator::GetFieldBowSpV(const TThinMem& RecMem, const int& FieldId, PBowSpV& SpV) const {
     // prepare input stream and move to the variable location
     TThinMIn MIn(RecMem);
     MIn.MoveTo(GetOffsetVar(RecMem, GetFieldSerialDesc(FieldId)));
@@ -1195,6 +1623,76 @@ void TRecSerializator::GetFieldBowSpV(const TMem& RecMem, const int& FieldId, PB
     SpV = TBowSpV::Load(MIn);
 }
 
+TStrView TRecSerializator::GetFieldStrView(const TThinMem& RecMem, const int& FieldId) const {
+    const TFieldSerialDesc& FieldSerialDesc = GetFieldSerialDesc(FieldId);
+    if (FieldSerialDesc.FixedPartP) {
+        // codebook keeps the string, so we can point to it
+        const int StrId = *((int*)GetLocationFixed(RecMem, FieldSerialDesc));
+        const char* CStr = CodebookH.GetKey(StrId);
+        return TStrView(CStr, (int)strlen(CStr));
+    } else if (FieldSerialDesc.SmallStringP) {
+        // one byte with length, followed by characters
+        const char* Bf = (const char*)GetLocationVar(RecMem, FieldSerialDesc);
+        return TStrView(Bf + 1, (int)(uchar)Bf[0]);
+    } else {
+        // integer with length, followed by characters
+        const char* Bf = (const char*)GetLocationVar(RecMem, FieldSerialDesc);
+        int BfL; memcpy(&BfL, Bf, sizeof(int));
+        return TStrView(Bf + sizeof(int), BfL);
+    }
+}
+
+TFltVView TRecSerializator::GetFieldFltVView(const TThinMem& RecMem, const int& FieldId) const {
+    // vector capacity and length, followed by values
+    const char* Bf = (const char*)GetLocationVar(RecMem, GetFieldSerialDesc(FieldId));
+    int Vals; memcpy(&Vals, Bf + sizeof(int), sizeof(int));
+    return TFltVView(Bf + 2 * sizeof(int), Vals);
+}
+
+void TRecSerializator::WriteFieldJson(const TThinMem& RecMem, const TFieldDesc& FieldDesc, TJsonWriter& Writer) const {
+    const int FieldId = FieldDesc.GetFieldId();
+    if (FieldDesc.IsInt()) {
+        Writer.PutNum((double)GetFieldInt(RecMem, FieldId));
+    } else if (FieldDesc.IsIntV()) {
+        TIntV FieldIntV; GetFieldIntV(RecMem, FieldId, FieldIntV);
+        Writer.PutArrStart();
+        for (int ValN = 0; ValN < FieldIntV.Len(); ValN++) { Writer.PutNum((double)FieldIntV[ValN]); }
+        Writer.PutArrEnd();
+    } else if (FieldDesc.IsUInt64()) {
+        Writer.PutNum((double)GetFieldUInt64(RecMem, FieldId));
+    } else if (FieldDesc.IsStr()) {
+        const TStrView FieldStr = GetFieldStrView(RecMem, FieldId);
+        Writer.PutStr(FieldStr.GetBf(), FieldStr.Len());
+    } else if (FieldDesc.IsStrV()) {
+        TStrV FieldStrV; GetFieldStrV(RecMem, FieldId, FieldStrV);
+        Writer.PutArrStart();
+        for (int ValN = 0; ValN < FieldStrV.Len(); ValN++) { Writer.PutStr(FieldStrV[ValN]); }
+        Writer.PutArrEnd();
+    } else if (FieldDesc.IsBool()) {
+        Writer.PutBool(GetFieldBool(RecMem, FieldId));
+    } else if (FieldDesc.IsFlt()) {
+        Writer.PutNum(GetFieldFlt(RecMem, FieldId));
+    } else if (FieldDesc.IsFltPr()) {
+        const TFltPr FieldFltPr = GetFieldFltPr(RecMem, FieldId);
+        Writer.PutArrStart(); Writer.PutNum(FieldFltPr.Val1); Writer.PutNum(FieldFltPr.Val2); Writer.PutArrEnd();
+    } else if (FieldDesc.IsFltV()) {
+        const TFltVView FieldFltV = GetFieldFltVView(RecMem, FieldId);
+        Writer.PutArrStart();
+        for (int ValN = 0; ValN < FieldFltV.Len(); ValN++) { Writer.PutNum(FieldFltV[ValN]); }
+        Writer.PutArrEnd();
+    } else if (FieldDesc.IsTm()) {
+        TTm FieldTm; GetFieldTm(RecMem, FieldId, FieldTm);
+        if (FieldTm.IsDef()) { Writer.PutStr(FieldTm.GetWebLogDateTimeStr(true, "T", false)); } else { Writer.PutNull(); }
+    } else if (FieldDesc.IsNumSpV()) {
+        TIntFltKdV FieldIntFltKdV; GetFieldNumSpV(RecMem, FieldId, FieldIntFltKdV);
+        Writer.PutStr(TStrUtil::GetStr(FieldIntFltKdV));
+    } else if (FieldDesc.IsBowSpV()) {
+        Writer.PutStr("[PBowSpV]"); //TODO
+    } else {
+        throw TQmExcept::New("Unsupported field type for JSon output: " + FieldDesc.GetFieldNm());
+    }
+}
+
 void TRecSerializator::SetFieldNull(const TMem& InRecMem, TMem& OutRecMem, const int& FieldId) {
     // different handling for fixed and variable fields
     const TFieldSerialDesc& FieldSerialDesc = GetFieldSerialDesc(FieldId);
@@ -1654,6 +2152,35 @@ void TRecIndexer::UpdateRec(const TMem& OldRecMem, const TMem& NewRecMem,
     }
 }
 
+///////////////////////////////
+/// Field column
+int64 TFieldColumn::GetSetValN(const uint64& RecId) {
+    // first value after column was empty
+    if (Len() == 0) { FirstRecId = RecId; }
+    const int64 ValN = GetValN(RecId);
+    if (ValN == GetVals()) {
+        // value of next record
+        if (FltP) { FltV.Add(0.0); } else { UInt64V.Add(0); }
+    }
+    QmAssertR(IsRecId(RecId), "TFieldColumn: record id out of range");
+    return ValN;
+}
+
+void TFieldColumn::DelVals(const uint64& Vals) {
+    if (Vals >= Len()) { 
+        // nothing left, start over
+        FltV.Clr(); UInt64V.Clr(); FirstValN = 0;
+        return; 
+    }
+    FirstRecId += Vals; FirstValN += Vals;
+    // release memory once more than half of the vector is deleted
+    if (FirstValN > uint64(GetVals() / 2)) {
+        if (FltP) { FltV.Del(0, int64(FirstValN) - 1); FltV.Pack(); }
+        else { UInt64V.Del(0, int64(FirstValN) - 1); UInt64V.Pack(); }
+        FirstValN = 0;
+    }
+}
+
 ///////////////////////////////
 /// Implementation of store which can be initialized from a schema.
 void TStoreImpl::InitFieldLocV() {
@@ -1669,6 +2196,59 @@ void TStoreImpl::InitFieldLocV() {
     }
 }
 
+void TStoreImpl::InitColumns() {
+    ColumnV.Clr(); FieldColumnNV.Gen(GetFields()); FieldColumnNV.PutAll(-1);
+    for (int ColumnN = 0; ColumnN < ColumnFieldIdV.Len(); ColumnN++) {
+        const int FieldId = ColumnFieldIdV[ColumnN];
+        const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+        QmAssertR(FieldDesc.IsInt() || FieldDesc.IsFlt() || FieldDesc.IsUInt64() || FieldDesc.IsTm(),
+            "Column supported only for int, uint64, float and datetime fields: " + FieldDesc.GetFieldNm());
+        ColumnV.Add(TFieldColumn(FieldId, FieldDesc.IsInt() || FieldDesc.IsFlt()));
+        FieldColumnNV[FieldId] = ColumnN;
+    }
+    // empty store has nothing to fill, others are filled on first use
+    ColumnsFilledP = Empty();
+}
+
+void TStoreImpl::FillColumns() const {
+    TSysCsLock Lock(ColumnSection);
+    if (ColumnsFilledP) { return; }
+    PStoreIter Iter = GetIter();
+    while (Iter->Next()) {
+        const uint64 RecId = Iter->GetRecId();
+        for (int ColumnN = 0; ColumnN < ColumnV.Len(); ColumnN++) {
+            ReadColumnVal(ColumnN, RecId);
+        }
+    }
+    ColumnsFilledP = true;
+}
+
+void TStoreImpl::ReadColumnVal(const int& ColumnN, const uint64& RecId) const {
+    TFieldColumn& Column = ColumnV[ColumnN];
+    const int FieldId = Column.GetFieldId();
+    const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+    if (FieldDesc.IsInt()) {
+        Column.SetFlt(RecId, (double)GetFieldInt(RecId, FieldId));
+    } else if (FieldDesc.IsFlt()) {
+        Column.SetFlt(RecId, GetFieldFlt(RecId, FieldId));
+    } else if (FieldDesc.IsUInt64()) {
+        Column.SetUInt64(RecId, GetFieldUInt64(RecId, FieldId));
+    } else {
+        Column.SetUInt64(RecId, GetFieldTmMSecs(RecId, FieldId));
+    }
+}
+
+void TStoreImpl::SetColumnVal(const int& ColumnN, const uint64& RecId) {
+    if (ColumnsFilledP) { ReadColumnVal(ColumnN, RecId); }
+}
+
+void TStoreImpl::SetColumnVals(const uint64& RecId) {
+    if (!ColumnsFilledP) { return; }
+    for (int ColumnN = 0; ColumnN < ColumnV.Len(); ColumnN++) {
+        SetColumnVal(ColumnN, RecId);
+    }
+}
+
 void TStoreImpl::GetRecMem(const TStoreLoc& RecLoc, const uint64& RecId, TMem& Rec) const {
     if (RecLoc == slDisk) {
         DataCache.GetVal(RecId, Rec);
@@ -1683,6 +2263,12 @@ void TStoreImpl::GetRecMem(const uint64& RecId, const int& FieldId, TMem& Rec) c
     GetRecMem(FieldLocV[FieldId], RecId, Rec);
 }
 
+TThinMem TStoreImpl::GetRecThinMem(const uint64& RecId, const int& FieldId, TMem& RecMem) const {
+    if (FieldLocV[FieldId] == slMemory) { return DataMem.GetThinVal(RecId); }
+    GetRecMem(FieldLocV[FieldId], RecId, RecMem);
+    return RecMem;
+}
+
 void TStoreImpl::PutRecMem(const TStoreLoc& RecLoc, const uint64& RecId, const TMem& Rec) {
     if (RecLoc == slDisk) {
         DataCache.SetVal(RecId, Rec);
@@ -1721,34 +2307,71 @@ const TRecSerializator& TStoreImpl::GetFieldSerializator(const int &FieldId) con
     return GetSerializator(FieldLocV[FieldId]);
 }
 
+template <class TKey> 
+void TStoreImpl::AddPrimaryDelta(const TKey& Key, const uint64& RecId) {
+    // changes are tracked after the first checkpoint saved the whole map
+    if (!CheckpointP) { return; }
+    Key.Save(PrimaryDeltaMOut); TUInt64(RecId).Save(PrimaryDeltaMOut);
+    PrimaryDeltaOps++;
+}
+
+template <class TKey> 
+uint64 TStoreImpl::LoadPrimaryDelta(TSIn& SIn, THash<TKey, TUInt64>& PrimaryIdH) {
+    uint64 Ops = 0;
+    while (!SIn.Eof()) {
+        TKey Key(SIn); TUInt64 RecId(SIn);
+        if (RecId == TUInt64::Mx) { PrimaryIdH.DelIfKey(Key); } else { PrimaryIdH.AddDat(Key, RecId); }
+        Ops++;
+    }
+    return Ops;
+}
+
 void TStoreImpl::SetPrimaryField(const uint64& RecId) {
     if (PrimaryFieldType == oftStr) {
-        PrimaryStrIdH.AddDat(GetFieldStr(RecId, PrimaryFieldId)) = RecId;
+        const TStr Key = GetFieldStr(RecId, PrimaryFieldId);
+        PrimaryStrIdH.AddDat(Key) = RecId; AddPrimaryDelta(Key, RecId);
     } else if (PrimaryFieldType == oftInt) {
-        PrimaryIntIdH.AddDat(GetFieldInt(RecId, PrimaryFieldId)) = RecId;
+        const TInt Key = GetFieldInt(RecId, PrimaryFieldId);
+        PrimaryIntIdH.AddDat(Key) = RecId; AddPrimaryDelta(Key, RecId);
     } else if (PrimaryFieldType == oftUInt64) {
-        PrimaryUInt64IdH.AddDat(GetFieldUInt64(RecId, PrimaryFieldId)) = RecId;
+        const TUInt64 Key = GetFieldUInt64(RecId, PrimaryFieldId);
+        PrimaryUInt64IdH.AddDat(Key) = RecId; AddPrimaryDelta(Key, RecId);
     } else if (PrimaryFieldType == oftFlt) {
-        PrimaryFltIdH.AddDat(GetFieldFlt(RecId, PrimaryFieldId)) = RecId;
+        const TFlt Key = GetFieldFlt(RecId, PrimaryFieldId);
+        PrimaryFltIdH.AddDat(Key) = RecId; AddPrimaryDelta(Key, RecId);
     } else if (PrimaryFieldType == oftTm) {
-        PrimaryTmMSecsIdH.AddDat(GetFieldTmMSecs(RecId, PrimaryFieldId)) = RecId;
+        const TUInt64 Key = GetFieldTmMSecs(RecId, PrimaryFieldId);
+        PrimaryTmMSecsIdH.AddDat(Key) = RecId; AddPrimaryDelta(Key, RecId);
     }
 }
 
 void TStoreImpl::DelPrimaryField(const uint64& RecId) {
     if (PrimaryFieldType == oftStr) {
-        PrimaryStrIdH.DelIfKey(GetFieldStr(RecId, PrimaryFieldId));
+        const TStr Key = GetFieldStr(RecId, PrimaryFieldId);
+        PrimaryStrIdH.DelIfKey(Key); AddPrimaryDelta(Key, TUInt64::Mx);
     } else if (PrimaryFieldType == oftInt) {
-        PrimaryIntIdH.DelIfKey(GetFieldInt(RecId, PrimaryFieldId));
+        const TInt Key = GetFieldInt(RecId, PrimaryFieldId);
+        PrimaryIntIdH.DelIfKey(Key); AddPrimaryDelta(Key, TUInt64::Mx);
     } else if (PrimaryFieldType == oftUInt64) {
-        PrimaryUInt64IdH.DelIfKey(GetFieldUInt64(RecId, PrimaryFieldId));
+        const TUInt64 Key = GetFieldUInt64(RecId, PrimaryFieldId);
+        PrimaryUInt64IdH.DelIfKey(Key); AddPrimaryDelta(Key, TUInt64::Mx);
     } else if (PrimaryFieldType == oftFlt) {
-        PrimaryFltIdH.DelIfKey(GetFieldFlt(RecId, PrimaryFieldId));
+        const TFlt Key = GetFieldFlt(RecId, PrimaryFieldId);
+        PrimaryFltIdH.DelIfKey(Key); AddPrimaryDelta(Key, TUInt64::Mx);
     } else if (PrimaryFieldType == oftTm) {
-        PrimaryTmMSecsIdH.DelIfKey(GetFieldTmMSecs(RecId, PrimaryFieldId));
+        const TUInt64 Key = GetFieldTmMSecs(RecId, PrimaryFieldId);
+        PrimaryTmMSecsIdH.DelIfKey(Key); AddPrimaryDelta(Key, TUInt64::Mx);
     }    
 }
 
+int TStoreImpl::GetPrimaryKeys() const {
+    if (PrimaryFieldType == oftInt) { return PrimaryIntIdH.Len(); }
+    if (PrimaryFieldType == oftUInt64) { return PrimaryUInt64IdH.Len(); }
+    if (PrimaryFieldType == oftFlt) { return PrimaryFltIdH.Len(); }
+    if (PrimaryFieldType == oftTm) { return PrimaryTmMSecsIdH.Len(); }
+    return PrimaryStrIdH.Len();
+}
+
 void TStoreImpl::InitFromSchema(const TStoreSchema& StoreSchema) {
     // at start there is no primary key
 	RecNmFieldP = false;
@@ -1790,6 +2413,13 @@ void TStoreImpl::InitFromSchema(const TStoreSchema& StoreSchema) {
     RecIndexer = TRecIndexer(GetIndex(), this);
     // remember window parameters
 	WndDesc =  StoreSchema.WndDesc;
+    // remember fields with columns
+    for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
+        const TStr& FieldNm = GetFieldNm(FieldId);
+        if (StoreSchema.FieldExH.IsKey(FieldNm) && StoreSchema.FieldExH.GetDat(FieldNm).ColumnP) {
+            ColumnFieldIdV.Add(FieldId);
+        }
+    }
 }
 
 void TStoreImpl::InitDataFlags() {
@@ -1808,19 +2438,25 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const uint& StoreId,
     const TStr& StoreName, const TStoreSchema& StoreSchema, const TStr& _StoreFNm, 
     const int64& _MxCacheSize): 
         TStore(Base, StoreId, StoreName), StoreFNm(_StoreFNm), FAccess(faCreate), 
-        DataCache(_StoreFNm + ".Cache", _MxCacheSize, 1024), DataMem(_StoreFNm + ".MemCache") {
+        PrimaryDelta(_StoreFNm + ".GenericStore"), DataCache(_StoreFNm + ".Cache", _MxCacheSize, 1024),
+        DataMem(_StoreFNm + ".MemCache") {
 
+    // remove deltas left by a previous store with the same name
+    PrimaryDelta.DelDeltas();
     InitFromSchema(StoreSchema);
     // initialize data storage flags
     InitDataFlags();    
+    // initialize columns
+    InitColumns();
 }
 
 TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm, 
     const TFAccess& _FAccess, const int64& _MxCacheSize): 
         TStore(Base, _StoreFNm + ".BaseStore"), 
         StoreFNm(_StoreFNm), FAccess(_FAccess), PrimaryFieldType(oftUndef),
+        PrimaryDelta(_StoreFNm + ".GenericStore"), 
         DataCache(_StoreFNm + ".Cache", _FAccess, _MxCacheSize), 
-        DataMem(_StoreFNm + ".MemCache", _FAccess)  {
+        DataMem(_StoreFNm + ".MemCache", _FAccess) {
 
     // load members
 	TFIn FIn(StoreFNm + ".GenericStore");
@@ -1851,6 +2487,28 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm,
     // load data
 	SerializatorCache.Load(FIn);
 	SerializatorMem.Load(FIn);
+    // load fields with columns (not present in older stores)
+    if (!FIn.Eof()) { ColumnFieldIdV.Load(FIn); }
+    // apply codebook and primary field map changes saved by checkpoints
+    for (int DeltaN = 0; DeltaN < PrimaryDelta.GetDeltas(); DeltaN++) {
+        TFIn DeltaFIn(PrimaryDelta.GetDeltaFNm(DeltaN)); uint64 Ops = 0;
+        Ops += SerializatorCache.LoadCodebookDelta(DeltaFIn);
+        Ops += SerializatorMem.LoadCodebookDelta(DeltaFIn);
+        if (PrimaryFieldType == oftInt) {
+            Ops += LoadPrimaryDelta(DeltaFIn, PrimaryIntIdH);
+        } else if (PrimaryFieldType == oftUInt64) {
+            Ops += LoadPrimaryDelta(DeltaFIn, PrimaryUInt64IdH);
+        } else if (PrimaryFieldType == oftFlt) {
+            Ops += LoadPrimaryDelta(DeltaFIn, PrimaryFltIdH);
+        } else if (PrimaryFieldType == oftTm) {
+            Ops += LoadPrimaryDelta(DeltaFIn, PrimaryTmMSecsIdH);
+        } else {
+            Ops += LoadPrimaryDelta(DeltaFIn, PrimaryStrIdH);
+        }
+        PrimaryDelta.AddDeltaItems(Ops);
+    }
+    SavedCacheCodebookLen = SerializatorCache.GetCodebookLen();
+    SavedMemCodebookLen = SerializatorMem.GetCodebookLen();
     
     // initialize field to storage location map
     InitFieldLocV();
@@ -1859,41 +2517,85 @@ TStoreImpl::TStoreImpl(const TWPt<TBase>& Base, const TStr& _StoreFNm,
     
     // initialize data storage flags
     InitDataFlags();    
+    // initialize columns, filled from stored records on first use
+    InitColumns();
 }
 
 TStoreImpl::~TStoreImpl() {
 	// save if necessary
-	if (FAccess != faRdOnly) {
+	if (FAccess != faRdOnly && !CheckpointP) {
 		TEnv::Logger->OnStatus(TStr::Fmt("Saving store '%s'...", GetStoreNm().CStr()));
 		// save base store
         TFOut BaseFOut(StoreFNm + ".BaseStore");
         SaveStore(BaseFOut);
 		// save store parameters
-		TFOut FOut(StoreFNm + ".GenericStore");
-        // save parameters about primary field
-		RecNmFieldP.Save(FOut);
-		PrimaryFieldId.Save(FOut);
-        if (PrimaryFieldType == oftInt) {
-            PrimaryIntIdH.Save(FOut);
-        } else if (PrimaryFieldType == oftUInt64) {
-            PrimaryUInt64IdH.Save(FOut);
-        } else if (PrimaryFieldType == oftFlt) {
-            PrimaryFltIdH.Save(FOut);
-        } else if (PrimaryFieldType == oftTm) {
-            PrimaryTmMSecsIdH.Save(FOut);
-        } else {
-            PrimaryStrIdH.Save(FOut);
-        }
-        // save time window
-		WndDesc.Save(FOut);
-        // save data
-		SerializatorCache.Save(FOut);
-		SerializatorMem.Save(FOut);
+		{ TFOut FOut(StoreFNm + ".GenericStore"); SaveGeneric(FOut); }
+        PrimaryDelta.DelDeltas();
 	} else {
 		TEnv::Logger->OnStatus("No saving of generic store " + GetStoreNm() + " neccessary!");
 	}
 }
 
+void TStoreImpl::SaveGeneric(TSOut& SOut) {
+    // save parameters about primary field
+    RecNmFieldP.Save(SOut);
+    PrimaryFieldId.Save(SOut);
+    if (PrimaryFieldType == oftInt) {
+        PrimaryIntIdH.Save(SOut);
+    } else if (PrimaryFieldType == oftUInt64) {
+        PrimaryUInt64IdH.Save(SOut);
+    } else if (PrimaryFieldType == oftFlt) {
+        PrimaryFltIdH.Save(SOut);
+    } else if (PrimaryFieldType == oftTm) {
+        PrimaryTmMSecsIdH.Save(SOut);
+    } else {
+        PrimaryStrIdH.Save(SOut);
+    }
+    // save time window
+    WndDesc.Save(SOut);
+    // save data
+    SerializatorCache.Save(SOut);
+    SerializatorMem.Save(SOut);
+    // save fields with columns
+    ColumnFieldIdV.Save(SOut);
+}
+
+void TStoreImpl::Checkpoint(TFCommit& Commit) {
+    QmAssertR(FAccess != faRdOnly, "Checkpoint of read-only store " + GetStoreNm());
+    // store parameters, codebooks and primary field map are saved whole at the 
+    // first checkpoint and when their deltas get long, otherwise only new codebook
+    // strings and primary field map changes
+    { TFOut BaseFOut(Commit.AddFNm(StoreFNm + ".BaseStore")); SaveStore(BaseFOut); }
+    CommitCacheCodebookLen = SerializatorCache.GetCodebookLen();
+    CommitMemCodebookLen = SerializatorMem.GetCodebookLen();
+    const int CodebookStrs = (CommitCacheCodebookLen - SavedCacheCodebookLen) + 
+        (CommitMemCodebookLen - SavedMemCodebookLen);
+    if (!CheckpointP || PrimaryDelta.IsSnapshotDue(GetPrimaryKeys() + CommitCacheCodebookLen + CommitMemCodebookLen)) {
+        TFOut FOut(PrimaryDelta.AddSnapshot(Commit)); SaveGeneric(FOut);
+    } else if (CodebookStrs > 0 || PrimaryDeltaOps > 0) {
+        TFOut FOut(PrimaryDelta.AddDelta(Commit, CodebookStrs + PrimaryDeltaOps));
+        SerializatorCache.SaveCodebookDelta(FOut, SavedCacheCodebookLen);
+        SerializatorMem.SaveCodebookDelta(FOut, SavedMemCodebookLen);
+        FOut.SaveBf(PrimaryDeltaMOut.GetBfAddr(), PrimaryDeltaMOut.Len());
+    }
+    // records, both storages are always opened together
+    DataCache.Checkpoint(Commit);
+    DataMem.Checkpoint(Commit);
+    // from now on store is saved only by checkpoints
+    CheckpointP = true;
+}
+
+void TStoreImpl::OnCommit() {
+    DataCache.OnCommit();
+    PrimaryDelta.OnCommit(); PrimaryDeltaMOut.Clr(); PrimaryDeltaOps = 0;
+    SavedCacheCodebookLen = CommitCacheCodebookLen;
+    SavedMemCodebookLen = CommitMemCodebookLen;
+}
+
+void TStoreImpl::OnSetField(const TWalOp& WalOp, const uint64& RecId, const int& FieldId) {
+    if (WalOp.IsLog()) { WalOp.GetWal().SetField(this, WalOp.GetOpMSecs(), RecId, FieldId); }
+}
+
 bool TStoreImpl::IsRecId(const uint64& RecId) const { 
     return DataMemP ? DataMem.IsValId(RecId) : DataCache.IsValId(RecId); 
 }
@@ -1941,79 +2643,59 @@ PStoreIter TStoreImpl::BackwardIter() const {
         TStoreIterVec::New(DataCache.GetLastValId(), DataCache.GetFirstValId(), false);
 }
 
-uint64 TStoreImpl::AddRec(const PJsonVal& RecVal) {
-	// check if we are given reference to existing record
-    try {        
-        // parse out record id, if referred directly
-        {
-            const uint64 RecId = TStore::GetRecId(RecVal);
-			if (IsRecId(RecId)) {
-                // check if we have anything more than record identifier, which would require calling UpdateRec
-                if (RecVal->GetObjKeys() > 1) { UpdateRec(RecId, RecVal); }
-                // return named record
-                return RecId;
+uint64 TStoreImpl::GetRefRecId(const PJsonVal& RecVal) const {
+    // parse out record id, if referred directly
+    const uint64 RecId = TStore::GetRecId(RecVal);
+    if (IsRecId(RecId)) { return RecId; }
+    // check if we have a primary field
+    if (IsPrimaryField()) {
+        uint64 PrimaryRecId = TUInt64::Mx;        
+        // primary field cannot be nullable, so we must have it
+        const TStr& PrimaryField = GetFieldNm(PrimaryFieldId);
+        QmAssertR(RecVal->IsObjKey(PrimaryField), "Missing primary field in the record: " + PrimaryField);
+        // parse based on the field type
+        if (PrimaryFieldType == oftStr) {
+            TStr FieldVal = RecVal->GetObjStr(PrimaryField);
+            if (PrimaryStrIdH.IsKey(FieldVal)) {
+                PrimaryRecId = PrimaryStrIdH.GetDat(FieldVal);
             }
-        }
-        // check if we have a primary field
-        if (IsPrimaryField()) {
-            uint64 PrimaryRecId = TUInt64::Mx;        
-            // primary field cannot be nullable, so we must have it
-            const TStr& PrimaryField = GetFieldNm(PrimaryFieldId);
-            QmAssertR(RecVal->IsObjKey(PrimaryField), "Missing primary field in the record: " + PrimaryField);
-            // parse based on the field type
-            if (PrimaryFieldType == oftStr) {
-                TStr FieldVal = RecVal->GetObjStr(PrimaryField);
-                if (PrimaryStrIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryStrIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftInt) {
-                const int FieldVal = RecVal->GetObjInt(PrimaryField);
-                if (PrimaryIntIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryIntIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftUInt64) {
-                const uint64 FieldVal = RecVal->GetObjInt(PrimaryField);
-                if (PrimaryUInt64IdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryUInt64IdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftFlt) {
-                const double FieldVal = RecVal->GetObjNum(PrimaryField);
-                if (PrimaryFltIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryFltIdH.GetDat(FieldVal);
-                }
-            } else if (PrimaryFieldType == oftTm) {
-                TStr TmStr = RecVal->GetObjStr(PrimaryField);
-                TTm Tm = TTm::GetTmFromWebLogDateTimeStr(TmStr, '-', ':', '.', 'T');
-                const uint64 FieldVal = TTm::GetMSecsFromTm(Tm);
-                if (PrimaryTmMSecsIdH.IsKey(FieldVal)) {
-                    PrimaryRecId = PrimaryTmMSecsIdH.GetDat(FieldVal);
-                }
+        } else if (PrimaryFieldType == oftInt) {
+            const int FieldVal = RecVal->GetObjInt(PrimaryField);
+            if (PrimaryIntIdH.IsKey(FieldVal)) {
+                PrimaryRecId = PrimaryIntIdH.GetDat(FieldVal);
+            }
+        } else if (PrimaryFieldType == oftUInt64) {
+            const uint64 FieldVal = RecVal->GetObjInt(PrimaryField);
+            if (PrimaryUInt64IdH.IsKey(FieldVal)) {
+                PrimaryRecId = PrimaryUInt64IdH.GetDat(FieldVal);
             }
-            // check if we found primary field with existing value
-            if (PrimaryRecId != TUInt64::Mx) {
-                // check if we have anything more than primary field, which would require redirect to UpdateRec
-                if (RecVal->GetObjKeys() > 1) { UpdateRec(PrimaryRecId, RecVal); }
-                // return id of named record
-                return PrimaryRecId;
+        } else if (PrimaryFieldType == oftFlt) {
+            const double FieldVal = RecVal->GetObjNum(PrimaryField);
+            if (PrimaryFltIdH.IsKey(FieldVal)) {
+                PrimaryRecId = PrimaryFltIdH.GetDat(FieldVal);
+            }
+        } else if (PrimaryFieldType == oftTm) {
+            TStr TmStr = RecVal->GetObjStr(PrimaryField);
+            TTm Tm = TTm::GetTmFromWebLogDateTimeStr(TmStr, '-', ':', '.', 'T');
+            const uint64 FieldVal = TTm::GetMSecsFromTm(Tm);
+            if (PrimaryTmMSecsIdH.IsKey(FieldVal)) {
+                PrimaryRecId = PrimaryTmMSecsIdH.GetDat(FieldVal);
             }
         }
-    } catch (const PExcept& Except) {
-        // error parsing, report error and return nothing
-        ErrorLog("[TStoreImpl::AddRec] Error parsing out reference to existing record:");
-        ErrorLog(Except->GetMsgStr());
-        return TUInt64::Mx;
+        // return id of record with existing primary field value (or TUInt64::Mx)
+        return PrimaryRecId;
     }
+    // new record
+    return TUInt64::Mx;
+}
 
-	// always add system field that means "inserted_at"
-	RecVal->AddToObj(TStoreWndDesc::SysInsertedAtFieldName, TTm::GetCurUniTm().GetStr());
-
+uint64 TStoreImpl::AddRecMem(const TMem& CacheRecMem, const TMem& MemRecMem) {
     // for storing record id
     uint64 RecId = TUInt64::Mx;    
     uint64 CacheRecId = TUInt64::Mx;    
     uint64 MemRecId = TUInt64::Mx;        
     // store to disk storage
     if (DataCacheP) {
-    	TMem CacheRecMem; SerializatorCache.Serialize(RecVal, CacheRecMem, this);
     	CacheRecId = DataCache.AddVal(CacheRecMem);
         RecId = CacheRecId;
         // index new record
@@ -2021,7 +2703,6 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal) {
     }
     // store to in-memory storage
     if (DataMemP) {
-        TMem MemRecMem; SerializatorMem.Serialize(RecVal, MemRecMem, this);
         MemRecId = DataMem.AddVal(MemRecMem);
         RecId = MemRecId;
         // index new record
@@ -2034,6 +2715,125 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal) {
     
 	// remember value-recordId map when primary field available
     if (IsPrimaryField()) { SetPrimaryField(RecId); }
+    // add values to columns
+    SetColumnVals(RecId);
+    // return record Id of the new record
+    return RecId;
+}
+
+bool TStoreImpl::SerializeJsonStr(const TStr& RecJsonStr, const TTm& InsertTm, TMem& CacheRecMem, TMem& MemRecMem) {
+    TRecSerializator::TPartRec CachePartRec, MemPartRec;
+    try {
+        TJsonReader Reader(RecJsonStr);
+        if (!Reader.Next() || !Reader.IsObjStart()) { return false; }
+        if (DataCacheP) { SerializatorCache.StartPartRec(CachePartRec); }
+        if (DataMemP) { SerializatorMem.StartPartRec(MemPartRec); }
+        int FieldId = -1;
+        while (Reader.Next() && Reader.IsKey()) {
+            const TChA& KeyChA = Reader.GetStr();
+            // keys usually come in the schema order, so check the next field
+            // before looking up the name
+            if (FieldId + 1 < GetFields() && GetFieldNm(FieldId + 1) == KeyChA.CStr()) {
+                FieldId++;
+            } else {
+                const TStr KeyStr = KeyChA;
+                if (!IsFieldNm(KeyStr)) {
+                    // joins and references need to go through AddRec
+                    if (IsJoinNm(KeyStr) || KeyStr.StartsWith("$")) { return false; }
+                    // other keys are ignored
+                    Reader.Next(); Reader.SkipVal(); continue;
+                }
+                FieldId = GetFieldId(KeyStr);
+            }
+            Reader.Next();
+            // system field is always set to current time below
+            if (GetFieldNm(FieldId) == TStoreWndDesc::SysInsertedAtFieldName) { Reader.SkipVal(); continue; }
+            if (FieldLocV[FieldId] == slMemory) {
+                SerializatorMem.SetPartRecFieldJson(MemPartRec, GetFieldDesc(FieldId), Reader);
+            } else {
+                SerializatorCache.SetPartRecFieldJson(CachePartRec, GetFieldDesc(FieldId), Reader);
+            }
+        }
+        // nothing can follow the record
+        if (Reader.Next()) { return false; }
+        // always add system field that means "inserted_at"
+        if (IsFieldNm(TStoreWndDesc::SysInsertedAtFieldName)) {
+            const int InsertedAtFieldId = GetFieldId(TStoreWndDesc::SysInsertedAtFieldName);
+            GetFieldSerializator(InsertedAtFieldId).SetPartRecFieldTm(
+                FieldLocV[InsertedAtFieldId] == slMemory ? MemPartRec : CachePartRec,
+                InsertedAtFieldId, InsertTm);
+        }
+        if (DataCacheP) { SerializatorCache.EndPartRec(CachePartRec, CacheRecMem, this); }
+        if (DataMemP) { SerializatorMem.EndPartRec(MemPartRec, MemRecMem, this); }
+    } catch (const PExcept& Except) {
+        // leave error reporting to AddRec
+        return false;
+    }
+    return true;
+}
+
+uint64 TStoreImpl::GetPrimaryRecId(const TMem& CacheRecMem, const TMem& MemRecMem) const {
+    const TMem& RecMem = IsFieldInMemory(PrimaryFieldId) ? MemRecMem : CacheRecMem;
+    const TRecSerializator& Serializator = GetFieldSerializator(PrimaryFieldId);
+    if (PrimaryFieldType == oftStr) {
+        const TStr FieldVal = Serializator.GetFieldStr(RecMem, PrimaryFieldId);
+        if (PrimaryStrIdH.IsKey(FieldVal)) { return PrimaryStrIdH.GetDat(FieldVal); }
+    } else if (PrimaryFieldType == oftInt) {
+        const int FieldVal = Serializator.GetFieldInt(RecMem, PrimaryFieldId);
+        if (PrimaryIntIdH.IsKey(FieldVal)) { return PrimaryIntIdH.GetDat(FieldVal); }
+    } else if (PrimaryFieldType == oftUInt64) {
+        const uint64 FieldVal = Serializator.GetFieldUInt64(RecMem, PrimaryFieldId);
+        if (PrimaryUInt64IdH.IsKey(FieldVal)) { return PrimaryUInt64IdH.GetDat(FieldVal); }
+    } else if (PrimaryFieldType == oftFlt) {
+        const double FieldVal = Serializator.GetFieldFlt(RecMem, PrimaryFieldId);
+        if (PrimaryFltIdH.IsKey(FieldVal)) { return PrimaryFltIdH.GetDat(FieldVal); }
+    } else if (PrimaryFieldType == oftTm) {
+        const uint64 FieldVal = Serializator.GetFieldTmMSecs(RecMem, PrimaryFieldId);
+        if (PrimaryTmMSecsIdH.IsKey(FieldVal)) { return PrimaryTmMSecsIdH.GetDat(FieldVal); }
+    }
+    return TUInt64::Mx;
+}
+
+bool TStoreImpl::TryAddRecJsonStr(const TStr& RecJsonStr, uint64& RecId) {
+    TWalOp WalOp(GetBase());
+    TMem CacheRecMem, MemRecMem;
+    if (!SerializeJsonStr(RecJsonStr, TTm::GetTmFromMSecs(WalOp.GetOpMSecs()), CacheRecMem, MemRecMem)) { return false; }
+    // existing primary field value means update, which goes through AddRec
+    if (IsPrimaryField() && GetPrimaryRecId(CacheRecMem, MemRecMem) != TUInt64::Mx) { return false; }
+    if (WalOp.IsLog()) { WalOp.GetWal().AddRecJson(GetStoreId(), WalOp.GetOpMSecs(), RecJsonStr); }
+    // store the record and call add triggers
+    RecId = AddRecMem(CacheRecMem, MemRecMem);
+    OnAdd(RecId);
+    return true;
+}
+
+uint64 TStoreImpl::AddRec(const PJsonVal& RecVal) {
+    TWalOp WalOp(GetBase());
+    if (WalOp.IsLog()) { WalOp.GetWal().AddRec(GetStoreId(), WalOp.GetOpMSecs(), RecVal); }
+	// check if we are given reference to existing record
+    try {        
+        const uint64 RefRecId = GetRefRecId(RecVal);
+        if (RefRecId != TUInt64::Mx) {
+            // check if we have anything more than record reference, which would require calling UpdateRec
+            if (RecVal->GetObjKeys() > 1) { UpdateRec(RefRecId, RecVal); }
+            // return named record
+            return RefRecId;
+        }
+    } catch (const PExcept& Except) {
+        // error parsing, report error and return nothing
+        ErrorLog("[TStoreImpl::AddRec] Error parsing out reference to existing record:");
+        ErrorLog(Except->GetMsgStr());
+        return TUInt64::Mx;
+    }
+
+	// always add system field that means "inserted_at"
+	RecVal->AddToObj(TStoreWndDesc::SysInsertedAtFieldName, TTm::GetTmFromMSecs(WalOp.GetOpMSecs()).GetStr());
+
+    // serialize and store the record
+    TMem CacheRecMem, MemRecMem;
+    if (DataCacheP) { SerializatorCache.Serialize(RecVal, CacheRecMem, this); }
+    if (DataMemP) { SerializatorMem.Serialize(RecVal, MemRecMem, this); }
+    const uint64 RecId = AddRecMem(CacheRecMem, MemRecMem);
     
 	// insert nested join records
 	AddJoinRec(RecId, RecVal);
@@ -2044,7 +2844,142 @@ uint64 TStoreImpl::AddRec(const PJsonVal& RecVal) {
 	return RecId;
 }
 
+uint64 TStoreImpl::AddRecBulk(const PSIn& SIn, const int& BatchLen,
+        const int64& IndexCacheSize, const bool& _TriggerP) {
+
+    TWPt<TBase> Base = GetBase();
+    QmAssertR(!Base->IsTempIndex(), "[TStoreImpl::AddRecBulk] Base already has a temporary index");
+    // all records are inserted at the time of the operation
+    TWalOp WalOp(Base); const TTm InsertTm = TTm::GetTmFromMSecs(WalOp.GetOpMSecs());
+    const TStr InsertTmStr = InsertTm.GetStr();
+    // serialization can run in parallel when it does not modify serializators
+    const bool ParallelP = SerializatorCache.IsThreadSafe() && SerializatorMem.IsThreadSafe();
+    // new records are indexed into temporary indices
+    Base->InitTempIndex(IndexCacheSize);
+    RecIndexer.SetIndex(Base->GetIndex());
+    // range of new record ids, records with nested joins and updates of existing records
+    uint64 FirstRecId = TUInt64::Mx, NewRecs = 0;
+    TVec<TPair<TUInt64, PJsonVal> > JoinRecValV; TVec<PJsonVal> UpdateRecValV;
+    try {
+        TStrV LnV; TVec<PJsonVal> RecValV; TVec<TMem> CacheRecMemV, MemRecMemV;
+        TBoolV FastV; TStrV ErrorMsgV;
+        while (!SIn->Eof()) {
+            // read next batch of records
+            GetJsonLnBatch(SIn, BatchLen, LnV);
+            if (WalOp.IsLog()) { WalOp.GetWal().AddRecBulk(GetStoreId(), WalOp.GetOpMSecs(), LnV); }
+            const int Recs = LnV.Len();
+            CacheRecMemV.Gen(Recs); MemRecMemV.Gen(Recs); ErrorMsgV.Gen(Recs);
+            FastV.Gen(Recs); RecValV.Gen(Recs);
+            // serialize records directly from JSon lines when possible
+            #pragma omp parallel for schedule(dynamic, 64) if(ParallelP)
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                FastV[RecN] = SerializeJsonStr(LnV[RecN], InsertTm, CacheRecMemV[RecN], MemRecMemV[RecN]);
+            }
+            // parse the remaining ones, lexer is not thread safe
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                if (!FastV[RecN]) { RecValV[RecN] = GetJsonLnRecVal(LnV[RecN]); }
+            }
+            // and serialize them from parsed JSon
+            #pragma omp parallel for schedule(dynamic, 64) if(ParallelP)
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                const PJsonVal& RecVal = RecValV[RecN];
+                if (RecVal.Empty()) { continue; }
+                try {
+                    RecVal->AddToObj(TStoreWndDesc::SysInsertedAtFieldName, InsertTmStr);
+                    if (DataCacheP) { SerializatorCache.Serialize(RecVal, CacheRecMemV[RecN], this); }
+                    if (DataMemP) { SerializatorMem.Serialize(RecVal, MemRecMemV[RecN], this); }
+                } catch (const PExcept& Except) {
+                    ErrorMsgV[RecN] = Except->GetMsgStr();
+                }
+            }
+            // store new records in the input order, postpone updates and joins
+            for (int RecN = 0; RecN < Recs; RecN++) {
+                if (FastV[RecN]) {
+                    // records with existing primary field value are updates
+                    if (IsPrimaryField() && GetPrimaryRecId(CacheRecMemV[RecN], MemRecMemV[RecN]) != TUInt64::Mx) {
+                        PJsonVal RecVal = GetJsonLnRecVal(LnV[RecN]);
+                        if (!RecVal.Empty()) { UpdateRecValV.Add(RecVal); }
+                        continue;
+                    }
+                    const uint64 RecId = AddRecMem(CacheRecMemV[RecN], MemRecMemV[RecN]);
+                    if (NewRecs == 0) { FirstRecId = RecId; }
+                    EAssert(RecId == FirstRecId + NewRecs); NewRecs++;
+                    continue;
+                }
+                const PJsonVal& RecVal = RecValV[RecN];
+                if (RecVal.Empty()) { continue; }
+                uint64 RefRecId = TUInt64::Mx;
+                try {
+                    RefRecId = GetRefRecId(RecVal);
+                } catch (const PExcept& Except) {
+                    ErrorLog("[TStoreImpl::AddRecBulk] Error parsing out reference to existing record:");
+                    ErrorLog(Except->GetMsgStr());
+                    continue;
+                }
+                if (RefRecId != TUInt64::Mx) {
+                    RecVal->DelObjKey(TStoreWndDesc::SysInsertedAtFieldName);
+                    UpdateRecValV.Add(RecVal);
+                } else if (!ErrorMsgV[RecN].Empty()) {
+                    ErrorLog("[TStoreImpl::AddRecBulk] Error serializing record:");
+                    ErrorLog(ErrorMsgV[RecN]);
+                } else {
+                    const uint64 RecId = AddRecMem(CacheRecMemV[RecN], MemRecMemV[RecN]);
+                    if (NewRecs == 0) { FirstRecId = RecId; }
+                    EAssert(RecId == FirstRecId + NewRecs); NewRecs++;
+                    // remember records with nested joins
+                    for (int JoinN = 0; JoinN < GetJoins(); JoinN++) {
+                        if (RecVal->IsObjKey(GetJoinDesc(JoinN).GetJoinNm())) {
+                            JoinRecValV.Add(TPair<TUInt64, PJsonVal>(RecId, RecVal)); break;
+                        }
+                    }
+                }
+            }
+            // start new temporary index when current one is full
+            if (Base->IsTempIndexFull()) {
+                Base->NewTempIndex(); RecIndexer.SetIndex(Base->GetIndex());
+            }
+            TEnv::Logger->OnStatus(TStr::Fmt("Bulk loaded %s records ...", TUInt64::GetStr(NewRecs).CStr()));
+        }
+    } catch (const PExcept& Except) {
+        // keep the index consistent with records stored so far
+        Base->MergeTempIndex(); RecIndexer.SetIndex(Base->GetIndex());
+        if (WalOp.IsLog()) { WalOp.GetWal().AddRecBulkEnd(GetStoreId(), WalOp.GetOpMSecs(), BatchLen, IndexCacheSize, _TriggerP); }
+        throw Except;
+    }
+    // replay repeats the load with logged lines
+    if (WalOp.IsLog()) { WalOp.GetWal().AddRecBulkEnd(GetStoreId(), WalOp.GetOpMSecs(), BatchLen, IndexCacheSize, _TriggerP); }
+    // merge temporary indices into the main index
+    Base->MergeTempIndex(); RecIndexer.SetIndex(Base->GetIndex());
+    uint64 UpdateRecs = 0;
+    PutTriggerP(_TriggerP);
+    try {
+        // insert nested join records and add joins
+        for (int JoinRecN = 0; JoinRecN < JoinRecValV.Len(); JoinRecN++) {
+            AddJoinRec(JoinRecValV[JoinRecN].Val1, JoinRecValV[JoinRecN].Val2);
+        }
+        JoinRecValV.Clr();
+        // call add triggers in batches
+        TUInt64V RecIdV(BatchLen, 0);
+        for (uint64 RecN = 0; RecN < NewRecs; RecN++) {
+            RecIdV.Add(FirstRecId + RecN);
+            if (RecIdV.Len() == BatchLen || RecN + 1 == NewRecs) {
+                OnAddBatch(RecIdV); RecIdV.Clr(false);
+            }
+        }
+        // update existing records
+        for (int RecN = 0; RecN < UpdateRecValV.Len(); RecN++) {
+            if (AddRec(UpdateRecValV[RecN]) != TUInt64::Mx) { UpdateRecs++; }
+        }
+    } catch (const PExcept& Except) {
+        PutTriggerP(true); throw Except;
+    }
+    PutTriggerP(true);
+    return NewRecs + UpdateRecs;
+}
+
 void TStoreImpl::UpdateRec(const uint64& RecId, const PJsonVal& RecVal) {    
+    TWalOp WalOp(GetBase());
+    if (WalOp.IsLog()) { WalOp.GetWal().UpdateRec(GetStoreId(), WalOp.GetOpMSecs(), RecId, RecVal); }
     // figure out which storage fields are affected
     bool CacheP = false, MemP = false, PrimaryP = false;
     for (int FieldId = 0; FieldId < GetFields(); FieldId++) {
@@ -2084,6 +3019,8 @@ void TStoreImpl::UpdateRec(const uint64& RecId, const PJsonVal& RecVal) {
     }
     // check if primary key changed and update the mapping
     if (PrimaryP) { SetPrimaryField(RecId); }
+    // update columns
+    SetColumnVals(RecId);
     // call update triggers
 	OnUpdate(RecId);
 }
@@ -2166,6 +3103,7 @@ void TStoreImpl::DeleteFirstNRecs(int DelRecs)  {
 }
 
 void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const bool& AssertOK) {
+    TWalOp WalOp(GetBase());
 	if (AssertOK) {
 		// assert that DelRecIdV is valid, without gaps and that deleting will not create gaps
 		PStoreIter Iter = GetIter();
@@ -2176,6 +3114,7 @@ void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const bool& AssertOK) {
 			Counter++;
 		}
 	}
+    if (WalOp.IsLog()) { WalOp.GetWal().DeleteRecs(GetStoreId(), WalOp.GetOpMSecs(), DelRecIdV); }
 	// delete records from index
 	for (int DelRecN = 0; DelRecN < DelRecIdV.Len(); DelRecN++) {
 		// report progress
@@ -2213,191 +3152,291 @@ void TStoreImpl::DeleteRecs(const TUInt64V& DelRecIdV, const bool& AssertOK) {
 	if (DataCacheP) { DataCache.DelVals(DelRecIdV.Len()); }
 	// delete records from in-memory store
 	if (DataMemP) { DataMem.DelVals(DelRecIdV.Len()); }
+	// delete records from columns
+	if (ColumnsFilledP) {
+		for (int ColumnN = 0; ColumnN < ColumnV.Len(); ColumnN++) {
+			ColumnV[ColumnN].DelVals(DelRecIdV.Len());
+		}
+	}
 
 	// report success :-)
 	TEnv::Logger->OnStatusFmt("  %s records at end", TUInt64::GetStr(GetRecs()).CStr());
 }
 
 bool TStoreImpl::IsFieldNull(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).IsFieldNull(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).IsFieldNull(Rec, FieldId);
 }
 
 int TStoreImpl::GetFieldInt(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldInt(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldInt(Rec, FieldId);
 }
 
 TStr TStoreImpl::GetFieldStr(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldStr(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldStr(Rec, FieldId);
 }
 
 bool TStoreImpl::GetFieldBool(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldBool(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldBool(Rec, FieldId);
 }
 
 double TStoreImpl::GetFieldFlt(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldFlt(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldFlt(Rec, FieldId);
 }
 
 TFltPr TStoreImpl::GetFieldFltPr(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldFltPr(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldFltPr(Rec, FieldId);
 }
 
 uint64 TStoreImpl::GetFieldUInt64(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldUInt64(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldUInt64(Rec, FieldId);
 }
 
 void TStoreImpl::GetFieldStrV(const uint64& RecId, const int& FieldId, TStrV& StrV) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldStrV(RecMem, FieldId, StrV);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldStrV(Rec, FieldId, StrV);
 }
 
 void TStoreImpl::GetFieldIntV(const uint64& RecId, const int& FieldId, TIntV& IntV) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldIntV(RecMem, FieldId, IntV);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldIntV(Rec, FieldId, IntV);
 }
 
 void TStoreImpl::GetFieldFltV(const uint64& RecId, const int& FieldId, TFltV& FltV) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldFltV(RecMem, FieldId, FltV);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldFltV(Rec, FieldId, FltV);
 }
 
 void TStoreImpl::GetFieldTm(const uint64& RecId, const int& FieldId, TTm& Tm) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldTm(RecMem, FieldId, Tm);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldTm(Rec, FieldId, Tm);
 }
 
 uint64 TStoreImpl::GetFieldTmMSecs(const uint64& RecId, const int& FieldId) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	return GetFieldSerializator(FieldId).GetFieldTmMSecs(RecMem, FieldId);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldTmMSecs(Rec, FieldId);
 }
 
 void TStoreImpl::GetFieldNumSpV(const uint64& RecId, const int& FieldId, TIntFltKdV& SpV) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldNumSpV(RecMem, FieldId, SpV);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldNumSpV(Rec, FieldId, SpV);
 }
 
 void TStoreImpl::GetFieldBowSpV(const uint64& RecId, const int& FieldId, PBowSpV& SpV) const {
-	TMem RecMem; GetRecMem(RecId, FieldId, RecMem);
-	GetFieldSerializator(FieldId).GetFieldBowSpV(RecMem, FieldId, SpV);
+	TMem RecMem; const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	GetFieldSerializator(FieldId).GetFieldBowSpV(Rec, FieldId, SpV);
+}
+
+TStrView TStoreImpl::GetFieldStrView(const uint64& RecId, const int& FieldId, TMem& RecMem) const {
+	const TThinMem Rec = GetRecThinMem(RecId, FieldId, RecMem);
+	return GetFieldSerializator(FieldId).GetFieldStrView(Rec, FieldId);
+}
+
+void TStoreImpl::WriteRecFieldsJson(const uint64& RecId, const TIntV& FieldIdV, TJsonWriter& Writer) const {
+	// memory part is read in place, disk part is copied out of the cache on first use
+	TThinMem MemRec; bool MemRecP = false;
+	TMem CacheRecMem; bool CacheRecP = false;
+	for (int FieldN = 0; FieldN < FieldIdV.Len(); FieldN++) {
+		const int FieldId = FieldIdV[FieldN];
+		if (FieldLocV[FieldId] == slMemory) {
+			if (!MemRecP) { MemRec = DataMem.GetThinVal(RecId); MemRecP = true; }
+		} else if (!CacheRecP) {
+			DataCache.GetVal(RecId, CacheRecMem); CacheRecP = true;
+		}
+		const TThinMem Rec = (FieldLocV[FieldId] == slMemory) ? MemRec : TThinMem(CacheRecMem);
+		const TRecSerializator& Serializator = GetFieldSerializator(FieldId);
+		if (Serializator.IsFieldNull(Rec, FieldId)) { continue; }
+		const TFieldDesc& FieldDesc = GetFieldDesc(FieldId);
+		Writer.PutKey(FieldDesc.GetFieldNm());
+		Serializator.WriteFieldJson(Rec, FieldDesc, Writer);
+	}
+}
+
+PJsonVal TStoreImpl::GetStoreStatJson() const {
+    PJsonVal StatVal = TJsonVal::NewObj();
+    if (DataCacheP) {
+        int64 MemUsed, Hits, Misses, Evictions;
+        DataCache.GetCacheStat(MemUsed, Hits, Misses, Evictions);
+        StatVal->AddToObj("cacheMemUsed", (double)MemUsed);
+        StatVal->AddToObj("cacheHits", (double)Hits);
+        StatVal->AddToObj("cacheMisses", (double)Misses);
+        StatVal->AddToObj("cacheEvictions", (double)Evictions);
+    }
+    return StatVal;
+}
+
+void TStoreImpl::GetFieldFltColumn(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TFltV& ValV) const {
+    if (!IsFieldColumn(FieldId)) { TStore::GetFieldFltColumn(RecIdFqV, FieldId, ValV); return; }
+    FillColumns();
+    const TFieldColumn& Column = ColumnV[FieldColumnNV[FieldId]];
+    QmAssertR(Column.IsFlt(), "Wrong field type, numeric expected");
+    ValV.Gen(RecIdFqV.Len(), 0);
+    for (int RecN = 0; RecN < RecIdFqV.Len(); RecN++) {
+        ValV.Add(Column.GetFlt(RecIdFqV[RecN].Key));
+    }
+}
+
+void TStoreImpl::GetFieldUInt64Column(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TUInt64V& ValV) const {
+    if (!IsFieldColumn(FieldId)) { TStore::GetFieldUInt64Column(RecIdFqV, FieldId, ValV); return; }
+    FillColumns();
+    const TFieldColumn& Column = ColumnV[FieldColumnNV[FieldId]];
+    QmAssertR(!Column.IsFlt(), "Wrong field type, uint64 or time expected");
+    ValV.Gen(RecIdFqV.Len(), 0);
+    for (int RecN = 0; RecN < RecIdFqV.Len(); RecN++) {
+        ValV.Add(Column.GetUInt64(RecIdFqV[RecN].Key));
+    }
 }
 
 void TStoreImpl::SetFieldNull(const uint64& RecId, const int& FieldId) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldNull(InRecMem, OutRecMem, FieldId);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldInt(const uint64& RecId, const int& FieldId, const int& Int) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldInt(InRecMem, OutRecMem, FieldId, Int);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldIntV(const uint64& RecId, const int& FieldId, const TIntV& IntV) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldIntV(InRecMem, OutRecMem, FieldId, IntV);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldUInt64(const uint64& RecId, const int& FieldId, const uint64& UInt64) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldUInt64(InRecMem, OutRecMem, FieldId, UInt64);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldStr(const uint64& RecId, const int& FieldId, const TStr& Str) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldStr(InRecMem, OutRecMem, FieldId, Str);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldStrV(const uint64& RecId, const int& FieldId, const TStrV& StrV) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldStrV(InRecMem, OutRecMem, FieldId, StrV);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldBool(const uint64& RecId, const int& FieldId, const bool& Bool) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldBool(InRecMem, OutRecMem, FieldId, Bool);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldFlt(const uint64& RecId, const int& FieldId, const double& Flt) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldFlt(InRecMem, OutRecMem, FieldId, Flt);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldFltPr(const uint64& RecId, const int& FieldId, const TFltPr& FltPr) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldFltPr(InRecMem, OutRecMem, FieldId, FltPr);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldFltV(const uint64& RecId, const int& FieldId, const TFltV& FltV) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldFltV(InRecMem, OutRecMem, FieldId, FltV);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldTm(const uint64& RecId, const int& FieldId, const TTm& Tm) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldTm(InRecMem, OutRecMem, FieldId, Tm);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldTmMSecs(const uint64& RecId, const int& FieldId, const uint64& TmMSecs) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldTmMSecs(InRecMem, OutRecMem, FieldId, TmMSecs);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    if (IsFieldColumn(FieldId)) { SetColumnVal(FieldColumnNV[FieldId], RecId); }
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldNumSpV(const uint64& RecId, const int& FieldId, const TIntFltKdV& SpV) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldNumSpV(InRecMem, OutRecMem, FieldId, SpV);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 void TStoreImpl::SetFieldBowSpV(const uint64& RecId, const int& FieldId, const PBowSpV& SpV) {
+    TWalOp WalOp(GetBase());
 	TMem InRecMem; GetRecMem(RecId, FieldId, InRecMem);
     TRecSerializator& FieldSerializator = GetFieldSerializator(FieldId);
     TMem OutRecMem; FieldSerializator.SetFieldBowSpV(InRecMem, OutRecMem, FieldId, SpV);
     RecIndexer.UpdateRec(InRecMem, OutRecMem, RecId, FieldId, FieldSerializator);
 	PutRecMem(RecId, FieldId, OutRecMem);
+    OnSetField(WalOp, RecId, FieldId);
 }
 
 ///////////////////////////////
@@ -2493,7 +3532,8 @@ TVec<TWPt<TStore> > CreateStoresFromSchema(const TWPt<TBase>& Base, const PJsonV
 			}
 		}
 	}
-    
+    // base saved by checkpoints needs one to include new stores
+    if (Base->IsCheckpoint()) { Base->Checkpoint(); }
     // done
     return NewStoreV;
 }
@@ -2535,6 +3575,8 @@ TWPt<TBase> LoadBase(const TStr& FPath, const TFAccess& FAccess, const uint64& I
 		Base->AddStore(Store);
 	}
 	InfoLog("Stores loaded");
+	// apply changes logged after the last checkpoint
+	Base->ReplayWal();
 	// finish base initialization if so required (default is true)
 	if (InitP) { Base->Init(); }
 	// done
@@ -2546,6 +3588,8 @@ TWPt<TBase> LoadBase(const TStr& FPath, const TFAccess& FAccess, const uint64& I
 void SaveBase(const TWPt<TBase>& Base) {
 	if (Base->IsRdOnly()) {
         InfoLog("No saving of generic base necessary!");
+    } else if (Base->IsCheckpoint()) {
+        InfoLog("List of stores saved by checkpoints");
     } else {
         // Only need to save list of stores so we know what to load next time
         // Everything else is saved automatically in destructor
@@ -46,12 +46,14 @@ public:
 	TBool SmallStringP;  
 	/// Default value if value not specified
 	PJsonVal DefaultVal;  
+	/// Keep values of the field also in a column (numeric and time fields)
+	TBool ColumnP;
 public:
 	TFieldDescEx() {}
     TFieldDescEx(const TStoreLoc& _FieldStoreLoc, const bool& _CodebookP, 
         const bool& _SmallStringP, const PJsonVal& _DefaultVal = NULL):
             FieldStoreLoc(_FieldStoreLoc), CodebookP(_CodebookP),
-            SmallStringP(_SmallStringP), DefaultVal(_DefaultVal) { }
+            SmallStringP(_SmallStringP), DefaultVal(_DefaultVal), ColumnP(false) { }
 };  
 
 ///////////////////////////////
@@ -200,23 +202,163 @@ public:
 };
 typedef TVec<TStoreSchema> TStoreSchemaV;
 
+///////////////////////////////
+/// Thin memory. 
+/// Presents a serialized record, either inside a TMem or directly inside 
+/// the storage, without copying it. It doesn't allocate or release any memory.
+class TThinMem {
+private:
+    char* Bf;
+    int BfL;
+    
+public:
+    TThinMem(): Bf(NULL), BfL(0) { }
+    TThinMem(const TMem& Mem): Bf(Mem.GetBf()), BfL(Mem.Len()) { }
+    TThinMem(const char* _Bf, const int& _BfL): Bf((char*)_Bf), BfL(_BfL) { }
+    
+    char* GetBf() const { return Bf; }
+    int Len() const { return BfL; }
+};
+
+///////////////////////////////
+/// In-memory storage chunk.
+/// Consecutive values of in-memory storage. Values are appended one after
+/// another into large pages and addressed by (page, offset), so adding a
+/// value does not allocate memory of its own. Space left by deleted and
+/// moved values is reclaimed by compacting the pages once it takes more
+/// than half of them. When the storage is read-only, values are mapped
+/// from the chunk file instead.
+class TInMemChunk;
+typedef TPt<TInMemChunk> PInMemChunk;
+class TInMemChunk {
+private:
+    /// Location of a value inside the pages
+    class TValLoc {
+    public:
+        int PageN;
+        int Offset;
+        int Len;
+        TValLoc(): PageN(-1), Offset(0), Len(0) { }
+        TValLoc(const int& _PageN, const int& _Offset, const int& _Len):
+            PageN(_PageN), Offset(_Offset), Len(_Len) { }
+    };
+    /// Default page size in bytes, larger values get a page of their own
+    enum { PageLen = 1048576 };
+
+private:
+    TCRef CRef;
+    /// Pages with values
+    TVec<PMem> PageV;
+    /// Free space at the end of the last page
+    int LastPageFree;
+    /// Location of each value
+    TVec<TValLoc, int64> ValLocV;
+    /// Bytes taken by all values, including garbage
+    int64 DataLen;
+    /// Bytes taken by deleted or moved values
+    int64 GarbageLen;
+    /// Chunk file mapped for read-only access, used instead of pages
+    PFMMap MMap;
+    /// Value offsets inside MMap, relative to MMapDataBf, one more than values
+    const uint64* MMapOffsetV;
+    /// Start of value data inside MMap
+    const char* MMapDataBf;
+    /// Number of mapped values
+    int64 MMapVals;
+    /// Changed since last saved
+    bool DirtyP;
+
+    TInMemChunk(): LastPageFree(0), DataLen(0), GarbageLen(0), MMapOffsetV(NULL), 
+        MMapDataBf(NULL), MMapVals(0), DirtyP(true) { }
+    TInMemChunk(const TStr& FNm, const bool& MMapP);
+
+    /// Append bytes to the last page and return their location
+    TValLoc PutBf(const char* Bf, const int& Len);
+    /// Mark space of the value as garbage
+    void FreeVal(const TValLoc& ValLoc) { GarbageLen += ValLoc.Len; }
+    /// Copy values to new pages when most of the space is garbage
+    void Compact();
+
+public:
+    /// New empty chunk
+    static PInMemChunk New() { return new TInMemChunk; }
+    /// Load chunk from file, maps it instead of copying to heap when MMapP is set
+    static PInMemChunk Load(const TStr& FNm, const bool& MMapP) { 
+        return new TInMemChunk(FNm, MMapP); }
+    /// Save chunk to file
+    void Save(const TStr& FNm);
+
+    /// True when values are accessed through the memory map
+    bool IsMMap() const { return !MMap.Empty(); }
+    /// True when chunk changed since last saved
+    bool IsDirty() const { return DirtyP; }
+    /// Number of values in the chunk, including the deleted ones
+    int64 Len() const { return IsMMap() ? MMapVals : ValLocV.Len(); }
+
+    /// Copy value into Val, reusing its buffer
+    void GetVal(const int64& ValN, TMem& Val) const;
+    /// Value inside the chunk, valid until the chunk is changed
+    TThinMem GetThinVal(const int64& ValN) const;
+    void AddVal(const TMem& Val);
+    /// Overwrite value in place when it fits, otherwise append it to the pages
+    void SetVal(const int64& ValN, const TMem& Val);
+    /// Release space of deleted value. Chunk stays clean, since the
+    /// deleted values are skipped when loading it.
+    void DelVal(const int64& ValN);
+
+    friend class TPt<TInMemChunk>;
+};
+
 ///////////////////////////////
 /// In-memory storage.
-/// Wrapper around TVec of TMems.
-/// TODO: Make circular buffer to avoid moving stuff on delete
+/// Values are kept in a sequence of chunks of fixed length, where value
+/// with id ValId lives in chunk ValId / ChunkLen. Deleting values from the
+/// front releases their memory and drops whole chunks once they are empty,
+/// without moving the remaining values. Each chunk is saved to its own file
+/// and only chunks changed since the last save are written again.
 class TInMemStorage {
 private:
+    /// Header tag of chunked layout. Older files hold all values in one file
+    /// and start with FlatTag or with a non-negative vector size.
+    enum { ChunkTag = -3, FlatTag = -2 };
+    /// Number of values in one chunk
+    enum { ChunkLen = 65536 };
+
     /// Storage filename
 	TStr FNm;
     /// Access type with which the storage is opened
 	TFAccess Access;
     /// Offset of the first record
 	TUInt64 FirstValOffset;
-    /// Storage vector
-    TVec<TMem, int64> ValV;
+    /// Id of the next added record
+    TUInt64 NextValId;
+    /// Chunk number of the first chunk in ChunkV
+    TUInt64 FirstChunkN;
+    /// Chunks, all except the last one are full
+    TVec<PInMemChunk, int64> ChunkV;
+    /// Chunks dropped since last save, their files are deleted on save
+    TUInt64V DelChunkNV;
+    /// Once checkpointed, storage is saved only by checkpoints
+    TBool CheckpointP;
+
+    /// Filename of chunk with the given chunk number
+    TStr GetChunkFNm(const uint64& ChunkN) const { return FNm + "." + TUInt64::GetStr(ChunkN); }
+    /// Chunk holding the given value
+    const PInMemChunk& GetChunk(const uint64& ValId) const { 
+        return ChunkV[int64(ValId / ChunkLen - FirstChunkN)]; }
+    /// Load chunks, or values from older single-file layouts
+    void Load();
+    /// Load values from older single-file layouts into chunks
+    void LoadFlat(TSIn& SIn, const int64& Tag);
+    /// Save changed chunks and header
+    void Save();
+    /// Save header with value and chunk offsets
+    void SaveHeader(const TStr& HeaderFNm) const;
     
 public:
 	TInMemStorage(const TStr& _FNm);
+	/// Opens existing storage. In read-only mode the chunks are mapped from
+	/// their files and not copied to the heap.
 	TInMemStorage(const TStr& _FNm, const TFAccess& _Access);
 	~TInMemStorage();
 
@@ -226,6 +368,8 @@ public:
 
 	bool IsValId(const uint64& ValId) const;
 	void GetVal(const uint64& ValId, TMem& Val) const; 
+	/// Value inside the storage, valid until the storage is changed
+	TThinMem GetThinVal(const uint64& ValId) const;
 	uint64 AddVal(const TMem& Val);
 	void SetVal(const uint64& ValId, const TMem& Val);
 	void DelVals(int Vals);
@@ -233,6 +377,9 @@ public:
 	uint64 Len() const;
 	uint64 GetFirstValId() const;
 	uint64 GetLastValId() const;
+
+	/// Add changed chunks and header to the commit
+	void Checkpoint(TFCommit& Commit);
 };
 
 ////////////////////////////////////
@@ -287,7 +434,7 @@ private:
 		int BfC, BfL;
 	private:
 	public:
-		TThinMIn(const TMem& Mem);
+		TThinMIn(const TThinMem& Mem);
 		TThinMIn(const void* _Bf, const int& _BfL);
         
 		bool Eof() { return BfC == BfL; }
@@ -300,6 +447,24 @@ private:
 		void MoveTo(int Offset);
 		bool GetNextLnBf(TChA& LnChA);
 	};
+
+public:
+    /////////////////////////////////////////////////
+    /// Partially serialized record. Fields are set one at a time, in any order,
+    /// while parsing the record; object can be reused for several records.
+    class TPartRec {
+    private:
+        /// Null map, fixed fields and var-field indexes
+        TMem FixedMem;
+        /// Variable-length values in the order in which they were set
+        TMOut VarSOut;
+        /// Position and length of variable-length values inside VarSOut
+        TIntPrV VarPosV;
+        /// Which fields were already set
+        TBoolV FieldSetV;
+        
+        friend class TRecSerializator;
+    };
     
 private: 
 	/// Only store fields with this storage flag
@@ -319,18 +484,18 @@ private:
 	TStrHash<TInt, TBigStrPool> CodebookH;
 
     /// Dump report used on failed asserts
-    TStr GetErrorMsg(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
+    TStr GetErrorMsg(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
     
 	/// returns field serialization description
 	const TFieldSerialDesc& GetFieldSerialDesc(const int& FieldId) const;
 	/// finds location inside the buffer for fixed-width fields
-	uchar* GetLocationFixed(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
+	uchar* GetLocationFixed(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
 	/// finds location inside the buffer for variable-width fields
-	int GetOffsetVar(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
+	int GetOffsetVar(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
 	/// finds location inside the buffer for variable-width fields
-	uchar* GetLocationVar(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
+	uchar* GetLocationVar(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc) const;
 	/// calculates length of buffer where given var-length field is stored
-	int GetVarPartBfLen(const TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc);
+	int GetVarPartBfLen(const TThinMem& RecMem, const TFieldSerialDesc& FieldSerialDesc);
     
 	/// set content offset for specified variable field
 	void SetLocationVar(TMem& RecMem, const TFieldSerialDesc& FieldSerialDesc, const int& VarOffset) const;
@@ -397,37 +562,63 @@ public:
 	void SerializeUpdate(const PJsonVal& RecVal, const TMem& InRecMem, TMem& OutRecMem, 
         const TWPt<TStore>& Store, TIntSet& ChangedFieldIdSet);
 
+	/// Start serializing new record field by field
+	void StartPartRec(TPartRec& PartRec) const;
+	/// Set field from JSon reader positioned at the start of the field value.
+	/// Reader is left at the last token of the value.
+	void SetPartRecFieldJson(TPartRec& PartRec, const TFieldDesc& FieldDesc, TJsonReader& Reader);
+	/// Set time field
+	void SetPartRecFieldTm(TPartRec& PartRec, const int& FieldId, const TTm& Tm);
+	/// Fill fields which were not set and produce final serialization
+	void EndPartRec(TPartRec& PartRec, TMem& RecMem, const TWPt<TStore>& Store);
+
+	/// Check if Serialize can be called from several threads at the same time,
+	/// which is not the case when it updates codebook or shares default values
+	bool IsThreadSafe() const;
+	/// Number of strings in the codebook, which only grows with new values
+	int GetCodebookLen() const { return CodebookH.Len(); }
+	/// Save codebook strings added after the first CodebookLen
+	void SaveCodebookDelta(TSOut& SOut, const int& CodebookLen) const;
+	/// Append codebook strings saved by SaveCodebookDelta, returns their number
+	int LoadCodebookDelta(TSIn& SIn);
+
 	/// Check if field inside this serializator
 	bool IsFieldId(const int& FieldId) const { return FieldIdToSerialDescIdH.IsKey(FieldId); }
     
 	/// Field getter
-	bool IsFieldNull(const TMem& RecMem, const int& FieldId) const;
+	bool IsFieldNull(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	int GetFieldInt(const TMem& RecMem, const int& FieldId) const;
+	int GetFieldInt(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	void GetFieldIntV(const TMem& RecMem, const int& FieldId, TIntV& IntV) const;
+	void GetFieldIntV(const TThinMem& RecMem, const int& FieldId, TIntV& IntV) const;
 	/// Field getter
-	uint64 GetFieldUInt64(const TMem& RecMem, const int& FieldId) const;
+	uint64 GetFieldUInt64(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	TStr GetFieldStr(const TMem& RecMem, const int& FieldId) const;
+	TStr GetFieldStr(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	void GetFieldStrV(const TMem& RecMem, const int& FieldId, TStrV& StrV) const;
+	void GetFieldStrV(const TThinMem& RecMem, const int& FieldId, TStrV& StrV) const;
 	/// Field getter
-	bool GetFieldBool(const TMem& RecMem, const int& FieldId) const;
+	bool GetFieldBool(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	double GetFieldFlt(const TMem& RecMem, const int& FieldId) const;
+	double GetFieldFlt(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	TFltPr GetFieldFltPr(const TMem& RecMem, const int& FieldId) const;
+	TFltPr GetFieldFltPr(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-	void GetFieldFltV(const TMem& RecMem, const int& FieldId, TFltV& FltV) const;
+	void GetFieldFltV(const TThinMem& RecMem, const int& FieldId, TFltV& FltV) const;
 	/// Field getter
-	void GetFieldTm(const TMem& RecMem, const int& FieldId, TTm& Tm) const;
+	void GetFieldTm(const TThinMem& RecMem, const int& FieldId, TTm& Tm) const;
 	/// Field getter
-	uint64 GetFieldTmMSecs(const TMem& RecMem, const int& FieldId) const;
+	uint64 GetFieldTmMSecs(const TThinMem& RecMem, const int& FieldId) const;
 	/// Field getter
-    void GetFieldNumSpV(const TMem& RecMem, const int& FieldId, TIntFltKdV& SpV) const;
+    void GetFieldNumSpV(const TThinMem& RecMem, const int& FieldId, TIntFltKdV& SpV) const;
 	/// Field getter
-    void GetFieldBowSpV(const TMem& RecMem, const int& FieldId, PBowSpV& SpV) const;    
+    void GetFieldBowSpV(const TThinMem& RecMem, const int& FieldId, PBowSpV& SpV) const;    
+	/// Field getter returning view into RecMem
+    TStrView GetFieldStrView(const TThinMem& RecMem, const int& FieldId) const;
+	/// Field getter returning view into RecMem
+    TFltVView GetFieldFltVView(const TThinMem& RecMem, const int& FieldId) const;
+	/// Write field value to JSon writer, same value as returned by TStore::GetFieldJson
+	void WriteFieldJson(const TThinMem& RecMem, const TFieldDesc& FieldDesc, TJsonWriter& Writer) const;
 
     /// Field setter
 	void SetFieldNull(const TMem& InRecMem, TMem& OutRecMem, const int& FieldId);
@@ -525,6 +716,9 @@ public:
     TRecIndexer() { }
     TRecIndexer(const TWPt<TIndex>& Index, const TWPt<TStore>& Store);
     
+    /// Redirect indexing to a different index with the same vocabulary (e.g. temporary index)
+    void SetIndex(const TWPt<TIndex>& _Index) { Index = _Index; }
+
     /// Index new record
     void IndexRec(const TMem& RecMem, const uint64& RecId, TRecSerializator& Serializator);
     /// Deindex existing record
@@ -537,6 +731,58 @@ public:
         const uint64& RecId, TIntSet& ChangedFieldIdSet, TRecSerializator& Serializator);
 };
 
+///////////////////////////////
+/// Field column.
+/// Values of one numeric or time field for all records of a store, stored
+/// in a dense vector ordered by record id. Integer and float fields are kept
+/// as doubles, uint64 and time fields (as milliseconds) as uint64. Values are
+/// added at the end and deleted from the front, same as records.
+class TFieldColumn {
+private:
+    /// Field id
+    TInt FieldId;
+    /// True when values are kept as doubles
+    TBool FltP;
+    /// Record id of the first value that was not deleted
+    TUInt64 FirstRecId;
+    /// Position of the first value that was not deleted
+    TUInt64 FirstValN;
+    /// Values of integer and float fields
+    TVec<TFlt, int64> FltV;
+    /// Values of uint64 and time fields
+    TVec<TUInt64, int64> UInt64V;
+
+    /// Number of values in the vector, including the deleted ones
+    int64 GetVals() const { return FltP ? FltV.Len() : UInt64V.Len(); }
+    /// Position of the record's value in the vector
+    int64 GetValN(const uint64& RecId) const { return int64(RecId - FirstRecId + FirstValN); }
+    /// Position of the record's value, adds new value at the end when needed
+    int64 GetSetValN(const uint64& RecId);
+
+public:
+    TFieldColumn(): FieldId(-1), FltP(false) { }
+    TFieldColumn(const int& _FieldId, const bool& _FltP): FieldId(_FieldId), FltP(_FltP) { }
+
+    int GetFieldId() const { return FieldId; }
+    /// True when values are kept as doubles
+    bool IsFlt() const { return FltP; }
+    /// Number of records in the column
+    uint64 Len() const { return uint64(GetVals()) - FirstValN; }
+    bool IsRecId(const uint64& RecId) const { return (FirstRecId <= RecId) && (RecId - FirstRecId < Len()); }
+
+    /// Get value of integer or float field
+    double GetFlt(const uint64& RecId) const { return FltV[GetValN(RecId)]; }
+    /// Get value of uint64 or time field
+    uint64 GetUInt64(const uint64& RecId) const { return UInt64V[GetValN(RecId)]; }
+    /// Set value of existing record or add the value of the next record
+    void SetFlt(const uint64& RecId, const double& Val) { FltV[GetSetValN(RecId)] = Val; }
+    /// Set value of existing record or add the value of the next record
+    void SetUInt64(const uint64& RecId, const uint64& Val) { UInt64V[GetSetValN(RecId)] = Val; }
+    /// Delete values of first records. Memory is released once deleted
+    /// values take more than half of the vector.
+    void DelVals(const uint64& Vals);
+};
+
 ///////////////////////////////
 /// Implementation of store which can be initialized from a schema.
 class TStoreImpl: public TStore {
@@ -571,6 +817,13 @@ private:
 	THash<TFlt, TUInt64> PrimaryFltIdH;
 	/// Hash map from TTm primary field to record ID
 	THash<TUInt64, TUInt64> PrimaryTmMSecsIdH;
+	/// Changes of primary field map since the last checkpoint, as pairs of
+	/// key and record ID (TUInt64::Mx for deleted keys)
+	TMOut PrimaryDeltaMOut;
+	/// Number of changes in PrimaryDeltaMOut
+	TUInt64 PrimaryDeltaOps;
+	/// Codebook and primary field map changes saved after the last full save of parameters
+	TFDelta PrimaryDelta;
 	
     /// Flag if we are using cache store
     TBool DataCacheP;
@@ -586,19 +839,50 @@ private:
 	TRecSerializator SerializatorMem;
     /// Map from fields to storage location
     TVec<TStoreLoc> FieldLocV;
+    /// Once checkpointed, store is saved only by checkpoints
+    TBool CheckpointP;
+    /// Codebook strings already saved by checkpoints
+    TInt SavedCacheCodebookLen, SavedMemCodebookLen;
+    /// Codebook strings included in the checkpoint waiting for commit
+    TInt CommitCacheCodebookLen, CommitMemCodebookLen;
     
     // record indexer
     TRecIndexer RecIndexer;
     
 	/// Time window settings
 	TStoreWndDesc WndDesc;
+
+    /// Ids of fields with columns
+    TIntV ColumnFieldIdV;
+    /// Columns of fields in ColumnFieldIdV, filled from records on first use
+    mutable TVec<TFieldColumn> ColumnV;
+    /// Map from field id to its column position (-1 when no column)
+    TIntV FieldColumnNV;
+    /// True when columns hold values of all records
+    mutable TBool ColumnsFilledP;
+    /// Synchronizes filling of columns from concurrent readers
+    mutable TSysCs ColumnSection;
     
     /// initialize field storage location map
     void InitFieldLocV();
+    /// Create columns for ColumnFieldIdV. Columns of a store with records
+    /// are filled on first use, so opening the store does not scan it.
+    void InitColumns();
+    /// Fill columns with values of existing records, if not filled yet
+    void FillColumns() const;
+    /// Copy the value of a field from the record to its column
+    void ReadColumnVal(const int& ColumnN, const uint64& RecId) const;
+    /// Update the value of a field in its column (skipped when columns are not filled yet)
+    void SetColumnVal(const int& ColumnN, const uint64& RecId);
+    /// Update values of all columns of a record
+    void SetColumnVals(const uint64& RecId);
     /// Get TMem serialization of record from specified storage
 	void GetRecMem(const TStoreLoc& RecLoc, const uint64& RecId, TMem& Rec) const;
     /// Get TMem serialization of record from specified where field is stored
 	void GetRecMem(const uint64& RecId, const int& FieldId, TMem& Rec) const;
+    /// Get serialization of record from storage where field is stored. Points
+    /// directly into in-memory storage, records from disk are copied to RecMem.
+	TThinMem GetRecThinMem(const uint64& RecId, const int& FieldId, TMem& RecMem) const;
     /// Set TMem serialization of record to a specified storage
 	void PutRecMem(const TStoreLoc& RecLoc, const uint64& RecId, const TMem& Rec);
     /// Set TMem serialization of record to storage where field is stored
@@ -623,6 +907,24 @@ private:
     void SetPrimaryField(const uint64& RecId);
     /// Delete primary field map
     void DelPrimaryField(const uint64& RecId);
+    /// Remember change of primary field map for the next checkpoint
+    template <class TKey> void AddPrimaryDelta(const TKey& Key, const uint64& RecId);
+    /// Apply changes of primary field map saved by a checkpoint, returns their number
+    template <class TKey> static uint64 LoadPrimaryDelta(TSIn& SIn, THash<TKey, TUInt64>& PrimaryIdH);
+    /// Number of keys in primary field map
+    int GetPrimaryKeys() const;
+    /// Get id of existing record referred to by $id or primary field, returns
+    /// TUInt64::Mx when record is new. Throws exception when reference invalid.
+    uint64 GetRefRecId(const PJsonVal& RecVal) const;
+    /// Store and index new record, serialized for disk and in-memory storage
+    uint64 AddRecMem(const TMem& CacheRecMem, const TMem& MemRecMem);
+    /// Serialize new record directly from JSon string, without building TJsonVal.
+    /// Returns false when the string is not valid or has keys other than fields
+    /// (e.g. nested joins or $id), in which case it should go through AddRec.
+    bool SerializeJsonStr(const TStr& RecJsonStr, const TTm& InsertTm, TMem& CacheRecMem, TMem& MemRecMem);
+    /// Get id of existing record with the same primary field value as the
+    /// serialized record, returns TUInt64::Mx when there is none
+    uint64 GetPrimaryRecId(const TMem& CacheRecMem, const TMem& MemRecMem) const;
     /// Transform Join name to it's corresponding field name
     TStr GetJoinFieldNm(const TStr& JoinNm) const { return JoinNm + "Id"; }
     
@@ -630,6 +932,10 @@ private:
 	void InitFromSchema(const TStoreSchema& StoreSchema);    
     /// Initialize field location flags
     void InitDataFlags();
+    /// Save store parameters and primary field map
+    void SaveGeneric(TSOut& SOut);
+    /// Log new value of the field when it was set by outermost operation
+    void OnSetField(const TWalOp& WalOp, const uint64& RecId, const int& FieldId);
 
 public:
 	TStoreImpl(const TWPt<TBase>& _Base, const uint& StoreId, 
@@ -640,6 +946,11 @@ public:
 	// need to override destructor, to clear cache
 	~TStoreImpl();
 
+    /// Add store parameters and changed records to the commit
+    void Checkpoint(TFCommit& Commit);
+    /// Release space freed before the last commit
+    void OnCommit();
+
 	bool IsRecId(const uint64& RecId) const;
 	bool HasRecNm() const { return RecNmFieldP; }
 	bool IsRecNm(const TStr& RecNm) const;
@@ -659,8 +970,17 @@ public:
     
 	/// Add new record
 	uint64 AddRec(const PJsonVal& RecVal);
+	/// Add new record directly from JSon string when it has no joins and
+	/// does not refer to an existing record
+	bool TryAddRecJsonStr(const TStr& RecJsonStr, uint64& RecId);
 	/// Update existing record
 	void UpdateRec(const uint64& RecId, const PJsonVal& RecVal);
+    /// Add records from a stream of JSon lines. Records are serialized in parallel when
+    /// serializators allow it, directly from the lines when they contain only fields, indexed into temporary indices and merged into the main
+    /// index at the end. Nested join records, updates of existing records and triggers
+    /// are processed in a final pass.
+	uint64 AddRecBulk(const PSIn& SIn, const int& BatchLen = 10000,
+        const int64& IndexCacheSize = int64(TInt::Giga), const bool& TriggerP = true);
 
     /// Purge records that fall out of store window (when it has one)
 	void GarbageCollect();
@@ -695,6 +1015,18 @@ public:
     void GetFieldNumSpV(const uint64& RecId, const int& FieldId, TIntFltKdV& SpV) const;
     /// Get field value using field id (default implementation throws exception)
     void GetFieldBowSpV(const uint64& RecId, const int& FieldId, PBowSpV& SpV) const;
+    /// Get view of string field value, RecMem is used only for records on disk
+	TStrView GetFieldStrView(const uint64& RecId, const int& FieldId, TMem& RecMem) const;
+    /// Write fields into JSon writer, reading each part of the record only once
+    void WriteRecFieldsJson(const uint64& RecId, const TIntV& FieldIdV, TJsonWriter& Writer) const;
+    /// Statistics of disk record cache
+    PJsonVal GetStoreStatJson() const;
+    /// Check if the store keeps a column with values of given field
+    bool IsFieldColumn(const int& FieldId) const { return FieldColumnNV[FieldId] != -1; }
+    /// Get values of integer or float field, read from column when available
+    void GetFieldFltColumn(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TFltV& ValV) const;
+    /// Get values of uint64 or time field, read from column when available
+    void GetFieldUInt64Column(const TUInt64IntKdV& RecIdFqV, const int& FieldId, TUInt64V& ValV) const;
     
 	/// Set the value of given field to NULL
 	void SetFieldNull(const uint64& RecId, const int& FieldId);
@@ -33,6 +33,43 @@ void TSrvFun::RegDefFun(const TWPt<TBase>& Base, TSAppSrvFunV& SrvFunV) {
 	SrvFunV.Add(TSfStores::New(Base));
 	SrvFunV.Add(TSfWordVoc::New(Base));
 	SrvFunV.Add(TSfStoreRec::New(Base));
+	SrvFunV.Add(TSfStoreRecs::New(Base));
+}
+
+void TSrvFun::Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
+	if (IsReadOnly()) {
+		TBase::TReadLock ReadLock(*Base);
+		TSAppSrvFun::Exec(FldNmValPrV, RqEnv);
+	} else {
+		TBase::TWriteLock WriteLock(*Base);
+		TSAppSrvFun::Exec(FldNmValPrV, RqEnv);
+	}
+}
+
+TWPt<TStore> TSrvFun::GetStore(const TStrKdV& FldNmValPrV) const {
+	if (IsFldNm(FldNmValPrV, "storeid")) {
+		TStr StoreIdStr = GetFldVal(FldNmValPrV, "storeid");
+		QmAssertR(StoreIdStr.IsInt(), "Missing or invalid store ID " + StoreIdStr);
+		const uint StoreId = StoreIdStr.GetUInt();
+		QmAssertR(Base->IsStoreId(StoreId), "No store with ID " + StoreIdStr);
+		return Base->GetStoreByStoreId(StoreId);
+	} else if (IsFldNm(FldNmValPrV, "store")) {
+		TStr StoreNm = GetFldVal(FldNmValPrV, "store");
+		QmAssertR(Base->IsStoreNm(StoreNm), "No store with name " + StoreNm);
+		return Base->GetStoreByStoreNm(StoreNm);
+	}
+	throw TQmExcept::New("No 'store' or 'storeid' parameter to define the store");
+}
+
+void TSrvFun::GetFieldIdV(const TStrKdV& FldNmValPrV, const TWPt<TStore>& Store, TIntV& FieldIdV) const {
+	// fields to output, given by one or more 'field' parameters
+	TStrV FieldNmV; GetFldValV(FldNmValPrV, "field", FieldNmV);
+	FieldIdV.Clr();
+	for (int FieldNmN = 0; FieldNmN < FieldNmV.Len(); FieldNmN++) {
+		const TStr& FieldNm = FieldNmV[FieldNmN];
+		QmAssertR(Store->IsFieldNm(FieldNm), "No field with name " + FieldNm);
+		FieldIdV.Add(Store->GetFieldId(FieldNm));
+	}
 }
 
 ///////////////////////////////////////////
@@ -161,21 +198,6 @@ TStr TSfWordVoc::ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv
 
 ///////////////////////////////////////////
 // QMiner-Server-Function-Record
-TWPt<TStore> TSfStoreRec::GetStore(const TStrKdV& FldNmValPrV) const {
-	if (IsFldNm(FldNmValPrV, "storeid")) {
-		TStr StoreIdStr = GetFldVal(FldNmValPrV, "storeid");
-		QmAssertR(StoreIdStr.IsInt(), "Missing or invalid store ID " + StoreIdStr);
-		const uint StoreId = StoreIdStr.GetUInt();
-		QmAssertR(Base->IsStoreId(StoreId), "No store with ID " + StoreIdStr);
-		return Base->GetStoreByStoreId(StoreId);
-	} else if (IsFldNm(FldNmValPrV, "store")) {
-		TStr StoreNm = GetFldVal(FldNmValPrV, "store");
-		QmAssertR(Base->IsStoreNm(StoreNm), "No store with name " + StoreNm);
-		return Base->GetStoreByStoreNm(StoreNm);
-	}
-	throw TQmExcept::New("No 'store' or 'storeid' parameter to define the store");
-}
-
 TRec TSfStoreRec::GetRec(const TStrKdV& FldNmValPrV, const TWPt<TStore>& Store) const {
 	if (IsFldNm(FldNmValPrV, "recid")) {
 		TStr RecIdStr = GetFldVal(FldNmValPrV, "recid");
@@ -195,7 +217,24 @@ TStr TSfStoreRec::ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEn
 	TWPt<TStore> Store = GetStore(FldNmValPrV);
 	TRec Rec = GetRec(FldNmValPrV, Store);
 	const bool JoinRecsP = IsFldNmVal(FldNmValPrV, "join", "T");
-	return TJsonVal::GetStrFromVal(Rec.GetJson(Base, true, true, JoinRecsP));
+	TIntV FieldIdV; GetFieldIdV(FldNmValPrV, Store, FieldIdV);
+	TJsonWriter Writer; Rec.WriteJson(Base, Writer, true, true, JoinRecsP, false, true, FieldIdV);
+	return Writer.GetStr();
+}
+
+///////////////////////////////////////////
+// QMiner-Server-Function-Records
+void TSfStoreRecs::ExecJSonStream(const TStrKdV& FldNmValPrV, 
+		const PSAppSrvRqEnv& RqEnv, TJsonWriter& Writer) {
+	TWPt<TStore> Store = GetStore(FldNmValPrV);
+	const int Offset = GetFldInt(FldNmValPrV, "offset", 0);
+	const int Limit = GetFldInt(FldNmValPrV, "limit", 100);
+	QmAssertR(Offset >= 0 && Limit >= 0, "Invalid offset or limit");
+	const bool JoinRecsP = IsFldNmVal(FldNmValPrV, "join", "T");
+	TIntV FieldIdV; GetFieldIdV(FldNmValPrV, Store, FieldIdV);
+	// records are written straight from the store, without building the JSon tree
+	PRecSet RecSet = Store->GetAllRecs();
+	RecSet->WriteJson(Base, Writer, Limit, Offset, true, false, true, JoinRecsP, false, FieldIdV);
 }
 
 ///////////////////////////////////////////
@@ -38,8 +38,16 @@ protected:
 		 TSAppSrvFun(FunNm, OutType), Base(_Base) { }
 
 	const TWPt<TBase>& GetBase() const { return Base; }
+
+	// helper functions for parsing input parameters
+	TWPt<TStore> GetStore(const TStrKdV& FldNmValPrV) const;
+	void GetFieldIdV(const TStrKdV& FldNmValPrV, const TWPt<TStore>& Store, TIntV& FieldIdV) const;
 public:
 	static void RegDefFun(const TWPt<TBase>& Base, TSAppSrvFunV& SrvFunV);
+
+	// executes the function holding the base lock, for reading when read-only
+	// so such functions can run on workers next to each other, otherwise for writing
+	void Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv);
 };
 
 ///////////////////////////////////////////
@@ -77,6 +85,7 @@ public:
 	static PSAppSrvFun New(const TWPt<TBase>& Base) { return new TSfStores(Base); }
 	static PJsonVal GetStoreJson(const TWPt<TBase>& Base, const TWPt<TStore>& Store);
 
+	bool IsReadOnly() const { return true; }
 	TStr ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv);
 };
 
@@ -91,6 +100,7 @@ private:
 public:
 	static PSAppSrvFun New(const TWPt<TBase>& Base) { return new TSfWordVoc(Base); }
 
+	bool IsReadOnly() const { return true; }
 	TStr ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv);
 };
 
@@ -100,16 +110,29 @@ public:
 class TSfStoreRec: public TSrvFun {
 private:
 	// helper functions for parsing input parameters
-	TWPt<TStore> GetStore(const TStrKdV& FldNmValPrV) const;
 	TRec GetRec(const TStrKdV& FldNmValPrV, const TWPt<TStore>& Store) const;
 
 	TSfStoreRec(const TWPt<TBase>& Base): TSrvFun(Base, "qm_record", saotJSon) { }
 public:
 	static PSAppSrvFun New(const TWPt<TBase>& Base) { return new TSfStoreRec(Base); }
 
+	bool IsReadOnly() const { return true; }
 	TStr ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv);
 };
 
+///////////////////////////////////////////
+// QMiner-Server-Function-Records
+//  lists records from a store, page by page; large pages are sent in chunks
+class TSfStoreRecs: public TSrvFun {
+private:
+	TSfStoreRecs(const TWPt<TBase>& Base): TSrvFun(Base, "qm_records", saotJSonStream) { }
+public:
+	static PSAppSrvFun New(const TWPt<TBase>& Base) { return new TSfStoreRecs(Base); }
+
+	bool IsReadOnly() const { return true; }
+	void ExecJSonStream(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv, TJsonWriter& Writer);
+};
+
 ///////////////////////////////////////////
 // QMiner-Server-Function-Debug
 //  dumps statistics to disk
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+#include <mine.h>
+
+// Generate document with Words tokens, token ids follow a Zipfian
+// distribution over Dims tokens
+TStrV GenZipfDoc(TRnd& Rnd, const int& Words, const int& Dims) {
+  TStrV TokenStrV;
+  for (int WordN = 0; WordN < Words; WordN++) {
+    const int Rank = TInt::GetMn((int)TMath::Power((double)Dims, Rnd.GetUniDev()), Dims);
+    TokenStrV.Add(TStr::Fmt("W%d", Rank));
+  }
+  return TokenStrV;
+}
+
+// Unbounded vocabulary grows with the stream, bounded stays fixed
+// and keeps the frequent tokens
+TEST(TBagOfWords, BoundedVocab) {
+  const int Docs = 20000, MxVocabSize = 500;
+  TRnd Rnd(1);
+  TFtrGen::TBagOfWords FullBow(true, true, true, TTokenizers::TSimple::New());
+  TFtrGen::TBagOfWords BoundedBow(true, true, true, TTokenizers::TSimple::New(),
+    -1, false, 1, 1, MxVocabSize);
+  EXPECT_TRUE(BoundedBow.IsBoundedVocab());
+  int Remaps = 0;
+  for (int DocN = 0; DocN < Docs; DocN++) {
+    TStrV TokenStrV = GenZipfDoc(Rnd, 20, 100000);
+    FullBow.Update(TokenStrV);
+    const bool DimUpdateP = BoundedBow.Update(TokenStrV);
+    EXPECT_TRUE(!DimUpdateP || BoundedBow.GetDim() <= MxVocabSize);
+    TIntV DimV; BoundedBow.GetRemappedDimV(DimV);
+    for (int DimN = 0; DimN < DimV.Len(); DimN++) {
+      EXPECT_TRUE(0 <= DimV[DimN] && DimV[DimN] < MxVocabSize); }
+    Remaps += DimV.Len();
+  }
+  EXPECT_LT(10 * MxVocabSize, FullBow.GetDim());
+  EXPECT_EQ(MxVocabSize, BoundedBow.GetDim());
+  EXPECT_LT(0, Remaps);
+  // most frequent tokens must be in the bounded vocabulary
+  TStrSet BoundedTokenSet;
+  for (int DimN = 0; DimN < BoundedBow.GetDim(); DimN++) {
+    BoundedTokenSet.AddKey(BoundedBow.GetVal(DimN)); }
+  EXPECT_EQ(MxVocabSize, BoundedTokenSet.Len());
+  for (int Rank = 1; Rank <= 20; Rank++) {
+    EXPECT_TRUE(BoundedTokenSet.IsKey(TStr::Fmt("W%d", Rank))); }
+  // extracted features only use the bounded dimensions
+  TIntFltKdV SpV; BoundedBow.AddFtr(GenZipfDoc(Rnd, 20, 100000), SpV);
+  EXPECT_LT(0, SpV.Len());
+  for (int SpN = 0; SpN < SpV.Len(); SpN++) { EXPECT_LT(SpV[SpN].Key, MxVocabSize); }
+}
+
+// Bounded vocabulary continues after save and load as if never saved
+TEST(TBagOfWords, BoundedVocabSaveLoad) {
+  const int MxVocabSize = 100;
+  TRnd Rnd(1);
+  TFtrGen::TBagOfWords Bow(true, true, true, TTokenizers::TSimple::New(),
+    -1, false, 1, 1, MxVocabSize);
+  for (int DocN = 0; DocN < 1000; DocN++) { Bow.Update(GenZipfDoc(Rnd, 10, 10000)); }
+  { TFOut FOut("bow.bin"); Bow.Save(FOut); }
+  TFIn FIn("bow.bin"); TFtrGen::TBagOfWords LoadBow(FIn);
+  EXPECT_EQ(MxVocabSize, LoadBow.GetMxVocabSize());
+  for (int DocN = 0; DocN < 1000; DocN++) {
+    TStrV TokenStrV = GenZipfDoc(Rnd, 10, 10000);
+    Bow.Update(TokenStrV); LoadBow.Update(TokenStrV);
+  }
+  for (int DimN = 0; DimN < MxVocabSize; DimN++) {
+    EXPECT_EQ(Bow.GetVal(DimN), LoadBow.GetVal(DimN)); }
+  TIntV DimV, LoadDimV; Bow.GetRemappedDimV(DimV); LoadBow.GetRemappedDimV(LoadDimV);
+  EXPECT_TRUE(DimV == LoadDimV);
+  TFile::Del("bow.bin");
+}
+
+// Documents used to check loading of streams saved before vocabulary size limit
+TVec<TStrV> GetUnboundedLayoutDocs() {
+  TVec<TStrV> DocV;
+  DocV.Add(TStrV::GetV("W1", "W2", "W3"));
+  DocV.Add(TStrV::GetV("W1", "W2", "W4"));
+  DocV.Add(TStrV::GetV("W1", "W5"));
+  return DocV;
+}
+
+// Save TFIDF bag of words after the above documents in the layout
+// before vocabulary size limit, without limit and remapped dimensions
+void SaveUnboundedLayout(TSOut& SOut) {
+  TInt(7).Save(SOut);
+  TTokenizers::TSimple::New()->Save(SOut);
+  TStrSet TokenSet;
+  for (int TokenN = 1; TokenN <= 5; TokenN++) { TokenSet.AddKey(TStr::Fmt("W%d", TokenN)); }
+  TokenSet.Save(SOut);
+  TInt(0).Save(SOut); TBool(false).Save(SOut);
+  TInt(1).Save(SOut); TInt(1).Save(SOut);
+  TInt(3).Save(SOut); TIntV::GetV(3, 2, 1, 1, 1).Save(SOut);
+  TBool(false).Save(SOut); TFlt(0.0).Save(SOut); TFltV(5).Save(SOut);
+  TVec<TStrSet>().Save(SOut);
+}
+
+// Streams saved before vocabulary size limit load with unbounded vocabulary
+TEST(TBagOfWords, LoadUnboundedLayout) {
+  TFtrGen::TBagOfWords Bow(true, true, true, TTokenizers::TSimple::New());
+  TVec<TStrV> DocV = GetUnboundedLayoutDocs();
+  for (int DocN = 0; DocN < DocV.Len(); DocN++) { Bow.Update(DocV[DocN]); }
+  TMOut SOut; SaveUnboundedLayout(SOut);
+  PSIn SIn = SOut.GetSIn(); TFtrGen::TBagOfWords LoadBow(*SIn);
+  EXPECT_TRUE(SIn->Eof());
+  EXPECT_FALSE(LoadBow.IsBoundedVocab());
+  EXPECT_EQ(Bow.GetDim(), LoadBow.GetDim());
+  TRnd Rnd(1);
+  for (int DocN = 0; DocN < 1000; DocN++) {
+    TStrV TokenStrV = GenZipfDoc(Rnd, 10, 10000);
+    Bow.Update(TokenStrV); LoadBow.Update(TokenStrV);
+  }
+  EXPECT_EQ(Bow.GetDim(), LoadBow.GetDim());
+  TIntFltKdV SpV, LoadSpV; TStrV TokenStrV = GenZipfDoc(Rnd, 20, 10000);
+  Bow.AddFtr(TokenStrV, SpV); LoadBow.AddFtr(TokenStrV, LoadSpV);
+  EXPECT_TRUE(SpV == LoadSpV);
+  // and saves in the current layout
+  TMOut NewSOut; LoadBow.Save(NewSOut);
+  PSIn NewSIn = NewSOut.GetSIn(); TFtrGen::TBagOfWords NewLoadBow(*NewSIn);
+  EXPECT_EQ(Bow.GetDim(), NewLoadBow.GetDim());
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+
+// Test files live in the current folder
+const TStr BlobBsTestFPath = "./blobbs-test/";
+
+void InitBlobBsTestFPath() {
+  if (TDir::Exists(BlobBsTestFPath)) {
+    TStrV FNmV; TFFile::GetFNmV(BlobBsTestFPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(BlobBsTestFPath);
+  }
+}
+
+TStr GetRepStr(const char& Ch, const int& Len) {
+  TChA ChA; for (int ChN = 0; ChN < Len; ChN++) { ChA += Ch; } return ChA;
+}
+
+TStr GetBlobStr(const PBlobBs& BlobBs, const TBlobPt& BlobPt) {
+  PSIn SIn = BlobBs->GetBlob(BlobPt); return TStr::LoadTxt(SIn);
+}
+
+// All files are replaced and deleted, no temporary files are left behind
+TEST(TFCommit, Commit) {
+  InitBlobBsTestFPath();
+  const TStr FNm1 = BlobBsTestFPath + "a.txt", FNm2 = BlobBsTestFPath + "b.txt";
+  const TStr DelFNm = BlobBsTestFPath + "c.txt", CommitFNm = BlobBsTestFPath + "test.commit";
+  TStr("old a").SaveTxt(FNm1); TStr("old c").SaveTxt(DelFNm);
+  {
+    TFCommit Commit(CommitFNm);
+    TStr("new a").SaveTxt(Commit.AddFNm(FNm1));
+    TStr("new b").SaveTxt(Commit.AddFNm(FNm2));
+    Commit.DelFNm(DelFNm);
+    Commit.Commit();
+    EXPECT_TRUE(Commit.IsCommit());
+  }
+  EXPECT_EQ(TStr::LoadTxt(FNm1), "new a");
+  EXPECT_EQ(TStr::LoadTxt(FNm2), "new b");
+  EXPECT_FALSE(TFile::Exists(DelFNm));
+  EXPECT_FALSE(TFile::Exists(CommitFNm));
+  EXPECT_FALSE(TFile::Exists(FNm1 + ".tmp"));
+  EXPECT_FALSE(TFCommit::Recover(CommitFNm));
+}
+
+// Commit not executed leaves old versions in place
+TEST(TFCommit, Abandon) {
+  InitBlobBsTestFPath();
+  const TStr FNm = BlobBsTestFPath + "a.txt", CommitFNm = BlobBsTestFPath + "test.commit";
+  TStr("old a").SaveTxt(FNm);
+  {
+    TFCommit Commit(CommitFNm);
+    TStr("new a").SaveTxt(Commit.AddFNm(FNm));
+  }
+  EXPECT_EQ(TStr::LoadTxt(FNm), "old a");
+  EXPECT_FALSE(TFile::Exists(FNm + ".tmp"));
+  EXPECT_FALSE(TFCommit::Recover(CommitFNm));
+  EXPECT_EQ(TStr::LoadTxt(FNm), "old a");
+}
+
+// Commit record written but files not moved (crash during commit)
+TEST(TFCommit, Recover) {
+  InitBlobBsTestFPath();
+  const TStr FNm1 = BlobBsTestFPath + "a.txt", FNm2 = BlobBsTestFPath + "b.txt";
+  const TStr CommitFNm = BlobBsTestFPath + "test.commit";
+  TStr("old a").SaveTxt(FNm1); TStr("old b").SaveTxt(FNm2);
+  // first file already moved, second not yet
+  TStr("new a").SaveTxt(FNm1);
+  TStr("new b").SaveTxt(FNm2 + ".tmp");
+  TStrV FNmV = TStrV::GetV(FNm1, FNm2), DelFNmV;
+  { TFOut FOut(CommitFNm); FNmV.Save(FOut); DelFNmV.Save(FOut); }
+  EXPECT_TRUE(TFCommit::Recover(CommitFNm));
+  EXPECT_EQ(TStr::LoadTxt(FNm1), "new a");
+  EXPECT_EQ(TStr::LoadTxt(FNm2), "new b");
+  EXPECT_FALSE(TFile::Exists(CommitFNm));
+  // incomplete commit record is ignored
+  TStr("new a again").SaveTxt(FNm1 + ".tmp");
+  { TFOut FOut(CommitFNm + ".tmp"); FNmV.Save(FOut); }
+  EXPECT_FALSE(TFCommit::Recover(CommitFNm));
+  EXPECT_EQ(TStr::LoadTxt(FNm1), "new a");
+  EXPECT_FALSE(TFile::Exists(CommitFNm + ".tmp"));
+}
+
+// Deltas are counted after commit and removed by the next snapshot
+TEST(TFDelta, Checkpoint) {
+  InitBlobBsTestFPath();
+  const TStr FNm = BlobBsTestFPath + "a.dat", CommitFNm = BlobBsTestFPath + "test.commit";
+  TFDelta Delta(FNm);
+  { TFCommit Commit(CommitFNm); TStr("snapshot").SaveTxt(Delta.AddSnapshot(Commit)); Commit.Commit(); }
+  Delta.OnCommit();
+  EXPECT_EQ(Delta.GetDeltas(), 0);
+  for (int DeltaN = 0; DeltaN < 3; DeltaN++) {
+    TFCommit Commit(CommitFNm);
+    TStr::Fmt("delta %d", DeltaN).SaveTxt(Delta.AddDelta(Commit, 1));
+    Commit.Commit(); Delta.OnCommit();
+  }
+  // abandoned checkpoint does not count
+  { TFCommit Commit(CommitFNm); TStr("lost").SaveTxt(Delta.AddDelta(Commit, 1)); }
+  EXPECT_EQ(Delta.GetDeltas(), 3);
+  EXPECT_FALSE(TFile::Exists(Delta.GetDeltaFNm(3)));
+  EXPECT_TRUE(Delta.IsSnapshotDue(4));
+  EXPECT_FALSE(Delta.IsSnapshotDue(6));
+  // reopening finds existing deltas
+  TFDelta LoadDelta(FNm);
+  EXPECT_EQ(LoadDelta.GetDeltas(), 3);
+  EXPECT_EQ(TStr::LoadTxt(LoadDelta.GetDeltaFNm(2)), "delta 2");
+  { TFCommit Commit(CommitFNm); TStr("new snapshot").SaveTxt(LoadDelta.AddSnapshot(Commit)); Commit.Commit(); }
+  LoadDelta.OnCommit();
+  EXPECT_EQ(LoadDelta.GetDeltas(), 0);
+  EXPECT_EQ(TStr::LoadTxt(FNm), "new snapshot");
+  EXPECT_FALSE(TFile::Exists(LoadDelta.GetDeltaFNm(0)));
+}
+
+// Changes after a checkpoint do not overwrite checkpointed blobs, so reopening
+// without the next checkpoint sees the checkpointed state
+TEST(TBlobBs, Checkpoint) {
+  InitBlobBsTestFPath();
+  const TStr BlobBsFNm = BlobBsTestFPath + "test.mbb", CommitFNm = BlobBsTestFPath + "test.commit";
+  const int Blobs = 200;
+  TRnd Rnd(1); TBlobPtV BlobPtV; TStrV BlobStrV;
+  {
+    PBlobBs BlobBs = TMBlobBs::New(BlobBsFNm, faCreate);
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) {
+      BlobStrV.Add(TStr::Fmt("blob %d ", BlobN) + GetRepStr('x', Rnd.GetUniDevInt(100)));
+      BlobPtV.Add(BlobBs->PutBlob(BlobStrV.Last()));
+    }
+    TFCommit Commit(CommitFNm);
+    BlobBs->Checkpoint(Commit);
+    Commit.Commit();
+    BlobBs->OnCommit();
+    // changes after checkpoint, blob-base is closed without another one
+    for (int BlobN = 0; BlobN < Blobs; BlobN += 2) {
+      BlobBs->PutBlob(BlobPtV[BlobN], TStrIn::New(GetRepStr('y', Rnd.GetUniDevInt(100))));
+    }
+    for (int BlobN = 1; BlobN < Blobs; BlobN += 4) { BlobBs->DelBlob(BlobPtV[BlobN]); }
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) { BlobBs->PutBlob(GetRepStr('z', 50)); }
+  }
+  {
+    PBlobBs BlobBs = TMBlobBs::New(BlobBsFNm, faUpdate);
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) {
+      EXPECT_EQ(GetBlobStr(BlobBs, BlobPtV[BlobN]), BlobStrV[BlobN]);
+    }
+    // traversal sees only checkpointed blobs
+    TBlobPt TrvBlobPt = BlobBs->FFirstBlobPt(); PSIn SIn; int TrvBlobs = 0;
+    while (BlobBs->FNextBlobPt(TrvBlobPt, SIn)) { TrvBlobs++; }
+    EXPECT_EQ(TrvBlobs, Blobs);
+    // new changes are committed with the next checkpoint
+    for (int BlobN = 0; BlobN < Blobs; BlobN += 2) {
+      BlobStrV[BlobN] = GetRepStr('w', Rnd.GetUniDevInt(200));
+      BlobPtV[BlobN] = BlobBs->PutBlob(BlobPtV[BlobN], TStrIn::New(BlobStrV[BlobN]));
+    }
+    TFCommit Commit(CommitFNm);
+    BlobBs->Checkpoint(Commit);
+    Commit.Commit();
+    BlobBs->OnCommit();
+  }
+  {
+    PBlobBs BlobBs = TMBlobBs::New(BlobBsFNm, faRdOnly);
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) {
+      EXPECT_EQ(GetBlobStr(BlobBs, BlobPtV[BlobN]), BlobStrV[BlobN]);
+    }
+  }
+}
+
+// Positional reads see the same blobs as stream reads, also right after
+// writes and from several threads at once
+TEST(TBlobBs, GetBlobAt) {
+  InitBlobBsTestFPath();
+  const TStr BlobBsFNm = BlobBsTestFPath + "test.mbb";
+  const int Blobs = 200;
+  TRnd Rnd(1); TBlobPtV BlobPtV; TStrV BlobStrV;
+  {
+    PBlobBs BlobBs = TMBlobBs::New(BlobBsFNm, faCreate);
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) {
+      BlobStrV.Add(TStr::Fmt("blob %d ", BlobN) + GetRepStr('x', Rnd.GetUniDevInt(1000)));
+      BlobPtV.Add(BlobBs->PutBlob(BlobStrV.Last()));
+      EXPECT_EQ(TStr::LoadTxt(BlobBs->GetBlobAt(BlobPtV.Last())), BlobStrV.Last());
+    }
+    // changed in place and moved blobs
+    for (int BlobN = 0; BlobN < Blobs; BlobN += 3) {
+      BlobStrV[BlobN] = GetRepStr('y', Rnd.GetUniDevInt(2000));
+      BlobPtV[BlobN] = BlobBs->PutBlob(BlobPtV[BlobN], TStrIn::New(BlobStrV[BlobN]));
+    }
+    for (int BlobN = 0; BlobN < Blobs; BlobN++) {
+      EXPECT_EQ(TStr::LoadTxt(BlobBs->GetBlobAt(BlobPtV[BlobN])), GetBlobStr(BlobBs, BlobPtV[BlobN]));
+    }
+  }
+  PBlobBs BlobBs = TMBlobBs::New(BlobBsFNm, faRdOnly);
+  int Errors = 0;
+  #pragma omp parallel for num_threads(4) reduction(+:Errors)
+  for (int ReadN = 0; ReadN < 10 * Blobs; ReadN++) {
+    const int BlobN = ReadN % Blobs;
+    if (TStr::LoadTxt(BlobBs->GetBlobAt(BlobPtV[BlobN])) != BlobStrV[BlobN]) { Errors++; }
+  }
+  EXPECT_EQ(Errors, 0);
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder
+const TStr ColumnTestFPath = "./column-test/";
+
+void InitColumnTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  if (TDir::Exists(ColumnTestFPath)) {
+    TStrV FNmV; TFFile::GetFNmV(ColumnTestFPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(ColumnTestFPath);
+  }
+}
+
+// same fields in both stores, only the first one keeps columns
+const TStr ColumnSchema = "["
+  "{\"name\":\"Col\",\"fields\":["
+  "{\"name\":\"Int\",\"type\":\"int\",\"column\":true},"
+  "{\"name\":\"Flt\",\"type\":\"float\",\"column\":true},"
+  "{\"name\":\"Tm\",\"type\":\"datetime\",\"column\":true}]},"
+  "{\"name\":\"NoCol\",\"fields\":["
+  "{\"name\":\"Int\",\"type\":\"int\"},"
+  "{\"name\":\"Flt\",\"type\":\"float\"},"
+  "{\"name\":\"Tm\",\"type\":\"datetime\"}]}]";
+
+// few distinct values, so sorting has plenty of ties
+PJsonVal GetColumnRec(TRnd& Rnd) {
+  PJsonVal RecVal = TJsonVal::NewObj();
+  RecVal->AddToObj("Int", Rnd.GetUniDevInt(-50, 50));
+  RecVal->AddToObj("Flt", Rnd.GetUniDevInt(20) / 4.0);
+  RecVal->AddToObj("Tm", TStr::Fmt("2015-03-%02dT%02d:00:00", 1 + Rnd.GetUniDevInt(28), Rnd.GetUniDevInt(24)));
+  return RecVal;
+}
+
+// add the same records to both stores
+void AddColumnRecs(const TWPt<TBase>& Base, TRnd& Rnd, const int& Recs) {
+  for (int RecN = 0; RecN < Recs; RecN++) {
+    PJsonVal RecVal = GetColumnRec(Rnd);
+    Base->AddRec("Col", RecVal); Base->AddRec("NoCol", RecVal);
+  }
+}
+
+// ids of records in the set
+void GetColumnRecIdV(const PRecSet& RecSet, TUInt64V& RecIdV) {
+  RecIdV.Clr();
+  for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) { RecIdV.Add(RecSet->GetRecId(RecN)); }
+}
+
+// filters and sorts on store with columns match the ones reading records
+void CheckColumns(const TWPt<TBase>& Base) {
+  TWPt<TStore> ColStore = Base->GetStoreByStoreNm("Col");
+  TWPt<TStore> NoColStore = Base->GetStoreByStoreNm("NoCol");
+  ASSERT_TRUE(ColStore->IsFieldColumn(0));
+  ASSERT_FALSE(NoColStore->IsFieldColumn(0));
+  ASSERT_EQ(ColStore->GetRecs(), NoColStore->GetRecs());
+  TUInt64V ColRecIdV, NoColRecIdV;
+  // filters
+  PRecSet ColRecSet = ColStore->GetAllRecs(); ColRecSet->FilterByFieldInt(0, -10, 10);
+  PRecSet NoColRecSet = NoColStore->GetAllRecs(); NoColRecSet->FilterByFieldInt(0, -10, 10);
+  GetColumnRecIdV(ColRecSet, ColRecIdV); GetColumnRecIdV(NoColRecSet, NoColRecIdV);
+  EXPECT_FALSE(ColRecIdV.Empty()); EXPECT_EQ(ColRecIdV, NoColRecIdV);
+  ColRecSet = ColStore->GetAllRecs(); ColRecSet->FilterByFieldFlt(1, 1.0, 2.5);
+  NoColRecSet = NoColStore->GetAllRecs(); NoColRecSet->FilterByFieldFlt(1, 1.0, 2.5);
+  GetColumnRecIdV(ColRecSet, ColRecIdV); GetColumnRecIdV(NoColRecSet, NoColRecIdV);
+  EXPECT_FALSE(ColRecIdV.Empty()); EXPECT_EQ(ColRecIdV, NoColRecIdV);
+  const uint64 MnMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 10, -1, 0, 0, 0));
+  const uint64 MxMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 12, -1, 12, 0, 0));
+  ColRecSet = ColStore->GetAllRecs(); ColRecSet->FilterByFieldTm(2, MnMSecs, MxMSecs);
+  NoColRecSet = NoColStore->GetAllRecs(); NoColRecSet->FilterByFieldTm(2, MnMSecs, MxMSecs);
+  GetColumnRecIdV(ColRecSet, ColRecIdV); GetColumnRecIdV(NoColRecSet, NoColRecIdV);
+  EXPECT_FALSE(ColRecIdV.Empty()); EXPECT_EQ(ColRecIdV, NoColRecIdV);
+  // sorts, both directions and all field types
+  for (int FieldId = 0; FieldId < 3; FieldId++) {
+    for (int AscN = 0; AscN < 2; AscN++) {
+      ColRecSet = ColStore->GetAllRecs(); ColRecSet->SortByField(AscN == 0, FieldId);
+      NoColRecSet = NoColStore->GetAllRecs(); NoColRecSet->SortByField(AscN == 0, FieldId);
+      GetColumnRecIdV(ColRecSet, ColRecIdV); GetColumnRecIdV(NoColRecSet, NoColRecIdV);
+      EXPECT_EQ(ColRecIdV, NoColRecIdV);
+    }
+  }
+  // histogram and timeline read from columns
+  PJsonVal HistVal = TJsonVal::GetValFromStr("{\"field\":\"Flt\",\"buckets\":7}");
+  PJsonVal ColHistVal = TAggrs::THistogram::New(Base, "Hist", ColStore->GetAllRecs(), HistVal)->SaveJson();
+  PJsonVal NoColHistVal = TAggrs::THistogram::New(Base, "Hist", NoColStore->GetAllRecs(), HistVal)->SaveJson();
+  EXPECT_EQ(TJsonVal::GetStrFromVal(ColHistVal), TJsonVal::GetStrFromVal(NoColHistVal));
+  PJsonVal TimeLineVal = TJsonVal::GetValFromStr("{\"field\":\"Tm\"}");
+  PJsonVal ColTimeLineVal = TAggrs::TTimeLine::New(Base, "TimeLine", ColStore->GetAllRecs(), TimeLineVal)->SaveJson();
+  PJsonVal NoColTimeLineVal = TAggrs::TTimeLine::New(Base, "TimeLine", NoColStore->GetAllRecs(), TimeLineVal)->SaveJson();
+  EXPECT_EQ(TJsonVal::GetStrFromVal(ColTimeLineVal), TJsonVal::GetStrFromVal(NoColTimeLineVal));
+}
+
+// delete first records and change some values in both stores
+void ChangeColumnRecs(const TWPt<TBase>& Base, TRnd& Rnd) {
+  TWPt<TStore> ColStore = Base->GetStoreByStoreNm("Col");
+  TWPt<TStore> NoColStore = Base->GetStoreByStoreNm("NoCol");
+  ColStore->DeleteFirstNRecs(300); NoColStore->DeleteFirstNRecs(300);
+  PStoreIter Iter = ColStore->GetIter();
+  while (Iter->Next()) {
+    if (Rnd.GetUniDevInt(5) != 0) { continue; }
+    const uint64 RecId = Iter->GetRecId();
+    const int Int = Rnd.GetUniDevInt(-50, 50);
+    ColStore->SetFieldInt(RecId, 0, Int); NoColStore->SetFieldInt(RecId, 0, Int);
+    const double Flt = Rnd.GetUniDevInt(20) / 4.0;
+    ColStore->SetFieldFlt(RecId, 1, Flt); NoColStore->SetFieldFlt(RecId, 1, Flt);
+  }
+}
+
+TEST(TFieldColumn, FilterAndSort) {
+  InitColumnTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(ColumnTestFPath, TJsonVal::GetValFromStr(ColumnSchema), 1000000, 1000000);
+  AddColumnRecs(Base, Rnd, 2000);
+  CheckColumns(Base);
+  ChangeColumnRecs(Base, Rnd);
+  CheckColumns(Base);
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// columns are filled on first use after load, changes made before that are included
+TEST(TFieldColumn, Load) {
+  InitColumnTest(); TRnd Rnd(1);
+  {
+    TWPt<TBase> Base = TStorage::NewBase(ColumnTestFPath, TJsonVal::GetValFromStr(ColumnSchema), 1000000, 1000000);
+    AddColumnRecs(Base, Rnd, 2000);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(ColumnTestFPath, faUpdate, 1000000, 1000000);
+    ChangeColumnRecs(Base, Rnd);
+    AddColumnRecs(Base, Rnd, 500);
+    CheckColumns(Base);
+    // and kept up to date once filled
+    ChangeColumnRecs(Base, Rnd);
+    AddColumnRecs(Base, Rnd, 500);
+    CheckColumns(Base);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(ColumnTestFPath, faRdOnly, 1000000, 1000000);
+    CheckColumns(Base);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
+
+// records with equal values keep their order, in both directions
+TEST(TFieldColumn, SortTies) {
+  InitColumnTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(ColumnTestFPath, TJsonVal::GetValFromStr(ColumnSchema), 1000000, 1000000);
+  AddColumnRecs(Base, Rnd, 2000);
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("Col");
+  for (int AscN = 0; AscN < 2; AscN++) {
+    const bool Asc = (AscN == 0);
+    // start from shuffled order, ties must follow it
+    PRecSet RecSet = Store->GetAllRecs(); RecSet->Shuffle(Rnd);
+    TUInt64V OrigRecIdV; GetColumnRecIdV(RecSet, OrigRecIdV);
+    THash<TUInt64, TInt> RecIdToPosH;
+    for (int RecN = 0; RecN < OrigRecIdV.Len(); RecN++) { RecIdToPosH.AddDat(OrigRecIdV[RecN], RecN); }
+    RecSet->SortByField(Asc, 0);
+    int Ties = 0, Errs = 0;
+    for (int RecN = 1; RecN < RecSet->GetRecs(); RecN++) {
+      const int PrevVal = Store->GetFieldInt(RecSet->GetRecId(RecN - 1), 0);
+      const int Val = Store->GetFieldInt(RecSet->GetRecId(RecN), 0);
+      if (Asc ? (PrevVal > Val) : (PrevVal < Val)) { Errs++; }
+      if (PrevVal != Val) { continue; }
+      Ties++;
+      if (RecIdToPosH.GetDat(RecSet->GetRecId(RecN - 1)) > RecIdToPosH.GetDat(RecSet->GetRecId(RecN))) { Errs++; }
+    }
+    EXPECT_LT(0, Ties);
+    EXPECT_EQ(0, Errs);
+  }
+  TStorage::SaveBase(Base); Base.Del();
+}
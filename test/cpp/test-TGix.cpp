@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+
+typedef TKeyDat<TUInt64, TInt> TGixTestItem;
+typedef TVec<TGixTestItem> TGixTestItemV;
+
+// Generate sorted posting list with Len distinct record ids from [0, MxRecId)
+void GenPostingV(TRnd& Rnd, const int& Len, const int& MxRecId, TGixTestItemV& ItemV) {
+  TUInt64Set RecIdSet;
+  while (RecIdSet.Len() < Len) { RecIdSet.AddKey(TUInt64(Rnd.GetUniDevInt(MxRecId))); }
+  ItemV.Gen(Len, 0);
+  int KeyId = RecIdSet.FFirstKeyId();
+  while (RecIdSet.FNextKeyId(KeyId)) { ItemV.Add(TGixTestItem(RecIdSet.GetKey(KeyId), 1)); }
+  ItemV.Sort();
+}
+
+// Reference linear-merge intersection
+void LinearIntrs(const TGixTestItemV& MainV, const TGixTestItemV& JoinV, TGixTestItemV& ResV) {
+  ResV.Clr(); int ValN1 = 0; int ValN2 = 0;
+  while ((ValN1 < MainV.Len()) && (ValN2 < JoinV.Len())) {
+    const TGixTestItem& Val1 = MainV[ValN1];
+    const TGixTestItem& Val2 = JoinV[ValN2];
+    if (Val1 < Val2) { ValN1++; }
+    else if (Val2 < Val1) { ValN2++; }
+    else { ResV.Add(TGixTestItem(Val1.Key, Val1.Dat + Val2.Dat)); ValN1++; ValN2++; }
+  }
+}
+
+// Search for the next position
+TEST(TGixGallop, GetNextItemN) {
+  TGixTestItemV ItemV;
+  for (int ItemN = 0; ItemN < 100; ItemN++) { ItemV.Add(TGixTestItem(2 * ItemN, 1)); }
+
+  EXPECT_EQ(0, TGixGallop::GetNextItemN(ItemV, TGixTestItem(0, 0), 0));
+  EXPECT_EQ(1, TGixGallop::GetNextItemN(ItemV, TGixTestItem(1, 0), 0));
+  EXPECT_EQ(50, TGixGallop::GetNextItemN(ItemV, TGixTestItem(100, 0), 0));
+  EXPECT_EQ(51, TGixGallop::GetNextItemN(ItemV, TGixTestItem(101, 0), 10));
+  EXPECT_EQ(99, TGixGallop::GetNextItemN(ItemV, TGixTestItem(198, 0), 0));
+  EXPECT_EQ(100, TGixGallop::GetNextItemN(ItemV, TGixTestItem(199, 0), 0));
+  EXPECT_EQ(100, TGixGallop::GetNextItemN(ItemV, TGixTestItem(0, 0), 100));
+  // never goes back
+  EXPECT_EQ(20, TGixGallop::GetNextItemN(ItemV, TGixTestItem(0, 0), 20));
+}
+
+typedef TGixItemCodec<TGixTestItem> TGixTestCodec;
+
+// Encoded items decode to the same items, including block boundaries,
+// large gaps between record ids and extreme frequencies
+TEST(TGixItemCodec, PackUnpack) {
+  TRnd Rnd(1);
+  const int LenV[] = { 0, 1, 127, 128, 129, 1000, 100000 };
+  for (int LenN = 0; LenN < 7; LenN++) {
+    TGixTestItemV ItemV; GenPostingV(Rnd, LenV[LenN], 100 * LenV[LenN] + 1, ItemV);
+    for (int ItemN = 0; ItemN < ItemV.Len(); ItemN++) { 
+      ItemV[ItemN].Dat = Rnd.GetUniDevInt(2000) - 1000; }
+    TMem PackedMem; TGixTestCodec::Pack(ItemV, PackedMem);
+    EXPECT_EQ(ItemV.Len(), TGixTestCodec::GetItems(PackedMem));
+    TGixTestItemV UnpackV; TGixTestCodec::Unpack(PackedMem, UnpackV);
+    EXPECT_TRUE(ItemV == UnpackV);
+  }
+  TGixTestItemV ItemV;
+  ItemV.Add(TGixTestItem(0, TInt::Mn)); ItemV.Add(TGixTestItem(1, TInt::Mx));
+  ItemV.Add(TGixTestItem(2, 1 << 30)); ItemV.Add(TGixTestItem(3, -(1 << 30) - 1));
+  ItemV.Add(TGixTestItem(TUInt64::Mx / 2, -1)); ItemV.Add(TGixTestItem(TUInt64::Mx - 1, 0));
+  TMem PackedMem; TGixTestCodec::Pack(ItemV, PackedMem);
+  TGixTestItemV UnpackV; TGixTestCodec::Unpack(PackedMem, UnpackV);
+  EXPECT_TRUE(ItemV == UnpackV);
+  for (int ItemN = 0; ItemN < ItemV.Len(); ItemN++) { 
+    EXPECT_EQ(ItemV[ItemN].Key, UnpackV[ItemN].Key);
+    EXPECT_EQ(ItemV[ItemN].Dat, UnpackV[ItemN].Dat); 
+  }
+}
+
+// Filtered decoding returns whole blocks, which include all the items that 
+// intersect with the filter, and skips the blocks which cannot intersect
+TEST(TGixItemCodec, UnpackFilter) {
+  TRnd Rnd(1);
+  TGixTestItemV ItemV; GenPostingV(Rnd, 100000, 1000000, ItemV);
+  TMem PackedMem; TGixTestCodec::Pack(ItemV, PackedMem);
+  const int FilterLenV[] = { 0, 1, 10, 1000, 100000 };
+  for (int FilterLenN = 0; FilterLenN < 5; FilterLenN++) {
+    TGixTestItemV FilterV; GenPostingV(Rnd, FilterLenV[FilterLenN], 1000000, FilterV);
+    TGixTestItemV UnpackV; TGixTestCodec::UnpackFilter(PackedMem, FilterV, UnpackV);
+    EXPECT_TRUE(UnpackV.IsSorted());
+    TGixTestItemV ExpectedV, ResV;
+    LinearIntrs(UnpackV, ItemV, ResV); EXPECT_EQ(UnpackV.Len(), ResV.Len());
+    LinearIntrs(FilterV, ItemV, ExpectedV); LinearIntrs(FilterV, UnpackV, ResV);
+    EXPECT_TRUE(ExpectedV == ResV);
+    if (FilterLenV[FilterLenN] <= 10) { EXPECT_LE(UnpackV.Len(), 128 * FilterLenV[FilterLenN]); }
+  }
+  // filter items before the first and after the last item
+  TGixTestItemV FilterV; FilterV.Add(TGixTestItem(0, 1)); FilterV.Add(TGixTestItem(TUInt64::Mx, 1));
+  TGixTestItemV UnpackV; TGixTestCodec::UnpackFilter(PackedMem, FilterV, UnpackV);
+  EXPECT_TRUE(UnpackV.Len() <= 256);
+}
+
+typedef TGix<TInt, TGixTestItem> TGixTest;
+typedef TPt<TGixTest> PGixTest;
+typedef TGixExpItem<TInt, TGixTestItem> TGixTestExpItem;
+
+// Build index "testgix", key lengths follow a Zipfian distribution
+void GenZipfGix(TRnd& Rnd, const int& Keys, const int& MxRecId) {
+  PGixTest Gix = TGixTest::New("testgix", "", faCreate, 10000000);
+  for (int KeyN = 0; KeyN < Keys; KeyN++) {
+    TGixTestItemV ItemV; GenPostingV(Rnd, TInt::GetMx(1, 100000 / (KeyN + 1)), MxRecId, ItemV);
+    Gix->AddItemV(KeyN, ItemV);
+  }
+}
+
+// Random two and three key queries over the most frequent keys
+void GenGixQueryVV(TRnd& Rnd, const int& Keys, const int& Queries, TVec<TIntV>& QueryKeyVV) {
+  QueryKeyVV.Gen(Queries);
+  for (int QueryN = 0; QueryN < Queries; QueryN++) {
+    const int QueryKeys = 2 + Rnd.GetUniDevInt(2);
+    for (int KeyN = 0; KeyN < QueryKeys; KeyN++) {
+      QueryKeyVV[QueryN].Add(Rnd.GetUniDevInt(Keys / 10)); }
+  }
+}
+
+// Run AND queries over a read-only index from increasing number of threads,
+// results must match single-threaded evaluation
+TEST(TGix, ConcurrentRead) {
+  const int Keys = 1000;
+  const int MxRecId = 1000000;
+  const int Queries = 2000;
+  TRnd Rnd(1);
+
+  GenZipfGix(Rnd, Keys, MxRecId);
+  PGixTest Gix = TGixTest::New("testgix", "", faRdOnly, 10000000);
+  TVec<TIntV> QueryKeyVV; GenGixQueryVV(Rnd, Keys, Queries, QueryKeyVV);
+  // expected results
+  TVec<TGixTestItemV> ResItemVV(Queries);
+  for (int QueryN = 0; QueryN < Queries; QueryN++) {
+    TGixTestExpItem::NewAndV(QueryKeyVV[QueryN])->Eval(Gix, ResItemVV[QueryN]);
+  }
+  // small cache, so readers keep loading item sets from disk at the same time
+  Gix.Clr(); Gix = TGixTest::New("testgix", "", faRdOnly, 100000);
+
+#ifdef GLib_OPENMP
+  for (int Threads = 1; Threads <= 8; Threads *= 2) {
+    int Errors = 0;
+    #pragma omp parallel for num_threads(Threads) reduction(+:Errors)
+    for (int QueryN = 0; QueryN < Queries; QueryN++) {
+      TGixTestItemV ItemV;
+      TGixTestExpItem::NewAndV(QueryKeyVV[QueryN])->Eval(Gix, ItemV);
+      if (!(ItemV == ResItemVV[QueryN])) { Errors++; }
+    }
+    EXPECT_EQ(0, Errors);
+  }
+#endif
+  Gix.Clr();
+  TFile::DelWc("./testgix.*");
+}
+
+// Query throughput at 1, 2, 4 and 8 threads, with all item sets cached and
+// with a small cache, where readers load item sets from disk; not run by
+// default, use --gtest_also_run_disabled_tests --gtest_filter=*Bench*
+TEST(TGix, DISABLED_ConcurrentReadBench) {
+  const int Keys = 10000;
+  const int MxRecId = 10000000;
+  const int Queries = 20000;
+  TRnd Rnd(1);
+
+  GenZipfGix(Rnd, Keys, MxRecId);
+  TVec<TIntV> QueryKeyVV; GenGixQueryVV(Rnd, Keys, Queries, QueryKeyVV);
+  const int64 CacheSizeV[] = { 1000000000, 1000000 };
+  for (int CacheSizeN = 0; CacheSizeN < 2; CacheSizeN++) {
+    PGixTest Gix = TGixTest::New("testgix", "", faRdOnly, CacheSizeV[CacheSizeN]);
+    // warm up the cache and the page cache
+    TGixTestItemV ItemV;
+    for (int QueryN = 0; QueryN < Queries; QueryN++) {
+      TGixTestExpItem::NewAndV(QueryKeyVV[QueryN])->Eval(Gix, ItemV); }
+#ifdef GLib_OPENMP
+    for (int Threads = 1; Threads <= 8; Threads *= 2) {
+      const uint64 StartMSecs = TSysTm::GetCurUniMSecs();
+      #pragma omp parallel for num_threads(Threads) schedule(dynamic, 16)
+      for (int QueryN = 0; QueryN < Queries; QueryN++) {
+        TGixTestItemV ResItemV;
+        TGixTestExpItem::NewAndV(QueryKeyVV[QueryN])->Eval(Gix, ResItemV);
+      }
+      const int MSecs = TInt::GetMx((int)(TSysTm::GetCurUniMSecs() - StartMSecs), 1);
+      printf("cache %s, %d threads: %d queries/s\n", (CacheSizeN == 0) ? "full" : "small",
+        Threads, (int)(1000.0 * Queries / MSecs));
+    }
+#endif
+  }
+  TFile::DelWc("./testgix.*");
+}
+
+// AND over encoded item sets reads only the blocks which can intersect,
+// results must match intersection of all the items
+TEST(TGix, EncodedIntrs) {
+  const int Keys = 50;
+  TRnd Rnd(1);
+  {
+    PGixTest Gix = TGixTest::New("testgix", "", faCreate, 10000000);
+    for (int KeyN = 0; KeyN < Keys; KeyN++) {
+      TGixTestItemV ItemV; GenPostingV(Rnd, TInt::GetMx(1, 200000 / (KeyN + 1)), 1000000, ItemV);
+      Gix->AddItemV(KeyN, ItemV);
+    }
+  }
+  PGixTest Gix = TGixTest::New("testgix", "", faRdOnly, 10000000);
+  for (int QueryN = 0; QueryN < 200; QueryN++) {
+    const int Key1 = Rnd.GetUniDevInt(Keys), Key2 = Rnd.GetUniDevInt(Keys);
+    TGixTestItemV ItemV1, ItemV2, ExpectedV, ResV;
+    Gix->GetItemV(Key1, ItemV1); Gix->GetItemV(Key2, ItemV2);
+    LinearIntrs(ItemV1, ItemV2, ExpectedV);
+    TGixTestExpItem::NewAnd(TGixTestExpItem::NewItem(Key1), 
+      TGixTestExpItem::NewItem(Key2))->Eval(Gix, ResV);
+    EXPECT_EQ(ExpectedV.Len(), ResV.Len());
+    EXPECT_TRUE(ExpectedV == ResV);
+  }
+  Gix.Clr();
+  TFile::DelWc("./testgix.*");
+}
+
+// Read-only index with flat key table must see the same keys and items
+// as the one that loads the key hash table
+TEST(TGix, FlatKeys) {
+  const int Keys = 500;
+  TRnd Rnd(1);
+  {
+    PGixTest Gix = TGixTest::New("testgix", "", faCreate, 10000000, 
+      TGixDefMerger<TInt, TGixTestItem>::New(), true);
+    for (int KeyN = 0; KeyN < Keys; KeyN++) {
+      TGixTestItemV ItemV; GenPostingV(Rnd, 1 + Rnd.GetUniDevInt(100), 100000, ItemV);
+      Gix->AddItemV(3 * KeyN, ItemV);
+    }
+  }
+  EXPECT_TRUE(TFile::Exists("./testgix.GixKey"));
+  PGixTest HashGix = TGixTest::New("testgix", "", faRdOnly, 10000000);
+  PGixTest FlatGix = TGixTest::New("testgix", "", faRdOnly, 10000000, 
+    TGixDefMerger<TInt, TGixTestItem>::New(), true);
+  EXPECT_EQ(Keys, HashGix->GetKeys());
+  EXPECT_EQ(Keys, FlatGix->GetKeys());
+  for (int KeyN = 0; KeyN < 3 * Keys; KeyN++) {
+    EXPECT_EQ(HashGix->IsKey(KeyN), FlatGix->IsKey(KeyN));
+    TGixTestItemV HashItemV, FlatItemV;
+    EXPECT_EQ(HashGix->GetItemV(KeyN, HashItemV), FlatGix->GetItemV(KeyN, FlatItemV));
+    EXPECT_TRUE(HashItemV == FlatItemV);
+  }
+  // mapped keys are traversed in sorted order
+  int KeyId = FlatGix->FFirstKeyId(), PrevKey = -1;
+  while (FlatGix->FNextKeyId(KeyId)) {
+    EXPECT_LT(PrevKey, FlatGix->GetKey(KeyId).Val); PrevKey = FlatGix->GetKey(KeyId);
+  }
+  HashGix.Clr(); FlatGix.Clr();
+  TFile::DelWc("./testgix.*");
+}
+
+// Number of items is taken from the key table or the cached item set,
+// without loading item sets from disk
+TEST(TGix, GetItemsEst) {
+  const int Keys = 200;
+  TRnd Rnd(1); TIntV ItemsV(Keys);
+  {
+    PGixTest Gix = TGixTest::New("testgix", "", faCreate, 10000000, 
+      TGixDefMerger<TInt, TGixTestItem>::New(), true);
+    for (int KeyN = 0; KeyN < Keys; KeyN++) {
+      TGixTestItemV ItemV; GenPostingV(Rnd, 1 + Rnd.GetUniDevInt(1000), 100000, ItemV);
+      Gix->AddItemV(KeyN, ItemV); ItemsV[KeyN] = ItemV.Len();
+    }
+  }
+  {
+    // new items are counted while their item sets are still in the cache
+    PGixTest Gix = TGixTest::New("testgix", "", faUpdate, 10000000, 
+      TGixDefMerger<TInt, TGixTestItem>::New(), true);
+    for (int KeyN = 0; KeyN < Keys; KeyN += 3) {
+      TGixTestItemV ItemV; GenPostingV(Rnd, 1 + Rnd.GetUniDevInt(100), 100000, ItemV);
+      for (int ItemN = 0; ItemN < ItemV.Len(); ItemN++) { ItemV[ItemN].Key += 100000; }
+      Gix->AddItemV(KeyN, ItemV); ItemsV[KeyN] += ItemV.Len();
+    }
+    for (int KeyN = 0; KeyN < Keys; KeyN++) { EXPECT_EQ(ItemsV[KeyN], Gix->GetItemsEst(KeyN)); }
+  }
+  PGixTest HashGix = TGixTest::New("testgix", "", faRdOnly, 10000000);
+  PGixTest FlatGix = TGixTest::New("testgix", "", faRdOnly, 10000000, 
+    TGixDefMerger<TInt, TGixTestItem>::New(), true);
+  for (int KeyN = 0; KeyN < Keys; KeyN++) {
+    EXPECT_EQ(ItemsV[KeyN], HashGix->GetItemsEst(KeyN));
+    EXPECT_EQ(ItemsV[KeyN], FlatGix->GetItemsEst(KeyN));
+  }
+  EXPECT_EQ(0, HashGix->GetItemsEst(Keys));
+  // AND of keys is estimated by the smaller one
+  EXPECT_EQ(TInt::GetMn(ItemsV[1], ItemsV[2]), TGixTestExpItem::NewAnd(
+    TGixTestExpItem::NewItem(1), TGixTestExpItem::NewItem(2))->GetItemsEst(HashGix));
+  EXPECT_EQ(0, HashGix->GetCacheSize());
+  EXPECT_EQ(0, FlatGix->GetCacheSize());
+  HashGix.Clr(); FlatGix.Clr();
+  // key table saved without item counts, they are read from item sets
+  {
+    TFIn FIn("./testgix.Gix"); TInt Tag(FIn); THash<TInt, TGixKeyDat> KeyIdH(FIn);
+    THash<TInt, TBlobPt> OldKeyIdH; int KeyId = KeyIdH.FFirstKeyId();
+    while (KeyIdH.FNextKeyId(KeyId)) { OldKeyIdH.AddDat(KeyIdH.GetKey(KeyId), KeyIdH[KeyId].Val1); }
+    TFOut FOut("./testgix.Gix"); OldKeyIdH.Save(FOut);
+  }
+  TFile::Del("./testgix.GixKey");
+  PGixTest OldGix = TGixTest::New("testgix", "", faRdOnly, 10000000);
+  for (int KeyN = 0; KeyN < Keys; KeyN++) { EXPECT_EQ(ItemsV[KeyN], OldGix->GetItemsEst(KeyN)); }
+  OldGix.Clr();
+  TFile::DelWc("./testgix.*");
+}
@@ -503,6 +503,69 @@ TEST(TStrIntH, ManipulateTable) {
   EXPECT_EQ(0,DatSum);
 }
 
+// Cached data for TQCache tests, records evicted keys
+class TTestCacheDat {
+private:
+  TCRef CRef;
+public:
+  int MemUsed;
+  TTestCacheDat(const int& _MemUsed): MemUsed(_MemUsed) { }
+  static TPt<TTestCacheDat> New(const int& MemUsed) { return new TTestCacheDat(MemUsed); }
+  int GetMemUsed() const { return MemUsed; }
+  void OnDelFromCache(const TInt& Key, void* RefToBs) { ((TIntV*)RefToBs)->Add(Key); }
+  friend class TPt<TTestCacheDat>;
+};
+typedef TPt<TTestCacheDat> PTestCacheDat;
+
+// Working set in main queue survives a long scan
+TEST(TQCache, ScanResistance) {
+  // each entry takes 100 bytes together with the key, cache holds 100 entries
+  const int DatMem = 100 - (int)sizeof(TInt);
+  TIntV EvictedKeyV;
+  TQCache<TInt, PTestCacheDat> Cache(100 * 100, &EvictedKeyV);
+  // working set is seen, pushed out by a short scan and requested again
+  for (int Key = 0; Key < 50; Key++) { Cache.Put(Key, TTestCacheDat::New(DatMem)); }
+  for (int Key = 1000; Key < 1100; Key++) { Cache.Put(Key, TTestCacheDat::New(DatMem)); }
+  EXPECT_EQ(50, EvictedKeyV.Len());
+  PTestCacheDat Dat;
+  for (int Key = 0; Key < 50; Key++) {
+    EXPECT_FALSE(Cache.Get(Key, Dat));
+    Cache.Put(Key, TTestCacheDat::New(DatMem));
+  }
+  // long scan
+  for (int Key = 2000; Key < 10000; Key++) {
+    if (!Cache.Get(Key, Dat)) { Cache.Put(Key, TTestCacheDat::New(DatMem)); }
+  }
+  int Hits = 0;
+  for (int Key = 0; Key < 50; Key++) { if (Cache.Get(Key, Dat)) { Hits++; } }
+  EXPECT_EQ(50, Hits);
+  EXPECT_EQ(50, (int)Cache.GetHits());
+  EXPECT_EQ(50 + 8000, (int)Cache.GetMisses());
+  EXPECT_EQ(Cache.GetEvictions(), (int64)EvictedKeyV.Len());
+  EXPECT_LE(Cache.GetMemUsed(), Cache.GetMxMemUsed());
+  EXPECT_EQ(Cache.GetKeys() * 100, (int)Cache.GetMemUsed());
+}
+
+// Memory usage follows changes of cached data
+TEST(TQCache, UpdateMemUsed) {
+  TIntV EvictedKeyV;
+  TQCache<TInt, PTestCacheDat> Cache(10000, &EvictedKeyV);
+  PTestCacheDat Dat = TTestCacheDat::New(100);
+  Cache.Put(1, Dat);
+  Cache.Put(2, TTestCacheDat::New(100));
+  EXPECT_EQ(2 * (100 + (int)sizeof(TInt)), (int)Cache.GetMemUsed());
+  Dat->MemUsed = 1000; Cache.UpdateMemUsed(1);
+  EXPECT_EQ(1100 + 2 * (int)sizeof(TInt), (int)Cache.GetMemUsed());
+  // growing entry pushes others out, but stays in the cache
+  Dat->MemUsed = 9990; Cache.UpdateMemUsed(1);
+  EXPECT_EQ(1, Cache.GetKeys());
+  EXPECT_TRUE(Cache.Get(1, Dat));
+  EXPECT_EQ(1, EvictedKeyV.Len());
+  EXPECT_EQ(2, EvictedKeyV[0].Val);
+  Cache.Del(1, false);
+  EXPECT_EQ(0, (int)Cache.GetMemUsed());
+}
+
 int Prime(const int& n) {
   int d;
 
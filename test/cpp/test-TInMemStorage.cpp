@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder
+const TStr InMemTestFNm = "./inmem-test.dat";
+
+void ClrInMemTest() {
+  TFile::DelWc(InMemTestFNm + "*");
+}
+
+// value with given id, some of them empty
+TMem GetInMemTestVal(const uint64& ValId) {
+  TMem Val; if (ValId % 7 == 0) { return Val; }
+  Val += TUInt64::GetStr(ValId);
+  return Val;
+}
+
+// storage with values [FirstValId, FirstValId + Vals)
+void CheckInMemVals(const TStorage::TInMemStorage& Storage, const uint64& FirstValId, const uint64& Vals) {
+  EXPECT_EQ(Vals, Storage.Len());
+  EXPECT_EQ(FirstValId, Storage.GetFirstValId());
+  EXPECT_FALSE(Storage.IsValId(FirstValId - 1));
+  EXPECT_FALSE(Storage.IsValId(FirstValId + Vals));
+  TMem Val; int Diffs = 0;
+  for (uint64 ValId = FirstValId; ValId < FirstValId + Vals; ValId++) {
+    Storage.GetVal(ValId, Val);
+    if (Val.GetAsStr() != GetInMemTestVal(ValId).GetAsStr()) { Diffs++; }
+  }
+  EXPECT_EQ(0, Diffs);
+}
+
+// layout before flat files: vector of values followed by offset of the first one
+void SaveInMemVecLayout(const uint64& FirstValId, const uint64& Vals) {
+  TVec<TMem, int64> ValV;
+  for (uint64 ValId = FirstValId; ValId < FirstValId + Vals; ValId++) { ValV.Add(GetInMemTestVal(ValId)); }
+  TFOut FOut(InMemTestFNm); ValV.Save(FOut); TUInt64(FirstValId).Save(FOut);
+}
+
+// flat layout before chunks: tag, offset of the first value, offsets and data
+void SaveInMemFlatLayout(const uint64& FirstValId, const uint64& Vals) {
+  TFOut FOut(InMemTestFNm);
+  FOut.Save(int64(-2)); TUInt64(FirstValId).Save(FOut); FOut.Save(int64(Vals));
+  uint64 Offset = 0; TUInt64(Offset).Save(FOut);
+  for (uint64 ValId = FirstValId; ValId < FirstValId + Vals; ValId++) {
+    Offset += GetInMemTestVal(ValId).Len(); TUInt64(Offset).Save(FOut); }
+  for (uint64 ValId = FirstValId; ValId < FirstValId + Vals; ValId++) {
+    TMem Val = GetInMemTestVal(ValId); FOut.SaveBf(Val.GetBf(), Val.Len()); }
+}
+
+// values span several chunks and first one does not start at chunk boundary
+TEST(TInMemStorage, Chunks) {
+  ClrInMemTest();
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm);
+    for (uint64 ValId = 0; ValId < 150000; ValId++) { Storage.AddVal(GetInMemTestVal(ValId)); }
+    Storage.DelVals(70000);
+    CheckInMemVals(Storage, 70000, 80000);
+  }
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faRdOnly);
+    CheckInMemVals(Storage, 70000, 80000);
+  }
+  ClrInMemTest();
+}
+
+// old layouts can be opened read-only
+TEST(TInMemStorage, LoadLegacyRdOnly) {
+  ClrInMemTest();
+  SaveInMemVecLayout(70000, 80000);
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faRdOnly);
+    CheckInMemVals(Storage, 70000, 80000);
+  }
+  SaveInMemFlatLayout(70000, 80000);
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faRdOnly);
+    CheckInMemVals(Storage, 70000, 80000);
+  }
+  // read-only open leaves the file as it was
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faRdOnly);
+    CheckInMemVals(Storage, 70000, 80000);
+  }
+  ClrInMemTest();
+}
+
+// old layouts opened for update are converted to chunks on close
+TEST(TInMemStorage, LoadLegacyUpdate) {
+  ClrInMemTest();
+  SaveInMemVecLayout(0, 1000);
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faUpdate);
+    CheckInMemVals(Storage, 0, 1000);
+    for (uint64 ValId = 1000; ValId < 2000; ValId++) { Storage.AddVal(GetInMemTestVal(ValId)); }
+  }
+  {
+    TStorage::TInMemStorage Storage(InMemTestFNm, faRdOnly);
+    CheckInMemVals(Storage, 0, 2000);
+  }
+  ClrInMemTest();
+}
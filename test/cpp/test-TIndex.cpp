@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder
+const TStr IndexTestFPath = "./index-test/";
+
+void InitIndexTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  if (TDir::Exists(IndexTestFPath)) {
+    TStrV FNmV; TFFile::GetFNmV(IndexTestFPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(IndexTestFPath);
+  }
+}
+
+typedef TIndex::TQmGixItem TQmGixTestItem;
+typedef TIndex::TQmGixItemV TQmGixTestItemV;
+
+// Generate sorted posting list with Len distinct record ids from [0, MxRecId)
+void GenQmPostingV(TRnd& Rnd, const int& Len, const int& MxRecId, TQmGixTestItemV& ItemV) {
+  TUInt64Set RecIdSet;
+  while (RecIdSet.Len() < Len) { RecIdSet.AddKey(TUInt64(Rnd.GetUniDevInt(MxRecId))); }
+  ItemV.Gen(Len, 0);
+  int KeyId = RecIdSet.FFirstKeyId();
+  while (RecIdSet.FNextKeyId(KeyId)) { ItemV.Add(TQmGixTestItem(RecIdSet.GetKey(KeyId), 1 + Rnd.GetUniDevInt(3))); }
+  ItemV.Sort();
+}
+
+// Reference linear-merge intersection, frequencies are summed up, 
+// or capped at one before summing when removing duplicates
+void LinearQmIntrs(const TQmGixTestItemV& MainV, const TQmGixTestItemV& JoinV, 
+    const bool& RmDupP, TQmGixTestItemV& ResV) {
+
+  ResV.Clr(); int ValN1 = 0; int ValN2 = 0;
+  while ((ValN1 < MainV.Len()) && (ValN2 < JoinV.Len())) {
+    const TQmGixTestItem& Val1 = MainV[ValN1];
+    const TQmGixTestItem& Val2 = JoinV[ValN2];
+    if (Val1 < Val2) { ValN1++; }
+    else if (Val2 < Val1) { ValN2++; }
+    else {
+      const int Fq = RmDupP ? (TInt::GetMn(1, Val1.Dat) + TInt::GetMn(1, Val2.Dat)) : (Val1.Dat + Val2.Dat);
+      ResV.Add(TQmGixTestItem(Val1.Key, Fq)); ValN1++; ValN2++;
+    }
+  }
+}
+
+// Posting lists with lengths following a Zipfian distribution,
+// length of list with rank ListN is proportional to 1/(ListN+1)
+void GenZipfQmPostingVV(TRnd& Rnd, const int& Lists, const int& MxLen, 
+    const int& MxRecId, TVec<TQmGixTestItemV>& PostingVV) {
+
+  PostingVV.Gen(Lists);
+  for (int ListN = 0; ListN < Lists; ListN++) {
+    const int Len = TInt::GetMx(1, MxLen / (ListN + 1));
+    GenQmPostingV(Rnd, Len, MxRecId, PostingVV[ListN]);
+  }
+}
+
+// Posting list lengths follow a Zipfian distribution, intersect each list with 
+// the longest one using the index mergers and compare with linear intersection
+TEST(TQmGixMerger, ZipfIntrs) {
+  const int MxRecId = 1000000;
+  const int Lists = 32;
+  const int MxLen = 100000;
+  TRnd Rnd(1);
+
+  TVec<TQmGixTestItemV> PostingVV;
+  GenZipfQmPostingVV(Rnd, Lists, MxLen, MxRecId, PostingVV);
+  TIndex::PQmGixMerger DefMerger = TIndex::TQmGixDefMerger::New();
+  TIndex::PQmGixMerger RmDupMerger = TIndex::TQmGixRmDupMerger::New();
+  for (int ListN = 1; ListN < Lists; ListN++) {
+    TQmGixTestItemV LinearResV, ResV;
+    // both argument orders, merger walks the shorter one
+    LinearQmIntrs(PostingVV[ListN], PostingVV[0], false, LinearResV);
+    ResV = PostingVV[ListN]; DefMerger->Intrs(ResV, PostingVV[0]);
+    EXPECT_TRUE(LinearResV == ResV);
+    ResV = PostingVV[0]; DefMerger->Intrs(ResV, PostingVV[ListN]);
+    EXPECT_TRUE(LinearResV == ResV);
+    LinearQmIntrs(PostingVV[ListN], PostingVV[0], true, LinearResV);
+    ResV = PostingVV[ListN]; RmDupMerger->Intrs(ResV, PostingVV[0]);
+    EXPECT_TRUE(LinearResV == ResV);
+    ResV = PostingVV[0]; RmDupMerger->Intrs(ResV, PostingVV[ListN]);
+    EXPECT_TRUE(LinearResV == ResV);
+    // frequencies are compared as well
+    for (int ItemN = 0; ItemN < ResV.Len(); ItemN++) { EXPECT_EQ(LinearResV[ItemN].Dat, ResV[ItemN].Dat); }
+  }
+}
+
+// Time of linear and galloping intersection of Zipfian lists with the longest 
+// one, grouped by rank; not run by default, use 
+// --gtest_also_run_disabled_tests --gtest_filter=*Bench*
+TEST(TQmGixMerger, DISABLED_ZipfIntrsBench) {
+  const int MxRecId = 10000000;
+  const int Lists = 1024;
+  const int MxLen = 1000000;
+  const int Repeats = 5;
+  TRnd Rnd(1);
+
+  TVec<TQmGixTestItemV> PostingVV;
+  GenZipfQmPostingVV(Rnd, Lists, MxLen, MxRecId, PostingVV);
+  TIndex::PQmGixMerger DefMerger = TIndex::TQmGixDefMerger::New();
+  // ranks [1, 4), [4, 16), [16, 64), ...
+  for (int MnListN = 1; MnListN < Lists; MnListN *= 4) {
+    const int MxListN = TInt::GetMn(4 * MnListN, Lists);
+    TTmStopWatch LinearWatch, GallopWatch; TQmGixTestItemV LinearResV, ResV;
+    for (int RepeatN = 0; RepeatN < Repeats; RepeatN++) {
+      for (int ListN = MnListN; ListN < MxListN; ListN++) {
+        LinearWatch.Start();
+        LinearQmIntrs(PostingVV[ListN], PostingVV[0], false, LinearResV);
+        LinearWatch.Stop();
+        GallopWatch.Start();
+        ResV = PostingVV[ListN]; DefMerger->Intrs(ResV, PostingVV[0]);
+        GallopWatch.Stop();
+        EXPECT_TRUE(LinearResV == ResV);
+      }
+    }
+    printf("ranks %d-%d (lengths %d-%d vs %d): linear %.1f ms, galloping %.1f ms\n",
+      MnListN, MxListN - 1, PostingVV[MxListN - 1].Len(), PostingVV[MnListN].Len(),
+      PostingVV[0].Len(), LinearWatch.GetMSec(), GallopWatch.GetMSec());
+  }
+}
+
+// store with numeric key, kept in the range index
+const TStr RangeSchema = "[{\"name\":\"Range\",\"fields\":["
+  "{\"name\":\"Num\",\"type\":\"string\"},{\"name\":\"Tag\",\"type\":\"string\"}],"
+  "\"keys\":[{\"field\":\"Num\",\"type\":\"value\",\"sort\":\"number\"},"
+  "{\"field\":\"Tag\",\"type\":\"value\"}]}]";
+
+TStr GetRangeRecStr(TRnd& Rnd) {
+  return TStr::Fmt("{\"Num\":\"%d\",\"Tag\":\"%s\"}", Rnd.GetUniDevInt(1000),
+    Rnd.GetUniDevInt(3) == 0 ? "a" : "b");
+}
+
+// sorted ids of records matching the query
+void GetRangeSearch(const TWPt<TBase>& Base, const TStr& QueryStr, TUInt64V& RecIdV) {
+  PRecSet RecSet = Base->Search(QueryStr); RecIdV.Clr();
+  for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) { RecIdV.Add(RecSet->GetRecId(RecN)); }
+  RecIdV.Sort();
+}
+
+// sorted ids of records with MnNum < Num < MxNum, and given tag when not empty
+void GetRangeScan(const TWPt<TBase>& Base, const int& MnNum, const int& MxNum,
+    const TStr& Tag, TUInt64V& RecIdV) {
+
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("Range"); RecIdV.Clr();
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    const uint64 RecId = Iter->GetRecId();
+    const int Num = Store->GetFieldStr(RecId, 0).GetInt();
+    if (Num <= MnNum || Num >= MxNum) { continue; }
+    if (!Tag.Empty() && Store->GetFieldStr(RecId, 1) != Tag) { continue; }
+    RecIdV.Add(RecId);
+  }
+  RecIdV.Sort();
+}
+
+// $gt, $lt and between queries must match a scan of the store
+void CheckRangeQueries(const TWPt<TBase>& Base) {
+  TUInt64V SearchV, ScanV;
+  GetRangeSearch(Base, "{\"$from\":\"Range\",\"Num\":{\"$gt\":\"900\"}}", SearchV);
+  GetRangeScan(Base, 900, TInt::Mx, "", ScanV);
+  EXPECT_FALSE(ScanV.Empty()); EXPECT_EQ(SearchV, ScanV);
+  GetRangeSearch(Base, "{\"$from\":\"Range\",\"Num\":{\"$lt\":\"25\"}}", SearchV);
+  GetRangeScan(Base, TInt::Mn, 25, "", ScanV);
+  EXPECT_FALSE(ScanV.Empty()); EXPECT_EQ(SearchV, ScanV);
+  // greater and less on the same key are merged into one between scan
+  GetRangeSearch(Base, "{\"$from\":\"Range\",\"Num\":[{\"$gt\":\"100\"},{\"$lt\":\"200\"}]}", SearchV);
+  GetRangeScan(Base, 100, 200, "", ScanV);
+  EXPECT_FALSE(ScanV.Empty()); EXPECT_EQ(SearchV, ScanV);
+  GetRangeSearch(Base, "{\"$from\":\"Range\",\"Num\":[{\"$gt\":\"100\"},{\"$lt\":\"200\"}],\"Tag\":\"a\"}", SearchV);
+  GetRangeScan(Base, 100, 200, "a", ScanV);
+  EXPECT_FALSE(ScanV.Empty()); EXPECT_EQ(SearchV, ScanV);
+  // empty range
+  GetRangeSearch(Base, "{\"$from\":\"Range\",\"Num\":[{\"$gt\":\"500\"},{\"$lt\":\"400\"}]}", SearchV);
+  EXPECT_TRUE(SearchV.Empty());
+}
+
+TEST(TRangeIndex, Search) {
+  InitIndexTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(IndexTestFPath, TJsonVal::GetValFromStr(RangeSchema), 1000000, 1000000);
+  for (int RecN = 0; RecN < 5000; RecN++) { Base->AddRec("Range", TJsonVal::GetValFromStr(GetRangeRecStr(Rnd))); }
+  CheckRangeQueries(Base);
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// deleted records are removed from the range index
+TEST(TRangeIndex, Delete) {
+  InitIndexTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(IndexTestFPath, TJsonVal::GetValFromStr(RangeSchema), 1000000, 1000000);
+  for (int RecN = 0; RecN < 5000; RecN++) { Base->AddRec("Range", TJsonVal::GetValFromStr(GetRangeRecStr(Rnd))); }
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("Range");
+  Store->DeleteFirstNRecs(2000);
+  CheckRangeQueries(Base);
+  // updates move records within the range index
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    if (Rnd.GetUniDevInt(4) == 0) { Store->SetFieldStr(Iter->GetRecId(), 0, TInt::GetStr(Rnd.GetUniDevInt(1000))); }
+  }
+  CheckRangeQueries(Base);
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// records indexed in temporary indices get merged into the range index
+TEST(TRangeIndex, MergeIndex) {
+  InitIndexTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(IndexTestFPath, TJsonVal::GetValFromStr(RangeSchema), 1000000, 1000000);
+  for (int RecN = 0; RecN < 1000; RecN++) { Base->AddRec("Range", TJsonVal::GetValFromStr(GetRangeRecStr(Rnd))); }
+  TChA LnChA;
+  for (int RecN = 0; RecN < 4000; RecN++) { LnChA += GetRangeRecStr(Rnd); LnChA += '\n'; }
+  // small temporary indices and batches, to merge several of them
+  Base->GetStoreByStoreNm("Range")->AddRecBulk(TMIn::New(LnChA), 500, 10000);
+  CheckRangeQueries(Base);
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// range index is saved and loaded with the base
+TEST(TRangeIndex, Load) {
+  InitIndexTest(); TRnd Rnd(1);
+  {
+    TWPt<TBase> Base = TStorage::NewBase(IndexTestFPath, TJsonVal::GetValFromStr(RangeSchema), 1000000, 1000000);
+    for (int RecN = 0; RecN < 5000; RecN++) { Base->AddRec("Range", TJsonVal::GetValFromStr(GetRangeRecStr(Rnd))); }
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(IndexTestFPath, faRdOnly, 1000000, 1000000);
+    CheckRangeQueries(Base);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
+
+// store with numeric key over string arrays, values can repeat within a record
+const TStr RangeVSchema = "[{\"name\":\"RangeV\",\"fields\":["
+  "{\"name\":\"Nums\",\"type\":\"string_v\"}],"
+  "\"keys\":[{\"field\":\"Nums\",\"type\":\"value\",\"sort\":\"number\"}]}]";
+
+void GetRangeVNumV(TRnd& Rnd, TStrV& NumV) {
+  NumV.Clr(); const int Nums = 1 + Rnd.GetUniDevInt(4);
+  for (int NumN = 0; NumN < Nums; NumN++) { NumV.Add(TInt::GetStr(Rnd.GetUniDevInt(20))); }
+}
+
+// query results with frequencies must match the number of values 
+// in range counted by a scan of the store
+void CheckRangeVQuery(const TWPt<TBase>& Base, const int& MnNum, const int& MxNum) {
+  PRecSet RecSet = Base->Search(TStr::Fmt("{\"$from\":\"RangeV\",\"Nums\":"
+    "[{\"$gt\":\"%d\"},{\"$lt\":\"%d\"}]}", MnNum, MxNum));
+  TUInt64IntKdV SearchV = RecSet->GetRecIdFqV(); SearchV.Sort();
+  TUInt64IntKdV ScanV;
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("RangeV");
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    TStrV NumV; Store->GetFieldStrV(Iter->GetRecId(), 0, NumV); int Fq = 0;
+    for (int NumN = 0; NumN < NumV.Len(); NumN++) {
+      const int Num = NumV[NumN].GetInt();
+      if (MnNum < Num && Num < MxNum) { Fq++; }
+    }
+    if (Fq > 0) { ScanV.Add(TUInt64IntKd(Iter->GetRecId(), Fq)); }
+  }
+  ScanV.Sort();
+  EXPECT_FALSE(ScanV.Empty());
+  ASSERT_EQ(ScanV.Len(), SearchV.Len());
+  for (int RecN = 0; RecN < ScanV.Len(); RecN++) {
+    EXPECT_EQ(ScanV[RecN].Key, SearchV[RecN].Key);
+    EXPECT_EQ(ScanV[RecN].Dat, SearchV[RecN].Dat);
+  }
+}
+
+// records with repeated values keep them until the last copy is removed
+TEST(TRangeIndex, RepeatedValues) {
+  InitIndexTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = TStorage::NewBase(IndexTestFPath, TJsonVal::GetValFromStr(RangeVSchema), 1000000, 1000000);
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("RangeV");
+  for (int RecN = 0; RecN < 2000; RecN++) {
+    TStrV NumV; GetRangeVNumV(Rnd, NumV);
+    PJsonVal RecVal = TJsonVal::NewObj();
+    RecVal->AddToObj("Nums", TJsonVal::NewArr(NumV));
+    Store->AddRec(RecVal);
+  }
+  CheckRangeVQuery(Base, 5, 12); CheckRangeVQuery(Base, 0, 3);
+  // remove one copy of a value from records
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    TStrV NumV; Store->GetFieldStrV(Iter->GetRecId(), 0, NumV);
+    if (NumV.Len() > 1) { NumV.Del(Rnd.GetUniDevInt(NumV.Len())); }
+    Store->SetFieldStrV(Iter->GetRecId(), 0, NumV);
+  }
+  CheckRangeVQuery(Base, 5, 12); CheckRangeVQuery(Base, 0, 3);
+  // value indexed twice and deleted once directly in the index stays in range
+  const int KeyId = Base->GetIndexVoc()->GetKeyId(Store->GetStoreId(), "Nums");
+  const uint64 RecId = Store->FirstRecId();
+  Base->GetIndex()->Index(KeyId, "25", RecId);
+  Base->GetIndex()->Index(KeyId, "25", RecId);
+  Base->GetIndex()->Delete(KeyId, "25", RecId);
+  PRecSet RecSet = Base->Search("{\"$from\":\"RangeV\",\"Nums\":{\"$gt\":\"19\"}}");
+  ASSERT_EQ(1, RecSet->GetRecs());
+  EXPECT_EQ(RecId, RecSet->GetRecId(0));
+  EXPECT_EQ(1, (int)RecSet->GetRecIdFqV()[0].Dat);
+  Base->GetIndex()->Delete(KeyId, "25", RecId);
+  EXPECT_EQ(0, Base->Search("{\"$from\":\"RangeV\",\"Nums\":{\"$gt\":\"19\"}}")->GetRecs());
+  TStorage::SaveBase(Base); Base.Del();
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+
+// Build json value from reader positioned at the start of a value
+PJsonVal GetReaderVal(TJsonReader& Reader) {
+  if (Reader.IsNull()) { return TJsonVal::NewNull(); }
+  if (Reader.IsBool()) { return TJsonVal::NewBool(Reader.GetBool()); }
+  if (Reader.IsNum()) { return TJsonVal::NewNum(Reader.GetNum()); }
+  if (Reader.IsStr()) { return TJsonVal::NewStr(TStr(Reader.GetStr())); }
+  if (Reader.IsArrStart()) {
+    PJsonVal Val = TJsonVal::NewArr();
+    while (Reader.Next() && !Reader.IsArrEnd()) { Val->AddToArr(GetReaderVal(Reader)); }
+    return Val;
+  }
+  EXPECT_TRUE(Reader.IsObjStart());
+  PJsonVal Val = TJsonVal::NewObj();
+  while (Reader.Next() && !Reader.IsObjEnd()) {
+    EXPECT_TRUE(Reader.IsKey());
+    const TStr Key = Reader.GetStr();
+    Reader.Next(); Val->AddToObj(Key, GetReaderVal(Reader));
+  }
+  return Val;
+}
+
+PJsonVal GetReaderVal(const TStr& JsonStr) {
+  TJsonReader Reader(JsonStr);
+  EXPECT_TRUE(Reader.Next());
+  PJsonVal Val = GetReaderVal(Reader);
+  EXPECT_FALSE(Reader.Next());
+  EXPECT_TRUE(Reader.IsEof());
+  return Val;
+}
+
+// Sequence of tokens for a small document
+TEST(TJsonReader, Tokens) {
+  TJsonReader Reader(" {\"a\": [1, -2.5e2, true], \"b\" :{}, \"c\":null, \"d\":\"x\\ty\"} ");
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsObjStart()); EXPECT_EQ(1, Reader.GetDepth());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsKey()); EXPECT_STREQ("a", Reader.GetStr().CStr());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsArrStart()); EXPECT_EQ(2, Reader.GetDepth());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsNum()); EXPECT_EQ(1, Reader.GetInt());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsNum()); EXPECT_EQ(-250.0, Reader.GetNum());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsBool()); EXPECT_TRUE(Reader.GetBool());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsArrEnd()); EXPECT_EQ(1, Reader.GetDepth());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsKey()); EXPECT_STREQ("b", Reader.GetStr().CStr());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsObjStart());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsObjEnd());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsKey()); EXPECT_STREQ("c", Reader.GetStr().CStr());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsNull());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsKey()); EXPECT_STREQ("d", Reader.GetStr().CStr());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsStr()); EXPECT_STREQ("x\ty", Reader.GetStr().CStr());
+  ASSERT_TRUE(Reader.Next()); EXPECT_TRUE(Reader.IsObjEnd()); EXPECT_EQ(0, Reader.GetDepth());
+  EXPECT_FALSE(Reader.Next()); EXPECT_TRUE(Reader.IsEof());
+  EXPECT_FALSE(Reader.Next());
+}
+
+// Skipping nested values
+TEST(TJsonReader, SkipVal) {
+  TJsonReader Reader("{\"a\":{\"b\":[1,[2,{}]],\"c\":3},\"d\":4}");
+  Reader.Next(); Reader.Next(); Reader.Next();
+  EXPECT_TRUE(Reader.IsObjStart());
+  Reader.SkipVal(); EXPECT_TRUE(Reader.IsObjEnd()); EXPECT_EQ(1, Reader.GetDepth());
+  Reader.Next(); EXPECT_STREQ("d", Reader.GetStr().CStr());
+  Reader.Next(); Reader.SkipVal(); EXPECT_EQ(4, Reader.GetInt());
+}
+
+// Values built from reader tokens must match the ones parsed by TJsonVal
+TEST(TJsonReader, EqualsJsonVal) {
+  const char* JsonCStrV[] = {
+    "{}", "[]",
+    "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"e\",\"f\":[{},[],null]}}",
+    "[-1, 0.5, 1e3, 2.5E-3, -0.0, 123456789]",
+    "{\"esc\":\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u0041\\u00e9\\u20ac\"}",
+    "  [ \"a\" ,\n\t\"b\" ]  "
+  };
+  for (int JsonN = 0; JsonN < (int)(sizeof(JsonCStrV) / sizeof(JsonCStrV[0])); JsonN++) {
+    const TStr JsonStr = JsonCStrV[JsonN];
+    PJsonVal Val = TJsonVal::GetValFromStr(JsonStr);
+    PJsonVal ReaderVal = GetReaderVal(JsonStr);
+    EXPECT_TRUE(*Val == *ReaderVal) << JsonStr.CStr();
+  }
+}
+
+// Top-level scalar values
+TEST(TJsonReader, Scalars) {
+  EXPECT_EQ(5, GetReaderVal("5")->GetInt());
+  EXPECT_STREQ("str", GetReaderVal("\"str\"")->GetStr().CStr());
+  EXPECT_TRUE(GetReaderVal(" null ")->IsNull());
+  EXPECT_FALSE(GetReaderVal("false")->GetBool());
+}
+
+// Malformed input must throw
+TEST(TJsonReader, Errors) {
+  const char* JsonCStrV[] = {
+    "", "{", "[1,2", "{\"a\" 1}", "{\"a\":1,}", "[1 2]", "{a:1}", "tru", "nul",
+    "\"abc", "\"\\x\"", "\"\\u12g4\"", "-", "1e", "{} {}", "[1]]", "{\"a\":1]"
+  };
+  for (int JsonN = 0; JsonN < (int)(sizeof(JsonCStrV) / sizeof(JsonCStrV[0])); JsonN++) {
+    TJsonReader Reader(JsonCStrV[JsonN]);
+    bool ExceptP = false;
+    try {
+      while (Reader.Next()) { }
+    } catch (const PExcept& Except) {
+      ExceptP = true;
+    }
+    EXPECT_TRUE(ExceptP) << JsonCStrV[JsonN];
+  }
+}
+
+// Reading through a large document without building the tree
+TEST(TJsonReader, LargeDoc) {
+  TRnd Rnd(1); TChA JsonChA = "[";
+  for (int RecN = 0; RecN < 100000; RecN++) {
+    if (RecN > 0) { JsonChA += ","; }
+    JsonChA += TStr::Fmt("{\"id\":%d,\"name\":\"rec%d\",\"val\":%g,\"tags\":[\"a\",\"b\"],\"ok\":true}",
+      RecN, Rnd.GetUniDevInt(1000), Rnd.GetUniDev());
+  }
+  JsonChA += "]";
+  const TStr JsonStr = JsonChA;
+  PJsonVal Val = TJsonVal::GetValFromStr(JsonStr);
+  TJsonReader Reader(JsonStr); int Tokens = 0;
+  while (Reader.Next()) { Tokens++; }
+  EXPECT_EQ(100000, Val->GetArrVals());
+  EXPECT_EQ(2 + 100000 * 15, Tokens);
+}
+
+// Writer output must parse back to the same value
+TEST(TJsonWriter, RoundTrip) {
+  const char* JsonCStrV[] = {
+    "{}", "[]",
+    "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"e\",\"f\":[{},[],null]},\"g\":true}",
+    "[-1, 0.5, 1e3, 2.5E-3, 123456789, 0.1, 3.141592653589793, 1e300]",
+    "{\"esc\":\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u0001 \\u0041\\u00e9\\u20ac\"}"
+  };
+  for (int JsonN = 0; JsonN < (int)(sizeof(JsonCStrV) / sizeof(JsonCStrV[0])); JsonN++) {
+    PJsonVal Val = TJsonVal::GetValFromStr(JsonCStrV[JsonN]);
+    TJsonWriter Writer; Writer.PutVal(Val);
+    EXPECT_EQ(0, Writer.GetDepth());
+    EXPECT_TRUE(*Val == *GetReaderVal(Writer.GetStr())) << Writer.GetStr().CStr();
+    EXPECT_TRUE(*Val == *TJsonVal::GetValFromStr(Writer.GetStr())) << Writer.GetStr().CStr();
+  }
+}
+
+// Separators, number formatting and escaping
+TEST(TJsonWriter, Format) {
+  TJsonWriter Writer;
+  Writer.PutObjStart();
+  Writer.PutKey("a"); Writer.PutArrStart(); Writer.PutNum(1); Writer.PutNum(-2.5); Writer.PutArrEnd();
+  Writer.PutKey("b"); Writer.PutNum(sqrt(-1.0));
+  Writer.PutKey("c\""); Writer.PutStr("x\ny\xc3\xa9");
+  Writer.PutKey("d"); Writer.PutObjStart(); Writer.PutObjEnd();
+  Writer.PutKey("e"); Writer.PutBool(false);
+  Writer.PutObjEnd();
+  EXPECT_STREQ("{\"a\":[1,-2.5],\"b\":null,\"c\\\"\":\"x\\ny\xc3\xa9\",\"d\":{},\"e\":false}",
+    Writer.GetStr().CStr());
+  // full precision
+  TJsonWriter NumWriter; NumWriter.PutNum(0.1 + 0.2);
+  EXPECT_EQ(0.1 + 0.2, GetReaderVal(NumWriter.GetStr())->GetNum());
+}
+
+// Writing to a stream in chunks gives the same output as writing to memory
+TEST(TJsonWriter, Chunks) {
+  TJsonWriter MemWriter;
+  PSOut SOut = TMOut::New(); TJsonWriter ChunkWriter(SOut, 100);
+  for (int LnN = 0; LnN < 1000; LnN++) {
+    for (int WriterN = 0; WriterN < 2; WriterN++) {
+      TJsonWriter& Writer = (WriterN == 0) ? MemWriter : ChunkWriter;
+      Writer.PutObjStart();
+      Writer.PutKey("id"); Writer.PutNum(LnN);
+      Writer.PutKey("name"); Writer.PutStr(TStr::Fmt("rec%d", LnN));
+      Writer.PutObjEnd(); Writer.PutLn();
+    }
+    // output reaches the stream before the end
+    if (LnN == 500) { EXPECT_LT(0, ((TMOut*)SOut())->Len()); }
+  }
+  ChunkWriter.Flush();
+  EXPECT_STREQ(MemWriter.GetStr().CStr(), ((TMOut*)SOut())->GetAsStr().CStr());
+}
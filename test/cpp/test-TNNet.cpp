@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+#include <mine.h>
+
+// Copy the network through serialization, so that both copies have the same weights
+TSignalProc::PNNet CopyNNet(const TSignalProc::PNNet& NNet) {
+  TMOut SOut; NNet->Save(SOut);
+  PSIn SIn = SOut.GetSIn();
+  return TSignalProc::TNNet::Load(*SIn);
+}
+
+// Random samples from [-1,1] with targets given by a smooth function
+void GenSamples(TRnd& Rnd, const int& Samples, const int& Inputs, const int& Outputs,
+    TFltVV& InVV, TFltVV& TargVV) {
+
+  InVV.Gen(Samples, Inputs); TargVV.Gen(Samples, Outputs);
+  for (int SampleN = 0; SampleN < Samples; SampleN++) {
+    double Sum = 0.0;
+    for (int InputN = 0; InputN < Inputs; InputN++) {
+      InVV(SampleN, InputN) = 2.0 * Rnd.GetUniDev() - 1.0;
+      Sum += InVV(SampleN, InputN);
+    }
+    for (int OutputN = 0; OutputN < Outputs; OutputN++) {
+      TargVV(SampleN, OutputN) = 0.8 * sin(Sum / sqrt((double)Inputs) + OutputN);
+    }
+  }
+}
+
+// Mini-batch step must equal summing single-sample steps before updating the weights
+TEST(TNNet, BatchEqualsOnline) {
+  TIntV LayoutV = TIntV::GetV(5, 7, 3);
+  TSignalProc::PNNet BatchNNet = TSignalProc::TNNet::New(LayoutV, 0.1, 0.5);
+  TSignalProc::PNNet OnlineNNet = CopyNNet(BatchNNet);
+  TRnd Rnd(1); TFltVV InVV, TargVV;
+  GenSamples(Rnd, 20, 5, 3, InVV, TargVV);
+
+  BatchNNet->FeedFwd(InVV);
+  BatchNNet->BackProp(TargVV);
+  for (int SampleN = 0; SampleN < InVV.GetRows(); SampleN++) {
+    TFltV InV; InVV.GetRow(SampleN, InV);
+    TFltV TargV; TargVV.GetRow(SampleN, TargV);
+    OnlineNNet->FeedFwd(InV);
+    OnlineNNet->BackProp(TargV, SampleN == InVV.GetRows() - 1);
+  }
+
+  // predictions of the batch network must match row by row predictions
+  TFltVV BatchResVV; BatchNNet->FeedFwd(InVV); BatchNNet->GetResults(BatchResVV);
+  for (int SampleN = 0; SampleN < InVV.GetRows(); SampleN++) {
+    TFltV InV; InVV.GetRow(SampleN, InV);
+    TFltV BatchResV; BatchNNet->FeedFwd(InV); BatchNNet->GetResults(BatchResV);
+    TFltV OnlineResV; OnlineNNet->FeedFwd(InV); OnlineNNet->GetResults(OnlineResV);
+    for (int OutputN = 0; OutputN < 3; OutputN++) {
+      EXPECT_NEAR(BatchResV[OutputN], BatchResVV(SampleN, OutputN), 1e-12);
+      EXPECT_NEAR(OnlineResV[OutputN], BatchResV[OutputN], 1e-12);
+    }
+  }
+}
+
+// Loaded network must give the same predictions
+TEST(TNNet, SaveLoad) {
+  TIntV LayoutV = TIntV::GetV(4, 6, 6, 2);
+  TSignalProc::PNNet NNet = TSignalProc::TNNet::New(LayoutV, 0.1, 0.5, 
+    TSignalProc::sigmoid, TSignalProc::linear);
+  TRnd Rnd(1); TFltVV InVV, TargVV;
+  GenSamples(Rnd, 50, 4, 2, InVV, TargVV);
+  NNet->FeedFwd(InVV); NNet->BackProp(TargVV);
+  TSignalProc::PNNet LoadNNet = CopyNNet(NNet);
+
+  TFltVV ResVV, LoadResVV;
+  NNet->FeedFwd(InVV); NNet->GetResults(ResVV);
+  LoadNNet->FeedFwd(InVV); LoadNNet->GetResults(LoadResVV);
+  EXPECT_TRUE(ResVV == LoadResVV);
+}
+
+// Save a layer in the layout used before weights were kept in matrices:
+// vector of neurons with their outgoing edges, last neuron is the bias
+void SaveNeuronLayer(TSOut& SOut, const TSignalProc::TTFunc& TFunc, const int& Neurons, const TFltVV& WgtVV) {
+  SOut.Save(Neurons); SOut.Save(Neurons);
+  for (int NeuronN = 0; NeuronN < Neurons; NeuronN++) {
+    TFlt(0.0).Save(SOut); TFlt(0.0).Save(SOut);
+    SaveEnum<TSignalProc::TTFunc>(SOut, TFunc);
+    TFltV SumDeltaWgtV(WgtVV.GetCols()); SumDeltaWgtV.Save(SOut);
+    TVec<TIntFltFltTr> OutEdgeV;
+    for (int EdgeN = 0; EdgeN < WgtVV.GetCols(); EdgeN++) {
+      OutEdgeV.Add(TIntFltFltTr(EdgeN, WgtVV(NeuronN, EdgeN), 0.0)); }
+    OutEdgeV.Save(SOut);
+    TInt(NeuronN).Save(SOut);
+  }
+}
+
+// Models saved with neuron layers load with the same weights
+TEST(TNNet, LoadNeuronLayout) {
+  // 2-2-1 network, hidden tanh and linear output
+  TFltVV InWgtVV(3, 2), HiddenWgtVV(3, 1), OutWgtVV;
+  InWgtVV(0, 0) = 0.5; InWgtVV(0, 1) = -0.25; InWgtVV(1, 0) = 0.125; 
+  InWgtVV(1, 1) = 1.0; InWgtVV(2, 0) = -0.5; InWgtVV(2, 1) = 0.75;
+  HiddenWgtVV(0, 0) = 2.0; HiddenWgtVV(1, 0) = -1.5; HiddenWgtVV(2, 0) = 0.3;
+  TMOut SOut;
+  TFlt(0.1).Save(SOut); TFlt(0.5).Save(SOut);
+  SOut.Save(3); SOut.Save(3);
+  SaveNeuronLayer(SOut, TSignalProc::tanHyper, 3, InWgtVV);
+  SaveNeuronLayer(SOut, TSignalProc::tanHyper, 3, HiddenWgtVV);
+  SaveNeuronLayer(SOut, TSignalProc::linear, 2, OutWgtVV);
+  PSIn SIn = SOut.GetSIn();
+  TSignalProc::PNNet NNet = TSignalProc::TNNet::Load(*SIn);
+  // loaded model is saved in the current layout
+  TSignalProc::PNNet CopyNet = CopyNNet(NNet);
+
+  TRnd Rnd(1); TFltVV InVV, TargVV;
+  GenSamples(Rnd, 10, 2, 1, InVV, TargVV);
+  TFltVV ResVV, CopyResVV;
+  NNet->FeedFwd(InVV); NNet->GetResults(ResVV);
+  CopyNet->FeedFwd(InVV); CopyNet->GetResults(CopyResVV);
+  for (int SampleN = 0; SampleN < InVV.GetRows(); SampleN++) {
+    double Res = HiddenWgtVV(2, 0);
+    for (int HiddenN = 0; HiddenN < 2; HiddenN++) {
+      const double Sum = InWgtVV(0, HiddenN) * InVV(SampleN, 0) + 
+        InWgtVV(1, HiddenN) * InVV(SampleN, 1) + InWgtVV(2, HiddenN);
+      Res += HiddenWgtVV(HiddenN, 0) * tanh(Sum);
+    }
+    EXPECT_NEAR(Res, ResVV(SampleN, 0), 1e-12);
+  }
+  EXPECT_TRUE(ResVV == CopyResVV);
+}
+
+// Learn a smooth function with mini-batches
+TEST(TNNet, MiniBatchLearn) {
+  const int Inputs = 50, Hidden = 200, Outputs = 10;
+  const int Samples = 2048, BatchSize = 64, Epochs = 20;
+  TRnd Rnd(1); TFltVV InVV, TargVV;
+  GenSamples(Rnd, Samples, Inputs, Outputs, InVV, TargVV);
+  TIntV LayoutV = TIntV::GetV(Inputs, Hidden, Outputs);
+  TSignalProc::PNNet NNet = TSignalProc::TNNet::New(LayoutV, 0.001, 0.5);
+
+  // error of the untrained network
+  TFltVV ResVV; NNet->FeedFwd(InVV); NNet->GetResults(ResVV);
+  TLinAlg::LinComb(1.0, ResVV, -1.0, TargVV, ResVV);
+  const double StartErr = TLinAlg::Frob(ResVV);
+
+  for (int EpochN = 0; EpochN < Epochs; EpochN++) {
+    for (int StartN = 0; StartN < Samples; StartN += BatchSize) {
+      TFltVV BatchInVV(BatchSize, Inputs), BatchTargVV(BatchSize, Outputs);
+      for (int SampleN = 0; SampleN < BatchSize; SampleN++) {
+        for (int InputN = 0; InputN < Inputs; InputN++) {
+          BatchInVV(SampleN, InputN) = InVV(StartN + SampleN, InputN); }
+        for (int OutputN = 0; OutputN < Outputs; OutputN++) {
+          BatchTargVV(SampleN, OutputN) = TargVV(StartN + SampleN, OutputN); }
+      }
+      NNet->FeedFwd(BatchInVV);
+      NNet->BackProp(BatchTargVV);
+    }
+  }
+  NNet->FeedFwd(InVV); NNet->GetResults(ResVV);
+  TLinAlg::LinComb(1.0, ResVV, -1.0, TargVV, ResVV);
+  const double EndErr = TLinAlg::Frob(ResVV);
+  EXPECT_LT(EndErr, 0.5 * StartErr);
+}
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+
+// client uses posix sockets
+#ifdef GLib_UNIX
+
+#include <net.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+
+// Server listens on local port, client requests are made from a separate thread
+const int SAppSrvTestPortN = 18787;
+
+// requests running at the same time, and the most seen at once
+std::atomic<int> SAppSrvTestRunning(0);
+std::atomic<int> SAppSrvTestMxRunning(0);
+// requests executed on the loop thread
+std::atomic<int> SAppSrvTestLoopReqs(0);
+std::thread::id SAppSrvTestLoopThreadId;
+
+void CountSAppSrvTestReq() {
+  if (std::this_thread::get_id() == SAppSrvTestLoopThreadId) { SAppSrvTestLoopReqs++; }
+}
+
+// read-only function taking some time, to see requests run in parallel
+class TSAppSrvTestSlow : public TSAppSrvFun {
+public:
+  TSAppSrvTestSlow(): TSAppSrvFun("slow", saotJSon) { }
+  bool IsReadOnly() const { return true; }
+  TStr ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
+    CountSAppSrvTestReq();
+    const int Running = ++SAppSrvTestRunning;
+    int MxRunning = SAppSrvTestMxRunning;
+    while (Running > MxRunning && !SAppSrvTestMxRunning.compare_exchange_weak(MxRunning, Running)) { }
+    usleep(200000);
+    SAppSrvTestRunning--;
+    return "{\"slow\":1}";
+  }
+};
+
+// changes the counter, executed on the loop thread
+class TSAppSrvTestWrite : public TSAppSrvFun {
+private:
+  TInt Writes;
+public:
+  TSAppSrvTestWrite(): TSAppSrvFun("write", saotJSon) { }
+  TStr ExecJSon(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) {
+    CountSAppSrvTestReq(); Writes++;
+    return TStr::Fmt("{\"writes\":%d}", Writes.Val);
+  }
+};
+
+// streams array of given length, fails in the middle when asked to
+class TSAppSrvTestStream : public TSAppSrvFun {
+public:
+  TSAppSrvTestStream(): TSAppSrvFun("stream", saotJSonStream) { }
+  bool IsReadOnly() const { return true; }
+  void ExecJSonStream(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv, TJsonWriter& Writer) {
+    const int Vals = GetFldInt(FldNmValPrV, "n", 10);
+    const bool ErrP = IsFldNm(FldNmValPrV, "err");
+    Writer.PutArrStart();
+    for (int ValN = 0; ValN < Vals; ValN++) {
+      Writer.PutNum(ValN);
+      if (ErrP && ValN == Vals / 2) { TExcept::Throw("Stream error"); }
+    }
+    Writer.PutArrEnd();
+  }
+};
+
+// fails outside of the error handling of TSAppSrvFun::Exec
+class TSAppSrvTestBroken : public TSAppSrvFun {
+public:
+  TSAppSrvTestBroken(): TSAppSrvFun("broken", saotJSon) { }
+  bool IsReadOnly() const { return true; }
+  void Exec(const TStrKdV& FldNmValPrV, const PSAppSrvRqEnv& RqEnv) { TExcept::Throw("Broken function"); }
+};
+
+// connects to the server and sends raw request, returns -1 when not connected
+int SendSAppSrvTestRq(const TStr& RqStr) {
+  const int SockFd = socket(AF_INET, SOCK_STREAM, 0);
+  timeval TimeOut; TimeOut.tv_sec = 10; TimeOut.tv_usec = 0;
+  setsockopt(SockFd, SOL_SOCKET, SO_RCVTIMEO, &TimeOut, sizeof(TimeOut));
+  sockaddr_in Addr; memset(&Addr, 0, sizeof(Addr));
+  Addr.sin_family = AF_INET; Addr.sin_port = htons(SAppSrvTestPortN);
+  Addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  if (connect(SockFd, (sockaddr*)&Addr, sizeof(Addr)) != 0) { close(SockFd); return -1; }
+  send(SockFd, RqStr.CStr(), RqStr.Len(), 0);
+  return SockFd;
+}
+
+// sends raw request and reads the response until the server closes the connection
+TStr GetSAppSrvTestResp(const TStr& RqStr) {
+  const int SockFd = SendSAppSrvTestRq(RqStr);
+  if (SockFd == -1) { return ""; }
+  TChA RespChA; char Bf[4096]; int BfL;
+  while ((BfL = (int)recv(SockFd, Bf, sizeof(Bf), 0)) > 0) { RespChA.AddBf(Bf, BfL); }
+  close(SockFd);
+  return RespChA;
+}
+
+TStr GetSAppSrvTestRq(const TStr& UrlStr, const TStr& VerStr = "HTTP/1.1", const TStr& ConnStr = "close") {
+  return "GET " + UrlStr + " " + VerStr + "\r\nHost: localhost\r\nConnection: " + ConnStr + "\r\n\r\n";
+}
+
+// body of the response, chunks joined together
+TStr GetSAppSrvTestBody(const TStr& RespStr) {
+  const int BodyChN = RespStr.SearchStr("\r\n\r\n");
+  if (BodyChN == -1) { return ""; }
+  const TStr BodyStr = RespStr.GetSubStr(BodyChN + 4, RespStr.Len() - 1);
+  if (!RespStr.GetSubStr(0, BodyChN).IsStrIn("chunked")) { return BodyStr; }
+  TChA BodyChA; int ChN = 0;
+  while (ChN < BodyStr.Len()) {
+    const int LnChN = BodyStr.SearchStr("\r\n", ChN);
+    if (LnChN == -1) { break; }
+    int ChunkLen = 0;
+    if (!BodyStr.GetSubStr(ChN, LnChN - 1).IsHexInt(ChunkLen)) { break; }
+    if (ChunkLen == 0) { return BodyChA; }
+    BodyChA += BodyStr.GetSubStr(LnChN + 2, LnChN + 1 + ChunkLen);
+    ChN = LnChN + 2 + ChunkLen + 2;
+  }
+  // chunks not terminated
+  return "";
+}
+
+// runs server with test functions on the loop, until the client calls exit
+void RunSAppSrvTest(const bool& WorkersP, void (*ClientFun)()) {
+  SAppSrvTestRunning = 0; SAppSrvTestMxRunning = 0; SAppSrvTestLoopReqs = 0;
+  SAppSrvTestLoopThreadId = std::this_thread::get_id();
+  TSAppSrvFunV SrvFunV;
+  SrvFunV.Add(TSASFunExit::New());
+  SrvFunV.Add(new TSAppSrvTestSlow());
+  SrvFunV.Add(new TSAppSrvTestWrite());
+  SrvFunV.Add(new TSAppSrvTestStream());
+  SrvFunV.Add(new TSAppSrvTestBroken());
+  PWebSrv WebSrv = TSAppSrv::New(SAppSrvTestPortN, SrvFunV, TNullNotify::New(), false, true, WorkersP);
+  std::thread ClientThread([ClientFun]() {
+    // loop stops before exit responds, no need to wait for it
+    ClientFun(); close(SendSAppSrvTestRq(GetSAppSrvTestRq("/exit"))); });
+  TLoop::Run();
+  ClientThread.join();
+}
+
+// read-only requests run in parallel on workers, others on the loop thread
+void SAppSrvTestWorkers() {
+  std::thread SlowThreadV[4];
+  TStrV RespStrV(4);
+  for (int ThreadN = 0; ThreadN < 4; ThreadN++) {
+    SlowThreadV[ThreadN] = std::thread([ThreadN, &RespStrV]() {
+      RespStrV[ThreadN] = GetSAppSrvTestResp(GetSAppSrvTestRq("/slow")); });
+  }
+  for (int ThreadN = 0; ThreadN < 4; ThreadN++) { SlowThreadV[ThreadN].join(); }
+  for (int ThreadN = 0; ThreadN < 4; ThreadN++) {
+    EXPECT_TRUE(RespStrV[ThreadN].StartsWith("HTTP/1.1 200")) << RespStrV[ThreadN].CStr();
+    EXPECT_EQ(TStr("{\"slow\":1}"), GetSAppSrvTestBody(RespStrV[ThreadN]));
+  }
+  EXPECT_EQ(TStr("{\"writes\":1}"), GetSAppSrvTestBody(GetSAppSrvTestResp(GetSAppSrvTestRq("/write"))));
+}
+
+TEST(TSAppSrv, Workers) {
+  RunSAppSrvTest(true, SAppSrvTestWorkers);
+  EXPECT_LE(2, SAppSrvTestMxRunning.load());
+  // only the write request
+  EXPECT_EQ(1, SAppSrvTestLoopReqs.load());
+}
+
+TEST(TSAppSrv, NoWorkers) {
+  RunSAppSrvTest(false, SAppSrvTestWorkers);
+  EXPECT_EQ(1, SAppSrvTestMxRunning.load());
+  EXPECT_EQ(5, SAppSrvTestLoopReqs.load());
+}
+
+// pipelined requests on one connection are answered in order
+void SAppSrvTestKeepAlive() {
+  const TStr RqStr = GetSAppSrvTestRq("/slow", "HTTP/1.1", "keep-alive") +
+    GetSAppSrvTestRq("/write", "HTTP/1.1", "keep-alive") + GetSAppSrvTestRq("/write");
+  const TStr RespStr = GetSAppSrvTestResp(RqStr);
+  const int SlowChN = RespStr.SearchStr("{\"slow\":1}");
+  const int Write1ChN = RespStr.SearchStr("{\"writes\":1}");
+  const int Write2ChN = RespStr.SearchStr("{\"writes\":2}");
+  EXPECT_NE(-1, SlowChN);
+  EXPECT_LT(SlowChN, Write1ChN);
+  EXPECT_LT(Write1ChN, Write2ChN);
+}
+
+TEST(TSAppSrv, KeepAlive) {
+  RunSAppSrvTest(true, SAppSrvTestKeepAlive);
+}
+
+// large output goes in chunks to HTTP/1.1 clients, in one piece to HTTP/1.0 ones
+void SAppSrvTestStream() {
+  TChA ExpectChA = "[";
+  for (int ValN = 0; ValN < 100000; ValN++) { if (ValN > 0) { ExpectChA += ","; } ExpectChA += TInt::GetStr(ValN); }
+  ExpectChA += "]";
+  const TStr ChunkedRespStr = GetSAppSrvTestResp(GetSAppSrvTestRq("/stream?n=100000"));
+  EXPECT_TRUE(ChunkedRespStr.GetLc().IsStrIn("transfer-encoding: chunked"));
+  EXPECT_EQ(TStr(ExpectChA), GetSAppSrvTestBody(ChunkedRespStr));
+  const TStr RespStr = GetSAppSrvTestResp(GetSAppSrvTestRq("/stream?n=100000", "HTTP/1.0"));
+  EXPECT_FALSE(RespStr.IsStrIn("chunked"));
+  EXPECT_EQ(TStr(ExpectChA), GetSAppSrvTestBody(RespStr));
+  // small output is sent as normal response
+  const TStr SmallRespStr = GetSAppSrvTestResp(GetSAppSrvTestRq("/stream?n=3"));
+  EXPECT_FALSE(SmallRespStr.IsStrIn("chunked"));
+  EXPECT_EQ(TStr("[0,1,2]"), GetSAppSrvTestBody(SmallRespStr));
+}
+
+TEST(TSAppSrv, Stream) {
+  RunSAppSrvTest(true, SAppSrvTestStream);
+}
+
+// errors after part of the response was sent, or thrown past the function,
+// drop the connection and are counted in statistics
+void SAppSrvTestErrors() {
+  const TStr StreamRespStr = GetSAppSrvTestResp(GetSAppSrvTestRq("/stream?n=100000&err=1"));
+  EXPECT_TRUE(StreamRespStr.StartsWith("HTTP/1.1 200"));
+  EXPECT_EQ(TStr(), GetSAppSrvTestBody(StreamRespStr));
+  // small output fails before anything is sent, client gets the error
+  const TStr SmallRespStr = GetSAppSrvTestResp(GetSAppSrvTestRq("/stream?n=4&err=1"));
+  EXPECT_TRUE(SmallRespStr.StartsWith("HTTP/1.1 500")) << SmallRespStr.CStr();
+  EXPECT_TRUE(SmallRespStr.IsStrIn("Stream error"));
+  EXPECT_EQ(TStr(), GetSAppSrvTestResp(GetSAppSrvTestRq("/broken")));
+  // server keeps working
+  EXPECT_EQ(TStr("{\"writes\":1}"), GetSAppSrvTestBody(GetSAppSrvTestResp(GetSAppSrvTestRq("/write"))));
+  PJsonVal ListVal = TJsonVal::GetValFromStr(GetSAppSrvTestBody(GetSAppSrvTestResp(GetSAppSrvTestRq("/"))));
+  ASSERT_TRUE(ListVal->IsObjKey("functions"));
+  PJsonVal FunArrVal = ListVal->GetObjKey("functions");
+  THash<TStr, PJsonVal> FunNmToStatH;
+  for (int FunN = 0; FunN < FunArrVal->GetArrVals(); FunN++) {
+    PJsonVal FunVal = FunArrVal->GetArrVal(FunN);
+    if (FunVal->IsObjKey("stat")) { FunNmToStatH.AddDat(FunVal->GetObjStr("name"), FunVal->GetObjKey("stat")); }
+  }
+  ASSERT_TRUE(FunNmToStatH.IsKey("stream"));
+  EXPECT_EQ(2, FunNmToStatH.GetDat("stream")->GetObjInt("requests"));
+  EXPECT_EQ(2, FunNmToStatH.GetDat("stream")->GetObjInt("errors"));
+  ASSERT_TRUE(FunNmToStatH.IsKey("broken"));
+  EXPECT_EQ(1, FunNmToStatH.GetDat("broken")->GetObjInt("errors"));
+  ASSERT_TRUE(FunNmToStatH.IsKey("write"));
+  EXPECT_EQ(0, FunNmToStatH.GetDat("write")->GetObjInt("errors"));
+}
+
+TEST(TSAppSrv, Errors) {
+  RunSAppSrvTest(true, SAppSrvTestErrors);
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder, records are added one by one
+// to the first base and with bulk load to the second one
+const TStr BulkTestFPath = "./bulk-test/";
+const TStr BulkRecTestFPath = "./bulk-rec-test/";
+const TStr BulkNextTestFPath = "./bulk-next-test/";
+
+void InitBulkTestDir(const TStr& FPath) {
+  if (TDir::Exists(FPath)) {
+    TStrV FNmV; TFFile::GetFNmV(FPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(FPath);
+  }
+}
+
+void InitBulkTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  InitBulkTestDir(BulkTestFPath); InitBulkTestDir(BulkRecTestFPath);
+}
+
+const TStr BulkSchema = "[{\"name\":\"People\",\"fields\":["
+  "{\"name\":\"Name\",\"type\":\"string\",\"primary\":true},"
+  "{\"name\":\"Age\",\"type\":\"int\",\"null\":true},"
+  "{\"name\":\"Tag\",\"type\":\"string\",\"null\":true},"
+  "{\"name\":\"Bio\",\"type\":\"string\",\"null\":true}],"
+  "\"joins\":[{\"name\":\"Friends\",\"type\":\"index\",\"store\":\"People\",\"inverse\":\"FriendOf\"},"
+  "{\"name\":\"FriendOf\",\"type\":\"index\",\"store\":\"People\",\"inverse\":\"Friends\"},"
+  "{\"name\":\"Best\",\"type\":\"field\",\"store\":\"People\"}],"
+  "\"keys\":[{\"field\":\"Tag\",\"type\":\"value\"},{\"field\":\"Bio\",\"type\":\"value\"}]}]";
+
+// The first People records are new, the rest update them by primary field.
+// Only new records have nested joins, and only to records added before them.
+TStr GetBulkRecStr(TRnd& Rnd, const int& RecN, const int& People, const bool& JoinsP) {
+  const int PersonN = (RecN < People) ? RecN : Rnd.GetUniDevInt(People);
+  TChA RecChA = TStr::Fmt("{\"Name\":\"p%d\",\"Age\":%d,\"Tag\":\"%c\",\"Bio\":\"w%d\"",
+    PersonN, Rnd.GetUniDevInt(100), 'a' + Rnd.GetUniDevInt(3), Rnd.GetUniDevInt(50));
+  if (JoinsP && RecN < People && PersonN > 0 && Rnd.GetUniDevInt(3) == 0) {
+    RecChA += TStr::Fmt(",\"Friends\":[{\"Name\":\"p%d\"},{\"Name\":\"p%d\"}]",
+      Rnd.GetUniDevInt(PersonN), Rnd.GetUniDevInt(PersonN));
+    RecChA += TStr::Fmt(",\"Best\":{\"Name\":\"p%d\"}", Rnd.GetUniDevInt(PersonN));
+  }
+  RecChA += "}";
+  return RecChA;
+}
+
+// Records as JSon lines
+TStr GetBulkRecLns(TRnd& Rnd, const int& Recs, const int& People, const bool& JoinsP) {
+  TChA LnChA;
+  for (int RecN = 0; RecN < Recs; RecN++) { LnChA += GetBulkRecStr(Rnd, RecN, People, JoinsP); LnChA += '\n'; }
+  return LnChA;
+}
+
+// Add JSon lines to the store one by one
+void AddBulkRecLns(const TWPt<TBase>& Base, const TStr& LnStr) {
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("People");
+  PSIn SIn = TMIn::New(LnStr); TStr RecStr;
+  while (SIn->GetNextLn(RecStr)) { Store->AddRec(TJsonVal::GetValFromStr(RecStr)); }
+}
+
+// sorted names of joined records
+TStr GetBulkJoinStr(const TWPt<TBase>& Base, const TRec& Rec, const TStr& JoinNm) {
+  PRecSet JoinRecSet = Rec.DoJoin(Base, JoinNm);
+  TStrV NameV;
+  for (int RecN = 0; RecN < JoinRecSet->GetRecs(); RecN++) {
+    NameV.Add(JoinRecSet->GetStore()->GetFieldNmStr(JoinRecSet->GetRecId(RecN), "Name")); }
+  NameV.Sort();
+  return TStr::GetStr(NameV, ",");
+}
+
+// record contents by name, joined records are given by names
+void GetBulkRecStrH(const TWPt<TBase>& Base, THash<TStr, TStr>& RecStrH) {
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("People");
+  RecStrH.Clr();
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    const TRec Rec = Store->GetRec(Iter->GetRecId());
+    TChA RecChA;
+    RecChA += Rec.IsFieldNull(1) ? TStr("null") : TInt::GetStr(Rec.GetFieldInt(1)); RecChA += '|';
+    RecChA += Rec.IsFieldNull(2) ? TStr("null") : Rec.GetFieldStr(2); RecChA += '|';
+    RecChA += Rec.IsFieldNull(3) ? TStr("null") : Rec.GetFieldStr(3); RecChA += '|';
+    RecChA += GetBulkJoinStr(Base, Rec, "Friends"); RecChA += '|';
+    RecChA += GetBulkJoinStr(Base, Rec, "FriendOf"); RecChA += '|';
+    RecChA += GetBulkJoinStr(Base, Rec, "Best");
+    RecStrH.AddDat(Rec.GetFieldStr(0), RecChA);
+  }
+}
+
+// sorted names of records matching the query
+void GetBulkSearch(const TWPt<TBase>& Base, const TStr& QueryStr, TStrV& NameV) {
+  PRecSet RecSet = Base->Search(QueryStr); NameV.Clr();
+  for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) {
+    NameV.Add(RecSet->GetStore()->GetFieldNmStr(RecSet->GetRecId(RecN), "Name")); }
+  NameV.Sort();
+}
+
+// both bases have the same records, joins and index
+void CheckBulkBases(const TWPt<TBase>& RecBase, const TWPt<TBase>& BulkBase) {
+  EXPECT_FALSE(BulkBase->IsTempIndex());
+  THash<TStr, TStr> RecStrH, BulkStrH;
+  GetBulkRecStrH(RecBase, RecStrH); GetBulkRecStrH(BulkBase, BulkStrH);
+  EXPECT_LT(0, RecStrH.Len());
+  EXPECT_EQ(RecStrH.Len(), BulkStrH.Len());
+  int Diffs = 0;
+  int KeyId = RecStrH.FFirstKeyId();
+  while (RecStrH.FNextKeyId(KeyId)) {
+    const TStr& Name = RecStrH.GetKey(KeyId);
+    if (!BulkStrH.IsKey(Name) || BulkStrH.GetDat(Name) != RecStrH[KeyId]) { Diffs++; }
+  }
+  EXPECT_EQ(0, Diffs);
+  TStrV QueryStrV = TStrV::GetV("{\"$from\":\"People\",\"Tag\":\"a\"}",
+    "{\"$from\":\"People\",\"Tag\":\"c\"}", "{\"$from\":\"People\",\"Bio\":\"w7\"}",
+    "{\"$from\":\"People\",\"Tag\":\"b\",\"Bio\":\"w2\"}");
+  for (int QueryN = 0; QueryN < QueryStrV.Len(); QueryN++) {
+    TStrV RecNameV, BulkNameV;
+    GetBulkSearch(RecBase, QueryStrV[QueryN], RecNameV);
+    GetBulkSearch(BulkBase, QueryStrV[QueryN], BulkNameV);
+    EXPECT_FALSE(RecNameV.Empty()); EXPECT_EQ(RecNameV, BulkNameV);
+  }
+}
+
+// Counts calls of the store triggers
+class TBulkCountTrigger : public TStoreTrigger {
+public:
+  int Adds, Updates;
+  TBulkCountTrigger(): Adds(0), Updates(0) { }
+  static PStoreTrigger New() { return new TBulkCountTrigger; }
+  void OnAdd(const TRec& Rec) { Adds++; }
+  void OnUpdate(const TRec& Rec) { Updates++; }
+  void OnDelete(const TRec& Rec) { }
+};
+
+// Memory stream that fails at the end of line FailLnN
+class TBulkFailSIn : public TMIn {
+private:
+  int LnN, FailLnN;
+public:
+  TBulkFailSIn(const TStr& Str, const int& _FailLnN):
+    TSBase("Input-Memory"), TMIn(Str), LnN(0), FailLnN(_FailLnN) { }
+  static PSIn New(const TStr& Str, const int& FailLnN) { return new TBulkFailSIn(Str, FailLnN); }
+  char GetCh() {
+    const char Ch = TMIn::GetCh();
+    if (Ch == '\n' && LnN++ == FailLnN) { throw TExcept::New("Stream failed"); }
+    return Ch;
+  }
+};
+
+// small batches and index cache, so postings go through several temporary index runs
+TEST(TStoreBulk, TempIndexRuns) {
+  InitBulkTest(); TRnd Rnd(1);
+  const TStr LnStr = GetBulkRecLns(Rnd, 3000, 3000, false);
+  TWPt<TBase> RecBase = TStorage::NewBase(BulkRecTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TBase> BulkBase = TStorage::NewBase(BulkTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  AddBulkRecLns(RecBase, LnStr);
+  EXPECT_EQ(3000, BulkBase->GetStoreByStoreNm("People")->AddRecBulk(TMIn::New(LnStr), 100, 10000));
+  CheckBulkBases(RecBase, BulkBase);
+  // and records added after the load are indexed as usual
+  const TStr NextLnStr = GetBulkRecLns(Rnd, 200, 100, false);
+  AddBulkRecLns(RecBase, NextLnStr); AddBulkRecLns(BulkBase, NextLnStr);
+  CheckBulkBases(RecBase, BulkBase);
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// records with the same primary field within one batch update the first one
+TEST(TStoreBulk, PrimaryUpdates) {
+  InitBulkTest(); TRnd Rnd(1);
+  const TStr LnStr = GetBulkRecLns(Rnd, 2000, 500, false);
+  TWPt<TBase> RecBase = TStorage::NewBase(BulkRecTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TBase> BulkBase = TStorage::NewBase(BulkTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  AddBulkRecLns(RecBase, LnStr);
+  EXPECT_EQ(2000, BulkBase->GetStoreByStoreNm("People")->AddRecBulk(TMIn::New(LnStr), 10000));
+  EXPECT_EQ(500, BulkBase->GetStoreByStoreNm("People")->GetRecs());
+  CheckBulkBases(RecBase, BulkBase);
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// nested join records are added after all records of the load
+TEST(TStoreBulk, NestedJoins) {
+  InitBulkTest(); TRnd Rnd(1);
+  const TStr LnStr = GetBulkRecLns(Rnd, 3000, 2000, true);
+  TWPt<TBase> RecBase = TStorage::NewBase(BulkRecTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TBase> BulkBase = TStorage::NewBase(BulkTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  AddBulkRecLns(RecBase, LnStr);
+  BulkBase->GetStoreByStoreNm("People")->AddRecBulk(TMIn::New(LnStr), 300, 10000);
+  CheckBulkBases(RecBase, BulkBase);
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// triggers see all new and updated records, or none when disabled
+TEST(TStoreBulk, Triggers) {
+  InitBulkTest(); TRnd Rnd(1);
+  const TStr LnStr = GetBulkRecLns(Rnd, 2000, 1500, true);
+  TWPt<TBase> RecBase = TStorage::NewBase(BulkRecTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TBase> BulkBase = TStorage::NewBase(BulkTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  PStoreTrigger RecTrigger = TBulkCountTrigger::New();
+  PStoreTrigger BulkTrigger = TBulkCountTrigger::New();
+  RecBase->GetStoreByStoreNm("People")->AddTrigger(RecTrigger);
+  BulkBase->GetStoreByStoreNm("People")->AddTrigger(BulkTrigger);
+  TBulkCountTrigger& RecCount = dynamic_cast<TBulkCountTrigger&>(*RecTrigger);
+  TBulkCountTrigger& BulkCount = dynamic_cast<TBulkCountTrigger&>(*BulkTrigger);
+  AddBulkRecLns(RecBase, LnStr);
+  BulkBase->GetStoreByStoreNm("People")->AddRecBulk(TMIn::New(LnStr), 300, 10000, true);
+  EXPECT_EQ(1500, RecCount.Adds); EXPECT_EQ(RecCount.Adds, BulkCount.Adds);
+  EXPECT_LT(0, RecCount.Updates); EXPECT_EQ(RecCount.Updates, BulkCount.Updates);
+  // disabled for the load only
+  const TStr NextLnStr = GetBulkRecLns(Rnd, 2000, 1500, true);
+  InitBulkTestDir(BulkNextTestFPath);
+  TWPt<TBase> NextBase = TStorage::NewBase(BulkNextTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  PStoreTrigger NextTrigger = TBulkCountTrigger::New();
+  NextBase->GetStoreByStoreNm("People")->AddTrigger(NextTrigger);
+  TBulkCountTrigger& NextCount = dynamic_cast<TBulkCountTrigger&>(*NextTrigger);
+  NextBase->GetStoreByStoreNm("People")->AddRecBulk(TMIn::New(NextLnStr), 300, 10000, false);
+  EXPECT_EQ(1500, NextBase->GetStoreByStoreNm("People")->GetRecs());
+  EXPECT_EQ(0, NextCount.Adds); EXPECT_EQ(0, NextCount.Updates);
+  AddBulkRecLns(NextBase, GetBulkRecStr(Rnd, 0, 1, false) + "\n");
+  EXPECT_EQ(0, NextCount.Adds); EXPECT_EQ(1, NextCount.Updates);
+  TStorage::SaveBase(NextBase); NextBase.Del();
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// failed load keeps records of complete batches indexed, and next load continues
+TEST(TStoreBulk, StreamError) {
+  InitBulkTest(); TRnd Rnd(1);
+  const TStr LnStr = GetBulkRecLns(Rnd, 1000, 1000, false);
+  TWPt<TBase> RecBase = TStorage::NewBase(BulkRecTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TBase> BulkBase = TStorage::NewBase(BulkTestFPath, TJsonVal::GetValFromStr(BulkSchema), 1000000, 1000000);
+  TWPt<TStore> BulkStore = BulkBase->GetStoreByStoreNm("People");
+  EXPECT_ANY_THROW(BulkStore->AddRecBulk(TBulkFailSIn::New(LnStr, 450), 100, 10000));
+  EXPECT_FALSE(BulkBase->IsTempIndex());
+  EXPECT_EQ(400, BulkStore->GetRecs());
+  // reference has the same records
+  TStrV LnV; LnStr.SplitOnAllCh('\n', LnV);
+  TChA FirstLnChA, RestLnChA;
+  for (int LnN = 0; LnN < LnV.Len(); LnN++) {
+    TChA& LnChA = (LnN < 400) ? FirstLnChA : RestLnChA; LnChA += LnV[LnN]; LnChA += '\n'; }
+  AddBulkRecLns(RecBase, FirstLnChA);
+  CheckBulkBases(RecBase, BulkBase);
+  // load the rest
+  AddBulkRecLns(RecBase, RestLnChA);
+  EXPECT_EQ(600, BulkStore->AddRecBulk(TMIn::New(RestLnChA), 100, 10000));
+  CheckBulkBases(RecBase, BulkBase);
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder, records are parsed into JSon
+// values in the first base and added from JSon strings in the second
+const TStr JsonStrTestFPath = "./json-str-test/";
+const TStr JsonValTestFPath = "./json-val-test/";
+
+void InitJsonStrTestDir(const TStr& FPath) {
+  if (TDir::Exists(FPath)) {
+    TStrV FNmV; TFFile::GetFNmV(FPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(FPath);
+  }
+}
+
+void InitJsonStrTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  InitJsonStrTestDir(JsonStrTestFPath); InitJsonStrTestDir(JsonValTestFPath);
+}
+
+// all field types, in memory and on disk
+const TStr JsonStrSchema = "[{\"name\":\"Recs\",\"fields\":["
+  "{\"name\":\"Name\",\"type\":\"string\",\"primary\":true},"
+  "{\"name\":\"Int\",\"type\":\"int\"},"
+  "{\"name\":\"UInt64\",\"type\":\"uint64\",\"null\":true},"
+  "{\"name\":\"Flt\",\"type\":\"float\",\"null\":true},"
+  "{\"name\":\"Bool\",\"type\":\"bool\",\"null\":true},"
+  "{\"name\":\"FltPr\",\"type\":\"float_pair\",\"null\":true},"
+  "{\"name\":\"Tm\",\"type\":\"datetime\",\"null\":true},"
+  "{\"name\":\"IntV\",\"type\":\"int_v\",\"null\":true,\"store\":\"cache\"},"
+  "{\"name\":\"Str\",\"type\":\"string\",\"null\":true,\"store\":\"cache\"},"
+  "{\"name\":\"StrV\",\"type\":\"string_v\",\"null\":true},"
+  "{\"name\":\"FltV\",\"type\":\"float_v\",\"null\":true},"
+  "{\"name\":\"Code\",\"type\":\"string\",\"null\":true,\"codebook\":true},"
+  "{\"name\":\"Short\",\"type\":\"string\",\"null\":true,\"shortstring\":true},"
+  "{\"name\":\"NumSpV\",\"type\":\"num_sp_v\",\"null\":true},"
+  "{\"name\":\"Dflt\",\"type\":\"string\",\"default\":\"dflt\"}],"
+  "\"keys\":[{\"field\":\"Str\",\"type\":\"value\"},{\"field\":\"Code\",\"type\":\"value\"}]}]";
+
+const char* JsonStrFieldNmV[] = { "Name", "Int", "UInt64", "Flt", "Bool", "FltPr", "Tm",
+  "IntV", "Str", "StrV", "FltV", "Code", "Short", "NumSpV", "Dflt" };
+
+// string with escapes and non-ascii characters
+TStr GetJsonStrTestStr(TRnd& Rnd) {
+  const char* PartV[] = { "a", "b\\\"q", "\\u00e9", "\\n", "x y", "\\ud83d\\ude00", "\\/", "z" };
+  TChA StrChA = "\"";
+  for (int PartN = Rnd.GetUniDevInt(4); PartN > 0; PartN--) { StrChA += PartV[Rnd.GetUniDevInt(8)]; }
+  StrChA += "\"";
+  return StrChA;
+}
+
+// random value of the field
+TStr GetJsonStrTestVal(TRnd& Rnd, const int& FieldN) {
+  TChA ValChA;
+  switch (FieldN) {
+    case 0: return TStr::Fmt("\"n%d\"", Rnd.GetUniDevInt(1500));
+    case 1: return TInt::GetStr(Rnd.GetUniDevInt(2000) - 1000);
+    case 2: return TInt::GetStr(Rnd.GetUniDevInt(100000));
+    case 3: return TFlt::GetStr(Rnd.GetNrmDev() * 1e3, "%g");
+    case 4: return Rnd.GetUniDevInt(2) ? "true" : "false";
+    case 5: return TStr::Fmt("[%g, %g]", Rnd.GetNrmDev(), Rnd.GetUniDev());
+    case 6: return TStr::Fmt("\"2014-%02d-%02dT%02d:%02d:%02d.%03d\"", 1 + Rnd.GetUniDevInt(12),
+      1 + Rnd.GetUniDevInt(28), Rnd.GetUniDevInt(24), Rnd.GetUniDevInt(60), Rnd.GetUniDevInt(60), Rnd.GetUniDevInt(1000));
+    case 7: ValChA += "[";
+      for (int ValN = Rnd.GetUniDevInt(4); ValN > 0; ValN--) { ValChA += TStr::Fmt("%d%s", Rnd.GetUniDevInt(100), ValN > 1 ? "," : ""); }
+      ValChA += "]"; return ValChA;
+    case 9: ValChA += "[ ";
+      for (int ValN = Rnd.GetUniDevInt(4); ValN > 0; ValN--) { ValChA += GetJsonStrTestStr(Rnd) + (ValN > 1 ? " , " : ""); }
+      ValChA += " ]"; return ValChA;
+    case 10: ValChA += "[";
+      for (int ValN = Rnd.GetUniDevInt(4); ValN > 0; ValN--) { ValChA += TStr::Fmt("%g%s", Rnd.GetUniDev(), ValN > 1 ? "," : ""); }
+      ValChA += "]"; return ValChA;
+    case 13: ValChA += "[";
+      for (int ValN = Rnd.GetUniDevInt(4); ValN > 0; ValN--) { ValChA += TStr::Fmt("[%d,%g]%s", Rnd.GetUniDevInt(50), Rnd.GetUniDev(), ValN > 1 ? "," : ""); }
+      ValChA += "]"; return ValChA;
+  }
+  return GetJsonStrTestStr(Rnd);
+}
+
+// record with shuffled, missing and null fields
+TStr GetJsonStrTestRec(TRnd& Rnd) {
+  TIntV FieldNV; for (int FieldN = 0; FieldN < 15; FieldN++) { FieldNV.Add(FieldN); }
+  if (Rnd.GetUniDevInt(2) == 0) { FieldNV.Shuffle(Rnd); }
+  TChA RecChA = "{";
+  for (int FieldNN = 0; FieldNN < FieldNV.Len(); FieldNN++) {
+    const int FieldN = FieldNV[FieldNN];
+    // only the first two fields are required
+    if (FieldN >= 2 && Rnd.GetUniDevInt(5) == 0) { continue; }
+    const bool NullP = (FieldN >= 2 && FieldN != 14 && Rnd.GetUniDevInt(6) == 0);
+    if (RecChA.Len() > 1) { RecChA += ", "; }
+    RecChA += TStr::Fmt("\"%s\" : %s", JsonStrFieldNmV[FieldN], NullP ? "null" : GetJsonStrTestVal(Rnd, FieldN).CStr());
+  }
+  if (Rnd.GetUniDevInt(10) == 0) { RecChA += ", \"extra\": {\"a\":[1,{\"b\":null}]}"; }
+  RecChA += "}";
+  return RecChA;
+}
+
+// sorted ids of records matching the query
+void GetJsonStrTestSearch(const TWPt<TBase>& Base, const PJsonVal& QueryVal, TUInt64V& RecIdV) {
+  PRecSet RecSet = Base->Search(QueryVal); RecIdV.Clr();
+  for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) { RecIdV.Add(RecSet->GetRecId(RecN)); }
+  RecIdV.Sort();
+}
+
+// records added from JSon strings are stored with the same bytes as parsed ones
+TEST(TStoreJsonStr, SameRecBytes) {
+  InitJsonStrTest(); TRnd Rnd(1);
+  TWPt<TBase> ValBase = TStorage::NewBase(JsonValTestFPath, TJsonVal::GetValFromStr(JsonStrSchema), 1000000, 1000000);
+  TWPt<TBase> StrBase = TStorage::NewBase(JsonStrTestFPath, TJsonVal::GetValFromStr(JsonStrSchema), 1000000, 1000000);
+  TWPt<TStore> ValStore = ValBase->GetStoreByStoreNm("Recs");
+  TWPt<TStore> StrStore = StrBase->GetStoreByStoreNm("Recs");
+  int FastRecs = 0;
+  for (int RecN = 0; RecN < 3000; RecN++) {
+    const TStr RecStr = GetJsonStrTestRec(Rnd);
+    const uint64 ValRecId = ValStore->AddRec(TJsonVal::GetValFromStr(RecStr));
+    uint64 StrRecId = TUInt64::Mx;
+    if (StrStore->TryAddRecJsonStr(RecStr, StrRecId)) { FastRecs++; }
+    else { StrRecId = StrStore->AddRec(TJsonVal::GetValFromStr(RecStr)); }
+    EXPECT_EQ(ValRecId, StrRecId);
+  }
+  // most records are new and take the direct path
+  EXPECT_LT(1000, FastRecs);
+  // both bases find the same records by keys
+  int Searches = 0;
+  PStoreIter Iter = ValStore->GetIter();
+  while (Iter->Next()) {
+    const uint64 RecId = Iter->GetRecId();
+    for (int FieldN = 8; FieldN <= 11; FieldN += 3) {
+      if (ValStore->IsFieldNull(RecId, FieldN)) { continue; }
+      PJsonVal QueryVal = TJsonVal::NewObj("$from", TStr("Recs"));
+      QueryVal->AddToObj(JsonStrFieldNmV[FieldN], ValStore->GetFieldStr(RecId, FieldN));
+      TUInt64V ValRecIdV, StrRecIdV;
+      GetJsonStrTestSearch(ValBase, QueryVal, ValRecIdV);
+      GetJsonStrTestSearch(StrBase, QueryVal, StrRecIdV);
+      EXPECT_EQ(ValRecIdV, StrRecIdV); Searches++;
+    }
+  }
+  EXPECT_LT(0, Searches);
+  TStorage::SaveBase(ValBase); ValBase.Del();
+  TStorage::SaveBase(StrBase); StrBase.Del();
+  // store files match byte for byte, index files can list keys in different order
+  TStrV FNmV; TFFile::GetFNmV(JsonValTestFPath, TStrV(), false, FNmV);
+  int StoreFiles = 0;
+  for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) {
+    const TStr FNm = FNmV[FNmN].GetFBase();
+    if (!FNm.StartsWith("Recs.")) { continue; }
+    StoreFiles++;
+    TMem ValMem; TMem::LoadMem(TFIn::New(JsonValTestFPath + FNm), ValMem);
+    TMem StrMem; TMem::LoadMem(TFIn::New(JsonStrTestFPath + FNm), StrMem);
+    ASSERT_EQ(ValMem.Len(), StrMem.Len()) << FNm.CStr();
+    EXPECT_EQ(0, memcmp(ValMem.GetBf(), StrMem.GetBf(), ValMem.Len())) << FNm.CStr();
+  }
+  EXPECT_LT(0, StoreFiles);
+}
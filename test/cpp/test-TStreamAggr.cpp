@@ -0,0 +1,404 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder, the second base is used
+// when comparing bulk load with adding records one by one
+const TStr StreamAggrTestFPath = "./stream-aggr-test/";
+const TStr StreamAggrBulkTestFPath = "./stream-aggr-bulk-test/";
+
+void InitStreamAggrTestDir(const TStr& FPath) {
+  if (TDir::Exists(FPath)) {
+    TStrV FNmV; TFFile::GetFNmV(FPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(FPath);
+  }
+}
+
+void InitStreamAggrTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  InitStreamAggrTestDir(StreamAggrTestFPath); InitStreamAggrTestDir(StreamAggrBulkTestFPath);
+}
+
+const TStr StreamAggrSchema = "[{\"name\":\"T\",\"fields\":["
+  "{\"name\":\"Time\",\"type\":\"datetime\"},{\"name\":\"Val\",\"type\":\"float\"}]}]";
+
+const uint64 WinBufTestMSecs = 10000;
+
+// window buffer with min and max on top of it
+void AddWinBufTestAggrs(const TWPt<TBase>& Base) {
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "timeSeriesWinBuf", TJsonVal::GetValFromStr(TStr::Fmt(
+    "{\"store\":\"T\",\"name\":\"WinBuf\",\"timestamp\":\"Time\",\"value\":\"Val\",\"winsize\":%d}", (int)WinBufTestMSecs))));
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "winBufMin",
+    TJsonVal::GetValFromStr("{\"store\":\"T\",\"name\":\"Min\",\"inAggr\":\"WinBuf\"}")));
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "winBufMax",
+    TJsonVal::GetValFromStr("{\"store\":\"T\",\"name\":\"Max\",\"inAggr\":\"WinBuf\"}")));
+}
+
+TWPt<TBase> NewWinBufTestBase() {
+  TWPt<TBase> Base = TStorage::NewBase(StreamAggrTestFPath, TJsonVal::GetValFromStr(StreamAggrSchema), 1000000, 1000000);
+  AddWinBufTestAggrs(Base);
+  return Base;
+}
+
+// reference window, values leave it once they are more than window size older than the newest one
+class TWinBufTestRef {
+public:
+  TFltUInt64PrV ValV;
+  TFltV OutValV;
+  TUInt64V OutTmMSecsV;
+
+  void Add(const double& Val, const uint64& TmMSecs) {
+    OutValV.Clr(); OutTmMSecsV.Clr();
+    while (!ValV.Empty() && TmMSecs - ValV[0].Val2 > WinBufTestMSecs) {
+      OutValV.Add(ValV[0].Val1); OutTmMSecsV.Add(ValV[0].Val2); ValV.Del(0);
+    }
+    ValV.Add(TFltUInt64Pr(Val, TmMSecs));
+  }
+};
+
+// adds record to the base and the reference window
+void AddWinBufTestRec(const TWPt<TBase>& Base, TWinBufTestRef& Ref, const double& Val, const uint64& TmMSecs) {
+  PJsonVal RecVal = TJsonVal::NewObj();
+  RecVal->AddToObj("Time", TTm::GetTmFromMSecs(TmMSecs).GetWebLogDateTimeStr(true, "T"));
+  RecVal->AddToObj("Val", Val);
+  Base->AddRec("T", RecVal); Ref.Add(Val, TmMSecs);
+}
+
+// window, outgoing values, minimum and maximum match the reference
+void CheckWinBufTest(const TWPt<TBase>& Base, const TWinBufTestRef& Ref) {
+  TStreamAggrs::TTimeSeriesWinBuf* WinBuf =
+    dynamic_cast<TStreamAggrs::TTimeSeriesWinBuf*>(Base->GetStreamAggr("T", "WinBuf")());
+  ASSERT_TRUE(WinBuf != NULL);
+  TFltV ValV, RefValV; WinBuf->GetFltV(ValV);
+  TUInt64V TmMSecsV, RefTmMSecsV; WinBuf->GetTmV(TmMSecsV);
+  double MnVal = TFlt::Mx, MxVal = TFlt::Mn;
+  for (int ValN = 0; ValN < Ref.ValV.Len(); ValN++) {
+    RefValV.Add(Ref.ValV[ValN].Val1); RefTmMSecsV.Add(Ref.ValV[ValN].Val2);
+    MnVal = TFlt::GetMn(MnVal, Ref.ValV[ValN].Val1); MxVal = TFlt::GetMx(MxVal, Ref.ValV[ValN].Val1);
+  }
+  ASSERT_EQ(Ref.ValV.Len(), WinBuf->GetN());
+  ASSERT_EQ(RefValV, ValV);
+  ASSERT_EQ(RefTmMSecsV, TmMSecsV);
+  ASSERT_EQ(Ref.OutValV, WinBuf->GetOutFltV());
+  ASSERT_EQ(Ref.OutTmMSecsV, WinBuf->GetOutTmMSecsV());
+  TStreamAggrOut::IFlt* Min = dynamic_cast<TStreamAggrOut::IFlt*>(Base->GetStreamAggr("T", "Min")());
+  TStreamAggrOut::IFlt* Max = dynamic_cast<TStreamAggrOut::IFlt*>(Base->GetStreamAggr("T", "Max")());
+  ASSERT_EQ(MnVal, Min->GetFlt());
+  ASSERT_EQ(MxVal, Max->GetFlt());
+}
+
+// slow records that keep the buffer wrapped, followed by a burst within the
+// same second that fills it up and makes it grow from a non-zero start
+void AddWinBufTestCycle(const TWPt<TBase>& Base, TWinBufTestRef& Ref, TRnd& Rnd, uint64& TmMSecs, const int& BurstLen) {
+  for (int RecN = 0; RecN < 40; RecN++) {
+    TmMSecs += 1000; AddWinBufTestRec(Base, Ref, Rnd.GetUniDevInt(100), TmMSecs);
+    CheckWinBufTest(Base, Ref);
+  }
+  for (int RecN = 0; RecN < BurstLen; RecN++) {
+    TmMSecs += Rnd.GetUniDevInt(2); AddWinBufTestRec(Base, Ref, Rnd.GetUniDevInt(100), TmMSecs);
+    CheckWinBufTest(Base, Ref);
+  }
+}
+
+// buffer grows while wrapped around
+TEST(TTimeSeriesWinBuf, Grow) {
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = NewWinBufTestBase();
+  TWinBufTestRef Ref; uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 10);
+  AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 40);
+  AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 100);
+  // longer gap empties all but the newest value
+  TmMSecs += 5 * WinBufTestMSecs; AddWinBufTestRec(Base, Ref, 50, TmMSecs);
+  CheckWinBufTest(Base, Ref);
+  AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 300);
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// wrapped buffer state is saved and loaded, and keeps working after
+TEST(TTimeSeriesWinBuf, Load) {
+  const TStr StateFNm = StreamAggrTestFPath + "WinBuf.dat";
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWinBufTestRef Ref; uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  {
+    TWPt<TBase> Base = NewWinBufTestBase();
+    AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 40);
+    // stop in the slow part, with the oldest value in the middle of the buffer
+    for (int RecN = 0; RecN < 25; RecN++) { TmMSecs += 1000; AddWinBufTestRec(Base, Ref, Rnd.GetUniDevInt(100), TmMSecs); }
+    CheckWinBufTest(Base, Ref);
+    TFOut FOut(StateFNm);
+    Base->GetStreamAggr("T", "WinBuf")->_Save(FOut);
+    Base->GetStreamAggr("T", "Min")->_Save(FOut);
+    Base->GetStreamAggr("T", "Max")->_Save(FOut);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(StreamAggrTestFPath, faUpdate, 1000000, 1000000);
+    AddWinBufTestAggrs(Base);
+    TFIn FIn(StateFNm);
+    Base->GetStreamAggr("T", "WinBuf")->_Load(FIn);
+    Base->GetStreamAggr("T", "Min")->_Load(FIn);
+    Base->GetStreamAggr("T", "Max")->_Load(FIn);
+    CheckWinBufTest(Base, Ref);
+    AddWinBufTestCycle(Base, Ref, Rnd, TmMSecs, 100);
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
+
+// values with the same time stamp leave minimum and maximum together
+TEST(TWinBufMinMax, EqualTimeStamps) {
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWPt<TBase> Base = NewWinBufTestBase();
+  TWinBufTestRef Ref; uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  for (int RecN = 0; RecN < 3000; RecN++) {
+    // few distinct values and time stamps, repeated up to several times
+    if (Rnd.GetUniDevInt(3) == 0) { TmMSecs += 1000 * (1 + Rnd.GetUniDevInt(4)); }
+    AddWinBufTestRec(Base, Ref, Rnd.GetUniDevInt(10), TmMSecs);
+    CheckWinBufTest(Base, Ref);
+  }
+  // monotone sequences, where the minimum or maximum is always the oldest value
+  for (int RecN = 0; RecN < 200; RecN++) {
+    if (RecN % 3 == 0) { TmMSecs += 1000; }
+    AddWinBufTestRec(Base, Ref, RecN, TmMSecs); CheckWinBufTest(Base, Ref);
+  }
+  for (int RecN = 0; RecN < 200; RecN++) {
+    if (RecN % 3 == 0) { TmMSecs += 1000; }
+    AddWinBufTestRec(Base, Ref, -RecN, TmMSecs); CheckWinBufTest(Base, Ref);
+  }
+  TStorage::SaveBase(Base); Base.Del();
+}
+
+// two time series, second one follows the first
+const TStr StreamAggrBatchSchema = "[{\"name\":\"T\",\"fields\":["
+  "{\"name\":\"Time\",\"type\":\"datetime\"},"
+  "{\"name\":\"X\",\"type\":\"float\"},{\"name\":\"Y\",\"type\":\"float\"}]}]";
+
+// aggregates with their own batch implementation, as type and parameters
+const char* StreamAggrBatchDefV[][2] = {
+  {"timeSeriesTick", "{\"name\":\"Tick\",\"timestamp\":\"Time\",\"value\":\"X\"}"},
+  {"ema", "{\"name\":\"Ema\",\"inAggr\":\"Tick\",\"emaType\":\"previous\",\"interval\":20000,\"initWindow\":50000}"},
+  {"timeSeriesWinBuf", "{\"name\":\"WinBufX\",\"timestamp\":\"Time\",\"value\":\"X\",\"winsize\":60000}"},
+  {"timeSeriesWinBuf", "{\"name\":\"WinBufY\",\"timestamp\":\"Time\",\"value\":\"Y\",\"winsize\":60000}"},
+  {"winBufCount", "{\"name\":\"Count\",\"inAggr\":\"WinBufX\"}"},
+  {"winBufSum", "{\"name\":\"Sum\",\"inAggr\":\"WinBufX\"}"},
+  {"winBufMin", "{\"name\":\"Min\",\"inAggr\":\"WinBufX\"}"},
+  {"winBufMax", "{\"name\":\"Max\",\"inAggr\":\"WinBufX\"}"},
+  {"ma", "{\"name\":\"Ma\",\"inAggr\":\"WinBufX\"}"},
+  {"variance", "{\"name\":\"VarX\",\"inAggr\":\"WinBufX\"}"},
+  {"variance", "{\"name\":\"VarY\",\"inAggr\":\"WinBufY\"}"},
+  {"covariance", "{\"name\":\"Cov\",\"inAggrX\":\"WinBufX\",\"inAggrY\":\"WinBufY\"}"},
+  {"correlation", "{\"name\":\"Corr\",\"inAggrCov\":\"Cov\",\"inAggrVarX\":\"VarX\",\"inAggrVarY\":\"VarY\"}"}
+};
+const int StreamAggrBatchDefs = sizeof(StreamAggrBatchDefV) / sizeof(StreamAggrBatchDefV[0]);
+
+TWPt<TBase> NewBatchTestBase(const TStr& FPath) {
+  TWPt<TBase> Base = TStorage::NewBase(FPath, TJsonVal::GetValFromStr(StreamAggrBatchSchema), 1000000, 1000000);
+  for (int DefN = 0; DefN < StreamAggrBatchDefs; DefN++) {
+    PJsonVal ParamVal = TJsonVal::GetValFromStr(StreamAggrBatchDefV[DefN][1]);
+    ParamVal->AddToObj("store", "T");
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, StreamAggrBatchDefV[DefN][0], ParamVal));
+  }
+  return Base;
+}
+
+// JSon lines with several records per time stamp and gaps longer than the window
+TStr GetBatchTestRecLns(TRnd& Rnd, uint64& TmMSecs, const int& Recs) {
+  TChA LnChA;
+  for (int RecN = 0; RecN < Recs; RecN++) {
+    if (Rnd.GetUniDevInt(4) != 0) { TmMSecs += Rnd.GetUniDevInt(3000); }
+    if (Rnd.GetUniDevInt(500) == 0) { TmMSecs += 100000; }
+    const double XVal = floor(Rnd.GetNrmDev() * 100);
+    const double YVal = floor(XVal / 2 + Rnd.GetNrmDev() * 20);
+    LnChA += TStr::Fmt("{\"Time\":\"%s\",\"X\":%g,\"Y\":%g}\n",
+      TTm::GetTmFromMSecs(TmMSecs).GetWebLogDateTimeStr(true, "T").CStr(), XVal, YVal);
+  }
+  return LnChA;
+}
+
+// adds records one by one
+void AddBatchTestRecLns(const TWPt<TBase>& Base, const TStr& LnStr) {
+  PSIn SIn = TMIn::New(LnStr); TStr RecStr;
+  while (SIn->GetNextLn(RecStr)) { Base->AddRec("T", TJsonVal::GetValFromStr(RecStr)); }
+}
+
+// each aggregate has the same state in both bases
+void CheckBatchTest(const TWPt<TBase>& RecBase, const TWPt<TBase>& BulkBase) {
+  for (int DefN = 0; DefN < StreamAggrBatchDefs; DefN++) {
+    const TStr AggrNm = TJsonVal::GetValFromStr(StreamAggrBatchDefV[DefN][1])->GetObjStr("name");
+    PStreamAggr RecAggr = RecBase->GetStreamAggr("T", AggrNm);
+    PStreamAggr BulkAggr = BulkBase->GetStreamAggr("T", AggrNm);
+    // all of them take the batch path
+    EXPECT_TRUE(BulkAggr->IsBatch()) << AggrNm.CStr();
+    EXPECT_EQ(TJsonVal::GetStrFromVal(RecAggr->SaveJson(-1)), TJsonVal::GetStrFromVal(BulkAggr->SaveJson(-1))) << AggrNm.CStr();
+    TStreamAggrOut::IFlt* RecFlt = dynamic_cast<TStreamAggrOut::IFlt*>(RecAggr());
+    TStreamAggrOut::IFlt* BulkFlt = dynamic_cast<TStreamAggrOut::IFlt*>(BulkAggr());
+    // covariance and correlation of a single value are not defined
+    if (RecFlt != NULL && !TFlt::IsNan(RecFlt->GetFlt())) { EXPECT_EQ(RecFlt->GetFlt(), BulkFlt->GetFlt()) << AggrNm.CStr(); }
+    if (RecFlt != NULL && TFlt::IsNan(RecFlt->GetFlt())) { EXPECT_TRUE(TFlt::IsNan(BulkFlt->GetFlt())) << AggrNm.CStr(); }
+    TStreamAggrOut::IFltVec* RecFltVec = dynamic_cast<TStreamAggrOut::IFltVec*>(RecAggr());
+    TStreamAggrOut::IFltVec* BulkFltVec = dynamic_cast<TStreamAggrOut::IFltVec*>(BulkAggr());
+    if (RecFltVec != NULL) {
+      TFltV RecValV, BulkValV; RecFltVec->GetFltV(RecValV); BulkFltVec->GetFltV(BulkValV);
+      EXPECT_EQ(RecValV, BulkValV) << AggrNm.CStr();
+    }
+  }
+}
+
+// batch implementations end up in the same state as adding records one by one
+TEST(TStreamAggrBatch, SameAsOnAddRec) {
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWPt<TBase> RecBase = NewBatchTestBase(StreamAggrTestFPath);
+  TWPt<TBase> BulkBase = NewBatchTestBase(StreamAggrBulkTestFPath);
+  uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  // several loads, of different batch lengths, continue from the previous state
+  const int BatchLens[] = {1, 7, 100, 1000};
+  for (int LoadN = 0; LoadN < 4; LoadN++) {
+    const TStr LnStr = GetBatchTestRecLns(Rnd, TmMSecs, 1500);
+    AddBatchTestRecLns(RecBase, LnStr);
+    BulkBase->GetStoreByStoreNm("T")->AddRecBulk(TMIn::New(LnStr), BatchLens[LoadN], 10000);
+    ASSERT_EQ(RecBase->GetStoreByStoreNm("T")->GetRecs(), BulkBase->GetStoreByStoreNm("T")->GetRecs());
+    CheckBatchTest(RecBase, BulkBase);
+  }
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// sum of a field, not thread safe, so it gets a step of its own
+class TBatchTestBarrier : public TStreamAggr, public TStreamAggrOut::IFlt {
+private:
+  TInt FieldId;
+  TFlt Sum;
+protected:
+  void OnAddRec(const TRec& Rec) { Sum += Rec.GetFieldFlt(FieldId); }
+  TBatchTestBarrier(const TWPt<TBase>& Base, const TStr& AggrNm, const int& _FieldId):
+    TStreamAggr(Base, AggrNm), FieldId(_FieldId) { }
+public:
+  static PStreamAggr New(const TWPt<TBase>& Base, const TStr& AggrNm, const int& FieldId) {
+    return new TBatchTestBarrier(Base, AggrNm, FieldId); }
+  bool IsBatch() const { return true; }
+  double GetFlt() const { return Sum; }
+  PJsonVal SaveJson(const int& Limit) const { return TJsonVal::NewNum(Sum); }
+  TStr Type() const { return "batchTestBarrier"; }
+};
+
+// three time series, each with a chain of aggregates
+const TStr StreamAggrChainSchema = "[{\"name\":\"T\",\"fields\":["
+  "{\"name\":\"Time\",\"type\":\"datetime\"},{\"name\":\"X\",\"type\":\"float\"},"
+  "{\"name\":\"Y\",\"type\":\"float\"},{\"name\":\"Z\",\"type\":\"float\"}]}]";
+
+// names of aggregates on the chains, in the order they are added
+void GetChainTestAggrNmV(TStrV& AggrNmV) {
+  const char* FldNms[] = {"X", "Y", "Z"};
+  for (int FldN = 0; FldN < 3; FldN++) {
+    AggrNmV.Add(TStr("Tick") + FldNms[FldN]); AggrNmV.Add(TStr("WinBuf") + FldNms[FldN]); }
+  AggrNmV.Add("Barrier");
+  for (int FldN = 0; FldN < 3; FldN++) {
+    AggrNmV.Add(TStr("Ema") + FldNms[FldN]); AggrNmV.Add(TStr("Var") + FldNms[FldN]);
+    AggrNmV.Add(TStr("Ma") + FldNms[FldN]); }
+  AggrNmV.Add("CovXY"); AggrNmV.Add("CovYZ"); AggrNmV.Add("CorrXY");
+}
+
+// adds aggregates of one chain step at a time, so independent ones share a step
+TWPt<TBase> NewChainTestBase(const TStr& FPath) {
+  TWPt<TBase> Base = TStorage::NewBase(FPath, TJsonVal::GetValFromStr(StreamAggrChainSchema), 1000000, 1000000);
+  const char* FldNms[] = {"X", "Y", "Z"};
+  for (int FldN = 0; FldN < 3; FldN++) {
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, "timeSeriesTick", TJsonVal::GetValFromStr(TStr::Fmt(
+      "{\"store\":\"T\",\"name\":\"Tick%s\",\"timestamp\":\"Time\",\"value\":\"%s\"}", FldNms[FldN], FldNms[FldN]))));
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, "timeSeriesWinBuf", TJsonVal::GetValFromStr(TStr::Fmt(
+      "{\"store\":\"T\",\"name\":\"WinBuf%s\",\"timestamp\":\"Time\",\"value\":\"%s\",\"winsize\":60000}", FldNms[FldN], FldNms[FldN]))));
+  }
+  Base->AddStreamAggr("T", TBatchTestBarrier::New(Base, "Barrier", 1));
+  for (int FldN = 0; FldN < 3; FldN++) {
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, "ema", TJsonVal::GetValFromStr(TStr::Fmt(
+      "{\"store\":\"T\",\"name\":\"Ema%s\",\"inAggr\":\"Tick%s\",\"emaType\":\"linear\",\"interval\":20000,\"initWindow\":10000}",
+      FldNms[FldN], FldNms[FldN]))));
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, "variance", TJsonVal::GetValFromStr(TStr::Fmt(
+      "{\"store\":\"T\",\"name\":\"Var%s\",\"inAggr\":\"WinBuf%s\"}", FldNms[FldN], FldNms[FldN]))));
+    Base->AddStreamAggr("T", TStreamAggr::New(Base, "ma", TJsonVal::GetValFromStr(TStr::Fmt(
+      "{\"store\":\"T\",\"name\":\"Ma%s\",\"inAggr\":\"WinBuf%s\"}", FldNms[FldN], FldNms[FldN]))));
+  }
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "covariance", TJsonVal::GetValFromStr(
+    "{\"store\":\"T\",\"name\":\"CovXY\",\"inAggrX\":\"WinBufX\",\"inAggrY\":\"WinBufY\"}")));
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "covariance", TJsonVal::GetValFromStr(
+    "{\"store\":\"T\",\"name\":\"CovYZ\",\"inAggrX\":\"WinBufY\",\"inAggrY\":\"WinBufZ\"}")));
+  Base->AddStreamAggr("T", TStreamAggr::New(Base, "correlation", TJsonVal::GetValFromStr(
+    "{\"store\":\"T\",\"name\":\"CorrXY\",\"inAggrCov\":\"CovXY\",\"inAggrVarX\":\"VarX\",\"inAggrVarY\":\"VarY\"}")));
+  return Base;
+}
+
+TStr GetChainTestRecLns(TRnd& Rnd, uint64& TmMSecs, const int& Recs) {
+  TChA LnChA;
+  for (int RecN = 0; RecN < Recs; RecN++) {
+    if (Rnd.GetUniDevInt(4) != 0) { TmMSecs += Rnd.GetUniDevInt(3000); }
+    const double XVal = floor(Rnd.GetNrmDev() * 100);
+    LnChA += TStr::Fmt("{\"Time\":\"%s\",\"X\":%g,\"Y\":%g,\"Z\":%g}\n",
+      TTm::GetTmFromMSecs(TmMSecs).GetWebLogDateTimeStr(true, "T").CStr(), XVal,
+      floor(XVal / 2 + Rnd.GetNrmDev() * 20), floor(Rnd.GetNrmDev() * 10));
+  }
+  return LnChA;
+}
+
+// aggregates on the chains have the same value in both bases
+void CheckChainTest(const TWPt<TBase>& RecBase, const TWPt<TBase>& BulkBase) {
+  TStrV AggrNmV; GetChainTestAggrNmV(AggrNmV);
+  for (int AggrN = 0; AggrN < AggrNmV.Len(); AggrN++) {
+    const TStr& AggrNm = AggrNmV[AggrN];
+    TStreamAggrOut::IFlt* RecFlt = dynamic_cast<TStreamAggrOut::IFlt*>(RecBase->GetStreamAggr("T", AggrNm)());
+    TStreamAggrOut::IFlt* BulkFlt = dynamic_cast<TStreamAggrOut::IFlt*>(BulkBase->GetStreamAggr("T", AggrNm)());
+    if (RecFlt == NULL) { continue; }
+    EXPECT_TRUE(BulkBase->GetStreamAggr("T", AggrNm)->IsBatch()) << AggrNm.CStr();
+    EXPECT_EQ(RecFlt->GetFlt(), BulkFlt->GetFlt()) << AggrNm.CStr();
+  }
+}
+
+// aggregates run in parallel steps after their inputs, and after the aggregates
+// that are not thread safe, and end up with the same values as record by record
+TEST(TStreamAggrBatch, DependencyChain) {
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWPt<TBase> RecBase = NewChainTestBase(StreamAggrTestFPath);
+  TWPt<TBase> BulkBase = NewChainTestBase(StreamAggrBulkTestFPath);
+  uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  for (int LoadN = 0; LoadN < 3; LoadN++) {
+    const TStr LnStr = GetChainTestRecLns(Rnd, TmMSecs, 2000);
+    AddBatchTestRecLns(RecBase, LnStr);
+    BulkBase->GetStoreByStoreNm("T")->AddRecBulk(TMIn::New(LnStr), 500, 10000);
+    CheckChainTest(RecBase, BulkBase);
+  }
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
+
+// aggregates other aggregates read from cannot be replaced, the others can
+TEST(TStreamAggrBatch, Replace) {
+  InitStreamAggrTest(); TRnd Rnd(1);
+  TWPt<TBase> RecBase = NewChainTestBase(StreamAggrTestFPath);
+  TWPt<TBase> BulkBase = NewChainTestBase(StreamAggrBulkTestFPath);
+  uint64 TmMSecs = TTm::GetMSecsFromTm(TTm(2015, 3, 1, -1, 0, 0, 0));
+  TStr LnStr = GetChainTestRecLns(Rnd, TmMSecs, 2000);
+  AddBatchTestRecLns(RecBase, LnStr);
+  BulkBase->GetStoreByStoreNm("T")->AddRecBulk(TMIn::New(LnStr), 500, 10000);
+  // variance and covariance read from the window buffer
+  EXPECT_ANY_THROW(BulkBase->AddStreamAggr("T", TStreamAggr::New(BulkBase, "timeSeriesWinBuf", TJsonVal::GetValFromStr(
+    "{\"store\":\"T\",\"name\":\"WinBufX\",\"timestamp\":\"Time\",\"value\":\"Z\",\"winsize\":60000}"))));
+  EXPECT_ANY_THROW(BulkBase->AddStreamAggr("T", TStreamAggr::New(BulkBase, "variance", TJsonVal::GetValFromStr(
+    "{\"store\":\"T\",\"name\":\"VarX\",\"inAggr\":\"WinBufZ\"}"))));
+  // nothing reads from the moving average, new one reads from another buffer
+  TWPt<TBase> BaseV[] = {RecBase, BulkBase};
+  for (int BaseN = 0; BaseN < 2; BaseN++) {
+    BaseV[BaseN]->AddStreamAggr("T", TStreamAggr::New(BaseV[BaseN], "ma", TJsonVal::GetValFromStr(
+      "{\"store\":\"T\",\"name\":\"MaX\",\"inAggr\":\"WinBufZ\"}")));
+  }
+  LnStr = GetChainTestRecLns(Rnd, TmMSecs, 2000);
+  AddBatchTestRecLns(RecBase, LnStr);
+  BulkBase->GetStoreByStoreNm("T")->AddRecBulk(TMIn::New(LnStr), 500, 10000);
+  CheckChainTest(RecBase, BulkBase);
+  TStrV InAggrNmV; BulkBase->GetStreamAggr("T", "MaX")->GetInAggrNmV(InAggrNmV);
+  EXPECT_EQ(TStrV::GetV("WinBufZ"), InAggrNmV);
+  TStorage::SaveBase(RecBase); RecBase.Del();
+  TStorage::SaveBase(BulkBase); BulkBase.Del();
+}
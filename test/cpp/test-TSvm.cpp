@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <base.h>
+#include <mine.h>
+
+// Generate synthetic sparse corpus with Docs documents of NonZeros words each,
+// word ids follow a Zipfian distribution over Dims words; target is positive
+// when the document contains any of the first few words
+void GenSpCorpus(TRnd& Rnd, const int& Docs, const int& Dims, const int& NonZeros,
+    TVec<TIntFltKdV>& DocV, TFltV& ClsV, TFltV& RegV) {
+
+  DocV.Gen(Docs, 0); ClsV.Gen(Docs, 0); RegV.Gen(Docs, 0);
+  for (int DocN = 0; DocN < Docs; DocN++) {
+    TIntSet WordIdSet;
+    while (WordIdSet.Len() < NonZeros) {
+      const double Rank = TMath::Power((double)Dims, Rnd.GetUniDev());
+      WordIdSet.AddKey(TInt::GetMn((int)Rank - 1, Dims - 1));
+    }
+    TIntFltKdV DocSpV; double Reg = 0.0;
+    int KeyId = WordIdSet.FFirstKeyId();
+    while (WordIdSet.FNextKeyId(KeyId)) {
+      const int WordId = WordIdSet.GetKey(KeyId);
+      DocSpV.Add(TIntFltKd(WordId, 1.0 + Rnd.GetUniDev()));
+      if (WordId < 8) { Reg += DocSpV.Last().Dat; }
+    }
+    DocSpV.Sort(); TLinAlg::Normalize(DocSpV);
+    DocV.Add(DocSpV); ClsV.Add(Reg > 0.0 ? 1.0 : -1.0); RegV.Add(Reg);
+  }
+}
+
+// Copy sparse corpus into a dense matrix with documents as columns
+void GetDenseCorpus(const TVec<TIntFltKdV>& DocV, const int& Dims, TFltVV& DocVV) {
+  DocVV.Gen(Dims, DocV.Len());
+  for (int DocN = 0; DocN < DocV.Len(); DocN++) {
+    for (int ElN = 0; ElN < DocV[DocN].Len(); ElN++) {
+      DocVV(DocV[DocN][ElN].Key, DocN) = DocV[DocN][ElN].Dat;
+    }
+  }
+}
+
+// Lazy scaling must track the explicit dense operations
+TEST(TScaledWgtV, Operations) {
+  TRnd Rnd(1);
+  TFltV WgtV(100); TLAMisc::FillRnd(WgtV, Rnd);
+  TSvm::TScaledWgtV ScaledWgtV(WgtV);
+  for (int StepN = 0; StepN < 1000; StepN++) {
+    TIntFltKdV SpV;
+    for (int ElN = 0; ElN < 5; ElN++) { SpV.Add(TIntFltKd(Rnd.GetUniDevInt(100), Rnd.GetNrmDev())); }
+    SpV.Merge();
+    EXPECT_NEAR(TLinAlg::DotProduct(WgtV, SpV), ScaledWgtV.DotProduct(SpV), 1e-8);
+    // scale often enough to trigger rescaling
+    const double Scale = 0.5 + 0.01 * Rnd.GetUniDev();
+    TLinAlg::MultiplyScalar(Scale, WgtV, WgtV); ScaledWgtV.MultiplyScalar(Scale);
+    TLinAlg::AddVec(0.1, SpV, WgtV); ScaledWgtV.AddVec(0.1, SpV);
+    EXPECT_NEAR(TLinAlg::Norm2(WgtV), ScaledWgtV.GetSqNorm(), 1e-8 * TFlt::GetMx(1.0, TLinAlg::Norm2(WgtV)));
+  }
+  TFltV ResWgtV; ScaledWgtV.GetWgtV(ResWgtV);
+  EXPECT_NEAR(0.0, TLinAlg::EuclDist(WgtV, ResWgtV), 1e-8);
+}
+
+// Sparse solvers must produce the same models as the dense ones
+TEST(TSvm, SparseEqualsDense) {
+  const int Docs = 500, Dims = 300;
+  TRnd Rnd(1);
+  TVec<TIntFltKdV> DocV; TFltV ClsV, RegV;
+  GenSpCorpus(Rnd, Docs, Dims, 10, DocV, ClsV, RegV);
+  TFltVV DocVV; GetDenseCorpus(DocV, Dims, DocVV);
+
+  // no difference limit, so that both run the same number of iterations
+  TSvm::TLinModel SpCfyModel = TSvm::SolveClassify<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 50, TNotify::NullNotify);
+  TSvm::TLinModel DenseCfyModel = TSvm::SolveClassify<TFltVV>(DocVV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 50, TNotify::NullNotify);
+  TFltV SpWgtV, DenseWgtV;
+  SpCfyModel.GetWgtV(SpWgtV); DenseCfyModel.GetWgtV(DenseWgtV);
+  EXPECT_NEAR(0.0, TLinAlg::EuclDist(SpWgtV, DenseWgtV) / TLinAlg::Norm(DenseWgtV), 1e-6);
+
+  TSvm::TLinModel SpRegModel = TSvm::SolveRegression<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+    RegV, 1.0, 0.1, 100000, 300, 0.0, 50, TNotify::NullNotify);
+  TSvm::TLinModel DenseRegModel = TSvm::SolveRegression<TFltVV>(DocVV, Dims, Docs,
+    RegV, 1.0, 0.1, 100000, 300, 0.0, 50, TNotify::NullNotify);
+  SpRegModel.GetWgtV(SpWgtV); DenseRegModel.GetWgtV(DenseWgtV);
+  EXPECT_NEAR(0.0, TLinAlg::EuclDist(SpWgtV, DenseWgtV) / TLinAlg::Norm(DenseWgtV), 1e-6);
+}
+
+// Synthetic bag-of-words corpus, iteration cost should not depend on
+// the dimensionality of the space
+TEST(TSvm, SparseBenchmark) {
+  const int Docs = 20000, NonZeros = 12, Iters = 2000;
+  TRnd Rnd(1);
+  for (int Dims = 20000; Dims <= 2000000; Dims *= 10) {
+    TVec<TIntFltKdV> DocV; TFltV ClsV, RegV;
+    GenSpCorpus(Rnd, Docs, Dims, NonZeros, DocV, ClsV, RegV);
+    TSvm::TLinModel Model = TSvm::SolveClassify<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+      ClsV, 1.0, 1.0, 100000, Iters, 0.0, 100, TNotify::NullNotify);
+    int Correct = 0;
+    for (int DocN = 0; DocN < Docs; DocN++) {
+      if (Model.Predict(DocV[DocN]) * ClsV[DocN] > 0.0) { Correct++; }
+    }
+    EXPECT_LT(0.9 * Docs, Correct);
+  }
+}
+
+// Parallel batch updates must be reproducible for a fixed number of threads
+// and close to the serial solution
+TEST(TSvm, ParallelBatch) {
+  const int Docs = 2000, Dims = 300;
+  TRnd Rnd(1);
+  TVec<TIntFltKdV> DocV; TFltV ClsV, RegV;
+  GenSpCorpus(Rnd, Docs, Dims, 10, DocV, ClsV, RegV);
+  TFltVV DocVV; GetDenseCorpus(DocV, Dims, DocVV);
+
+  TSvm::TLinModel SerialModel = TSvm::SolveClassify<TFltVV>(DocVV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 500, TNotify::NullNotify, 1);
+  TSvm::TLinModel ParModel1 = TSvm::SolveClassify<TFltVV>(DocVV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 500, TNotify::NullNotify, 4);
+  TSvm::TLinModel ParModel2 = TSvm::SolveClassify<TFltVV>(DocVV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 500, TNotify::NullNotify, 4);
+  TFltV SerialWgtV, ParWgtV1, ParWgtV2;
+  SerialModel.GetWgtV(SerialWgtV); ParModel1.GetWgtV(ParWgtV1); ParModel2.GetWgtV(ParWgtV2);
+  EXPECT_TRUE(ParWgtV1 == ParWgtV2);
+  EXPECT_NEAR(0.0, TLinAlg::EuclDist(SerialWgtV, ParWgtV1) / TLinAlg::Norm(SerialWgtV), 1e-6);
+
+  // sparse solver only parallelizes independent dot products
+  TSvm::TLinModel SpSerialModel = TSvm::SolveClassify<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 500, TNotify::NullNotify, 1);
+  TSvm::TLinModel SpParModel = TSvm::SolveClassify<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+    ClsV, 1.0, 1.0, 100000, 300, 0.0, 500, TNotify::NullNotify, 4);
+  SpSerialModel.GetWgtV(SerialWgtV); SpParModel.GetWgtV(ParWgtV1);
+  EXPECT_TRUE(SerialWgtV == ParWgtV1);
+}
+
+// Batch prediction must match predicting column by column
+TEST(TSvm, BatchPredict) {
+  const int Docs = 500, Dims = 300;
+  TRnd Rnd(1);
+  TVec<TIntFltKdV> DocV; TFltV ClsV, RegV;
+  GenSpCorpus(Rnd, Docs, Dims, 10, DocV, ClsV, RegV);
+  TFltVV DocVV; GetDenseCorpus(DocV, Dims, DocVV);
+  TSvm::TLinModel Model = TSvm::SolveRegression<TVec<TIntFltKdV> >(DocV, Dims, Docs,
+    RegV, 1.0, 0.1, 100000, 100, 0.0, 50, TNotify::NullNotify);
+
+  TFltV SpPredV, DensePredV;
+  Model.Predict(DocV, SpPredV); Model.Predict(DocVV, DensePredV);
+  EXPECT_EQ(Docs, SpPredV.Len());
+  EXPECT_EQ(Docs, DensePredV.Len());
+  for (int DocN = 0; DocN < Docs; DocN++) {
+    const double Pred = Model.Predict(DocV[DocN]);
+    EXPECT_NEAR(Pred, SpPredV[DocN], 1e-12);
+    EXPECT_NEAR(Pred, DensePredV[DocN], 1e-12);
+  }
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <qminer.h>
+
+using namespace TQm;
+
+// Test files live in the current folder, state of the base before the
+// crash is dumped next to it
+const TStr WalTestFPath = "./wal-test/";
+const TStr WalTestDumpFNm = "./wal-test-dump.txt";
+
+void InitWalTest() {
+  if (!TQm::TEnv::IsInit()) { TQm::TEnv::Init(); TQm::TEnv::InitLogger(0, "null"); }
+  if (TDir::Exists(WalTestFPath)) {
+    TStrV FNmV; TFFile::GetFNmV(WalTestFPath, TStrV(), false, FNmV);
+    for (int FNmN = 0; FNmN < FNmV.Len(); FNmN++) { TFile::Del(FNmV[FNmN], false); }
+  } else {
+    TDir::GenDir(WalTestFPath);
+  }
+  TFile::Del(WalTestDumpFNm, false);
+}
+
+// records with joins in both directions, indexed keys and fields in memory and cache
+const TStr WalSchema = "[{\"name\":\"A\",\"fields\":["
+  "{\"name\":\"Name\",\"type\":\"string\",\"primary\":true},"
+  "{\"name\":\"Val\",\"type\":\"int\",\"null\":true},"
+  "{\"name\":\"Tag\",\"type\":\"string\",\"null\":true,\"store\":\"cache\"},"
+  "{\"name\":\"FltV\",\"type\":\"float_v\",\"null\":true}],"
+  "\"joins\":[{\"name\":\"J\",\"type\":\"field\",\"store\":\"B\",\"inverse\":\"Back\"}],"
+  "\"keys\":[{\"field\":\"Tag\",\"type\":\"value\"}]},"
+  "{\"name\":\"B\",\"fields\":["
+  "{\"name\":\"Name\",\"type\":\"string\",\"primary\":true},"
+  "{\"name\":\"X\",\"type\":\"float\",\"null\":true}],"
+  "\"joins\":[{\"name\":\"Back\",\"type\":\"index\",\"store\":\"A\",\"inverse\":\"J\"}],"
+  "\"keys\":[{\"field\":\"Name\",\"type\":\"value\"}]}]";
+
+// all records with their joins, and results of some index queries
+TStr GetWalTestDump(const TWPt<TBase>& Base) {
+  TChA DumpChA;
+  for (int StoreN = 0; StoreN < Base->GetStores(); StoreN++) {
+    TWPt<TStore> Store = Base->GetStoreByStoreN(StoreN);
+    DumpChA += Store->GetStoreNm() + " " + TUInt64::GetStr(Store->GetRecs()) + "\n";
+    PStoreIter Iter = Store->GetIter();
+    while (Iter->Next()) {
+      const TRec Rec = Store->GetRec(Iter->GetRecId());
+      DumpChA += TJsonVal::GetStrFromVal(Rec.GetJson(Base, true, false, true, false, true)); DumpChA += '\n';
+    }
+  }
+  TStrV QueryStrV;
+  QueryStrV.Add("{\"$from\":\"A\",\"Tag\":\"t3\"}");
+  QueryStrV.Add("{\"$from\":\"A\",\"Tag\":\"t7\"}");
+  QueryStrV.Add("{\"$join\":{\"$name\":\"Back\",\"$query\":{\"$from\":\"B\",\"Name\":\"b5\"}}}");
+  for (int QueryN = 0; QueryN < QueryStrV.Len(); QueryN++) {
+    PRecSet RecSet = Base->Search(QueryStrV[QueryN]);
+    for (int RecN = 0; RecN < RecSet->GetRecs(); RecN++) { DumpChA += TUInt64::GetStr(RecSet->GetRecId(RecN)); DumpChA += ' '; }
+    DumpChA += '\n';
+  }
+  return DumpChA;
+}
+
+// records with joins get new names, since replacing a field join keeps the old
+// inverse join, others can update existing records with the same name
+TStr GetWalTestRecStr(TRnd& Rnd, const int& OpN, const bool& JoinP) {
+  TStr RecStr = JoinP ? TStr::Fmt("{\"Name\":\"j%d\"", OpN) : TStr::Fmt("{\"Name\":\"a%d\"", Rnd.GetUniDevInt(1000));
+  RecStr += TStr::Fmt(",\"Val\":%d,\"Tag\":\"t%d\"", Rnd.GetUniDevInt(20), Rnd.GetUniDevInt(10));
+  if (Rnd.GetUniDevInt(3) == 0) { RecStr += TStr::Fmt(",\"FltV\":[%d,%d]", Rnd.GetUniDevInt(9), Rnd.GetUniDevInt(9)); }
+  if (JoinP) { RecStr += TStr::Fmt(",\"J\":{\"Name\":\"b%d\",\"X\":%d}", Rnd.GetUniDevInt(50), Rnd.GetUniDevInt(100)); }
+  return RecStr + "}";
+}
+
+// random mix of store operations, numbered from FirstOpN
+void ExecWalTestOps(const TWPt<TBase>& Base, TRnd& Rnd, const int& FirstOpN, const int& Ops) {
+  TWPt<TStore> StoreA = Base->GetStoreByStoreNm("A");
+  TWPt<TStore> StoreB = Base->GetStoreByStoreNm("B");
+  for (int OpN = FirstOpN; OpN < FirstOpN + Ops; OpN++) {
+    const int Op = Rnd.GetUniDevInt(100);
+    if (Op < 45 || StoreA->Empty() || StoreB->Empty()) {
+      StoreA->AddRec(TJsonVal::GetValFromStr(GetWalTestRecStr(Rnd, OpN, Rnd.GetUniDevInt(2) == 0)));
+      continue;
+    }
+    const uint64 RecId = StoreA->FirstRecId() + Rnd.GetUniDevInt((int)StoreA->GetRecs());
+    if (Op < 60) {
+      StoreA->UpdateRec(RecId, TJsonVal::GetValFromStr(TStr::Fmt("{\"Val\":%d,\"Tag\":\"t%d\"}",
+        Rnd.GetUniDevInt(20), Rnd.GetUniDevInt(10))));
+    } else if (Op < 65) {
+      StoreA->SetFieldInt(RecId, StoreA->GetFieldId("Val"), Rnd.GetUniDevInt(20));
+    } else if (Op < 68) {
+      StoreA->SetFieldNull(RecId, StoreA->GetFieldId("Val"));
+    } else if (Op < 72) {
+      StoreA->SetFieldStr(RecId, StoreA->GetFieldId("Tag"), TStr::Fmt("t%d", Rnd.GetUniDevInt(10)));
+    } else if (Op < 75) {
+      StoreA->DeleteFirstNRecs(5);
+    } else if (Op < 85) {
+      const uint64 JoinRecId = StoreB->FirstRecId() + Rnd.GetUniDevInt((int)StoreB->GetRecs());
+      if (!StoreA->GetRec(RecId).DoSingleJoin(Base, "J").IsDef()) { StoreA->AddJoin(StoreA->GetJoinId("J"), RecId, JoinRecId, 1); }
+    } else {
+      StoreB->AddRec(TJsonVal::GetValFromStr(TStr::Fmt("{\"Name\":\"b%d\",\"X\":%d}",
+        Rnd.GetUniDevInt(60), Rnd.GetUniDevInt(100))));
+    }
+  }
+}
+
+// changes made with the log enabled are replayed after the base is dropped without closing
+TEST(TWal, Replay) {
+  InitWalTest();
+  // process exits right after the changes, without saving the base
+  EXPECT_EXIT({
+    TWPt<TBase> Base = TStorage::NewBase(WalTestFPath, TJsonVal::GetValFromStr(WalSchema), 1000000, 1000000);
+    Base->InitWal(0, 0, 0); TRnd Rnd(1);
+    ExecWalTestOps(Base, Rnd, 0, 1000);
+    // part of the changes is included in a checkpoint, the rest only in the log
+    Base->Checkpoint();
+    ExecWalTestOps(Base, Rnd, 1000, 1000);
+    { TFOut DumpFOut(WalTestDumpFNm); DumpFOut.PutStr(GetWalTestDump(Base)); }
+    _exit(0);
+  }, ::testing::ExitedWithCode(0), "");
+  const TStr DumpStr = TStr::LoadTxt(WalTestDumpFNm);
+  ASSERT_FALSE(DumpStr.Empty());
+  // read-only base can not replay the log
+  EXPECT_ANY_THROW(TStorage::LoadBase(WalTestFPath, faRdOnly, 1000000, 1000000));
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(WalTestFPath, faUpdate, 1000000, 1000000);
+    EXPECT_EQ(DumpStr, GetWalTestDump(Base));
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(WalTestFPath, faRdOnly, 1000000, 1000000);
+    EXPECT_EQ(DumpStr, GetWalTestDump(Base));
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
+
+// strings encoded with codebooks in memory and cache
+const TStr WalCodebookSchema = "[{\"name\":\"C\",\"fields\":["
+  "{\"name\":\"Name\",\"type\":\"string\",\"primary\":true},"
+  "{\"name\":\"MemCode\",\"type\":\"string\",\"codebook\":true},"
+  "{\"name\":\"CacheCode\",\"type\":\"string\",\"codebook\":true,\"store\":\"cache\"}]}]";
+
+// adds records with codes from given prefix, new prefix adds new codebook strings
+void AddWalCodebookTestRecs(const TWPt<TBase>& Base, const int& FirstRecN, const int& Recs, const TStr& CodePrefix) {
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("C");
+  for (int RecN = FirstRecN; RecN < FirstRecN + Recs; RecN++) {
+    Store->AddRec(TJsonVal::GetValFromStr(TStr::Fmt("{\"Name\":\"c%d\",\"MemCode\":\"%s%d\",\"CacheCode\":\"%s%d\"}",
+      RecN, CodePrefix.CStr(), RecN % 7, CodePrefix.CStr(), RecN % 11)));
+  }
+}
+
+TStr GetWalCodebookTestDump(const TWPt<TBase>& Base) {
+  TChA DumpChA;
+  TWPt<TStore> Store = Base->GetStoreByStoreNm("C");
+  PStoreIter Iter = Store->GetIter();
+  while (Iter->Next()) {
+    DumpChA += TJsonVal::GetStrFromVal(Store->GetRec(Iter->GetRecId()).GetJson(Base)); DumpChA += '\n';
+  }
+  return DumpChA;
+}
+
+// codebook strings added after the first checkpoint survive checkpoints
+// which only save changes of the store
+TEST(TWal, Codebook) {
+  InitWalTest();
+  EXPECT_EXIT({
+    TWPt<TBase> Base = TStorage::NewBase(WalTestFPath, TJsonVal::GetValFromStr(WalCodebookSchema), 1000000, 1000000);
+    Base->InitWal(0, 0, 0);
+    AddWalCodebookTestRecs(Base, 0, 100, "x");
+    Base->Checkpoint();
+    AddWalCodebookTestRecs(Base, 100, 100, "y");
+    Base->Checkpoint();
+    // new codebook strings go to a delta, the snapshot is not rewritten
+    if (!TFile::Exists(WalTestFPath + "C.GenericStore.Delta0")) { _exit(1); }
+    AddWalCodebookTestRecs(Base, 200, 100, "z");
+    { TFOut DumpFOut(WalTestDumpFNm); DumpFOut.PutStr(GetWalCodebookTestDump(Base)); }
+    _exit(0);
+  }, ::testing::ExitedWithCode(0), "");
+  const TStr DumpStr = TStr::LoadTxt(WalTestDumpFNm);
+  ASSERT_FALSE(DumpStr.Empty());
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(WalTestFPath, faUpdate, 1000000, 1000000);
+    EXPECT_EQ(DumpStr, GetWalCodebookTestDump(Base));
+    // codebooks extended after the replay are saved by the next checkpoint
+    AddWalCodebookTestRecs(Base, 300, 100, "w");
+    Base->Checkpoint();
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  {
+    TWPt<TBase> Base = TStorage::LoadBase(WalTestFPath, faRdOnly, 1000000, 1000000);
+    EXPECT_EQ(400, (int)Base->GetStoreByStoreNm("C")->GetRecs());
+    EXPECT_TRUE(GetWalCodebookTestDump(Base).StartsWith(DumpStr));
+    EXPECT_EQ(TStr("w0"), Base->GetStoreByStoreNm("C")->GetFieldNmStr(399, "MemCode"));
+    EXPECT_EQ(TStr("w3"), Base->GetStoreByStoreNm("C")->GetFieldNmStr(399, "CacheCode"));
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
+
+// stream aggregates are not logged, so they do not mix with the log
+TEST(TWal, StreamAggr) {
+  InitWalTest();
+  {
+    TWPt<TBase> Base = TStorage::NewBase(WalTestFPath, TJsonVal::GetValFromStr(WalSchema), 1000000, 1000000);
+    Base->AddStreamAggr("A", TStreamAggrs::TRecBuffer::New(Base, "Buf", 3));
+    EXPECT_ANY_THROW(Base->InitWal(0, 0, 0));
+    EXPECT_FALSE(Base->IsWal());
+    TStorage::SaveBase(Base); Base.Del();
+  }
+  InitWalTest();
+  {
+    TWPt<TBase> Base = TStorage::NewBase(WalTestFPath, TJsonVal::GetValFromStr(WalSchema), 1000000, 1000000);
+    PStreamAggr StreamAggr = TStreamAggrs::TRecBuffer::New(Base, "Buf", 3);
+    Base->InitWal(0, 0, 0);
+    EXPECT_ANY_THROW(Base->AddStreamAggr("A", StreamAggr));
+    EXPECT_ANY_THROW(TStreamAggrs::TRecBuffer::New(Base, "Buf2", 3));
+    EXPECT_FALSE(Base->GetStreamAggrBase(Base->GetStoreByStoreNm("A")->GetStoreId())->IsStreamAggr("Buf"));
+    TStorage::SaveBase(Base); Base.Del();
+  }
+}
@@ -0,0 +1,89 @@
+console.log(__filename)
+var assert = require('../../src/nodejs/scripts/assert.js'); //adds assert.run function
+var qm = require('../../');
+var fs = qm.fs;
+
+qm.delLock();
+qm.config('qm.conf', true, 8080, 1024);
+var backward = require('../../src/nodejs/scripts/backward.js');
+backward.addToProcess(process); // adds process.isArg function
+
+var base = qm.create('qm.conf', "", true); // 2nd arg: empty schema, 3rd arg: clear db folder = true
+
+console.log("StreamAggrParallel", "Comparing bulk loaded stream aggregates with per-record adds");
+
+// only report failours
+assert.silent = !process.isArg("-verbose");
+// name of the debug process
+assert.consoleTitle = "StreamAggrParallel";
+
+var fields = 10;
+var records = 100000;
+
+// two stores with the same fields, one gets records one by one, the other in bulk
+function storeDef(name) {
+    var def = { name: name, fields: [{ name: "Time", type: "datetime" }] };
+    for (var i = 0; i < fields; i++) { def.fields.push({ name: "V" + i, type: "float" }); }
+    return def;
+}
+base.createStore([storeDef("Single"), storeDef("Bulk")]);
+
+// 99 aggregates per store, independent for each field
+var aggrNms = [];
+function addAggrs(storeName) {
+    aggrNms = [];
+    function addAggr(params) {
+        new qm.StreamAggr(base, params, storeName);
+        aggrNms.push(params.name);
+    }
+    for (var i = 0; i < fields; i++) {
+        addAggr({ name: "tick" + i, type: "timeSeriesTick", timestamp: "Time", value: "V" + i });
+        addAggr({ name: "ema" + i, type: "ema", inAggr: "tick" + i, emaType: "previous", interval: 20000, initWindow: 50000 });
+        addAggr({ name: "wb" + i, type: "timeSeriesWinBuf", timestamp: "Time", value: "V" + i, winsize: 300000 });
+        var types = ["winBufCount", "winBufSum", "winBufMin", "winBufMax", "ma", "variance"];
+        for (var j = 0; j < types.length; j++) {
+            addAggr({ name: types[j] + i, type: types[j], inAggr: "wb" + i });
+        }
+    }
+    for (var i = 0; i + 1 < fields; i++) {
+        addAggr({ name: "cov" + i, type: "covariance", inAggrX: "wb" + i, inAggrY: "wb" + (i + 1) });
+    }
+}
+addAggrs("Single");
+addAggrs("Bulk");
+
+// generate records
+var recs = [];
+var time = new Date("2014-01-01T00:00:00.000Z").getTime();
+fs.mkdir('./sandbox/streamaggr');
+var fout = fs.openWrite("./sandbox/streamaggr/recs.json");
+for (var recN = 0; recN < records; recN++) {
+    time += Math.random() < 0.25 ? 0 : Math.floor(Math.random() * 3000);
+    var rec = { Time: new Date(time).toISOString() };
+    for (var i = 0; i < fields; i++) { rec["V" + i] = Math.floor(Math.random() * 200 - 100); }
+    recs.push(rec);
+    fout.writeLine(JSON.stringify(rec));
+}
+fout.close();
+
+var Single = base.store("Single");
+var startTm = new Date().getTime();
+for (var recN = 0; recN < records; recN++) { Single.add(recs[recN]); }
+var singleMSecs = new Date().getTime() - startTm;
+
+var Bulk = base.store("Bulk");
+startTm = new Date().getTime();
+assert.equal(Bulk.loadJson("./sandbox/streamaggr/recs.json", { batchSize: 10000 }), records, "Bulk.loadJson");
+var bulkMSecs = new Date().getTime() - startTm;
+
+// independent aggregates run in parallel on batches, results must not change
+for (var aggrN = 0; aggrN < aggrNms.length; aggrN++) {
+    var aggrNm = aggrNms[aggrN];
+    assert.equal(JSON.stringify(Bulk.getStreamAggr(aggrNm).saveJson()),
+        JSON.stringify(Single.getStreamAggr(aggrNm).saveJson()), aggrNm);
+}
+
+console.log("StreamAggrParallel", aggrNms.length + " aggregates, " + records + " records: " +
+    "add " + singleMSecs + "ms, loadJson " + bulkMSecs + "ms");
+
+base.close();